@@ -0,0 +1,65 @@
+/**
+ * @file bench_common.h
+ * @brief Shared helpers for the worldx-ucra micro-benchmarks
+ *
+ * Header-only timing and test-signal utilities. Benchmarks are standalone
+ * executables built when WORLDX_BUILD_BENCHMARKS is enabled; they are not
+ * registered with CTest.
+ */
+#ifndef WORLDX_UCRA_BENCH_COMMON_H
+#define WORLDX_UCRA_BENCH_COMMON_H
+
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/** Monotonic wall clock in seconds */
+static inline double bench_now_sec(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * Fill x with a voiced test signal: a band-limited pulse train whose F0
+ * glides around base_f0 with a 5 Hz vibrato, plus a little noise. Returns the
+ * true F0 at time t through bench_signal_f0().
+ */
+static inline double bench_signal_f0(double base_f0, double t) {
+    return base_f0 * (1.0 + 0.03 * sin(2.0 * M_PI * 5.0 * t));
+}
+
+static inline void bench_make_signal(double* x, int x_length, int fs, double base_f0) {
+    double phase = 0.0;
+    unsigned int seed = 12345u;
+    for (int n = 0; n < x_length; n++) {
+        double f0 = bench_signal_f0(base_f0, (double)n / fs);
+        double v = 0.0;
+        for (int h = 1; h * f0 < fs / 2.0 && h <= 40; h++) {
+            v += sin(h * phase) / h;
+        }
+        seed = seed * 1664525u + 1013904223u;
+        double noise = ((double)(seed >> 8) / 16777216.0 - 0.5) * 0.01;
+        x[n] = 0.2 * v + noise;
+        phase += 2.0 * M_PI * f0 / fs;
+        if (phase > 2.0 * M_PI) phase -= 2.0 * M_PI;
+    }
+}
+
+#endif /* WORLDX_UCRA_BENCH_COMMON_H */
@@ -0,0 +1,154 @@
+/**
+ * @file bench_resampler_batch.c
+ * @brief Batch render throughput over 1, 2, 4 and 8 worker threads
+ *
+ * Usage: bench_resampler_batch [notes]
+ *
+ * Writes two samples (and their sidecar caches) and a manifest of `notes`
+ * notes, then renders the batch with each thread count, every time with a
+ * fresh engine. Reports wall time, notes/s and speed-up over one thread, and
+ * checks that every note file is byte-identical to the one-thread render.
+ *
+ * Fails if any note differs, or if on a machine with two or more CPUs two
+ * workers are not clearly faster than one: notes share no state while they
+ * render, so anything serializing them (a lock around synthesis, say) shows
+ * up here as a speed-up stuck near 1x.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cli/resampler_batch.h"
+#include "wav_io.h"
+#include "worldx_thread.h"
+#include "worldcache/worldcache_manager.h"
+#include "bench/bench_common.h"
+
+#define MIN_TWO_THREAD_SPEEDUP 1.3
+
+static const char* kWavs[2] = { "bench_resampler_batch_a.wav", "bench_resampler_batch_b.wav" };
+static const char* kManifest = "bench_resampler_batch.txt";
+
+static void note_file(char* buf, size_t size, const char* kind, int i) {
+    snprintf(buf, size, "bench_resampler_batch_%s_%d.wav", kind, i);
+}
+
+static int write_manifest(int notes) {
+    FILE* f = fopen(kManifest, "w");
+    if (!f) return -1;
+    for (int i = 0; i < notes; i++) {
+        char out[96];
+        note_file(out, sizeof(out), "note", i);
+        fprintf(f, "-p %d -l %d -o 20 %s %s\n", (i * 100) % 1200 - 600, 250 + (i % 4) * 50, kWavs[i % 2], out);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static unsigned char* read_file(const char* path, long* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    unsigned char* data = NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (*size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = (unsigned char*)malloc((size_t)*size + 1);
+        if (data && fread(data, 1, (size_t)*size, f) != (size_t)*size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+static int same_file(const char* a, const char* b) {
+    long size_a = 0, size_b = 0;
+    unsigned char* data_a = read_file(a, &size_a);
+    unsigned char* data_b = read_file(b, &size_b);
+    int same = data_a && data_b && size_a == size_b && memcmp(data_a, data_b, (size_t)size_a) == 0;
+    free(data_a);
+    free(data_b);
+    return same;
+}
+
+static int run(ResamplerBatch* batch, int threads, double* seconds) {
+    ResamplerEngine* engine = NULL;
+    if (resampler_engine_create((size_t)256 << 20, &engine) != 0) return -1;
+    ResamplerBatchReport report;
+    double t0 = bench_now_sec();
+    int status = resampler_batch_render(engine, batch, threads, stderr, &report);
+    *seconds = bench_now_sec() - t0;
+    resampler_engine_destroy(engine);
+    return status;
+}
+
+int main(int argc, char** argv) {
+    int notes = argc > 1 ? atoi(argv[1]) : 64;
+    if (notes <= 0 || notes > 100000) return EXIT_FAILURE;
+
+    const int fs = 44100, n = fs;
+    double* x = (double*)malloc(sizeof(double) * (size_t)n);
+    if (!x) return EXIT_FAILURE;
+    for (int w = 0; w < 2; w++) {
+        bench_make_signal(x, n, fs, w ? 260.0 : 180.0);
+        if (wav_write_pcm16(kWavs[w], x, n, fs, 1) != 0 || worldcache_ensure(kWavs[w], NULL) < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    free(x);
+    ResamplerBatch batch;
+    if (write_manifest(notes) != 0 || resampler_batch_load(kManifest, "ucra-cli", &batch, stderr) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    int cpus = worldx_cpu_count();
+    printf("%d notes, %d CPUs\n", notes, cpus);
+    printf("%8s %10s %10s %9s %10s\n", "threads", "seconds", "notes/s", "speedup", "identical");
+
+    const int thread_counts[] = { 1, 2, 4, 8 };
+    double base_s = 0.0, two_speedup = 0.0;
+    int failed = 0;
+    for (size_t k = 0; k < sizeof(thread_counts) / sizeof(thread_counts[0]) && !failed; k++) {
+        double seconds = 0.0;
+        if (run(&batch, thread_counts[k], &seconds) != 0) {
+            fprintf(stderr, "batch render failed on %d threads\n", thread_counts[k]);
+            failed = 1;
+            break;
+        }
+        // The one-thread render is the reference every later one must match
+        int identical = 1;
+        for (int i = 0; i < batch.count; i++) {
+            char ref[96];
+            note_file(ref, sizeof(ref), "ref", i);
+            if (k == 0) {
+                if (rename(batch.notes[i].config.out_file_path, ref) != 0) identical = 0;
+            } else if (!same_file(ref, batch.notes[i].config.out_file_path)) {
+                identical = 0;
+            }
+        }
+        if (k == 0) base_s = seconds;
+        if (thread_counts[k] == 2) two_speedup = base_s / seconds;
+        printf("%8d %10.3f %10.1f %8.2fx %10s\n", thread_counts[k], seconds, notes / seconds,
+               base_s / seconds, identical ? "yes" : "NO");
+        if (!identical) failed = 1;
+    }
+    if (!failed && cpus >= 2 && notes >= 2 && two_speedup < MIN_TWO_THREAD_SPEEDUP) {
+        fprintf(stderr, "two threads only %.2fx faster than one (want %.1fx)\n", two_speedup,
+                MIN_TWO_THREAD_SPEEDUP);
+        failed = 1;
+    }
+
+    for (int i = 0; i < batch.count; i++) {
+        char ref[96];
+        note_file(ref, sizeof(ref), "ref", i);
+        remove(ref);
+        remove(batch.notes[i].config.out_file_path);
+    }
+    resampler_batch_free(&batch);
+    char sidecar[96];
+    for (int w = 0; w < 2; w++) {
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWavs[w]);
+        remove(sidecar);
+        remove(kWavs[w]);
+    }
+    remove(kManifest);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file bench_resampler_server.c
+ * @brief Per-note wall time: a resampler process per note versus the server
+ *
+ * Usage: bench_resampler_server [notes] [seconds]
+ *
+ * Writes one sample of `seconds` (and its sidecar cache), then renders
+ * `notes` notes of varying pitch and length from it three ways:
+ *
+ *   spawn ucra-cli   one process per note rendering in-process, as UTAU and
+ *                    OpenUtau drive a resampler: startup, engine creation and
+ *                    a sidecar load every note
+ *   spawn shim       one ucra-resampler process per note, forwarding to a
+ *                    server started in this process
+ *   forward          the same requests sent from this process, i.e. the
+ *                    socket round trip and render without process startup
+ *
+ * Reports mean, median and worst wall time per note. POSIX only.
+ */
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cli/resampler_server.h"
+#include "worldcache/worldcache_manager.h"
+#include "bench/bench_common.h"
+
+extern char** environ;
+
+#define NOTE_ARGS 9
+
+static int write_wav(const char* path, const double* x, int n, int fs) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    uint32_t data_size = (uint32_t)n * 2, byte_rate = (uint32_t)fs * 2, fmt_size = 16, riff = 36 + data_size;
+    uint16_t pcm = 1, channels = 1, align = 2, bits = 16;
+    uint32_t rate = (uint32_t)fs;
+    fwrite("RIFF", 1, 4, f); fwrite(&riff, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f); fwrite(&pcm, 2, 1, f); fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f); fwrite(&byte_rate, 4, 1, f); fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f); fwrite(&data_size, 4, 1, f);
+    for (int i = 0; i < n; i++) {
+        int16_t v = (int16_t)(x[i] * 16000.0);
+        fwrite(&v, 2, 1, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/* Arguments of note i: pitch and length vary from note to note */
+typedef struct {
+    char pitch[32], length[32];
+    char* argv[NOTE_ARGS + 1];
+} Note;
+
+static void note_init(Note* note, const char* program, const char* wav, const char* out, int i) {
+    snprintf(note->pitch, sizeof(note->pitch), "%d", (i * 100) % 1200 - 600);
+    snprintf(note->length, sizeof(note->length), "%d", 200 + (i * 37) % 400);
+    const char* args[NOTE_ARGS] = { program, "-p", note->pitch, "-l", note->length, "-o", "20", wav, out };
+    for (int k = 0; k < NOTE_ARGS; k++) note->argv[k] = (char*)args[k];
+    note->argv[NOTE_ARGS] = NULL;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void report(const char* label, double* ms, int notes) {
+    double sum = 0.0;
+    for (int i = 0; i < notes; i++) sum += ms[i];
+    qsort(ms, (size_t)notes, sizeof(double), compare_double);
+    printf("%-15s %9.2f %9.2f %9.2f\n", label, sum / notes, ms[notes / 2], ms[notes - 1]);
+}
+
+/* Run program once per note with its output discarded; 0 if every note succeeded */
+static int run_spawn(const char* program, const char* wav, const char* out, int notes, double* ms) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+    int result = 0;
+    for (int i = 0; i < notes && result == 0; i++) {
+        Note note;
+        note_init(&note, program, wav, out, i);
+        double t0 = bench_now_sec();
+        pid_t pid;
+        int status = 0;
+        if (posix_spawn(&pid, program, &actions, NULL, note.argv, environ) != 0 ||
+            waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            result = -1;
+        }
+        ms[i] = (bench_now_sec() - t0) * 1e3;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return result;
+}
+
+static int run_forward(const char* socket_path, const char* wav, const char* out, int notes, double* ms) {
+    FILE* sink = fopen("/dev/null", "w");
+    if (!sink) return -1;
+    int result = 0;
+    for (int i = 0; i < notes && result == 0; i++) {
+        Note note;
+        note_init(&note, "ucra-resampler", wav, out, i);
+        double t0 = bench_now_sec();
+        int exit_code;
+        if (resampler_forward(socket_path, NOTE_ARGS, note.argv, sink, sink, &exit_code) != 0 ||
+            exit_code != EXIT_SUCCESS) {
+            result = -1;
+        }
+        ms[i] = (bench_now_sec() - t0) * 1e3;
+    }
+    fclose(sink);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int notes = argc > 1 ? atoi(argv[1]) : 50;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    const int fs = 44100;
+    int n = (int)(seconds * fs);
+    if (notes <= 0 || notes > 100000 || n <= 0) return EXIT_FAILURE;
+
+    const char* wav = "bench_resampler_server.wav";
+    const char* out = "bench_resampler_server_out.wav";
+    double* x = (double*)malloc(sizeof(double) * (size_t)n);
+    double* ms = (double*)malloc(sizeof(double) * (size_t)notes);
+    if (!x || !ms) return EXIT_FAILURE;
+    bench_make_signal(x, n, fs, 180.0);
+    if (write_wav(wav, x, n, fs) != 0 || worldcache_ensure(wav, NULL) < 0) return EXIT_FAILURE;
+    free(x);
+
+    // Spawned shims find the server through the environment
+    char socket_path[128];
+    snprintf(socket_path, sizeof(socket_path), "/tmp/bench_resampler_server_%d.sock", (int)getpid());
+    setenv(RESAMPLER_SOCKET_ENV, socket_path, 1);
+
+    printf("%d notes from a %.2f s sample (ms per note)\n", notes, seconds);
+    printf("%-15s %9s %9s %9s\n", "mode", "mean", "median", "max");
+    int failed = run_spawn(UCRA_CLI_PATH, wav, out, notes, ms) != 0;
+    if (!failed) report("spawn ucra-cli", ms, notes);
+
+    ResamplerServer* server = NULL;
+    if (resampler_server_start(socket_path, 0, (size_t)256 << 20, &server) != 0) {
+        fprintf(stderr, "server did not start\n");
+        return EXIT_FAILURE;
+    }
+    if (!failed) failed = run_spawn(UCRA_RESAMPLER_PATH, wav, out, notes, ms) != 0;
+    if (!failed) report("spawn shim", ms, notes);
+    if (!failed) failed = run_forward(socket_path, wav, out, notes, ms) != 0;
+    if (!failed) report("forward", ms, notes);
+
+    ResamplerServerStats stats;
+    resampler_request_stop(socket_path);
+    resampler_server_join(server, &stats);
+    printf("server: %llu requests, %llu failed, cache %llu hits, %llu misses\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.failed,
+           (unsigned long long)stats.cache_hits, (unsigned long long)stats.cache_misses);
+
+    char sidecar[96];
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", wav);
+    remove(sidecar);
+    remove(wav);
+    remove(out);
+    free(ms);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file bench_wav_io.c
+ * @brief WAV read/write throughput: mapped SIMD conversion versus per-sample stdio
+ *
+ * Usage: bench_wav_io [seconds] [reps]
+ *
+ * Writes a `seconds`-long test signal as 16-bit, 24-bit and float32 files
+ * (mono and stereo) and reads each back `reps` times two ways:
+ *
+ *   stdio   fread of the data chunk, then one scalar decode per sample
+ *           and channel (how wav_io read files before)
+ *   wav_io  wav_read_mono(): mapped file, SIMD conversion, block downmix
+ *
+ * then writes 16-bit output the same two ways, plain and with TPDF dither,
+ * quantizes the signal in memory (per-sample scalar versus the SIMD kernel),
+ * decodes 24-bit samples with each kernel set the CPU has and times a
+ * 22050 -> 44100 Hz rate conversion. Throughput is reported in
+ * MB/s of 16-bit/file data. The files stay in the page cache, so reads are
+ * conversion costs; file writes also pay for the page cache and filesystem,
+ * which the in-memory line leaves out.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simd_convert.h"
+#include "wav_io.h"
+#include "bench/bench_common.h"
+
+static const char* kPath = "bench_wav_io.wav";
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v & 0xFFFF); put16(p + 2, v >> 16); }
+
+/* Canonical 44-byte-header file of x in the given format, every channel the same */
+static long write_format(const double* x, int n, int fs, int format, int bits, int channels) {
+    int bytes = bits / 8;
+    size_t data_size = (size_t)n * (size_t)channels * (size_t)bytes;
+    uint8_t* buf = (uint8_t*)malloc(44 + data_size);
+    if (!buf) return -1;
+    memcpy(buf, "RIFF", 4);
+    put32(buf + 4, (uint32_t)(36 + data_size));
+    memcpy(buf + 8, "WAVEfmt ", 8);
+    put32(buf + 16, 16);
+    put16(buf + 20, (uint32_t)format);
+    put16(buf + 22, (uint32_t)channels);
+    put32(buf + 24, (uint32_t)fs);
+    put32(buf + 28, (uint32_t)(fs * channels * bytes));
+    put16(buf + 32, (uint32_t)(channels * bytes));
+    put16(buf + 34, (uint32_t)bits);
+    memcpy(buf + 36, "data", 4);
+    put32(buf + 40, (uint32_t)data_size);
+    uint8_t* p = buf + 44;
+    for (int i = 0; i < n; i++) {
+        for (int c = 0; c < channels; c++, p += bytes) {
+            if (format == 3) {
+                float v = (float)x[i];
+                memcpy(p, &v, 4);
+            } else {
+                int32_t v = (int32_t)(x[i] * (bits == 16 ? 32767.0 : 8388607.0));
+                for (int b = 0; b < bytes; b++) p[b] = (uint8_t)(v >> (8 * b));
+            }
+        }
+    }
+    FILE* f = fopen(kPath, "wb");
+    int ok = f && fwrite(buf, 1, 44 + data_size, f) == 44 + data_size;
+    if (f && fclose(f) != 0) ok = 0;
+    free(buf);
+    return ok ? (long)(44 + data_size) : -1;
+}
+
+static double decode_scalar(const uint8_t* p, int format, int bits) {
+    if (format == 3) {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    if (bits == 16) return (int16_t)(p[0] | p[1] << 8) / 32768.0;
+    int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24);
+    return (v >> 8) / 8388608.0;
+}
+
+/* The previous reader: read the data chunk, decode sample by sample */
+static int read_stdio(int format, int bits, int channels, double* x, int n) {
+    FILE* f = fopen(kPath, "rb");
+    if (!f) return -1;
+    size_t bytes = (size_t)bits / 8, data_size = (size_t)n * (size_t)channels * bytes;
+    uint8_t* data = (uint8_t*)malloc(data_size);
+    int ok = data && fseek(f, 44, SEEK_SET) == 0 && fread(data, 1, data_size, f) == data_size;
+    fclose(f);
+    for (int i = 0; ok && i < n; i++) {
+        double sum = 0.0;
+        for (int c = 0; c < channels; c++) {
+            sum += decode_scalar(data + ((size_t)i * (size_t)channels + (size_t)c) * bytes, format, bits);
+        }
+        x[i] = sum / channels;
+    }
+    free(data);
+    return ok ? 0 : -1;
+}
+
+/* The previous writer: per-sample clip, round and encode into 4 KB blocks */
+static int write_stdio(const double* x, int n, int fs, int channels) {
+    FILE* f = fopen(kPath, "wb");
+    if (!f) return -1;
+    uint8_t header[44] = { 0 };
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put32(header + 16, 16);
+    put16(header + 20, 1);
+    put16(header + 22, (uint32_t)channels);
+    put32(header + 24, (uint32_t)fs);
+    put16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    int ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+    uint8_t block[4096];
+    size_t used = 0, frame_bytes = (size_t)channels * 2;
+    for (int i = 0; ok && i < n; i++) {
+        double v = x[i] < -1.0 ? -1.0 : (x[i] > 1.0 ? 1.0 : x[i]);
+        double scaled = v * 32767.0;
+        int16_t s = (int16_t)(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+        for (int c = 0; c < channels; c++, used += 2) put16(block + used, (uint16_t)s);
+        if (used + frame_bytes > sizeof(block) || i == n - 1) {
+            ok = fwrite(block, 1, used, f) == used;
+            used = 0;
+        }
+    }
+    return fclose(f) == 0 && ok ? 0 : -1;
+}
+
+static int write_wav_io(const double* x, int n, int fs, int channels, int dither) {
+    WavWriter* writer = NULL;
+    if (wav_writer_open(kPath, fs, channels, &writer) != 0) return -1;
+    wav_writer_reserve(writer, (uint64_t)n);
+    if (dither) wav_writer_set_dither(writer, 1);
+    int ok = wav_writer_write(writer, x, n) == 0;
+    return wav_writer_close(writer) == 0 && ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 30.0;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+    if (seconds <= 0.0 || seconds > 600.0 || reps <= 0) return EXIT_FAILURE;
+
+    const int fs = 44100, n = (int)(seconds * fs);
+    double* x = (double*)malloc(sizeof(double) * (size_t)n);
+    double* y = (double*)malloc(sizeof(double) * (size_t)n);
+    if (!x || !y) return EXIT_FAILURE;
+    bench_make_signal(x, n, fs, 220.0);
+    int failed = 0;
+
+    printf("%.0f s at %d Hz, best of %d\n", seconds, fs, reps);
+    printf("%-16s %12s %12s %8s\n", "read", "stdio MB/s", "wav_io MB/s", "speedup");
+    const struct { const char* name; int format, bits, channels; } reads[] = {
+        { "pcm16 mono", 1, 16, 1 }, { "pcm16 stereo", 1, 16, 2 }, { "pcm24 mono", 1, 24, 1 },
+        { "pcm24 stereo", 1, 24, 2 }, { "float32 mono", 3, 32, 1 }, { "float32 stereo", 3, 32, 2 },
+    };
+    for (size_t r = 0; r < sizeof(reads) / sizeof(reads[0]) && !failed; r++) {
+        long size = write_format(x, n, fs, reads[r].format, reads[r].bits, reads[r].channels);
+        if (size < 0) { failed = 1; break; }
+        double best_stdio = 1e30, best_mapped = 1e30;
+        for (int k = 0; k < reps && !failed; k++) {
+            double t0 = bench_now_sec();
+            failed = read_stdio(reads[r].format, reads[r].bits, reads[r].channels, y, n) != 0;
+            double t1 = bench_now_sec();
+            double* z = NULL;
+            int length = 0, rate = 0;
+            failed = failed || wav_read_mono(kPath, &z, &length, &rate) != 0 || length != n;
+            double t2 = bench_now_sec();
+            // Same samples both ways
+            if (!failed && memcmp(y, z, sizeof(double) * (size_t)n) != 0) failed = 1;
+            free(z);
+            if (t1 - t0 < best_stdio) best_stdio = t1 - t0;
+            if (t2 - t1 < best_mapped) best_mapped = t2 - t1;
+        }
+        if (!failed) {
+            printf("%-16s %12.1f %12.1f %7.2fx\n", reads[r].name, size / 1048576.0 / best_stdio,
+                   size / 1048576.0 / best_mapped, best_stdio / best_mapped);
+        }
+    }
+
+    printf("%-16s %12s %12s %8s\n", "write pcm16", "stdio MB/s", "wav_io MB/s", "speedup");
+    for (int channels = 1; channels <= 2 && !failed; channels++) {
+        for (int dither = 0; dither <= 1 && !failed; dither++) {
+            double best_stdio = 1e30, best_simd = 1e30;
+            // Alternate which goes first so neither always pays for the other's writeback
+            for (int k = 0; k < 2 * reps && !failed; k++) {
+                double t0 = bench_now_sec();
+                failed = (k & 1 ? write_wav_io(x, n, fs, channels, dither) : write_stdio(x, n, fs, channels)) != 0;
+                double t = bench_now_sec() - t0;
+                double* best = k & 1 ? &best_simd : &best_stdio;
+                if (t < *best) *best = t;
+            }
+            double mb = (44.0 + 2.0 * n * channels) / 1048576.0;
+            if (!failed) {
+                printf("%-16s %12.1f %12.1f %7.2fx\n", channels == 1 ? (dither ? "mono, tpdf" : "mono")
+                                                                   : (dither ? "stereo, tpdf" : "stereo"),
+                       mb / best_stdio, mb / best_simd, best_stdio / best_simd);
+            }
+        }
+    }
+
+    if (!failed) {
+        int16_t* q = (int16_t*)malloc(sizeof(int16_t) * (size_t)n);
+        double best_scalar = 1e30, best_simd = 1e30;
+        for (int k = 0; q && k < reps; k++) {
+            double t0 = bench_now_sec();
+            for (int i = 0; i < n; i++) {
+                double v = x[i] < -1.0 ? -1.0 : (x[i] > 1.0 ? 1.0 : x[i]);
+                double scaled = v * 32767.0;
+                q[i] = (int16_t)(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+            }
+            double t1 = bench_now_sec();
+            simd_convert_f64_to_s16(x, NULL, q, (size_t)n);
+            double t2 = bench_now_sec();
+            if (t1 - t0 < best_scalar) best_scalar = t1 - t0;
+            if (t2 - t1 < best_simd) best_simd = t2 - t1;
+        }
+        double mb = 2.0 * n / 1048576.0;
+        if (q) {
+            printf("%-16s %12.1f %12.1f %7.2fx\n", "memory", mb / best_scalar, mb / best_simd,
+                   best_scalar / best_simd);
+        }
+        failed = !q;
+        free(q);
+    }
+
+    // 24-bit decode with each kernel set this CPU has
+    if (!failed) {
+        uint8_t* raw = (uint8_t*)malloc(3 * (size_t)n + 16);
+        failed = !raw;
+        for (int i = 0; raw && i < n; i++) {
+            int32_t v = (int32_t)(x[i] * 8388607.0);
+            raw[3 * i] = (uint8_t)v;
+            raw[3 * i + 1] = (uint8_t)(v >> 8);
+            raw[3 * i + 2] = (uint8_t)(v >> 16);
+        }
+        printf("%-16s", "pcm24 decode");
+        for (int isa = WORLD_FLAGS_ISA_SCALAR; raw && isa <= (int)world_flags_detect_isa(); isa++) {
+            simd_convert_set_isa((WorldFlagsIsa)isa);
+            double best = 1e30;
+            for (int k = 0; k < reps; k++) {
+                double t0 = bench_now_sec();
+                simd_convert_s24le_to_f64(raw, y, (size_t)n);
+                double t = bench_now_sec() - t0;
+                if (t < best) best = t;
+            }
+            printf(" %s %.1f MB/s", world_flags_isa_name((WorldFlagsIsa)isa), 3.0 * n / 1048576.0 / best);
+        }
+        printf("\n");
+        simd_convert_set_isa(WORLD_FLAGS_ISA_AVX2);
+        free(raw);
+    }
+
+    if (!failed) {
+        int half = n / 2;
+        double best = 1e30;
+        for (int k = 0; k < reps && !failed; k++) {
+            double* z = NULL;
+            int length = 0;
+            double t0 = bench_now_sec();
+            failed = wav_resample(x, half, 22050, 44100, &z, &length) != 0;
+            double t1 = bench_now_sec();
+            free(z);
+            if (t1 - t0 < best) best = t1 - t0;
+        }
+        if (!failed) printf("resample 22050 -> 44100: %.1f Msamples/s in\n", half / best / 1e6);
+    }
+
+    remove(kPath);
+    free(x);
+    free(y);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file bench_wavtool.c
+ * @brief Whole-song render: a file per note plus wavtool versus mixing in memory
+ *
+ * Usage: bench_wavtool [notes] [threads]
+ *
+ * Writes two samples (and their sidecar caches) and a song manifest of
+ * `notes` overlapping notes with UTAU envelopes, then renders the song two
+ * ways, each with a fresh engine:
+ *
+ *   files      the classic flow: every note written to its own WAV, then
+ *              decoded again and mixed into the song one file at a time
+ *   in-memory  batch -w: rendered buffers mixed straight into the song
+ *              through the streaming mixer
+ *
+ * Reports wall time, notes/s and the bytes of temporary note files written
+ * and read back.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cli/resampler_batch.h"
+#include "wav_io.h"
+#include "worldcache/worldcache_manager.h"
+#include "bench/bench_common.h"
+
+static const char* kWavs[2] = { "bench_wavtool_a.wav", "bench_wavtool_b.wav" };
+static const char* kManifest = "bench_wavtool.txt";
+static const char* kSong = "bench_wavtool_song.wav";
+
+static void note_file(char* buf, size_t size, int i) {
+    snprintf(buf, size, "bench_wavtool_note_%d.wav", i);
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    fclose(f);
+    return size;
+}
+
+/* Eighth notes at 120 BPM with a 30 ms overlap and a fade at both ends */
+static int write_manifest(int notes) {
+    FILE* f = fopen(kManifest, "w");
+    if (!f) return -1;
+    for (int i = 0; i < notes; i++) {
+        char out[64];
+        note_file(out, sizeof(out), i);
+        fprintf(f, "-p %d -l 300 -o 20 -c 60 %s %s 0 240@120+30 0 10 35 0 100 100 0 30\n",
+                (i * 100) % 1200 - 600, kWavs[i % 2], out);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/* The classic flow: note files, then a wavtool pass decoding each of them */
+static int run_files(ResamplerBatch* batch, int threads, double* seconds, uint64_t* temp_bytes) {
+    ResamplerEngine* engine = NULL;
+    if (resampler_engine_create((size_t)256 << 20, &engine) != 0) return -1;
+    double t0 = bench_now_sec();
+    ResamplerBatchReport report;
+    int status = resampler_batch_render(engine, batch, threads, stderr, &report);
+    resampler_engine_destroy(engine);
+    WavtoolMixer* mixer = NULL;
+    if (status != 0 || wavtool_mixer_create(kSong, 44100, 1, 512, WAVTOOL_HISTORY_MS, &mixer) != 0) return -1;
+
+    *temp_bytes = 0;
+    for (int i = 0; i < batch->count && status == 0; i++) {
+        const ResamplerBatchNote* note = &batch->notes[i];
+        WavtoolNote placement;
+        double* x = NULL;
+        int length = 0, fs = 0;
+        long size = file_size(note->config.out_file_path);
+        if (size < 0 || wavtool_parse_note(note->wavtool_argc, note->wavtool_argv, &placement, stderr) != 0 ||
+            wav_read_mono(note->config.out_file_path, &x, &length, &fs) != 0 ||
+            wavtool_mixer_add(mixer, x, length, &placement) != 0) {
+            status = -1;
+        }
+        free(x);
+        *temp_bytes += 2 * (uint64_t)(size > 0 ? size : 0);  // written, then read back
+    }
+    if (wavtool_mixer_finish(mixer, NULL) != 0) status = -1;
+    *seconds = bench_now_sec() - t0;
+    return status;
+}
+
+static int run_memory(ResamplerBatch* batch, int threads, double* seconds) {
+    ResamplerEngine* engine = NULL;
+    if (resampler_engine_create((size_t)256 << 20, &engine) != 0) return -1;
+    double t0 = bench_now_sec();
+    ResamplerBatchReport report;
+    int status = resampler_batch_render_song(engine, batch, kSong, threads, stderr, &report, NULL);
+    *seconds = bench_now_sec() - t0;
+    resampler_engine_destroy(engine);
+    return status;
+}
+
+int main(int argc, char** argv) {
+    int notes = argc > 1 ? atoi(argv[1]) : 200;
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+    if (notes <= 0 || notes > 100000) return EXIT_FAILURE;
+
+    const int fs = 44100, n = fs;
+    double* x = (double*)malloc(sizeof(double) * (size_t)n);
+    if (!x) return EXIT_FAILURE;
+    for (int w = 0; w < 2; w++) {
+        bench_make_signal(x, n, fs, w ? 260.0 : 180.0);
+        if (wav_write_pcm16(kWavs[w], x, n, fs, 1) != 0 || worldcache_ensure(kWavs[w], NULL) < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    free(x);
+    ResamplerBatch batch;
+    if (write_manifest(notes) != 0 || resampler_batch_load(kManifest, "ucra-cli", &batch, stderr) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    double files_s = 0.0, memory_s = 0.0;
+    uint64_t temp_bytes = 0;
+    int failed = run_files(&batch, threads, &files_s, &temp_bytes) != 0;
+    long song_bytes = file_size(kSong);
+    if (!failed) failed = run_memory(&batch, threads, &memory_s) != 0;
+
+    if (!failed) {
+        printf("%d notes, %.1f KB song\n", notes, song_bytes / 1024.0);
+        printf("%-10s %10s %10s %14s\n", "mode", "seconds", "notes/s", "temp I/O MB");
+        printf("%-10s %10.3f %10.1f %14.2f\n", "files", files_s, notes / files_s, temp_bytes / 1048576.0);
+        printf("%-10s %10.3f %10.1f %14.2f\n", "in-memory", memory_s, notes / memory_s, 0.0);
+    }
+
+    for (int i = 0; i < batch.count; i++) remove(batch.notes[i].config.out_file_path);
+    resampler_batch_free(&batch);
+    char sidecar[96];
+    for (int w = 0; w < 2; w++) {
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWavs[w]);
+        remove(sidecar);
+        remove(kWavs[w]);
+    }
+    remove(kManifest);
+    remove(kSong);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file bench_world_coded.c
+ * @brief Cache bytes, load time and per-frame decode cost of coded sp/ap
+ *
+ * Usage: bench_world_coded [seconds] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "world_quality.h"
+#include "worldcache/worldcache_serialize.h"
+#include "bench/bench_common.h"
+
+typedef struct {
+    const char* name;
+    WorldPrecision precision;
+    int coded;
+} Variant;
+
+// Pack sp/ap into cache blocks the way they are laid out in memory
+static int build_cache(const WorldAnalysisData* data, uint8_t** out_buf, size_t* out_size) {
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    h.sample_rate = data->sample_rate;
+    h.frame_period_ms = data->frame_period;
+    h.num_frames = (uint32_t)data->f0_length;
+    h.fft_size = (uint32_t)data->fft_size;
+
+    size_t frames = (size_t)data->f0_length;
+    size_t sp_dims, ap_dims;
+    const void* sp;
+    const void* ap;
+    if (world_analysis_data_is_coded(data)) {
+        h.flags |= WORLDCACHE_FLAG_CODED;
+        sp_dims = (size_t)data->coded_sp_dims;
+        ap_dims = (size_t)data->coded_ap_dims;
+        sp = data->coded_spectrogram[0];
+        ap = data->coded_aperiodicity[0];
+    } else {
+        sp_dims = ap_dims = (size_t)(data->fft_size / 2 + 1);
+        if (data->precision == WORLD_PRECISION_FLOAT32) {
+            h.flags |= WORLDCACHE_FLAG_FLOAT32;
+            sp = data->spectrogram_f32[0];
+            ap = data->aperiodicity_f32[0];
+        } else {
+            sp = data->spectrogram[0];
+            ap = data->aperiodicity[0];
+        }
+    }
+    size_t value_size = worldcache_header_value_size(&h);
+    h.sp_size = (uint64_t)(frames * sp_dims * value_size);
+    h.ap_size = (uint64_t)(frames * ap_dims * value_size);
+    h.voiced_mask_size = 0;
+    return worldcache_serialize(&h, (const uint8_t*)sp, (const uint8_t*)ap, NULL, out_buf, out_size);
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    if (x_length <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * x_length);
+    double* y_ref = (double*)malloc(sizeof(double) * x_length);
+    double* y = (double*)malloc(sizeof(double) * x_length);
+    if (!x || !y_ref || !y) return EXIT_FAILURE;
+    bench_make_signal(x, x_length, fs, 220.0);
+
+    printf("%-8s %12s %10s %14s %10s %10s\n", "variant", "cache_bytes", "load_ms",
+           "decode_us/frm", "snr_db", "mcd_db");
+
+    const Variant variants[] = {
+        { "double", WORLD_PRECISION_DOUBLE, 0 },
+        { "float32", WORLD_PRECISION_FLOAT32, 0 },
+        { "coded", WORLD_PRECISION_DOUBLE, 1 },
+    };
+    WorldAnalysisData ref;
+    world_analysis_data_init(&ref);
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        WorldAnalysisData data;
+        world_analysis_data_init(&data);
+        data.precision = variants[v].precision;
+        if (world_analyze(x, x_length, fs, NULL, &data) != 0 ||
+            (variants[v].coded && world_analysis_data_encode(&data, 0) != 0)) {
+            fprintf(stderr, "analysis failed\n");
+            return EXIT_FAILURE;
+        }
+
+        uint8_t* buf = NULL;
+        size_t buf_size = 0;
+        if (build_cache(&data, &buf, &buf_size) != 0) {
+            fprintf(stderr, "serialize failed\n");
+            return EXIT_FAILURE;
+        }
+
+        double t0 = bench_now_sec();
+        for (int it = 0; it < iterations; it++) {
+            WorldCacheHeader_t h;
+            uint8_t *sp = NULL, *ap = NULL, *vm = NULL;
+            if (worldcache_deserialize(buf, buf_size, &h, &sp, &ap, &vm) != 0) {
+                fprintf(stderr, "deserialize failed\n");
+                return EXIT_FAILURE;
+            }
+            worldcache_free_blocks(sp, ap, vm);
+        }
+        double load_ms = (bench_now_sec() - t0) * 1000.0 / iterations;
+
+        // Materialize every frame once, as synthesis would
+        int bins = data.fft_size / 2 + 1;
+        double* sp_row = (double*)malloc(sizeof(double) * bins);
+        double* ap_row = (double*)malloc(sizeof(double) * bins);
+        if (!sp_row || !ap_row) return EXIT_FAILURE;
+        double t1 = bench_now_sec();
+        for (int i = 0; i < data.f0_length; i++) {
+            world_analysis_data_get_frame(&data, i, sp_row, ap_row);
+        }
+        double decode_us = (bench_now_sec() - t1) * 1e6 / data.f0_length;
+
+        double snr = 0.0, mcd = 0.0;
+        if (v == 0) {
+            world_synthesize(&data, y_ref, x_length);
+        } else {
+            world_synthesize(&data, y, x_length);
+            snr = world_quality_snr_db(y_ref, y, x_length);
+            // Compare materialized envelopes frame by frame against the double run
+            double total = 0.0;
+            for (int i = 0; i < data.f0_length; i++) {
+                world_analysis_data_get_frame(&data, i, sp_row, ap_row);
+                const double* ref_row[1] = { ref.spectrogram[i] };
+                const double* test_row[1] = { sp_row };
+                total += world_quality_mcd_db(ref_row, test_row, 1, data.fft_size, fs);
+            }
+            mcd = total / data.f0_length;
+        }
+        printf("%-8s %12zu %10.3f %14.2f %10.2f %10.4f\n", variants[v].name, buf_size, load_ms,
+               decode_us, snr, mcd);
+
+        free(sp_row);
+        free(ap_row);
+        free(buf);
+        if (v == 0) {
+            ref = data;  // kept as the quality reference
+        } else {
+            world_analysis_data_free(&data);
+        }
+    }
+
+    world_analysis_data_free(&ref);
+    free(x);
+    free(y_ref);
+    free(y);
+    return EXIT_SUCCESS;
+}
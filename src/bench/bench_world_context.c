@@ -0,0 +1,71 @@
+/**
+ * @file bench_world_context.c
+ * @brief Per-file analysis time with and without a WorldAnalysisContext
+ *
+ * Usage: bench_world_context [files] [max_seconds]
+ *
+ * Simulates batch precaching: many short samples of varying length are
+ * analyzed one after another, either with world_analyze() into fresh data
+ * or with one context reusing the same WorldAnalysisData.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "bench/bench_common.h"
+
+int main(int argc, char** argv) {
+    int files = argc > 1 ? atoi(argv[1]) : 200;
+    double max_seconds = argc > 2 ? atof(argv[2]) : 0.5;
+    const int fs = 44100;
+    int max_length = (int)(max_seconds * fs);
+    if (files <= 0 || max_length <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * max_length);
+    int* lengths = (int*)malloc(sizeof(int) * files);
+    if (!x || !lengths) return EXIT_FAILURE;
+    bench_make_signal(x, max_length, fs, 220.0);
+
+    // Lengths between 40% and 100% of max_seconds, fixed sequence
+    unsigned int seed = 2024u;
+    for (int i = 0; i < files; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        lengths[i] = (int)(max_length * (0.4 + 0.6 * (double)(seed >> 8) / 16777216.0));
+    }
+
+    double t0 = bench_now_sec();
+    for (int i = 0; i < files; i++) {
+        WorldAnalysisData data;
+        world_analysis_data_init(&data);
+        if (world_analyze(x, lengths[i], fs, NULL, &data) != 0) {
+            fprintf(stderr, "analysis failed\n");
+            return EXIT_FAILURE;
+        }
+        world_analysis_data_free(&data);
+    }
+    double fresh_ms = (bench_now_sec() - t0) * 1000.0 / files;
+
+    WorldAnalysisContext* ctx = NULL;
+    if (world_analysis_context_create(&ctx, fs, NULL) != 0) return EXIT_FAILURE;
+    WorldAnalysisData data;
+    world_analysis_data_init(&data);
+    double t1 = bench_now_sec();
+    for (int i = 0; i < files; i++) {
+        if (world_analysis_context_analyze(ctx, x, lengths[i], &data) != 0) {
+            fprintf(stderr, "analysis failed\n");
+            return EXIT_FAILURE;
+        }
+    }
+    double context_ms = (bench_now_sec() - t1) * 1000.0 / files;
+    world_analysis_data_free(&data);
+    world_analysis_context_destroy(ctx);
+
+    printf("%-10s %8s %14s\n", "mode", "files", "ms_per_file");
+    printf("%-10s %8d %14.3f\n", "fresh", files, fresh_ms);
+    printf("%-10s %8d %14.3f\n", "context", files, context_ms);
+    printf("speed-up %.2fx\n", fresh_ms / context_ms);
+
+    free(x);
+    free(lengths);
+    return EXIT_SUCCESS;
+}
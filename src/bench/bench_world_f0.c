@@ -0,0 +1,85 @@
+/**
+ * @file bench_world_f0.c
+ * @brief Time and F0 RMSE of each WorldF0Estimator
+ *
+ * Usage: bench_world_f0 [seconds] [iterations]
+ *
+ * The reference set is the benchmark test signal at several base F0s, whose
+ * true contour is known exactly (bench_signal_f0()). RMSE is in cents over
+ * frames both the estimator and the reference treat as voiced; "unvoiced"
+ * is the share of frames the estimator wrongly left unvoiced.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "bench/bench_common.h"
+
+static const char* estimator_name(WorldF0Estimator estimator) {
+    switch (estimator) {
+        case WORLD_F0_DIO_STONEMASK: return "dio+stonemask";
+        case WORLD_F0_HARVEST_DECIMATED: return "harvest-dec";
+        default: return "harvest";
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 3;
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    if (x_length <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * x_length);
+    if (!x) return EXIT_FAILURE;
+
+    printf("%-14s %8s %12s %12s %10s\n", "estimator", "base_f0", "analyze_ms", "rmse_cents",
+           "unvoiced");
+
+    const double base_f0s[] = { 110.0, 220.0, 440.0 };
+    const WorldF0Estimator estimators[] = {
+        WORLD_F0_HARVEST, WORLD_F0_DIO_STONEMASK, WORLD_F0_HARVEST_DECIMATED
+    };
+    for (size_t b = 0; b < sizeof(base_f0s) / sizeof(base_f0s[0]); b++) {
+        bench_make_signal(x, x_length, fs, base_f0s[b]);
+        for (size_t e = 0; e < sizeof(estimators) / sizeof(estimators[0]); e++) {
+            WorldAnalysisOptions options;
+            world_analysis_options_init(&options);
+            options.f0_estimator = estimators[e];
+
+            double total = 0.0, rmse = 0.0, unvoiced = 0.0;
+            for (int it = 0; it < iterations; it++) {
+                WorldAnalysisData data;
+                world_analysis_data_init(&data);
+                double t0 = bench_now_sec();
+                if (world_analyze(x, x_length, fs, &options, &data) != 0) {
+                    fprintf(stderr, "analysis failed\n");
+                    return EXIT_FAILURE;
+                }
+                total += bench_now_sec() - t0;
+
+                double sum = 0.0;
+                int voiced = 0, missed = 0;
+                for (int i = 0; i < data.f0_length; i++) {
+                    if (data.f0[i] <= 0.0) {
+                        missed++;
+                        continue;
+                    }
+                    double ref = bench_signal_f0(base_f0s[b], data.temporal_positions[i]);
+                    double cents = 1200.0 * log2(data.f0[i] / ref);
+                    sum += cents * cents;
+                    voiced++;
+                }
+                rmse = voiced ? sqrt(sum / voiced) : 0.0;
+                unvoiced = (double)missed / data.f0_length;
+                world_analysis_data_free(&data);
+            }
+            printf("%-14s %8.0f %12.2f %12.2f %9.1f%%\n", estimator_name(estimators[e]),
+                   base_f0s[b], total * 1000.0 / iterations, rmse, 100.0 * unvoiced);
+        }
+    }
+
+    free(x);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file bench_world_flags.c
+ * @brief Frames per second of the flag pipeline per flag combination and ISA
+ *
+ * Usage: bench_world_flags [seconds] [iterations]
+ *
+ * Compares the unfused scalar reference against the fused pipeline on every
+ * instruction set the CPU supports, and reports the largest relative
+ * difference of the fused result against the reference.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "world_flags.h"
+#include "bench/bench_common.h"
+
+typedef struct {
+    const char* name;
+    WorldFlagParams params;
+} FlagCase;
+
+static int copy_data(const WorldAnalysisData* src, WorldAnalysisData* dst) {
+    if (world_analysis_data_allocate(dst, src->f0_length, src->fft_size) != 0) return -1;
+    size_t bins = (size_t)(src->fft_size / 2 + 1);
+    for (int i = 0; i < src->f0_length; i++) {
+        memcpy(dst->spectrogram[i], src->spectrogram[i], sizeof(double) * bins);
+        memcpy(dst->aperiodicity[i], src->aperiodicity[i], sizeof(double) * bins);
+    }
+    dst->sample_rate = src->sample_rate;
+    return 0;
+}
+
+static double max_rel_diff(const WorldAnalysisData* a, const WorldAnalysisData* b) {
+    int bins = a->fft_size / 2 + 1;
+    double worst = 0.0;
+    for (int i = 0; i < a->f0_length; i++) {
+        for (int j = 0; j < bins; j++) {
+            double d = fabs(a->spectrogram[i][j] - b->spectrogram[i][j]) /
+                       (fabs(b->spectrogram[i][j]) + 1e-30);
+            double e = fabs(a->aperiodicity[i][j] - b->aperiodicity[i][j]) /
+                       (fabs(b->aperiodicity[i][j]) + 1e-30);
+            if (d > worst) worst = d;
+            if (e > worst) worst = e;
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 4.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    if (seconds <= 0.0 || iterations <= 0) return EXIT_FAILURE;
+
+    WorldAnalysisData src, ref, work;
+    world_analysis_data_init(&src);
+    world_analysis_data_init(&ref);
+    world_analysis_data_init(&work);
+    if (world_generate_dummy_data(&src, seconds, 44100, 5.0, 220.0) != 0) return EXIT_FAILURE;
+
+    const FlagCase cases[] = {
+        { "g", { 30.0, 0.0, 0.0, 0.0 } },
+        { "B", { 0.0, 40.0, 0.0, 0.0 } },
+        { "H", { 0.0, 0.0, 50.0, 0.0 } },
+        { "t", { 0.0, 0.0, 0.0, -2.0 } },
+        { "B+t", { 0.0, 40.0, 0.0, -2.0 } },
+        { "g+B+H+t", { 30.0, 40.0, 50.0, -2.0 } },
+    };
+    WorldFlagsIsa best = world_flags_detect_isa();
+
+    printf("%-9s %-10s %14s %12s\n", "flags", "kernel", "frames/s", "max_rel_diff");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const WorldFlagParams* params = &cases[c].params;
+        if (copy_data(&src, &ref) != 0) return EXIT_FAILURE;
+
+        double t0 = bench_now_sec();
+        for (int it = 0; it < iterations; it++) {
+            // Timing runs on the same frames again; only the first pass is kept
+            WorldAnalysisData* target = it == 0 ? &ref : &work;
+            if (it == 1 && copy_data(&src, &work) != 0) return EXIT_FAILURE;
+            for (int i = 0; i < src.f0_length; i++) {
+                world_flags_apply_reference(params, src.sample_rate, src.fft_size,
+                                            target->spectrogram[i], target->aperiodicity[i]);
+            }
+        }
+        double ref_fps = (double)src.f0_length * iterations / (bench_now_sec() - t0);
+        printf("%-9s %-10s %14.0f %12s\n", cases[c].name, "reference", ref_fps, "-");
+
+        WorldFlagPipeline* pipeline = NULL;
+        if (world_flag_pipeline_create(&pipeline, params, src.sample_rate, src.fft_size) != 0) {
+            return EXIT_FAILURE;
+        }
+        for (int isa = WORLD_FLAGS_ISA_SCALAR; isa <= (int)best; isa++) {
+            world_flag_pipeline_set_isa(pipeline, (WorldFlagsIsa)isa);
+            if (copy_data(&src, &work) != 0) return EXIT_FAILURE;
+            world_flag_pipeline_apply(pipeline, &work);
+            double diff = max_rel_diff(&work, &ref);
+
+            double t1 = bench_now_sec();
+            for (int it = 0; it < iterations; it++) {
+                world_flag_pipeline_apply(pipeline, &work);
+            }
+            double fps = (double)src.f0_length * iterations / (bench_now_sec() - t1);
+            printf("%-9s %-10s %14.0f %12.3g\n", cases[c].name,
+                   world_flags_isa_name((WorldFlagsIsa)isa), fps, diff);
+        }
+        world_flag_pipeline_destroy(pipeline);
+    }
+
+    world_analysis_data_free(&src);
+    world_analysis_data_free(&ref);
+    world_analysis_data_free(&work);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file bench_world_layout.c
+ * @brief Allocation count and analyze/synthesize time per WorldDataLayout
+ *
+ * Usage: bench_world_layout [seconds] [iterations]
+ *
+ * "allocs" is the number of heap allocations one world_analyze() call makes,
+ * counted by interposing the allocator (WORLD's own included); it reads
+ * "n/a" where the counter is unavailable (non-glibc, sanitizer builds).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "worldx_alloc_count.h"
+#include "bench/bench_common.h"
+
+static const char* layout_name(WorldDataLayout layout) {
+    return layout == WORLD_LAYOUT_CONTIGUOUS ? "contiguous" : "rows";
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    if (x_length <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * x_length);
+    double* y = (double*)malloc(sizeof(double) * x_length);
+    if (!x || !y) return EXIT_FAILURE;
+    bench_make_signal(x, x_length, fs, 220.0);
+
+    printf("%-11s %8s %8s %12s %12s\n", "layout", "frames", "allocs", "analyze_ms", "synth_ms");
+
+    const WorldDataLayout layouts[] = { WORLD_LAYOUT_ROWS, WORLD_LAYOUT_CONTIGUOUS };
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        double analyze_sec = 0.0, synth_sec = 0.0;
+        int frames = 0;
+        long allocs = 0;
+        for (int it = 0; it < iterations; it++) {
+            WorldAnalysisData data;
+            world_analysis_data_init(&data);
+            data.layout = layouts[l];
+
+            long before = worldx_alloc_count();
+            double t0 = bench_now_sec();
+            if (world_analyze(x, x_length, fs, NULL, &data) != 0) {
+                fprintf(stderr, "analysis failed\n");
+                return EXIT_FAILURE;
+            }
+            double t1 = bench_now_sec();
+            allocs = worldx_alloc_count() - before;
+            world_synthesize(&data, y, x_length);
+            double t2 = bench_now_sec();
+
+            analyze_sec += t1 - t0;
+            synth_sec += t2 - t1;
+            frames = data.f0_length;
+            world_analysis_data_free(&data);
+        }
+        char count[32] = "n/a";
+        if (WORLDX_ALLOC_COUNT_AVAILABLE) snprintf(count, sizeof(count), "%ld", allocs);
+        printf("%-11s %8d %8s %12.2f %12.2f\n", layout_name(layouts[l]), frames, count,
+               analyze_sec * 1000.0 / iterations, synth_sec * 1000.0 / iterations);
+    }
+
+    free(x);
+    free(y);
+    return EXIT_SUCCESS;
+}
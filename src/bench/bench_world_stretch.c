@@ -0,0 +1,114 @@
+/**
+ * @file bench_world_stretch.c
+ * @brief Memory traffic and render time of stretched notes
+ *
+ * Usage: bench_world_stretch [length_ms] [iterations]
+ *
+ * Renders a long note (default 4 s) whose vowel is a 300 ms region of a
+ * 0.5 s analysis. "copy" builds a full WorldAnalysisData with an
+ * interpolated sp/ap row per output frame, the way a naive resampler would;
+ * the view variants point into the source and differ only in when they
+ * interpolate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "world_stretch.h"
+#include "bench/bench_common.h"
+
+// Naive reference: materialize every output frame
+static int build_copy(const WorldAnalysisData* src, const WorldFrameView* map,
+                      WorldAnalysisData* out) {
+    int bins = src->fft_size / 2 + 1;
+    if (world_analysis_data_allocate(out, map->frame_count, src->fft_size) != 0) return -1;
+    out->frame_period = src->frame_period;
+    out->sample_rate = src->sample_rate;
+    for (int j = 0; j < map->frame_count; j++) {
+        out->f0[j] = map->f0[j];
+        memcpy(out->spectrogram[j], map->spectrogram[j], sizeof(double) * bins);
+        memcpy(out->aperiodicity[j], map->aperiodicity[j], sizeof(double) * bins);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    double length_ms = argc > 1 ? atof(argv[1]) : 4000.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    const int fs = 44100;
+    int x_length = fs / 2;
+    if (length_ms <= 0.0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * x_length);
+    int y_length = (int)(length_ms / 1000.0 * fs);
+    double* y = (double*)malloc(sizeof(double) * y_length);
+    if (!x || !y) return EXIT_FAILURE;
+    bench_make_signal(x, x_length, fs, 220.0);
+
+    WorldAnalysisData source;
+    world_analysis_data_init(&source);
+    if (world_analyze(x, x_length, fs, NULL, &source) != 0) {
+        fprintf(stderr, "analysis failed\n");
+        return EXIT_FAILURE;
+    }
+    int bins = source.fft_size / 2 + 1;
+
+    WorldStretchParams params;
+    world_stretch_params_init(&params);
+    params.offset_ms = 50.0;
+    params.consonant_ms = 100.0;
+    params.cutoff_ms = -400.0;
+    params.length_ms = length_ms;
+
+    printf("%-12s %8s %10s %14s %10s %10s\n", "variant", "frames", "interp", "bytes_written",
+           "build_ms", "synth_ms");
+
+    const struct { const char* name; double threshold; } variants[] = {
+        { "copy", 0.0 },
+        { "view-all", 0.0 },
+        { "view-0.5dB", 0.5 },
+        { "view-near", -1.0 },
+    };
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        params.interp_threshold_db = variants[v].threshold;
+        WorldFrameView view;
+        world_frame_view_init(&view);
+        WorldAnalysisData copy;
+        world_analysis_data_init(&copy);
+        int is_copy = v == 0;
+
+        double build = 0.0, synth = 0.0;
+        for (int it = 0; it < iterations; it++) {
+            double t0 = bench_now_sec();
+            if (world_frame_view_build(&view, &source, &params) != 0 ||
+                (is_copy && build_copy(&source, &view, &copy) != 0)) {
+                fprintf(stderr, "build failed\n");
+                return EXIT_FAILURE;
+            }
+            double t1 = bench_now_sec();
+            if (is_copy) {
+                world_synthesize(&copy, y, y_length);
+            } else {
+                world_frame_view_synthesize(&view, y, y_length);
+            }
+            double t2 = bench_now_sec();
+            build += t1 - t0;
+            synth += t2 - t1;
+        }
+
+        size_t bytes = is_copy ? view.bytes_written +
+                                     (size_t)view.frame_count * 2 * (size_t)bins * sizeof(double)
+                               : view.bytes_written;
+        printf("%-12s %8d %10d %14zu %10.3f %10.2f\n", variants[v].name, view.frame_count,
+               view.interpolated_frames, bytes, build * 1000.0 / iterations,
+               synth * 1000.0 / iterations);
+        world_frame_view_free(&view);
+        world_analysis_data_free(&copy);
+    }
+
+    world_analysis_data_free(&source);
+    free(x);
+    free(y);
+    return EXIT_SUCCESS;
+}
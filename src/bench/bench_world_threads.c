@@ -0,0 +1,79 @@
+/**
+ * @file bench_world_threads.c
+ * @brief Scaling of world_analyze() over 1, 2, 4, 8 and 16 threads
+ *
+ * Usage: bench_world_threads [seconds] [iterations]
+ *
+ * Reports wall time, speed-up over one thread, and the largest absolute
+ * difference of sp/ap against the single-threaded result.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "bench/bench_common.h"
+
+static double max_abs_diff(double** a, double** b, int frames, int bins) {
+    double worst = 0.0;
+    for (int i = 0; i < frames; i++) {
+        for (int j = 0; j < bins; j++) {
+            double d = fabs(a[i][j] - b[i][j]);
+            if (d > worst) worst = d;
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 3;
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    if (x_length <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * x_length);
+    if (!x) return EXIT_FAILURE;
+    bench_make_signal(x, x_length, fs, 220.0);
+
+    WorldAnalysisOptions options;
+    world_analysis_options_init(&options);
+
+    WorldAnalysisData reference;
+    world_analysis_data_init(&reference);
+    if (world_analyze(x, x_length, fs, &options, &reference) != 0) {
+        fprintf(stderr, "analysis failed\n");
+        return EXIT_FAILURE;
+    }
+    int bins = reference.fft_size / 2 + 1;
+
+    printf("%8s %12s %9s %12s %12s\n", "threads", "analyze_ms", "speedup", "max|dsp|", "max|dap|");
+
+    const int thread_counts[] = { 1, 2, 4, 8, 16 };
+    double base_ms = 0.0;
+    for (size_t k = 0; k < sizeof(thread_counts) / sizeof(thread_counts[0]); k++) {
+        double total = 0.0;
+        double dsp = 0.0, dap = 0.0;
+        for (int it = 0; it < iterations; it++) {
+            WorldAnalysisData data;
+            world_analysis_data_init(&data);
+            options.num_threads = thread_counts[k];
+            double t0 = bench_now_sec();
+            if (world_analyze(x, x_length, fs, &options, &data) != 0) {
+                fprintf(stderr, "analysis failed\n");
+                return EXIT_FAILURE;
+            }
+            total += bench_now_sec() - t0;
+            dsp = max_abs_diff(reference.spectrogram, data.spectrogram, data.f0_length, bins);
+            dap = max_abs_diff(reference.aperiodicity, data.aperiodicity, data.f0_length, bins);
+            world_analysis_data_free(&data);
+        }
+        double ms = total * 1000.0 / iterations;
+        if (k == 0) base_ms = ms;
+        printf("%8d %12.2f %8.2fx %12.3g %12.3g\n", thread_counts[k], ms, base_ms / ms, dsp, dap);
+    }
+
+    world_analysis_data_free(&reference);
+    free(x);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file bench_worldcache_compress.c
+ * @brief Cache compression modes: ratio, write and decode throughput
+ *
+ * Usage: bench_worldcache_compress [samples] [seconds] [iterations]
+ *
+ * Analyzes `samples` voice-like signals of `seconds` each (a stand-in for a
+ * voicebank), trains a dictionary on the even-numbered ones and writes the
+ * odd-numbered ones as .worldcache files in every mode: plain, zstd at
+ * several levels, and zstd with the dictionary. Reports the compression
+ * ratio of the payload, write MB/s and full-load decode MB/s (raw payload
+ * bytes per second of worldcache_read_frames).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "worldcache/worldcache_analysis.h"
+#include "worldcache/worldcache_dict.h"
+#include "bench/bench_common.h"
+
+typedef struct {
+    const char* name;
+    int compressed;
+    int level;
+    int dict;
+} Mode;
+
+static void cache_path(char* out, size_t size, int i) {
+    snprintf(out, size, "bench_worldcache_compress_%d.worldcache", i);
+}
+
+/* Write sample i in mode m; returns the file size or 0 on failure */
+static size_t write_cache(const WorldAnalysisData* data, int i, const Mode* m, const WorldCacheDict* dict) {
+    char path[64];
+    cache_path(path, sizeof(path), i);
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_header_from_analysis(&h, data) != 0) return 0;
+    if (m->compressed) h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+    WorldCacheCompression opts = { m->level, m->dict ? dict : NULL };
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    int result = worldcache_write_analysis_ex(f, &h, data, &opts);
+    long size = ftell(f);
+    if (fclose(f) != 0 || result != 0 || size <= 0) return 0;
+    return (size_t)size;
+}
+
+int main(int argc, char** argv) {
+    int samples = argc > 1 ? atoi(argv[1]) : 24;
+    double seconds = argc > 2 ? atof(argv[2]) : 0.5;
+    int iterations = argc > 3 ? atoi(argv[3]) : 5;
+    if (samples < 2 || seconds <= 0.0 || iterations <= 0) return EXIT_FAILURE;
+
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    double* x = (double*)malloc(sizeof(double) * (size_t)x_length);
+    WorldAnalysisData* data = (WorldAnalysisData*)calloc((size_t)samples, sizeof(WorldAnalysisData));
+    if (!x || !data) return EXIT_FAILURE;
+    WorldAnalysisOptions options;
+    world_analysis_options_init(&options);
+    for (int i = 0; i < samples; i++) {
+        world_analysis_data_init(&data[i]);
+        bench_make_signal(x, x_length, fs, 140.0 + 260.0 * i / samples);
+        if (world_analyze(x, x_length, fs, &options, &data[i]) != 0) return EXIT_FAILURE;
+    }
+    free(x);
+
+    /* dictionary from the even samples; the odd ones are measured */
+    const WorldCacheDict* dict = NULL;
+    WorldCacheDictTrainer* t = worldcache_dict_trainer_create(0);
+    for (int i = 0; t && i < samples; i += 2) {
+        WorldCacheHeader_t h;
+        worldcache_header_init(&h);
+        if (worldcache_header_from_analysis(&h, &data[i]) != 0 || worldcache_dict_trainer_add(t, &h, &data[i]) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    void* dict_bytes = NULL;
+    size_t dict_size = 0;
+    double t0 = bench_now_sec();
+    if (worldcache_dict_trainer_finish(t, WORLDCACHE_DICT_CAPACITY, &dict_bytes, &dict_size) == 0) {
+        dict = worldcache_dict_register(dict_bytes, dict_size);
+    }
+    double train_time = bench_now_sec() - t0;
+    worldcache_dict_trainer_destroy(t);
+    free(dict_bytes);
+
+    size_t raw = 0;
+    for (int i = 1; i < samples; i += 2) {
+        WorldCacheHeader_t h;
+        worldcache_header_init(&h);
+        worldcache_header_from_analysis(&h, &data[i]);
+        raw += (size_t)h.sp_size + h.ap_size + h.voiced_mask_size;
+    }
+    printf("%d samples of %.2f s, %.1f MB of payload measured\n", samples / 2, seconds, raw / 1048576.0);
+    if (dict) printf("dictionary: %zu bytes, trained in %.2f s\n", dict_size, train_time);
+
+    const Mode modes[] = {
+        { "plain", 0, 0, 0 },   { "zstd-1", 1, 1, 0 },      { "zstd-3", 1, 3, 0 },
+        { "zstd-9", 1, 9, 0 },  { "zstd-19", 1, 19, 0 },    { "dict+zstd-1", 1, 1, 1 },
+        { "dict+zstd-3", 1, 3, 1 }, { "dict+zstd-9", 1, 9, 1 },
+    };
+    printf("%-12s %8s %12s %12s\n", "mode", "ratio", "write MB/s", "decode MB/s");
+    WorldAnalysisData loaded;
+    world_analysis_data_init(&loaded);
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        if (modes[m].dict && !dict) {
+            printf("%-12s (no dictionary: built without zstd)\n", modes[m].name);
+            continue;
+        }
+        size_t stored = 0;
+        int ok = 1;
+        t0 = bench_now_sec();
+        for (int i = 1; ok && i < samples; i += 2) {
+            size_t size = write_cache(&data[i], i, &modes[m], dict);
+            ok = size > 0;
+            stored += size;
+        }
+        double write_time = bench_now_sec() - t0;
+        if (!ok) {
+            printf("%-12s (unavailable without zstd)\n", modes[m].name);
+            continue;
+        }
+
+        t0 = bench_now_sec();
+        for (int it = 0; ok && it < iterations; it++) {
+            for (int i = 1; ok && i < samples; i += 2) {
+                char path[64];
+                cache_path(path, sizeof(path), i);
+                ok = worldcache_read_frames(path, 0, data[i].f0_length, &loaded, NULL) == 0;
+            }
+        }
+        double read_time = (bench_now_sec() - t0) / iterations;
+        if (!ok) {
+            fprintf(stderr, "%s: read failed\n", modes[m].name);
+            return EXIT_FAILURE;
+        }
+        printf("%-12s %8.2f %12.1f %12.1f\n", modes[m].name, (double)raw / (double)stored,
+               raw / 1048576.0 / write_time, raw / 1048576.0 / read_time);
+    }
+
+    for (int i = 0; i < samples; i++) {
+        char path[64];
+        cache_path(path, sizeof(path), i);
+        remove(path);
+        world_analysis_data_free(&data[i]);
+    }
+    world_analysis_data_free(&loaded);
+    free(data);
+    worldcache_dict_clear();
+    return EXIT_SUCCESS;
+}
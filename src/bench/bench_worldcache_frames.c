@@ -0,0 +1,85 @@
+/**
+ * @file bench_worldcache_frames.c
+ * @brief Note-sized range reads vs full loads of long cached samples
+ *
+ * Usage: bench_worldcache_frames [seconds] [frames] [iterations]
+ *
+ * Writes a `seconds`-long analysis as a plain and (with zstd) a chunked
+ * compressed .worldcache, then times worldcache_read_frames for a full load
+ * and for `frames`-frame slices at spread-out offsets, reporting the time and
+ * payload bytes read per load.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "worldcache/worldcache_analysis.h"
+#include "bench/bench_common.h"
+
+static const char* kCache = "bench_worldcache_frames.worldcache";
+
+static int write_cache(const WorldAnalysisData* data, int compressed) {
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_header_from_analysis(&h, data) != 0) return -1;
+    if (compressed) h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+    FILE* f = fopen(kCache, "wb");
+    if (!f) return -1;
+    int result = worldcache_write_analysis(f, &h, data);
+    return fclose(f) == 0 ? result : -1;
+}
+
+/* Mean seconds per read of `count` frames, cycling the start through the sample */
+static double time_reads(int total, int count, int iterations, size_t* bytes) {
+    WorldAnalysisData d;
+    world_analysis_data_init(&d);
+    WorldCacheLoadInfo info;
+    *bytes = 0;
+    double t0 = bench_now_sec();
+    for (int i = 0; i < iterations; i++) {
+        int first = count < total ? (int)((unsigned)i * 7919u % (unsigned)(total - count)) : 0;
+        if (worldcache_read_frames(kCache, first, count, &d, &info) != 0) {
+            world_analysis_data_free(&d);
+            return -1.0;
+        }
+        *bytes += info.bytes_read;
+    }
+    double t = (bench_now_sec() - t0) / iterations;
+    *bytes /= (size_t)iterations;
+    world_analysis_data_free(&d);
+    return t;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10.0;
+    int frames = argc > 2 ? atoi(argv[2]) : 60;
+    int iterations = argc > 3 ? atoi(argv[3]) : 50;
+    if (seconds <= 0.0 || frames <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    WorldAnalysisData src;
+    world_analysis_data_init(&src);
+    if (world_generate_dummy_data(&src, seconds, 44100, 5.0, 200.0) != 0) return EXIT_FAILURE;
+
+    printf("%.1f s sample, %d frames, %d-frame slices\n", seconds, src.f0_length, frames);
+    printf("%-12s %-6s %12s %12s\n", "payload", "read", "us/load", "KB read");
+    for (int compressed = 0; compressed < 2; compressed++) {
+        const char* label = compressed ? "compressed" : "plain";
+        if (write_cache(&src, compressed) != 0) {
+            printf("%-12s (unavailable without zstd)\n", label);
+            continue;
+        }
+        size_t full_bytes = 0, part_bytes = 0;
+        double full = time_reads(src.f0_length, src.f0_length, iterations, &full_bytes);
+        double part = time_reads(src.f0_length, frames, iterations, &part_bytes);
+        if (full < 0.0 || part < 0.0) {
+            fprintf(stderr, "read failed\n");
+            return EXIT_FAILURE;
+        }
+        printf("%-12s %-6s %12.1f %12.1f\n", label, "full", full * 1e6, full_bytes / 1024.0);
+        printf("%-12s %-6s %12.1f %12.1f  (%.1fx)\n", label, "slice", part * 1e6, part_bytes / 1024.0,
+               full / part);
+    }
+
+    remove(kCache);
+    world_analysis_data_free(&src);
+    return EXIT_SUCCESS;
+}
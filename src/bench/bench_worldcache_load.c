@@ -0,0 +1,129 @@
+/**
+ * @file bench_worldcache_load.c
+ * @brief Cache hit latency: memory-mapped vs fread loading
+ *
+ * Usage: bench_worldcache_load [seconds] [iterations]
+ *
+ * Writes an uncompressed cache for a `seconds`-long analysis, then times a
+ * full per-note load the way the resampler does it (open, header, payload,
+ * fresh WorldAnalysisData) through both paths. "load" is the call itself;
+ * "load+touch" also reads every sp/ap value once, as synthesis would, which
+ * is where a mapping pays for its page faults. Cold runs evict the file from
+ * the page cache first (POSIX_FADV_DONTNEED; skipped where unavailable).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "worldcache/worldcache_analysis.h"
+#include "bench/bench_common.h"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char* kCache = "bench_worldcache_load.worldcache";
+
+// Drop the cache file's pages from the page cache; returns 0 if supported
+static int evict_page_cache(void) {
+#if defined(POSIX_FADV_DONTNEED)
+    int fd = open(kCache, O_RDONLY);
+    if (fd < 0) return -1;
+    fdatasync(fd);
+    int result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return result == 0 ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+static int load_fread(WorldAnalysisData* data) {
+    FILE* f = fopen(kCache, "rb");
+    if (!f) return -1;
+    WorldCacheHeader_t h;
+    int result = worldcache_header_read(f, &h) == 0 ? worldcache_read_analysis(f, &h, data, NULL) : -1;
+    fclose(f);
+    return result;
+}
+
+static int load_mmap(WorldAnalysisData* data) {
+    WorldCacheMapping* m = NULL;
+    if (worldcache_mapping_open(kCache, &m) != 0) return -1;
+    int result = worldcache_attach_analysis(m, data, NULL);
+    worldcache_mapping_release(m);
+    return result;
+}
+
+static double touch(const WorldAnalysisData* data) {
+    int bins = data->fft_size / 2 + 1;
+    double sum = 0.0;
+    for (int i = 0; i < data->f0_length; i++) {
+        for (int k = 0; k < bins; k++) sum += data->spectrogram[i][k] + data->aperiodicity[i][k];
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    if (x_length <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * x_length);
+    if (!x) return EXIT_FAILURE;
+    bench_make_signal(x, x_length, fs, 220.0);
+
+    WorldAnalysisData source;
+    world_analysis_data_init(&source);
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    FILE* f = NULL;
+    if (world_analyze(x, x_length, fs, NULL, &source) != 0 ||
+        worldcache_header_from_analysis(&h, &source) != 0 || !(f = fopen(kCache, "wb")) ||
+        worldcache_write_analysis(f, &h, &source) != 0 || fclose(f) != 0) {
+        fprintf(stderr, "cache setup failed\n");
+        return EXIT_FAILURE;
+    }
+    size_t payload = (size_t)h.sp_size + h.ap_size + h.voiced_mask_size;
+    printf("cache: %d frames, %zu payload bytes\n", source.f0_length, payload);
+    printf("%-6s %-5s %10s %14s\n", "path", "cache", "load_ms", "load+touch_ms");
+
+    int (*const loaders[])(WorldAnalysisData*) = { load_fread, load_mmap };
+    const char* names[] = { "fread", "mmap" };
+    volatile double sink = 0.0;
+    for (int cold = 0; cold <= 1; cold++) {
+        if (cold && evict_page_cache() != 0) {
+            printf("cold runs skipped: page cache eviction unsupported\n");
+            break;
+        }
+        for (int l = 0; l < 2; l++) {
+            double load = 0.0, total = 0.0;
+            for (int it = 0; it < iterations; it++) {
+                if (cold) evict_page_cache();
+                WorldAnalysisData data;
+                world_analysis_data_init(&data);
+                double t0 = bench_now_sec();
+                if (loaders[l](&data) != 0) {
+                    fprintf(stderr, "%s load failed\n", names[l]);
+                    return EXIT_FAILURE;
+                }
+                double t1 = bench_now_sec();
+                sink += touch(&data);
+                double t2 = bench_now_sec();
+                world_analysis_data_free(&data);
+                load += t1 - t0;
+                total += t2 - t0;
+            }
+            printf("%-6s %-5s %10.3f %14.3f\n", names[l], cold ? "cold" : "warm",
+                   load * 1000.0 / iterations, total * 1000.0 / iterations);
+        }
+    }
+
+    remove(kCache);
+    world_analysis_data_free(&source);
+    free(x);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file bench_worldcache_lru.c
+ * @brief Per-note analysis lookup: manager (disk) vs in-process LRU
+ *
+ * Usage: bench_worldcache_lru [samples] [notes]
+ *
+ * Writes `samples` short WAVs, warms their .worldcache sidecars, then looks
+ * up `notes` analyses with a song-like reuse pattern (a few vowels used over
+ * and over) through worldcache_get_analysis and through a WorldCacheLru, and
+ * reports the time per lookup and the LRU hit rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "worldcache/worldcache_manager.h"
+#include "worldcache/worldcache_lru.h"
+#include "bench/bench_common.h"
+
+static int write_wav(const char* path, const double* x, int n, int fs) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    uint32_t data_size = (uint32_t)n * 2, byte_rate = (uint32_t)fs * 2, fmt_size = 16, riff = 36 + data_size;
+    uint16_t pcm = 1, channels = 1, align = 2, bits = 16;
+    uint32_t rate = (uint32_t)fs;
+    fwrite("RIFF", 1, 4, f); fwrite(&riff, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f); fwrite(&pcm, 2, 1, f); fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f); fwrite(&byte_rate, 4, 1, f); fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f); fwrite(&data_size, 4, 1, f);
+    for (int i = 0; i < n; i++) {
+        int16_t v = (int16_t)(x[i] * 16000.0);
+        fwrite(&v, 2, 1, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/* Note i of the song: half the notes hit the first two samples */
+static int note_sample(int i, int samples) {
+    unsigned h = (unsigned)i * 2654435761u;
+    return (h >> 16) % 2 ? (int)((h >> 8) % 2) : (int)((h >> 4) % (unsigned)samples);
+}
+
+int main(int argc, char** argv) {
+    int samples = argc > 1 ? atoi(argv[1]) : 16;
+    int notes = argc > 2 ? atoi(argv[2]) : 400;
+    const int fs = 44100, n = fs / 2;
+    if (samples <= 0 || notes <= 0 || samples > 1000) return EXIT_FAILURE;
+
+    char (*paths)[64] = malloc(sizeof(*paths) * (size_t)samples);
+    double* x = (double*)malloc(sizeof(double) * n);
+    if (!paths || !x) return EXIT_FAILURE;
+    for (int s = 0; s < samples; s++) {
+        snprintf(paths[s], sizeof(paths[s]), "bench_worldcache_lru_%03d.wav", s);
+        bench_make_signal(x, n, fs, 150.0 + 10.0 * s);
+        WorldAnalysisData d;
+        world_analysis_data_init(&d);
+        if (write_wav(paths[s], x, n, fs) != 0 || worldcache_get_analysis(paths[s], &d) != 0) {
+            fprintf(stderr, "setup failed\n");
+            return EXIT_FAILURE;
+        }
+        world_analysis_data_free(&d);
+    }
+
+    volatile double sink = 0.0;
+    double t0 = bench_now_sec();
+    for (int i = 0; i < notes; i++) {
+        WorldAnalysisData d;
+        world_analysis_data_init(&d);
+        if (worldcache_get_analysis(paths[note_sample(i, samples)], &d) != 0) return EXIT_FAILURE;
+        sink += d.f0[d.f0_length / 2];
+        world_analysis_data_free(&d);
+    }
+    double manager = (bench_now_sec() - t0) / notes;
+
+    WorldCacheLru* lru = NULL;
+    if (worldcache_lru_create((size_t)256 << 20, &lru) != 0) return EXIT_FAILURE;
+    t0 = bench_now_sec();
+    for (int i = 0; i < notes; i++) {
+        WorldCacheHandle* h = NULL;
+        if (worldcache_lru_acquire(lru, paths[note_sample(i, samples)], &h) != 0) return EXIT_FAILURE;
+        const WorldAnalysisData* d = worldcache_handle_data(h);
+        sink += d->f0[d->f0_length / 2];
+        worldcache_lru_release(h);
+    }
+    double cached = (bench_now_sec() - t0) / notes;
+    WorldCacheLruStats st;
+    worldcache_lru_stats(lru, &st);
+    worldcache_lru_destroy(lru);
+
+    printf("%d samples, %d notes\n", samples, notes);
+    printf("%-8s %12s\n", "path", "us/lookup");
+    printf("%-8s %12.1f\n", "manager", manager * 1e6);
+    printf("%-8s %12.1f  (%llu hits, %llu misses, %.1f MB resident)\n", "lru", cached * 1e6,
+           (unsigned long long)st.hits, (unsigned long long)st.misses, st.bytes / 1e6);
+
+    for (int s = 0; s < samples; s++) {
+        char sidecar[96];
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", paths[s]);
+        remove(sidecar);
+        remove(paths[s]);
+    }
+    free(paths);
+    free(x);
+    return EXIT_SUCCESS;
+}
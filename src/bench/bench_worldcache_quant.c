@@ -0,0 +1,168 @@
+/**
+ * @file bench_worldcache_quant.c
+ * @brief Cache representations: size versus decode speed
+ *
+ * Usage: bench_worldcache_quant [samples] [seconds] [iterations]
+ *
+ * Analyzes `samples` voice-like signals of `seconds` each and writes them
+ * as .worldcache files with double, float32 and quantized sp/ap, plain and
+ * zstd-compressed. Reports the size relative to the plain double cache, the
+ * quality of the quantized round trip (MCD/SNR against the PRD thresholds)
+ * and full-load decode throughput as MB/s of double sp+ap delivered. The
+ * quantized decode kernels are also timed on their own for every ISA the
+ * CPU supports.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "worldcache/worldcache_analysis.h"
+#include "worldcache/worldcache_quant.h"
+#include "world_quality.h"
+#include "bench/bench_common.h"
+
+typedef struct {
+    const char* name;
+    WorldPrecision precision;
+    int quantized;
+    int compressed;
+} Mode;
+
+static void cache_path(char* out, size_t size, int i) {
+    snprintf(out, size, "bench_worldcache_quant_%d.worldcache", i);
+}
+
+/* Write sample i in mode m; returns the file size or 0 on failure */
+static size_t write_cache(const WorldAnalysisData* data, int i, const Mode* m) {
+    char path[64];
+    cache_path(path, sizeof(path), i);
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (m->quantized) h.flags |= WORLDCACHE_FLAG_QUANTIZED;
+    if (worldcache_header_from_analysis(&h, data) != 0) return 0;
+    if (m->compressed) h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    int result = worldcache_write_analysis(f, &h, data);
+    long size = ftell(f);
+    if (fclose(f) != 0 || result != 0 || size <= 0) return 0;
+    return (size_t)size;
+}
+
+int main(int argc, char** argv) {
+    int samples = argc > 1 ? atoi(argv[1]) : 8;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    int iterations = argc > 3 ? atoi(argv[3]) : 5;
+    if (samples < 1 || seconds <= 0.0 || iterations <= 0) return EXIT_FAILURE;
+
+    const int fs = 44100;
+    int x_length = (int)(seconds * fs);
+    double* x = (double*)malloc(sizeof(double) * (size_t)x_length);
+    WorldAnalysisData* data = (WorldAnalysisData*)calloc((size_t)samples, sizeof(WorldAnalysisData));
+    WorldAnalysisData* data_f32 = (WorldAnalysisData*)calloc((size_t)samples, sizeof(WorldAnalysisData));
+    if (!x || !data || !data_f32) return EXIT_FAILURE;
+    WorldAnalysisOptions options;
+    world_analysis_options_init(&options);
+    size_t raw = 0;
+    double mcd = 0.0, snr = 1e9;
+    int passed = 1;
+    for (int i = 0; i < samples; i++) {
+        world_analysis_data_init(&data[i]);
+        world_analysis_data_init(&data_f32[i]);
+        bench_make_signal(x, x_length, fs, 140.0 + 260.0 * i / samples);
+        if (world_analyze(x, x_length, fs, &options, &data[i]) != 0) return EXIT_FAILURE;
+        /* float32 copies analyze the same signal */
+        data_f32[i].precision = WORLD_PRECISION_FLOAT32;
+        if (world_analyze(x, x_length, fs, &options, &data_f32[i]) != 0 ||
+            data_f32[i].precision != WORLD_PRECISION_FLOAT32) {
+            return EXIT_FAILURE;
+        }
+        raw += 2 * (size_t)data[i].f0_length * (size_t)(data[i].fft_size / 2 + 1) * sizeof(double);
+
+        WorldCacheQuantQuality q;
+        if (worldcache_quant_check(&data[i], &q) != 0) return EXIT_FAILURE;
+        if (q.mcd_db > mcd) mcd = q.mcd_db;
+        if (q.snr_db < snr) snr = q.snr_db;
+        passed = passed && q.passed;
+    }
+    free(x);
+    printf("%d samples of %.2f s, %.1f MB of double sp+ap\n", samples, seconds, raw / 1048576.0);
+    printf("quantized round trip: worst MCD %.4f dB (max %.1f), worst SNR %.2f dB (min %.1f): %s\n", mcd,
+           WORLD_QUALITY_MAX_MCD_DB, snr, WORLD_QUALITY_MIN_SNR_DB, passed ? "pass" : "FAIL");
+
+    const Mode modes[] = {
+        { "double", WORLD_PRECISION_DOUBLE, 0, 0 },   { "double+zstd", WORLD_PRECISION_DOUBLE, 0, 1 },
+        { "float32", WORLD_PRECISION_FLOAT32, 0, 0 }, { "float32+zstd", WORLD_PRECISION_FLOAT32, 0, 1 },
+        { "quant", WORLD_PRECISION_DOUBLE, 1, 0 },    { "quant+zstd", WORLD_PRECISION_DOUBLE, 1, 1 },
+    };
+    printf("%-14s %10s %8s %12s\n", "mode", "bytes", "ratio", "decode MB/s");
+    WorldAnalysisData loaded;
+    world_analysis_data_init(&loaded);
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        const WorldAnalysisData* src = modes[m].precision == WORLD_PRECISION_FLOAT32 ? data_f32 : data;
+        size_t stored = 0;
+        int ok = 1;
+        for (int i = 0; ok && i < samples; i++) {
+            size_t size = write_cache(&src[i], i, &modes[m]);
+            ok = size > 0;
+            stored += size;
+        }
+        if (!ok) {
+            printf("%-14s (unavailable without zstd)\n", modes[m].name);
+            continue;
+        }
+        double t0 = bench_now_sec();
+        for (int it = 0; ok && it < iterations; it++) {
+            for (int i = 0; ok && i < samples; i++) {
+                char path[64];
+                cache_path(path, sizeof(path), i);
+                ok = worldcache_read_frames(path, 0, src[i].f0_length, &loaded, NULL) == 0;
+            }
+        }
+        double read_time = (bench_now_sec() - t0) / iterations;
+        if (!ok) {
+            fprintf(stderr, "%s: read failed\n", modes[m].name);
+            return EXIT_FAILURE;
+        }
+        printf("%-14s %10zu %8.2f %12.1f\n", modes[m].name, stored, (double)raw / (double)stored,
+               raw / 1048576.0 / read_time);
+    }
+
+    /* decode kernels alone, from rows already in memory */
+    uint32_t bins = (uint32_t)(data[0].fft_size / 2 + 1);
+    uint8_t *sp = NULL, *ap = NULL;
+    float* rows = (float*)malloc(sizeof(float) * bins * 3);
+    if (!rows || worldcache_quant_encode_analysis(&data[0], &sp, &ap) != 0) return EXIT_FAILURE;
+    size_t sp_row = worldcache_quant_sp_row_bytes(bins);
+    int frames = data[0].f0_length;
+    int repeats = 50 * iterations;
+    for (int isa = WORLD_FLAGS_ISA_SCALAR; isa <= (int)world_flags_detect_isa(); isa++) {
+        double t0 = bench_now_sec();
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < frames; i++) {
+                worldcache_quant_decode_sp(sp + (size_t)i * sp_row, bins, (uint32_t)i, rows + 2 * bins, rows,
+                                           (WorldFlagsIsa)isa);
+                worldcache_quant_decode_ap(ap + (size_t)i * bins, bins, rows + bins, (WorldFlagsIsa)isa);
+            }
+        }
+        double elapsed = bench_now_sec() - t0;
+        double out_bytes = 2.0 * frames * bins * sizeof(float) * repeats;
+        printf("kernel %-7s %10.1f MB/s of float32 sp+ap (%.0f frames/s)\n",
+               world_flags_isa_name((WorldFlagsIsa)isa), out_bytes / 1048576.0 / elapsed,
+               (double)frames * repeats / elapsed);
+    }
+    free(sp);
+    free(ap);
+    free(rows);
+
+    for (int i = 0; i < samples; i++) {
+        char path[64];
+        cache_path(path, sizeof(path), i);
+        remove(path);
+        world_analysis_data_free(&data[i]);
+        world_analysis_data_free(&data_f32[i]);
+    }
+    world_analysis_data_free(&loaded);
+    free(data);
+    free(data_f32);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file bench_worldcache_validate.c
+ * @brief Cache validation cost per lookup: legacy byte-wise hash vs tiered check
+ *
+ * Usage: bench_worldcache_validate [seconds] [iterations]
+ *
+ * Writes a `seconds`-long 16-bit mono WAV-sized file and times one cache
+ * validation the way the manager does it per note:
+ *  - legacy:  stat() mtime + FNV-1a over fgetc() (the previous manager code)
+ *  - rehash:  worldcache_hash_file, the tier taken after a touch or copy
+ *  - fast:    worldcache_source_check with matching identity (stat only)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "worldcache/worldcache_source.h"
+#include "bench/bench_common.h"
+
+static const char* kWav = "bench_worldcache_validate.wav";
+
+static int validate_legacy(WorldCacheHeader_t* h) {
+    struct stat st;
+    if (stat(kWav, &st) != 0) return 0;
+    FILE* f = fopen(kWav, "rb");
+    if (!f) return 0;
+    uint64_t hash = 1469598103934665603ULL;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        hash ^= (uint64_t)c;
+        hash *= 1099511628211ULL;
+    }
+    fclose(f);
+    return (uint64_t)st.st_mtime == h->wav_mtime && hash == h->wav_hash;
+}
+
+static int validate_rehash(WorldCacheHeader_t* h) {
+    uint64_t hash;
+    return worldcache_hash_file(kWav, &hash) == 0 && hash == h->wav_hash;
+}
+
+static int validate_fast(WorldCacheHeader_t* h) {
+    return worldcache_source_check(h, kWav) == WORLDCACHE_SOURCE_CURRENT;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10.0;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    const int fs = 44100;
+    int n = (int)(seconds * fs);
+    if (n <= 0 || iterations <= 0) return EXIT_FAILURE;
+
+    double* x = (double*)malloc(sizeof(double) * n);
+    FILE* f = fopen(kWav, "wb");
+    if (!x || !f) return EXIT_FAILURE;
+    bench_make_signal(x, n, fs, 220.0);
+    for (int i = 0; i < n; i++) {
+        short v = (short)(x[i] * 16000.0);
+        fwrite(&v, sizeof(v), 1, f);
+    }
+    fclose(f);
+    free(x);
+
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_source_stamp(&h, kWav) != 0) {
+        fprintf(stderr, "stamp failed\n");
+        return EXIT_FAILURE;
+    }
+    printf("source: %.1f s, %llu bytes\n", seconds, (unsigned long long)h.wav_size);
+    printf("%-8s %12s %10s\n", "path", "us/lookup", "MB/s");
+
+    int (*const checks[])(WorldCacheHeader_t*) = { validate_legacy, validate_rehash, validate_fast };
+    const char* names[] = { "legacy", "rehash", "fast" };
+    volatile int sink = 0;
+    for (int c = 0; c < 3; c++) {
+        double t0 = bench_now_sec();
+        for (int it = 0; it < iterations; it++) sink += checks[c](&h);
+        double per = (bench_now_sec() - t0) / iterations;
+        printf("%-8s %12.2f %10.1f\n", names[c], per * 1e6, (double)h.wav_size / per / 1e6);
+    }
+
+    remove(kWav);
+    return sink >= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file bench_worldcache_writer.c
+ * @brief First-render latency on cache misses with and without write-back
+ *
+ * Usage: bench_worldcache_writer [samples] [seconds] [zstd_level]
+ *
+ * Writes `samples` WAVs of `seconds` each and renders each of them once from
+ * a cold cache (no sidecars): worldcache_get_analysis followed by
+ * world_synthesize, as a resampler's first note from a sample does. Reports
+ * mean and worst latency until the analysis is available and until the note
+ * is rendered, with synchronous sidecar writes and with write-back, plus the
+ * time the final flush of the write-back queue takes. zstd_level sets
+ * worldcache_set_compression_level (compressed builds only).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "worldcache/worldcache_manager.h"
+#include "worldcache/worldcache_serialize.h"
+#include "worldcache/worldcache_writer.h"
+#include "bench/bench_common.h"
+
+static int write_wav(const char* path, const double* x, int n, int fs) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    uint32_t data_size = (uint32_t)n * 2, byte_rate = (uint32_t)fs * 2, fmt_size = 16, riff = 36 + data_size;
+    uint16_t pcm = 1, channels = 1, align = 2, bits = 16;
+    uint32_t rate = (uint32_t)fs;
+    fwrite("RIFF", 1, 4, f); fwrite(&riff, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f); fwrite(&pcm, 2, 1, f); fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f); fwrite(&byte_rate, 4, 1, f); fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f); fwrite(&data_size, 4, 1, f);
+    for (int i = 0; i < n; i++) {
+        int16_t v = (int16_t)(x[i] * 16000.0);
+        fwrite(&v, 2, 1, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void remove_sidecars(char (*paths)[64], int samples) {
+    char sidecar[96];
+    for (int s = 0; s < samples; s++) {
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", paths[s]);
+        remove(sidecar);
+    }
+}
+
+/* Render every sample once from a cold cache; returns 0 on success */
+static int run(char (*paths)[64], int samples, const char* label) {
+    remove_sidecars(paths, samples);
+    double ready_sum = 0.0, ready_max = 0.0, render_sum = 0.0, render_max = 0.0;
+    double t_all = bench_now_sec();
+    for (int s = 0; s < samples; s++) {
+        WorldAnalysisData d;
+        world_analysis_data_init(&d);
+        double t0 = bench_now_sec();
+        if (worldcache_get_analysis(paths[s], &d) != 0) return -1;
+        double ready = bench_now_sec() - t0;
+        double* y = (double*)malloc(sizeof(double) * (size_t)d.x_length);
+        if (!y || world_synthesize(&d, y, d.x_length) != 0) return -1;
+        double render = bench_now_sec() - t0;
+        free(y);
+        world_analysis_data_free(&d);
+        ready_sum += ready;
+        render_sum += render;
+        if (ready > ready_max) ready_max = ready;
+        if (render > render_max) render_max = render;
+    }
+    double t_flush = bench_now_sec();
+    if (worldcache_flush_writes() != 0) return -1;
+    double flush = bench_now_sec() - t_flush;
+    printf("%-11s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", label, ready_sum / samples * 1e3, ready_max * 1e3,
+           render_sum / samples * 1e3, render_max * 1e3, flush * 1e3, (bench_now_sec() - t_all) * 1e3);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int samples = argc > 1 ? atoi(argv[1]) : 16;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.5;
+    if (argc > 3) worldcache_set_compression_level(atoi(argv[3]));
+    const int fs = 44100;
+    int n = (int)(seconds * fs);
+    if (samples <= 0 || samples > 1000 || n <= 0) return EXIT_FAILURE;
+
+    char (*paths)[64] = malloc(sizeof(*paths) * (size_t)samples);
+    double* x = (double*)malloc(sizeof(double) * (size_t)n);
+    if (!paths || !x) return EXIT_FAILURE;
+    for (int s = 0; s < samples; s++) {
+        snprintf(paths[s], sizeof(paths[s]), "bench_worldcache_writer_%03d.wav", s);
+        bench_make_signal(x, n, fs, 150.0 + 10.0 * s);
+        if (write_wav(paths[s], x, n, fs) != 0) return EXIT_FAILURE;
+    }
+    free(x);
+
+    printf("%d cold samples of %.2f s, zstd level %d (ms)\n", samples, seconds, worldcache_compression_level());
+    printf("%-11s %9s %9s %9s %9s %9s %9s\n", "mode", "ready", "max", "render", "max", "flush", "total");
+    int failed = run(paths, samples, "sync") != 0;
+    failed = failed || worldcache_set_write_back((size_t)256 << 20) != 0 || run(paths, samples, "write-back") != 0;
+    worldcache_set_write_back(0);
+
+    WorldCacheWriterStats stats;
+    worldcache_writer_stats(&stats);
+    printf("write-back: %llu queued, %llu inline\n", (unsigned long long)stats.queued,
+           (unsigned long long)stats.inline_writes);
+
+    remove_sidecars(paths, samples);
+    for (int s = 0; s < samples; s++) remove(paths[s]);
+    free(paths);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,325 +1,290 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <getopt.h>
-#include <math.h>
-#include <errno.h>
 
-// Include UCRA headers
-#include "ucra/ucra.h"
-
-// Include our WORLD wrapper
-#include "world_wrapper.h"
-
-// Function to initialize UCRA_RenderConfig with default values
-void init_render_config(UCRA_RenderConfig* config) {
-    memset(config, 0, sizeof(UCRA_RenderConfig));
-
-    // Set default values for basic fields
-    config->sample_rate = 44100;
-    config->channels = 1;
-    config->block_size = 512;
-    config->flags = 0;
-    config->notes = NULL;
-    config->note_count = 0;
-    config->options = NULL;
-    config->option_count = 0;
-
-    // Set default values for UTAU CLI arguments
-    config->in_file_path = NULL;
-    config->out_file_path = NULL;
-    config->pitch = 0.0;           // cents
-    config->velocity = 100.0;      // default velocity
-    config->offset = 0.0;          // milliseconds
-    config->length = 0.0;          // milliseconds
-    config->consonant = 0.0;       // milliseconds
-    config->cutoff = 0.0;          // milliseconds
-    config->volume = 1.0;          // 0.0-1.0
-    config->modulation = 0.0;      // modulation amount
-    config->tempo = 120.0;         // BPM
-    config->pitch_string = NULL;   // pitch string
-}
-
-// Function to display help message
-void print_help(const char* program_name) {
-    printf("Usage: %s [OPTIONS] <input_file> <output_file>\n\n", program_name);
-    printf("UTAU-compatible voice synthesizer using UCRA and WORLD libraries.\n\n");
-
-    printf("Required Arguments:\n");
-    printf("  <input_file>              Input audio file path\n");
-    printf("  <output_file>             Output audio file path\n\n");
-
-    printf("UTAU Resampler Arguments:\n");
-    printf("  -p, --pitch CENTS         Pitch adjustment in cents (default: 0.0)\n");
-    printf("  -v, --velocity VALUE      Velocity/amplitude modifier (default: 100.0)\n");
-    printf("  -f, --flags FLAGS         UTAU flags as hexadecimal (default: 0)\n");
-    printf("  -o, --offset MS           OTO offset parameter in milliseconds (default: 0.0)\n");
-    printf("  -l, --length MS           OTO length parameter in milliseconds (default: 0.0)\n");
-    printf("  -c, --consonant MS        OTO consonant parameter in milliseconds (default: 0.0)\n");
-    printf("  -k, --cutoff MS           OTO cutoff parameter in milliseconds (default: 0.0)\n");
-    printf("  -V, --volume LEVEL        Volume modifier 0.0-1.0 (default: 1.0)\n");
-    printf("  -m, --modulation AMOUNT   Modulation amount (default: 0.0)\n");
-    printf("  -t, --tempo BPM           Tempo in beats per minute (default: 120.0)\n");
-    printf("  -s, --pitch-string STR    Pitch bend string (e.g., 'C4', 'R')\n\n");
-
-    printf("Audio Settings:\n");
-    printf("  -r, --sample-rate RATE    Sample rate in Hz (default: 44100)\n");
-    printf("  -C, --channels COUNT      Number of channels (default: 1)\n");
-    printf("  -b, --block-size SIZE     Block size for processing (default: 512)\n\n");
+// Resampler invocations and the persistent server
+#include "cli/resampler.h"
+#include "cli/resampler_batch.h"
+#include "cli/resampler_server.h"
+
+// Voicebank cache packs and pre-analysis
+#include "worldcache/worldcache_dict.h"
+#include "worldcache/worldcache_pack.h"
+#include "worldcache/worldcache_precache.h"
+#include "worldcache/worldcache_quant.h"
+
+// Function to run `pack build|update|verify|dict <voicebank_dir>`
+int run_pack_command(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s pack <build|update|verify|dict> <voicebank_dir>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* action = argv[1];
+    const char* dir = argv[2];
+    WorldPackReport report;
+
+    if (strcmp(action, "build") == 0 || strcmp(action, "update") == 0) {
+        if (worldpack_build(dir, strcmp(action, "update") == 0, &report) != 0) {
+            fprintf(stderr, "Error: Failed to write %s/%s\n", dir, WORLDPACK_FILENAME);
+            return EXIT_FAILURE;
+        }
+        printf("%s/%s: %d entries (%d reused, %d analyzed, %d failed), %llu bytes\n", dir,
+               WORLDPACK_FILENAME, report.entries, report.reused, report.analyzed, report.failed,
+               (unsigned long long)report.bytes);
+        return report.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    if (strcmp(action, "verify") == 0) {
+        int status = worldpack_verify(dir, &report);
+        if (status < 0) {
+            fprintf(stderr, "Error: No readable %s in %s\n", WORLDPACK_FILENAME, dir);
+            return EXIT_FAILURE;
+        }
+        printf("%s/%s: %d samples, %d entries, %d stale, %d missing, %d orphaned, %d malformed\n",
+               dir, WORLDPACK_FILENAME, report.samples, report.entries, report.stale, report.missing,
+               report.orphaned, report.failed);
+        return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    printf("Other Options:\n");
-    printf("  -h, --help                Display this help message\n");
-    printf("  --version                 Display version information\n\n");
+    if (strcmp(action, "dict") == 0) {
+        WorldCacheDictReport dict;
+        if (worldcache_dict_train(dir, 0, &dict) != 0) {
+            fprintf(stderr, "Error: Failed to train %s/%s from %d samples (zstd support and enough "
+                    "samples are required)\n", dir, WORLDCACHE_DICT_FILENAME, dict.samples);
+            return EXIT_FAILURE;
+        }
+        printf("%s/%s: id %u, %zu bytes from %d samples (%zu training bytes, %d failed)\n", dir,
+               WORLDCACHE_DICT_FILENAME, (unsigned)dict.dict_id, dict.dict_size, dict.samples,
+               dict.training_bytes, dict.failed);
+        if (dict.recompressed > 0) {
+            printf("%d sidecars recompressed: %llu -> %llu bytes (%.1f%%)\n", dict.recompressed,
+                   (unsigned long long)dict.bytes_before, (unsigned long long)dict.bytes_after,
+                   100.0 * (double)dict.bytes_after / (double)dict.bytes_before);
+        }
+        return EXIT_SUCCESS;
+    }
 
-    printf("Examples:\n");
-    printf("  %s input.wav output.wav\n", program_name);
-    printf("  %s -p 100 -v 80 --offset 50 input.wav output.wav\n", program_name);
-    printf("  %s --pitch-string \"C4 R C5\" input.wav output.wav\n", program_name);
+    fprintf(stderr, "Error: Unknown pack action '%s'\n", action);
+    return EXIT_FAILURE;
 }
 
-// Function to display version information
-void print_version(void) {
-    printf("worldx-ucra v1.0.0\n");
-    printf("WORLD-based UTAU vocal synthesizer\n");
-    printf("Built with UCRA, vv-dsp, and WORLD libraries\n");
+// Progress line of `precache`, redrawn at most a few times per second
+typedef struct {
+    double last_print;
+} PrecacheProgress;
+
+static void print_precache_progress(const WorldCachePrecacheReport* r, void* user) {
+    PrecacheProgress* p = (PrecacheProgress*)user;
+    if (r->done < r->samples && r->elapsed - p->last_print < 0.25) return;
+    p->last_print = r->elapsed;
+    double elapsed = r->elapsed > 0.0 ? r->elapsed : 1e-9;
+    fprintf(stderr, "\r[%d/%d] %d analyzed, %d current, %d failed  %.1f files/s, %.1f audio-s/s ",
+            r->done, r->samples, r->analyzed, r->current, r->failed, r->done / elapsed,
+            r->audio_seconds / elapsed);
+    if (r->done == r->samples) fputc('\n', stderr);
+    fflush(stderr);
 }
 
-// Function to parse a double value with error checking
-int parse_double(const char* str, double* value, const char* arg_name) {
-    char* endptr;
-    errno = 0;
-    *value = strtod(str, &endptr);
+// Function to run `precache [-j THREADS] [-L LEVEL] [-Q] <voicebank_dir>`
+int run_precache_command(int argc, char* argv[]) {
+    int threads = 0;
+    const char* dir = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            uint32_t value;
+            if (resampler_parse_uint32(argv[++i], &value, "thread count", stderr) != 0) return EXIT_FAILURE;
+            threads = value > 1024 ? 1024 : (int)value;
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            uint32_t value;
+            if (resampler_parse_uint32(argv[++i], &value, "compression level", stderr) != 0) return EXIT_FAILURE;
+            worldcache_set_compression_level(value > 22 ? 22 : (int)value);
+        } else if (strcmp(argv[i], "-Q") == 0) {
+            WorldCacheQuantQuality quality;
+            if (worldcache_set_quantized(1, &quality) != 0) {
+                fprintf(stderr, "Error: Quantized caches fail the quality check (MCD %.2f dB, SNR %.2f dB)\n",
+                        quality.mcd_db, quality.snr_db);
+                return EXIT_FAILURE;
+            }
+        } else if (!dir && argv[i][0] != '-') {
+            dir = argv[i];
+        } else {
+            dir = NULL;
+            break;
+        }
+    }
+    if (!dir) {
+        fprintf(stderr, "Usage: %s precache [-j THREADS] [-L LEVEL] [-Q] <voicebank_dir>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
 
-    if (errno != 0 || endptr == str || *endptr != '\0') {
-        fprintf(stderr, "Error: Invalid %s value '%s'\n", arg_name, str);
-        return -1;
+    PrecacheProgress progress = { 0.0 };
+    WorldCachePrecacheReport report;
+    int status = worldcache_precache(dir, threads, print_precache_progress, &progress, &report);
+    if (status < 0) {
+        fprintf(stderr, "Error: Cannot read voicebank directory %s\n", dir);
+        return EXIT_FAILURE;
     }
-    return 0;
+    double elapsed = report.elapsed > 0.0 ? report.elapsed : 1e-9;
+    printf("%s: %d samples from %d oto.ini (%d analyzed, %d current, %d missing, %d failed) "
+           "in %.2f s on %d threads: %.1f files/s, %.1f audio-s/s\n",
+           dir, report.samples, report.oto_files, report.analyzed, report.current, report.missing,
+           report.failed, report.elapsed, report.threads, report.samples / elapsed,
+           report.audio_seconds / elapsed);
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-// Function to parse an unsigned integer with error checking
-int parse_uint32(const char* str, uint32_t* value, const char* arg_name) {
-    char* endptr;
-    errno = 0;
-    unsigned long tmp = strtoul(str, &endptr, 0);  // 0 allows hex/oct/dec
+// Function to run `batch [-j THREADS] [-w SONG] <manifest>`
+int run_batch_command(int argc, char* argv[]) {
+    int threads = 0;
+    const char* manifest = NULL;
+    const char* song = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            uint32_t value;
+            if (resampler_parse_uint32(argv[++i], &value, "thread count", stderr) != 0) return EXIT_FAILURE;
+            threads = value > 1024 ? 1024 : (int)value;
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            song = argv[++i];
+        } else if (!manifest && argv[i][0] != '-') {
+            manifest = argv[i];
+        } else {
+            manifest = NULL;
+            break;
+        }
+    }
+    if (!manifest) {
+        fprintf(stderr, "Usage: %s batch [-j THREADS] [-w SONG] <manifest>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
 
-    if (errno != 0 || endptr == str || *endptr != '\0' || tmp > UINT32_MAX) {
-        fprintf(stderr, "Error: Invalid %s value '%s'\n", arg_name, str);
-        return -1;
+    ResamplerBatch batch;
+    if (resampler_batch_load(manifest, argv[0], &batch, stderr) != 0) return EXIT_FAILURE;
+    ResamplerEngine* engine = NULL;
+    if (resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0) {
+        fprintf(stderr, "Error: Failed to create UCRA engine\n");
+        resampler_batch_free(&batch);
+        return EXIT_FAILURE;
+    }
+    ResamplerBatchReport report;
+    WavtoolMixerStats mix;
+    int status = song ? resampler_batch_render_song(engine, &batch, song, threads, stderr, &report, &mix)
+                      : resampler_batch_render(engine, &batch, threads, stderr, &report);
+    resampler_engine_destroy(engine);
+    resampler_batch_free(&batch);
+    if (status < 0) {
+        if (!song) fprintf(stderr, "Error: Cannot start the render threads\n");
+        return EXIT_FAILURE;
+    }
+    double elapsed = report.elapsed > 0.0 ? report.elapsed : 1e-9;
+    printf("%s: %d notes (%d rendered, %d failed) in %.2f s on %d threads: %.1f notes/s, "
+           "RTF %.3f (%.2f s of audio)\n",
+           manifest, report.notes, report.rendered, report.failed, report.elapsed, report.threads,
+           report.notes / elapsed, report.audio_seconds > 0.0 ? report.elapsed / report.audio_seconds : 0.0,
+           report.audio_seconds);
+    if (song) {
+        printf("%s: %llu samples, %llu bytes written, %d overlaps clamped to the %zu KB ring\n", song,
+               (unsigned long long)mix.samples, (unsigned long long)mix.bytes_written, mix.clamped,
+               mix.ring_bytes / 1024);
     }
-    *value = (uint32_t)tmp;
-    return 0;
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-int main(int argc, char* argv[]) {
-    UCRA_RenderConfig config;
-    init_render_config(&config);
-
-    // Define long options
-    static struct option long_options[] = {
-        {"pitch",        required_argument, 0, 'p'},
-        {"velocity",     required_argument, 0, 'v'},
-        {"flags",        required_argument, 0, 'f'},
-        {"offset",       required_argument, 0, 'o'},
-        {"length",       required_argument, 0, 'l'},
-        {"consonant",    required_argument, 0, 'c'},
-        {"cutoff",       required_argument, 0, 'k'},
-        {"volume",       required_argument, 0, 'V'},
-        {"modulation",   required_argument, 0, 'm'},
-        {"tempo",        required_argument, 0, 't'},
-        {"pitch-string", required_argument, 0, 's'},
-        {"sample-rate",  required_argument, 0, 'r'},
-        {"channels",     required_argument, 0, 'C'},
-        {"block-size",   required_argument, 0, 'b'},
-        {"help",         no_argument,       0, 'h'},
-        {"version",      no_argument,       0, 1000},
-        {0, 0, 0, 0}
-    };
-
-    int opt;
-    int option_index = 0;
+// Socket named on the command line, or the default one
+static const char* socket_arg(const char* path, char* buf, size_t size) {
+    if (path) return path;
+    return resampler_default_socket(buf, size) == 0 ? buf : NULL;
+}
 
-    // Parse command line arguments
-    while ((opt = getopt_long(argc, argv, "p:v:f:o:l:c:k:V:m:t:s:r:C:b:h",
-                              long_options, &option_index)) != -1) {
-        switch (opt) {
-            case 'p':
-                if (parse_double(optarg, &config.pitch, "pitch") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'v':
-                if (parse_double(optarg, &config.velocity, "velocity") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'f':
-                if (parse_uint32(optarg, &config.flags, "flags") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'o':
-                if (parse_double(optarg, &config.offset, "offset") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'l':
-                if (parse_double(optarg, &config.length, "length") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'c':
-                if (parse_double(optarg, &config.consonant, "consonant") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'k':
-                if (parse_double(optarg, &config.cutoff, "cutoff") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'V':
-                if (parse_double(optarg, &config.volume, "volume") != 0) {
-                    return EXIT_FAILURE;
-                }
-                if (config.volume < 0.0 || config.volume > 1.0) {
-                    fprintf(stderr, "Error: Volume must be between 0.0 and 1.0\n");
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'm':
-                if (parse_double(optarg, &config.modulation, "modulation") != 0) {
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 't':
-                if (parse_double(optarg, &config.tempo, "tempo") != 0) {
-                    return EXIT_FAILURE;
-                }
-                if (config.tempo <= 0.0) {
-                    fprintf(stderr, "Error: Tempo must be positive\n");
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 's':
-                config.pitch_string = optarg;
-                break;
-            case 'r':
-                if (parse_uint32(optarg, &config.sample_rate, "sample-rate") != 0) {
-                    return EXIT_FAILURE;
-                }
-                if (config.sample_rate < 8000 || config.sample_rate > 192000) {
-                    fprintf(stderr, "Error: Sample rate must be between 8000 and 192000 Hz\n");
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'C':
-                if (parse_uint32(optarg, &config.channels, "channels") != 0) {
-                    return EXIT_FAILURE;
-                }
-                if (config.channels < 1 || config.channels > 8) {
-                    fprintf(stderr, "Error: Channels must be between 1 and 8\n");
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'b':
-                if (parse_uint32(optarg, &config.block_size, "block-size") != 0) {
-                    return EXIT_FAILURE;
-                }
-                if (config.block_size < 64 || config.block_size > 8192) {
-                    fprintf(stderr, "Error: Block size must be between 64 and 8192\n");
-                    return EXIT_FAILURE;
-                }
-                break;
-            case 'h':
-                print_help(argv[0]);
-                return EXIT_SUCCESS;
-            case 1000:  // --version
-                print_version();
-                return EXIT_SUCCESS;
-            case '?':
-                // getopt_long already printed an error message
-                fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
-                return EXIT_FAILURE;
-            default:
-                fprintf(stderr, "Unexpected option: %c\n", opt);
-                return EXIT_FAILURE;
+// Function to run `--serve [-j THREADS] [SOCKET]`
+int run_serve_command(int argc, char* argv[]) {
+    int threads = 0;
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            uint32_t value;
+            if (resampler_parse_uint32(argv[++i], &value, "thread count", stderr) != 0) return EXIT_FAILURE;
+            threads = value > 256 ? 256 : (int)value;
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s --serve [-j THREADS] [SOCKET]\n", argv[0]);
+            return EXIT_FAILURE;
         }
     }
-
-    // Check for required positional arguments
-    if (optind + 2 > argc) {
-        fprintf(stderr, "Error: Missing required arguments\n");
-        fprintf(stderr, "Usage: %s [OPTIONS] <input_file> <output_file>\n", argv[0]);
-        fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
+    char buf[512];
+    path = socket_arg(path, buf, sizeof(buf));
+    ResamplerServer* server = NULL;
+    if (!path || resampler_server_start(path, threads, RESAMPLER_CACHE_BUDGET, &server) != 0) {
+        fprintf(stderr, "Error: Cannot serve on %s (already served, or no Unix domain sockets)\n",
+                path ? path : "the default socket");
         return EXIT_FAILURE;
     }
+    printf("Serving resampler requests on %s; stop with '%s --serve-stop'\n", path, argv[0]);
+    fflush(stdout);
+
+    ResamplerServerStats stats;
+    resampler_server_join(server, &stats);
+    printf("%llu requests (%llu failed), analysis cache %llu hits, %llu misses\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.failed,
+           (unsigned long long)stats.cache_hits, (unsigned long long)stats.cache_misses);
+    return EXIT_SUCCESS;
+}
 
-    // Set input and output file paths
-    config.in_file_path = argv[optind];
-    config.out_file_path = argv[optind + 1];
-
-    // Display parsed configuration
-    printf("worldx-ucra - WORLD-based UTAU vocal synthesizer\n");
-    printf("Version: 1.0.0\n\n");
-
-    printf("Parsed Configuration:\n");
-    printf("  Input file:     %s\n", config.in_file_path);
-    printf("  Output file:    %s\n", config.out_file_path);
-    printf("  Sample rate:    %u Hz\n", config.sample_rate);
-    printf("  Channels:       %u\n", config.channels);
-    printf("  Block size:     %u\n", config.block_size);
-    printf("  Flags:          0x%X\n", config.flags);
-    printf("  Pitch:          %.2f cents\n", config.pitch);
-    printf("  Velocity:       %.2f\n", config.velocity);
-    printf("  Offset:         %.2f ms\n", config.offset);
-    printf("  Length:         %.2f ms\n", config.length);
-    printf("  Consonant:      %.2f ms\n", config.consonant);
-    printf("  Cutoff:         %.2f ms\n", config.cutoff);
-    printf("  Volume:         %.2f\n", config.volume);
-    printf("  Modulation:     %.2f\n", config.modulation);
-    printf("  Tempo:          %.2f BPM\n", config.tempo);
-    if (config.pitch_string) {
-        printf("  Pitch string:   %s\n", config.pitch_string);
+// Function to run `--serve-stop [SOCKET]`
+int run_serve_stop_command(int argc, char* argv[]) {
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s --serve-stop [SOCKET]\n", argv[0]);
+        return EXIT_FAILURE;
     }
+    char buf[512];
+    const char* path = socket_arg(argc == 2 ? argv[1] : NULL, buf, sizeof(buf));
+    if (!path || resampler_request_stop(path) != 0) {
+        fprintf(stderr, "Error: No server answered on %s\n", path ? path : "the default socket");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
 
-    printf("\nTesting UCRA library integration...\n");
-
-    // Test UCRA library functionality
-    UCRA_Handle engine = NULL;
-    UCRA_Result result = ucra_engine_create(&engine, NULL, 0);
-
-    if (result == UCRA_SUCCESS && engine != NULL) {
-        printf("✅ UCRA engine created successfully!\n");
-
-        // Get engine info
-        char info_buffer[512];
-        result = ucra_engine_getinfo(engine, info_buffer, sizeof(info_buffer));
-        if (result == UCRA_SUCCESS) {
-            printf("Engine info: %s\n", info_buffer);
-        }
-
-        // Test basic render with parsed configuration
-        UCRA_RenderResult render_result = {0};
-        result = ucra_render(engine, &config, &render_result);
-        if (result == UCRA_SUCCESS) {
-            printf("✅ UCRA render test successful!\n");
-            printf("Rendered %llu frames at %u Hz\n",
-                   (unsigned long long)render_result.frames, render_result.sample_rate);
-        } else {
-            printf("⚠️  UCRA render test returned error code: %d\n", result);
-        }
+int main(int argc, char* argv[]) {
+    // Subcommands come before the resampler options
+    if (argc > 1 && strcmp(argv[1], "pack") == 0) {
+        argv[1] = argv[0];
+        return run_pack_command(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "precache") == 0) {
+        argv[1] = argv[0];
+        return run_precache_command(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "batch") == 0) {
+        argv[1] = argv[0];
+        return run_batch_command(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        argv[1] = argv[0];
+        return run_serve_command(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve-stop") == 0) {
+        argv[1] = argv[0];
+        return run_serve_stop_command(argc - 1, argv + 1);
+    }
 
-        // Destroy engine
-        ucra_engine_destroy(engine);
-        printf("✅ UCRA engine destroyed successfully!\n");
-    } else {
-        printf("❌ Failed to create UCRA engine (error code: %d)\n", result);
+    UCRA_RenderConfig config;
+    int exit_code;
+    int parsed = resampler_parse_args(argc, argv, &config, stdout, stderr, &exit_code);
+    if (parsed == 1) resampler_print_help(stdout, argv[0], 1);
+    if (parsed != 0) return exit_code;
+
+    ResamplerEngine* engine = NULL;
+    if (resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0) {
+        printf("❌ Failed to create UCRA engine\n");
         return EXIT_FAILURE;
     }
+    printf("✅ UCRA engine created successfully!\n");
 
-    printf("\n🎵 CLI argument parsing and UCRA integration successful!\n");
-    printf("All UTAU CLI arguments are parsed and stored in UCRA_RenderConfig.\n");
+    // UCRA's render goes first: the WORLD note then owns the output file
+    resampler_engine_check(engine, &config, stdout);
+    exit_code = resampler_render_note(engine, &config, NULL, stdout, stderr, NULL);
 
-    return EXIT_SUCCESS;
+    resampler_engine_destroy(engine);
+    printf("✅ UCRA engine destroyed successfully!\n");
+    return exit_code;
 }
@@ -0,0 +1,138 @@
+/**
+ * @file resampler.h
+ * @brief UTAU resampler invocations: argument parsing and note rendering
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * One resampler invocation is `[OPTIONS] <input_file> <output_file>`, parsed
+ * into a UCRA_RenderConfig. A ResamplerEngine holds what every note needs
+ * and is expensive to set up: the UCRA engine and an in-memory analysis
+ * cache. ucra-cli creates one per process; the resampler server
+ * (resampler_server.h) keeps one alive across thousands of notes.
+ */
+#ifndef WORLDX_UCRA_RESAMPLER_H
+#define WORLDX_UCRA_RESAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ucra/ucra.h"
+#include "worldcache/worldcache_lru.h"
+
+/** Default in-memory analysis budget of an engine */
+#define RESAMPLER_CACHE_BUDGET ((size_t)256 << 20)
+
+/** @brief Initialize a render config with the resampler defaults */
+void resampler_config_init(UCRA_RenderConfig* config);
+
+/**
+ * @brief Print the usage text
+ * @param subcommands Also list ucra-cli's subcommands and server options
+ */
+void resampler_print_help(FILE* out, const char* program_name, int subcommands);
+
+/** @brief Print version information */
+void resampler_print_version(FILE* out);
+
+/**
+ * @brief Parse a double, reporting errors to err
+ * @return 0 on success, -1 on failure
+ */
+int resampler_parse_double(const char* str, double* value, const char* arg_name, FILE* err);
+
+/**
+ * @brief Parse an unsigned integer (decimal, hex or octal), reporting errors to err
+ * @return 0 on success, -1 on failure
+ */
+int resampler_parse_uint32(const char* str, uint32_t* value, const char* arg_name, FILE* err);
+
+/**
+ * @brief Parse a resampler invocation
+ *
+ * argv[0] is the program name. String fields of config point into argv.
+ * --version prints to out, errors go to err; the usage text is left to the
+ * caller, which knows what else it accepts. Uses getopt_long, so calls must
+ * not overlap.
+ *
+ * @param exit_code Receives the process exit code when the invocation is
+ *                  finished without rendering
+ * @return 0 when config holds a note to render, 1 for --help, -1 when the
+ *         invocation is finished (version or an error)
+ */
+int resampler_parse_args(int argc, char* argv[], UCRA_RenderConfig* config, FILE* out, FILE* err,
+                         int* exit_code);
+
+/** Engine shared by the notes of one process */
+typedef struct ResamplerEngine ResamplerEngine;
+
+/**
+ * @brief Create the UCRA engine and an analysis cache of cache_budget bytes
+ * @return 0 on success, -1 on failure
+ */
+int resampler_engine_create(size_t cache_budget, ResamplerEngine** out_engine);
+
+/** @brief Destroy an engine; NULL is ignored */
+void resampler_engine_destroy(ResamplerEngine* engine);
+
+/** @brief UCRA engine description */
+const char* resampler_engine_info(const ResamplerEngine* engine);
+
+/** @brief Counters of the engine's analysis cache */
+void resampler_engine_cache_stats(ResamplerEngine* engine, WorldCacheLruStats* out_stats);
+
+/**
+ * @brief Render one note
+ *
+ * Prints the parsed configuration to out, loads the
+ * input's analysis through the engine's cache, maps it onto the note
+ * (offset, consonant, cutoff, length, velocity), shifts it by the pitch and
+ * writes the synthesized note scaled by the volume to the output file.
+ * Thread-safe.
+ *
+ * @param base_dir Directory relative paths in config are resolved against;
+ *                 NULL uses them as they are
+ * @param out Receives the report; NULL discards it
+ * @param out_seconds Receives the length of the rendered note; may be NULL
+ * @return EXIT_SUCCESS or EXIT_FAILURE, as the process would exit
+ */
+int resampler_render_note(ResamplerEngine* engine, const UCRA_RenderConfig* config,
+                          const char* base_dir, FILE* out, FILE* err, double* out_seconds);
+
+/**
+ * @brief Report whether the UCRA engine renders config
+ *
+ * A diagnostic for the single-shot command line: it runs UCRA's own render
+ * under the engine's UCRA lock, so the batch and server paths, which render
+ * notes concurrently, do not call it.
+ */
+void resampler_engine_check(ResamplerEngine* engine, const UCRA_RenderConfig* config, FILE* out);
+
+/** Samples of a note rendered in memory */
+typedef struct {
+    double* samples;          /**< Mono signal; release with free() */
+    int length;
+    int sample_rate;
+    int frames;               /**< Analysis frames the note was synthesized from */
+    int interpolated_frames;
+} ResamplerNoteAudio;
+
+/**
+ * @brief Render one note into memory
+ *
+ * The samples resampler_render_note() would write to the output file, before
+ * 16-bit quantization; out_file_path is not used. Thread-safe.
+ *
+ * @return 0 on success, -1 on failure (reported to err)
+ */
+int resampler_render_samples(ResamplerEngine* engine, const UCRA_RenderConfig* config,
+                             const char* base_dir, FILE* err, ResamplerNoteAudio* audio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_RESAMPLER_H */
@@ -0,0 +1,753 @@
+/**
+ * @file resampler_batch.c
+ * @brief Manifest parsing and pooled rendering of resampler invocations
+ */
+
+#include "resampler_batch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "worldcache/worldcache_voicebank.h"
+#include "worldx_pool.h"
+#include "worldx_thread.h"
+
+static double now_sec(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Growable list of owned strings
+typedef struct {
+    char** items;
+    int count;
+    int capacity;
+} ArgList;
+
+static void args_free(ArgList* args) {
+    for (int i = 0; i < args->count; i++) free(args->items[i]);
+    free(args->items);
+    memset(args, 0, sizeof(*args));
+}
+
+// Append s, taking ownership (s is freed on failure)
+static int args_push(ArgList* args, char* s) {
+    if (!s) return -1;
+    if (args->count == args->capacity) {
+        int capacity = args->capacity ? args->capacity * 2 : 16;
+        char** items = (char**)realloc(args->items, sizeof(char*) * (size_t)capacity);
+        if (!items) {
+            free(s);
+            return -1;
+        }
+        args->items = items;
+        args->capacity = capacity;
+    }
+    args->items[args->count++] = s;
+    return 0;
+}
+
+static char* copy_string(const char* s, size_t n) {
+    char* copy = (char*)malloc(n + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+typedef struct {
+    const char* path;
+    const char* program;
+    FILE* err;
+    int capacity;
+} Loader;
+
+// Turn args (taken over and reset) into the next entry of batch
+static int batch_add(ResamplerBatch* batch, Loader* loader, ArgList* args, int line) {
+    if (batch->count == loader->capacity) {
+        int capacity = loader->capacity ? loader->capacity * 2 : 64;
+        ResamplerBatchNote* notes =
+            (ResamplerBatchNote*)realloc(batch->notes, sizeof(ResamplerBatchNote) * (size_t)capacity);
+        if (!notes) return -1;
+        batch->notes = notes;
+        loader->capacity = capacity;
+    }
+    // argv[0], the arguments and a terminating NULL
+    char** argv = (char**)calloc((size_t)args->count + 2, sizeof(char*));
+    char* program = copy_string(loader->program, strlen(loader->program));
+    if (!argv || !program) {
+        free(argv);
+        free(program);
+        return -1;
+    }
+    argv[0] = program;
+    if (args->count > 0) memcpy(argv + 1, args->items, sizeof(char*) * (size_t)args->count);
+
+    ResamplerBatchNote* note = &batch->notes[batch->count++];
+    memset(note, 0, sizeof(*note));
+    note->line = line;
+    note->argc = args->count + 1;
+    note->argv = argv;
+    free(args->items);
+    memset(args, 0, sizeof(*args));
+
+    int exit_code;
+    note->valid = resampler_parse_args(note->argc, note->argv, &note->config, loader->err, loader->err,
+                                       &exit_code) == 0;
+    note->status = EXIT_FAILURE;
+    // Positional arguments end argv once parsed; what follows the output is wavtool's
+    for (int i = 1; note->valid && i < note->argc; i++) {
+        if (note->argv[i] == note->config.out_file_path) {
+            note->wavtool_argc = note->argc - i - 1;
+            note->wavtool_argv = note->argv + i + 1;
+            break;
+        }
+    }
+    if (!note->valid) {
+        fprintf(loader->err, "%s:%d: not a resampler invocation, skipped\n", loader->path, line);
+        batch->invalid++;
+    }
+    return 0;
+}
+
+// Split one line into arguments; returns -1 on an unterminated quote
+static int tokenize_line(const char* p, const char* end, ArgList* args) {
+    for (;;) {
+        while (p < end && is_space(*p)) p++;
+        if (p >= end || *p == '#') return 0;
+
+        char* arg = (char*)malloc((size_t)(end - p) + 1);
+        if (!arg) return -1;
+        size_t n = 0;
+        while (p < end && !is_space(*p)) {
+            if (*p == '"') {
+                for (p++; p < end && *p != '"'; p++) {
+                    if (*p == '\\' && p + 1 < end && (p[1] == '"' || p[1] == '\\')) p++;
+                    arg[n++] = *p;
+                }
+            } else if (*p == '\'') {
+                for (p++; p < end && *p != '\''; p++) arg[n++] = *p;
+            } else {
+                arg[n++] = *p++;
+                continue;
+            }
+            if (p >= end) {
+                free(arg);
+                return -1;
+            }
+            p++;  // closing quote
+        }
+        arg[n] = '\0';
+        if (args_push(args, arg) != 0) return -1;
+    }
+}
+
+static int load_lines(ResamplerBatch* batch, Loader* loader, const char* text, const char* end) {
+    int line = 0;
+    for (const char* p = text; p < end; line++) {
+        const char* eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) eol = end;
+        ArgList args = { 0 };
+        if (tokenize_line(p, eol, &args) != 0) {
+            args_free(&args);
+            fprintf(loader->err, "%s:%d: unterminated quote\n", loader->path, line + 1);
+            return -1;
+        }
+        if (args.count > 0 && batch_add(batch, loader, &args, line + 1) != 0) {
+            args_free(&args);
+            return -1;
+        }
+        p = eol + 1;
+    }
+    return 0;
+}
+
+// JSON subset: objects, arrays, strings and numbers (other literals only where skipped)
+typedef struct {
+    const char* p;
+    const char* end;
+    int line;
+} Json;
+
+static void json_ws(Json* j) {
+    for (; j->p < j->end && is_space(*j->p); j->p++) {
+        if (*j->p == '\n') j->line++;
+    }
+}
+
+static int json_peek(Json* j, char c) {
+    json_ws(j);
+    return j->p < j->end && *j->p == c;
+}
+
+static int json_expect(Json* j, char c) {
+    if (!json_peek(j, c)) return -1;
+    j->p++;
+    return 0;
+}
+
+static int hex4(const char* p, unsigned* out) {
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        int d = c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : (c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1));
+        if (d < 0) return -1;
+        v = v << 4 | (unsigned)d;
+    }
+    *out = v;
+    return 0;
+}
+
+static size_t put_utf8(char* out, unsigned cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | cp >> 12);
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | cp >> 18);
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// String at the cursor, unescaped into a malloc'd copy
+static char* json_string(Json* j) {
+    if (json_expect(j, '"') != 0) return NULL;
+    // escapes never expand: \uXXXX (6 bytes) needs at most 3, a pair (12) 4
+    char* out = (char*)malloc((size_t)(j->end - j->p) + 1);
+    if (!out) return NULL;
+    size_t n = 0;
+    while (j->p < j->end && *j->p != '"') {
+        char c = *j->p++;
+        if ((unsigned char)c < 0x20) break;
+        if (c != '\\') {
+            out[n++] = c;
+            continue;
+        }
+        if (j->p >= j->end) break;
+        c = *j->p++;
+        const char* simple = strchr("\"\\/bfnrt", c);
+        if (simple && c != '\0') {
+            static const char values[] = "\"\\/\b\f\n\r\t";
+            out[n++] = values[simple - "\"\\/bfnrt"];
+            continue;
+        }
+        unsigned cp, low;
+        if (c != 'u' || j->end - j->p < 4 || hex4(j->p, &cp) != 0) break;
+        j->p += 4;
+        if (cp >= 0xD800 && cp < 0xDC00) {
+            if (j->end - j->p < 6 || j->p[0] != '\\' || j->p[1] != 'u' || hex4(j->p + 2, &low) != 0 ||
+                low < 0xDC00 || low >= 0xE000) {
+                break;
+            }
+            j->p += 6;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        n += put_utf8(out + n, cp);
+    }
+    if (j->p >= j->end || *j->p != '"') {
+        free(out);
+        return NULL;
+    }
+    j->p++;
+    out[n] = '\0';
+    return out;
+}
+
+// Number at the cursor, as its source text
+static char* json_number(Json* j) {
+    json_ws(j);
+    const char* start = j->p;
+    while (j->p < j->end && strchr("+-0123456789.eE", *j->p) && *j->p != '\0') j->p++;
+    if (j->p == start) return NULL;
+    char* text = copy_string(start, (size_t)(j->p - start));
+    if (!text) return NULL;
+    char* endptr;
+    strtod(text, &endptr);
+    if (*endptr != '\0') {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+static int json_skip(Json* j, int depth) {
+    json_ws(j);
+    if (j->p >= j->end || depth > 64) return -1;
+    char c = *j->p;
+    if (c == '"') {
+        char* s = json_string(j);
+        free(s);
+        return s ? 0 : -1;
+    }
+    if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        j->p++;
+        if (json_peek(j, close)) {
+            j->p++;
+            return 0;
+        }
+        for (;;) {
+            if (c == '{') {
+                char* key = json_string(j);
+                free(key);
+                if (!key || json_expect(j, ':') != 0) return -1;
+            }
+            if (json_skip(j, depth + 1) != 0) return -1;
+            if (json_peek(j, ',')) {
+                j->p++;
+                continue;
+            }
+            return json_expect(j, close);
+        }
+    }
+    static const char* const literals[] = { "true", "false", "null" };
+    for (int i = 0; i < 3; i++) {
+        size_t len = strlen(literals[i]);
+        if ((size_t)(j->end - j->p) >= len && memcmp(j->p, literals[i], len) == 0) {
+            j->p += len;
+            return 0;
+        }
+    }
+    char* number = json_number(j);
+    free(number);
+    return number ? 0 : -1;
+}
+
+// One note object: long options first, then input, output and the wavtool arguments
+static int json_note(Json* j, ArgList* args) {
+    if (json_expect(j, '{') != 0) return -1;
+    char *input = NULL, *output = NULL, *wavtool = NULL;
+    int result = 0;
+    if (json_peek(j, '}')) {
+        j->p++;
+    } else {
+        for (;;) {
+            char* key = json_string(j);
+            if (!key || json_expect(j, ':') != 0) {
+                free(key);
+                result = -1;
+                break;
+            }
+            char* value = json_peek(j, '"') ? json_string(j) : json_number(j);
+            if (!value) {
+                free(key);
+                result = -1;
+                break;
+            }
+            if (strcmp(key, "wavtool") == 0) {
+                free(key);
+                free(wavtool);
+                wavtool = value;
+            } else if (strcmp(key, "input") == 0 || strcmp(key, "output") == 0) {
+                char** slot = key[0] == 'i' ? &input : &output;
+                free(*slot);
+                *slot = value;
+                free(key);
+            } else {
+                size_t len = strlen(key);
+                char* option = (char*)malloc(len + 3);
+                if (option) {
+                    memcpy(option, "--", 2);
+                    memcpy(option + 2, key, len + 1);
+                }
+                free(key);
+                if (args_push(args, option) != 0 || args_push(args, value) != 0) {
+                    result = -1;
+                    break;
+                }
+            }
+            if (json_peek(j, ',')) {
+                j->p++;
+                continue;
+            }
+            result = json_expect(j, '}');
+            break;
+        }
+    }
+    if (result == 0 && input) {
+        result = args_push(args, input);
+        input = NULL;
+    }
+    if (result == 0 && output) {
+        result = args_push(args, output);
+        output = NULL;
+    }
+    if (result == 0 && wavtool) result = tokenize_line(wavtool, wavtool + strlen(wavtool), args);
+    free(input);
+    free(output);
+    free(wavtool);
+    return result;
+}
+
+static int json_notes(ResamplerBatch* batch, Loader* loader, Json* j) {
+    if (json_expect(j, '[') != 0) return -1;
+    if (json_peek(j, ']')) {
+        j->p++;
+        return 0;
+    }
+    for (;;) {
+        json_ws(j);
+        int line = j->line;
+        ArgList args = { 0 };
+        if (json_note(j, &args) != 0 || batch_add(batch, loader, &args, line) != 0) {
+            args_free(&args);
+            return -1;
+        }
+        if (json_peek(j, ',')) {
+            j->p++;
+            continue;
+        }
+        return json_expect(j, ']');
+    }
+}
+
+static int load_json(ResamplerBatch* batch, Loader* loader, const char* text, const char* end) {
+    Json j = { text, end, 1 };
+    int result = -1;
+    if (json_peek(&j, '[')) {
+        result = json_notes(batch, loader, &j);
+    } else if (json_expect(&j, '{') == 0) {
+        int found = 0;
+        result = json_peek(&j, '}') ? 0 : -1;
+        if (result == 0) j.p++;
+        while (result != 0) {
+            char* key = json_string(&j);
+            if (!key || json_expect(&j, ':') != 0) {
+                free(key);
+                break;
+            }
+            int notes = strcmp(key, "notes") == 0 && !found;
+            free(key);
+            if ((notes ? json_notes(batch, loader, &j) : json_skip(&j, 0)) != 0) break;
+            found |= notes;
+            if (json_peek(&j, ',')) {
+                j.p++;
+                continue;
+            }
+            result = json_expect(&j, '}');
+            break;
+        }
+    }
+    json_ws(&j);
+    if (result == 0 && j.p != j.end) result = -1;
+    if (result != 0) fprintf(loader->err, "%s:%d: malformed JSON manifest\n", loader->path, j.line);
+    return result;
+}
+
+// A note's output file as the key two notes collide on: the real path of
+// its directory plus its name, so "out.wav", "./out.wav" and "sub/../out.wav"
+// are one file. Paths whose directory does not resolve are kept as written.
+typedef struct {
+    const ResamplerBatchNote* note;
+    char* key;
+} Output;
+
+static char* output_key(const char* path) {
+    size_t dir_len = worldcache_path_dir_length(path);
+    char* dir = (char*)malloc(dir_len + 2);
+    if (!dir) return NULL;
+    if (dir_len > 0) {
+        memcpy(dir, path, dir_len);
+        dir[dir_len] = '\0';
+    } else {
+        strcpy(dir, ".");
+    }
+#if defined(_WIN32)
+    char* real = _fullpath(NULL, dir, 0);
+#else
+    char* real = realpath(dir, NULL);
+#endif
+    free(dir);
+    const char* name = path + dir_len;
+    char* key = (char*)malloc((real ? strlen(real) + 1 : 0) + strlen(name) + 1);
+    if (key && real) {
+        sprintf(key, "%s/%s", real, name);
+    } else if (key) {
+        strcpy(key, path);
+    }
+    free(real);
+    return key;
+}
+
+static int compare_outputs(const void* a, const void* b) {
+#if defined(_WIN32)
+    return _stricmp(((const Output*)a)->key, ((const Output*)b)->key);
+#else
+    return strcmp(((const Output*)a)->key, ((const Output*)b)->key);
+#endif
+}
+
+// Two notes writing one file would race; refuse the manifest
+static int check_outputs(const ResamplerBatch* batch, Loader* loader) {
+    Output* outputs = (Output*)calloc((size_t)batch->count + 1, sizeof(Output));
+    if (!outputs) return -1;
+    int n = 0, result = 0;
+    for (int i = 0; i < batch->count && result == 0; i++) {
+        if (!batch->notes[i].valid) continue;
+        outputs[n].note = &batch->notes[i];
+        if (!(outputs[n++].key = output_key(batch->notes[i].config.out_file_path))) result = -1;
+    }
+    if (result == 0) qsort(outputs, (size_t)n, sizeof(outputs[0]), compare_outputs);
+    for (int i = 1; i < n && result == 0; i++) {
+        if (compare_outputs(&outputs[i - 1], &outputs[i]) == 0) {
+            const ResamplerBatchNote* first = outputs[i - 1].note;
+            const ResamplerBatchNote* second = outputs[i].note;
+            if (first->line > second->line) {
+                const ResamplerBatchNote* t = first;
+                first = second;
+                second = t;
+            }
+            fprintf(loader->err, "%s:%d: %s is also written by line %d\n", loader->path, second->line,
+                    second->config.out_file_path, first->line);
+            result = -1;
+        }
+    }
+    for (int i = 0; i < n; i++) free(outputs[i].key);
+    free(outputs);
+    return result;
+}
+
+int resampler_batch_load(const char* path, const char* program, ResamplerBatch* batch, FILE* err) {
+    if (!path || !program || !batch || !err) return -1;
+    memset(batch, 0, sizeof(*batch));
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(err, "Error: Cannot read manifest %s\n", path);
+        return -1;
+    }
+    char* text = NULL;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        text = (char*)malloc((size_t)size + 1);
+        if (text && fread(text, 1, (size_t)size, f) != (size_t)size) {
+            free(text);
+            text = NULL;
+        }
+    }
+    fclose(f);
+    if (!text) {
+        fprintf(err, "Error: Cannot read manifest %s\n", path);
+        return -1;
+    }
+    text[size] = '\0';
+
+    const char* begin = text;
+    const char* end = text + size;
+    if (size >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0) begin += 3;  // UTF-8 BOM
+    const char* first = begin;
+    while (first < end && is_space(*first)) first++;
+
+    Loader loader = { path, program, err, 0 };
+    int json = first < end && (*first == '[' || *first == '{');
+    int result = json ? load_json(batch, &loader, begin, end) : load_lines(batch, &loader, begin, end);
+    if (result == 0) result = check_outputs(batch, &loader);
+    free(text);
+    if (result != 0) resampler_batch_free(batch);
+    return result;
+}
+
+void resampler_batch_free(ResamplerBatch* batch) {
+    if (!batch) return;
+    for (int i = 0; i < batch->count; i++) {
+        for (int k = 0; k < batch->notes[i].argc; k++) free(batch->notes[i].argv[k]);
+        free(batch->notes[i].argv);
+    }
+    free(batch->notes);
+    memset(batch, 0, sizeof(*batch));
+}
+
+typedef struct {
+    ResamplerEngine* engine;
+    ResamplerBatchNote* notes;
+    FILE* err;
+} BatchRun;
+
+static void render_job(void* ctx, size_t job, int worker) {
+    (void)worker;
+    BatchRun* run = (BatchRun*)ctx;
+    ResamplerBatchNote* note = &run->notes[job];
+    note->seconds = 0.0;
+    note->status = note->valid ? resampler_render_note(run->engine, &note->config, NULL, NULL, run->err,
+                                                       &note->seconds)
+                               : EXIT_FAILURE;
+}
+
+int resampler_batch_render(ResamplerEngine* engine, ResamplerBatch* batch, int threads, FILE* err,
+                           ResamplerBatchReport* report) {
+    if (!engine || !batch || !err) return -1;
+
+    BatchRun run = { engine, batch->notes, err };
+    WorldxPoolStats stats = { 0, 0 };
+    double start = now_sec();
+    if (batch->count > 0 &&
+        worldx_pool_run(threads, (size_t)batch->count, render_job, &run, &stats) != 0) {
+        return -1;
+    }
+
+    ResamplerBatchReport totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.elapsed = now_sec() - start;
+    totals.notes = batch->count;
+    totals.threads = stats.threads;
+    for (int i = 0; i < batch->count; i++) {
+        if (batch->notes[i].status == EXIT_SUCCESS) {
+            totals.rendered++;
+            totals.audio_seconds += batch->notes[i].seconds;
+        } else {
+            totals.failed++;
+        }
+    }
+    if (report) *report = totals;
+    return totals.failed ? 1 : 0;
+}
+
+typedef struct {
+    ResamplerEngine* engine;
+    ResamplerBatchNote* notes;
+    ResamplerNoteAudio* audio;
+    FILE* err;
+} SongRun;
+
+static void song_job(void* ctx, size_t job, int worker) {
+    (void)worker;
+    SongRun* run = (SongRun*)ctx;
+    ResamplerBatchNote* note = &run->notes[job];
+    ResamplerNoteAudio* audio = &run->audio[job];
+    memset(audio, 0, sizeof(*audio));
+    note->status = note->valid && resampler_render_samples(run->engine, &note->config, NULL, run->err, audio) == 0
+                       ? EXIT_SUCCESS
+                       : EXIT_FAILURE;
+}
+
+int resampler_batch_render_song(ResamplerEngine* engine, ResamplerBatch* batch, const char* output,
+                                int threads, FILE* err, ResamplerBatchReport* report,
+                                WavtoolMixerStats* mix) {
+    if (!engine || !batch || !output || !err) return -1;
+    if (threads <= 0) threads = worldx_cpu_count();
+
+    // Placement of every note, and the song's format from the first entry
+    WavtoolNote* placements = (WavtoolNote*)malloc(sizeof(WavtoolNote) * (size_t)(batch->count + 1));
+    int* placed = (int*)calloc((size_t)batch->count + 1, sizeof(int));
+    UCRA_RenderConfig format;
+    resampler_config_init(&format);
+    for (int i = 0; placements && placed && i < batch->count; i++) {
+        ResamplerBatchNote* note = &batch->notes[i];
+        if (!note->valid) continue;
+        if (wavtool_parse_note(note->wavtool_argc, note->wavtool_argv, &placements[i], err) == 0) {
+            placed[i] = 1;
+        } else {
+            fprintf(err, "%s: wavtool arguments of this note are invalid, left out\n",
+                    note->config.out_file_path);
+        }
+    }
+    if (batch->count > 0 && batch->notes[0].valid) format = batch->notes[0].config;
+
+    // Notes are rendered a window at a time and mixed in order, bounding memory
+    int window = threads * 4;
+    ResamplerNoteAudio* audio = (ResamplerNoteAudio*)calloc((size_t)window, sizeof(ResamplerNoteAudio));
+    if (!placements || !placed || !audio) {
+        free(placements);
+        free(placed);
+        free(audio);
+        return -1;
+    }
+
+    WavtoolMixer* mixer = NULL;
+    ResamplerBatchReport totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.notes = batch->count;
+    totals.threads = 1;
+    int result = 0;
+    double start = now_sec();
+    for (int first = 0; first < batch->count && result == 0; first += window) {
+        int count = batch->count - first < window ? batch->count - first : window;
+        SongRun run = { engine, batch->notes + first, audio, err };
+        WorldxPoolStats stats = { 0, 0 };
+        if (worldx_pool_run(threads, (size_t)count, song_job, &run, &stats) != 0) {
+            result = -1;
+            break;
+        }
+        if (stats.threads > totals.threads) totals.threads = stats.threads;
+
+        // The song plays at the rate of the first note rendered
+        if (!mixer) {
+            int fs = (int)format.sample_rate;
+            for (int k = count - 1; k >= 0; k--) {
+                if (batch->notes[first + k].status == EXIT_SUCCESS) fs = audio[k].sample_rate;
+            }
+            format.sample_rate = (uint32_t)fs;
+            if (wavtool_mixer_create(output, fs, (int)format.channels, (int)format.block_size,
+                                     WAVTOOL_HISTORY_MS, &mixer) != 0) {
+                result = -1;
+            }
+        }
+
+        for (int k = 0; k < count; k++) {
+            int i = first + k;
+            if (!mixer) {
+                free(audio[k].samples);
+                continue;
+            }
+            ResamplerBatchNote* note = &batch->notes[i];
+            if (note->status == EXIT_SUCCESS && audio[k].sample_rate != (int)format.sample_rate) {
+                fprintf(err, "Error: Note rendered at %d Hz into a %u Hz song (%s)\n", audio[k].sample_rate,
+                        format.sample_rate, note->config.in_file_path);
+                note->status = EXIT_FAILURE;
+            }
+            if (!placed[i]) note->status = EXIT_FAILURE;
+            int ok = note->status == EXIT_SUCCESS;
+            if (placed[i] && result == 0 &&
+                wavtool_mixer_add(mixer, ok ? audio[k].samples : NULL, ok ? audio[k].length : 0,
+                                  &placements[i]) != 0) {
+                result = -1;
+            }
+            if (ok) {
+                note->seconds = (double)audio[k].length / audio[k].sample_rate;
+                totals.rendered++;
+                totals.audio_seconds += note->seconds;
+            } else {
+                totals.failed++;
+            }
+            free(audio[k].samples);
+        }
+    }
+    if (!mixer && result == 0 &&
+        wavtool_mixer_create(output, (int)format.sample_rate, (int)format.channels, (int)format.block_size,
+                             WAVTOOL_HISTORY_MS, &mixer) != 0) {
+        result = -1;
+    }
+    if (mixer && wavtool_mixer_finish(mixer, mix) != 0) result = -1;
+    totals.elapsed = now_sec() - start;
+    if (result != 0) fprintf(err, "Error: Cannot write the song to %s\n", output);
+    if (report) *report = totals;
+    free(placements);
+    free(placed);
+    free(audio);
+    if (result != 0) return -1;
+    return totals.failed ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file resampler_batch.h
+ * @brief Render a whole list of resampler invocations in one process
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * A manifest lists resampler invocations with the arguments ucra-cli takes,
+ * in one of two forms:
+ *
+ * - Lines: one invocation per line, `[OPTIONS] <input_file> <output_file>`.
+ *   Whitespace separates arguments, "..." and '...' quote them (a backslash
+ *   escapes `"` or `\` inside "..." and is literal elsewhere, so Windows
+ *   paths need no escaping), and `#` starts a comment.
+ * - JSON: an array of objects, or an object whose "notes" member is one.
+ *   "input" and "output" are the positional arguments; every other member
+ *   is a long option (`"pitch": 100` is `--pitch 100`) with a string or
+ *   number value.
+ *
+ * The notes are rendered on a work-stealing pool (worldx_pool.h) sharing
+ * one ResamplerEngine, so each sample is analyzed or loaded once. Each note
+ * writes the same bytes as rendering it with its own ucra-cli process.
+ *
+ * Arguments after an entry's output file are wavtool's (wavtool.h: stp,
+ * length and the envelope; JSON entries give them as a "wavtool" string).
+ * A song render mixes the notes straight into one file with them instead
+ * of writing a file per note.
+ */
+#ifndef WORLDX_UCRA_RESAMPLER_BATCH_H
+#define WORLDX_UCRA_RESAMPLER_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "cli/resampler.h"
+#include "cli/wavtool.h"
+
+/** One manifest entry */
+typedef struct {
+    int line;                  /**< Manifest line the entry starts on */
+    int argc;
+    char** argv;               /**< argv[0] is the program name; owned by the batch */
+    int wavtool_argc;
+    char** wavtool_argv;       /**< Arguments after the output file, within argv */
+    UCRA_RenderConfig config;  /**< Parsed arguments; strings point into argv */
+    int valid;                 /**< Whether the arguments describe a note */
+    int status;                /**< Exit code of the render */
+    double seconds;            /**< Length of the rendered note */
+} ResamplerBatchNote;
+
+/** Parsed manifest */
+typedef struct {
+    ResamplerBatchNote* notes;
+    int count;
+    int invalid;  /**< Entries whose arguments do not describe a note */
+} ResamplerBatch;
+
+/** Totals of a batch render */
+typedef struct {
+    int notes;             /**< Entries in the manifest */
+    int rendered;          /**< Notes written */
+    int failed;            /**< Invalid entries and notes that failed to render */
+    int threads;           /**< Workers used */
+    double elapsed;        /**< Wall time of the render, seconds */
+    double audio_seconds;  /**< Length of the notes written */
+} ResamplerBatchReport;
+
+/**
+ * @brief Read and parse a manifest
+ *
+ * Entries with invalid arguments are reported to err, prefixed with the
+ * manifest line, and counted in `invalid`; they fail when rendered, as the
+ * process running them alone would.
+ *
+ * @param program argv[0] of every entry, for messages
+ * @return 0 on success, -1 if the manifest cannot be read, is malformed, or
+ *         names one output file twice (the result would depend on timing)
+ */
+int resampler_batch_load(const char* path, const char* program, ResamplerBatch* batch, FILE* err);
+
+/** @brief Free a loaded batch */
+void resampler_batch_free(ResamplerBatch* batch);
+
+/**
+ * @brief Render every note of a batch
+ *
+ * Failures are reported to err as the notes' own processes would report
+ * them; per-note reports are not printed.
+ *
+ * @param threads Worker count; <= 0 uses worldx_cpu_count()
+ * @param report Receives the totals; may be NULL
+ * @return 0 if every note was written, 1 if some failed, -1 on invalid arguments
+ */
+int resampler_batch_render(ResamplerEngine* engine, ResamplerBatch* batch, int threads, FILE* err,
+                           ResamplerBatchReport* report);
+
+/**
+ * @brief Render every note of a batch into one song
+ *
+ * Notes are rendered in memory, a few per worker at a time, and mixed in
+ * manifest order by a WavtoolMixer placing and shaping them with their
+ * wavtool arguments; no per-note files are written. The song plays at the
+ * rate of the first note rendered, with the channel count and block size of
+ * the first entry. A note that fails to render (or renders at another rate)
+ * leaves silence of its length; one whose wavtool arguments are invalid is
+ * left out.
+ *
+ * @param output Song WAV path
+ * @param mix Receives the mixer's counters; may be NULL
+ * @return 0 if every note was mixed, 1 if some failed, -1 if the song could
+ *         not be written
+ */
+int resampler_batch_render_song(ResamplerEngine* engine, ResamplerBatch* batch, const char* output,
+                                int threads, FILE* err, ResamplerBatchReport* report,
+                                WavtoolMixerStats* mix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_RESAMPLER_BATCH_H */
@@ -0,0 +1,40 @@
+/**
+ * @file resampler_client.c
+ * @brief ucra-resampler: the resampler command line, rendered by a running server
+ *
+ * Takes exactly the arguments of `ucra-cli [OPTIONS] <input_file> <output_file>`
+ * and is meant to be configured as the resampler in UTAU or OpenUtau. Each
+ * invocation is checked here, then forwarded to the `ucra-cli --serve` on the
+ * default socket (resampler_server.h); when no server answers, the note is
+ * rendered in this process exactly as ucra-cli would.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cli/resampler.h"
+#include "cli/resampler_server.h"
+
+int main(int argc, char* argv[]) {
+    UCRA_RenderConfig config;
+    int exit_code;
+    int parsed = resampler_parse_args(argc, argv, &config, stdout, stderr, &exit_code);
+    if (parsed == 1) resampler_print_help(stdout, argv[0], 0);
+    if (parsed != 0) return exit_code;
+
+    char socket_path[512];
+    if (resampler_default_socket(socket_path, sizeof(socket_path)) == 0 &&
+        resampler_forward(socket_path, argc, argv, stdout, stderr, &exit_code) == 0) {
+        return exit_code;
+    }
+
+    // No server: render in this process
+    ResamplerEngine* engine = NULL;
+    if (resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0) {
+        fprintf(stderr, "Error: Failed to create UCRA engine\n");
+        return EXIT_FAILURE;
+    }
+    exit_code = resampler_render_note(engine, &config, NULL, stdout, stderr, NULL);
+    resampler_engine_destroy(engine);
+    return exit_code;
+}
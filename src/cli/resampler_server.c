@@ -0,0 +1,491 @@
+/**
+ * @file resampler_server.c
+ * @brief Persistent resampler server over a Unix domain socket
+ *
+ * Wire format (native byte order, the client and server share a host):
+ *
+ *   request: u32 magic, u32 kind, u32 count, count x (u32 size, bytes)
+ *            strings are the client's working directory, then its argv
+ *   reply:   u32 magic, i32 exit code, (u32 size, bytes) stdout,
+ *            (u32 size, bytes) stderr
+ *
+ * Both ends check that the other runs as the same user before anything is
+ * sent or read, and the default socket lives in a directory only that user
+ * can enter.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // struct ucred
+#endif
+
+#include "resampler_server.h"
+#include "resampler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "worldx_thread.h"
+#endif
+
+#define RESAMPLER_MAGIC 0x31525857u  /* 'WXR1' */
+#define RESAMPLER_MAX_ARGS 256
+#define RESAMPLER_MAX_STRING ((uint32_t)64 << 10)
+#define RESAMPLER_MAX_OUTPUT ((uint32_t)16 << 20)
+#define RESAMPLER_MAX_THREADS 256
+
+enum { REQUEST_RENDER = 0, REQUEST_STOP = 1 };
+
+// Separator to put between dir and a name
+static const char* dir_sep(const char* dir) {
+    return dir[strlen(dir) - 1] == '/' ? "" : "/";
+}
+
+#if !defined(_WIN32)
+// The per-user directory of the default socket under a shared temporary
+// directory: created 0700 if missing, and only used if it is a real
+// directory of this user that nobody else can enter
+static int private_dir(const char* path) {
+    struct stat st;
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+    return lstat(path, &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == geteuid() && (st.st_mode & 077) == 0
+               ? 0
+               : -1;
+}
+#endif
+
+int resampler_default_socket(char* out, size_t size) {
+    if (!out || size == 0) return -1;
+
+    const char* env = getenv(RESAMPLER_SOCKET_ENV);
+    int n;
+    if (env && env[0] != '\0') {
+        n = snprintf(out, size, "%s", env);
+        return n >= 0 && (size_t)n < size ? 0 : -1;
+    }
+#if defined(_WIN32)
+    const char* dir = getenv("TEMP");
+    if (!dir || dir[0] == '\0') dir = "/tmp";
+    n = snprintf(out, size, "%s%sworldx-ucra.sock", dir, dir_sep(dir));
+    return n >= 0 && (size_t)n < size ? 0 : -1;
+#else
+    // $XDG_RUNTIME_DIR is private to the user already
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0] == '/') {
+        n = snprintf(out, size, "%s%sworldx-ucra.sock", runtime, dir_sep(runtime));
+        return n >= 0 && (size_t)n < size ? 0 : -1;
+    }
+    const char* dir = getenv("TMPDIR");
+    if (!dir || dir[0] == '\0') dir = "/tmp";
+    n = snprintf(out, size, "%s%sworldx-ucra-%u", dir, dir_sep(dir), (unsigned)geteuid());
+    if (n < 0 || (size_t)n >= size || private_dir(out) != 0) return -1;
+    int m = snprintf(out + n, size - (size_t)n, "/resampler.sock");
+    return m >= 0 && (size_t)m < size - (size_t)n ? 0 : -1;
+#endif
+}
+
+#if !defined(_WIN32)
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+struct ResamplerServer {
+    int fd;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    int bound;
+    ResamplerEngine* engine;
+    worldx_thread_t* threads;
+    int thread_count;
+    // lock guards stopping and the counters
+    worldx_mutex_t lock;
+    // getopt_long keeps global state
+    worldx_mutex_t parse_lock;
+    int stopping;
+    uint64_t requests, failed;
+};
+
+static int send_all(int fd, const void* buf, size_t size) {
+    const char* p = (const char*)buf;
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, SEND_FLAGS);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+static int recv_all(int fd, void* buf, size_t size) {
+    char* p = (char*)buf;
+    while (size > 0) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+static int send_u32(int fd, uint32_t v) { return send_all(fd, &v, sizeof(v)); }
+static int recv_u32(int fd, uint32_t* v) { return recv_all(fd, v, sizeof(*v)); }
+
+static int send_block(int fd, const void* data, size_t size) {
+    if (size > UINT32_MAX) return -1;
+    return send_u32(fd, (uint32_t)size) == 0 && (size == 0 || send_all(fd, data, size) == 0) ? 0 : -1;
+}
+
+// Receive a block of at most max bytes as a NUL-terminated malloc'd string
+static char* recv_block(int fd, uint32_t max, uint32_t* out_size) {
+    uint32_t size;
+    if (recv_u32(fd, &size) != 0 || size > max) return NULL;
+    char* data = (char*)malloc((size_t)size + 1);
+    if (!data) return NULL;
+    if (size > 0 && recv_all(fd, data, size) != 0) {
+        free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    if (out_size) *out_size = size;
+    return data;
+}
+
+// Whether the process at the other end of fd runs as this user. Linux and
+// the BSDs report it; elsewhere only the socket's directory protects it.
+static int peer_is_user(int fd) {
+#if defined(__linux__)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == geteuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) || \
+    defined(__DragonFly__)
+    uid_t uid;
+    gid_t gid;
+    return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#else
+    (void)fd;
+    return 1;
+#endif
+}
+
+// Connect to the server at path; a listener of another user is not talked to
+static int socket_connect(const char* path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || !peer_is_user(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void free_strings(char** strings, uint32_t count) {
+    if (!strings) return;
+    for (uint32_t i = 0; i < count; i++) free(strings[i]);
+    free(strings);
+}
+
+static int send_reply(int fd, int exit_code, const char* out, size_t out_size, const char* err,
+                      size_t err_size) {
+    int32_t code = (int32_t)exit_code;
+    return send_u32(fd, RESAMPLER_MAGIC) == 0 && send_all(fd, &code, sizeof(code)) == 0 &&
+                   send_block(fd, out, out_size) == 0 && send_block(fd, err, err_size) == 0
+               ? 0
+               : -1;
+}
+
+// Parse and render one forwarded invocation, printing to out and err
+static int render_request(ResamplerServer* server, int argc, char* argv[], const char* cwd, FILE* out,
+                          FILE* err) {
+    UCRA_RenderConfig config;
+    int exit_code;
+    worldx_mutex_lock(&server->parse_lock);
+    int parsed = resampler_parse_args(argc, argv, &config, out, err, &exit_code);
+    worldx_mutex_unlock(&server->parse_lock);
+    if (parsed == 1) resampler_print_help(out, argv[0], 0);
+    if (parsed != 0) return exit_code;
+    return resampler_render_note(server->engine, &config, cwd, out, err, NULL);
+}
+
+// Wake the workers blocked in accept() so they see the stop flag
+static void wake_workers(ResamplerServer* server) {
+    for (int i = 1; i < server->thread_count; i++) {
+        int fd = socket_connect(server->path);
+        if (fd >= 0) close(fd);
+    }
+}
+
+// Serve one connection; returns 1 if it asked the server to stop
+static int handle_client(ResamplerServer* server, int client) {
+    uint32_t magic, kind, count;
+    if (recv_u32(client, &magic) != 0 || magic != RESAMPLER_MAGIC || recv_u32(client, &kind) != 0 ||
+        recv_u32(client, &count) != 0 || count > RESAMPLER_MAX_ARGS + 1) {
+        return 0;
+    }
+    // one spare slot keeps argv NULL-terminated
+    char** strings = (char**)calloc((size_t)count + 1, sizeof(char*));
+    if (!strings) return 0;
+    for (uint32_t i = 0; i < count; i++) {
+        strings[i] = recv_block(client, RESAMPLER_MAX_STRING, NULL);
+        if (!strings[i]) {
+            free_strings(strings, count);
+            return 0;
+        }
+    }
+
+    if (kind == REQUEST_STOP) {
+        worldx_mutex_lock(&server->lock);
+        server->stopping = 1;
+        worldx_mutex_unlock(&server->lock);
+        send_reply(client, EXIT_SUCCESS, NULL, 0, NULL, 0);
+        free_strings(strings, count);
+        return 1;
+    }
+    if (kind != REQUEST_RENDER || count < 2) {
+        free_strings(strings, count);
+        return 0;
+    }
+
+    char *out_text = NULL, *err_text = NULL;
+    size_t out_size = 0, err_size = 0;
+    FILE* out = open_memstream(&out_text, &out_size);
+    FILE* err = open_memstream(&err_text, &err_size);
+    int exit_code = EXIT_FAILURE;
+    if (out && err) exit_code = render_request(server, (int)count - 1, strings + 1, strings[0], out, err);
+    if (out) fclose(out);
+    if (err) fclose(err);
+
+    send_reply(client, exit_code, out_text, out_size, err_text, err_size);
+    worldx_mutex_lock(&server->lock);
+    server->requests++;
+    if (exit_code != EXIT_SUCCESS) server->failed++;
+    worldx_mutex_unlock(&server->lock);
+
+    free(out_text);
+    free(err_text);
+    free_strings(strings, count);
+    return 0;
+}
+
+static void worker_main(void* arg) {
+    ResamplerServer* server = (ResamplerServer*)arg;
+    for (;;) {
+        int client = accept(server->fd, NULL, NULL);
+        worldx_mutex_lock(&server->lock);
+        int stopping = server->stopping;
+        worldx_mutex_unlock(&server->lock);
+        if (stopping) {
+            if (client >= 0) close(client);
+            break;
+        }
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        // other users get nothing rendered, stopped or even read
+        if (!peer_is_user(client)) {
+            close(client);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        int stop = handle_client(server, client);
+        close(client);
+        if (stop) {
+            wake_workers(server);
+            break;
+        }
+    }
+}
+
+static void server_free(ResamplerServer* server) {
+    if (server->fd >= 0) close(server->fd);
+    if (server->bound) unlink(server->path);
+    resampler_engine_destroy(server->engine);
+    worldx_mutex_destroy(&server->lock);
+    worldx_mutex_destroy(&server->parse_lock);
+    free(server->threads);
+    free(server);
+}
+
+int resampler_server_start(const char* socket_path, int threads, size_t cache_budget,
+                           ResamplerServer** out_server) {
+    if (!socket_path || !out_server) return -1;
+    *out_server = NULL;
+
+    struct sockaddr_un addr;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) return -1;
+    // A server that still answers owns the path; a socket file of this user
+    // nobody listens on is left over from one that died. Another user's
+    // socket stays, and bind() refuses the path.
+    int probe = socket_connect(socket_path);
+    if (probe >= 0) {
+        close(probe);
+        return -1;
+    }
+    struct stat st;
+    if (lstat(socket_path, &st) == 0 && S_ISSOCK(st.st_mode) && st.st_uid == geteuid()) unlink(socket_path);
+
+    ResamplerServer* server = (ResamplerServer*)calloc(1, sizeof(ResamplerServer));
+    if (!server) return -1;
+    server->fd = -1;
+    strcpy(server->path, socket_path);
+    if (worldx_mutex_init(&server->lock) != 0) {
+        free(server);
+        return -1;
+    }
+    if (worldx_mutex_init(&server->parse_lock) != 0) {
+        worldx_mutex_destroy(&server->lock);
+        free(server);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    int count = threads > 0 ? threads : worldx_cpu_count();
+    if (count > RESAMPLER_MAX_THREADS) count = RESAMPLER_MAX_THREADS;
+    server->threads = (worldx_thread_t*)calloc((size_t)count, sizeof(worldx_thread_t));
+    if (!server->threads || resampler_engine_create(cache_budget, &server->engine) != 0 ||
+        (server->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        server_free(server);
+        return -1;
+    }
+    if (bind(server->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        server_free(server);
+        return -1;
+    }
+    server->bound = 1;
+    if (chmod(socket_path, 0600) != 0 || listen(server->fd, SOMAXCONN) != 0) {
+        server_free(server);
+        return -1;
+    }
+
+    // Workers that cannot be started leave the connections to the others
+    for (int i = 0; i < count; i++) {
+        if (worldx_thread_create(&server->threads[server->thread_count], worker_main, server) != 0) break;
+        server->thread_count++;
+    }
+    if (server->thread_count == 0) {
+        server_free(server);
+        return -1;
+    }
+    *out_server = server;
+    return 0;
+}
+
+void resampler_server_join(ResamplerServer* server, ResamplerServerStats* out_stats) {
+    if (!server) return;
+
+    for (int i = 0; i < server->thread_count; i++) worldx_thread_join(&server->threads[i]);
+    if (out_stats) {
+        WorldCacheLruStats cache;
+        resampler_engine_cache_stats(server->engine, &cache);
+        out_stats->requests = server->requests;
+        out_stats->failed = server->failed;
+        out_stats->cache_hits = cache.hits;
+        out_stats->cache_misses = cache.misses;
+    }
+    server_free(server);
+}
+
+int resampler_forward(const char* socket_path, int argc, char* argv[], FILE* out, FILE* err,
+                      int* exit_code) {
+    if (!socket_path || argc < 1 || argc > RESAMPLER_MAX_ARGS || !argv || !exit_code) return -1;
+
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) return -1;
+    int fd = socket_connect(socket_path);
+    if (fd < 0) return -1;
+
+    int ok = send_u32(fd, RESAMPLER_MAGIC) == 0 && send_u32(fd, REQUEST_RENDER) == 0 &&
+             send_u32(fd, (uint32_t)argc + 1) == 0 && send_block(fd, cwd, strlen(cwd)) == 0;
+    for (int i = 0; ok && i < argc; i++) ok = send_block(fd, argv[i], strlen(argv[i])) == 0;
+
+    uint32_t magic = 0, out_size = 0, err_size = 0;
+    int32_t code = EXIT_FAILURE;
+    char *out_text = NULL, *err_text = NULL;
+    ok = ok && recv_u32(fd, &magic) == 0 && magic == RESAMPLER_MAGIC && recv_all(fd, &code, sizeof(code)) == 0;
+    if (ok) out_text = recv_block(fd, RESAMPLER_MAX_OUTPUT, &out_size);
+    if (out_text) err_text = recv_block(fd, RESAMPLER_MAX_OUTPUT, &err_size);
+    close(fd);
+
+    // The server went away mid-request: the caller renders the note itself
+    if (!err_text) {
+        free(out_text);
+        return -1;
+    }
+    if (out) fwrite(out_text, 1, out_size, out);
+    if (err) fwrite(err_text, 1, err_size, err);
+    free(out_text);
+    free(err_text);
+    *exit_code = code;
+    return 0;
+}
+
+int resampler_request_stop(const char* socket_path) {
+    if (!socket_path) return -1;
+
+    int fd = socket_connect(socket_path);
+    if (fd < 0) return -1;
+    uint32_t magic = 0;
+    int32_t code = EXIT_FAILURE;
+    int ok = send_u32(fd, RESAMPLER_MAGIC) == 0 && send_u32(fd, REQUEST_STOP) == 0 && send_u32(fd, 0) == 0 &&
+             recv_u32(fd, &magic) == 0 && magic == RESAMPLER_MAGIC && recv_all(fd, &code, sizeof(code)) == 0;
+    close(fd);
+    return ok && code == EXIT_SUCCESS ? 0 : -1;
+}
+
+#else /* _WIN32 */
+
+int resampler_server_start(const char* socket_path, int threads, size_t cache_budget,
+                           ResamplerServer** out_server) {
+    (void)socket_path;
+    (void)threads;
+    (void)cache_budget;
+    if (out_server) *out_server = NULL;
+    return -1;
+}
+
+void resampler_server_join(ResamplerServer* server, ResamplerServerStats* out_stats) {
+    (void)server;
+    if (out_stats) memset(out_stats, 0, sizeof(*out_stats));
+}
+
+int resampler_forward(const char* socket_path, int argc, char* argv[], FILE* out, FILE* err,
+                      int* exit_code) {
+    (void)socket_path;
+    (void)argc;
+    (void)argv;
+    (void)out;
+    (void)err;
+    (void)exit_code;
+    return -1;
+}
+
+int resampler_request_stop(const char* socket_path) {
+    (void)socket_path;
+    return -1;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,105 @@
+/**
+ * @file resampler_server.h
+ * @brief Persistent resampler server and its client
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * UTAU and OpenUtau start the resampler once per note, so every note pays
+ * for process startup, creating the UCRA engine and loading the sample's
+ * analysis. The server (`ucra-cli --serve`) keeps one ResamplerEngine, with
+ * its in-memory analysis cache, alive and renders the invocations clients
+ * forward to it over a Unix domain socket on a fixed set of worker threads.
+ *
+ * A request carries the client's working directory and its argv unchanged;
+ * the reply carries the exit code and what the invocation printed to stdout
+ * and stderr, so a forwarded note behaves exactly like one rendered in the
+ * client's own process. Both ends hang up on a peer that runs as another
+ * user (SO_PEERCRED on Linux, getpeereid() on the BSDs and macOS), and the
+ * server only replaces a leftover socket file of its own user. Unix domain
+ * sockets are POSIX-only: on Windows the server does not start and
+ * resampler_forward() always reports that no server is running.
+ */
+#ifndef WORLDX_UCRA_RESAMPLER_SERVER_H
+#define WORLDX_UCRA_RESAMPLER_SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Environment variable overriding the default socket path */
+#define RESAMPLER_SOCKET_ENV "WORLDX_RESAMPLER_SOCKET"
+
+/** Opaque running server */
+typedef struct ResamplerServer ResamplerServer;
+
+/** Counters of a server's lifetime */
+typedef struct {
+    uint64_t requests;      /**< Invocations rendered or answered */
+    uint64_t failed;        /**< Invocations that exited with a failure */
+    uint64_t cache_hits;    /**< Notes whose analysis was already in memory */
+    uint64_t cache_misses;  /**< Notes whose analysis was loaded or computed */
+} ResamplerServerStats;
+
+/**
+ * @brief Default socket path
+ *
+ * $WORLDX_RESAMPLER_SOCKET if set, otherwise worldx-ucra.sock in
+ * $XDG_RUNTIME_DIR, or resampler.sock in worldx-ucra-<uid> under $TMPDIR
+ * (or /tmp). That directory is created with mode 0700 and refused if it is
+ * not a directory of this user closed to everyone else.
+ *
+ * @return 0 on success, -1 if the path does not fit or its directory is not private
+ */
+int resampler_default_socket(char* out, size_t size);
+
+/**
+ * @brief Start serving on socket_path
+ *
+ * Creates the engine, binds the socket (replacing a stale socket file, but
+ * failing if a server still answers there) and starts the workers.
+ *
+ * @param threads Worker threads; <= 0 uses worldx_cpu_count()
+ * @param cache_budget Byte budget of the in-memory analysis cache
+ * @return 0 on success, -1 on failure
+ */
+int resampler_server_start(const char* socket_path, int threads, size_t cache_budget,
+                           ResamplerServer** out_server);
+
+/**
+ * @brief Wait for a stop request, then shut the server down
+ *
+ * Joins the workers, removes the socket file, destroys the engine and frees
+ * the server.
+ *
+ * @param out_stats Receives the lifetime counters; may be NULL
+ */
+void resampler_server_join(ResamplerServer* server, ResamplerServerStats* out_stats);
+
+/**
+ * @brief Render an invocation on the server at socket_path
+ *
+ * Relative paths in argv are resolved against the caller's working
+ * directory. What the invocation printed is written to out and err.
+ *
+ * @param exit_code Receives the invocation's exit code
+ * @return 0 if the server handled the invocation, -1 if no server answered
+ *         (the caller should render in-process)
+ */
+int resampler_forward(const char* socket_path, int argc, char* argv[], FILE* out, FILE* err,
+                      int* exit_code);
+
+/**
+ * @brief Ask the server at socket_path to stop
+ * @return 0 if a server acknowledged, -1 otherwise
+ */
+int resampler_request_stop(const char* socket_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_RESAMPLER_SERVER_H */
@@ -0,0 +1,183 @@
+#include "resampler.h"
+#include "resampler_batch.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Batch rendering: line and JSON manifests rendered on four threads write
+ * the same bytes as each note rendered alone with its own engine (every
+ * note's synthesis owns its noise generator),
+ * invalid entries fail without stopping the rest, and manifests that are
+ * malformed or write one file twice, however it is spelled, are refused. */
+
+#define NOTES 6
+
+static const char* kWavs[2] = { "resampler batch test a.wav", "resampler_batch_test_b.wav" };
+static const char* kLines = "resampler_batch_test.txt";
+static const char* kJson = "resampler_batch_test.json";
+static const char* kBad = "resampler_batch_test_bad.txt";
+
+/* Note i: sample, pitch, velocity, length */
+static const struct { int wav; const char *pitch, *velocity, *length; } kNotes[NOTES] = {
+    { 0, "0", "100", "300" },  { 1, "200", "150", "400" }, { 0, "-300", "80", "250" },
+    { 1, "700", "100", "350" }, { 0, "1200", "120", "500" }, { 1, "-1200", "100", "200" },
+};
+
+static int write_text(const char* path, const char* text) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    fputs(text, f);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void output_name(char* buf, size_t size, const char* kind, int i) {
+    snprintf(buf, size, "resampler_batch_test_%s_%d.wav", kind, i);
+}
+
+static void cleanup(void) {
+    char path[256];
+    for (int w = 0; w < 2; w++) {
+        snprintf(path, sizeof(path), "%s.worldcache", kWavs[w]);
+        remove(path);
+        remove(kWavs[w]);
+    }
+    static const char* const kinds[] = { "ref", "lines", "json" };
+    for (int k = 0; k < 3; k++) {
+        for (int i = 0; i < NOTES; i++) {
+            output_name(path, sizeof(path), kinds[k], i);
+            remove(path);
+        }
+    }
+    remove(kLines);
+    remove(kJson);
+    remove(kBad);
+}
+
+/* Render every note alone, the way separate ucra-cli runs would */
+static int render_references(FILE* sink) {
+    for (int i = 0; i < NOTES; i++) {
+        char out[256];
+        output_name(out, sizeof(out), "ref", i);
+        char* argv[] = { "ucra-cli", "-p", (char*)kNotes[i].pitch, "-v", (char*)kNotes[i].velocity,
+                         "-o", "20", "-l", (char*)kNotes[i].length, (char*)kWavs[kNotes[i].wav], out, NULL };
+        UCRA_RenderConfig config;
+        int exit_code;
+        ResamplerEngine* engine = NULL;
+        if (resampler_parse_args(11, argv, &config, sink, stderr, &exit_code) != 0 ||
+            resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0) {
+            return -1;
+        }
+        int status = resampler_render_note(engine, &config, NULL, sink, stderr, NULL);
+        resampler_engine_destroy(engine);
+        if (status != EXIT_SUCCESS) return -1;
+    }
+    return 0;
+}
+
+static int write_manifests(void) {
+    char lines[4096] = "# notes of the test song\n\n";
+    char json[4096] = "{\"voicebank\": {\"name\": \"test\", \"tags\": [1, true, null]},\n \"notes\": [\n";
+    for (int i = 0; i < NOTES; i++) {
+        char out[256], entry[512];
+        output_name(out, sizeof(out), "lines", i);
+        snprintf(entry, sizeof(entry), "-p %s --velocity=%s -o 20 -l '%s' \"%s\" %s  # note %d\n",
+                 kNotes[i].pitch, kNotes[i].velocity, kNotes[i].length, kWavs[kNotes[i].wav], out, i);
+        strcat(lines, entry);
+        output_name(out, sizeof(out), "json", i);
+        snprintf(entry, sizeof(entry),
+                 "  {\"input\": \"%s\", \"pitch\": %s, \"velocity\": \"%s\", \"offset\": 20,\n"
+                 "   \"length\": %s, \"output\": \"%s\"},\n",
+                 kWavs[kNotes[i].wav], kNotes[i].pitch, kNotes[i].velocity, kNotes[i].length, out);
+        strcat(json, entry);
+    }
+    /* one entry each that cannot render */
+    strcat(lines, "-V 2 resampler_batch_test_b.wav resampler_batch_test_lines_x.wav\n");
+    strcat(json, "  {\"input\": \"resampler_batch_test_b.wav\", \"volume\": 2,"
+                 " \"output\": \"resampler_batch_test_json_x.wav\"}\n]}\n");
+    return write_text(kLines, lines) == 0 && write_text(kJson, json) == 0 ? 0 : -1;
+}
+
+/* Load and render path; every valid note must match its reference */
+static int check_manifest(const char* path, const char* kind, FILE* sink) {
+    ResamplerBatch batch;
+    if (resampler_batch_load(path, "ucra-cli", &batch, sink) != 0) {
+        fprintf(stderr, "%s: not loaded\n", path);
+        return -1;
+    }
+    if (batch.count != NOTES + 1 || batch.invalid != 1 || batch.notes[NOTES].valid) {
+        fprintf(stderr, "%s: %d entries, %d invalid\n", path, batch.count, batch.invalid);
+        return -1;
+    }
+    ResamplerEngine* engine = NULL;
+    ResamplerBatchReport report;
+    if (resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0) return -1;
+    int status = resampler_batch_render(engine, &batch, 4, sink, &report);
+    WorldCacheLruStats cache;
+    resampler_engine_cache_stats(engine, &cache);
+    resampler_engine_destroy(engine);
+    resampler_batch_free(&batch);
+
+    printf("%s: %d notes, %d rendered, %d failed on %d threads, %.2f s of audio, cache %llu misses\n", path,
+           report.notes, report.rendered, report.failed, report.threads, report.audio_seconds,
+           (unsigned long long)cache.misses);
+    if (status != 1 || report.rendered != NOTES || report.failed != 1 || report.threads != 4 ||
+        report.audio_seconds <= 0.0 || cache.misses != 2) {
+        fprintf(stderr, "%s: unexpected report\n", path);
+        return -1;
+    }
+    for (int i = 0; i < NOTES; i++) {
+        char ref[256], out[256];
+        output_name(ref, sizeof(ref), "ref", i);
+        output_name(out, sizeof(out), kind, i);
+        if (!worldx_test_same_file(ref, out)) {
+            fprintf(stderr, "%s: note %d differs from its own render\n", path, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    cleanup();
+    if (worldx_test_write_tone(kWavs[0], 22050, 0.5, 220.0, 2) != 0 ||
+        worldx_test_write_tone(kWavs[1], 22050, 0.5, 330.0, 2) != 0) {
+        perror("wav"); return 1;
+    }
+    FILE* sink = tmpfile();
+    if (!sink) { perror("tmpfile"); return 1; }
+
+    if (render_references(sink) != 0) { fprintf(stderr, "reference render failed\n"); return 2; }
+    if (write_manifests() != 0) { perror("manifest"); return 3; }
+    if (check_manifest(kLines, "lines", sink) != 0) return 4;
+    if (check_manifest(kJson, "json", sink) != 0) return 5;
+
+    /* refused manifests */
+    static const char* const bad[] = {
+        "a.wav out.wav\n-p 100 b.wav out.wav\n",   /* one output twice */
+        "a.wav out.wav\nb.wav ./out.wav\n",         /* the same file spelled twice */
+        "a.wav ./out.wav\nb.wav .//./out.wav\n",
+        "a.wav \"out.wav\n",                         /* unterminated quote */
+        "[{\"input\": \"a.wav\", \"output\": \"out.wav\"}",  /* unterminated array */
+        "[{\"input\": \"a.wav\", \"pitch\": true}]",       /* unsupported value */
+        "{\"notes\": []} trailing",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        ResamplerBatch batch;
+        if (write_text(kBad, bad[i]) != 0) { perror("manifest"); return 6; }
+        if (resampler_batch_load(kBad, "ucra-cli", &batch, sink) == 0) {
+            fprintf(stderr, "bad manifest %zu accepted\n", i); return 7;
+        }
+    }
+    ResamplerBatch batch;
+    if (resampler_batch_load("resampler_batch_test_missing.txt", "ucra-cli", &batch, sink) == 0) {
+        fprintf(stderr, "missing manifest accepted\n"); return 8;
+    }
+
+    fclose(sink);
+    cleanup();
+    printf("resampler batch test passed\n");
+    return 0;
+}
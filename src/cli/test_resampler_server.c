@@ -0,0 +1,176 @@
+#include "resampler.h"
+#include "resampler_server.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/* Resampler server: a forwarded note writes the same bytes as one rendered
+ * in-process, the second note of a sample is served from memory, failures
+ * and --help come back with their exit codes, and once the server stops
+ * forwarding reports that the caller has to render itself. */
+
+static const char* kWav = "resampler_server_test.wav";
+static const char* kSocket = "resampler_server_test.sock";
+static const char* kLocal = "resampler_server_test_local.wav";
+static const char* kServed = "resampler_server_test_served.wav";
+
+/* A note invocation writing to output; argv is rebuilt per call since
+ * getopt_long may reorder it */
+#define NOTE_ARGS 15
+static void note_args(char* argv[NOTE_ARGS], const char* output) {
+    const char* args[NOTE_ARGS] = { "ucra-cli", "-p", "200", "-v", "150", "-o", "20", "-c", "80",
+                                    "-l", "400", "-V", "0.8", kWav, output };
+    for (int i = 0; i < NOTE_ARGS; i++) argv[i] = (char*)args[i];
+}
+
+static void cleanup(void) {
+    char sidecar[256];
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWav);
+    remove(sidecar);
+    remove(kWav);
+    remove(kLocal);
+    remove(kServed);
+}
+
+#if !defined(_WIN32)
+/* The default socket is in $XDG_RUNTIME_DIR, else in a private per-user
+ * directory under $TMPDIR; a directory others can enter is refused */
+static int check_default_socket(void) {
+    const char* tmp = "resampler_server_test_tmp";
+    char expected[300], path[512], dir[256];
+    unsetenv(RESAMPLER_SOCKET_ENV);
+    setenv("XDG_RUNTIME_DIR", "/run/user/test", 1);
+    if (resampler_default_socket(path, sizeof(path)) != 0 || strcmp(path, "/run/user/test/worldx-ucra.sock") != 0) {
+        return 1;
+    }
+    unsetenv("XDG_RUNTIME_DIR");
+    setenv("TMPDIR", tmp, 1);
+    mkdir(tmp, 0755);
+    snprintf(dir, sizeof(dir), "%s/worldx-ucra-%u", tmp, (unsigned)geteuid());
+    snprintf(expected, sizeof(expected), "%s/resampler.sock", dir);
+    struct stat st;
+    int result = resampler_default_socket(path, sizeof(path)) != 0 || strcmp(path, expected) != 0 ||
+                         stat(dir, &st) != 0 || (st.st_mode & 0777) != 0700
+                     ? 2
+                     : 0;
+    if (result == 0 && (chmod(dir, 0755) != 0 || resampler_default_socket(path, sizeof(path)) == 0)) result = 3;
+    rmdir(dir);
+    rmdir(tmp);
+    unsetenv("TMPDIR");
+    return result;
+}
+
+/* Another user reaching the socket is hung up on before its request is
+ * read: its stop is not acknowledged and the server keeps serving. Needs
+ * root to switch users. */
+static int check_foreign_peer(void) {
+    if (geteuid() != 0) {
+        printf("foreign peer check skipped (not root)\n");
+        return 0;
+    }
+    if (chmod(kSocket, 0666) != 0) return 1;
+    pid_t pid = fork();
+    if (pid < 0) return 2;
+    if (pid == 0) {
+        if (setuid(65534) != 0) _exit(2);
+        _exit(resampler_request_stop(kSocket) == 0 ? 1 : 0);
+    }
+    int status = 0;
+    int result = waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 3;
+    return chmod(kSocket, 0600) == 0 ? result : 4;
+}
+#endif
+
+int main(void) {
+    cleanup();
+    if (worldx_test_write_tone(kWav, 22050, 0.5, 220.0, 2) != 0) { perror("wav"); return 1; }
+    FILE* sink = tmpfile();
+    if (!sink) { perror("tmpfile"); return 1; }
+
+    /* in-process reference */
+    char* argv[NOTE_ARGS];
+    note_args(argv, kLocal);
+    UCRA_RenderConfig config;
+    int exit_code;
+    ResamplerEngine* engine = NULL;
+    if (resampler_parse_args(NOTE_ARGS, argv, &config, sink, stderr, &exit_code) != 0 ||
+        resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0 ||
+        resampler_render_note(engine, &config, NULL, sink, stderr, NULL) != EXIT_SUCCESS) {
+        fprintf(stderr, "in-process render failed\n"); return 2;
+    }
+    resampler_engine_destroy(engine);
+
+    ResamplerServer* server = NULL;
+    if (resampler_server_start(kSocket, 2, RESAMPLER_CACHE_BUDGET, &server) != 0) {
+#if defined(_WIN32)
+        printf("resampler server skipped (no Unix domain sockets)\n");
+        cleanup();
+        return 0;
+#else
+        fprintf(stderr, "server did not start\n"); return 3;
+#endif
+    }
+    /* a second server on the same socket is refused */
+    ResamplerServer* second = NULL;
+    if (resampler_server_start(kSocket, 1, RESAMPLER_CACHE_BUDGET, &second) == 0) {
+        fprintf(stderr, "second server started\n"); return 4;
+    }
+
+#if !defined(_WIN32)
+    int step = check_default_socket();
+    if (step != 0) { fprintf(stderr, "default socket check failed (%d)\n", step); return 12; }
+    step = check_foreign_peer();
+    if (step != 0) { fprintf(stderr, "foreign peer check failed (%d)\n", step); return 13; }
+#endif
+
+    for (int note = 0; note < 2; note++) {
+        note_args(argv, kServed);
+        if (resampler_forward(kSocket, NOTE_ARGS, argv, sink, stderr, &exit_code) != 0 ||
+            exit_code != EXIT_SUCCESS) {
+            fprintf(stderr, "forwarded note %d failed\n", note); return 5;
+        }
+        if (!worldx_test_same_file(kLocal, kServed)) {
+            fprintf(stderr, "forwarded note %d differs\n", note); return 6;
+        }
+        remove(kServed);
+    }
+
+    /* errors and --help keep their exit codes */
+    char* bad[] = { "ucra-cli", "-V", "2", (char*)kWav, (char*)kServed, NULL };
+    char* help[] = { "ucra-cli", "--help", NULL };
+    if (resampler_forward(kSocket, 5, bad, sink, sink, &exit_code) != 0 || exit_code != EXIT_FAILURE) {
+        fprintf(stderr, "invalid volume not reported\n"); return 7;
+    }
+    if (resampler_forward(kSocket, 2, help, sink, sink, &exit_code) != 0 || exit_code != EXIT_SUCCESS) {
+        fprintf(stderr, "--help failed\n"); return 8;
+    }
+
+    if (resampler_request_stop(kSocket) != 0) { fprintf(stderr, "stop not acknowledged\n"); return 9; }
+    ResamplerServerStats stats;
+    resampler_server_join(server, &stats);
+    printf("%llu requests, %llu failed, cache %llu hits, %llu misses\n", (unsigned long long)stats.requests,
+           (unsigned long long)stats.failed, (unsigned long long)stats.cache_hits,
+           (unsigned long long)stats.cache_misses);
+    if (stats.requests != 4 || stats.failed != 1 || stats.cache_misses != 1 || stats.cache_hits != 1) {
+        fprintf(stderr, "unexpected counters\n"); return 10;
+    }
+
+    /* nobody listens any more: the caller falls back to rendering itself */
+    note_args(argv, kServed);
+    if (resampler_forward(kSocket, NOTE_ARGS, argv, sink, stderr, &exit_code) == 0) {
+        fprintf(stderr, "forward succeeded without a server\n"); return 11;
+    }
+
+    fclose(sink);
+    cleanup();
+    printf("resampler server test passed\n");
+    return 0;
+}
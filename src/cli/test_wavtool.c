@@ -0,0 +1,248 @@
+#include "resampler_batch.h"
+#include "wavtool.h"
+#include "wav_io.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* In-process wavtool: lengths and envelopes parse as UTAU writes them, the
+ * streaming mixer matches a whole-song overlap-add while its ring wraps,
+ * overlaps older than the ring are clamped, and a song mixed from rendered
+ * buffers matches the one mixed from note files. */
+
+static const char* kMix = "wavtool_test_mix.wav";
+static const char* kWavs[2] = { "wavtool_test_a.wav", "wavtool_test_b.wav" };
+static const char* kManifest = "wavtool_test.txt";
+static const char* kSongs[3] = { "wavtool_test_song1.wav", "wavtool_test_song4.wav", "wavtool_test_files.wav" };
+
+#define NOTES 4
+
+static void note_file(char* buf, size_t size, int i) {
+    snprintf(buf, size, "wavtool_test_note_%d.wav", i);
+}
+
+static void cleanup(void) {
+    char path[256];
+    for (int w = 0; w < 2; w++) {
+        snprintf(path, sizeof(path), "%s.worldcache", kWavs[w]);
+        remove(path);
+        remove(kWavs[w]);
+    }
+    for (int i = 0; i < NOTES; i++) {
+        note_file(path, sizeof(path), i);
+        remove(path);
+    }
+    for (int i = 0; i < 3; i++) remove(kSongs[i]);
+    remove(kMix);
+    remove(kManifest);
+}
+
+/* Largest difference between two files' samples in 16-bit steps, or -1 */
+static int max_step_diff(const char* a, const char* b) {
+    double *x = NULL, *y = NULL;
+    int nx = 0, ny = 0, fx = 0, fy = 0, diff = -1;
+    if (wav_read_mono(a, &x, &nx, &fx) == 0 && wav_read_mono(b, &y, &ny, &fy) == 0 && nx == ny && fx == fy) {
+        diff = 0;
+        for (int i = 0; i < nx; i++) {
+            int d = (int)lrint(fabs(x[i] - y[i]) * 32768.0);
+            if (d > diff) diff = d;
+        }
+    }
+    free(x);
+    free(y);
+    return diff;
+}
+
+static int check_parsing(void) {
+    double ms;
+    if (wavtool_parse_length("480@120+10", &ms, stderr) != 0 || fabs(ms - 510.0) > 1e-9) return -1;
+    if (wavtool_parse_length("240@150-12.5", &ms, stderr) != 0 || fabs(ms - 187.5) > 1e-9) return -1;
+    if (wavtool_parse_length("250.5", &ms, stderr) != 0 || ms != 250.5) return -1;
+    FILE* sink = tmpfile();
+    if (!sink) return -1;
+    int rejected = wavtool_parse_length("480@", &ms, sink) != 0 && wavtool_parse_length("x", &ms, sink) != 0 &&
+                   wavtool_parse_length("480@0", &ms, sink) != 0 && wavtool_parse_length("480@120*2", &ms, sink) != 0;
+
+    char* full[] = { "12.5", "480@120+0", "5", "35", "20", "0", "100", "80", "40", "30", "10", "15", "70" };
+    char* rest[] = { "0", "300", "0", "0" };
+    char* bad[] = { "0", "300", "5", "x" };
+    WavtoolNote note;
+    int ok = rejected && wavtool_parse_note(13, full, &note, stderr) == 0 && note.stp_ms == 12.5 &&
+             note.length_ms == 500.0 && note.p[0] == 5.0 && note.p[1] == 35.0 && note.p[2] == 20.0 &&
+             note.v[0] == 0.0 && note.v[1] == 100.0 && note.v[2] == 80.0 && note.v[3] == 40.0 &&
+             note.overlap_ms == 30.0 && note.p[3] == 10.0 && note.p[4] == 15.0 && note.v[4] == 70.0 &&
+             note.has_envelope && note.has_p5;
+    /* envelope corners: (5, 0), (40, 1), (55, .7), (470, .8), (490, .4), ramps in between */
+    ok = ok && fabs(wavtool_envelope_gain(&note, 40.0) - 1.0) < 1e-12 &&
+         fabs(wavtool_envelope_gain(&note, 47.5) - 0.85) < 1e-12 &&
+         fabs(wavtool_envelope_gain(&note, 480.0) - 0.6) < 1e-12 &&
+         fabs(wavtool_envelope_gain(&note, 495.0) - 0.2) < 1e-12 && wavtool_envelope_gain(&note, 500.0) == 0.0;
+    ok = ok && wavtool_parse_note(4, rest, &note, stderr) == 0 && note.length_ms == 300.0 && !note.has_p5 &&
+         wavtool_parse_note(4, bad, &note, sink) != 0 && wavtool_parse_note(1, rest, &note, sink) != 0;
+    fclose(sink);
+    return ok ? 0 : -1;
+}
+
+/* Mixer against a whole-buffer overlap-add: a small ring and block size so
+ * notes are longer than the ring and wrap around it */
+static int check_mixer(void) {
+    const int fs = 8000, block = 64;
+    WavtoolNote notes[4];
+    for (int i = 0; i < 4; i++) wavtool_note_init(&notes[i]);
+    notes[0].length_ms = 300.0;                               /* flat */
+    notes[1].length_ms = 250.0, notes[1].stp_ms = 10.0, notes[1].overlap_ms = 40.0;
+    notes[1].has_envelope = 1;
+    notes[1].p[0] = 0.0, notes[1].p[1] = 30.0, notes[1].p[2] = 50.0, notes[1].p[3] = 5.0;
+    notes[1].v[0] = 0.0, notes[1].v[1] = 100.0, notes[1].v[2] = 100.0, notes[1].v[3] = 50.0;
+    notes[2] = notes[1];
+    notes[2].length_ms = 180.0, notes[2].overlap_ms = 60.0, notes[2].has_p5 = 1;
+    notes[2].p[4] = 20.0, notes[2].v[4] = 60.0;
+    notes[3].length_ms = 100.0, notes[3].overlap_ms = -25.0; /* a gap before it */
+
+    const int x_length = fs / 4;
+    double* x = (double*)malloc(sizeof(double) * (size_t)x_length);
+    double* song = (double*)calloc((size_t)fs * 2, sizeof(double));
+    if (!x || !song) return -1;
+    for (int i = 0; i < x_length; i++) x[i] = 0.45 * sin(2.0 * M_PI * 330.0 * i / fs);
+
+    WavtoolMixer* mixer = NULL;
+    if (wavtool_mixer_create(kMix, fs, 2, block, 60.0, &mixer) != 0) return -1;
+    long end = 0;
+    for (int n = 0; n < 4; n++) {
+        if (wavtool_mixer_add(mixer, x, x_length, &notes[n]) != 0) return -1;
+        long start = end - lround(notes[n].overlap_ms * fs / 1000.0);
+        long length = lround(notes[n].length_ms * fs / 1000.0);
+        long stp = lround(notes[n].stp_ms * fs / 1000.0);
+        for (long k = 0; k < length; k++) {
+            double gain = wavtool_envelope_gain(&notes[n], k * 1000.0 / fs);
+            if (stp + k < x_length) song[start + k] += x[stp + k] * gain;
+        }
+        if (start + length > end) end = start + length;
+    }
+    WavtoolMixerStats stats;
+    if (wavtool_mixer_finish(mixer, &stats) != 0) return -1;
+    printf("mixer: %d notes, %llu samples, %llu bytes, %zu ring bytes\n", stats.notes,
+           (unsigned long long)stats.samples, (unsigned long long)stats.bytes_written, stats.ring_bytes);
+    if (stats.notes != 4 || stats.clamped != 0 || stats.samples != (uint64_t)end ||
+        stats.bytes_written != 44 + (uint64_t)end * 4 || stats.ring_bytes >= sizeof(double) * 1024) {
+        fprintf(stderr, "unexpected mixer counters\n");
+        return -1;
+    }
+
+    double* y = NULL;
+    int y_length = 0, y_fs = 0;
+    if (wav_read_mono(kMix, &y, &y_length, &y_fs) != 0 || y_length != end || y_fs != fs) return -1;
+    int worst = 0;
+    for (long i = 0; i < end; i++) {
+        double v = song[i] < -1.0 ? -1.0 : (song[i] > 1.0 ? 1.0 : song[i]);
+        int d = abs((int)lrint(y[i] * 32768.0) - (int)lrint(v * 32767.0));
+        if (d > worst) worst = d;
+    }
+    free(x);
+    free(y);
+    free(song);
+    if (worst > 1) {
+        fprintf(stderr, "mixed song differs from the reference by %d steps\n", worst);
+        return -1;
+    }
+
+    /* an overlap reaching back past the ring is clamped to what it holds */
+    WavtoolNote far;
+    wavtool_note_init(&far);
+    far.length_ms = 50.0, far.overlap_ms = 500.0;
+    if (wavtool_mixer_create(kMix, fs, 1, block, 60.0, &mixer) != 0 ||
+        wavtool_mixer_add(mixer, NULL, 0, &notes[0]) != 0 || wavtool_mixer_add(mixer, NULL, 0, &far) != 0 ||
+        wavtool_mixer_finish(mixer, &stats) != 0 || stats.clamped != 1 || stats.samples != 2400) {
+        fprintf(stderr, "far overlap not clamped\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Song from rendered buffers versus the file-based flow */
+static int check_song(void) {
+    if (worldx_test_write_tone(kWavs[0], 44100, 0.5, 220.0, 2) != 0 ||
+        worldx_test_write_tone(kWavs[1], 44100, 0.5, 330.0, 2) != 0) return -1;
+    FILE* f = fopen(kManifest, "w");
+    if (!f) return -1;
+    /* half volume: a resynthesized note peaks well above its source tone,
+     * and a note file clipping at full scale is not what this compares */
+    static const char* const args[NOTES] = {
+        "-p 0 -l 300 -o 20 -V 0.5", "-p 200 -l 250 -o 20 -V 0.5", "-p -300 -l 350 -o 20 -v 150 -V 0.5",
+        "-p 700 -l 200 -o 20 -V 0.5",
+    };
+    static const char* const wavtool[NOTES] = {
+        "0 300 0 5 35 0 100 100 0", "10 240 0 30 50 0 100 100 50 40 5",
+        "0 480@120-160 5 35 20 0 100 80 40 60 10 15 70", "20 150 10 20 30 0 100 100 0 80",
+    };
+    for (int i = 0; i < NOTES; i++) {
+        char out[256];
+        note_file(out, sizeof(out), i);
+        fprintf(f, "%s %s %s %s\n", args[i], kWavs[i % 2], out, wavtool[i]);
+    }
+    if (fclose(f) != 0) return -1;
+
+    FILE* sink = tmpfile();
+    ResamplerBatch batch;
+    ResamplerEngine* engine = NULL;
+    ResamplerBatchReport report;
+    WavtoolMixerStats mix[2];
+    if (!sink || resampler_batch_load(kManifest, "ucra-cli", &batch, stderr) != 0 ||
+        resampler_engine_create(RESAMPLER_CACHE_BUDGET, &engine) != 0) {
+        return -1;
+    }
+    for (int run = 0; run < 2; run++) {
+        if (resampler_batch_render_song(engine, &batch, kSongs[run], run ? 4 : 1, stderr, &report, &mix[run]) != 0 ||
+            report.rendered != NOTES || mix[run].notes != NOTES) {
+            fprintf(stderr, "song on %d threads failed\n", run ? 4 : 1);
+            return -1;
+        }
+    }
+    printf("song: %d notes, %llu samples, %.2f s of audio\n", report.notes, (unsigned long long)mix[1].samples,
+           report.audio_seconds);
+
+    /* file-based flow: a file per note, decoded again and mixed */
+    if (resampler_batch_render(engine, &batch, 2, stderr, &report) != 0) return -1;
+    WavtoolMixer* mixer = NULL;
+    if (wavtool_mixer_create(kSongs[2], 44100, 1, 512, WAVTOOL_HISTORY_MS, &mixer) != 0) return -1;
+    for (int i = 0; i < NOTES; i++) {
+        WavtoolNote note;
+        double* x = NULL;
+        int length = 0, fs = 0;
+        ResamplerBatchNote* entry = &batch.notes[i];
+        if (wavtool_parse_note(entry->wavtool_argc, entry->wavtool_argv, &note, stderr) != 0 ||
+            wav_read_mono(entry->config.out_file_path, &x, &length, &fs) != 0 ||
+            wavtool_mixer_add(mixer, x, length, &note) != 0) {
+            return -1;
+        }
+        free(x);
+    }
+    if (wavtool_mixer_finish(mixer, NULL) != 0) return -1;
+    resampler_engine_destroy(engine);
+    resampler_batch_free(&batch);
+    fclose(sink);
+
+    int threads_diff = max_step_diff(kSongs[0], kSongs[1]);
+    int files_diff = max_step_diff(kSongs[0], kSongs[2]);
+    printf("song: thread counts differ by %d steps, file-based flow by %d\n", threads_diff, files_diff);
+    /* note files round each note to 16 bits (and decode at 1/32768 what was
+     * written at 1/32767) before mixing, a step or so per overlapping note */
+    if (threads_diff != 0 || files_diff < 0 || files_diff > 3) {
+        fprintf(stderr, "songs differ\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(void) {
+    cleanup();
+    if (check_parsing() != 0) { fprintf(stderr, "parsing failed\n"); return 1; }
+    if (check_mixer() != 0) { fprintf(stderr, "mixer failed\n"); return 2; }
+    if (check_song() != 0) { fprintf(stderr, "song failed\n"); return 3; }
+    cleanup();
+    printf("wavtool test passed\n");
+    return 0;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file wavtool.c
+ * @brief In-process UTAU wavtool implementation
+ */
+
+#include "wavtool.h"
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wav_io.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define WAVTOOL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVTOOL_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WAVTOOL_NEON 1
+#endif
+
+// Envelope corners: (0, 0), up to five points and (L, 0)
+#define ENVELOPE_POINTS 7
+
+void wavtool_note_init(WavtoolNote* note) {
+    memset(note, 0, sizeof(*note));
+    for (int i = 0; i < 5; i++) note->v[i] = 100.0;
+}
+
+static int parse_number(const char* str, double* value, char** end) {
+    errno = 0;
+    *value = strtod(str, end);
+    return *end != str && errno != ERANGE && isfinite(*value) ? 0 : -1;
+}
+
+int wavtool_parse_length(const char* str, double* out_ms, FILE* err) {
+    char* end = NULL;
+    double value;
+    if (!str || parse_number(str, &value, &end) != 0) goto invalid;
+    if (*end == '\0') {
+        *out_ms = value;
+        return 0;
+    }
+
+    // TICKS@TEMPO[+-MS]
+    double tempo, correction = 0.0;
+    if (*end != '@' || parse_number(end + 1, &tempo, &end) != 0 || tempo <= 0.0) goto invalid;
+    if (*end != '\0' && ((*end != '+' && *end != '-') || parse_number(end, &correction, &end) != 0 ||
+                         *end != '\0')) {
+        goto invalid;
+    }
+    *out_ms = value * 60000.0 / (480.0 * tempo) + correction;
+    return 0;
+
+invalid:
+    fprintf(err, "Error: Invalid wavtool length '%s'\n", str ? str : "");
+    return -1;
+}
+
+int wavtool_parse_note(int argc, char* const argv[], WavtoolNote* note, FILE* err) {
+    wavtool_note_init(note);
+    if (argc < 2 || argc > 13) {
+        fprintf(err, "Error: wavtool takes stp, length and up to 11 envelope values, got %d values\n", argc);
+        return -1;
+    }
+    char* end;
+    if (parse_number(argv[0], &note->stp_ms, &end) != 0 || *end != '\0') {
+        fprintf(err, "Error: Invalid wavtool stp '%s'\n", argv[0]);
+        return -1;
+    }
+    if (wavtool_parse_length(argv[1], &note->length_ms, err) != 0) return -1;
+
+    // p1 p2 p3 v1 v2 v3 v4 ovr p4 p5 v5, as far as given
+    double* slots[11] = { &note->p[0], &note->p[1], &note->p[2], &note->v[0], &note->v[1], &note->v[2],
+                          &note->v[3], &note->overlap_ms, &note->p[3], &note->p[4], &note->v[4] };
+    for (int i = 2; i < argc; i++) {
+        if (parse_number(argv[i], slots[i - 2], &end) != 0 || *end != '\0') {
+            fprintf(err, "Error: Invalid wavtool envelope value '%s'\n", argv[i]);
+            return -1;
+        }
+    }
+    note->has_envelope = argc > 2;
+    note->has_p5 = argc > 11;
+    return 0;
+}
+
+// Corners of the envelope in ms and linear gain, times made non-decreasing within [0, L]
+static int envelope_points(const WavtoolNote* note, double t[ENVELOPE_POINTS], double g[ENVELOPE_POINTS]) {
+    double length = note->length_ms > 0.0 ? note->length_ms : 0.0;
+    const double* p = note->p;
+    const double* v = note->v;
+    int n = 0;
+    t[n] = 0.0, g[n++] = 0.0;
+    t[n] = p[0], g[n++] = v[0];
+    t[n] = p[0] + p[1], g[n++] = v[1];
+    if (note->has_p5) t[n] = p[0] + p[1] + p[4], g[n++] = v[4];
+    t[n] = length - p[3] - p[2], g[n++] = v[2];
+    t[n] = length - p[3], g[n++] = v[3];
+    t[n] = length, g[n++] = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && t[i] < t[i - 1]) t[i] = t[i - 1];
+        if (t[i] > length) t[i] = length;
+        g[i] /= 100.0;
+    }
+    return n;
+}
+
+double wavtool_envelope_gain(const WavtoolNote* note, double t_ms) {
+    if (t_ms < 0.0 || t_ms >= note->length_ms) return 0.0;
+    if (!note->has_envelope) return 1.0;
+    double t[ENVELOPE_POINTS], g[ENVELOPE_POINTS];
+    int n = envelope_points(note, t, g);
+    for (int i = n - 2; i >= 0; i--) {
+        if (t[i] <= t_ms && t_ms < t[i + 1]) {
+            return g[i] + (g[i + 1] - g[i]) * (t_ms - t[i]) / (t[i + 1] - t[i]);
+        }
+    }
+    return 0.0;
+}
+
+// dst[i] += src[i] * (g0 + step * i): one linear envelope segment
+static void mix_ramp(double* dst, const double* src, int n, double g0, double step) {
+    int i = 0;
+#if defined(WAVTOOL_AVX)
+    __m256d vg0 = _mm256_set1_pd(g0), vstep = _mm256_set1_pd(step), four = _mm256_set1_pd(4.0);
+    __m256d idx = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    for (; i + 4 <= n; i += 4) {
+        __m256d gain = _mm256_add_pd(vg0, _mm256_mul_pd(vstep, idx));
+        __m256d sum = _mm256_add_pd(_mm256_loadu_pd(dst + i), _mm256_mul_pd(_mm256_loadu_pd(src + i), gain));
+        _mm256_storeu_pd(dst + i, sum);
+        idx = _mm256_add_pd(idx, four);
+    }
+#elif defined(WAVTOOL_SSE2)
+    __m128d vg0 = _mm_set1_pd(g0), vstep = _mm_set1_pd(step), two = _mm_set1_pd(2.0);
+    __m128d idx = _mm_set_pd(1.0, 0.0);
+    for (; i + 2 <= n; i += 2) {
+        __m128d gain = _mm_add_pd(vg0, _mm_mul_pd(vstep, idx));
+        _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(dst + i), _mm_mul_pd(_mm_loadu_pd(src + i), gain)));
+        idx = _mm_add_pd(idx, two);
+    }
+#elif defined(WAVTOOL_NEON)
+    float64x2_t vg0 = vdupq_n_f64(g0), vstep = vdupq_n_f64(step), two = vdupq_n_f64(2.0);
+    float64x2_t idx = vcombine_f64(vdup_n_f64(0.0), vdup_n_f64(1.0));
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t gain = vaddq_f64(vg0, vmulq_f64(vstep, idx));
+        vst1q_f64(dst + i, vaddq_f64(vld1q_f64(dst + i), vmulq_f64(vld1q_f64(src + i), gain)));
+        idx = vaddq_f64(idx, two);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] += src[i] * (g0 + step * (double)i);
+    }
+}
+
+struct WavtoolMixer {
+    WavWriter* writer;
+    int fs;
+    int block_size;
+    int64_t capacity;  // ring samples, a multiple of block_size
+    double* ring;      // sample i of the song lives at ring[i % capacity]
+    int64_t flushed;   // samples written to the file
+    int64_t end;       // length of the song so far
+    int notes, clamped;
+    int ok;
+};
+
+int wavtool_mixer_create(const char* path, int fs, int channels, int block_size, double history_ms,
+                         WavtoolMixer** out_mixer) {
+    if (!out_mixer) return -1;
+    *out_mixer = NULL;
+    if (!path || fs <= 0 || block_size <= 0 || !(history_ms >= 0.0) || history_ms > 600000.0) return -1;
+
+    WavtoolMixer* mixer = (WavtoolMixer*)calloc(1, sizeof(WavtoolMixer));
+    if (!mixer) return -1;
+    int64_t history = (int64_t)ceil(history_ms * fs / 1000.0);
+    int64_t blocks = (history + block_size - 1) / block_size + 1;
+    if (blocks < 2) blocks = 2;
+    mixer->fs = fs;
+    mixer->block_size = block_size;
+    mixer->capacity = blocks * block_size;
+    mixer->ring = (double*)malloc(sizeof(double) * (size_t)mixer->capacity);
+    mixer->ok = 1;
+    if (!mixer->ring || wav_writer_open(path, fs, channels, &mixer->writer) != 0) {
+        free(mixer->ring);
+        free(mixer);
+        return -1;
+    }
+    *out_mixer = mixer;
+    return 0;
+}
+
+// Write the oldest block (or what is left of it at the end of the song)
+static void flush_block(WavtoolMixer* mixer) {
+    int64_t n = mixer->end - mixer->flushed;
+    if (n > mixer->block_size) n = mixer->block_size;
+    if (n <= 0) return;
+    const double* x = mixer->ring + mixer->flushed % mixer->capacity;
+    if (wav_writer_write(mixer->writer, x, (int)n) != 0) mixer->ok = 0;
+    mixer->flushed += n;
+}
+
+// Extend the song with silence up to target, streaming out what falls off the ring
+static void extend_to(WavtoolMixer* mixer, int64_t target) {
+    while (mixer->end < target) {
+        int64_t offset = mixer->end % mixer->capacity;
+        int64_t n = target - mixer->end;
+        if (n > mixer->block_size) n = mixer->block_size;
+        if (n > mixer->capacity - offset) n = mixer->capacity - offset;
+        while (mixer->end + n - mixer->flushed > mixer->capacity) flush_block(mixer);
+        memset(mixer->ring + offset, 0, sizeof(double) * (size_t)n);
+        mixer->end += n;
+    }
+}
+
+// Add src[0..n) of the note, whose first sample is sample k of the note, at dst
+static void mix_enveloped(double* dst, const double* src, int64_t k, int n, const double* s,
+                          const double* g, int points) {
+    int segment = 0;
+    for (int i = 0; i < n;) {
+        // Segment [s[j], s[j+1]) holding sample k + i
+        double pos = (double)(k + i);
+        while (segment + 2 < points && s[segment + 1] <= pos) segment++;
+        double span = s[segment + 1] - s[segment];
+        double step = span > 0.0 ? (g[segment + 1] - g[segment]) / span : 0.0;
+        double g0 = g[segment] + step * (pos - s[segment]);
+        // The last segment ends the note: nothing is mixed past its end
+        double next = ceil(s[segment + 1]) - pos;
+        if (next <= 0.0) break;
+        int run = next < n - i ? (int)next : n - i;
+        mix_ramp(dst + i, src + i, run, g0, step);
+        i += run;
+    }
+}
+
+int wavtool_mixer_add(WavtoolMixer* mixer, const double* x, int length, const WavtoolNote* note) {
+    if (!mixer || !note || (!x && length > 0)) return -1;
+
+    double scale = mixer->fs / 1000.0;
+    int64_t note_length = note->length_ms > 0.0 ? (int64_t)llround(note->length_ms * scale) : 0;
+    int64_t stp = note->stp_ms > 0.0 ? (int64_t)llround(note->stp_ms * scale) : 0;
+    int64_t start = mixer->end - (int64_t)llround(note->overlap_ms * scale);
+    if (start < mixer->flushed) {
+        // Before the start of the song is not a lack of history
+        if (mixer->flushed > 0) mixer->clamped++;
+        start = mixer->flushed;
+    }
+
+    // Envelope corners in samples; a flat envelope is one segment at full level
+    double s[ENVELOPE_POINTS], g[ENVELOPE_POINTS];
+    int points = 2;
+    if (note->has_envelope) {
+        points = envelope_points(note, s, g);
+        for (int i = 0; i < points; i++) s[i] *= scale;
+    } else {
+        s[0] = 0.0, s[1] = (double)note_length;
+        g[0] = g[1] = 1.0;
+    }
+
+    // Mixed a block at a time, never across the end of the ring
+    for (int64_t k = 0; k < note_length;) {
+        int64_t pos = start + k;
+        int64_t n = note_length - k;
+        if (n > mixer->block_size) n = mixer->block_size;
+        if (n > mixer->capacity - pos % mixer->capacity) n = mixer->capacity - pos % mixer->capacity;
+        extend_to(mixer, pos + n);
+
+        int64_t available = (int64_t)length - (stp + k);
+        if (available > n) available = n;
+        if (available > 0) {
+            mix_enveloped(mixer->ring + pos % mixer->capacity, x + stp + k, k, (int)available, s, g, points);
+        }
+        k += n;
+    }
+    mixer->notes++;
+    return mixer->ok ? 0 : -1;
+}
+
+void wavtool_mixer_stats(const WavtoolMixer* mixer, WavtoolMixerStats* out_stats) {
+    if (!mixer || !out_stats) return;
+    out_stats->notes = mixer->notes;
+    out_stats->clamped = mixer->clamped;
+    out_stats->samples = (uint64_t)mixer->end;
+    out_stats->bytes_written = wav_writer_bytes(mixer->writer);
+    out_stats->ring_bytes = sizeof(double) * (size_t)mixer->capacity;
+}
+
+int wavtool_mixer_finish(WavtoolMixer* mixer, WavtoolMixerStats* out_stats) {
+    if (!mixer) return -1;
+    while (mixer->flushed < mixer->end) flush_block(mixer);
+    wavtool_mixer_stats(mixer, out_stats);
+    int ok = wav_writer_close(mixer->writer) == 0 && mixer->ok;
+    free(mixer->ring);
+    free(mixer);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file wavtool.h
+ * @brief In-process UTAU wavtool: note envelopes and streaming overlap-add
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * UTAU and OpenUtau join the resampler's notes with a separate wavtool run
+ * per note, `wavtool <output> <input> <stp> <length> [p1 p2 p3 v1 v2 v3 v4
+ * [ovr [p4 [p5 v5]]]]`, which decodes the note file, shapes it with the
+ * envelope and mixes it into the growing output file. A WavtoolMixer does
+ * the same with rendered note buffers: each note starts `ovr` ms before the
+ * end of the song so far and is added to what is already there.
+ *
+ * Only the last stretch of the song can still change, so the mixer keeps it
+ * in a fixed ring of whole blocks and streams everything older to the
+ * output file. A note reaching back further than the ring holds is clamped
+ * to the oldest sample still held.
+ */
+#ifndef WORLDX_UCRA_WAVTOOL_H
+#define WORLDX_UCRA_WAVTOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** Default history the mixer keeps for overlaps, milliseconds */
+#define WAVTOOL_HISTORY_MS 2000.0
+
+/** Placement and envelope of one note, as wavtool's arguments give them */
+typedef struct {
+    double stp_ms;      /**< Skipped from the start of the rendered note */
+    double length_ms;   /**< Length the note occupies in the output */
+    double overlap_ms;  /**< How far the note starts before the end of the output */
+    /**
+     * Envelope times p1..p5 (ms) and levels v1..v5 (percent). The points are
+     * (0, 0), (p1, v1), (p1+p2, v2), (p1+p2+p5, v5), (L-p4-p3, v3),
+     * (L-p4, v4) and (L, 0), where L is the length; without an envelope
+     * the note is mixed at full level.
+     */
+    double p[5];
+    double v[5];
+    int has_envelope;
+    int has_p5;         /**< Whether the fifth point was given */
+} WavtoolNote;
+
+/** @brief Initialize a note with no skip, length, overlap or envelope */
+void wavtool_note_init(WavtoolNote* note);
+
+/**
+ * @brief Parse a wavtool length: milliseconds, or `TICKS@TEMPO[+-MS]`
+ *
+ * Ticks are 480 per quarter note at TEMPO beats per minute; the optional
+ * correction (the preutterance adjustment UTAU appends) is added.
+ *
+ * @return 0 on success, -1 on failure (reported to err)
+ */
+int wavtool_parse_length(const char* str, double* out_ms, FILE* err);
+
+/**
+ * @brief Parse wavtool's arguments after the input file
+ *
+ * @param argc Number of arguments: stp and length, optionally followed by
+ *             p1 p2 p3 v1 v2 v3 v4, ovr, p4, and p5 v5
+ * @return 0 on success, -1 on failure (reported to err)
+ */
+int wavtool_parse_note(int argc, char* const argv[], WavtoolNote* note, FILE* err);
+
+/**
+ * @brief Gain of the note's envelope at a time
+ * @param t_ms Time from the start of the note in the output
+ * @return Linear gain (1.0 at 100%)
+ */
+double wavtool_envelope_gain(const WavtoolNote* note, double t_ms);
+
+/** Streaming overlap-add of notes into one file */
+typedef struct WavtoolMixer WavtoolMixer;
+
+/** Counters of a mix */
+typedef struct {
+    int notes;                /**< Notes mixed */
+    int clamped;              /**< Notes reaching back further than the history */
+    uint64_t samples;         /**< Length of the output */
+    uint64_t bytes_written;   /**< Size of the output file */
+    size_t ring_bytes;        /**< Memory of the ring */
+} WavtoolMixerStats;
+
+/**
+ * @brief Create a mixer writing 16-bit PCM to path
+ *
+ * @param block_size Samples per block: notes are mixed and the output is
+ *                   written in blocks of this size
+ * @param history_ms How far back a note may start before the end of the
+ *                   output; the ring holds this much rounded up to whole
+ *                   blocks, plus one block
+ * @return 0 on success, -1 on failure
+ */
+int wavtool_mixer_create(const char* path, int fs, int channels, int block_size, double history_ms,
+                         WavtoolMixer** out_mixer);
+
+/**
+ * @brief Mix one note
+ *
+ * @param x Rendered note at the mixer's sample rate; samples past its end
+ *          are silence, so NULL with length 0 adds a rest
+ * @return 0 on success, -1 on failure (write error)
+ */
+int wavtool_mixer_add(WavtoolMixer* mixer, const double* x, int length, const WavtoolNote* note);
+
+/** @brief Counters so far */
+void wavtool_mixer_stats(const WavtoolMixer* mixer, WavtoolMixerStats* out_stats);
+
+/**
+ * @brief Write what the ring still holds, close the file and free the mixer
+ * @param out_stats Receives the final counters; may be NULL
+ * @return 0 on success, -1 if any write failed
+ */
+int wavtool_mixer_finish(WavtoolMixer* mixer, WavtoolMixerStats* out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WAVTOOL_H */
@@ -0,0 +1,311 @@
+/**
+ * @file simd_convert.c
+ * @brief Vectorized sample-format conversion implementation
+ */
+
+#include "simd_convert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_CONVERT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_CONVERT_TARGET_SSE2
+#define SIMD_CONVERT_TARGET_AVX2
+#else
+#define SIMD_CONVERT_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_CONVERT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SIMD_CONVERT_NEON 1
+#endif
+
+// Highest instruction set the conversions may use (simd_convert_set_isa)
+static WorldFlagsIsa g_isa_cap = WORLD_FLAGS_ISA_AVX2;
+
+void simd_convert_set_isa(WorldFlagsIsa isa) {
+    g_isa_cap = isa;
+}
+
+#if defined(SIMD_CONVERT_X86)
+// Kernel set for this CPU: x86 builds only assume what the compiler does by
+// default (SSE2 at most), so the wider kernels are chosen at run time
+static WorldFlagsIsa convert_isa(void) {
+    WorldFlagsIsa isa = world_flags_detect_isa();
+    return isa < g_isa_cap ? isa : g_isa_cap;
+}
+
+// Each kernel converts a prefix of the buffer and returns its length; the
+// caller finishes the rest with scalar code
+
+SIMD_CONVERT_TARGET_AVX2
+static size_t f64_to_f32_avx2(const double* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4));
+        _mm_storeu_ps(dst + i, lo);
+        _mm_storeu_ps(dst + i + 4, hi);
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_SSE2
+static size_t f64_to_f32_sse2(const double* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_AVX2
+static size_t f32_to_f64_avx2(const float* src, double* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+        _mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_SSE2
+static size_t f32_to_f64_sse2(const float* src, double* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_AVX2
+static size_t s16le_to_f64_avx2(const uint8_t* src, double* dst, size_t n) {
+    const __m256d scale = _mm256_set1_pd(1.0 / 32768.0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_cvtepi32_pd(lo), scale));
+        _mm256_storeu_pd(dst + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(hi), scale));
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_SSE2
+static size_t s16le_to_f64_sse2(const uint8_t* src, double* dst, size_t n) {
+    const __m128d scale = _mm_set1_pd(1.0 / 32768.0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_cvtepi32_pd(lo), scale));
+        _mm_storeu_pd(dst + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(lo, 0x4E)), scale));
+        _mm_storeu_pd(dst + i + 4, _mm_mul_pd(_mm_cvtepi32_pd(hi), scale));
+        _mm_storeu_pd(dst + i + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(hi, 0x4E)), scale));
+    }
+    return i;
+}
+
+// 16-byte loads cover 4 packed 24-bit samples and read 4 bytes past them,
+// hence i + 6 <= n
+
+SIMD_CONVERT_TARGET_AVX2
+static size_t s24le_to_f64_avx2(const uint8_t* src, double* dst, size_t n) {
+    const __m128i order = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256d scale = _mm256_set1_pd(1.0 / 8388608.0);
+    size_t i = 0;
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+        __m128i s = _mm_srai_epi32(_mm_shuffle_epi8(v, order), 8);
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_cvtepi32_pd(s), scale));
+    }
+    return i;
+}
+
+// SSE2 has no byte shuffle: byte shifts of the load put sample k at the
+// bottom of a lane, the lanes are interleaved, and a shift pair sign-extends
+SIMD_CONVERT_TARGET_SSE2
+static size_t s24le_to_f64_sse2(const uint8_t* src, double* dst, size_t n) {
+    const __m128d scale = _mm_set1_pd(1.0 / 8388608.0);
+    size_t i = 0;
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+        __m128i s01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));                     // bytes 0-3, 3-6
+        __m128i s23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));  // bytes 6-9, 9-12
+        __m128i s = _mm_srai_epi32(_mm_slli_epi32(_mm_unpacklo_epi64(s01, s23), 8), 8);
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_cvtepi32_pd(s), scale));
+        _mm_storeu_pd(dst + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(s, 0x4E)), scale));
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_AVX2
+static size_t f64_to_s16_avx2(const double* src, const double* dither, int16_t* dst, size_t n) {
+    const __m256d lo = _mm256_set1_pd(-1.0), hi = _mm256_set1_pd(1.0), scale = _mm256_set1_pd(32767.0);
+    const __m256d half = _mm256_set1_pd(0.5), sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i q[2];
+        for (int h = 0; h < 2; h++) {
+            // max returns its second operand for NaN
+            __m256d v = _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(src + i + 4 * h), lo), hi);
+            v = _mm256_mul_pd(v, scale);
+            if (dither) v = _mm256_add_pd(v, _mm256_loadu_pd(dither + i + 4 * h));
+            v = _mm256_add_pd(v, _mm256_or_pd(_mm256_and_pd(v, sign), half));
+            q[h] = _mm256_cvttpd_epi32(v);
+        }
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(q[0], q[1]));
+    }
+    return i;
+}
+
+SIMD_CONVERT_TARGET_SSE2
+static size_t f64_to_s16_sse2(const double* src, const double* dither, int16_t* dst, size_t n) {
+    const __m128d lo = _mm_set1_pd(-1.0), hi = _mm_set1_pd(1.0), scale = _mm_set1_pd(32767.0);
+    const __m128d half = _mm_set1_pd(0.5), sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i q[4];
+        for (int h = 0; h < 4; h++) {
+            // max returns its second operand for NaN
+            __m128d v = _mm_min_pd(_mm_max_pd(_mm_loadu_pd(src + i + 2 * h), lo), hi);
+            v = _mm_mul_pd(v, scale);
+            if (dither) v = _mm_add_pd(v, _mm_loadu_pd(dither + i + 2 * h));
+            v = _mm_add_pd(v, _mm_or_pd(_mm_and_pd(v, sign), half));
+            q[h] = _mm_cvttpd_epi32(v);
+        }
+        __m128i a = _mm_unpacklo_epi64(q[0], q[1]);
+        __m128i b = _mm_unpacklo_epi64(q[2], q[3]);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+    }
+    return i;
+}
+#endif
+
+void simd_convert_f64_to_f32(const double* src, float* dst, size_t n) {
+    size_t i = 0;
+#if defined(SIMD_CONVERT_X86)
+    WorldFlagsIsa isa = convert_isa();
+    if (isa >= WORLD_FLAGS_ISA_AVX2) i = f64_to_f32_avx2(src, dst, n);
+    else if (isa >= WORLD_FLAGS_ISA_SSE2) i = f64_to_f32_sse2(src, dst, n);
+#elif defined(SIMD_CONVERT_NEON)
+    for (; i + 4 <= n; i += 4) {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(src + i));
+        float32x2_t hi = vcvt_f32_f64(vld1q_f64(src + i + 2));
+        vst1q_f32(dst + i, vcombine_f32(lo, hi));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (float)src[i];
+    }
+}
+
+void simd_convert_f32_to_f64(const float* src, double* dst, size_t n) {
+    size_t i = 0;
+#if defined(SIMD_CONVERT_X86)
+    WorldFlagsIsa isa = convert_isa();
+    if (isa >= WORLD_FLAGS_ISA_AVX2) i = f32_to_f64_avx2(src, dst, n);
+    else if (isa >= WORLD_FLAGS_ISA_SSE2) i = f32_to_f64_sse2(src, dst, n);
+#elif defined(SIMD_CONVERT_NEON)
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(src + i);
+        vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(v)));
+        vst1q_f64(dst + i + 2, vcvt_high_f64_f32(v));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (double)src[i];
+    }
+}
+
+void simd_convert_s16le_to_f64(const uint8_t* src, double* dst, size_t n) {
+    size_t i = 0;
+#if defined(SIMD_CONVERT_X86)
+    WorldFlagsIsa isa = convert_isa();
+    if (isa >= WORLD_FLAGS_ISA_AVX2) i = s16le_to_f64_avx2(src, dst, n);
+    else if (isa >= WORLD_FLAGS_ISA_SSE2) i = s16le_to_f64_sse2(src, dst, n);
+#elif defined(SIMD_CONVERT_NEON)
+    const float64x2_t scale = vdupq_n_f64(1.0 / 32768.0);
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(src + 2 * i));
+        int32x4_t lo = vmovl_s16(vget_low_s16(v));
+        int32x4_t hi = vmovl_high_s16(v);
+        vst1q_f64(dst + i, vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(lo))), scale));
+        vst1q_f64(dst + i + 2, vmulq_f64(vcvtq_f64_s64(vmovl_high_s32(lo)), scale));
+        vst1q_f64(dst + i + 4, vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(hi))), scale));
+        vst1q_f64(dst + i + 6, vmulq_f64(vcvtq_f64_s64(vmovl_high_s32(hi)), scale));
+    }
+#endif
+    for (; i < n; i++) {
+        const uint8_t* p = src + 2 * i;
+        dst[i] = (int16_t)(uint16_t)(p[0] | (p[1] << 8)) / 32768.0;
+    }
+}
+
+void simd_convert_s24le_to_f64(const uint8_t* src, double* dst, size_t n) {
+    size_t i = 0;
+#if defined(SIMD_CONVERT_X86)
+    WorldFlagsIsa isa = convert_isa();
+    if (isa >= WORLD_FLAGS_ISA_AVX2) i = s24le_to_f64_avx2(src, dst, n);
+    else if (isa >= WORLD_FLAGS_ISA_SSE2) i = s24le_to_f64_sse2(src, dst, n);
+#elif defined(SIMD_CONVERT_NEON)
+    const float64x2_t scale = vdupq_n_f64(1.0 / 8388608.0);
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x3_t b = vld3_u8(src + 3 * i);  // byte planes of 8 samples
+        uint16x8_t low = vmovl_u8(b.val[0]);
+        uint16x8_t high = vorrq_u16(vmovl_u8(b.val[1]), vshlq_n_u16(vmovl_u8(b.val[2]), 8));
+        int32x4_t lo = vshrq_n_s32(vreinterpretq_s32_u32(vorrq_u32(vshll_n_u16(vget_low_u16(high), 16),
+                                                                    vshll_n_u16(vget_low_u16(low), 8))), 8);
+        int32x4_t hi = vshrq_n_s32(vreinterpretq_s32_u32(vorrq_u32(vshll_n_u16(vget_high_u16(high), 16),
+                                                                    vshll_n_u16(vget_high_u16(low), 8))), 8);
+        vst1q_f64(dst + i, vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(lo))), scale));
+        vst1q_f64(dst + i + 2, vmulq_f64(vcvtq_f64_s64(vmovl_high_s32(lo)), scale));
+        vst1q_f64(dst + i + 4, vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(hi))), scale));
+        vst1q_f64(dst + i + 6, vmulq_f64(vcvtq_f64_s64(vmovl_high_s32(hi)), scale));
+    }
+#endif
+    for (; i < n; i++) {
+        const uint8_t* p = src + 3 * i;
+        int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24);
+        dst[i] = (v >> 8) / 8388608.0;
+    }
+}
+
+void simd_convert_f64_to_s16(const double* src, const double* dither, int16_t* dst, size_t n) {
+    size_t i = 0;
+#if defined(SIMD_CONVERT_X86)
+    WorldFlagsIsa isa = convert_isa();
+    if (isa >= WORLD_FLAGS_ISA_AVX2) i = f64_to_s16_avx2(src, dither, dst, n);
+    else if (isa >= WORLD_FLAGS_ISA_SSE2) i = f64_to_s16_sse2(src, dither, dst, n);
+#elif defined(SIMD_CONVERT_NEON)
+    const float64x2_t lo = vdupq_n_f64(-1.0), hi = vdupq_n_f64(1.0), scale = vdupq_n_f64(32767.0);
+    const uint64x2_t half = vreinterpretq_u64_f64(vdupq_n_f64(0.5));
+    const uint64x2_t sign = vdupq_n_u64(0x8000000000000000ull);
+    for (; i + 4 <= n; i += 4) {
+        int32x2_t q[2];
+        for (int h = 0; h < 2; h++) {
+            // maxnm returns the number for NaN
+            float64x2_t v = vminnmq_f64(vmaxnmq_f64(vld1q_f64(src + i + 2 * h), lo), hi);
+            v = vmulq_f64(v, scale);
+            if (dither) v = vaddq_f64(v, vld1q_f64(dither + i + 2 * h));
+            v = vaddq_f64(v, vreinterpretq_f64_u64(vorrq_u64(vandq_u64(vreinterpretq_u64_f64(v), sign), half)));
+            q[h] = vqmovn_s64(vcvtq_s64_f64(v));
+        }
+        vst1_s16(dst + i, vqmovn_s32(vcombine_s32(q[0], q[1])));
+    }
+#endif
+    for (; i < n; i++) {
+        double v = src[i] >= -1.0 ? (src[i] <= 1.0 ? src[i] : 1.0) : -1.0;
+        v *= 32767.0;
+        if (dither) v += dither[i];
+        v = v < 0.0 ? v - 0.5 : v + 0.5;
+        long r = (long)v;
+        dst[i] = (int16_t)(r < -32768 ? -32768 : (r > 32767 ? 32767 : r));
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file simd_convert.h
+ * @brief Vectorized sample-format conversion helpers
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * Conversions between storage and compute precision, used at the boundary
+ * where float32 data is handed to WORLD (which only accepts double), and
+ * between WAV samples and the double signals WORLD reads and writes. On x86
+ * each routine picks its SSE2 or AVX2 kernel at run time
+ * (world_flags_detect_isa), so a default build still gets the wide kernels;
+ * AArch64 uses NEON, other targets scalar code. Buffers need no particular
+ * alignment.
+ */
+#ifndef WORLDX_UCRA_SIMD_CONVERT_H
+#define WORLDX_UCRA_SIMD_CONVERT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "world_flags.h"
+
+/** @brief Narrow n doubles to floats (round to nearest) */
+void simd_convert_f64_to_f32(const double* src, float* dst, size_t n);
+
+/** @brief Widen n floats to doubles (exact) */
+void simd_convert_f32_to_f64(const float* src, double* dst, size_t n);
+
+/** @brief Widen n little-endian 16-bit PCM samples to doubles in [-1, 1) (exact) */
+void simd_convert_s16le_to_f64(const uint8_t* src, double* dst, size_t n);
+
+/** @brief Widen n packed little-endian 24-bit PCM samples to doubles in [-1, 1) (exact) */
+void simd_convert_s24le_to_f64(const uint8_t* src, double* dst, size_t n);
+
+/**
+ * @brief Quantize n doubles to 16-bit PCM
+ *
+ * Each sample is clipped to [-1, 1] (NaN to -1), scaled by 32767, offset by
+ * dither[i] steps when dither is not NULL, rounded half away from zero and
+ * saturated to the int16 range.
+ */
+void simd_convert_f64_to_s16(const double* src, const double* dither, int16_t* dst, size_t n);
+
+/**
+ * @brief Cap the instruction set the x86 kernels use
+ *
+ * By default the conversions use the best set world_flags_detect_isa()
+ * reports; tests and benchmarks lower the cap to run the narrower kernels.
+ * The cap is process-wide: set it while no other thread converts.
+ */
+void simd_convert_set_isa(WorldFlagsIsa isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_SIMD_CONVERT_H */
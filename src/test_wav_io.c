@@ -0,0 +1,283 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simd_convert.h"
+#include "wav_io.h"
+
+static const char* kPath = "test_wav_io.wav";
+static const char* kPath2 = "test_wav_io_2.wav";
+
+static uint32_t rng = 12345u;
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v & 0xFFFF); put16(p + 2, v >> 16); }
+
+/* Reference decode, one sample at a time */
+static double ref_sample(const uint8_t* p, int format, int bits) {
+    if (format == 3 && bits == 32) { float v; memcpy(&v, p, 4); return v; }
+    if (format == 3) { double v; memcpy(&v, p, 8); return v; }
+    switch (bits) {
+        case 8: return (p[0] - 128) / 128.0;
+        case 16: return (int16_t)(p[0] | p[1] << 8) / 32768.0;
+        case 24: return ((int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8) / 8388608.0;
+        default: return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24) / 2147483648.0;
+    }
+}
+
+/* Reference quantizer of the writer */
+static int16_t ref_s16(double x, double dither) {
+    double v = x >= -1.0 ? (x <= 1.0 ? x : 1.0) : -1.0;
+    v = v * 32767.0 + dither;
+    long r = (long)(v < 0.0 ? v - 0.5 : v + 0.5);
+    return (int16_t)(r < -32768 ? -32768 : (r > 32767 ? 32767 : r));
+}
+
+/* A WAV with a 2-byte junk chunk before the data, so the samples start off 4-byte alignment */
+static int write_wav(const char* path, int format, int bits, int channels, const uint8_t* data,
+                     uint32_t bytes, int extensible) {
+    uint8_t header[12 + 8 + 40 + 10 + 8];
+    uint32_t fmt_size = extensible ? 40 : 16;
+    size_t used = 0;
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put32(header + 16, fmt_size);
+    memset(header + 20, 0, 40);
+    put16(header + 20, extensible ? 0xFFFE : (uint32_t)format);
+    put16(header + 22, (uint32_t)channels);
+    put32(header + 24, 8000);
+    put32(header + 28, 8000u * (uint32_t)(channels * bits / 8));
+    put16(header + 32, (uint32_t)(channels * bits / 8));
+    put16(header + 34, (uint32_t)bits);
+    if (extensible) { put16(header + 36, 22); put16(header + 44, (uint32_t)format); }
+    used = 20 + fmt_size;
+    memcpy(header + used, "junk", 4);
+    put32(header + used + 4, 2);
+    header[used + 8] = header[used + 9] = 0;
+    used += 10;
+    memcpy(header + used, "data", 4);
+    put32(header + used + 4, bytes);
+    used += 8;
+    put32(header + 4, (uint32_t)(used - 8 + bytes));
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = fwrite(header, 1, used, f) == used && fwrite(data, 1, bytes, f) == bytes;
+    return fclose(f) == 0 && ok ? 0 : -1;
+}
+
+static long read_file(const char* path, uint8_t* buf, size_t size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    long n = (long)fread(buf, 1, size, f);
+    fclose(f);
+    return n;
+}
+
+static int check_kernels_isa(WorldFlagsIsa isa) {
+    uint8_t raw[3 * 64 + 16];
+    double got[64];
+    int16_t q[64];
+    for (size_t i = 0; i < sizeof(raw); i++) raw[i] = (uint8_t)next_rand();
+    for (size_t n = 0; n <= 40; n++) {
+        simd_convert_s16le_to_f64(raw + 1, got, n);
+        for (size_t i = 0; i < n; i++) {
+            if (got[i] != ref_sample(raw + 1 + 2 * i, 1, 16)) { fprintf(stderr, "%s s16 n=%zu i=%zu\n", world_flags_isa_name(isa), n, i); return -1; }
+        }
+        simd_convert_s24le_to_f64(raw + 1, got, n);
+        for (size_t i = 0; i < n; i++) {
+            if (got[i] != ref_sample(raw + 1 + 3 * i, 1, 24)) { fprintf(stderr, "%s s24 n=%zu i=%zu\n", world_flags_isa_name(isa), n, i); return -1; }
+        }
+    }
+
+    /* Edges: exact limits, out of range, halves, NaN, and dither pushing past full scale */
+    double x[40], dither[40];
+    const double edges[] = { 0.0, 1.0, -1.0, 1.5, -1.5, NAN, 0.5 / 32767.0, -0.5 / 32767.0,
+                             1.5 / 32767.0, -2.5 / 32767.0, 1e-9, -1e-9, 0.999999, -0.999999 };
+    for (int i = 0; i < 40; i++) {
+        x[i] = i < 14 ? edges[i] : ((double)next_rand() / 4294967296.0 * 2.2 - 1.1);
+        dither[i] = (double)next_rand() / 4294967296.0 + (double)next_rand() / 4294967296.0 - 1.0;
+    }
+    for (size_t n = 0; n <= 40; n++) {
+        for (int d = 0; d < 2; d++) {
+            simd_convert_f64_to_s16(x, d ? dither : NULL, q, n);
+            for (size_t i = 0; i < n; i++) {
+                if (q[i] != ref_s16(x[i], d ? dither[i] : 0.0)) {
+                    fprintf(stderr, "%s s16 out n=%zu i=%zu dither=%d: %d vs %d\n", world_flags_isa_name(isa), n, i, d,
+                            q[i], ref_s16(x[i], d ? dither[i] : 0.0));
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* Every kernel set this CPU has agrees with the scalar reference */
+static int check_kernels(void) {
+    int result = 0;
+    for (int isa = WORLD_FLAGS_ISA_SCALAR; result == 0 && isa <= (int)world_flags_detect_isa(); isa++) {
+        simd_convert_set_isa((WorldFlagsIsa)isa);
+        result = check_kernels_isa((WorldFlagsIsa)isa);
+    }
+    simd_convert_set_isa(WORLD_FLAGS_ISA_AVX2);
+    return result;
+}
+
+/* Every supported format and a few channel counts, averaged down as the reference does */
+static int check_reader(void) {
+    const int formats[][2] = { { 1, 8 }, { 1, 16 }, { 1, 24 }, { 1, 32 }, { 3, 32 }, { 3, 64 } };
+    const int frames = 2500;
+    uint8_t* data = malloc((size_t)frames * 3 * 8);
+    if (!data) return -1;
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        int format = formats[f][0], bits = formats[f][1], bytes = bits / 8;
+        for (int channels = 1; channels <= 3; channels++) {
+            size_t n = (size_t)frames * (size_t)channels;
+            for (size_t i = 0; i < n; i++) {
+                uint8_t* p = data + i * (size_t)bytes;
+                double v = (double)next_rand() / 4294967296.0 * 2.0 - 1.0;
+                if (format == 3 && bits == 32) { float s = (float)v; memcpy(p, &s, 4); }
+                else if (format == 3) memcpy(p, &v, 8);
+                else for (int b = 0; b < bytes; b++) p[b] = (uint8_t)next_rand();
+            }
+            double* x = NULL;
+            int length = 0, fs = 0;
+            if (write_wav(kPath, format, bits, channels, data, (uint32_t)(n * (size_t)bytes), channels == 2) != 0 ||
+                wav_read_mono(kPath, &x, &length, &fs) != 0) {
+                fprintf(stderr, "read failed: format %d/%d, %d channels\n", format, bits, channels);
+                free(data);
+                return -1;
+            }
+            int bad = length != frames || fs != 8000;
+            for (int i = 0; !bad && i < frames; i++) {
+                double sum = 0.0;
+                for (int c = 0; c < channels; c++) {
+                    sum += ref_sample(data + ((size_t)i * (size_t)channels + (size_t)c) * (size_t)bytes, format, bits);
+                }
+                bad = x[i] != sum / channels;
+            }
+            free(x);
+            if (bad) {
+                fprintf(stderr, "mismatch: format %d/%d, %d channels\n", format, bits, channels);
+                free(data);
+                return -1;
+            }
+        }
+    }
+
+    /* A data chunk claiming more than the file holds keeps the whole frames present */
+    double* x = NULL;
+    int length = 0, fs = 0;
+    if (write_wav(kPath, 1, 16, 1, data, 1001, 0) != 0) { free(data); return -1; }
+    FILE* f = fopen(kPath, "r+b");
+    uint8_t size[4];
+    put32(size, 4000);
+    int patched = f && fseek(f, 12 + 24 + 10 + 4, SEEK_SET) == 0 && fwrite(size, 1, 4, f) == 4;
+    if (f) fclose(f);
+    if (!patched || wav_read_mono(kPath, &x, &length, &fs) != 0 || length != 500) {
+        fprintf(stderr, "truncated data chunk: %d samples\n", length);
+        free(x);
+        free(data);
+        return -1;
+    }
+    free(x);
+    free(data);
+    return 0;
+}
+
+static int check_writer(void) {
+    enum { N = 3000, SIZE = 44 + 2 * 2 * N };
+    static double x[N];
+    static uint8_t plain[SIZE + 1], dithered[SIZE + 1], again[SIZE + 1];
+    for (int i = 0; i < N; i++) x[i] = 0.8 * sin(i * 0.031) + (i % 97 == 0 ? 1.3 : 0.0);
+    x[7] = NAN;
+
+    /* Plain output matches the reference quantizer on both channels */
+    if (wav_write_pcm16(kPath, x, N, 8000, 2) != 0 || read_file(kPath, plain, SIZE + 1) != SIZE) {
+        fprintf(stderr, "plain write failed\n");
+        return -1;
+    }
+    for (int i = 0; i < N; i++) {
+        int16_t want = ref_s16(x[i], 0.0);
+        for (int c = 0; c < 2; c++) {
+            const uint8_t* p = plain + 44 + 4 * i + 2 * c;
+            if ((int16_t)(p[0] | p[1] << 8) != want) { fprintf(stderr, "sample %d channel %d\n", i, c); return -1; }
+        }
+    }
+
+    /* Dithered output is reproducible, within one step of the plain one, and not equal to it;
+       space reserved beyond what is written is given back */
+    for (int pass = 0; pass < 2; pass++) {
+        WavWriter* writer = NULL;
+        if (wav_writer_open(pass ? kPath2 : kPath, 8000, 2, &writer) != 0 ||
+            wav_writer_reserve(writer, 2 * N) != 0) {
+            fprintf(stderr, "dither open failed\n");
+            return -1;
+        }
+        wav_writer_set_dither(writer, 7);
+        int ok = wav_writer_write(writer, x, N / 3) == 0 && wav_writer_write(writer, x + N / 3, N - N / 3) == 0;
+        if (wav_writer_close(writer) != 0 || !ok ||
+            read_file(pass ? kPath2 : kPath, pass ? again : dithered, SIZE + 1) != SIZE) {
+            fprintf(stderr, "dither write failed\n");
+            return -1;
+        }
+    }
+    if (memcmp(dithered, again, SIZE) != 0 || memcmp(dithered, plain, 44) != 0) {
+        fprintf(stderr, "dither not reproducible\n");
+        return -1;
+    }
+    int changed = 0;
+    for (int i = 44; i < SIZE; i += 2) {
+        int a = (int16_t)(plain[i] | plain[i + 1] << 8), b = (int16_t)(dithered[i] | dithered[i + 1] << 8);
+        if (abs(a - b) > 1) { fprintf(stderr, "dither moved byte %d by %d\n", i, a - b); return -1; }
+        changed += a != b;
+    }
+    if (changed == 0) { fprintf(stderr, "dither had no effect\n"); return -1; }
+    printf("dither changed %d of %d samples\n", changed, 2 * N);
+    return 0;
+}
+
+/* A tone survives rate conversion up, down and by a non-integer ratio */
+static int check_resample(void) {
+    const int rates[][2] = { { 22050, 44100 }, { 48000, 44100 }, { 44100, 22050 }, { 44100, 8000 } };
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        int fs_in = rates[r][0], fs_out = rates[r][1], n = fs_in / 2;
+        double* x = malloc(sizeof(double) * (size_t)n);
+        if (!x) return -1;
+        for (int i = 0; i < n; i++) x[i] = 0.5 * sin(2.0 * M_PI * 440.0 * i / fs_in);
+        double* y = NULL;
+        int length = 0;
+        if (wav_resample(x, n, fs_in, fs_out, &y, &length) != 0 || length != fs_out / 2) {
+            fprintf(stderr, "resample %d -> %d: %d samples\n", fs_in, fs_out, length);
+            free(x);
+            free(y);
+            return -1;
+        }
+        double worst = 0.0;
+        for (int i = length / 10; i < length - length / 10; i++) {
+            double d = fabs(y[i] - 0.5 * sin(2.0 * M_PI * 440.0 * i / fs_out));
+            if (d > worst) worst = d;
+        }
+        printf("resample %5d -> %5d: max error %.2e\n", fs_in, fs_out, worst);
+        free(x);
+        free(y);
+        if (worst > 1e-3) return -1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = check_kernels() != 0 || check_reader() != 0 || check_writer() != 0 || check_resample() != 0;
+    remove(kPath);
+    remove(kPath2);
+    if (failed) return 1;
+    printf("wav_io OK\n");
+    return 0;
+}
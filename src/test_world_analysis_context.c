@@ -0,0 +1,151 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "worldx_alloc_count.h"
+#include "world/harvest.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static void make_tone(double* x, int n, int fs, double f0) {
+    for (int i = 0; i < n; i++) {
+        x[i] = 0.0;
+        for (int h = 1; h <= 8; h++) x[i] += 0.2 * sin(2.0 * M_PI * h * f0 * i / fs) / h;
+    }
+}
+
+/* Rows of a that differ from b in any bit */
+static int rows_differing(double** a, double** b, int frames, int bins) {
+    int rows = 0;
+    for (int i = 0; i < frames; i++) {
+        if (memcmp(a[i], b[i], sizeof(double) * (size_t)bins) != 0) rows++;
+    }
+    return rows;
+}
+
+/* Once warm, a context analysis allocates no more than WORLD's F0
+ * estimator does on its own: the envelope and aperiodicity stages run on
+ * the context's plans and buffers */
+static int check_steady_state(WorldAnalysisContext* ctx, const double* x, int n, int fs,
+                              WorldAnalysisData* reused, WorldAnalysisData* reused_f32) {
+    if (!WORLDX_ALLOC_COUNT_AVAILABLE) {
+        printf("steady-state allocation check skipped (no allocator interposition)\n");
+        return 0;
+    }
+    WorldAnalysisOptions options;
+    world_analysis_options_init(&options);
+    HarvestOption harvest_option;
+    InitializeHarvestOption(&harvest_option);
+    harvest_option.frame_period = options.frame_period;
+    harvest_option.f0_floor = options.f0_floor;
+    harvest_option.f0_ceil = options.f0_ceil;
+    int frames = GetSamplesForHarvest(fs, n, options.frame_period);
+    double* positions = malloc(sizeof(double) * 2 * (size_t)frames);
+    if (!positions) return 1;
+
+    long before = worldx_alloc_count();
+    Harvest(x, n, fs, &harvest_option, positions, positions + frames);
+    long harvest_allocs = worldx_alloc_count() - before;
+    free(positions);
+
+    before = worldx_alloc_count();
+    int failed = world_analysis_context_analyze(ctx, x, n, reused) != 0;
+    long ctx_allocs = worldx_alloc_count() - before;
+    before = worldx_alloc_count();
+    failed |= world_analysis_context_analyze(ctx, x, n, reused_f32) != 0;
+    long ctx_f32_allocs = worldx_alloc_count() - before;
+
+    WorldAnalysisData fresh;
+    world_analysis_data_init(&fresh);
+    before = worldx_alloc_count();
+    failed |= world_analyze(x, n, fs, NULL, &fresh) != 0;
+    long fresh_allocs = worldx_alloc_count() - before;
+    world_analysis_data_free(&fresh);
+
+    printf("allocations: F0 estimation %ld, context %ld (float32 %ld), world_analyze %ld\n",
+           harvest_allocs, ctx_allocs, ctx_f32_allocs, fresh_allocs);
+    if (failed) return 2;
+    if (ctx_allocs > harvest_allocs || ctx_f32_allocs > harvest_allocs) return 3;
+    return 0;
+}
+
+int main(void) {
+    const int fs = 44100;
+    /* longest first: later files must fit into the grown buffers */
+    const double seconds[] = { 0.6, 0.3, 0.45, 0.2 };
+    const double f0s[] = { 220.0, 180.0, 330.0, 260.0 };
+    int max_n = (int)(seconds[0] * fs);
+    double* x = malloc(sizeof(double) * max_n);
+    if (!x) { perror("alloc"); return 1; }
+
+    WorldAnalysisContext* ctx = NULL;
+    if (world_analysis_context_create(&ctx, fs, NULL) != 0) {
+        fprintf(stderr, "context create failed\n"); return 2;
+    }
+
+    WorldAnalysisData reused, reused_f32;
+    world_analysis_data_init(&reused);
+    world_analysis_data_init(&reused_f32);
+    reused_f32.precision = WORLD_PRECISION_FLOAT32;
+    double* f0_buffer = NULL;
+    void* sp_slab = NULL;
+    void* sp_f32_slab = NULL;
+
+    for (size_t k = 0; k < sizeof(seconds) / sizeof(seconds[0]); k++) {
+        int n = (int)(seconds[k] * fs);
+        make_tone(x, n, fs, f0s[k]);
+
+        WorldAnalysisData fresh;
+        world_analysis_data_init(&fresh);
+        if (world_analyze(x, n, fs, NULL, &fresh) != 0 ||
+            world_analysis_context_analyze(ctx, x, n, &reused) != 0 ||
+            world_analysis_context_analyze(ctx, x, n, &reused_f32) != 0) {
+            fprintf(stderr, "analysis failed\n"); return 3;
+        }
+
+        if (reused.f0_length != fresh.f0_length || reused.fft_size != fresh.fft_size ||
+            reused_f32.f0_length != fresh.f0_length ||
+            world_analysis_context_fft_size(ctx) != fresh.fft_size) {
+            fprintf(stderr, "dimension mismatch\n"); return 4;
+        }
+        for (int i = 0; i < fresh.f0_length; i++) {
+            if (reused.f0[i] != fresh.f0[i] || reused_f32.f0[i] != fresh.f0[i]) {
+                fprintf(stderr, "F0 mismatch at frame %d\n", i); return 5;
+            }
+        }
+        /* same frames, same noise seeds: bit-identical */
+        int bins = fresh.fft_size / 2 + 1;
+        int dsp = rows_differing(fresh.spectrogram, reused.spectrogram, fresh.f0_length, bins);
+        int dap = rows_differing(fresh.aperiodicity, reused.aperiodicity, fresh.f0_length, bins);
+        printf("file %zu: %d frames, differing rows sp %d ap %d\n", k, fresh.f0_length, dsp, dap);
+        if (dsp != 0 || dap != 0) {
+            fprintf(stderr, "context result diverges\n"); return 6;
+        }
+
+        /* after the first (longest) file no buffer may move */
+        if (k == 0) {
+            f0_buffer = reused.f0;
+            sp_slab = reused.spectrogram_slab;
+            sp_f32_slab = reused_f32.spectrogram_slab;
+        } else if (reused.f0 != f0_buffer || reused.spectrogram_slab != sp_slab ||
+                   reused_f32.spectrogram_slab != sp_f32_slab) {
+            fprintf(stderr, "buffers reallocated for a shorter file\n"); return 7;
+        }
+        world_analysis_data_free(&fresh);
+    }
+
+    int n = (int)(seconds[1] * fs);
+    make_tone(x, n, fs, f0s[1]);
+    int step = check_steady_state(ctx, x, n, fs, &reused, &reused_f32);
+    if (step != 0) { fprintf(stderr, "steady-state analysis allocates (%d)\n", step); return 8; }
+
+    world_analysis_data_free(&reused);
+    world_analysis_data_free(&reused_f32);
+    world_analysis_context_destroy(ctx);
+    free(x);
+    printf("world analysis context test passed\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "world_synth_stream.h"
+#include "world_quality.h"
+#include "world/codec.h"
+
+/* Lazy decoding into the stream must match a full up-front decode this closely */
+#define MIN_LAZY_SNR_DB 60.0
+
+int main(void) {
+    WorldAnalysisData data;
+    world_analysis_data_init(&data);
+    if (world_generate_dummy_data(&data, 2.0, 44100, 5.0, 220.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+    int frames = data.f0_length;
+    int bins = data.fft_size / 2 + 1;
+
+    /* keep the original envelope to report MCD */
+    double** orig_sp = malloc(sizeof(double*) * frames);
+    double* orig_slab = malloc(sizeof(double) * (size_t)frames * bins);
+    if (!orig_sp || !orig_slab) { perror("alloc"); return 2; }
+    for (int i = 0; i < frames; i++) {
+        orig_sp[i] = orig_slab + (size_t)i * bins;
+        for (int j = 0; j < bins; j++) orig_sp[i][j] = data.spectrogram[i][j];
+    }
+
+    if (world_analysis_data_encode(&data, 0) != 0 || !world_analysis_data_is_coded(&data)) {
+        fprintf(stderr, "encode failed\n"); return 3;
+    }
+    if (data.spectrogram || data.aperiodicity || data.coded_sp_dims != WORLD_CODED_SP_DIMS_DEFAULT) {
+        fprintf(stderr, "full matrices still resident\n"); return 4;
+    }
+
+    if (data.coded_ap_dims != GetNumberOfAperiodicities(data.sample_rate)) {
+        fprintf(stderr, "unexpected band count %d\n", data.coded_ap_dims); return 5;
+    }
+    size_t full_bytes = 2 * (size_t)frames * bins * sizeof(double);
+    size_t coded_bytes = (size_t)frames * (data.coded_sp_dims + data.coded_ap_dims) * sizeof(double);
+    printf("sp+ap bytes: full %zu, coded %zu\n", full_bytes, coded_bytes);
+
+    /* reference: decode everything up front and synthesize through the stream */
+    WorldAnalysisData full;
+    world_analysis_data_init(&full);
+    if (world_analysis_data_allocate(&full, frames, data.fft_size) != 0) {
+        fprintf(stderr, "allocate failed\n"); return 6;
+    }
+    full.frame_period = data.frame_period;
+    full.sample_rate = data.sample_rate;
+    full.x_length = data.x_length;
+    for (int i = 0; i < frames; i++) full.f0[i] = data.f0[i];
+    DecodeSpectralEnvelope((const double* const*)data.coded_spectrogram, frames, data.sample_rate,
+                           data.fft_size, data.coded_sp_dims, full.spectrogram);
+    DecodeAperiodicity((const double* const*)data.coded_aperiodicity, frames, data.sample_rate,
+                       data.fft_size, full.aperiodicity);
+
+    /* a ranged decode matches WORLD's whole-matrix decode */
+    double* row_slab = malloc(sizeof(double) * 2 * (size_t)bins * 7);
+    double* sp_rows[7];
+    double* ap_rows[7];
+    if (!row_slab) { perror("alloc"); return 7; }
+    for (int i = 0; i < 7; i++) {
+        sp_rows[i] = row_slab + (size_t)i * bins;
+        ap_rows[i] = row_slab + (size_t)(7 + i) * bins;
+    }
+    if (world_analysis_data_get_frames(&data, 100, 7, sp_rows, ap_rows) != 0) {
+        fprintf(stderr, "ranged decode failed\n"); return 11;
+    }
+    for (int i = 0; i < 7; i++) {
+        for (int j = 0; j < bins; j++) {
+            if (sp_rows[i][j] != full.spectrogram[100 + i][j] ||
+                ap_rows[i][j] != full.aperiodicity[100 + i][j]) {
+                fprintf(stderr, "ranged decode differs at frame %d bin %d\n", 100 + i, j); return 12;
+            }
+        }
+    }
+    free(row_slab);
+
+    int n = data.x_length;
+    double* ref = malloc(sizeof(double) * n);
+    double* y = malloc(sizeof(double) * n);
+    if (!ref || !y) { perror("alloc"); return 7; }
+    if (world_synthesize_streamed(&full, ref, n, 512) != 0 || world_synthesize(&data, y, n) != 0) {
+        fprintf(stderr, "synthesis failed\n"); return 8;
+    }
+
+    double snr = world_quality_snr_db(ref, y, n);
+    double mcd = world_quality_mcd_db((const double* const*)orig_sp,
+                                      (const double* const*)full.spectrogram,
+                                      frames, data.fft_size, data.sample_rate);
+    printf("lazy decode vs full decode: SNR %.2f dB; coding MCD %.4f dB\n", snr, mcd);
+    if (snr < MIN_LAZY_SNR_DB) { fprintf(stderr, "lazy decode diverges\n"); return 9; }
+    if (!(mcd >= 0.0 && mcd <= WORLD_QUALITY_MAX_MCD_DB)) {
+        fprintf(stderr, "coding MCD above %.1f dB\n", WORLD_QUALITY_MAX_MCD_DB); return 10;
+    }
+
+    free(ref);
+    free(y);
+    free(orig_sp);
+    free(orig_slab);
+    world_analysis_data_free(&full);
+    world_analysis_data_free(&data);
+    printf("world coded test passed\n");
+    return 0;
+}
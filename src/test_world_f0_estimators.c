@@ -0,0 +1,74 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Every estimator must track a clean harmonic tone this closely */
+#define MAX_F0_RMSE_CENTS 50.0
+#define MIN_VOICED_RATIO 0.9
+
+static double true_f0(double t) { return 220.0 * (1.0 + 0.03 * sin(2.0 * M_PI * 5.0 * t)); }
+
+int main(void) {
+    const int fs = 44100;
+    const int n = 2 * fs;
+    double* x = malloc(sizeof(double) * n);
+    if (!x) { perror("alloc"); return 1; }
+    double phase = 0.0;
+    for (int i = 0; i < n; i++) {
+        double f0 = true_f0((double)i / fs);
+        x[i] = 0.0;
+        for (int h = 1; h <= 10; h++) x[i] += 0.2 * sin(h * phase) / h;
+        phase += 2.0 * M_PI * f0 / fs;
+    }
+
+    const WorldF0Estimator estimators[] = {
+        WORLD_F0_HARVEST, WORLD_F0_DIO_STONEMASK, WORLD_F0_HARVEST_DECIMATED
+    };
+    int frames = -1;
+    for (size_t e = 0; e < sizeof(estimators) / sizeof(estimators[0]); e++) {
+        WorldAnalysisOptions options;
+        world_analysis_options_init(&options);
+        options.f0_estimator = estimators[e];
+
+        WorldAnalysisData data;
+        world_analysis_data_init(&data);
+        if (world_analyze(x, n, fs, &options, &data) != 0) {
+            fprintf(stderr, "analysis failed (estimator %d)\n", (int)estimators[e]); return 2;
+        }
+        if (data.f0_estimator != estimators[e]) {
+            fprintf(stderr, "estimator not recorded\n"); return 3;
+        }
+        if (frames >= 0 && data.f0_length != frames) {
+            fprintf(stderr, "frame count differs between estimators\n"); return 4;
+        }
+        frames = data.f0_length;
+
+        /* skip the edges, where estimators legitimately disagree */
+        double sum = 0.0;
+        int voiced = 0, counted = 0;
+        for (int i = frames / 10; i < frames - frames / 10; i++) {
+            counted++;
+            if (data.f0[i] <= 0.0) continue;
+            double cents = 1200.0 * log2(data.f0[i] / true_f0(data.temporal_positions[i]));
+            sum += cents * cents;
+            voiced++;
+        }
+        double rmse = voiced ? sqrt(sum / voiced) : INFINITY;
+        double ratio = (double)voiced / counted;
+        printf("estimator %d: F0 RMSE %.2f cents, voiced %.1f%%\n", (int)estimators[e], rmse,
+               100.0 * ratio);
+        if (rmse > MAX_F0_RMSE_CENTS || ratio < MIN_VOICED_RATIO) {
+            fprintf(stderr, "F0 estimate off\n"); return 5;
+        }
+        world_analysis_data_free(&data);
+    }
+
+    free(x);
+    printf("world F0 estimator test passed\n");
+    return 0;
+}
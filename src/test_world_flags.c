@@ -0,0 +1,86 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "world_flags.h"
+
+/* Fused kernels may only differ from the reference by rounding */
+#define MAX_REL_DIFF 1e-9
+
+static double max_rel_diff(const double* a, const double* b, int n) {
+    double worst = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = fabs(a[i] - b[i]) / (fabs(b[i]) + 1e-30);
+        if (d > worst) worst = d;
+    }
+    return worst;
+}
+
+int main(void) {
+    WorldAnalysisData src;
+    world_analysis_data_init(&src);
+    if (world_generate_dummy_data(&src, 0.5, 44100, 5.0, 220.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+    int bins = src.fft_size / 2 + 1;
+    double* sp = malloc(sizeof(double) * bins);
+    double* ap = malloc(sizeof(double) * bins);
+    double* ref_sp = malloc(sizeof(double) * bins);
+    double* ref_ap = malloc(sizeof(double) * bins);
+    if (!sp || !ap || !ref_sp || !ref_ap) { perror("alloc"); return 2; }
+
+    /* gender, brightness, breathiness, tilt */
+    const WorldFlagParams cases[] = {
+        { 0.0, 0.0, 0.0, 0.0 },
+        { 40.0, 0.0, 0.0, 0.0 },
+        { -60.0, 0.0, 0.0, 0.0 },
+        { 0.0, 50.0, 0.0, 0.0 },
+        { 0.0, 0.0, 70.0, 0.0 },
+        { 0.0, 0.0, -30.0, 0.0 },
+        { 0.0, 0.0, 0.0, -3.0 },
+        { 25.0, -40.0, 20.0, 1.5 },
+    };
+    WorldFlagsIsa best = world_flags_detect_isa();
+    printf("best ISA: %s\n", world_flags_isa_name(best));
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        WorldFlagPipeline* pipeline = NULL;
+        if (world_flag_pipeline_create(&pipeline, &cases[c], src.sample_rate, src.fft_size) != 0) {
+            fprintf(stderr, "pipeline create failed\n"); return 3;
+        }
+        for (int isa = WORLD_FLAGS_ISA_SCALAR; isa <= (int)best; isa++) {
+            if (world_flag_pipeline_set_isa(pipeline, (WorldFlagsIsa)isa) != 0) {
+                fprintf(stderr, "ISA %d rejected\n", isa); return 4;
+            }
+            double worst = 0.0;
+            for (int i = 0; i < src.f0_length; i += 7) {
+                memcpy(sp, src.spectrogram[i], sizeof(double) * bins);
+                memcpy(ap, src.aperiodicity[i], sizeof(double) * bins);
+                memcpy(ref_sp, sp, sizeof(double) * bins);
+                memcpy(ref_ap, ap, sizeof(double) * bins);
+                world_flag_pipeline_apply_frame(pipeline, sp, ap);
+                world_flags_apply_reference(&cases[c], src.sample_rate, src.fft_size, ref_sp, ref_ap);
+                double d = max_rel_diff(sp, ref_sp, bins);
+                if (d > worst) worst = d;
+                d = max_rel_diff(ap, ref_ap, bins);
+                if (d > worst) worst = d;
+                if (c == 0 && (memcmp(sp, src.spectrogram[i], sizeof(double) * bins) != 0 ||
+                               memcmp(ap, src.aperiodicity[i], sizeof(double) * bins) != 0)) {
+                    fprintf(stderr, "neutral flags changed the frame\n"); return 5;
+                }
+            }
+            printf("case %zu %-6s max rel diff %.3g\n", c, world_flags_isa_name((WorldFlagsIsa)isa), worst);
+            if (worst > MAX_REL_DIFF) { fprintf(stderr, "kernel diverges from reference\n"); return 6; }
+        }
+        world_flag_pipeline_destroy(pipeline);
+    }
+
+    free(sp);
+    free(ap);
+    free(ref_sp);
+    free(ref_ap);
+    world_analysis_data_free(&src);
+    printf("world flags test passed\n");
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "world_quality.h"
+
+int main(void) {
+    WorldAnalysisData ref, f32;
+    world_analysis_data_init(&ref);
+    world_analysis_data_init(&f32);
+    f32.precision = WORLD_PRECISION_FLOAT32;
+
+    if (world_generate_dummy_data(&ref, 2.0, 44100, 5.0, 220.0) != 0 ||
+        world_generate_dummy_data(&f32, 2.0, 44100, 5.0, 220.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+    if (f32.precision != WORLD_PRECISION_FLOAT32 || !f32.spectrogram_f32 || f32.spectrogram) {
+        fprintf(stderr, "float32 storage not selected\n"); return 2;
+    }
+
+    size_t values = 2 * (size_t)ref.f0_length * (size_t)(ref.fft_size / 2 + 1);
+    printf("sp+ap bytes: double %zu, float32 %zu\n", values * sizeof(double), values * sizeof(float));
+
+    int n = ref.x_length;
+    double* y_ref = malloc(sizeof(double) * n);
+    double* y_f32 = malloc(sizeof(double) * n);
+    if (!y_ref || !y_f32) { perror("alloc"); return 3; }
+    if (world_synthesize(&ref, y_ref, n) != 0 || world_synthesize(&f32, y_f32, n) != 0) {
+        fprintf(stderr, "synthesis failed\n"); return 4;
+    }
+
+    double snr = world_quality_snr_db(y_ref, y_f32, n);
+
+    /* widen back to compare envelopes */
+    if (world_analysis_data_convert(&f32, WORLD_PRECISION_DOUBLE) != 0) {
+        fprintf(stderr, "convert failed\n"); return 5;
+    }
+    double mcd = world_quality_mcd_db((const double* const*)ref.spectrogram,
+                                      (const double* const*)f32.spectrogram,
+                                      ref.f0_length, ref.fft_size, ref.sample_rate);
+    printf("float32 round trip: SNR %.2f dB, MCD %.4f dB\n", snr, mcd);
+
+    if (snr < WORLD_QUALITY_MIN_SNR_DB) { fprintf(stderr, "SNR below threshold\n"); return 6; }
+    if (mcd < 0.0 || mcd > WORLD_QUALITY_MAX_MCD_DB) { fprintf(stderr, "MCD above threshold\n"); return 7; }
+
+    free(y_ref);
+    free(y_f32);
+    world_analysis_data_free(&ref);
+    world_analysis_data_free(&f32);
+    printf("world precision test passed\n");
+    return 0;
+}
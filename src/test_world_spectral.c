@@ -0,0 +1,296 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_spectral.h"
+
+#include "world/cheaptrick.h"
+#include "world/d4c.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* world_spectral_analyze() against WORLD's CheapTrick() and D4C() on sung
+ * vowels (a glottal pulse train through three formants, with vibrato and
+ * breath noise) and a fricative, at 44.1, 48 and 22.05 kHz, quantized to
+ * 16 bits as read from a WAV file.
+ *
+ * The two differ only in the sequence of the safeguard noise: about 1e-12
+ * added to every windowed sample, and up to 6 * 2.2e-16 to every smoothed
+ * power bin. The second is what shows where the envelope nears the 16-bit
+ * floor, so the envelope must agree to MAX_LOG_SP_DIFF (natural log) where
+ * it is above SP_FLOOR and to MAX_LOG_SP_DIFF_NEAR_FLOOR below it. The
+ * aperiodicity must agree to MAX_AP_DIFF and every voiced/unvoiced decision
+ * exactly.
+ *
+ * Two inputs WORLD does not handle are defined here instead:
+ * - F0 above fs / 4 makes WORLD read past its spectra; such frames must
+ *   match WORLD run at fs / 4.
+ * - Below 15.8 kHz, D4C's voiced/unvoiced decision reads its 7.9 kHz
+ *   boundary past Nyquist, from bins WORLD never writes. The boundary stops
+ *   at Nyquist, so at 11.025 kHz a vowel is voiced and white noise is
+ *   mostly not.
+ */
+#define MAX_LOG_SP_DIFF 1e-4
+#define SP_FLOOR 1e-9
+#define MAX_LOG_SP_DIFF_NEAR_FLOOR 1e-2
+#define MAX_AP_DIFF 1e-5
+#define FRAME_PERIOD_MS 5.0
+
+typedef struct {
+    int fs;
+    int n;
+    int frames;
+    double* x;
+    double* f0;
+    double* positions;
+} Recording;
+
+/* Two-pole resonator at a formant frequency and bandwidth */
+typedef struct {
+    double a1, a2, gain, y1, y2;
+} Formant;
+
+static void formant_init(Formant* f, double freq, double bandwidth, int fs) {
+    double r = exp(-M_PI * bandwidth / fs);
+    f->a1 = 2.0 * r * cos(2.0 * M_PI * freq / fs);
+    f->a2 = -r * r;
+    f->gain = 1.0 - r;
+    f->y1 = f->y2 = 0.0;
+}
+
+static double formant_run(Formant* f, double in) {
+    double y = f->gain * in + f->a1 * f->y1 + f->a2 * f->y2;
+    f->y2 = f->y1;
+    f->y1 = y;
+    return y;
+}
+
+static double uniform(unsigned int* seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return (double)(*seed >> 8) / 16777216.0 - 0.5;
+}
+
+/* Vowel F0 at time t: a glide from 150 to 330 Hz with a 5.5 Hz vibrato */
+static double vowel_f0(double t, double seconds) {
+    return (150.0 + 180.0 * t / seconds) * (1.0 + 0.02 * sin(2.0 * M_PI * 5.5 * t));
+}
+
+/* 1 s: vowel, a fricative from 0.40 to 0.55 s, vowel. Fricative frames get
+ * F0 0 and 200 Hz by turns, so D4C's own decision is exercised too. */
+static int record(Recording* r, int fs, int noise_only) {
+    const double seconds = 1.0;
+    r->fs = fs;
+    r->n = (int)(seconds * fs);
+    r->frames = (int)(1000.0 * r->n / fs / FRAME_PERIOD_MS) + 1;
+    r->x = malloc(sizeof(double) * r->n);
+    r->f0 = malloc(sizeof(double) * r->frames);
+    r->positions = malloc(sizeof(double) * r->frames);
+    if (!r->x || !r->f0 || !r->positions) return -1;
+
+    Formant formants[3];
+    formant_init(&formants[0], 700.0, 80.0, fs);
+    formant_init(&formants[1], 1200.0, 90.0, fs);
+    formant_init(&formants[2], 2600.0, 120.0, fs);
+    unsigned int seed = 7u;
+    double phase = 0.0;
+    for (int i = 0; i < r->n; i++) {
+        double t = (double)i / fs;
+        double noise = uniform(&seed);
+        int fricative = noise_only || (t >= 0.40 && t < 0.55);
+        double v = 0.0;
+        if (!fricative) {
+            /* Rosenberg-like pulse: open phase 60 % of the period */
+            double open = phase / (2.0 * M_PI);
+            double pulse = open < 0.6 ? 0.5 * (1.0 - cos(M_PI * open / 0.6)) : 0.0;
+            v = pulse + 0.02 * noise;
+            for (int k = 0; k < 3; k++) v = formant_run(&formants[k], v);
+            v *= 4.0;
+        } else {
+            v = 0.05 * noise;
+        }
+        r->x[i] = floor(v * 32767.0 + 0.5) / 32767.0;
+        phase += 2.0 * M_PI * vowel_f0(t, seconds) / fs;
+        if (phase >= 2.0 * M_PI) phase -= 2.0 * M_PI;
+    }
+    for (int i = 0; i < r->frames; i++) {
+        double t = i * FRAME_PERIOD_MS / 1000.0;
+        int fricative = noise_only || (t >= 0.40 && t < 0.55);
+        r->positions[i] = t;
+        r->f0[i] = fricative ? (i % 2 ? 200.0 : 0.0) : vowel_f0(t, seconds);
+    }
+    return 0;
+}
+
+static void recording_free(Recording* r) {
+    free(r->x);
+    free(r->f0);
+    free(r->positions);
+}
+
+static double** rows(int frames, int bins) {
+    double** m = malloc(sizeof(double*) * frames);
+    if (!m) return NULL;
+    for (int i = 0; i < frames; i++) {
+        m[i] = malloc(sizeof(double) * bins);
+        if (!m[i]) return NULL;
+    }
+    return m;
+}
+
+static void rows_free(double** m, int frames) {
+    if (!m) return;
+    for (int i = 0; i < frames; i++) free(m[i]);
+    free(m);
+}
+
+static int unvoiced(const double* ap, int bins) {
+    for (int j = 0; j < bins; j++) {
+        if (ap[j] != 1.0 - 1e-12) return 0;
+    }
+    return 1;
+}
+
+/* Analyze r both ways and compare. f0 sets the frames' F0 for ours; WORLD
+ * gets world_f0 (the same F0 limited to what it can handle). */
+static int compare(const Recording* r, const double* f0, const double* world_f0, int with_d4c,
+                   const char* what) {
+    CheapTrickOption ct;
+    InitializeCheapTrickOption(r->fs, &ct);
+    D4COption d4c;
+    InitializeD4COption(&d4c);
+    int bins = ct.fft_size / 2 + 1;
+    double** sp = rows(r->frames, bins);
+    double** ap = rows(r->frames, bins);
+    double** world_sp = rows(r->frames, bins);
+    double** world_ap = rows(r->frames, bins);
+    WorldSpectralWork* work = NULL;
+    if (!sp || !ap || !world_sp || !world_ap ||
+        world_spectral_work_create(&work, r->fs, ct.fft_size, ct.q1, d4c.threshold) != 0) {
+        fprintf(stderr, "%s: setup failed\n", what);
+        return -1;
+    }
+
+    world_spectral_analyze(work, r->x, r->n, r->positions, f0, 0, r->frames, sp, ap);
+    CheapTrick(r->x, r->n, r->fs, r->positions, world_f0, r->frames, &ct, world_sp);
+    if (with_d4c) D4C(r->x, r->n, r->fs, r->positions, world_f0, r->frames, ct.fft_size, &d4c, world_ap);
+
+    double sp_diff = 0.0, floor_diff = 0.0, ap_diff = 0.0;
+    int voiced = 0, decisions_differ = 0;
+    for (int i = 0; i < r->frames; i++) {
+        for (int j = 0; j < bins; j++) {
+            double d = fabs(log(sp[i][j] / world_sp[i][j]));
+            double* worst = world_sp[i][j] > SP_FLOOR ? &sp_diff : &floor_diff;
+            if (!(d <= *worst)) *worst = d;
+        }
+        if (!with_d4c) continue;
+        if (unvoiced(ap[i], bins) != unvoiced(world_ap[i], bins)) decisions_differ++;
+        if (!unvoiced(ap[i], bins)) voiced++;
+        for (int j = 0; j < bins; j++) {
+            double d = fabs(ap[i][j] - world_ap[i][j]);
+            if (!(d <= ap_diff)) ap_diff = d;
+        }
+    }
+    printf("%s: %d frames, max |log sp diff| %.3g (%.3g near the floor)", what, r->frames, sp_diff,
+           floor_diff);
+    if (with_d4c) printf(", %d voiced, max |ap diff| %.3g", voiced, ap_diff);
+    printf("\n");
+
+    int result = 0;
+    if (!(sp_diff <= MAX_LOG_SP_DIFF) || !(floor_diff <= MAX_LOG_SP_DIFF_NEAR_FLOOR)) {
+        fprintf(stderr, "%s: envelope differs from CheapTrick() by more than %g (%g near the floor)\n", what,
+                MAX_LOG_SP_DIFF, MAX_LOG_SP_DIFF_NEAR_FLOOR);
+        result = -1;
+    }
+    if (with_d4c && (decisions_differ || !(ap_diff <= MAX_AP_DIFF))) {
+        fprintf(stderr, "%s: %d voicing decisions differ, aperiodicity by %g (limit %g)\n", what,
+                decisions_differ, ap_diff, MAX_AP_DIFF);
+        result = -1;
+    }
+    if (with_d4c && (voiced == 0 || voiced == r->frames)) {
+        fprintf(stderr, "%s: expected voiced and unvoiced frames\n", what);
+        result = -1;
+    }
+    world_spectral_work_destroy(work);
+    rows_free(sp, r->frames);
+    rows_free(ap, r->frames);
+    rows_free(world_sp, r->frames);
+    rows_free(world_ap, r->frames);
+    return result;
+}
+
+/* Voiced frames of our analysis at a rate where WORLD's decision is undefined */
+static int count_voiced(const Recording* r) {
+    CheapTrickOption ct;
+    InitializeCheapTrickOption(r->fs, &ct);
+    D4COption d4c;
+    InitializeD4COption(&d4c);
+    int bins = ct.fft_size / 2 + 1;
+    double** sp = rows(r->frames, bins);
+    double** ap = rows(r->frames, bins);
+    WorldSpectralWork* work = NULL;
+    if (!sp || !ap || world_spectral_work_create(&work, r->fs, ct.fft_size, ct.q1, d4c.threshold) != 0) {
+        return -1;
+    }
+    world_spectral_analyze(work, r->x, r->n, r->positions, r->f0, 0, r->frames, sp, ap);
+    int voiced = 0;
+    for (int i = 0; i < r->frames; i++) {
+        int ok = 1;
+        for (int j = 0; j < bins; j++) ok &= isfinite(sp[i][j]) && sp[i][j] > 0.0 && ap[i][j] > 0.0;
+        if (!ok) { voiced = -1; break; }
+        if (!unvoiced(ap[i], bins)) voiced++;
+    }
+    world_spectral_work_destroy(work);
+    rows_free(sp, r->frames);
+    rows_free(ap, r->frames);
+    return voiced;
+}
+
+int main(void) {
+    const int rates[] = { 44100, 48000, 22050 };
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        Recording r;
+        char what[64];
+        if (record(&r, rates[k], 0) != 0) { perror("alloc"); return 1; }
+        snprintf(what, sizeof(what), "%d Hz", rates[k]);
+        if (compare(&r, r.f0, r.f0, 1, what) != 0) return 2;
+
+        /* F0 above fs / 4 on every tenth vowel frame: WORLD at fs / 4 */
+        double* high = malloc(sizeof(double) * r.frames);
+        double* limited = malloc(sizeof(double) * r.frames);
+        if (!high || !limited) { perror("alloc"); return 1; }
+        for (int i = 0; i < r.frames; i++) {
+            high[i] = limited[i] = r.f0[i];
+            if (i % 10 == 5 && r.f0[i] > 0.0) {
+                high[i] = r.fs / 3.0;
+                limited[i] = r.fs / 4.0;
+            }
+        }
+        snprintf(what, sizeof(what), "%d Hz, F0 above fs/4", rates[k]);
+        if (compare(&r, high, limited, 1, what) != 0) return 3;
+        free(high);
+        free(limited);
+        recording_free(&r);
+    }
+
+    /* 11.025 kHz: CheapTrick as WORLD; D4C's decision up to Nyquist only */
+    Recording vowel, noise;
+    if (record(&vowel, 11025, 0) != 0 || record(&noise, 11025, 1) != 0) { perror("alloc"); return 1; }
+    if (compare(&vowel, vowel.f0, vowel.f0, 0, "11025 Hz") != 0) return 4;
+    int vowel_voiced = count_voiced(&vowel);
+    int noise_voiced = count_voiced(&noise);
+    printf("11025 Hz: %d of %d vowel frames voiced, %d of %d noise frames\n", vowel_voiced, vowel.frames,
+           noise_voiced, noise.frames);
+    /* a short window of white noise now and then looks voiced; one in ten
+     * of the frames given an F0 would be a wrong decision */
+    if (vowel_voiced < vowel.frames * 3 / 4 || noise_voiced > noise.frames / 20) {
+        fprintf(stderr, "11025 Hz: voicing decisions wrong\n");
+        return 5;
+    }
+    recording_free(&vowel);
+    recording_free(&noise);
+
+    printf("world spectral test passed\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "world_wrapper.h"
+#include "world_stretch.h"
+
+/* Whether v lies within [min, max] of a and b at every bin */
+static int row_between(const double* v, const double* a, const double* b, int bins) {
+    for (int k = 0; k < bins; k++) {
+        double lo = a[k] < b[k] ? a[k] : b[k];
+        double hi = a[k] < b[k] ? b[k] : a[k];
+        if (!(v[k] >= lo && v[k] <= hi)) return 0;
+    }
+    return 1;
+}
+
+/* An interpolated frame lies between two adjacent source frames, in both
+ * its envelope and its aperiodicity */
+static int between_neighbours(const WorldAnalysisData* data, const double* sp, const double* ap) {
+    int bins = data->fft_size / 2 + 1;
+    for (int i = 0; i + 1 < data->f0_length; i++) {
+        if (row_between(sp, data->spectrogram[i], data->spectrogram[i + 1], bins) &&
+            row_between(ap, data->aperiodicity[i], data->aperiodicity[i + 1], bins)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    WorldAnalysisData data;
+    world_analysis_data_init(&data);
+    if (world_generate_dummy_data(&data, 0.5, 44100, 5.0, 220.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+    int bins = data.fft_size / 2 + 1;
+
+    /* 4 s note from a 300 ms vowel after a 100 ms consonant */
+    WorldStretchParams params;
+    world_stretch_params_init(&params);
+    params.offset_ms = 50.0;
+    params.consonant_ms = 100.0;
+    params.cutoff_ms = -400.0;
+    params.length_ms = 4000.0;
+
+    WorldFrameView view;
+    world_frame_view_init(&view);
+    if (world_frame_view_build(&view, &data, &params) != 0) {
+        fprintf(stderr, "view build failed\n"); return 2;
+    }
+    if (view.frame_count != (int)(4000.0 / 5.0) + 1) {
+        fprintf(stderr, "unexpected frame count %d\n", view.frame_count); return 3;
+    }
+
+    /* consonant frames are the source rows themselves */
+    for (int j = 0; j < 20; j++) {
+        if (view.spectrogram[j] != data.spectrogram[10 + j] ||
+            view.aperiodicity[j] != data.aperiodicity[10 + j]) {
+            fprintf(stderr, "consonant frame %d is not a source view\n", j); return 4;
+        }
+    }
+    /* the dummy envelope is steady, so nothing needs interpolation */
+    printf("steady: %d interpolated, %zu bytes written\n", view.interpolated_frames, view.bytes_written);
+    if (view.interpolated_frames != 0 || view.bytes_written != 0) {
+        fprintf(stderr, "steady vowel was interpolated\n"); return 5;
+    }
+
+    /* make every vowel frame differ from its neighbour: interpolation kicks in */
+    for (int i = 30; i < data.f0_length; i++) {
+        for (int k = 0; k < bins; k++) data.spectrogram[i][k] *= (i % 2) ? 4.0 : 0.25;
+    }
+    if (world_frame_view_build(&view, &data, &params) != 0) {
+        fprintf(stderr, "view rebuild failed\n"); return 6;
+    }
+    printf("varying: %d interpolated, %zu bytes written\n", view.interpolated_frames, view.bytes_written);
+    if (view.interpolated_frames == 0) { fprintf(stderr, "no interpolation\n"); return 7; }
+    for (int j = 0; j < view.frame_count; j++) {
+        int in_source = 0;
+        for (int i = 0; i < data.f0_length && !in_source; i++) {
+            in_source = view.spectrogram[j] == data.spectrogram[i];
+        }
+        if (!in_source && !between_neighbours(&data, view.spectrogram[j], view.aperiodicity[j])) {
+            fprintf(stderr, "interpolated frame %d is outside its source frames\n", j); return 8;
+        }
+    }
+
+    /* nearest-only never writes rows */
+    params.interp_threshold_db = -1.0;
+    if (world_frame_view_build(&view, &data, &params) != 0 || view.interpolated_frames != 0) {
+        fprintf(stderr, "nearest mode interpolated\n"); return 9;
+    }
+
+    int n = (int)(params.length_ms / 1000.0 * data.sample_rate);
+    double* y = malloc(sizeof(double) * n);
+    if (!y) { perror("alloc"); return 10; }
+    if (world_frame_view_synthesize(&view, y, n) != 0) { fprintf(stderr, "synthesis failed\n"); return 11; }
+    for (int i = 0; i < n; i++) {
+        if (!isfinite(y[i])) { fprintf(stderr, "non-finite output\n"); return 12; }
+    }
+
+    free(y);
+    world_frame_view_free(&view);
+    world_analysis_data_free(&data);
+    printf("world stretch test passed\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+#include "world_synth_stream.h"
+#include "worldx_alloc_count.h"
+
+#include "world/synthesis.h"
+#include "world/matlabfunctions.h"
+
+/* With randn_reseed() WORLD's Synthesis() starts from the noise state the
+ * port starts from, and the two must agree to rounding. Without it WORLD's
+ * noise continues from wherever it was, so only the periodic part and the
+ * noise level can match. */
+#define MAX_SYNTH_DIFF 1e-9
+#define MIN_UNSEEDED_SNR_DB 30.0
+
+/* Heap a synthesis may use beyond world_synth_stream_memory_bytes(): its
+ * pull buffer and the allocator's per-block rounding */
+#define HEAP_SLACK_BYTES 8192
+
+#if defined(WORLDX_HAVE_RANDN_RESEED)
+static double max_diff(const double* ref, const double* y, int n) {
+    double diff = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (!(fabs(ref[i] - y[i]) <= diff)) diff = fabs(ref[i] - y[i]);
+    }
+    return diff;
+}
+#else
+static double snr_db(const double* ref, const double* y, int n) {
+    double signal = 0.0, noise = 0.0;
+    for (int i = 0; i < n; i++) {
+        signal += ref[i] * ref[i];
+        noise += (ref[i] - y[i]) * (ref[i] - y[i]);
+    }
+    if (noise <= 0.0) return INFINITY;
+    return 10.0 * log10(signal / noise);
+}
+#endif
+
+/* Compare against WORLD's Synthesis(); returns 0 when close enough */
+static int check_world(const double* ref, const double* y, int n, const char* what) {
+#if defined(WORLDX_HAVE_RANDN_RESEED)
+    double diff = max_diff(ref, y, n);
+    printf("%s: max |diff| vs Synthesis() %.3g\n", what, diff);
+    if (!(diff <= MAX_SYNTH_DIFF)) {
+        fprintf(stderr, "%s differs from Synthesis() by more than %g\n", what, MAX_SYNTH_DIFF);
+        return -1;
+    }
+#else
+    double snr = snr_db(ref, y, n);
+    printf("%s: SNR vs Synthesis() %.2f dB\n", what, snr);
+    if (snr < MIN_UNSEEDED_SNR_DB) {
+        fprintf(stderr, "%s SNR below %.1f dB\n", what, MIN_UNSEEDED_SNR_DB);
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+int main(void) {
+    const int block_sizes[] = { 64, 512, 1024 };
+    WorldAnalysisData data;
+    world_analysis_data_init(&data);
+    if (world_generate_dummy_data(&data, 2.0, 44100, 5.0, 220.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+    /* an unvoiced stretch (noise only, voicing edges) and a low, falling
+     * tail that the synthesis extrapolates past the last frame */
+    for (int i = 100; i < 140; i++) data.f0[i] = 0.0;
+    for (int i = data.f0_length - 30; i < data.f0_length; i++) {
+        data.f0[i] = 120.0 - 2.0 * (i - (data.f0_length - 30));
+    }
+
+    int n = data.x_length + 2000;
+    double* ref = malloc(sizeof(double) * n);
+    double* y = malloc(sizeof(double) * n);
+    double* z = malloc(sizeof(double) * n);
+    if (!ref || !y || !z) { perror("alloc"); return 2; }
+
+#if defined(WORLDX_HAVE_RANDN_RESEED)
+    randn_reseed();
+#endif
+    Synthesis(data.f0, data.f0_length, (const double* const*)data.spectrogram,
+              (const double* const*)data.aperiodicity, data.fft_size, data.frame_period,
+              data.sample_rate, n, ref);
+    if (world_synthesize(&data, y, n) != 0) { fprintf(stderr, "synthesize failed\n"); return 3; }
+    if (check_world(ref, y, n, "world_synthesize") != 0) return 4;
+
+    /* a repeated call draws the same noise */
+    if (world_synthesize(&data, z, n) != 0 || memcmp(y, z, sizeof(double) * n) != 0) {
+        fprintf(stderr, "repeated synthesis differs\n"); return 5;
+    }
+
+    /* the block size only changes how the samples are handed out */
+    for (size_t b = 0; b < sizeof(block_sizes) / sizeof(block_sizes[0]); b++) {
+        if (world_synthesize_streamed(&data, z, n, block_sizes[b]) != 0) {
+            fprintf(stderr, "streamed synthesis failed (block %d)\n", block_sizes[b]); return 6;
+        }
+        if (memcmp(y, z, sizeof(double) * n) != 0) {
+            fprintf(stderr, "block %d changes the samples\n", block_sizes[b]); return 7;
+        }
+    }
+
+    /* bare row tables (what a frame view hands over) stream the same way */
+    if (world_synthesize_frames_streamed(data.f0, (const double* const*)data.spectrogram,
+                                         (const double* const*)data.aperiodicity, data.f0_length,
+                                         data.fft_size, data.frame_period, data.sample_rate,
+                                         z, n, 512) != 0) {
+        fprintf(stderr, "streamed row synthesis failed\n"); return 8;
+    }
+    if (memcmp(y, z, sizeof(double) * n) != 0) { fprintf(stderr, "row synthesis differs\n"); return 9; }
+
+    /* pushing and pulling by hand: finish() sizes the output to the frames */
+    WorldSynthStream* stream = NULL;
+    if (world_synth_stream_create(&stream, data.sample_rate, data.frame_period, data.fft_size, 256, 8) != 0) {
+        fprintf(stderr, "stream create failed\n"); return 10;
+    }
+    int frames_n = (int)((data.f0_length - 1) * data.frame_period * data.sample_rate / 1000.0) + 1;
+#if defined(WORLDX_HAVE_RANDN_RESEED)
+    randn_reseed();
+#endif
+    Synthesis(data.f0, data.f0_length, (const double* const*)data.spectrogram,
+              (const double* const*)data.aperiodicity, data.fft_size, data.frame_period,
+              data.sample_rate, frames_n, ref);
+    int pushed = 0, written = 0;
+    double block[256];
+    for (;;) {
+        int accepted = 0;
+        if (pushed < data.f0_length) {
+            accepted = world_synth_stream_push(stream, data.f0 + pushed,
+                                               (const double* const*)data.spectrogram + pushed,
+                                               (const double* const*)data.aperiodicity + pushed,
+                                               data.f0_length - pushed);
+            if (accepted < 0) { fprintf(stderr, "push failed\n"); return 11; }
+            pushed += accepted;
+            if (pushed == data.f0_length) world_synth_stream_finish(stream);
+        }
+        int pulled, any = 0;
+        while ((pulled = world_synth_stream_pull(stream, block)) == 1) {
+            int count = frames_n - written < 256 ? frames_n - written : 256;
+            if (count <= 0) { fprintf(stderr, "stream ran past its frames\n"); return 12; }
+            memcpy(z + written, block, sizeof(double) * count);
+            written += count;
+            any = 1;
+        }
+        if (pulled < 0 || (!any && accepted == 0)) break;
+    }
+    world_synth_stream_destroy(stream);
+    if (written != frames_n) { fprintf(stderr, "stream wrote %d of %d samples\n", written, frames_n); return 13; }
+    if (check_world(ref, z, frames_n, "push/pull") != 0) return 14;
+
+    /* stream memory must not depend on note length: the heap a synthesis
+     * holds at its peak, counted by the allocator, is the same for a note
+     * four times longer and within the stream's own estimate */
+#if WORLDX_ALLOC_COUNT_AVAILABLE
+    if (world_synth_stream_create(&stream, data.sample_rate, data.frame_period, data.fft_size, 512, 0) != 0) {
+        fprintf(stderr, "stream create failed\n"); return 15;
+    }
+    long estimate = (long)world_synth_stream_memory_bytes(stream);
+    world_synth_stream_destroy(stream);
+    long peak[2];
+    size_t note_bytes = 0;
+    for (int k = 0; k < 2; k++) {
+        WorldAnalysisData note;
+        world_analysis_data_init(&note);
+        if (world_generate_dummy_data(&note, k ? 8.0 : 2.0, 44100, 5.0, 220.0) != 0) {
+            fprintf(stderr, "dummy data failed\n"); return 16;
+        }
+        double* out = malloc(sizeof(double) * note.x_length);
+        if (!out) { perror("alloc"); return 2; }
+        long before = worldx_alloc_live_bytes();
+        worldx_alloc_peak_reset();
+        if (world_synthesize_streamed(&note, out, note.x_length, 512) != 0) {
+            fprintf(stderr, "synthesize failed\n"); return 17;
+        }
+        peak[k] = worldx_alloc_peak_bytes() - before;
+        if (k == 0) note_bytes = sizeof(double) * 2 * (size_t)note.f0_length * (size_t)(note.fft_size / 2 + 1);
+        printf("%.0f s note: synthesis heap peak %ld bytes\n", k ? 8.0 : 2.0, peak[k]);
+        free(out);
+        world_analysis_data_free(&note);
+    }
+    printf("stream estimate %ld bytes, 2 s note sp+ap %zu bytes\n", estimate, note_bytes);
+    if (labs(peak[1] - peak[0]) > HEAP_SLACK_BYTES) {
+        fprintf(stderr, "synthesis heap grows with note length\n"); return 18;
+    }
+    if (peak[0] > estimate + HEAP_SLACK_BYTES || peak[1] > estimate + HEAP_SLACK_BYTES) {
+        fprintf(stderr, "synthesis heap above the stream estimate\n"); return 19;
+    }
+    if ((size_t)peak[0] >= note_bytes) { fprintf(stderr, "stream memory not bounded\n"); return 20; }
+#else
+    printf("allocation counting not available, stream memory not checked\n");
+#endif
+
+    free(ref);
+    free(y);
+    free(z);
+    world_analysis_data_free(&data);
+    printf("world synth stream test passed\n");
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world_wrapper.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Any number of analysis threads must reproduce the serial result exactly */
+
+static void make_signal(double* x, int n, int fs) {
+    double phase = 0.0;
+    unsigned int seed = 1u;
+    for (int i = 0; i < n; i++) {
+        double f0 = 200.0 * (1.0 + 0.05 * sin(2.0 * M_PI * 4.0 * i / fs));
+        x[i] = 0.0;
+        for (int h = 1; h <= 12; h++) x[i] += 0.2 * sin(h * phase) / h;
+        /* an unvoiced tail */
+        seed = seed * 1664525u + 1013904223u;
+        if (i > n * 3 / 4) x[i] = ((double)(seed >> 8) / 16777216.0 - 0.5) * 0.1;
+        phase += 2.0 * M_PI * f0 / fs;
+    }
+}
+
+static int same_rows(double** a, double** b, int frames, int bins) {
+    for (int i = 0; i < frames; i++) {
+        if (memcmp(a[i], b[i], sizeof(double) * (size_t)bins) != 0) return 0;
+    }
+    return 1;
+}
+
+int main(void) {
+    const int fs = 44100;
+    const int n = fs / 2;
+    double* x = malloc(sizeof(double) * n);
+    if (!x) { perror("alloc"); return 1; }
+    make_signal(x, n, fs);
+
+    WorldAnalysisOptions options;
+    world_analysis_options_init(&options);
+    WorldAnalysisData serial;
+    world_analysis_data_init(&serial);
+    if (world_analyze(x, n, fs, &options, &serial) != 0) {
+        fprintf(stderr, "serial analysis failed\n"); return 2;
+    }
+    int bins = serial.fft_size / 2 + 1;
+    for (int i = 0; i < serial.f0_length; i++) {
+        for (int j = 0; j < bins; j++) {
+            double sp = serial.spectrogram[i][j], ap = serial.aperiodicity[i][j];
+            if (!(sp > 0.0) || !isfinite(sp) || !(ap > 0.0) || !(ap <= 1.0)) {
+                fprintf(stderr, "invalid value at frame %d bin %d\n", i, j); return 3;
+            }
+        }
+    }
+
+    /* 0 selects the CPU count; 7 leaves uneven slices */
+    const int threads[] = { 2, 3, 7, 0 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        options.num_threads = threads[t];
+        WorldAnalysisData threaded;
+        world_analysis_data_init(&threaded);
+        if (world_analyze(x, n, fs, &options, &threaded) != 0) {
+            fprintf(stderr, "analysis with %d threads failed\n", threads[t]); return 4;
+        }
+        if (threaded.f0_length != serial.f0_length || threaded.fft_size != serial.fft_size) {
+            fprintf(stderr, "dimension mismatch\n"); return 5;
+        }
+        if (!same_rows(serial.spectrogram, threaded.spectrogram, serial.f0_length, bins) ||
+            !same_rows(serial.aperiodicity, threaded.aperiodicity, serial.f0_length, bins)) {
+            fprintf(stderr, "%d threads diverge from the serial analysis\n", threads[t]); return 6;
+        }
+        printf("%d threads: %d frames identical\n", threads[t], threaded.f0_length);
+        world_analysis_data_free(&threaded);
+    }
+
+    world_analysis_data_free(&serial);
+    free(x);
+    printf("world threads test passed\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "worldx_pool.h"
+#include "worldx_thread.h"
+
+/* Every job runs exactly once, and a worker stuck on a long job has the
+ * rest of its range stolen. */
+
+enum { kJobs = 4000, kThreads = 4 };
+
+typedef struct {
+    worldx_atomic_t runs[kJobs];
+    worldx_atomic_t stolen_from_first; /* jobs of worker 0's range run elsewhere */
+    int block_first;
+    int timed_out;
+} Batch;
+
+static void run_job(void* ctx, size_t job, int worker) {
+    Batch* b = (Batch*)ctx;
+    worldx_atomic_inc(&b->runs[job]);
+    if (job > 0 && job < kJobs / kThreads && worker != 0) worldx_atomic_inc(&b->stolen_from_first);
+
+    /* job 0 blocks its worker until someone else takes over its range */
+    if (job == 0 && b->block_first) {
+        time_t start = time(NULL);
+        while (worldx_atomic_load(&b->stolen_from_first) == 0) {
+            if (time(NULL) - start > 10) {
+                b->timed_out = 1;
+                return;
+            }
+        }
+    }
+}
+
+int main(void) {
+    Batch* b = (Batch*)calloc(1, sizeof(Batch));
+    if (!b) return 1;
+    b->block_first = 1;
+
+    WorldxPoolStats stats;
+    if (worldx_pool_run(kThreads, kJobs, run_job, b, &stats) != 0) {
+        fprintf(stderr, "pool run failed\n"); return 2;
+    }
+    for (int i = 0; i < kJobs; i++) {
+        if (b->runs[i] != 1) { fprintf(stderr, "job %d ran %ld times\n", i, (long)b->runs[i]); return 3; }
+    }
+    printf("%d threads, %zu steals, %ld jobs of worker 0 stolen\n", stats.threads, stats.steals,
+           (long)b->stolen_from_first);
+    if (b->timed_out || stats.threads < 2 || stats.steals == 0 || b->stolen_from_first == 0) {
+        fprintf(stderr, "blocked range was not stolen\n"); return 4;
+    }
+
+    /* fewer jobs than threads, empty batches, bad arguments */
+    Batch* small = (Batch*)calloc(1, sizeof(Batch));
+    if (!small) return 5;
+    if (worldx_pool_run(64, 1, run_job, small, &stats) != 0 || stats.threads != 1 || small->runs[0] != 1) {
+        fprintf(stderr, "single job batch wrong\n"); return 6;
+    }
+    if (worldx_pool_run(0, 0, run_job, small, NULL) != 0 || worldx_pool_run(2, 5, NULL, NULL, NULL) == 0) {
+        fprintf(stderr, "argument handling wrong\n"); return 7;
+    }
+
+    free(small);
+    free(b);
+    printf("worldx pool test passed\n");
+    return 0;
+}
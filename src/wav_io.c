@@ -0,0 +1,450 @@
+/**
+ * @file wav_io.c
+ * @brief Minimal RIFF/WAVE reader and writer implementation
+ */
+
+#include "wav_io.h"
+#include "simd_convert.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define WAV_FORMAT_PCM        0x0001
+#define WAV_FORMAT_IEEE_FLOAT 0x0003
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+static uint16_t read_u16le(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_u16le(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void write_u32le(uint8_t* p, uint32_t v) {
+    write_u16le(p, (uint16_t)(v & 0xFFFF));
+    write_u16le(p + 2, (uint16_t)(v >> 16));
+}
+
+// One sample of the given format, scaled to [-1, 1)
+static double decode_sample(const uint8_t* p, int format, int bits) {
+    if (format == WAV_FORMAT_IEEE_FLOAT) {
+        if (bits == 32) {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return (double)v;
+        }
+        double v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    switch (bits) {
+        case 8:
+            return ((int)p[0] - 128) / 128.0;
+        case 16:
+            return (int16_t)read_u16le(p) / 32768.0;
+        case 24: {
+            int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24);
+            return (v >> 8) / 8388608.0;
+        }
+        default:
+            return (int32_t)read_u32le(p) / 2147483648.0;
+    }
+}
+
+// The whole file, mapped read-only where possible and read into memory otherwise
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    uint8_t* owned;
+} WavSource;
+
+static int source_read(const char* path, WavSource* src) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (size <= 0 || fseek(f, 0, SEEK_SET) != 0 || !(src->owned = (uint8_t*)malloc((size_t)size))) {
+        fclose(f);
+        return -1;
+    }
+    src->size = fread(src->owned, 1, (size_t)size, f);
+    src->data = src->owned;
+    fclose(f);
+    return 0;
+}
+
+static int source_open(const char* path, WavSource* src) {
+    memset(src, 0, sizeof(*src));
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        HANDLE section = NULL;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && (uint64_t)size.QuadPart <= SIZE_MAX) {
+            section = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        }
+        CloseHandle(file);
+        if (section) {
+            src->data = (const uint8_t*)MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(section);  // the view keeps the section alive
+            if (src->data) {
+                src->size = (size_t)size.QuadPart;
+                return 0;
+            }
+        }
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        void* base = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size <= SIZE_MAX) {
+            base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);  // the mapping keeps the file alive
+        if (base != MAP_FAILED) {
+#if defined(POSIX_MADV_SEQUENTIAL)
+            posix_madvise(base, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+            src->data = (const uint8_t*)base;
+            src->size = (size_t)st.st_size;
+            return 0;
+        }
+    }
+#endif
+    // Pipes, special files and platforms without mappings
+    return source_read(path, src);
+}
+
+static void source_close(WavSource* src) {
+    if (src->owned) {
+        free(src->owned);
+    } else if (src->data) {
+#if defined(_WIN32)
+        UnmapViewOfFile((LPCVOID)src->data);
+#else
+        munmap((void*)src->data, src->size);
+#endif
+    }
+    memset(src, 0, sizeof(*src));
+}
+
+// n interleaved samples to doubles; the common formats take the SIMD kernels
+static void decode_samples(const uint8_t* p, int format, int bits, double* dst, size_t n) {
+    if (format == WAV_FORMAT_PCM && bits == 16) {
+        simd_convert_s16le_to_f64(p, dst, n);
+    } else if (format == WAV_FORMAT_PCM && bits == 24) {
+        simd_convert_s24le_to_f64(p, dst, n);
+    } else if (format == WAV_FORMAT_IEEE_FLOAT && bits == 32) {
+        // The data chunk need not be 4-byte aligned; stage through an aligned buffer
+        float staged[1024];
+        for (size_t i = 0; i < n; i += 1024) {
+            size_t count = n - i < 1024 ? n - i : 1024;
+            memcpy(staged, p + 4 * i, count * sizeof(float));
+            simd_convert_f32_to_f64(staged, dst + i, count);
+        }
+    } else {
+        size_t sample_bytes = (size_t)bits / 8;
+        for (size_t i = 0; i < n; i++) dst[i] = decode_sample(p + i * sample_bytes, format, bits);
+    }
+}
+
+int wav_read_mono(const char* path, double** out_x, int* out_length, int* out_fs) {
+    if (!path || !out_x || !out_length || !out_fs) return -1;
+
+    WavSource src;
+    if (source_open(path, &src) != 0) return -1;
+    if (src.size < 12 || memcmp(src.data, "RIFF", 4) != 0 || memcmp(src.data + 8, "WAVE", 4) != 0) {
+        source_close(&src);
+        return -1;
+    }
+
+    int format = 0, channels = 0, fs = 0, bits = 0;
+    const uint8_t* samples = NULL;
+    size_t data_size = 0;
+    size_t pos = 12;
+    while (!samples && src.size - pos >= 8) {
+        const uint8_t* chunk = src.data + pos;
+        uint32_t size = read_u32le(chunk + 4);
+        size_t avail = src.size - pos - 8;
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (size < 16 || avail < 16) break;
+            const uint8_t* fmt = chunk + 8;
+            format = read_u16le(fmt);
+            channels = read_u16le(fmt + 2);
+            fs = (int)read_u32le(fmt + 4);
+            bits = read_u16le(fmt + 14);
+            // Extensible files carry the real format in the sub-format GUID
+            if (format == WAV_FORMAT_EXTENSIBLE && size >= 26 && avail >= 26) format = read_u16le(fmt + 24);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (format == 0) break;
+            samples = chunk + 8;
+            // Tolerate a truncated final chunk; keep what was written
+            data_size = size < avail ? size : avail;
+            break;
+        }
+        if ((uint64_t)size + (size & 1) > avail) break;
+        pos += 8 + (size_t)size + (size & 1);
+    }
+
+    int supported = (format == WAV_FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+                    (format == WAV_FORMAT_IEEE_FLOAT && (bits == 32 || bits == 64));
+    size_t frame_bytes = supported && channels > 0 ? (size_t)bits / 8 * (size_t)channels : 0;
+    size_t length = frame_bytes ? data_size / frame_bytes : 0;
+    double* x = NULL;
+    if (samples && frame_bytes && fs > 0 && length > 0 && length <= (size_t)INT32_MAX) {
+        x = (double*)malloc(sizeof(double) * length);
+    }
+    if (!x) {
+        source_close(&src);
+        return -1;
+    }
+
+    if (channels == 1) {
+        decode_samples(samples, format, bits, x, length);
+    } else {
+        // Decode a block of frames, then average each frame's channels in order
+        size_t block = length < 1024 ? length : 1024;
+        double* frames = (double*)malloc(sizeof(double) * block * (size_t)channels);
+        if (!frames) {
+            free(x);
+            source_close(&src);
+            return -1;
+        }
+        for (size_t i = 0; i < length; i += block) {
+            size_t count = length - i < block ? length - i : block;
+            decode_samples(samples + i * frame_bytes, format, bits, frames, count * (size_t)channels);
+            for (size_t k = 0; k < count; k++) {
+                const double* frame = frames + k * (size_t)channels;
+                double sum = 0.0;
+                for (int c = 0; c < channels; c++) sum += frame[c];
+                x[i + k] = sum / channels;
+            }
+        }
+        free(frames);
+    }
+    source_close(&src);
+
+    *out_x = x;
+    *out_length = (int)length;
+    *out_fs = fs;
+    return 0;
+}
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50 && term > 1e-12 * sum; k++) {
+        double h = x / (2.0 * k);
+        term *= h * h;
+        sum += term;
+    }
+    return sum;
+}
+
+#define RESAMPLE_ZERO_CROSSINGS 16
+#define RESAMPLE_PHASES         256
+#define RESAMPLE_KAISER_BETA    8.0
+
+int wav_resample(const double* x, int length, int fs_in, int fs_out, double** out_y, int* out_length) {
+    if (!x || length <= 0 || fs_in <= 0 || fs_out <= 0 || !out_y || !out_length) return -1;
+    int64_t n = (int64_t)length * fs_out / fs_in;
+    if (n < 1) n = 1;
+    if (n > INT32_MAX) return -1;
+    double* y = (double*)malloc(sizeof(double) * (size_t)n);
+    if (!y) return -1;
+    if (fs_in == fs_out) {
+        memcpy(y, x, sizeof(double) * (size_t)length);
+        *out_y = y;
+        *out_length = length;
+        return 0;
+    }
+
+    // Kernel over input samples: cutoff fc of the input Nyquist, half-width
+    // RESAMPLE_ZERO_CROSSINGS zero crossings, tabulated at RESAMPLE_PHASES
+    // points per input sample and interpolated linearly
+    double ratio = (double)fs_out / fs_in;
+    double fc = (ratio < 1.0 ? ratio : 1.0) * 0.95;
+    double width = RESAMPLE_ZERO_CROSSINGS / fc;
+    int taps = (int)ceil(width * RESAMPLE_PHASES) + 2;
+    double* kernel = (double*)malloc(sizeof(double) * (size_t)taps);
+    if (!kernel) {
+        free(y);
+        return -1;
+    }
+    const double pi = 3.14159265358979323846;
+    double norm = bessel_i0(RESAMPLE_KAISER_BETA);
+    for (int i = 0; i < taps; i++) {
+        double d = (double)i / RESAMPLE_PHASES;
+        double r = d / width;
+        double sinc = d == 0.0 ? 1.0 : sin(pi * fc * d) / (pi * fc * d);
+        kernel[i] = r >= 1.0 ? 0.0 : fc * sinc * bessel_i0(RESAMPLE_KAISER_BETA * sqrt(1.0 - r * r)) / norm;
+    }
+
+    for (int64_t j = 0; j < n; j++) {
+        double t = j / ratio;
+        int64_t first = (int64_t)ceil(t - width), last = (int64_t)floor(t + width);
+        if (first < 0) first = 0;
+        if (last > length - 1) last = length - 1;
+        double sum = 0.0;
+        for (int64_t k = first; k <= last; k++) {
+            double pos = fabs(t - (double)k) * RESAMPLE_PHASES;
+            int i = (int)pos;
+            if (i >= taps - 1) continue;
+            double frac = pos - i;
+            sum += x[k] * (kernel[i] + frac * (kernel[i + 1] - kernel[i]));
+        }
+        y[j] = sum;
+    }
+    free(kernel);
+    *out_y = y;
+    *out_length = (int)n;
+    return 0;
+}
+
+struct WavWriter {
+    FILE* f;
+    int channels;
+    uint64_t data_size;
+    uint64_t reserved;  // file bytes preallocated
+    uint32_t dither;    // generator state; 0 without dither
+    int ok;
+};
+
+// Canonical 44-byte header of a 16-bit PCM file with data_size bytes of samples
+static void pcm16_header(uint8_t header[44], int fs, int channels, uint32_t data_size) {
+    memcpy(header, "RIFF", 4);
+    write_u32le(header + 4, 36 + data_size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    write_u32le(header + 16, 16);
+    write_u16le(header + 20, WAV_FORMAT_PCM);
+    write_u16le(header + 22, (uint16_t)channels);
+    write_u32le(header + 24, (uint32_t)fs);
+    write_u32le(header + 28, (uint32_t)fs * (uint32_t)channels * 2);
+    write_u16le(header + 32, (uint16_t)(channels * 2));
+    write_u16le(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    write_u32le(header + 40, data_size);
+}
+
+int wav_writer_open(const char* path, int fs, int channels, WavWriter** out_writer) {
+    if (!out_writer) return -1;
+    *out_writer = NULL;
+    if (!path || fs <= 0 || channels < 1 || channels > 8) return -1;
+
+    WavWriter* writer = (WavWriter*)calloc(1, sizeof(WavWriter));
+    if (!writer) return -1;
+    writer->f = fopen(path, "wb");
+    if (!writer->f) {
+        free(writer);
+        return -1;
+    }
+    // Sizes are patched in by wav_writer_close()
+    uint8_t header[44];
+    pcm16_header(header, fs, channels, 0);
+    writer->channels = channels;
+    writer->ok = fwrite(header, 1, sizeof(header), writer->f) == sizeof(header);
+    *out_writer = writer;
+    return 0;
+}
+
+int wav_writer_reserve(WavWriter* writer, uint64_t frames) {
+    if (!writer) return -1;
+    uint64_t bytes = 44 + frames * (uint64_t)writer->channels * 2;
+    if (bytes <= 44 + writer->data_size || bytes > (uint64_t)UINT32_MAX + 8) return 0;
+#if defined(__linux__)
+    if (!writer->ok || fflush(writer->f) != 0 || posix_fallocate(fileno(writer->f), 0, (off_t)bytes) != 0) {
+        return -1;
+    }
+    writer->reserved = bytes;
+#endif
+    return 0;
+}
+
+void wav_writer_set_dither(WavWriter* writer, uint32_t seed) {
+    if (writer) writer->dither = seed ? seed : 0x9E3779B9u;
+}
+
+// Triangular noise in (-1, 1) steps: the sum of two 16-bit uniforms from one xorshift32 draw
+static double dither_tpdf(uint32_t* state) {
+    uint32_t v = *state;
+    v ^= v << 13;
+    v ^= v >> 17;
+    v ^= v << 5;
+    *state = v;
+    return ((v & 0xFFFF) + (v >> 16) + 1) * (1.0 / 65536.0) - 1.0;
+}
+
+int wav_writer_write(WavWriter* writer, const double* x, int length) {
+    if (!writer || (!x && length > 0) || length < 0) return -1;
+    size_t frame_bytes = (size_t)writer->channels * 2;
+    if (writer->data_size + (uint64_t)length * frame_bytes > UINT32_MAX - 36) writer->ok = 0;
+
+    // Quantize and encode in blocks of whole frames
+    enum { BLOCK_FRAMES = 512 };
+    int16_t q[BLOCK_FRAMES];
+    double noise[BLOCK_FRAMES];
+    uint8_t block[BLOCK_FRAMES * 8 * 2];
+    for (int i = 0; writer->ok && i < length; i += BLOCK_FRAMES) {
+        int count = length - i < BLOCK_FRAMES ? length - i : BLOCK_FRAMES;
+        if (writer->dither) {
+            for (int k = 0; k < count; k++) noise[k] = dither_tpdf(&writer->dither);
+        }
+        simd_convert_f64_to_s16(x + i, writer->dither ? noise : NULL, q, (size_t)count);
+        size_t used = 0;
+        for (int k = 0; k < count; k++) {
+            for (int c = 0; c < writer->channels; c++, used += 2) write_u16le(block + used, (uint16_t)q[k]);
+        }
+        writer->ok = fwrite(block, 1, used, writer->f) == used;
+        writer->data_size += used;
+    }
+    return writer->ok ? 0 : -1;
+}
+
+uint64_t wav_writer_bytes(const WavWriter* writer) {
+    return writer ? 44 + writer->data_size : 0;
+}
+
+int wav_writer_close(WavWriter* writer) {
+    if (!writer) return -1;
+    uint8_t sizes[4];
+    write_u32le(sizes, (uint32_t)(36 + writer->data_size));
+    int ok = writer->ok && fseek(writer->f, 4, SEEK_SET) == 0 && fwrite(sizes, 1, 4, writer->f) == 4;
+    write_u32le(sizes, (uint32_t)writer->data_size);
+    ok = ok && fseek(writer->f, 40, SEEK_SET) == 0 && fwrite(sizes, 1, 4, writer->f) == 4;
+#if defined(__linux__)
+    // Give back what was reserved but not written
+    if (ok && writer->reserved > 44 + writer->data_size) {
+        ok = fflush(writer->f) == 0 && ftruncate(fileno(writer->f), (off_t)(44 + writer->data_size)) == 0;
+    }
+#endif
+    ok = fclose(writer->f) == 0 && ok;
+    free(writer);
+    return ok ? 0 : -1;
+}
+
+int wav_write_pcm16(const char* path, const double* x, int length, int fs, int channels) {
+    if (!x || length < 0) return -1;
+    WavWriter* writer = NULL;
+    if (wav_writer_open(path, fs, channels, &writer) != 0) return -1;
+    // Preallocation is only a hint; the writes report real failures
+    wav_writer_reserve(writer, (uint64_t)length);
+    int ok = wav_writer_write(writer, x, length) == 0;
+    return wav_writer_close(writer) == 0 && ok ? 0 : -1;
+}
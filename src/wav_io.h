@@ -0,0 +1,117 @@
+/**
+ * @file wav_io.h
+ * @brief Minimal RIFF/WAVE reader and 16-bit writer
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * Reads the sample formats UTAU voicebanks ship in (8/16/24/32-bit PCM and
+ * 32/64-bit IEEE float, plain or WAVE_FORMAT_EXTENSIBLE) into a mono double
+ * signal in [-1, 1) ready for world_analyze(). Multi-channel files are
+ * averaged down to mono. Rendered notes are written back as 16-bit PCM,
+ * whole or streamed block by block through a WavWriter.
+ *
+ * The reader maps the file rather than copying it, and 16/24-bit PCM and
+ * 32-bit float, the formats nearly every voicebank uses, are converted with
+ * the SIMD kernels of simd_convert.h; the writer quantizes the same way.
+ */
+#ifndef WORLDX_UCRA_WAV_IO_H
+#define WORLDX_UCRA_WAV_IO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Read a WAV file as a mono double signal
+ *
+ * @param path WAV file path
+ * @param out_x Receives a malloc'd signal; release with free()
+ * @param out_length Receives the number of samples
+ * @param out_fs Receives the sample rate
+ * @return 0 on success, -1 on failure (I/O error, unsupported format)
+ */
+int wav_read_mono(const char* path, double** out_x, int* out_length, int* out_fs);
+
+/**
+ * @brief Convert a signal to another sample rate
+ *
+ * Band-limited interpolation with a Kaiser-windowed sinc; when converting
+ * down, the cutoff follows the lower Nyquist frequency. The output has
+ * length * fs_out / fs_in samples (at least one); equal rates copy.
+ *
+ * @param out_y Receives a malloc'd signal; release with free()
+ * @return 0 on success, -1 on failure
+ */
+int wav_resample(const double* x, int length, int fs_in, int fs_out, double** out_y, int* out_length);
+
+/**
+ * @brief Write a mono double signal as 16-bit PCM
+ *
+ * Samples are clipped to [-1, 1] and rounded; every output channel carries
+ * the same signal.
+ *
+ * @param path Output WAV path (overwritten)
+ * @param x Signal in [-1, 1]
+ * @param length Number of samples
+ * @param fs Sample rate
+ * @param channels Output channel count (1..8)
+ * @return 0 on success, -1 on failure
+ */
+int wav_write_pcm16(const char* path, const double* x, int length, int fs, int channels);
+
+/** Streaming 16-bit PCM writer */
+typedef struct WavWriter WavWriter;
+
+/**
+ * @brief Create a 16-bit PCM file to append samples to
+ *
+ * @param path Output WAV path (overwritten)
+ * @param fs Sample rate
+ * @param channels Output channel count (1..8)
+ * @param out_writer Receives the writer
+ * @return 0 on success, -1 on failure
+ */
+int wav_writer_open(const char* path, int fs, int channels, WavWriter** out_writer);
+
+/**
+ * @brief Reserve disk space for the samples still to come
+ *
+ * Allocates the file up front so it is not grown write by write; space left
+ * unused is released on close. A no-op where the platform offers no way to
+ * preallocate.
+ *
+ * @param frames Frames the caller expects to write
+ * @return 0 on success (or no-op), -1 on failure
+ */
+int wav_writer_reserve(WavWriter* writer, uint64_t frames);
+
+/**
+ * @brief Add triangular (TPDF) dither of +-1 step before rounding
+ *
+ * The noise comes from a generator seeded with seed, so the same input
+ * and seed always give the same file.
+ */
+void wav_writer_set_dither(WavWriter* writer, uint32_t seed);
+
+/**
+ * @brief Append a mono double signal, clipped and rounded as wav_write_pcm16() does
+ * @return 0 on success, -1 on failure (later writes and the close fail too)
+ */
+int wav_writer_write(WavWriter* writer, const double* x, int length);
+
+/** @brief Bytes of the file so far, header included */
+uint64_t wav_writer_bytes(const WavWriter* writer);
+
+/**
+ * @brief Fill in the header sizes and close the file
+ * @return 0 if every write succeeded, -1 otherwise
+ */
+int wav_writer_close(WavWriter* writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WAV_IO_H */
@@ -0,0 +1,358 @@
+/**
+ * @file world_flags.c
+ * @brief Fused in-place flag processing implementation
+ */
+
+#include "world_flags.h"
+#include "simd_convert.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WORLD_FLAGS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define WORLD_FLAGS_TARGET_SSE2
+#define WORLD_FLAGS_TARGET_AVX2
+#else
+#define WORLD_FLAGS_TARGET_SSE2 __attribute__((target("sse2")))
+#define WORLD_FLAGS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Flag curve constants
+#define WORLD_FLAGS_GENDER_MAX_OCTAVES 0.5
+#define WORLD_FLAGS_BRIGHTNESS_MAX_DB 12.0
+#define WORLD_FLAGS_PIVOT_HZ 1000.0
+
+struct WorldFlagPipeline {
+    int bins;
+    WorldFlagsIsa isa;
+
+    // Formant warp: out[k] = in[idx[k]] + (in[idx[k] + 1] - in[idx[k]]) * frac[k]
+    int warp_active;
+    int32_t* idx;
+    double* frac;
+
+    // Combined brightness and tilt power gain per bin
+    int gain_active;
+    double* gain;
+
+    // Breathiness: ap = ap * ap_scale + ap_offset
+    int ap_active;
+    double ap_scale;
+    double ap_offset;
+
+    // Frame scratch: source copy for the warp, widened rows for float32 data
+    double* scratch;
+    double* wide_sp;
+    double* wide_ap;
+};
+
+// ---------------------------------------------------------------------------
+// Flag curves, shared by the pipeline tables and the reference
+
+static double warp_ratio(const WorldFlagParams* params) {
+    return pow(2.0, params->gender / 100.0 * WORLD_FLAGS_GENDER_MAX_OCTAVES);
+}
+
+static double brightness_db(const WorldFlagParams* params, double freq, double nyquist) {
+    if (freq <= WORLD_FLAGS_PIVOT_HZ || nyquist <= WORLD_FLAGS_PIVOT_HZ) return 0.0;
+    return params->brightness / 100.0 * WORLD_FLAGS_BRIGHTNESS_MAX_DB *
+           (freq - WORLD_FLAGS_PIVOT_HZ) / (nyquist - WORLD_FLAGS_PIVOT_HZ);
+}
+
+static double tilt_db(const WorldFlagParams* params, double freq, double bin_hz) {
+    // DC borrows the first bin's frequency so log2 stays finite
+    double f = freq > 0.0 ? freq : bin_hz;
+    return params->tilt * log2(f / WORLD_FLAGS_PIVOT_HZ);
+}
+
+// ---------------------------------------------------------------------------
+// Kernels. Each processes bins [0, n) of one frame; src is the pre-warp copy
+// of sp and is only read when the warp is active.
+
+static void kernel_scalar(const WorldFlagPipeline* p, const double* src, double* sp, double* ap) {
+    int n = p->bins;
+    for (int k = 0; k < n; k++) {
+        if (p->warp_active) {
+            double lo = src[p->idx[k]];
+            double hi = src[p->idx[k] + 1];
+            sp[k] = lo + (hi - lo) * p->frac[k];
+        }
+        if (p->gain_active) sp[k] *= p->gain[k];
+        if (p->ap_active) ap[k] = ap[k] * p->ap_scale + p->ap_offset;
+    }
+}
+
+#if defined(WORLD_FLAGS_X86)
+WORLD_FLAGS_TARGET_SSE2
+static void kernel_sse2(const WorldFlagPipeline* p, const double* src, double* sp, double* ap) {
+    int n = p->bins;
+    int k = 0;
+    __m128d scale = _mm_set1_pd(p->ap_scale);
+    __m128d offset = _mm_set1_pd(p->ap_offset);
+    for (; k + 2 <= n; k += 2) {
+        __m128d v;
+        if (p->warp_active) {
+            const int32_t* idx = p->idx + k;
+            __m128d lo = _mm_set_pd(src[idx[1]], src[idx[0]]);
+            __m128d hi = _mm_set_pd(src[idx[1] + 1], src[idx[0] + 1]);
+            v = _mm_add_pd(lo, _mm_mul_pd(_mm_sub_pd(hi, lo), _mm_loadu_pd(p->frac + k)));
+        } else {
+            v = _mm_loadu_pd(sp + k);
+        }
+        if (p->gain_active) v = _mm_mul_pd(v, _mm_loadu_pd(p->gain + k));
+        _mm_storeu_pd(sp + k, v);
+        if (p->ap_active) {
+            __m128d a = _mm_loadu_pd(ap + k);
+            _mm_storeu_pd(ap + k, _mm_add_pd(_mm_mul_pd(a, scale), offset));
+        }
+    }
+    for (; k < n; k++) {
+        if (p->warp_active) {
+            double lo = src[p->idx[k]];
+            double hi = src[p->idx[k] + 1];
+            sp[k] = lo + (hi - lo) * p->frac[k];
+        }
+        if (p->gain_active) sp[k] *= p->gain[k];
+        if (p->ap_active) ap[k] = ap[k] * p->ap_scale + p->ap_offset;
+    }
+}
+
+WORLD_FLAGS_TARGET_AVX2
+static void kernel_avx2(const WorldFlagPipeline* p, const double* src, double* sp, double* ap) {
+    int n = p->bins;
+    int k = 0;
+    __m256d scale = _mm256_set1_pd(p->ap_scale);
+    __m256d offset = _mm256_set1_pd(p->ap_offset);
+    for (; k + 4 <= n; k += 4) {
+        __m256d v;
+        if (p->warp_active) {
+            __m128i idx = _mm_loadu_si128((const __m128i*)(p->idx + k));
+            __m256d lo = _mm256_i32gather_pd(src, idx, 8);
+            __m256d hi = _mm256_i32gather_pd(src + 1, idx, 8);
+            v = _mm256_add_pd(lo, _mm256_mul_pd(_mm256_sub_pd(hi, lo),
+                                                _mm256_loadu_pd(p->frac + k)));
+        } else {
+            v = _mm256_loadu_pd(sp + k);
+        }
+        if (p->gain_active) v = _mm256_mul_pd(v, _mm256_loadu_pd(p->gain + k));
+        _mm256_storeu_pd(sp + k, v);
+        if (p->ap_active) {
+            __m256d a = _mm256_loadu_pd(ap + k);
+            _mm256_storeu_pd(ap + k, _mm256_add_pd(_mm256_mul_pd(a, scale), offset));
+        }
+    }
+    for (; k < n; k++) {
+        if (p->warp_active) {
+            double lo = src[p->idx[k]];
+            double hi = src[p->idx[k] + 1];
+            sp[k] = lo + (hi - lo) * p->frac[k];
+        }
+        if (p->gain_active) sp[k] *= p->gain[k];
+        if (p->ap_active) ap[k] = ap[k] * p->ap_scale + p->ap_offset;
+    }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+
+void world_flag_params_init(WorldFlagParams* params) {
+    if (!params) return;
+    memset(params, 0, sizeof(*params));
+}
+
+WorldFlagsIsa world_flags_detect_isa(void) {
+#if defined(WORLD_FLAGS_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    int has_sse2 = (info[3] & (1 << 26)) != 0;
+    int os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (os_avx) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) return WORLD_FLAGS_ISA_AVX2;
+    }
+    if (has_sse2) return WORLD_FLAGS_ISA_SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return WORLD_FLAGS_ISA_AVX2;
+    if (__builtin_cpu_supports("sse2")) return WORLD_FLAGS_ISA_SSE2;
+#endif
+#endif
+    return WORLD_FLAGS_ISA_SCALAR;
+}
+
+const char* world_flags_isa_name(WorldFlagsIsa isa) {
+    switch (isa) {
+        case WORLD_FLAGS_ISA_AVX2: return "avx2";
+        case WORLD_FLAGS_ISA_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+int world_flag_pipeline_create(WorldFlagPipeline** out_pipeline, const WorldFlagParams* params,
+                               int fs, int fft_size) {
+    if (!out_pipeline || !params || fs <= 0 || fft_size < 4) return -1;
+    *out_pipeline = NULL;
+
+    WorldFlagPipeline* p = (WorldFlagPipeline*)calloc(1, sizeof(WorldFlagPipeline));
+    if (!p) return -1;
+
+    int bins = fft_size / 2 + 1;
+    p->bins = bins;
+    p->isa = world_flags_detect_isa();
+    p->warp_active = params->gender != 0.0;
+    p->gain_active = params->brightness != 0.0 || params->tilt != 0.0;
+    p->ap_active = params->breathiness != 0.0;
+
+    p->idx = (int32_t*)malloc(sizeof(int32_t) * bins);
+    p->frac = (double*)malloc(sizeof(double) * bins);
+    p->gain = (double*)malloc(sizeof(double) * bins);
+    p->scratch = (double*)malloc(sizeof(double) * 3 * (size_t)bins);
+    if (!p->idx || !p->frac || !p->gain || !p->scratch) {
+        world_flag_pipeline_destroy(p);
+        return -1;
+    }
+    p->wide_sp = p->scratch + bins;
+    p->wide_ap = p->wide_sp + bins;
+
+    double ratio = warp_ratio(params);
+    double bin_hz = (double)fs / fft_size;
+    double nyquist = fs / 2.0;
+    for (int k = 0; k < bins; k++) {
+        // Positions past the last bin hold it: idx + 1 is the last bin, frac 1
+        double pos = k * ratio;
+        if (pos >= bins - 1) {
+            p->idx[k] = bins - 2;
+            p->frac[k] = 1.0;
+        } else {
+            p->idx[k] = (int32_t)pos;
+            p->frac[k] = pos - p->idx[k];
+        }
+
+        double freq = k * bin_hz;
+        double db = 0.0;
+        if (params->brightness != 0.0) db += brightness_db(params, freq, nyquist);
+        if (params->tilt != 0.0) db += tilt_db(params, freq, bin_hz);
+        p->gain[k] = pow(10.0, db / 10.0);
+    }
+
+    double h = params->breathiness / 100.0;
+    p->ap_scale = h > 0.0 ? 1.0 - h : 1.0 + h;
+    p->ap_offset = h > 0.0 ? h : 0.0;
+
+    *out_pipeline = p;
+    return 0;
+}
+
+int world_flag_pipeline_set_isa(WorldFlagPipeline* pipeline, WorldFlagsIsa isa) {
+    if (!pipeline || isa > world_flags_detect_isa()) return -1;
+    pipeline->isa = isa;
+    return 0;
+}
+
+WorldFlagsIsa world_flag_pipeline_isa(const WorldFlagPipeline* pipeline) {
+    return pipeline ? pipeline->isa : WORLD_FLAGS_ISA_SCALAR;
+}
+
+void world_flag_pipeline_apply_frame(WorldFlagPipeline* pipeline, double* sp_row, double* ap_row) {
+    WorldFlagPipeline* p = pipeline;
+    if (!p->warp_active && !p->gain_active && !p->ap_active) return;
+
+    // The warp reads neighbouring bins, so it works from a copy of the row
+    const double* src = NULL;
+    if (p->warp_active) {
+        memcpy(p->scratch, sp_row, sizeof(double) * p->bins);
+        src = p->scratch;
+    }
+
+    switch (p->isa) {
+#if defined(WORLD_FLAGS_X86)
+        case WORLD_FLAGS_ISA_AVX2: kernel_avx2(p, src, sp_row, ap_row); break;
+        case WORLD_FLAGS_ISA_SSE2: kernel_sse2(p, src, sp_row, ap_row); break;
+#endif
+        default: kernel_scalar(p, src, sp_row, ap_row); break;
+    }
+}
+
+int world_flag_pipeline_apply(WorldFlagPipeline* pipeline, WorldAnalysisData* data) {
+    if (!pipeline || !data || world_analysis_data_is_coded(data)) return -1;
+    if (data->fft_size / 2 + 1 != pipeline->bins) return -1;
+
+    size_t bins = (size_t)pipeline->bins;
+    if (data->precision == WORLD_PRECISION_FLOAT32) {
+        if (!data->spectrogram_f32 || !data->aperiodicity_f32) return -1;
+        for (int i = 0; i < data->sp_length; i++) {
+            simd_convert_f32_to_f64(data->spectrogram_f32[i], pipeline->wide_sp, bins);
+            simd_convert_f32_to_f64(data->aperiodicity_f32[i], pipeline->wide_ap, bins);
+            world_flag_pipeline_apply_frame(pipeline, pipeline->wide_sp, pipeline->wide_ap);
+            simd_convert_f64_to_f32(pipeline->wide_sp, data->spectrogram_f32[i], bins);
+            simd_convert_f64_to_f32(pipeline->wide_ap, data->aperiodicity_f32[i], bins);
+        }
+        return 0;
+    }
+
+    if (!data->spectrogram || !data->aperiodicity) return -1;
+    for (int i = 0; i < data->sp_length; i++) {
+        world_flag_pipeline_apply_frame(pipeline, data->spectrogram[i], data->aperiodicity[i]);
+    }
+    return 0;
+}
+
+void world_flag_pipeline_destroy(WorldFlagPipeline* pipeline) {
+    if (!pipeline) return;
+
+    free(pipeline->idx);
+    free(pipeline->frac);
+    free(pipeline->gain);
+    free(pipeline->scratch);
+    free(pipeline);
+}
+
+void world_flags_apply_reference(const WorldFlagParams* params, int fs, int fft_size,
+                                 double* sp_row, double* ap_row) {
+    int bins = fft_size / 2 + 1;
+    double bin_hz = (double)fs / fft_size;
+    double nyquist = fs / 2.0;
+
+    if (params->gender != 0.0) {
+        double* src = (double*)malloc(sizeof(double) * bins);
+        if (!src) return;
+        memcpy(src, sp_row, sizeof(double) * bins);
+        double ratio = warp_ratio(params);
+        for (int k = 0; k < bins; k++) {
+            double pos = k * ratio;
+            if (pos >= bins - 1) {
+                sp_row[k] = src[bins - 1];
+            } else {
+                int i = (int)pos;
+                sp_row[k] = src[i] + (src[i + 1] - src[i]) * (pos - i);
+            }
+        }
+        free(src);
+    }
+
+    if (params->brightness != 0.0) {
+        for (int k = 0; k < bins; k++) {
+            sp_row[k] *= pow(10.0, brightness_db(params, k * bin_hz, nyquist) / 10.0);
+        }
+    }
+
+    if (params->tilt != 0.0) {
+        for (int k = 0; k < bins; k++) {
+            sp_row[k] *= pow(10.0, tilt_db(params, k * bin_hz, bin_hz) / 10.0);
+        }
+    }
+
+    if (params->breathiness != 0.0) {
+        double h = params->breathiness / 100.0;
+        for (int k = 0; k < bins; k++) {
+            ap_row[k] = h > 0.0 ? ap_row[k] + (1.0 - ap_row[k]) * h : ap_row[k] * (1.0 + h);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file world_flags.h
+ * @brief Fused in-place flag processing on WORLD spectral frames
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * Applies the spectral UTAU flags (gender/formant shift, brightness,
+ * breathiness, tilt) to sp and ap in a single pass per frame. Everything that
+ * depends only on the parameters, sample rate and fft_size -- the formant warp
+ * index/fraction table and the combined brightness/tilt gain curve -- is
+ * computed once when the pipeline is created. The per-frame kernel runs on
+ * AVX2 or SSE2 when the CPU supports it (checked at runtime) and falls back
+ * to scalar code otherwise.
+ */
+#ifndef WORLDX_UCRA_WORLD_FLAGS_H
+#define WORLDX_UCRA_WORLD_FLAGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "world_wrapper.h"
+
+/**
+ * @brief Spectral flag parameters
+ *
+ * All-zero parameters are neutral.
+ */
+typedef struct {
+    /** Formant shift, -100..100; positive lowers formants (up to half an octave) */
+    double gender;
+    /** High-frequency emphasis, -100..100; +-12 dB at Nyquist, ramping from 1 kHz */
+    double brightness;
+    /** -100..100; positive pushes aperiodicity towards 1, negative towards 0 */
+    double breathiness;
+    /** Spectral tilt in dB per octave relative to 1 kHz */
+    double tilt;
+} WorldFlagParams;
+
+/** Instruction set used by the per-frame kernel */
+typedef enum {
+    WORLD_FLAGS_ISA_SCALAR = 0,
+    WORLD_FLAGS_ISA_SSE2 = 1,
+    WORLD_FLAGS_ISA_AVX2 = 2
+} WorldFlagsIsa;
+
+/** Opaque precomputed flag pipeline */
+typedef struct WorldFlagPipeline WorldFlagPipeline;
+
+/** @brief Reset parameters to neutral */
+void world_flag_params_init(WorldFlagParams* params);
+
+/** @brief Best instruction set supported by the running CPU */
+WorldFlagsIsa world_flags_detect_isa(void);
+
+/** @brief Human-readable ISA name */
+const char* world_flags_isa_name(WorldFlagsIsa isa);
+
+/**
+ * @brief Build a pipeline for the given parameters and frame geometry
+ *
+ * The pipeline starts on world_flags_detect_isa().
+ *
+ * @return 0 on success, -1 on failure
+ */
+int world_flag_pipeline_create(WorldFlagPipeline** out_pipeline, const WorldFlagParams* params,
+                               int fs, int fft_size);
+
+/**
+ * @brief Force a kernel instruction set
+ * @return 0 on success, -1 if the CPU does not support it
+ */
+int world_flag_pipeline_set_isa(WorldFlagPipeline* pipeline, WorldFlagsIsa isa);
+
+/** @brief Instruction set the pipeline currently uses */
+WorldFlagsIsa world_flag_pipeline_isa(const WorldFlagPipeline* pipeline);
+
+/**
+ * @brief Apply all active flags to one frame in place
+ *
+ * @param sp_row fft_size/2+1 spectral envelope values
+ * @param ap_row fft_size/2+1 aperiodicity values
+ */
+void world_flag_pipeline_apply_frame(WorldFlagPipeline* pipeline, double* sp_row, double* ap_row);
+
+/**
+ * @brief Apply all active flags to every frame of data in place
+ *
+ * Float32 rows are widened into scratch, processed and narrowed back. Coded
+ * data is rejected; apply flags to decoded frames instead.
+ *
+ * @return 0 on success, -1 on failure (geometry mismatch, coded data)
+ */
+int world_flag_pipeline_apply(WorldFlagPipeline* pipeline, WorldAnalysisData* data);
+
+/** @brief Destroy a pipeline; NULL is ignored */
+void world_flag_pipeline_destroy(WorldFlagPipeline* pipeline);
+
+/**
+ * @brief Unfused scalar reference
+ *
+ * One plain pass per flag, evaluating every curve per bin, exactly as the
+ * flags are specified. Used to validate the fused kernels.
+ */
+void world_flags_apply_reference(const WorldFlagParams* params, int fs, int fft_size,
+                                 double* sp_row, double* ap_row);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLD_FLAGS_H */
@@ -0,0 +1,60 @@
+/**
+ * @file world_noise.h
+ * @brief Private copies of WORLD's randn() generator
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * WORLD draws the noise of D4C, CheapTrick and Synthesis() from randn(): a
+ * single process-wide xorshift128 state, summed over twelve 28-bit draws.
+ * A WorldNoise is the same generator with the state held by the caller, so
+ * every analysis frame or synthesis owns its sequence and calls can run on
+ * any number of threads without sharing it.
+ */
+#ifndef WORLDX_UCRA_WORLD_NOISE_H
+#define WORLDX_UCRA_WORLD_NOISE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/** xorshift128 state of one generator */
+typedef struct {
+    uint32_t x, y, z, w;
+} WorldNoise;
+
+/** @brief Start from the state randn_reseed() restores, as Synthesis() does */
+static inline void world_noise_reset(WorldNoise* noise) {
+    noise->x = 123456789u;
+    noise->y = 362436069u;
+    noise->z = 521288629u;
+    noise->w = 88675123u;
+}
+
+/** @brief Start a sequence keyed by a frame index and a stream number */
+static inline void world_noise_seed(WorldNoise* noise, int frame, uint32_t stream) {
+    world_noise_reset(noise);
+    noise->x ^= (uint32_t)frame * 2654435761u;
+    noise->y ^= stream;
+}
+
+/** @brief Next sample, distributed as randn() (approximately N(0, 1)) */
+static inline double world_noise_next(WorldNoise* noise) {
+    uint32_t sum = 0;
+    for (int i = 0; i < 12; i++) {
+        uint32_t t = noise->x ^ (noise->x << 11);
+        noise->x = noise->y;
+        noise->y = noise->z;
+        noise->z = noise->w;
+        noise->w = (noise->w ^ (noise->w >> 19)) ^ (t ^ (t >> 8));
+        sum += noise->w >> 4;
+    }
+    return sum / 268435456.0 - 6.0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLD_NOISE_H */
@@ -0,0 +1,98 @@
+/**
+ * @file world_quality.c
+ * @brief Objective quality metrics implementation
+ */
+
+#include "world_quality.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Points on the warped frequency axis used to integrate each cepstral term
+#define MCEP_GRID 256
+
+double world_quality_snr_db(const double* ref, const double* test, int length) {
+    if (!ref || !test || length <= 0) return -INFINITY;
+
+    double signal = 0.0, noise = 0.0;
+    for (int i = 0; i < length; i++) {
+        double d = ref[i] - test[i];
+        signal += ref[i] * ref[i];
+        noise += d * d;
+    }
+    if (noise <= 0.0) return INFINITY;
+    if (signal <= 0.0) return -INFINITY;
+    return 10.0 * log10(signal / noise);
+}
+
+// All-pass warping factor approximating the mel scale at a sample rate
+static double mel_alpha(int fs) {
+    if (fs <= 8000) return 0.31;
+    if (fs <= 16000) return 0.42;
+    if (fs <= 22050) return 0.45;
+    if (fs <= 32000) return 0.50;
+    if (fs <= 44100) return 0.53;
+    return 0.55;
+}
+
+// Mel-cepstrum c[1..order] of one power spectrum, integrating the log
+// amplitude over a uniform grid on the warped axis.
+static void frame_mcep(const double* sp, int bins, const double* grid_bin,
+                       const double* cos_table, double* c) {
+    double log_amp[MCEP_GRID];
+    for (int m = 0; m < MCEP_GRID; m++) {
+        double pos = grid_bin[m];
+        int k = (int)pos;
+        if (k >= bins - 1) k = bins - 2;
+        double frac = pos - k;
+        double p = sp[k] + (sp[k + 1] - sp[k]) * frac;
+        log_amp[m] = 0.5 * log(p > 1e-300 ? p : 1e-300);
+    }
+    for (int d = 1; d <= WORLD_QUALITY_MCEP_ORDER; d++) {
+        const double* cosd = cos_table + (size_t)(d - 1) * MCEP_GRID;
+        double acc = 0.0;
+        for (int m = 0; m < MCEP_GRID; m++) acc += log_amp[m] * cosd[m];
+        c[d - 1] = acc / MCEP_GRID;
+    }
+}
+
+double world_quality_mcd_db(const double* const* ref_sp, const double* const* test_sp,
+                            int frames, int fft_size, int fs) {
+    if (!ref_sp || !test_sp || frames <= 0 || fft_size < 4 || fs <= 0) return -1.0;
+
+    int bins = fft_size / 2 + 1;
+    double alpha = mel_alpha(fs);
+    double grid_bin[MCEP_GRID];
+    double* cos_table = (double*)malloc(sizeof(double) * MCEP_GRID * WORLD_QUALITY_MCEP_ORDER);
+    if (!cos_table) return -1.0;
+
+    for (int m = 0; m < MCEP_GRID; m++) {
+        // Uniform point on the warped axis, mapped back to linear frequency
+        double w_mel = M_PI * (m + 0.5) / MCEP_GRID;
+        double w = w_mel - 2.0 * atan(alpha * sin(w_mel) / (1.0 + alpha * cos(w_mel)));
+        grid_bin[m] = w / M_PI * (bins - 1);
+        for (int d = 1; d <= WORLD_QUALITY_MCEP_ORDER; d++) {
+            cos_table[(size_t)(d - 1) * MCEP_GRID + m] = cos(d * w_mel);
+        }
+    }
+
+    const double k_mcd = 10.0 / log(10.0) * sqrt(2.0);
+    double c_ref[WORLD_QUALITY_MCEP_ORDER], c_test[WORLD_QUALITY_MCEP_ORDER];
+    double total = 0.0;
+    for (int i = 0; i < frames; i++) {
+        frame_mcep(ref_sp[i], bins, grid_bin, cos_table, c_ref);
+        frame_mcep(test_sp[i], bins, grid_bin, cos_table, c_test);
+        double sum = 0.0;
+        for (int d = 0; d < WORLD_QUALITY_MCEP_ORDER; d++) {
+            double diff = c_ref[d] - c_test[d];
+            sum += diff * diff;
+        }
+        total += k_mcd * sqrt(sum);
+    }
+
+    free(cos_table);
+    return total / frames;
+}
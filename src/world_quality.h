@@ -0,0 +1,46 @@
+/**
+ * @file world_quality.h
+ * @brief Objective quality metrics for lossy storage modes
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * SNR and mel-cepstral distortion (MCD) helpers used to hold every reduced
+ * precision or coded representation to the PRD re-synthesis thresholds.
+ */
+#ifndef WORLDX_UCRA_WORLD_QUALITY_H
+#define WORLDX_UCRA_WORLD_QUALITY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** PRD threshold: minimum SNR against the WORLD re-synthesis reference */
+#define WORLD_QUALITY_MIN_SNR_DB 25.0
+/** PRD threshold: maximum mel-cepstral distortion */
+#define WORLD_QUALITY_MAX_MCD_DB 4.5
+/** Mel-cepstrum order used for MCD (c1..c24, c0 excluded) */
+#define WORLD_QUALITY_MCEP_ORDER 24
+
+/**
+ * @brief Signal-to-noise ratio of test against ref
+ * @return SNR in dB (INFINITY when identical)
+ */
+double world_quality_snr_db(const double* ref, const double* test, int length);
+
+/**
+ * @brief Mean mel-cepstral distortion between two spectrogram sequences
+ *
+ * Both inputs are WORLD power spectra ([frame][fft_size/2+1]). Each frame is
+ * warped onto the mel scale with a first-order all-pass (alpha chosen from
+ * fs) and converted to a WORLD_QUALITY_MCEP_ORDER mel-cepstrum.
+ *
+ * @return Mean MCD in dB over frames, or -1.0 on invalid input
+ */
+double world_quality_mcd_db(const double* const* ref_sp, const double* const* test_sp,
+                            int frames, int fft_size, int fs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLD_QUALITY_H */
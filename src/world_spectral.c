@@ -0,0 +1,595 @@
+/**
+ * @file world_spectral.c
+ * @brief CheapTrick and D4C frame analysis implementation
+ *
+ * Follows WORLD's cheaptrick.cpp, d4c.cpp and the helpers they use from
+ * common.cpp and matlabfunctions.cpp step by step, with every temporary
+ * array moved into WorldSpectralWork.
+ */
+
+#include "world_spectral.h"
+#include "world_noise.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "world/common.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// WORLD's constantnumbers.h
+#define WORLD_SAFEGUARD_MINIMUM 0.000000000001
+#define WORLD_EPS 0.00000000000000022204460492503131
+#define WORLD_DEFAULT_F0 500.0
+#define WORLD_LOG2 0.69314718055994529
+#define WORLD_D4C_FLOOR_F0 47.0
+#define WORLD_D4C_FREQUENCY_INTERVAL 3000.0
+#define WORLD_D4C_UPPER_LIMIT 15000.0
+// Lowest F0 of D4C's voiced/unvoiced decision (D4CLoveTrain)
+#define WORLD_D4C_LOVE_TRAIN_F0 40.0
+
+typedef enum { WINDOW_HANNING, WINDOW_BLACKMAN } WindowType;
+
+struct WorldSpectralWork {
+    int fs;
+    int fft_size;
+    double q1;
+    double threshold;
+    double f0_floor;
+    size_t bytes;
+
+    // CheapTrick
+    ForwardRealFFT forward;
+    InverseRealFFT inverse;
+    double* smoothing_lifter;
+    double* compensation_lifter;
+
+    // D4C general body, and the FFT of its voiced/unvoiced decision
+    int d4c_fft_size;
+    ForwardRealFFT d4c_forward;
+    int love_fft_size;
+    ForwardRealFFT love_forward;
+    int love_boundary[3];
+    int number_of_aperiodicities;
+    int nuttall_length;
+    double* nuttall;
+    double* coarse_frequency_axis;
+    double* coarse_aperiodicity;
+    double* frequency_axis;
+    double* tmp_real;
+    double* tmp_imag;
+    double* static_centroid;
+    double* centroid;
+    double* smoothed_power_spectrum;
+    double* static_group_delay;
+    double* smoothed_group_delay;
+    double* power_spectrum;
+
+    // Shared by both: F0-adaptive window, LinearSmoothing() and DCCorrection()
+    double* window;
+    double* mirroring_spectrum;
+    double* mirroring_segment;
+    double* smoothing_axis;
+    double* low_levels;
+    double* high_levels;
+    double* low_frequency_axis;
+    double* low_frequency_replica;
+
+    double* slab;
+};
+
+// matlab_round()
+static int round_to_int(double x) {
+    return x > 0 ? (int)(x + 0.5) : (int)(x - 0.5);
+}
+
+// interp1Q(): y sampled at x0 + i * dx, read at xi
+static void interp1q(double x0, double dx, const double* y, int y_length,
+                     const double* xi, int xi_length, double* yi) {
+    for (int i = 0; i < xi_length; i++) {
+        int base = (int)((xi[i] - x0) / dx);
+        double fraction = (xi[i] - x0) / dx - base;
+        double delta = base < y_length - 1 ? y[base + 1] - y[base] : 0.0;
+        yi[i] = y[base] + delta * fraction;
+    }
+}
+
+// interp1() for ascending xi, walking the segments instead of running histc()
+static void interp1(const double* x, const double* y, int x_length,
+                    const double* xi, int xi_length, double* yi) {
+    int k = 1;
+    for (int i = 0; i < xi_length; i++) {
+        while (k < x_length - 1 && xi[i] >= x[k]) k++;
+        double s = (xi[i] - x[k - 1]) / (x[k] - x[k - 1]);
+        yi[i] = y[k - 1] + s * (y[k] - y[k - 1]);
+    }
+}
+
+// In-place ascending heap sort (qsort() may allocate)
+static void sift_down(double* v, int root, int count) {
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && v[child + 1] > v[child]) child++;
+        if (v[root] >= v[child]) return;
+        double t = v[root];
+        v[root] = v[child];
+        v[child] = t;
+        root = child;
+    }
+}
+
+static void sort_ascending(double* v, int count) {
+    for (int i = count / 2 - 1; i >= 0; i--) sift_down(v, i, count);
+    for (int end = count - 1; end > 0; end--) {
+        double t = v[0];
+        v[0] = v[end];
+        v[end] = t;
+        sift_down(v, 0, end);
+    }
+}
+
+// LinearSmoothing(); output may alias input
+static void linear_smoothing(WorldSpectralWork* work, const double* input, double width,
+                             int fft_size, double* output) {
+    int fs = work->fs;
+    int half = fft_size / 2;
+    int boundary = (int)(width * fft_size / fs) + 1;
+    double* mirroring_spectrum = work->mirroring_spectrum;
+    double* mirroring_segment = work->mirroring_segment;
+    double* frequency_axis = work->smoothing_axis;
+
+    for (int i = 0; i < boundary; i++) {
+        mirroring_spectrum[i] = input[boundary - i];
+    }
+    for (int i = boundary; i < half + boundary; i++) {
+        mirroring_spectrum[i] = input[i - boundary];
+    }
+    for (int i = half + boundary; i <= half + boundary * 2; i++) {
+        mirroring_spectrum[i] = input[half - (i - (half + boundary))];
+    }
+
+    mirroring_segment[0] = mirroring_spectrum[0] * fs / fft_size;
+    for (int i = 1; i < half + boundary * 2 + 1; i++) {
+        mirroring_segment[i] = mirroring_spectrum[i] * fs / fft_size + mirroring_segment[i - 1];
+    }
+    for (int i = 0; i <= half; i++) {
+        frequency_axis[i] = (double)i / fft_size * fs - width / 2.0;
+    }
+
+    double origin_of_mirroring_axis = -(boundary - 0.5) * fs / fft_size;
+    double discrete_frequency_interval = (double)fs / fft_size;
+    interp1q(origin_of_mirroring_axis, discrete_frequency_interval, mirroring_segment,
+             half + boundary * 2 + 1, frequency_axis, half + 1, work->low_levels);
+    for (int i = 0; i <= half; i++) frequency_axis[i] += width;
+    interp1q(origin_of_mirroring_axis, discrete_frequency_interval, mirroring_segment,
+             half + boundary * 2 + 1, frequency_axis, half + 1, work->high_levels);
+
+    for (int i = 0; i <= half; i++) {
+        output[i] = (work->high_levels[i] - work->low_levels[i]) / width;
+    }
+}
+
+// DCCorrection(); output may alias input
+static void dc_correction(WorldSpectralWork* work, const double* input, double f0,
+                          int fft_size, double* output) {
+    int fs = work->fs;
+    int upper_limit = 2 + (int)(f0 * fft_size / fs);
+    double* low_frequency_axis = work->low_frequency_axis;
+    double* low_frequency_replica = work->low_frequency_replica;
+
+    for (int i = 0; i < upper_limit; i++) {
+        low_frequency_axis[i] = (double)i * fs / fft_size;
+    }
+    int upper_limit_replica = upper_limit - 1;
+    interp1q(f0 - low_frequency_axis[0], -(double)fs / fft_size, input, upper_limit + 1,
+             low_frequency_axis, upper_limit_replica, low_frequency_replica);
+
+    for (int i = 0; i < upper_limit_replica; i++) {
+        output[i] = input[i] + low_frequency_replica[i];
+    }
+}
+
+// F0-adaptive windowing shared by CheapTrick (Hanning, normalized to unit
+// energy) and D4C; fills waveform[0, 2 * half + 1) and returns half
+static int windowed_waveform(WorldSpectralWork* work, const double* x, int x_length, double f0,
+                             double position, int half, WindowType type,
+                             double window_length_ratio, int normalize, WorldNoise* noise,
+                             double* waveform) {
+    int fs = work->fs;
+    int length = half * 2 + 1;
+    int origin = round_to_int(position * fs + 0.001);
+    double* window = work->window;
+
+    double average = 0.0;
+    for (int i = 0; i < length; i++) {
+        int base = i - half;
+        if (normalize) {
+            double t = base / 1.5 / fs;
+            window[i] = 0.5 * cos(M_PI * t * f0) + 0.5;
+            average += window[i] * window[i];
+        } else {
+            double t = (2.0 * base / window_length_ratio) / fs;
+            window[i] = type == WINDOW_HANNING
+                            ? 0.5 * cos(M_PI * t * f0) + 0.5
+                            : 0.42 + 0.5 * cos(M_PI * t * f0) + 0.08 * cos(M_PI * t * f0 * 2);
+        }
+    }
+    if (normalize) {
+        average = sqrt(average);
+        for (int i = 0; i < length; i++) window[i] /= average;
+    }
+
+    for (int i = 0; i < length; i++) {
+        int index = origin + i - half;
+        if (index < 0) index = 0;
+        if (index > x_length - 1) index = x_length - 1;
+        waveform[i] = x[index] * window[i] + world_noise_next(noise) * WORLD_SAFEGUARD_MINIMUM;
+    }
+
+    double weight_waveform = 0.0, weight_window = 0.0;
+    for (int i = 0; i < length; i++) {
+        weight_waveform += waveform[i];
+        weight_window += window[i];
+    }
+    double coefficient = weight_waveform / weight_window;
+    for (int i = 0; i < length; i++) waveform[i] -= window[i] * coefficient;
+    return half;
+}
+
+// CheapTrickGeneralBody()
+static void cheaptrick_frame(WorldSpectralWork* work, const double* x, int x_length, double f0,
+                             double position, WorldNoise* noise, double* spectral_envelope) {
+    int fs = work->fs;
+    int fft_size = work->fft_size;
+    int half_fft = fft_size / 2;
+    ForwardRealFFT* forward = &work->forward;
+    InverseRealFFT* inverse = &work->inverse;
+    double* waveform = forward->waveform;
+
+    // Windowing, then the power spectrum with DC correction
+    int half = windowed_waveform(work, x, x_length, f0, position, round_to_int(1.5 * fs / f0),
+                                 WINDOW_HANNING, 3.0, 1, noise, waveform);
+    for (int i = half * 2 + 1; i < fft_size; i++) waveform[i] = 0.0;
+    fft_execute(forward->forward_fft);
+    for (int i = 0; i <= half_fft; i++) {
+        waveform[i] = forward->spectrum[i][0] * forward->spectrum[i][0] +
+                      forward->spectrum[i][1] * forward->spectrum[i][1];
+    }
+    dc_correction(work, waveform, f0, fft_size, waveform);
+
+    // Linear-axis smoothing plus infinitesimal noise, so no bin is zero
+    linear_smoothing(work, waveform, f0 * 2.0 / 3.0, fft_size, waveform);
+    for (int i = 0; i <= half_fft; i++) {
+        waveform[i] = waveform[i] + fabs(world_noise_next(noise)) * WORLD_EPS;
+    }
+
+    // Log-axis smoothing and spectral recovery on the cepstrum
+    double* smoothing_lifter = work->smoothing_lifter;
+    double* compensation_lifter = work->compensation_lifter;
+    double q1 = work->q1;
+    smoothing_lifter[0] = 1.0;
+    compensation_lifter[0] = (1.0 - 2.0 * q1) + 2.0 * q1;
+    for (int i = 1; i <= half_fft; i++) {
+        double quefrency = (double)i / fs;
+        smoothing_lifter[i] = sin(M_PI * f0 * quefrency) / (M_PI * f0 * quefrency);
+        compensation_lifter[i] = (1.0 - 2.0 * q1) + 2.0 * q1 * cos(2.0 * M_PI * quefrency * f0);
+    }
+
+    for (int i = 0; i <= half_fft; i++) waveform[i] = log(waveform[i]);
+    for (int i = 1; i < half_fft; i++) waveform[fft_size - i] = waveform[i];
+    fft_execute(forward->forward_fft);
+
+    for (int i = 0; i <= half_fft; i++) {
+        inverse->spectrum[i][0] =
+            forward->spectrum[i][0] * smoothing_lifter[i] * compensation_lifter[i] / fft_size;
+        inverse->spectrum[i][1] = 0.0;
+    }
+    fft_execute(inverse->inverse_fft);
+
+    for (int i = 0; i <= half_fft; i++) {
+        spectral_envelope[i] = exp(inverse->waveform[i]);
+    }
+}
+
+// GetCentroid(): energy centroid of the Blackman-windowed segment
+static void centroid_at(WorldSpectralWork* work, const double* x, int x_length, double f0,
+                        double position, WorldNoise* noise, double* centroid) {
+    int fs = work->fs;
+    int fft_size = work->d4c_fft_size;
+    ForwardRealFFT* forward = &work->d4c_forward;
+    double* waveform = forward->waveform;
+
+    for (int i = 0; i < fft_size; i++) waveform[i] = 0.0;
+    windowed_waveform(work, x, x_length, f0, position, round_to_int(4.0 * fs / f0 / 2.0),
+                      WINDOW_BLACKMAN, 4.0, 0, noise, waveform);
+    int last = round_to_int(2.0 * fs / f0) * 2;
+    double power = 0.0;
+    for (int i = 0; i <= last; i++) power += waveform[i] * waveform[i];
+    for (int i = 0; i <= last; i++) waveform[i] /= sqrt(power);
+
+    fft_execute(forward->forward_fft);
+    for (int i = 0; i <= fft_size / 2; i++) {
+        work->tmp_real[i] = forward->spectrum[i][0];
+        work->tmp_imag[i] = forward->spectrum[i][1];
+    }
+
+    for (int i = 0; i < fft_size; i++) waveform[i] *= i + 1.0;
+    fft_execute(forward->forward_fft);
+    for (int i = 0; i <= fft_size / 2; i++) {
+        centroid[i] = forward->spectrum[i][0] * work->tmp_real[i] +
+                      work->tmp_imag[i] * forward->spectrum[i][1];
+    }
+}
+
+// D4CLoveTrainSub(): ratio of the cumulative power up to 4 kHz and 7.9 kHz
+static double love_train_ratio(WorldSpectralWork* work, const double* x, int x_length, double f0,
+                               double position, WorldNoise* noise) {
+    int fs = work->fs;
+    int fft_size = work->love_fft_size;
+    ForwardRealFFT* forward = &work->love_forward;
+    double* power_spectrum = work->power_spectrum;
+    int boundary0 = work->love_boundary[0];
+    int boundary1 = work->love_boundary[1];
+    int boundary2 = work->love_boundary[2];
+
+    int window_length = round_to_int(1.5 * fs / f0) * 2 + 1;
+    windowed_waveform(work, x, x_length, f0, position, round_to_int(3.0 * fs / f0 / 2.0),
+                      WINDOW_BLACKMAN, 3.0, 0, noise, forward->waveform);
+    for (int i = window_length; i < fft_size; i++) forward->waveform[i] = 0.0;
+    fft_execute(forward->forward_fft);
+
+    for (int i = 0; i <= boundary0; i++) power_spectrum[i] = 0.0;
+    for (int i = boundary0 + 1; i < fft_size / 2 + 1; i++) {
+        power_spectrum[i] = forward->spectrum[i][0] * forward->spectrum[i][0] +
+                            forward->spectrum[i][1] * forward->spectrum[i][1];
+    }
+    for (int i = boundary0; i <= boundary2; i++) power_spectrum[i] += power_spectrum[i - 1];
+
+    return power_spectrum[boundary1] / power_spectrum[boundary2];
+}
+
+// D4CGeneralBody(): coarse aperiodicity in 3 kHz bands from the group delay
+static void d4c_general_body(WorldSpectralWork* work, const double* x, int x_length, double f0,
+                             double position, WorldNoise* noise, double* coarse_aperiodicity) {
+    int fs = work->fs;
+    int fft_size = work->d4c_fft_size;
+    int half_fft = fft_size / 2;
+    ForwardRealFFT* forward = &work->d4c_forward;
+    double* static_centroid = work->static_centroid;
+    double* smoothed_power_spectrum = work->smoothed_power_spectrum;
+    double* static_group_delay = work->static_group_delay;
+
+    // Temporally static centroid
+    centroid_at(work, x, x_length, f0, position - 0.25 / f0, noise, static_centroid);
+    centroid_at(work, x, x_length, f0, position + 0.25 / f0, noise, work->centroid);
+    for (int i = 0; i <= half_fft; i++) static_centroid[i] += work->centroid[i];
+    dc_correction(work, static_centroid, f0, fft_size, static_centroid);
+
+    // Smoothed power spectrum
+    for (int i = 0; i < fft_size; i++) forward->waveform[i] = 0.0;
+    windowed_waveform(work, x, x_length, f0, position, round_to_int(4.0 * fs / f0 / 2.0),
+                      WINDOW_HANNING, 4.0, 0, noise, forward->waveform);
+    fft_execute(forward->forward_fft);
+    for (int i = 0; i <= half_fft; i++) {
+        smoothed_power_spectrum[i] = forward->spectrum[i][0] * forward->spectrum[i][0] +
+                                     forward->spectrum[i][1] * forward->spectrum[i][1];
+    }
+    dc_correction(work, smoothed_power_spectrum, f0, fft_size, smoothed_power_spectrum);
+    linear_smoothing(work, smoothed_power_spectrum, f0, fft_size, smoothed_power_spectrum);
+
+    // Static group delay
+    for (int i = 0; i <= half_fft; i++) {
+        static_group_delay[i] = static_centroid[i] / smoothed_power_spectrum[i];
+    }
+    linear_smoothing(work, static_group_delay, f0 / 2.0, fft_size, static_group_delay);
+    linear_smoothing(work, static_group_delay, f0, fft_size, work->smoothed_group_delay);
+    for (int i = 0; i <= half_fft; i++) static_group_delay[i] -= work->smoothed_group_delay[i];
+
+    // Coarse aperiodicity
+    int window_length = work->nuttall_length;
+    int half_window_length = window_length / 2;
+    int boundary = round_to_int(fft_size * 8.0 / window_length);
+    double* power_spectrum = work->power_spectrum;
+    for (int i = 0; i < fft_size; i++) forward->waveform[i] = 0.0;
+    for (int i = 0; i < work->number_of_aperiodicities; i++) {
+        int center = (int)(WORLD_D4C_FREQUENCY_INTERVAL * (i + 1) * fft_size / fs);
+        for (int j = 0; j <= half_window_length * 2; j++) {
+            forward->waveform[j] =
+                static_group_delay[center - half_window_length + j] * work->nuttall[j];
+        }
+        fft_execute(forward->forward_fft);
+        for (int j = 0; j <= half_fft; j++) {
+            power_spectrum[j] = forward->spectrum[j][0] * forward->spectrum[j][0] +
+                                forward->spectrum[j][1] * forward->spectrum[j][1];
+        }
+        sort_ascending(power_spectrum, half_fft + 1);
+        for (int j = 1; j <= half_fft; j++) power_spectrum[j] += power_spectrum[j - 1];
+        coarse_aperiodicity[i] =
+            10 * log10(power_spectrum[half_fft - boundary - 1] / power_spectrum[half_fft]);
+    }
+
+    // Revision of the result based on the F0
+    for (int i = 0; i < work->number_of_aperiodicities; i++) {
+        double revised = coarse_aperiodicity[i] + (f0 - 100) / 50.0;
+        coarse_aperiodicity[i] = revised < 0.0 ? revised : 0.0;
+    }
+}
+
+static void d4c_frame(WorldSpectralWork* work, const double* x, int x_length, double f0,
+                      double position, WorldNoise* noise, double* aperiodicity) {
+    int bins = work->fft_size / 2 + 1;
+    int voiced = f0 != 0.0;
+    if (voiced) {
+        double love_f0 = f0 > WORLD_D4C_LOVE_TRAIN_F0 ? f0 : WORLD_D4C_LOVE_TRAIN_F0;
+        voiced = love_train_ratio(work, x, x_length, love_f0, position, noise) > work->threshold;
+    }
+    if (!voiced) {
+        for (int i = 0; i < bins; i++) aperiodicity[i] = 1.0 - WORLD_SAFEGUARD_MINIMUM;
+        return;
+    }
+
+    double body_f0 = f0 > WORLD_D4C_FLOOR_F0 ? f0 : WORLD_D4C_FLOOR_F0;
+    d4c_general_body(work, x, x_length, body_f0, position, noise, &work->coarse_aperiodicity[1]);
+
+    // Linear interpolation of the coarse bands onto the spectral bins
+    interp1(work->coarse_frequency_axis, work->coarse_aperiodicity,
+            work->number_of_aperiodicities + 2, work->frequency_axis, bins, aperiodicity);
+    for (int i = 0; i < bins; i++) aperiodicity[i] = pow(10.0, aperiodicity[i] / 20.0);
+}
+
+void world_spectral_analyze(WorldSpectralWork* work, const double* x, int x_length,
+                            const double* temporal_positions, const double* f0,
+                            int begin, int end, double** spectrogram, double** aperiodicity) {
+    if (!work || !x || x_length <= 0) return;
+
+    double f0_limit = work->fs / 4.0;
+    for (int i = begin; i < end; i++) {
+        double frame_f0 = f0[i] > f0_limit ? f0_limit : f0[i];
+        WorldNoise noise;
+
+        world_noise_seed(&noise, i, 1u);
+        double cheaptrick_f0 = frame_f0 <= work->f0_floor ? WORLD_DEFAULT_F0 : frame_f0;
+        cheaptrick_frame(work, x, x_length, cheaptrick_f0, temporal_positions[i], &noise,
+                         spectrogram[i]);
+
+        world_noise_seed(&noise, i, 2u);
+        d4c_frame(work, x, x_length, frame_f0, temporal_positions[i], &noise, aperiodicity[i]);
+    }
+}
+
+// 2^(1 + floor(log2(ratio * fs / f0 + 1))), as WORLD sizes its FFTs
+static int fft_size_for(int fs, double ratio, double f0) {
+    return (int)pow(2.0, 1.0 + (int)(log(ratio * fs / f0 + 1) / WORLD_LOG2));
+}
+
+static double* take(double** cursor, size_t count) {
+    double* p = *cursor;
+    *cursor += count;
+    return p;
+}
+
+int world_spectral_work_create(WorldSpectralWork** out_work, int fs, int fft_size,
+                               double q1, double threshold) {
+    if (!out_work) return -1;
+    *out_work = NULL;
+    if (fs <= 0 || fft_size < 8 || (fft_size & (fft_size - 1)) != 0) return -1;
+
+    WorldSpectralWork* work = (WorldSpectralWork*)calloc(1, sizeof(WorldSpectralWork));
+    if (!work) return -1;
+    work->fs = fs;
+    work->fft_size = fft_size;
+    work->q1 = q1;
+    work->threshold = threshold;
+    work->f0_floor = 3.0 * fs / (fft_size - 3.0);
+    work->d4c_fft_size = fft_size_for(fs, 4.0, WORLD_D4C_FLOOR_F0);
+    work->love_fft_size = fft_size_for(fs, 3.0, WORLD_D4C_LOVE_TRAIN_F0);
+    work->love_boundary[0] = (int)ceil(100.0 * work->love_fft_size / fs);
+    work->love_boundary[1] = (int)ceil(4000.0 * work->love_fft_size / fs);
+    work->love_boundary[2] = (int)ceil(7900.0 * work->love_fft_size / fs);
+    // Below 15.8 kHz the 7.9 kHz boundary lies past Nyquist, where WORLD
+    // reads uninitialized bins; stop at Nyquist instead
+    for (int i = 0; i < 3; i++) {
+        if (work->love_boundary[i] > work->love_fft_size / 2) {
+            work->love_boundary[i] = work->love_fft_size / 2;
+        }
+    }
+    double upper = fs / 2.0 - WORLD_D4C_FREQUENCY_INTERVAL;
+    if (upper > WORLD_D4C_UPPER_LIMIT) upper = WORLD_D4C_UPPER_LIMIT;
+    work->number_of_aperiodicities = (int)(upper / WORLD_D4C_FREQUENCY_INTERVAL);
+    if (work->number_of_aperiodicities < 0) work->number_of_aperiodicities = 0;
+    work->nuttall_length =
+        (int)(WORLD_D4C_FREQUENCY_INTERVAL * work->d4c_fft_size / fs) * 2 + 1;
+
+    // Every array lives in one slab, sized for the largest FFT in use.
+    // F0 is capped at fs / 4, so smoothing widths stay below a quarter of
+    // the bins.
+    int largest = fft_size;
+    if (work->d4c_fft_size > largest) largest = work->d4c_fft_size;
+    if (work->love_fft_size > largest) largest = work->love_fft_size;
+    size_t bins = (size_t)(fft_size / 2 + 1);
+    size_t d4c_bins = (size_t)(work->d4c_fft_size / 2 + 1);
+    size_t large = (size_t)largest;
+    size_t bands = (size_t)work->number_of_aperiodicities + 2;
+    size_t power = d4c_bins > (size_t)work->love_fft_size ? d4c_bins : (size_t)work->love_fft_size;
+    size_t total = 2 * bins                                   // lifters
+                   + (size_t)work->nuttall_length + 2 * bands + bins  // D4C axes and window
+                   + 7 * d4c_bins + power                     // D4C spectra
+                   + large + 1                                // F0-adaptive window
+                   + 2 * (large + large / 2 + 4)              // LinearSmoothing mirrors
+                   + 3 * (large / 2 + 1)                      // LinearSmoothing axis and levels
+                   + 2 * (large / 2 + 3);                     // DCCorrection
+    work->slab = (double*)calloc(total, sizeof(double));
+    if (!work->slab) {
+        free(work);
+        return -1;
+    }
+    double* cursor = work->slab;
+    work->smoothing_lifter = take(&cursor, bins);
+    work->compensation_lifter = take(&cursor, bins);
+    work->nuttall = take(&cursor, (size_t)work->nuttall_length);
+    work->coarse_frequency_axis = take(&cursor, bands);
+    work->coarse_aperiodicity = take(&cursor, bands);
+    work->frequency_axis = take(&cursor, bins);
+    work->tmp_real = take(&cursor, d4c_bins);
+    work->tmp_imag = take(&cursor, d4c_bins);
+    work->static_centroid = take(&cursor, d4c_bins);
+    work->centroid = take(&cursor, d4c_bins);
+    work->smoothed_power_spectrum = take(&cursor, d4c_bins);
+    work->static_group_delay = take(&cursor, d4c_bins);
+    work->smoothed_group_delay = take(&cursor, d4c_bins);
+    work->power_spectrum = take(&cursor, power);
+    work->window = take(&cursor, large + 1);
+    work->mirroring_spectrum = take(&cursor, large + large / 2 + 4);
+    work->mirroring_segment = take(&cursor, large + large / 2 + 4);
+    work->smoothing_axis = take(&cursor, large / 2 + 1);
+    work->low_levels = take(&cursor, large / 2 + 1);
+    work->high_levels = take(&cursor, large / 2 + 1);
+    work->low_frequency_axis = take(&cursor, large / 2 + 3);
+    work->low_frequency_replica = take(&cursor, large / 2 + 3);
+    work->bytes = sizeof(WorldSpectralWork) + sizeof(double) * total;
+
+    // Nuttall window, coarse band axis and bin axis of the aperiodicity
+    for (int i = 0; i < work->nuttall_length; i++) {
+        double t = i / (work->nuttall_length - 1.0);
+        work->nuttall[i] = 0.355768 - 0.487396 * cos(2.0 * M_PI * t) +
+                           0.144232 * cos(4.0 * M_PI * t) - 0.012604 * cos(6.0 * M_PI * t);
+    }
+    int n = work->number_of_aperiodicities;
+    work->coarse_aperiodicity[0] = -60.0;
+    work->coarse_aperiodicity[n + 1] = -WORLD_SAFEGUARD_MINIMUM;
+    for (int i = 0; i <= n; i++) {
+        work->coarse_frequency_axis[i] = i * WORLD_D4C_FREQUENCY_INTERVAL;
+    }
+    work->coarse_frequency_axis[n + 1] = fs / 2.0;
+    for (size_t i = 0; i < bins; i++) {
+        work->frequency_axis[i] = (double)i * fs / fft_size;
+    }
+
+    InitializeForwardRealFFT(fft_size, &work->forward);
+    InitializeInverseRealFFT(fft_size, &work->inverse);
+    InitializeForwardRealFFT(work->d4c_fft_size, &work->d4c_forward);
+    InitializeForwardRealFFT(work->love_fft_size, &work->love_forward);
+    work->bytes += (sizeof(double) + sizeof(fft_complex)) *
+                   (2 * (size_t)fft_size + (size_t)work->d4c_fft_size + (size_t)work->love_fft_size);
+
+    *out_work = work;
+    return 0;
+}
+
+size_t world_spectral_work_bytes(const WorldSpectralWork* work) {
+    return work ? work->bytes : 0;
+}
+
+void world_spectral_work_destroy(WorldSpectralWork* work) {
+    if (!work) return;
+
+    DestroyForwardRealFFT(&work->forward);
+    DestroyInverseRealFFT(&work->inverse);
+    DestroyForwardRealFFT(&work->d4c_forward);
+    DestroyForwardRealFFT(&work->love_forward);
+    free(work->slab);
+    free(work);
+}
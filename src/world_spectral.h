@@ -0,0 +1,77 @@
+/**
+ * @file world_spectral.h
+ * @brief CheapTrick and D4C frame analysis on preallocated plans and buffers
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * WORLD's CheapTrick() and D4C() build their FFT plans and work arrays on
+ * every call (and allocate again inside every frame), and both add their
+ * safeguard noise from WORLD's process-wide randn() generator, so two calls
+ * running at the same time race on its state. A WorldSpectralWork holds the
+ * plans and buffers of the same per-frame computation, so analyzing frames
+ * allocates nothing, and seeds a private generator from the frame index, so
+ * a frame's envelope and aperiodicity depend only on the signal, its F0 and
+ * position, and its index: any split of the frames over any number of
+ * threads gives bit-identical results.
+ *
+ * The safeguard noise itself (kMySafeGuardMinimum, about 1e-12, and kEps
+ * after smoothing) is drawn from the same distribution as randn(); only the
+ * sequence differs from a WORLD call. test_world_spectral.c holds the
+ * results to CheapTrick() and D4C() on 16-bit signals: envelopes within
+ * 1e-4 in natural log (1e-2 where they approach 1e-9 and the kEps noise
+ * shows), aperiodicity within 1e-5, identical voicing decisions.
+ *
+ * Two inputs on which WORLD reads memory it never wrote are defined here:
+ * - F0 above fs / 4 is analyzed at fs / 4 (WORLD's smoothing reads past
+ *   its spectra there).
+ * - Below 15.8 kHz, the 7.9 kHz boundary of D4C's voiced/unvoiced decision
+ *   is past Nyquist; it stops at Nyquist, as if WORLD's unwritten bins held
+ *   no power.
+ */
+#ifndef WORLDX_UCRA_WORLD_SPECTRAL_H
+#define WORLDX_UCRA_WORLD_SPECTRAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/** Opaque per-thread CheapTrick/D4C work state */
+typedef struct WorldSpectralWork WorldSpectralWork;
+
+/**
+ * @brief Create work state for one sample rate and CheapTrick fft_size
+ *
+ * @param out_work Receives the new work state
+ * @param fs Sample rate
+ * @param fft_size CheapTrick fft_size; rows have fft_size / 2 + 1 bins
+ * @param q1 CheapTrick spectral recovery parameter (CheapTrickOption.q1)
+ * @param threshold D4C voiced/unvoiced threshold (D4COption.threshold)
+ * @return 0 on success, -1 on failure
+ */
+int world_spectral_work_create(WorldSpectralWork** out_work, int fs, int fft_size,
+                               double q1, double threshold);
+
+/** @brief Bytes held by the work state */
+size_t world_spectral_work_bytes(const WorldSpectralWork* work);
+
+/**
+ * @brief Analyze frames [begin, end) into spectrogram[i] and aperiodicity[i]
+ *
+ * Same as CheapTrick() followed by D4C() on those frames, with the two
+ * deviations above: F0 limited to fs / 4, and the voicing decision limited
+ * to Nyquist.
+ */
+void world_spectral_analyze(WorldSpectralWork* work, const double* x, int x_length,
+                            const double* temporal_positions, const double* f0,
+                            int begin, int end, double** spectrogram, double** aperiodicity);
+
+/** @brief Destroy work state; NULL is ignored */
+void world_spectral_work_destroy(WorldSpectralWork* work);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLD_SPECTRAL_H */
@@ -0,0 +1,230 @@
+/**
+ * @file world_stretch.c
+ * @brief Zero-copy time-stretch frame views implementation
+ */
+
+#include "world_stretch.h"
+#include "world_synth_stream.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Positions this close to a source frame use it directly
+#define WORLD_STRETCH_SNAP 1e-6
+
+// Block size world_frame_view_synthesize() streams with
+#define WORLD_STRETCH_SYNTH_BLOCK_SIZE 512
+
+void world_stretch_params_init(WorldStretchParams* params) {
+    if (!params) return;
+
+    params->offset_ms = 0.0;
+    params->consonant_ms = 0.0;
+    params->cutoff_ms = 0.0;
+    params->length_ms = 0.0;
+    params->consonant_scale = 1.0;
+    params->interp_threshold_db = 0.5;
+}
+
+void world_frame_view_init(WorldFrameView* view) {
+    if (!view) return;
+    memset(view, 0, sizeof(*view));
+}
+
+void world_frame_view_free(WorldFrameView* view) {
+    if (!view) return;
+
+    free(view->f0);
+    free(view->spectrogram);
+    free(view->aperiodicity);
+    free(view->interp_slab);
+    free(view->pair_distance);
+    world_frame_view_init(view);
+}
+
+// Source regions in ms, clamped to the analysis
+typedef struct {
+    double start;       // offset
+    double fixed_end;   // end of the consonant region
+    double region_end;  // end of the usable (vowel) region
+    double fixed_out;   // consonant region length in the output
+    double length;      // output length
+    double scale;       // consonant playback rate
+} NoteMap;
+
+static double clamp(double v, double lo, double hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void note_map_init(NoteMap* map, const WorldStretchParams* p, double source_ms) {
+    map->scale = p->consonant_scale > 0.0 ? p->consonant_scale : 1.0;
+    map->start = clamp(p->offset_ms, 0.0, source_ms);
+    map->fixed_end = clamp(map->start + p->consonant_ms, map->start, source_ms);
+    double region_end = p->cutoff_ms < 0.0 ? map->start - p->cutoff_ms : source_ms - p->cutoff_ms;
+    map->region_end = clamp(region_end, map->fixed_end, source_ms);
+    map->fixed_out = (map->fixed_end - map->start) / map->scale;
+    map->length = p->length_ms;
+}
+
+// Source time (ms) shown at output time t_ms
+static double note_map_source_ms(const NoteMap* map, double t_ms) {
+    if (t_ms < map->fixed_out) return map->start + t_ms * map->scale;
+
+    double remaining = map->length - map->fixed_out;
+    double u = remaining > 0.0 ? (t_ms - map->fixed_out) / remaining : 0.0;
+    return map->fixed_end + clamp(u, 0.0, 1.0) * (map->region_end - map->fixed_end);
+}
+
+// Mean absolute log-power difference between source frames i and i + 1, dB
+static double pair_distance(WorldFrameView* view, const WorldAnalysisData* source, int i) {
+    if (view->pair_distance[i] >= 0.0) return view->pair_distance[i];
+
+    int bins = source->fft_size / 2 + 1;
+    const double* a = source->spectrogram[i];
+    const double* b = source->spectrogram[i + 1];
+    double sum = 0.0;
+    for (int k = 0; k < bins; k++) {
+        sum += fabs(log(a[k] / b[k]));
+    }
+    view->pair_distance[i] = 10.0 / log(10.0) * sum / bins;
+    return view->pair_distance[i];
+}
+
+static int grow(void** ptr, int* capacity, int needed, size_t elem_size) {
+    if (needed <= *capacity) return 0;
+    void* grown = realloc(*ptr, elem_size * (size_t)needed);
+    if (!grown) return -1;
+    *ptr = grown;
+    *capacity = needed;
+    return 0;
+}
+
+int world_frame_view_build(WorldFrameView* view, const WorldAnalysisData* source,
+                           const WorldStretchParams* params) {
+    if (!view || !source || !params || params->length_ms <= 0.0) return -1;
+    if (!source->f0 || !source->spectrogram || !source->aperiodicity ||
+        source->f0_length < 1 || source->frame_period <= 0.0) {
+        return -1;
+    }
+    if (source->precision != WORLD_PRECISION_DOUBLE || world_analysis_data_is_coded(source)) {
+        return -1;
+    }
+
+    int frames = source->f0_length;
+    int bins = source->fft_size / 2 + 1;
+    double fp = source->frame_period;
+    int out_frames = (int)(params->length_ms / fp) + 1;
+
+    // f0, spectrogram and aperiodicity share frame_capacity
+    if (out_frames > view->frame_capacity) {
+        double* f0 = (double*)realloc(view->f0, sizeof(double) * out_frames);
+        if (f0) view->f0 = f0;
+        const double** sp = (const double**)realloc(view->spectrogram, sizeof(double*) * out_frames);
+        if (sp) view->spectrogram = sp;
+        const double** ap = (const double**)realloc(view->aperiodicity, sizeof(double*) * out_frames);
+        if (ap) view->aperiodicity = ap;
+        if (!f0 || !sp || !ap) return -1;
+        view->frame_capacity = out_frames;
+    }
+    if (frames > 1 && grow((void**)&view->pair_distance, &view->pair_capacity, frames - 1,
+                           sizeof(double)) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < frames - 1; i++) view->pair_distance[i] = -1.0;
+
+    view->frame_count = out_frames;
+    view->fft_size = source->fft_size;
+    view->sample_rate = source->sample_rate;
+    view->frame_period = fp;
+
+    NoteMap map;
+    note_map_init(&map, params, (frames - 1) * fp);
+
+    // Pass 1: point every frame at a source row, leaving NULL where the
+    // neighbours differ enough to need an interpolated row
+    int interpolated = 0;
+    for (int j = 0; j < out_frames; j++) {
+        double pos = note_map_source_ms(&map, j * fp) / fp;
+        int i0 = (int)pos;
+        double frac = pos - i0;
+        if (i0 >= frames - 1) {
+            i0 = frames - 1;
+            frac = 0.0;
+        }
+
+        int nearest = frac < 0.5 ? i0 : i0 + 1;
+        int direct = -1;
+        if (frac < WORLD_STRETCH_SNAP) {
+            direct = i0;
+        } else if (frac > 1.0 - WORLD_STRETCH_SNAP) {
+            direct = i0 + 1;
+        } else if (params->interp_threshold_db < 0.0 ||
+                   (source->f0[i0] > 0.0) != (source->f0[i0 + 1] > 0.0) ||
+                   pair_distance(view, source, i0) <= params->interp_threshold_db) {
+            direct = nearest;
+        }
+
+        // F0 is always interpolated between voiced frames; it costs nothing
+        if (frac >= WORLD_STRETCH_SNAP && source->f0[i0] > 0.0 && source->f0[i0 + 1] > 0.0) {
+            view->f0[j] = source->f0[i0] + (source->f0[i0 + 1] - source->f0[i0]) * frac;
+        } else {
+            view->f0[j] = source->f0[frac < WORLD_STRETCH_SNAP ? i0 : nearest];
+        }
+
+        if (direct >= 0) {
+            view->spectrogram[j] = source->spectrogram[direct];
+            view->aperiodicity[j] = source->aperiodicity[direct];
+        } else {
+            view->spectrogram[j] = NULL;
+            view->aperiodicity[j] = NULL;
+            interpolated++;
+        }
+    }
+
+    // Pass 2: interpolate only the frames left open
+    if (interpolated > 0) {
+        size_t row_values = 2 * (size_t)bins;
+        if (interpolated > view->interp_capacity) {
+            double* slab = (double*)realloc(view->interp_slab,
+                                            sizeof(double) * row_values * interpolated);
+            if (!slab) return -1;
+            view->interp_slab = slab;
+            view->interp_capacity = interpolated;
+        }
+
+        int next = 0;
+        for (int j = 0; j < out_frames; j++) {
+            if (view->spectrogram[j]) continue;
+
+            double pos = note_map_source_ms(&map, j * fp) / fp;
+            int i0 = (int)pos;
+            double frac = pos - i0;
+            double* sp = view->interp_slab + (size_t)next * row_values;
+            double* ap = sp + bins;
+            const double* sp0 = source->spectrogram[i0];
+            const double* sp1 = source->spectrogram[i0 + 1];
+            const double* ap0 = source->aperiodicity[i0];
+            const double* ap1 = source->aperiodicity[i0 + 1];
+            for (int k = 0; k < bins; k++) {
+                sp[k] = sp0[k] + (sp1[k] - sp0[k]) * frac;
+                ap[k] = ap0[k] + (ap1[k] - ap0[k]) * frac;
+            }
+            view->spectrogram[j] = sp;
+            view->aperiodicity[j] = ap;
+            next++;
+        }
+    }
+
+    view->interpolated_frames = interpolated;
+    view->bytes_written = (size_t)interpolated * 2 * (size_t)bins * sizeof(double);
+    return 0;
+}
+
+int world_frame_view_synthesize(const WorldFrameView* view, double* y, int y_length) {
+    if (!view || !y || y_length <= 0 || view->frame_count <= 0) return -1;
+
+    return world_synthesize_frames_streamed(view->f0, (const double* const*)view->spectrogram,
+                                            (const double* const*)view->aperiodicity,
+                                            view->frame_count, view->fft_size, view->frame_period,
+                                            view->sample_rate, y, y_length, WORLD_STRETCH_SYNTH_BLOCK_SIZE);
+}
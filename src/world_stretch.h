@@ -0,0 +1,114 @@
+/**
+ * @file world_stretch.h
+ * @brief Zero-copy time-stretch frame views over cached analysis
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * A UTAU note keeps the OTO consonant region at (velocity-scaled) original
+ * speed and stretches the vowel region to the requested length. Instead of
+ * building a new analysis by copying sp/ap rows, a WorldFrameView maps every
+ * output frame to a source position and hands synthesis a row table whose
+ * entries point straight into the source analysis. Rows are only
+ * interpolated where the output position falls between two source frames
+ * that actually differ; in steady vowel regions neighbouring frames are
+ * nearly identical and the nearest frame is used as-is.
+ */
+#ifndef WORLDX_UCRA_WORLD_STRETCH_H
+#define WORLDX_UCRA_WORLD_STRETCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "world_wrapper.h"
+
+/**
+ * @brief Note timing, in UTAU resampler terms
+ */
+typedef struct {
+    /** Start of the sample in the source, ms (OTO offset) */
+    double offset_ms;
+    /** Fixed region after offset, ms (OTO consonant) */
+    double consonant_ms;
+    /** OTO cutoff: < 0 is the region length from offset, >= 0 is trimmed from the end */
+    double cutoff_ms;
+    /** Output length, ms */
+    double length_ms;
+    /** Playback rate of the consonant region; 1.0 keeps it unchanged (velocity 100) */
+    double consonant_scale;
+    /**
+     * Mean absolute log-spectral difference (dB) above which two neighbouring
+     * source frames are interpolated. 0 interpolates every fractional
+     * position; a negative value always takes the nearest frame.
+     */
+    double interp_threshold_db;
+} WorldStretchParams;
+
+/**
+ * @brief Output frame sequence as views into a source analysis
+ *
+ * `spectrogram` / `aperiodicity` entries point either into the source rows
+ * or into the view's own slab of interpolated rows. The view must not
+ * outlive the source data. Buffers are grow-only and reused by later builds.
+ */
+typedef struct {
+    /** Output F0 per frame (always computed) */
+    double* f0;
+    /** Output spectral envelope rows */
+    const double** spectrogram;
+    /** Output aperiodicity rows */
+    const double** aperiodicity;
+    /** Number of output frames */
+    int frame_count;
+
+    /** Geometry copied from the source */
+    int fft_size;
+    int sample_rate;
+    double frame_period;
+
+    /** Frames that needed an interpolated row in the last build */
+    int interpolated_frames;
+    /** Bytes of sp/ap row data written by the last build */
+    size_t bytes_written;
+
+    /** Internal storage */
+    double* interp_slab;
+    int interp_capacity;
+    int frame_capacity;
+    double* pair_distance;
+    int pair_capacity;
+} WorldFrameView;
+
+/** @brief Defaults: no offset/consonant/cutoff, unit consonant scale, 0.5 dB threshold */
+void world_stretch_params_init(WorldStretchParams* params);
+
+/** @brief Initialize an empty view */
+void world_frame_view_init(WorldFrameView* view);
+
+/** @brief Free all view storage */
+void world_frame_view_free(WorldFrameView* view);
+
+/**
+ * @brief Map a note onto source frames
+ *
+ * The source must hold double-precision rows; float32 and coded data cannot
+ * be viewed without conversion.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int world_frame_view_build(WorldFrameView* view, const WorldAnalysisData* source,
+                           const WorldStretchParams* params);
+
+/**
+ * @brief Synthesize the view as WORLD's Synthesis() does, through
+ *        world_synthesize_frames_streamed()
+ * @return 0 on success, -1 on failure
+ */
+int world_frame_view_synthesize(const WorldFrameView* view, double* y, int y_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLD_STRETCH_H */
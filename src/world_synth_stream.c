@@ -0,0 +1,622 @@
+/**
+ * @file world_synth_stream.c
+ * @brief Block-streaming WORLD synthesis implementation
+ *
+ * Follows WORLD's synthesis.cpp step by step, with GetTimeBase() advanced
+ * one sample at a time and GetOneFrameSegment() run one pulse at a time, so
+ * only the frames around the current sample and one block of output are
+ * ever held.
+ */
+
+#include "world_synth_stream.h"
+#include "world_noise.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "world/common.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// WORLD's constantnumbers.h
+#define WORLD_SAFEGUARD_MINIMUM 0.000000000001
+#define WORLD_DEFAULT_F0 500.0
+
+// Fewest frame slots: the time base reads up to three frames at once and a
+// push needs one more
+#define WORLD_SYNTH_MIN_QUEUE_FRAMES 4
+
+struct WorldSynthStream {
+    int fs;
+    double frame_period;
+    double period;  // frame period in seconds, as Synthesis() uses it
+    double lowest_f0;
+    int fft_size;
+    int bins;
+    int block_size;
+    int queue_frames;
+
+    // Frame ring. Frame i sits in slot i % queue_frames until the time base
+    // has moved past it.
+    double* f0;
+    double* sp_slab;
+    double* ap_slab;
+    double** sp_rows;
+    double** ap_rows;
+    long long frames_pushed;
+    int finished;
+    long long y_length;  // -1 until known
+
+    // Time base: the next sample to interpolate, the coarse segment of the
+    // one before it, and that sample's phase and voicing
+    long long sample;
+    long long segment;
+    double total_phase;
+    double wrap_phase;
+    double vuv;
+
+    // Pulse located but not synthesized yet: its noise spans the samples up
+    // to the next pulse. Envelope and aperiodic ratio are interpolated when
+    // it is located, so its frames can leave the ring.
+    int pending;
+    long long pulse_index;
+    double pulse_shift;
+    double pulse_vuv;
+    double* envelope;
+    double* ratio;
+
+    // Noise of this synthesis only, restarted like Synthesis() restarts
+    // WORLD's randn()
+    WorldNoise noise;
+    MinimumPhaseAnalysis minimum_phase;
+    ForwardRealFFT forward;
+    InverseRealFFT inverse;
+    int plans_ready;
+    double* dc_remover;
+    double* periodic;
+    double* aperiodic;
+
+    // Samples [emitted, emitted + block_size + fft_size) of the output
+    double* out;
+    long long emitted;
+    double* work_slab;
+};
+
+// First frame the time base may still read: the segment of the last sample,
+// two back for the pulse interpolated on it
+static long long first_needed_frame(const WorldSynthStream* s) {
+    return s->segment > 2 ? s->segment - 2 : 0;
+}
+
+static int ring_is_full(const WorldSynthStream* s) {
+    return s->frames_pushed - first_needed_frame(s) >= s->queue_frames;
+}
+
+// Queue one frame into the next ring slot. Returns 1 if there was room.
+static int queue_frame(WorldSynthStream* s, double f0, const double* sp, const double* ap) {
+    if (ring_is_full(s)) return 0;
+
+    int slot = (int)(s->frames_pushed % s->queue_frames);
+    s->f0[slot] = f0;
+    memcpy(s->sp_rows[slot], sp, sizeof(double) * s->bins);
+    memcpy(s->ap_rows[slot], ap, sizeof(double) * s->bins);
+    s->frames_pushed++;
+    return 1;
+}
+
+// GetDCRemover()
+static void make_dc_remover(int fft_size, double* dc_remover) {
+    double dc_component = 0.0;
+    for (int i = 0; i < fft_size / 2; i++) {
+        dc_remover[i] = 0.5 - 0.5 * cos(2.0 * M_PI * (i + 1.0) / (1.0 + fft_size));
+        dc_remover[fft_size - i - 1] = dc_remover[i];
+        dc_component += dc_remover[i] * 2.0;
+    }
+    for (int i = 0; i < fft_size / 2; i++) {
+        dc_remover[i] /= dc_component;
+        dc_remover[fft_size - i - 1] = dc_remover[i];
+    }
+}
+
+int world_synth_stream_create(WorldSynthStream** out_stream, int fs, double frame_period,
+                              int fft_size, int block_size, int queue_frames) {
+    if (!out_stream || fs <= 0 || frame_period <= 0.0 || fft_size <= 0 || block_size <= 0) {
+        return -1;
+    }
+    *out_stream = NULL;
+
+    if (queue_frames <= 0) {
+        // Frames spanned by one block, twice over, plus the time base's reach
+        int frames_per_block = (int)(block_size * 1000.0 / (fs * frame_period)) + 1;
+        queue_frames = 2 * frames_per_block + 16;
+        if (queue_frames < 64) queue_frames = 64;
+    }
+    if (queue_frames < WORLD_SYNTH_MIN_QUEUE_FRAMES) queue_frames = WORLD_SYNTH_MIN_QUEUE_FRAMES;
+
+    WorldSynthStream* s = (WorldSynthStream*)calloc(1, sizeof(WorldSynthStream));
+    if (!s) return -1;
+
+    s->fs = fs;
+    s->frame_period = frame_period;
+    s->period = frame_period / 1000.0;
+    s->lowest_f0 = fs / fft_size + 1.0;
+    s->fft_size = fft_size;
+    s->bins = fft_size / 2 + 1;
+    s->block_size = block_size;
+    s->queue_frames = queue_frames;
+    s->y_length = -1;
+    s->segment = 1;
+
+    size_t ring_values = (size_t)queue_frames * (size_t)s->bins;
+    s->f0 = (double*)calloc((size_t)queue_frames, sizeof(double));
+    s->sp_slab = (double*)calloc(ring_values, sizeof(double));
+    s->ap_slab = (double*)calloc(ring_values, sizeof(double));
+    s->sp_rows = (double**)calloc((size_t)queue_frames, sizeof(double*));
+    s->ap_rows = (double**)calloc((size_t)queue_frames, sizeof(double*));
+    // envelope, ratio, dc_remover, periodic, aperiodic, out
+    size_t work_values = 2 * (size_t)s->bins + 4 * (size_t)fft_size + (size_t)block_size;
+    s->work_slab = (double*)calloc(work_values, sizeof(double));
+    if (!s->f0 || !s->sp_slab || !s->ap_slab || !s->sp_rows || !s->ap_rows || !s->work_slab) {
+        world_synth_stream_destroy(s);
+        return -1;
+    }
+    for (int i = 0; i < queue_frames; i++) {
+        s->sp_rows[i] = s->sp_slab + (size_t)i * s->bins;
+        s->ap_rows[i] = s->ap_slab + (size_t)i * s->bins;
+    }
+    s->envelope = s->work_slab;
+    s->ratio = s->envelope + s->bins;
+    s->dc_remover = s->ratio + s->bins;
+    s->periodic = s->dc_remover + fft_size;
+    s->aperiodic = s->periodic + fft_size;
+    s->out = s->aperiodic + fft_size;
+
+    make_dc_remover(fft_size, s->dc_remover);
+    world_noise_reset(&s->noise);
+    InitializeMinimumPhaseAnalysis(fft_size, &s->minimum_phase);
+    InitializeForwardRealFFT(fft_size, &s->forward);
+    InitializeInverseRealFFT(fft_size, &s->inverse);
+    s->plans_ready = 1;
+
+    *out_stream = s;
+    return 0;
+}
+
+int world_synth_stream_push(WorldSynthStream* stream, const double* f0,
+                            const double* const* spectrogram,
+                            const double* const* aperiodicity, int frame_count) {
+    if (!stream || !f0 || !spectrogram || !aperiodicity || frame_count < 0) return -1;
+    if (stream->finished) return -1;
+
+    int accepted = 0;
+    while (accepted < frame_count &&
+           queue_frame(stream, f0[accepted], spectrogram[accepted], aperiodicity[accepted])) {
+        accepted++;
+    }
+    return accepted;
+}
+
+int world_synth_stream_finish(WorldSynthStream* stream) {
+    if (!stream || stream->frames_pushed == 0) return -1;
+    stream->finished = 1;
+    if (stream->y_length < 0) {
+        // Samples covered by the pushed frames, as Synthesis() is usually
+        // sized for the same frame count
+        long long y_length =
+            (long long)((stream->frames_pushed - 1) * stream->frame_period * stream->fs / 1000.0) + 1;
+        stream->y_length = y_length > stream->sample ? y_length : stream->sample;
+    }
+    return 0;
+}
+
+// coarse_f0 of GetTemporalParametersForTimeBase()
+static double coarse_f0(const WorldSynthStream* s, long long frame) {
+    double f0 = s->f0[frame % s->queue_frames];
+    return f0 < s->lowest_f0 ? 0.0 : f0;
+}
+
+// Coarse F0 and voicing at point k. Point f0_length, past the last frame,
+// extrapolates the last two frames (a single frame is held).
+static void coarse_point(const WorldSynthStream* s, long long k, double* f0, double* vuv) {
+    if (k < s->frames_pushed) {
+        *f0 = coarse_f0(s, k);
+        *vuv = *f0 == 0.0 ? 0.0 : 1.0;
+        return;
+    }
+    long long last = s->frames_pushed - 1;
+    double last_f0 = coarse_f0(s, last);
+    double prev_f0 = coarse_f0(s, last > 0 ? last - 1 : last);
+    double last_vuv = last_f0 == 0.0 ? 0.0 : 1.0;
+    double prev_vuv = prev_f0 == 0.0 ? 0.0 : 1.0;
+    *f0 = last_f0 * 2 - prev_f0;
+    *vuv = last_vuv * 2 - prev_vuv;
+}
+
+// GetSafeAperiodicity()
+static double safe_aperiodicity(double x) {
+    double y = 0.999999999999 < x ? 0.999999999999 : x;
+    return 0.001 > y ? 0.001 : y;
+}
+
+// GetSpectralEnvelope() and GetAperiodicRatio() at time seconds
+static void interpolate_frame(WorldSynthStream* s, double time) {
+    long long floor_frame = (long long)floor(time / s->period);
+    long long ceil_frame = (long long)ceil(time / s->period);
+    if (s->finished) {
+        long long last = s->frames_pushed - 1;
+        if (floor_frame > last) floor_frame = last;
+        if (ceil_frame > last) ceil_frame = last;
+    }
+    double interpolation = time / s->period - floor_frame;
+    const double* sp0 = s->sp_rows[floor_frame % s->queue_frames];
+    const double* ap0 = s->ap_rows[floor_frame % s->queue_frames];
+
+    if (floor_frame == ceil_frame) {
+        for (int i = 0; i < s->bins; i++) {
+            s->envelope[i] = fabs(sp0[i]);
+            s->ratio[i] = pow(safe_aperiodicity(ap0[i]), 2.0);
+        }
+        return;
+    }
+    const double* sp1 = s->sp_rows[ceil_frame % s->queue_frames];
+    const double* ap1 = s->ap_rows[ceil_frame % s->queue_frames];
+    for (int i = 0; i < s->bins; i++) {
+        s->envelope[i] = (1.0 - interpolation) * fabs(sp0[i]) + interpolation * fabs(sp1[i]);
+        s->ratio[i] = pow((1.0 - interpolation) * safe_aperiodicity(ap0[i]) +
+                          interpolation * safe_aperiodicity(ap1[i]), 2.0);
+    }
+}
+
+// fftshift()
+static void fftshift(const double* x, int x_length, double* y) {
+    for (int i = 0; i < x_length / 2; i++) {
+        y[i] = x[i + x_length / 2];
+        y[i + x_length / 2] = x[i];
+    }
+}
+
+// GetPeriodicResponse() of the pending pulse into s->periodic
+static void periodic_response(WorldSynthStream* s) {
+    int fft_size = s->fft_size;
+    if (s->pulse_vuv <= 0.5 || s->ratio[0] > 0.999) {
+        memset(s->periodic, 0, sizeof(double) * fft_size);
+        return;
+    }
+
+    MinimumPhaseAnalysis* minimum_phase = &s->minimum_phase;
+    for (int i = 0; i <= fft_size / 2; i++) {
+        minimum_phase->log_spectrum[i] =
+            log(s->envelope[i] * (1.0 - s->ratio[i]) + WORLD_SAFEGUARD_MINIMUM) / 2.0;
+    }
+    GetMinimumPhaseSpectrum(minimum_phase);
+
+    // Fractional pulse delay as a linear phase (GetSpectrumWithFractionalTimeShift())
+    double coefficient = 2.0 * M_PI * s->pulse_shift * s->fs / fft_size;
+    fft_complex* spectrum = s->inverse.spectrum;
+    for (int i = 0; i <= fft_size / 2; i++) {
+        double re = minimum_phase->minimum_phase_spectrum[i][0];
+        double im = minimum_phase->minimum_phase_spectrum[i][1];
+        double re2 = cos(coefficient * i);
+        double im2 = sqrt(1.0 - re2 * re2);
+        spectrum[i][0] = re * re2 + im * im2;
+        spectrum[i][1] = im * re2 - re * im2;
+    }
+    fft_execute(s->inverse.inverse_fft);
+    fftshift(s->inverse.waveform, fft_size, s->periodic);
+
+    // RemoveDCComponent()
+    double dc_component = 0.0;
+    for (int i = fft_size / 2; i < fft_size; i++) dc_component += s->periodic[i];
+    for (int i = 0; i < fft_size / 2; i++) s->periodic[i] = -dc_component * s->dc_remover[i];
+    for (int i = fft_size / 2; i < fft_size; i++) s->periodic[i] -= dc_component * s->dc_remover[i];
+}
+
+// GetAperiodicResponse() of the pending pulse into s->aperiodic
+static void aperiodic_response(WorldSynthStream* s, int noise_size) {
+    int fft_size = s->fft_size;
+    ForwardRealFFT* forward = &s->forward;
+
+    // GetNoiseSpectrum()
+    double average = 0.0;
+    for (int i = 0; i < noise_size; i++) {
+        forward->waveform[i] = world_noise_next(&s->noise);
+        average += forward->waveform[i];
+    }
+    if (noise_size > 0) average /= noise_size;
+    for (int i = 0; i < noise_size; i++) forward->waveform[i] -= average;
+    for (int i = noise_size; i < fft_size; i++) forward->waveform[i] = 0.0;
+    fft_execute(forward->forward_fft);
+
+    MinimumPhaseAnalysis* minimum_phase = &s->minimum_phase;
+    if (s->pulse_vuv != 0.0) {
+        for (int i = 0; i <= fft_size / 2; i++) {
+            minimum_phase->log_spectrum[i] =
+                log(s->envelope[i] * s->ratio[i] + WORLD_SAFEGUARD_MINIMUM) / 2.0;
+        }
+    } else {
+        for (int i = 0; i <= fft_size / 2; i++) {
+            minimum_phase->log_spectrum[i] = log(s->envelope[i] + WORLD_SAFEGUARD_MINIMUM) / 2.0;
+        }
+    }
+    GetMinimumPhaseSpectrum(minimum_phase);
+
+    const fft_complex* filter = minimum_phase->minimum_phase_spectrum;
+    const fft_complex* noise = forward->spectrum;
+    fft_complex* spectrum = s->inverse.spectrum;
+    for (int i = 0; i <= fft_size / 2; i++) {
+        spectrum[i][0] = filter[i][0] * noise[i][0] - filter[i][1] * noise[i][1];
+        spectrum[i][1] = filter[i][0] * noise[i][1] + filter[i][1] * noise[i][0];
+    }
+    fft_execute(s->inverse.inverse_fft);
+    fftshift(s->inverse.waveform, fft_size, s->aperiodic);
+}
+
+// GetOneFrameSegment() for the pending pulse, overlap-added into the output
+static void synthesize_pulse(WorldSynthStream* s, int noise_size) {
+    int fft_size = s->fft_size;
+    periodic_response(s);
+    aperiodic_response(s, noise_size);
+
+    double sqrt_noise_size = sqrt((double)noise_size);
+    long long offset = s->pulse_index - fft_size / 2 + 1;
+    int lower_limit = offset < 0 ? (int)-offset : 0;
+    int upper_limit = fft_size;
+    if (s->y_length >= 0 && s->y_length - offset < upper_limit) {
+        upper_limit = (int)(s->y_length - offset);
+    }
+    double* out = s->out + (offset - s->emitted + lower_limit);
+    for (int j = lower_limit; j < upper_limit; j++) {
+        *out++ += (s->periodic[j] * sqrt_noise_size + s->aperiodic[j]) / fft_size;
+    }
+    s->pending = 0;
+}
+
+// Interpolate the F0 and voicing of the next sample as GetTimeBase() does
+// and, when its phase wraps, locate a pulse on the sample before it. A
+// newly located pulse completes the pending one. Returns 0 when the frames
+// this needs have not been pushed yet.
+static int advance_sample(WorldSynthStream* s) {
+    long long n = s->sample;
+    double time = n / (double)s->fs;
+
+    // interp1() segment: points are frame times, plus one past the last frame
+    long long k = s->segment;
+    while (k < s->frames_pushed && k * s->period <= time) k++;
+    if (!s->finished && k >= s->frames_pushed) return 0;
+
+    double f0_a, vuv_a, f0_b, vuv_b;
+    coarse_point(s, k - 1, &f0_a, &vuv_a);
+    coarse_point(s, k, &f0_b, &vuv_b);
+    double x0 = (k - 1) * s->period;
+    double fraction = (time - x0) / (k * s->period - x0);
+    double f0 = f0_a + fraction * (f0_b - f0_a);
+    double vuv = vuv_a + fraction * (vuv_b - vuv_a) > 0.5 ? 1.0 : 0.0;
+    if (vuv == 0.0) f0 = WORLD_DEFAULT_F0;
+
+    double total_phase = n == 0 ? 2.0 * M_PI * f0 / s->fs
+                                : s->total_phase + 2.0 * M_PI * f0 / s->fs;
+    double wrap_phase = fmod(total_phase, 2.0 * M_PI);
+
+    if (n > 0 && fabs(wrap_phase - s->wrap_phase) > M_PI) {
+        double pulse_time = (n - 1) / (double)s->fs;
+        if (!s->finished && (long long)ceil(pulse_time / s->period) >= s->frames_pushed) return 0;
+
+        if (s->pending) synthesize_pulse(s, (int)(n - 1 - s->pulse_index));
+
+        // Fractional position of the wrap between samples n - 1 and n
+        double y1 = s->wrap_phase - 2.0 * M_PI;
+        double y2 = wrap_phase;
+        double x = -y1 / (y2 - y1);
+        s->pending = 1;
+        s->pulse_index = n - 1;
+        s->pulse_shift = x / s->fs;
+        s->pulse_vuv = s->vuv;
+        interpolate_frame(s, pulse_time);
+    }
+
+    s->sample = n + 1;
+    s->segment = k;
+    s->total_phase = total_phase;
+    s->wrap_phase = wrap_phase;
+    s->vuv = vuv;
+    return 1;
+}
+
+// Whether samples [emitted, emitted + block_size) have every pulse added
+static int block_ready(const WorldSynthStream* s) {
+    if (s->y_length >= 0 && s->sample >= s->y_length && !s->pending) return 1;
+
+    // Later pulses sit at the pending one or at the sample before the next
+    long long next_pulse = s->sample - 1;
+    if (s->pending && s->pulse_index < next_pulse) next_pulse = s->pulse_index;
+    return s->emitted + s->block_size <= next_pulse - s->fft_size / 2 + 1;
+}
+
+int world_synth_stream_pull(WorldSynthStream* stream, double* out) {
+    if (!stream || !out) return -1;
+    if (stream->y_length >= 0 && stream->emitted >= stream->y_length) return 0;
+
+    while (!block_ready(stream)) {
+        if (stream->y_length >= 0 && stream->sample >= stream->y_length) {
+            synthesize_pulse(stream, 0);  // the last pulse has no noise span
+        } else if (!advance_sample(stream)) {
+            return 0;
+        }
+    }
+
+    int block_size = stream->block_size;
+    int fft_size = stream->fft_size;
+    memcpy(out, stream->out, sizeof(double) * block_size);
+    if (stream->y_length >= 0 && stream->emitted + block_size > stream->y_length) {
+        int valid = (int)(stream->y_length - stream->emitted);
+        memset(out + valid, 0, sizeof(double) * (block_size - valid));
+    }
+    memmove(stream->out, stream->out + block_size, sizeof(double) * fft_size);
+    memset(stream->out + fft_size, 0, sizeof(double) * block_size);
+    stream->emitted += block_size;
+    return 1;
+}
+
+int world_synth_stream_block_size(const WorldSynthStream* stream) {
+    return stream ? stream->block_size : 0;
+}
+
+// One WORLD fft_plan as fft.cpp allocates it: ip[n], w[n * 5 / 4] and a
+// copy of the input (n values for real input, 2n for complex)
+static size_t fft_plan_bytes(size_t n, size_t input_values) {
+    return n * sizeof(int) + (n * 5 / 4 + input_values) * sizeof(double);
+}
+
+size_t world_synth_stream_memory_bytes(const WorldSynthStream* stream) {
+    if (!stream) return 0;
+
+    size_t fft = (size_t)stream->fft_size;
+    size_t bins = (size_t)stream->bins;
+    size_t bytes = sizeof(WorldSynthStream);
+    bytes += (size_t)stream->queue_frames * (sizeof(double) * (2 * bins + 1) + 2 * sizeof(double*));
+    bytes += sizeof(double) * (2 * bins + 4 * fft + (size_t)stream->block_size);
+    // MinimumPhaseAnalysis: log spectrum, two complex arrays, a real and a
+    // complex plan
+    bytes += fft * (sizeof(double) + 2 * sizeof(fft_complex)) + fft_plan_bytes(fft, fft) +
+             fft_plan_bytes(fft, 2 * fft);
+    // ForwardRealFFT and InverseRealFFT: waveform, spectrum and plan each
+    bytes += 2 * (fft * (sizeof(double) + sizeof(fft_complex)) + fft_plan_bytes(fft, fft));
+    return bytes;
+}
+
+void world_synth_stream_destroy(WorldSynthStream* stream) {
+    if (!stream) return;
+
+    if (stream->plans_ready) {
+        DestroyMinimumPhaseAnalysis(&stream->minimum_phase);
+        DestroyForwardRealFFT(&stream->forward);
+        DestroyInverseRealFFT(&stream->inverse);
+    }
+    free(stream->f0);
+    free(stream->sp_slab);
+    free(stream->ap_slab);
+    free(stream->sp_rows);
+    free(stream->ap_rows);
+    free(stream->work_slab);
+    free(stream);
+}
+
+// Frames to stream: either an analysis (any precision or coding) or bare
+// double row tables
+typedef struct {
+    const WorldAnalysisData* data;
+    const double* f0;
+    const double* const* spectrogram;
+    const double* const* aperiodicity;
+    int frame_count;
+} FrameSource;
+
+// Queue frames [first, first + count) of float32 or coded data, widened or
+// decoded straight into the free ring slots. Each contiguous run of slots
+// takes one world_analysis_data_get_frames() call, so WORLD's decoders set
+// up their plans once per run rather than once per frame.
+static int push_data_frames(WorldSynthStream* s, const WorldAnalysisData* data, int first, int count) {
+    int accepted = 0;
+    while (accepted < count && !ring_is_full(s)) {
+        int free_slots = (int)(s->queue_frames - (s->frames_pushed - first_needed_frame(s)));
+        int slot = (int)(s->frames_pushed % s->queue_frames);
+        int run = count - accepted;
+        if (run > free_slots) run = free_slots;
+        if (run > s->queue_frames - slot) run = s->queue_frames - slot;
+        int frame = first + accepted;
+        if (world_analysis_data_get_frames(data, frame, run, s->sp_rows + slot, s->ap_rows + slot) != 0) {
+            return -1;
+        }
+        memcpy(s->f0 + slot, data->f0 + frame, sizeof(double) * run);
+        s->frames_pushed += run;
+        accepted += run;
+    }
+    return accepted;
+}
+
+// Push frames [first, first + count) of the source
+static int push_source_frames(WorldSynthStream* stream, const FrameSource* source, int first, int count) {
+    const WorldAnalysisData* data = source->data;
+    if (data && (data->precision == WORLD_PRECISION_FLOAT32 || world_analysis_data_is_coded(data))) {
+        if (stream->finished) return -1;
+        return push_data_frames(stream, data, first, count);
+    }
+    return world_synth_stream_push(stream, source->f0 + first, source->spectrogram + first,
+                                   source->aperiodicity + first, count);
+}
+
+static int synthesize_source(const FrameSource* source, int fs, double frame_period, int fft_size,
+                             double* y, int y_length, int block_size) {
+    WorldSynthStream* stream = NULL;
+    if (world_synth_stream_create(&stream, fs, frame_period, fft_size, block_size, 0) != 0) {
+        return -1;
+    }
+    double* block = (double*)malloc(sizeof(double) * (size_t)block_size);
+    if (!block) {
+        world_synth_stream_destroy(stream);
+        return -1;
+    }
+    // Synthesis() of y_length samples: past the last frame F0 is
+    // extrapolated and the envelope held, with nothing more pushed
+    stream->y_length = y_length;
+
+    int result = 0;
+    int next_frame = 0;
+    int written = 0;
+    while (written < y_length) {
+        int accepted = 0;
+        if (next_frame < source->frame_count) {
+            accepted = push_source_frames(stream, source, next_frame, source->frame_count - next_frame);
+            if (accepted < 0) { result = -1; break; }
+            next_frame += accepted;
+            if (next_frame == source->frame_count) world_synth_stream_finish(stream);
+        }
+
+        int pulled = world_synth_stream_pull(stream, block);
+        if (pulled < 0 || (pulled == 0 && accepted == 0)) {
+            result = -1;  // ring full yet nothing to synthesize: locked
+            break;
+        }
+        while (pulled == 1 && written < y_length) {
+            int n = y_length - written < block_size ? y_length - written : block_size;
+            memcpy(y + written, block, sizeof(double) * n);
+            written += n;
+            pulled = world_synth_stream_pull(stream, block);
+            if (pulled < 0) { result = -1; break; }
+        }
+        if (result != 0) break;
+    }
+
+    free(block);
+    world_synth_stream_destroy(stream);
+    return result;
+}
+
+int world_synthesize_streamed(const WorldAnalysisData* data, double* y, int y_length,
+                              int block_size) {
+    if (!data || !y || y_length <= 0 || !data->f0 || data->f0_length <= 0) return -1;
+    if (!world_analysis_data_is_coded(data)) {
+        if (data->precision == WORLD_PRECISION_FLOAT32) {
+            if (!data->spectrogram_f32 || !data->aperiodicity_f32) return -1;
+        } else if (!data->spectrogram || !data->aperiodicity) {
+            return -1;
+        }
+    }
+
+    FrameSource source = { data, data->f0, (const double* const*)data->spectrogram,
+                           (const double* const*)data->aperiodicity, data->f0_length };
+    return synthesize_source(&source, data->sample_rate, data->frame_period, data->fft_size,
+                             y, y_length, block_size);
+}
+
+int world_synthesize_frames_streamed(const double* f0, const double* const* spectrogram,
+                                     const double* const* aperiodicity, int frame_count,
+                                     int fft_size, double frame_period, int fs,
+                                     double* y, int y_length, int block_size) {
+    if (!f0 || !spectrogram || !aperiodicity || frame_count <= 0 || !y || y_length <= 0) return -1;
+
+    FrameSource source = { NULL, f0, spectrogram, aperiodicity, frame_count };
+    return synthesize_source(&source, fs, frame_period, fft_size, y, y_length, block_size);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file world_synth_stream.h
+ * @brief Block-streaming WORLD synthesis
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * A port of WORLD's Synthesis() that produces audio in fixed blocks
+ * (UCRA_RenderConfig.block_size) while frames are still being pushed. The
+ * stream copies every pushed frame into a fixed ring of frame slots and keeps
+ * one block of output plus one FFT frame of overlap, so its memory is bounded
+ * by the ring size rather than note length.
+ *
+ * Pulses, envelopes and overlap-add follow synthesis.cpp operation for
+ * operation. The aperiodic noise comes from the stream's own copy of WORLD's
+ * randn() generator (world_noise.h), started from the state randn_reseed()
+ * restores, so a stream's output depends only on its frames: streams run on
+ * any number of threads at once, and the samples equal those of Synthesis()
+ * called right after randn_reseed(), for any block size.
+ */
+#ifndef WORLDX_UCRA_WORLD_SYNTH_STREAM_H
+#define WORLDX_UCRA_WORLD_SYNTH_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "world_wrapper.h"
+
+/** Opaque streaming synthesizer */
+typedef struct WorldSynthStream WorldSynthStream;
+
+/**
+ * @brief Create a streaming synthesizer
+ *
+ * @param out_stream Receives the new stream
+ * @param fs Sample rate
+ * @param frame_period Frame period in milliseconds
+ * @param fft_size FFT size of the spectral frames that will be pushed
+ * @param block_size Samples produced by each world_synth_stream_pull()
+ * @param queue_frames Frame slots in the ring (at least 4); values <= 0 pick
+ *                     a size that lets a block's worth of frames be pushed
+ *                     at once
+ * @return 0 on success, -1 on failure
+ */
+int world_synth_stream_create(WorldSynthStream** out_stream, int fs, double frame_period,
+                              int fft_size, int block_size, int queue_frames);
+
+/**
+ * @brief Queue analysis frames for synthesis
+ *
+ * Frames are copied, so the caller's rows may be reused immediately. When the
+ * ring is full fewer frames than requested are accepted; pull blocks to make
+ * room and push the remainder.
+ *
+ * @return Number of frames accepted (0..frame_count), or -1 on error
+ */
+int world_synth_stream_push(WorldSynthStream* stream, const double* f0,
+                            const double* const* spectrogram,
+                            const double* const* aperiodicity, int frame_count);
+
+/**
+ * @brief Mark the end of input
+ *
+ * Subsequent pulls drain the tail, treating the pushed frames as the whole
+ * input of Synthesis() sized to cover them ((frames - 1) frame periods plus
+ * one sample), until that many samples have been emitted.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int world_synth_stream_finish(WorldSynthStream* stream);
+
+/**
+ * @brief Pull one block of block_size samples
+ *
+ * @param out Receives block_size samples
+ * @return 1 if a block was written, 0 if more frames are needed (or, after
+ *         world_synth_stream_finish(), the stream is drained), -1 on error
+ */
+int world_synth_stream_pull(WorldSynthStream* stream, double* out);
+
+/** @brief Block size the stream was created with */
+int world_synth_stream_block_size(const WorldSynthStream* stream);
+
+/**
+ * @brief Bytes held by the stream: its frame ring, output and pulse buffers,
+ *        and the WORLD FFT plans and arrays it synthesizes with
+ */
+size_t world_synth_stream_memory_bytes(const WorldSynthStream* stream);
+
+/** @brief Destroy a stream; NULL is ignored */
+void world_synth_stream_destroy(WorldSynthStream* stream);
+
+/**
+ * @brief Render analysis data through a stream into a full output buffer
+ *
+ * Same samples as Synthesis() of the decoded frames into y_length samples;
+ * world_synthesize() runs through here. Float32 data is widened and coded
+ * data decoded straight into the stream's free frame slots, one decoder call
+ * per run of slots, so at most the ring's worth of frames is ever
+ * materialized.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int world_synthesize_streamed(const WorldAnalysisData* data, double* y, int y_length,
+                              int block_size);
+
+/**
+ * @brief Render double-precision frame rows through a stream
+ *
+ * Same as world_synthesize_streamed() for row tables that are not a
+ * WorldAnalysisData, such as a WorldFrameView.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int world_synthesize_frames_streamed(const double* f0, const double* const* spectrogram,
+                                     const double* const* aperiodicity, int frame_count,
+                                     int fft_size, double frame_period, int fs,
+                                     double* y, int y_length, int block_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLD_SYNTH_STREAM_H */
@@ -4,17 +4,117 @@
  */
 
 #include "world_wrapper.h"
+#include "world_synth_stream.h"
+#include "simd_convert.h"
+#include "world_spectral.h"
+#include "worldx_thread.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
 // WORLD library headers
 #include "world/harvest.h"
+#include "world/dio.h"
+#include "world/stonemask.h"
 #include "world/cheaptrick.h"
 #include "world/d4c.h"
-#include "world/synthesis.h"
+#include "world/codec.h"
 #include "world/common.h"
 
+static void* aligned_alloc_bytes(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, WORLD_DATA_ALIGNMENT);
+#else
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, WORLD_DATA_ALIGNMENT, size) != 0) return NULL;
+    return ptr;
+#endif
+}
+
+static void aligned_free_bytes(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// Allocate a [frames][bins] matrix. With WORLD_LAYOUT_CONTIGUOUS the rows are
+// views into one aligned slab returned through *slab; otherwise *slab stays
+// NULL and each row is its own allocation.
+static double** allocate_matrix(int frames, int bins, WorldDataLayout layout, void** slab) {
+    *slab = NULL;
+
+    double** rows = (double**)calloc((size_t)frames, sizeof(double*));
+    if (!rows) return NULL;
+
+    if (layout == WORLD_LAYOUT_CONTIGUOUS) {
+        double* values = (double*)aligned_alloc_bytes(sizeof(double) * (size_t)frames * (size_t)bins);
+        if (!values) {
+            free(rows);
+            return NULL;
+        }
+        for (int i = 0; i < frames; i++) {
+            rows[i] = values + (size_t)i * (size_t)bins;
+        }
+        *slab = values;
+        return rows;
+    }
+
+    for (int i = 0; i < frames; i++) {
+        rows[i] = (double*)malloc(sizeof(double) * bins);
+        if (!rows[i]) {
+            for (int j = 0; j < i; j++) free(rows[j]);
+            free(rows);
+            return NULL;
+        }
+    }
+    return rows;
+}
+
+// Float32 matrices are always one aligned slab
+static float** allocate_matrix_f32(int frames, int bins, void** slab) {
+    *slab = NULL;
+
+    float** rows = (float**)calloc((size_t)frames, sizeof(float*));
+    if (!rows) return NULL;
+
+    float* values = (float*)aligned_alloc_bytes(sizeof(float) * (size_t)frames * (size_t)bins);
+    if (!values) {
+        free(rows);
+        return NULL;
+    }
+    for (int i = 0; i < frames; i++) {
+        rows[i] = values + (size_t)i * (size_t)bins;
+    }
+    *slab = values;
+    return rows;
+}
+
+static void free_matrix_f32(float** rows, void* slab) {
+    if (!rows) return;
+    aligned_free_bytes(slab);
+    free(rows);
+}
+
+static void free_matrix(double** rows, int frames, void* slab) {
+    if (!rows) return;
+
+    if (slab) {
+        aligned_free_bytes(slab);
+    } else {
+        for (int i = 0; i < frames; i++) {
+            if (rows[i]) {
+                free(rows[i]);
+            }
+        }
+    }
+    free(rows);
+}
+
 void world_analysis_data_init(WorldAnalysisData* data) {
     if (!data) return;
 
@@ -29,16 +129,66 @@ void world_analysis_data_init(WorldAnalysisData* data) {
     data->frame_period = 0.0;
     data->sample_rate = 0;
     data->x_length = 0;
+    data->f0_estimator = WORLD_F0_HARVEST;
+    data->frame_capacity = 0;
+    data->layout = WORLD_LAYOUT_CONTIGUOUS;
+    data->spectrogram_slab = NULL;
+    data->aperiodicity_slab = NULL;
+    data->precision = WORLD_PRECISION_DOUBLE;
+    data->spectrogram_f32 = NULL;
+    data->aperiodicity_f32 = NULL;
+    data->coded_spectrogram = NULL;
+    data->coded_aperiodicity = NULL;
+    data->coded_sp_dims = 0;
+    data->coded_ap_dims = 0;
+    data->coded_slab = NULL;
+    data->storage_release = NULL;
+    data->storage_owner = NULL;
+    data->borrowed_matrices = 0;
+}
+
+// Release the sp/ap matrices in whichever representation they are held.
+// Borrowed rows only lose their row tables.
+static void drop_matrices(WorldAnalysisData* data) {
+    int owned = !data->borrowed_matrices;
+
+    if (data->spectrogram_f32 || data->aperiodicity_f32) {
+        free_matrix_f32(data->spectrogram_f32, owned ? data->spectrogram_slab : NULL);
+        free_matrix_f32(data->aperiodicity_f32, owned ? data->aperiodicity_slab : NULL);
+    } else if (owned) {
+        free_matrix(data->spectrogram, data->frame_capacity, data->spectrogram_slab);
+        free_matrix(data->aperiodicity, data->frame_capacity, data->aperiodicity_slab);
+    } else {
+        free(data->spectrogram);
+        free(data->aperiodicity);
+    }
+    data->spectrogram = NULL;
+    data->aperiodicity = NULL;
+    data->spectrogram_f32 = NULL;
+    data->aperiodicity_f32 = NULL;
+    data->spectrogram_slab = NULL;
+    data->aperiodicity_slab = NULL;
+
+    if (owned) aligned_free_bytes(data->coded_slab);
+    free(data->coded_spectrogram);
+    free(data->coded_aperiodicity);
+    data->coded_spectrogram = NULL;
+    data->coded_aperiodicity = NULL;
+    data->coded_sp_dims = 0;
+    data->coded_ap_dims = 0;
+    data->coded_slab = NULL;
+
+    data->borrowed_matrices = 0;
 }
 
 void world_analysis_data_free(WorldAnalysisData* data) {
     if (!data) return;
 
-    // Free F0 array
-    if (data->f0) {
+    // Free F0 array (borrowed F0 belongs to the storage owner)
+    if (data->f0 && !data->storage_release) {
         free(data->f0);
-        data->f0 = NULL;
     }
+    data->f0 = NULL;
 
     // Free temporal positions
     if (data->temporal_positions) {
@@ -46,29 +196,18 @@ void world_analysis_data_free(WorldAnalysisData* data) {
         data->temporal_positions = NULL;
     }
 
-    // Free spectrogram 2D array
-    if (data->spectrogram) {
-        for (int i = 0; i < data->sp_length; i++) {
-            if (data->spectrogram[i]) {
-                free(data->spectrogram[i]);
-            }
-        }
-        free(data->spectrogram);
-        data->spectrogram = NULL;
-    }
+    // Free spectrogram and aperiodicity 2D arrays (slab, per-row or coded)
+    drop_matrices(data);
 
-    // Free aperiodicity 2D array
-    if (data->aperiodicity) {
-        for (int i = 0; i < data->ap_length; i++) {
-            if (data->aperiodicity[i]) {
-                free(data->aperiodicity[i]);
-            }
-        }
-        free(data->aperiodicity);
-        data->aperiodicity = NULL;
+    // Hand borrowed storage back to its owner
+    if (data->storage_release) {
+        data->storage_release(data->storage_owner);
+        data->storage_release = NULL;
+        data->storage_owner = NULL;
     }
 
     // Reset all lengths
+    data->frame_capacity = 0;
     data->f0_length = 0;
     data->sp_length = 0;
     data->fft_size = 0;
@@ -76,11 +215,35 @@ void world_analysis_data_free(WorldAnalysisData* data) {
     data->frame_period = 0.0;
     data->sample_rate = 0;
     data->x_length = 0;
+    data->f0_estimator = WORLD_F0_HARVEST;
+}
+
+// Whether the current buffers can hold f0_length frames of fft_size in the
+// requested layout and precision
+static int allocation_fits(const WorldAnalysisData* data, int f0_length, int fft_size) {
+    if (!data->f0 || !data->temporal_positions || data->fft_size != fft_size ||
+        data->frame_capacity < f0_length || world_analysis_data_is_coded(data) ||
+        data->storage_release) {
+        return 0;
+    }
+    if (data->precision == WORLD_PRECISION_FLOAT32) {
+        return data->spectrogram_f32 && data->aperiodicity_f32;
+    }
+    return data->spectrogram && data->aperiodicity &&
+           (data->layout == WORLD_LAYOUT_CONTIGUOUS) == (data->spectrogram_slab != NULL);
 }
 
 int world_analysis_data_allocate(WorldAnalysisData* data, int f0_length, int fft_size) {
     if (!data || f0_length <= 0 || fft_size <= 0) return -1;
 
+    // Keep buffers that are already big enough; analysis overwrites them
+    if (allocation_fits(data, f0_length, fft_size)) {
+        data->f0_length = f0_length;
+        data->sp_length = f0_length;
+        data->ap_length = f0_length;
+        return 0;
+    }
+
     // Free any existing data first
     world_analysis_data_free(data);
 
@@ -92,97 +255,776 @@ int world_analysis_data_allocate(WorldAnalysisData* data, int f0_length, int fft
     data->temporal_positions = (double*)malloc(sizeof(double) * f0_length);
     if (!data->temporal_positions) goto allocation_error;
 
-    // Allocate spectrogram 2D array
-    data->spectrogram = (double**)malloc(sizeof(double*) * f0_length);
-    if (!data->spectrogram) goto allocation_error;
+    // Set dimensions up front so the error path frees exactly what exists
+    data->frame_capacity = f0_length;
+    data->f0_length = f0_length;
+    data->sp_length = f0_length;
+    data->ap_length = f0_length;
+    data->fft_size = fft_size;
 
     int spectral_bins = fft_size / 2 + 1;
-    for (int i = 0; i < f0_length; i++) {
-        data->spectrogram[i] = (double*)malloc(sizeof(double) * spectral_bins);
-        if (!data->spectrogram[i]) goto allocation_error;
+
+    if (data->precision == WORLD_PRECISION_FLOAT32) {
+        data->spectrogram_f32 = allocate_matrix_f32(f0_length, spectral_bins,
+                                                    &data->spectrogram_slab);
+        if (!data->spectrogram_f32) goto allocation_error;
+
+        data->aperiodicity_f32 = allocate_matrix_f32(f0_length, spectral_bins,
+                                                     &data->aperiodicity_slab);
+        if (!data->aperiodicity_f32) goto allocation_error;
+
+        return 0;
     }
 
+    // Allocate spectrogram 2D array
+    data->spectrogram = allocate_matrix(f0_length, spectral_bins, data->layout,
+                                        &data->spectrogram_slab);
+    if (!data->spectrogram) goto allocation_error;
+
     // Allocate aperiodicity 2D array
-    data->aperiodicity = (double**)malloc(sizeof(double*) * f0_length);
+    data->aperiodicity = allocate_matrix(f0_length, spectral_bins, data->layout,
+                                         &data->aperiodicity_slab);
     if (!data->aperiodicity) goto allocation_error;
 
-    for (int i = 0; i < f0_length; i++) {
-        data->aperiodicity[i] = (double*)malloc(sizeof(double) * spectral_bins);
-        if (!data->aperiodicity[i]) goto allocation_error;
+    return 0;
+
+allocation_error:
+    world_analysis_data_free(data);
+    return -1;
+}
+
+int world_analysis_data_convert(WorldAnalysisData* data, WorldPrecision precision) {
+    if (!data) return -1;
+    if (data->precision == precision) return 0;
+
+    int frames = data->sp_length;
+    int bins = data->fft_size / 2 + 1;
+    if (frames <= 0 || data->ap_length != frames) return -1;
+
+    if (precision == WORLD_PRECISION_FLOAT32) {
+        if (!data->spectrogram || !data->aperiodicity) return -1;
+
+        void* sp_slab = NULL;
+        void* ap_slab = NULL;
+        float** sp = allocate_matrix_f32(frames, bins, &sp_slab);
+        float** ap = allocate_matrix_f32(frames, bins, &ap_slab);
+        if (!sp || !ap) {
+            free_matrix_f32(sp, sp_slab);
+            free_matrix_f32(ap, ap_slab);
+            return -1;
+        }
+        for (int i = 0; i < frames; i++) {
+            simd_convert_f64_to_f32(data->spectrogram[i], sp[i], (size_t)bins);
+            simd_convert_f64_to_f32(data->aperiodicity[i], ap[i], (size_t)bins);
+        }
+
+        drop_matrices(data);
+        data->spectrogram_f32 = sp;
+        data->aperiodicity_f32 = ap;
+        data->spectrogram_slab = sp_slab;
+        data->aperiodicity_slab = ap_slab;
+    } else {
+        if (!data->spectrogram_f32 || !data->aperiodicity_f32) return -1;
+
+        void* sp_slab = NULL;
+        void* ap_slab = NULL;
+        double** sp = allocate_matrix(frames, bins, data->layout, &sp_slab);
+        double** ap = allocate_matrix(frames, bins, data->layout, &ap_slab);
+        if (!sp || !ap) {
+            free_matrix(sp, frames, sp_slab);
+            free_matrix(ap, frames, ap_slab);
+            return -1;
+        }
+        for (int i = 0; i < frames; i++) {
+            simd_convert_f32_to_f64(data->spectrogram_f32[i], sp[i], (size_t)bins);
+            simd_convert_f32_to_f64(data->aperiodicity_f32[i], ap[i], (size_t)bins);
+        }
+
+        drop_matrices(data);
+        data->spectrogram = sp;
+        data->aperiodicity = ap;
+        data->spectrogram_slab = sp_slab;
+        data->aperiodicity_slab = ap_slab;
+    }
+
+    data->precision = precision;
+    data->frame_capacity = frames;
+    return 0;
+}
+
+int world_analysis_data_is_coded(const WorldAnalysisData* data) {
+    return data && data->coded_spectrogram && data->coded_aperiodicity;
+}
+
+// Coded matrices share one slab: [frames][sp_dims] then [frames][ap_dims]
+static int allocate_coded(int frames, int sp_dims, int ap_dims, double*** out_sp,
+                          double*** out_ap, double** out_slab) {
+    double** coded_sp = (double**)calloc((size_t)frames, sizeof(double*));
+    double** coded_ap = (double**)calloc((size_t)frames, sizeof(double*));
+    double* slab = (double*)aligned_alloc_bytes(sizeof(double) * (size_t)frames *
+                                                (size_t)(sp_dims + ap_dims));
+    if (!coded_sp || !coded_ap || !slab) {
+        free(coded_sp);
+        free(coded_ap);
+        aligned_free_bytes(slab);
+        return -1;
+    }
+    for (int i = 0; i < frames; i++) {
+        coded_sp[i] = slab + (size_t)i * (size_t)sp_dims;
+        coded_ap[i] = slab + (size_t)frames * (size_t)sp_dims + (size_t)i * (size_t)ap_dims;
     }
+    *out_sp = coded_sp;
+    *out_ap = coded_ap;
+    *out_slab = slab;
+    return 0;
+}
 
-    // Set dimensions
+int world_analysis_data_allocate_coded(WorldAnalysisData* data, int f0_length, int fft_size,
+                                       int sp_dims, int ap_dims) {
+    if (!data || f0_length <= 0 || fft_size <= 0 || sp_dims <= 0 || ap_dims <= 0) return -1;
+
+    world_analysis_data_free(data);
+
+    data->f0 = (double*)malloc(sizeof(double) * f0_length);
+    data->temporal_positions = (double*)malloc(sizeof(double) * f0_length);
+    if (!data->f0 || !data->temporal_positions ||
+        allocate_coded(f0_length, sp_dims, ap_dims, &data->coded_spectrogram,
+                       &data->coded_aperiodicity, &data->coded_slab) != 0) {
+        world_analysis_data_free(data);
+        return -1;
+    }
+    data->frame_capacity = f0_length;
     data->f0_length = f0_length;
     data->sp_length = f0_length;
     data->ap_length = f0_length;
     data->fft_size = fft_size;
-
+    data->coded_sp_dims = sp_dims;
+    data->coded_ap_dims = ap_dims;
     return 0;
+}
+
+// Row table over a frame-major block of row_bytes-sized rows
+static void** row_table(void* block, int frames, size_t row_bytes) {
+    void** rows = (void**)malloc(sizeof(void*) * (size_t)frames);
+    if (!rows) return NULL;
+    for (int i = 0; i < frames; i++) {
+        rows[i] = (uint8_t*)block + (size_t)i * row_bytes;
+    }
+    return rows;
+}
+
+int world_analysis_data_attach(WorldAnalysisData* data, int f0_length, int fft_size,
+                               const WorldAnalysisStorage* storage) {
+    if (!data || !storage || !storage->f0 || !storage->spectrogram || !storage->aperiodicity ||
+        !storage->release || f0_length <= 0 || fft_size <= 0) {
+        return -1;
+    }
 
-allocation_error:
     world_analysis_data_free(data);
-    return -1;
+
+    int coded = storage->coded_sp_dims > 0;
+    size_t bins = (size_t)(fft_size / 2 + 1);
+    size_t value_size = (!coded && storage->precision == WORLD_PRECISION_FLOAT32) ? sizeof(float)
+                                                                                   : sizeof(double);
+    size_t sp_row = (coded ? (size_t)storage->coded_sp_dims : bins) * value_size;
+    size_t ap_row = (coded ? (size_t)storage->coded_ap_dims : bins) * value_size;
+    if (coded && storage->coded_ap_dims <= 0) return -1;
+
+    void** sp = row_table(storage->spectrogram, f0_length, sp_row);
+    void** ap = row_table(storage->aperiodicity, f0_length, ap_row);
+    double* temporal_positions = (double*)malloc(sizeof(double) * f0_length);
+    if (!sp || !ap || !temporal_positions) {
+        free(sp);
+        free(ap);
+        free(temporal_positions);
+        return -1;
+    }
+
+    if (coded) {
+        data->coded_spectrogram = (double**)sp;
+        data->coded_aperiodicity = (double**)ap;
+        data->coded_sp_dims = storage->coded_sp_dims;
+        data->coded_ap_dims = storage->coded_ap_dims;
+    } else if (storage->precision == WORLD_PRECISION_FLOAT32) {
+        data->spectrogram_f32 = (float**)sp;
+        data->aperiodicity_f32 = (float**)ap;
+        data->spectrogram_slab = storage->spectrogram;
+        data->aperiodicity_slab = storage->aperiodicity;
+    } else {
+        data->spectrogram = (double**)sp;
+        data->aperiodicity = (double**)ap;
+        // Non-NULL slab: the rows are one contiguous run
+        data->spectrogram_slab = storage->spectrogram;
+        data->aperiodicity_slab = storage->aperiodicity;
+    }
+    if (!coded) data->precision = storage->precision;
+
+    data->f0 = storage->f0;
+    data->temporal_positions = temporal_positions;
+    data->frame_capacity = f0_length;
+    data->f0_length = f0_length;
+    data->sp_length = f0_length;
+    data->ap_length = f0_length;
+    data->fft_size = fft_size;
+    data->storage_release = storage->release;
+    data->storage_owner = storage->owner;
+    data->borrowed_matrices = 1;
+    return 0;
 }
 
-int world_analyze(const double* x, int x_length, int fs,
-                  double frame_period, double f0_floor, double f0_ceil,
-                  WorldAnalysisData* data) {
-    if (!x || !data || x_length <= 0 || fs <= 0) return -1;
+// Storage shared by world_analysis_data_share(); freed with its last user
+typedef struct {
+    worldx_atomic_t refs;
+    double* f0;
+    void* spectrogram_slab;
+    void* aperiodicity_slab;
+} SharedStorage;
+
+static void shared_release(void* owner) {
+    SharedStorage* s = (SharedStorage*)owner;
+    if (worldx_atomic_dec(&s->refs) > 0) return;
+    free(s->f0);
+    aligned_free_bytes(s->spectrogram_slab);
+    aligned_free_bytes(s->aperiodicity_slab);
+    free(s);
+}
+
+int world_analysis_data_share(WorldAnalysisData* data, WorldAnalysisData* out) {
+    if (!data || !out || data == out || world_analysis_data_is_coded(data) || !data->f0 ||
+        data->f0_length <= 0 || !data->spectrogram_slab || !data->aperiodicity_slab) {
+        return -1;
+    }
+    SharedStorage* s = NULL;
+    if (data->storage_release == shared_release) {
+        s = (SharedStorage*)data->storage_owner;
+        worldx_atomic_inc(&s->refs);
+    } else if (data->storage_release) {
+        return -1;
+    } else {
+        // data keeps its row tables and hands the blocks to the shared owner
+        s = (SharedStorage*)malloc(sizeof(*s));
+        if (!s) return -1;
+        s->refs = 2;
+        s->f0 = data->f0;
+        s->spectrogram_slab = data->spectrogram_slab;
+        s->aperiodicity_slab = data->aperiodicity_slab;
+        data->storage_release = shared_release;
+        data->storage_owner = s;
+        data->borrowed_matrices = 1;
+    }
+
+    WorldAnalysisStorage storage;
+    memset(&storage, 0, sizeof(storage));
+    storage.f0 = data->f0;
+    storage.spectrogram = data->spectrogram_slab;
+    storage.aperiodicity = data->aperiodicity_slab;
+    storage.precision = data->precision;
+    storage.release = shared_release;
+    storage.owner = s;
+    if (world_analysis_data_attach(out, data->f0_length, data->fft_size, &storage) != 0) {
+        shared_release(s);
+        return -1;
+    }
+    if (data->temporal_positions) {
+        memcpy(out->temporal_positions, data->temporal_positions, sizeof(double) * (size_t)data->f0_length);
+    } else {
+        memset(out->temporal_positions, 0, sizeof(double) * (size_t)data->f0_length);
+    }
+    out->frame_period = data->frame_period;
+    out->sample_rate = data->sample_rate;
+    out->x_length = data->x_length;
+    out->f0_estimator = data->f0_estimator;
+    return 0;
+}
+
+int world_analysis_data_encode(WorldAnalysisData* data, int sp_dims) {
+    if (!data || world_analysis_data_is_coded(data)) return -1;
+    if (sp_dims <= 0) sp_dims = WORLD_CODED_SP_DIMS_DEFAULT;
+
+    int frames = data->sp_length;
+    int bins = data->fft_size / 2 + 1;
+    int ap_dims = GetNumberOfAperiodicities(data->sample_rate);
+    if (frames <= 0 || data->ap_length != frames || sp_dims > bins || ap_dims <= 0) return -1;
+
+    // WORLD's coders take double rows; float32 data is widened into a
+    // temporary copy first
+    double** sp = data->spectrogram;
+    double** ap = data->aperiodicity;
+    void* wide_sp_slab = NULL;
+    void* wide_ap_slab = NULL;
+    if (data->precision == WORLD_PRECISION_FLOAT32) {
+        if (!data->spectrogram_f32 || !data->aperiodicity_f32) return -1;
+        sp = allocate_matrix(frames, bins, WORLD_LAYOUT_CONTIGUOUS, &wide_sp_slab);
+        ap = allocate_matrix(frames, bins, WORLD_LAYOUT_CONTIGUOUS, &wide_ap_slab);
+        if (!sp || !ap) {
+            free_matrix(sp, frames, wide_sp_slab);
+            free_matrix(ap, frames, wide_ap_slab);
+            return -1;
+        }
+        for (int i = 0; i < frames; i++) {
+            simd_convert_f32_to_f64(data->spectrogram_f32[i], sp[i], (size_t)bins);
+            simd_convert_f32_to_f64(data->aperiodicity_f32[i], ap[i], (size_t)bins);
+        }
+    } else if (!sp || !ap) {
+        return -1;
+    }
+
+    double** coded_sp = NULL;
+    double** coded_ap = NULL;
+    double* slab = NULL;
+    int result = -1;
+    if (allocate_coded(frames, sp_dims, ap_dims, &coded_sp, &coded_ap, &slab) == 0) {
+        CodeSpectralEnvelope((const double* const*)sp, frames, data->sample_rate,
+                             data->fft_size, sp_dims, coded_sp);
+        CodeAperiodicity((const double* const*)ap, frames, data->sample_rate,
+                         data->fft_size, coded_ap);
+        result = 0;
+    }
+
+    if (wide_sp_slab || wide_ap_slab) {
+        free_matrix(sp, frames, wide_sp_slab);
+        free_matrix(ap, frames, wide_ap_slab);
+    }
+    if (result != 0) return -1;
+
+    // Drop the full matrices; only the coded frames remain resident
+    drop_matrices(data);
+
+    data->coded_spectrogram = coded_sp;
+    data->coded_aperiodicity = coded_ap;
+    data->coded_sp_dims = sp_dims;
+    data->coded_ap_dims = ap_dims;
+    data->coded_slab = slab;
+    return 0;
+}
+
+int world_analysis_data_get_frame(const WorldAnalysisData* data, int frame,
+                                  double* sp_row, double* ap_row) {
+    return world_analysis_data_get_frames(data, frame, 1, &sp_row, &ap_row);
+}
+
+int world_analysis_data_get_frames(const WorldAnalysisData* data, int first, int count,
+                                   double* const* sp_rows, double* const* ap_rows) {
+    if (!data || !sp_rows || !ap_rows || first < 0 || count < 0 || first > data->sp_length - count) {
+        return -1;
+    }
+
+    size_t bins = (size_t)(data->fft_size / 2 + 1);
+    if (world_analysis_data_is_coded(data)) {
+        // One decoder call per range: WORLD sets up its IDCT plan per call
+        DecodeSpectralEnvelope((const double* const*)(data->coded_spectrogram + first), count,
+                               data->sample_rate, data->fft_size, data->coded_sp_dims,
+                               (double**)sp_rows);
+        DecodeAperiodicity((const double* const*)(data->coded_aperiodicity + first), count,
+                           data->sample_rate, data->fft_size, (double**)ap_rows);
+        return 0;
+    }
+    if (data->precision == WORLD_PRECISION_FLOAT32) {
+        if (!data->spectrogram_f32 || !data->aperiodicity_f32) return -1;
+        for (int i = 0; i < count; i++) {
+            simd_convert_f32_to_f64(data->spectrogram_f32[first + i], sp_rows[i], bins);
+            simd_convert_f32_to_f64(data->aperiodicity_f32[first + i], ap_rows[i], bins);
+        }
+        return 0;
+    }
+    if (!data->spectrogram || !data->aperiodicity) return -1;
+    for (int i = 0; i < count; i++) {
+        memcpy(sp_rows[i], data->spectrogram[first + i], sizeof(double) * bins);
+        memcpy(ap_rows[i], data->aperiodicity[first + i], sizeof(double) * bins);
+    }
+    return 0;
+}
+
+// Frame slice analyzed by one worker of world_analyze()
+typedef struct {
+    const double* x;
+    int x_length;
+    WorldSpectralWork* work;
+    WorldAnalysisData* data;
+    int begin;
+    int end;
+    int running;
+    worldx_thread_t thread;
+} AnalysisSlice;
+
+static void analyze_slice(void* arg) {
+    AnalysisSlice* slice = (AnalysisSlice*)arg;
+    WorldAnalysisData* data = slice->data;
+
+    world_spectral_analyze(slice->work, slice->x, slice->x_length,
+                           data->temporal_positions, data->f0, slice->begin, slice->end,
+                           data->spectrogram, data->aperiodicity);
+}
+
+void world_analysis_options_init(WorldAnalysisOptions* options) {
+    if (!options) return;
+
+    options->frame_period = 5.0;
+    options->f0_floor = 71.0;
+    options->f0_ceil = 800.0;
+    options->f0_estimator = WORLD_F0_HARVEST;
+    options->num_threads = 1;
+}
+
+// Lowest rate WORLD_F0_HARVEST_DECIMATED runs Harvest at, and the largest
+// decimation factor (Harvest's own internal limit)
+#define WORLD_DECIMATED_MIN_FS 4000.0
+#define WORLD_DECIMATED_MAX_FACTOR 12
+
+// Largest integer factor that divides fs and keeps the decimated rate at or
+// above both WORLD_DECIMATED_MIN_FS and 4 * f0_ceil. Harvest only needs the
+// band around the fundamental, so a few kHz is plenty.
+static int harvest_decimation_factor(int fs, double f0_ceil) {
+    double target = 4.0 * f0_ceil;
+    if (target < WORLD_DECIMATED_MIN_FS) target = WORLD_DECIMATED_MIN_FS;
+    int factor = (int)(fs / target);
+    if (factor > WORLD_DECIMATED_MAX_FACTOR) factor = WORLD_DECIMATED_MAX_FACTOR;
+    for (; factor > 1; factor--) {
+        if (fs % factor == 0) return factor;
+    }
+    return 1;
+}
+
+// Hann-windowed sinc low-pass at 90% of the output Nyquist, evaluated only at
+// the kept samples
+static void decimate_signal(const double* x, int x_length, int factor, double* y, int y_length) {
+    int half = 8 * factor;
+    double cutoff = 0.9 / factor;  // relative to the input Nyquist
+    double taps[2 * 8 * WORLD_DECIMATED_MAX_FACTOR + 1];
+    double gain = 0.0;
+    for (int k = -half; k <= half; k++) {
+        double t = M_PI * cutoff * k;
+        double sinc = k == 0 ? 1.0 : sin(t) / t;
+        double window = 0.5 + 0.5 * cos(M_PI * k / (half + 1));
+        taps[k + half] = sinc * window;
+        gain += taps[k + half];
+    }
+
+    for (int m = 0; m < y_length; m++) {
+        int center = m * factor;
+        double acc = 0.0;
+        for (int k = -half; k <= half; k++) {
+            int n = center + k;
+            if (n >= 0 && n < x_length) acc += taps[k + half] * x[n];
+        }
+        y[m] = acc / gain;
+    }
+}
+
+// Grow-only work buffers of one analysis, including each slice's CheapTrick/
+// D4C plans and buffers. world_analyze() uses a throwaway set; a
+// WorldAnalysisContext keeps its own across calls.
+typedef struct {
+    double* values;
+    size_t value_capacity;
+    AnalysisSlice* slices;
+    int slice_capacity;
+    WorldSpectralWork** works;
+    int work_count;
+} AnalysisScratch;
+
+static double* scratch_values(AnalysisScratch* scratch, size_t count) {
+    if (count > scratch->value_capacity) {
+        double* grown = (double*)realloc(scratch->values, sizeof(double) * count);
+        if (!grown) return NULL;
+        scratch->values = grown;
+        scratch->value_capacity = count;
+    }
+    return scratch->values;
+}
+
+static AnalysisSlice* scratch_slices(AnalysisScratch* scratch, int count) {
+    if (count > scratch->slice_capacity) {
+        AnalysisSlice* grown =
+            (AnalysisSlice*)realloc(scratch->slices, sizeof(AnalysisSlice) * (size_t)count);
+        if (!grown) return NULL;
+        scratch->slices = grown;
+        scratch->slice_capacity = count;
+    }
+    memset(scratch->slices, 0, sizeof(AnalysisSlice) * (size_t)count);
+    return scratch->slices;
+}
+
+static void scratch_free(AnalysisScratch* scratch) {
+    for (int i = 0; i < scratch->work_count; i++) {
+        world_spectral_work_destroy(scratch->works[i]);
+    }
+    free(scratch->works);
+    free(scratch->values);
+    free(scratch->slices);
+    memset(scratch, 0, sizeof(*scratch));
+}
+
+// Per-sample-rate analysis setup: options plus the WORLD option structs
+// derived from them
+typedef struct {
+    int fs;
+    WorldAnalysisOptions options;
+    CheapTrickOption cheaptrick_option;
+    D4COption d4c_option;
+    int fft_size;
+} AnalysisSetup;
+
+static int setup_init(AnalysisSetup* setup, int fs, const WorldAnalysisOptions* options) {
+    if (fs <= 0) return -1;
+    if (options) {
+        setup->options = *options;
+    } else {
+        world_analysis_options_init(&setup->options);
+    }
+    if (setup->options.frame_period <= 0.0 || setup->options.f0_floor <= 0.0 ||
+        setup->options.f0_ceil <= setup->options.f0_floor) {
+        return -1;
+    }
+
+    setup->fs = fs;
+    InitializeCheapTrickOption(fs, &setup->cheaptrick_option);
+    setup->cheaptrick_option.f0_floor = setup->options.f0_floor;
+    InitializeD4COption(&setup->d4c_option);
+    setup->fft_size = GetFFTSizeForCheapTrick(fs, &setup->cheaptrick_option);
+    return 0;
+}
+
+// Spectral work state for count slices, created for the setup's sample rate
+// and fft_size the first time that many slices run
+static WorldSpectralWork** scratch_works(AnalysisScratch* scratch, const AnalysisSetup* setup,
+                                         int count) {
+    if (count > scratch->work_count) {
+        WorldSpectralWork** grown =
+            (WorldSpectralWork**)realloc(scratch->works, sizeof(WorldSpectralWork*) * (size_t)count);
+        if (!grown) return NULL;
+        scratch->works = grown;
+        for (; scratch->work_count < count; scratch->work_count++) {
+            if (world_spectral_work_create(&grown[scratch->work_count], setup->fs, setup->fft_size,
+                                           setup->cheaptrick_option.q1,
+                                           setup->d4c_option.threshold) != 0) {
+                return NULL;
+            }
+        }
+    }
+    return scratch->works;
+}
+
+// Fill data->f0 / data->temporal_positions (f0_length frames) with the
+// estimator selected in the setup
+static int estimate_f0(const double* x, int x_length, const AnalysisSetup* setup,
+                       AnalysisScratch* scratch, WorldAnalysisData* data) {
+    const WorldAnalysisOptions* options = &setup->options;
+    int fs = setup->fs;
+    int f0_length = data->f0_length;
+
+    if (options->f0_estimator == WORLD_F0_DIO_STONEMASK) {
+        DioOption dio_option;
+        InitializeDioOption(&dio_option);
+        dio_option.frame_period = options->frame_period;
+        dio_option.f0_floor = options->f0_floor;
+        dio_option.f0_ceil = options->f0_ceil;
+
+        double* coarse_f0 = scratch_values(scratch, (size_t)f0_length);
+        if (!coarse_f0) return -1;
+        Dio(x, x_length, fs, &dio_option, data->temporal_positions, coarse_f0);
+        StoneMask(x, x_length, fs, data->temporal_positions, coarse_f0, f0_length, data->f0);
+        return 0;
+    }
 
-    // Initialize WORLD option structures
     HarvestOption harvest_option;
     InitializeHarvestOption(&harvest_option);
-    harvest_option.frame_period = frame_period;
-    harvest_option.f0_floor = f0_floor;
-    harvest_option.f0_ceil = f0_ceil;
+    harvest_option.frame_period = options->frame_period;
+    harvest_option.f0_floor = options->f0_floor;
+    harvest_option.f0_ceil = options->f0_ceil;
 
-    CheapTrickOption cheaptrick_option;
-    InitializeCheapTrickOption(fs, &cheaptrick_option);
-    cheaptrick_option.f0_floor = f0_floor;
+    int factor = options->f0_estimator == WORLD_F0_HARVEST_DECIMATED
+                     ? harvest_decimation_factor(fs, options->f0_ceil) : 1;
+    if (factor == 1) {
+        Harvest(x, x_length, fs, &harvest_option, data->temporal_positions, data->f0);
+        return 0;
+    }
 
-    D4COption d4c_option;
-    InitializeD4COption(&d4c_option);
+    // Harvest on the decimated copy, then map its frames onto the full-rate
+    // frame grid (the counts can differ by one at the very end)
+    int fs_low = fs / factor;
+    int x_low_length = (x_length + factor - 1) / factor;
+    int low_frames = GetSamplesForHarvest(fs_low, x_low_length, options->frame_period);
+    double* x_low = scratch_values(scratch, (size_t)x_low_length + 2 * (size_t)low_frames);
+    if (!x_low) return -1;
+    double* low_positions = x_low + x_low_length;
+    double* low_f0 = low_positions + low_frames;
+
+    decimate_signal(x, x_length, factor, x_low, x_low_length);
+    Harvest(x_low, x_low_length, fs_low, &harvest_option, low_positions, low_f0);
+    for (int i = 0; i < f0_length; i++) {
+        data->temporal_positions[i] = i * options->frame_period / 1000.0;
+        data->f0[i] = low_f0[i < low_frames ? i : low_frames - 1];
+    }
+    return 0;
+}
+
+// Full analysis into double matrices; data->precision must be DOUBLE
+static int analyze_double(const double* x, int x_length, const AnalysisSetup* setup,
+                          AnalysisScratch* scratch, WorldAnalysisData* data) {
+    const WorldAnalysisOptions* options = &setup->options;
+    int fs = setup->fs;
 
     // Calculate required array sizes
-    int f0_length = GetSamplesForHarvest(fs, x_length, frame_period);
-    int fft_size = GetFFTSizeForCheapTrick(fs, &cheaptrick_option);
+    int f0_length = options->f0_estimator == WORLD_F0_DIO_STONEMASK
+                        ? GetSamplesForDIO(fs, x_length, options->frame_period)
+                        : GetSamplesForHarvest(fs, x_length, options->frame_period);
 
-    // Allocate memory for analysis data
-    if (world_analysis_data_allocate(data, f0_length, fft_size) != 0) {
+    // Allocate memory for analysis data (reused when it already fits)
+    if (world_analysis_data_allocate(data, f0_length, setup->fft_size) != 0) {
         return -1;
     }
 
     // Store analysis parameters
-    data->frame_period = frame_period;
+    data->frame_period = options->frame_period;
     data->sample_rate = fs;
     data->x_length = x_length;
+    data->f0_estimator = options->f0_estimator;
 
-    // Perform F0 analysis with Harvest
-    Harvest(x, x_length, fs, &harvest_option, data->temporal_positions, data->f0);
+    if (estimate_f0(x, x_length, setup, scratch, data) != 0) {
+        world_analysis_data_free(data);
+        return -1;
+    }
 
-    // Perform spectral envelope analysis with CheapTrick
-    CheapTrick(x, x_length, fs, data->temporal_positions, data->f0, f0_length,
-               &cheaptrick_option, data->spectrogram);
+    // Split the CheapTrick/D4C frame range into contiguous slices, each with
+    // its own FFT plans and buffers
+    int num_threads = options->num_threads;
+    if (num_threads <= 0) num_threads = worldx_cpu_count();
+    if (num_threads > f0_length) num_threads = f0_length;
 
-    // Perform aperiodicity analysis with D4C
-    D4C(x, x_length, fs, data->temporal_positions, data->f0, f0_length,
-        fft_size, &d4c_option, data->aperiodicity);
+    AnalysisSlice* slices = scratch_slices(scratch, num_threads);
+    WorldSpectralWork** works = scratch_works(scratch, setup, num_threads);
+    if (!slices || !works) {
+        world_analysis_data_free(data);
+        return -1;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        slices[t].work = works[t];
+        slices[t].x = x;
+        slices[t].x_length = x_length;
+        slices[t].data = data;
+        slices[t].begin = (int)((long long)f0_length * t / num_threads);
+        slices[t].end = (int)((long long)f0_length * (t + 1) / num_threads);
+    }
+
+    // Slice 0 runs on the calling thread; if a worker fails to start its
+    // slice is analyzed inline instead
+    for (int t = 1; t < num_threads; t++) {
+        slices[t].running =
+            worldx_thread_create(&slices[t].thread, analyze_slice, &slices[t]) == 0;
+        if (!slices[t].running) {
+            analyze_slice(&slices[t]);
+        }
+    }
+    analyze_slice(&slices[0]);
+    for (int t = 1; t < num_threads; t++) {
+        if (slices[t].running) {
+            worldx_thread_join(&slices[t].thread);
+        }
+    }
 
     return 0;
 }
 
-int world_synthesize(const WorldAnalysisData* data, double* y, int y_length) {
-    if (!data || !y || y_length <= 0) return -1;
-    if (!data->f0 || !data->spectrogram || !data->aperiodicity) return -1;
+int world_analyze(const double* x, int x_length, int fs,
+                  const WorldAnalysisOptions* options, WorldAnalysisData* data) {
+    if (!x || !data || x_length <= 0) return -1;
+
+    AnalysisSetup setup;
+    if (setup_init(&setup, fs, options) != 0) return -1;
 
-    // Perform WORLD synthesis
-    Synthesis(data->f0, data->f0_length, data->spectrogram, data->aperiodicity,
-              data->fft_size, data->frame_period, data->sample_rate,
-              y_length, y);
+    // WORLD computes in double; float32 storage is narrowed once afterwards
+    WorldPrecision precision = data->precision;
+    data->precision = WORLD_PRECISION_DOUBLE;
 
+    AnalysisScratch scratch = { 0 };
+    int result = analyze_double(x, x_length, &setup, &scratch, data);
+    scratch_free(&scratch);
+    if (result == 0 && precision != WORLD_PRECISION_DOUBLE) {
+        result = world_analysis_data_convert(data, precision);
+        if (result != 0) world_analysis_data_free(data);
+    }
+
+    data->precision = precision;
+    return result;
+}
+
+struct WorldAnalysisContext {
+    AnalysisSetup setup;
+    AnalysisScratch scratch;
+    // Double-precision staging for callers that store float32
+    WorldAnalysisData work;
+};
+
+int world_analysis_context_create(WorldAnalysisContext** out_ctx, int fs,
+                                  const WorldAnalysisOptions* options) {
+    if (!out_ctx) return -1;
+    *out_ctx = NULL;
+
+    WorldAnalysisContext* ctx = (WorldAnalysisContext*)calloc(1, sizeof(WorldAnalysisContext));
+    if (!ctx) return -1;
+    if (setup_init(&ctx->setup, fs, options) != 0) {
+        free(ctx);
+        return -1;
+    }
+    world_analysis_data_init(&ctx->work);
+
+    *out_ctx = ctx;
     return 0;
 }
 
+int world_analysis_context_fft_size(const WorldAnalysisContext* ctx) {
+    return ctx ? ctx->setup.fft_size : 0;
+}
+
+// Narrow double analysis into float32 data, reusing its buffers
+static int narrow_into(const WorldAnalysisData* src, WorldAnalysisData* dst) {
+    if (world_analysis_data_allocate(dst, src->f0_length, src->fft_size) != 0) return -1;
+
+    size_t bins = (size_t)(src->fft_size / 2 + 1);
+    memcpy(dst->f0, src->f0, sizeof(double) * (size_t)src->f0_length);
+    memcpy(dst->temporal_positions, src->temporal_positions,
+           sizeof(double) * (size_t)src->f0_length);
+    for (int i = 0; i < src->f0_length; i++) {
+        simd_convert_f64_to_f32(src->spectrogram[i], dst->spectrogram_f32[i], bins);
+        simd_convert_f64_to_f32(src->aperiodicity[i], dst->aperiodicity_f32[i], bins);
+    }
+    dst->frame_period = src->frame_period;
+    dst->sample_rate = src->sample_rate;
+    dst->x_length = src->x_length;
+    dst->f0_estimator = src->f0_estimator;
+    return 0;
+}
+
+int world_analysis_context_analyze(WorldAnalysisContext* ctx, const double* x, int x_length,
+                                   WorldAnalysisData* data) {
+    if (!ctx || !x || !data || x_length <= 0) return -1;
+
+    if (data->precision == WORLD_PRECISION_DOUBLE) {
+        return analyze_double(x, x_length, &ctx->setup, &ctx->scratch, data);
+    }
+
+    if (analyze_double(x, x_length, &ctx->setup, &ctx->scratch, &ctx->work) != 0) return -1;
+    return narrow_into(&ctx->work, data);
+}
+
+void world_analysis_context_destroy(WorldAnalysisContext* ctx) {
+    if (!ctx) return;
+
+    scratch_free(&ctx->scratch);
+    world_analysis_data_free(&ctx->work);
+    free(ctx);
+}
+
+// Block size world_synthesize() streams with; the samples do not depend on it
+#define WORLD_SYNTH_BLOCK_SIZE 512
+
+int world_synthesize(const WorldAnalysisData* data, double* y, int y_length) {
+    if (!data || !y || y_length <= 0) return -1;
+    if (!data->f0) return -1;
+    return world_synthesize_streamed(data, y, y_length, WORLD_SYNTH_BLOCK_SIZE);
+}
+
 int world_generate_dummy_data(WorldAnalysisData* data, double duration_sec,
                               int fs, double frame_period, double base_f0) {
     if (!data || duration_sec <= 0 || fs <= 0 || base_f0 <= 0) return -1;
@@ -191,8 +1033,13 @@ int world_generate_dummy_data(WorldAnalysisData* data, double duration_sec,
     int f0_length = (int)(duration_sec * 1000.0 / frame_period) + 1;
     int fft_size = 2048; // Default FFT size
 
+    // Generated in double, then stored in the requested precision
+    WorldPrecision precision = data->precision;
+    data->precision = WORLD_PRECISION_DOUBLE;
+
     // Allocate memory
     if (world_analysis_data_allocate(data, f0_length, fft_size) != 0) {
+        data->precision = precision;
         return -1;
     }
 
@@ -240,5 +1087,12 @@ int world_generate_dummy_data(WorldAnalysisData* data, double duration_sec,
         }
     }
 
+    if (precision != WORLD_PRECISION_DOUBLE &&
+        world_analysis_data_convert(data, precision) != 0) {
+        world_analysis_data_free(data);
+        data->precision = precision;
+        return -1;
+    }
+
     return 0;
 }
@@ -17,6 +17,67 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 
+/** Alignment in bytes of the contiguous spectrogram/aperiodicity slabs */
+#define WORLD_DATA_ALIGNMENT 64
+
+/**
+ * @brief Memory layout of the spectrogram and aperiodicity matrices
+ *
+ * Both layouts expose the same `double**` row table, so WORLD and every
+ * consumer of WorldAnalysisData index rows identically. They differ only in
+ * where the rows live.
+ */
+typedef enum {
+    /** One WORLD_DATA_ALIGNMENT-aligned slab per matrix, rows are views into it */
+    WORLD_LAYOUT_CONTIGUOUS = 0,
+    /** One heap allocation per row */
+    WORLD_LAYOUT_ROWS = 1
+} WorldDataLayout;
+
+/**
+ * @brief Storage precision of the spectrogram and aperiodicity matrices
+ *
+ * WORLD itself only computes in double. With WORLD_PRECISION_FLOAT32 the
+ * matrices are stored as float, halving their footprint, and are widened
+ * with SIMD only where they are handed to WORLD.
+ */
+typedef enum {
+    /** Rows are exposed through `spectrogram` / `aperiodicity` */
+    WORLD_PRECISION_DOUBLE = 0,
+    /** Rows are exposed through `spectrogram_f32` / `aperiodicity_f32` */
+    WORLD_PRECISION_FLOAT32 = 1
+} WorldPrecision;
+
+/**
+ * @brief F0 estimator used by world_analyze()
+ *
+ * Values are stored in .worldcache headers; do not renumber.
+ */
+typedef enum {
+    /** Harvest at the input rate (most robust, slowest) */
+    WORLD_F0_HARVEST = 0,
+    /** DIO refined by StoneMask (much faster, less robust on breathy input) */
+    WORLD_F0_DIO_STONEMASK = 1,
+    /** Harvest on a copy decimated to a few kHz, just above what f0_ceil needs */
+    WORLD_F0_HARVEST_DECIMATED = 2
+} WorldF0Estimator;
+
+/**
+ * @brief Options for world_analyze()
+ */
+typedef struct {
+    /** Frame period in milliseconds (default: 5.0) */
+    double frame_period;
+    /** Lower F0 limit in Hz (default: 71.0) */
+    double f0_floor;
+    /** Upper F0 limit in Hz (default: 800.0) */
+    double f0_ceil;
+    /** F0 estimator (default: WORLD_F0_HARVEST) */
+    WorldF0Estimator f0_estimator;
+    /** CheapTrick/D4C worker threads; <= 0 selects the number of online CPUs (default: 1) */
+    int num_threads;
+} WorldAnalysisOptions;
+
 /**
  * @brief WORLD analysis data container
  *
@@ -49,12 +110,75 @@ typedef struct {
     double frame_period;  /**< Frame period in milliseconds */
     int sample_rate;      /**< Original sample rate */
     int x_length;         /**< Original signal length */
+    WorldF0Estimator f0_estimator; /**< F0 estimator that produced f0 */
+
+    /** Frames the current f0/sp/ap buffers can hold (>= f0_length) */
+    int frame_capacity;
+
+    /** Matrix layout used by world_analysis_data_allocate() */
+    WorldDataLayout layout;
+    /** Backing slab of spectrogram rows (contiguous layout only) */
+    void* spectrogram_slab;
+    /** Backing slab of aperiodicity rows (contiguous layout only) */
+    void* aperiodicity_slab;
+
+    /** Matrix precision used by world_analysis_data_allocate() */
+    WorldPrecision precision;
+    /** Float32 spectral envelope rows (WORLD_PRECISION_FLOAT32 only) */
+    float** spectrogram_f32;
+    /** Float32 aperiodicity rows (WORLD_PRECISION_FLOAT32 only) */
+    float** aperiodicity_f32;
+
+    /** Mel-cepstral spectral envelope rows [frame][coded_sp_dims] (coded only) */
+    double** coded_spectrogram;
+    /** Band aperiodicity rows [frame][coded_ap_dims] (coded only) */
+    double** coded_aperiodicity;
+    /** Dimensions of each coded spectral envelope frame */
+    int coded_sp_dims;
+    /** Number of coded aperiodicity bands */
+    int coded_ap_dims;
+    /** Single slab backing both coded matrices */
+    double* coded_slab;
+
+    /** Releases borrowed storage (see world_analysis_data_attach()); NULL when everything is owned */
+    void (*storage_release)(void* owner);
+    /** Owner passed to storage_release */
+    void* storage_owner;
+    /** Whether the current sp/ap rows point into borrowed storage */
+    int borrowed_matrices;
 } WorldAnalysisData;
 
+/**
+ * @brief Externally owned analysis storage for world_analysis_data_attach()
+ *
+ * `spectrogram` and `aperiodicity` are frame-major [f0_length][dims] blocks:
+ * fft_size/2+1 doubles or floats per row for full data, coded_sp_dims /
+ * coded_ap_dims doubles per row for coded data. Blocks must be aligned for
+ * their value type.
+ */
+typedef struct {
+    double* f0;
+    void* spectrogram;
+    void* aperiodicity;
+    /** Precision of full rows (ignored for coded rows) */
+    WorldPrecision precision;
+    /** > 0 for coded rows */
+    int coded_sp_dims;
+    int coded_ap_dims;
+    /** Called once with owner when the data no longer uses the storage (required) */
+    void (*release)(void* owner);
+    void* owner;
+} WorldAnalysisStorage;
+
+/** Default number of mel-cepstral dimensions for coded spectral envelopes */
+#define WORLD_CODED_SP_DIMS_DEFAULT 60
+
 /**
  * @brief Initialize WorldAnalysisData structure
  *
- * Initializes all pointers to NULL and lengths to 0.
+ * Initializes all pointers to NULL and lengths to 0, and selects
+ * WORLD_LAYOUT_CONTIGUOUS with WORLD_PRECISION_DOUBLE. Set `layout` or
+ * `precision` afterwards to request another storage format.
  * Must be called before using the structure.
  *
  * @param data Pointer to WorldAnalysisData structure to initialize
@@ -64,7 +188,9 @@ void world_analysis_data_init(WorldAnalysisData* data);
 /**
  * @brief Free all memory allocated in WorldAnalysisData
  *
- * Frees all dynamically allocated arrays and resets the structure.
+ * Frees all dynamically allocated arrays and resets the structure, whichever
+ * layout they were allocated with. The `layout` and `precision` selections
+ * are preserved.
  * Safe to call multiple times on the same structure.
  *
  * @param data Pointer to WorldAnalysisData structure to free
@@ -75,7 +201,14 @@ void world_analysis_data_free(WorldAnalysisData* data);
  * @brief Allocate memory for WorldAnalysisData arrays
  *
  * Allocates memory for F0, spectrogram, aperiodicity, and temporal_positions
- * arrays based on the provided dimensions.
+ * arrays based on the provided dimensions. The matrices follow `data->layout`:
+ * WORLD_LAYOUT_CONTIGUOUS needs 6 allocations regardless of length, while
+ * WORLD_LAYOUT_ROWS needs 2 * f0_length + 4. WORLD_PRECISION_FLOAT32
+ * matrices are always contiguous.
+ *
+ * Buffers that already hold at least f0_length frames of the same fft_size,
+ * layout and precision are kept (contents are not cleared), so repeated
+ * analysis into the same data only allocates when it grows.
  *
  * @param data Pointer to WorldAnalysisData structure
  * @param f0_length Number of F0 frames
@@ -84,30 +217,186 @@ void world_analysis_data_free(WorldAnalysisData* data);
  */
 int world_analysis_data_allocate(WorldAnalysisData* data, int f0_length, int fft_size);
 
+/**
+ * @brief Convert the matrices of allocated data to another precision
+ *
+ * Re-stores spectrogram and aperiodicity in the requested precision (a
+ * no-op if already there) and updates `precision`.
+ *
+ * @return 0 on success, -1 on failure (data is left unchanged)
+ */
+int world_analysis_data_convert(WorldAnalysisData* data, WorldPrecision precision);
+
+/**
+ * @brief Replace the full spectrogram/aperiodicity with the coded representation
+ *
+ * Codes every frame with WORLD's CodeSpectralEnvelope (sp_dims-dimensional
+ * mel-cepstrum) and CodeAperiodicity (band aperiodicity), then releases the
+ * full fft_size/2+1 bin matrices. fft_size and the frame counts are kept so
+ * frames can be decoded again on demand.
+ *
+ * @param sp_dims Mel-cepstral dimensions; <= 0 selects WORLD_CODED_SP_DIMS_DEFAULT
+ * @return 0 on success, -1 on failure (data is left unchanged)
+ */
+int world_analysis_data_encode(WorldAnalysisData* data, int sp_dims);
+
+/**
+ * @brief Allocate empty coded storage
+ *
+ * Frees any existing data and allocates f0, temporal_positions and the coded
+ * matrices for f0_length frames, for callers that fill the coded frames
+ * themselves (e.g. loading them from a cache).
+ *
+ * @return 0 on success, -1 on memory allocation failure
+ */
+int world_analysis_data_allocate_coded(WorldAnalysisData* data, int f0_length, int fft_size,
+                                       int sp_dims, int ap_dims);
+
+/**
+ * @brief Expose external storage as analysis data without copying
+ *
+ * Frees any existing data, then points f0 and the sp/ap row tables straight
+ * into storage; only the row tables and temporal_positions are allocated.
+ * The rows are writable, so in-place processing works as long as the
+ * storage allows writes (a copy-on-write mapping does). world_analysis_data_convert()
+ * and world_analysis_data_encode() replace the borrowed matrices with owned
+ * ones. storage->release is called from world_analysis_data_free(), and also
+ * when world_analysis_data_allocate() has to replace the storage.
+ *
+ * @return 0 on success, -1 on failure (storage->release is not called)
+ */
+int world_analysis_data_attach(WorldAnalysisData* data, int f0_length, int fft_size,
+                               const WorldAnalysisStorage* storage);
+
+/**
+ * @brief Give a second WorldAnalysisData the same full (double or float32) storage
+ *
+ * Nothing is copied: data's f0 and sp/ap blocks become reference counted
+ * storage that out attaches to (world_analysis_data_attach()), and each of
+ * them frees its share with world_analysis_data_free(). Both then see the
+ * same rows, so neither may write them in place while the other is in use.
+ * Per-row layouts, coded data and storage borrowed from elsewhere cannot be
+ * shared.
+ *
+ * @return 0 on success, -1 on failure (data stays usable either way)
+ */
+int world_analysis_data_share(WorldAnalysisData* data, WorldAnalysisData* out);
+
+/** @brief Whether data holds the coded representation */
+int world_analysis_data_is_coded(const WorldAnalysisData* data);
+
+/**
+ * @brief Materialize one frame as double rows
+ *
+ * Works for every representation: double rows are copied, float32 rows are
+ * widened and coded frames are decoded with WORLD's decoders. This is how
+ * synthesis reads coded data, one frame at a time.
+ *
+ * @param sp_row Receives fft_size/2+1 spectral envelope values
+ * @param ap_row Receives fft_size/2+1 aperiodicity values
+ * @return 0 on success, -1 on failure
+ */
+int world_analysis_data_get_frame(const WorldAnalysisData* data, int frame,
+                                  double* sp_row, double* ap_row);
+
+/**
+ * @brief Materialize frames [first, first + count) as double rows
+ *
+ * Same as world_analysis_data_get_frame() for each frame, but coded frames
+ * are decoded by one DecodeSpectralEnvelope() and one DecodeAperiodicity()
+ * call, so WORLD builds its decoder plans and axes once for the whole range
+ * instead of once per frame.
+ *
+ * @param sp_rows Receives count rows of fft_size/2+1 spectral envelope values
+ * @param ap_rows Receives count rows of fft_size/2+1 aperiodicity values
+ * @return 0 on success, -1 on failure
+ */
+int world_analysis_data_get_frames(const WorldAnalysisData* data, int first, int count,
+                                   double* const* sp_rows, double* const* ap_rows);
+
+/**
+ * @brief Initialize analysis options with the defaults
+ *
+ * frame_period 5 ms, f0 range 71-800 Hz, Harvest, single-threaded.
+ */
+void world_analysis_options_init(WorldAnalysisOptions* options);
+
 /**
  * @brief Perform WORLD analysis on input audio signal
  *
- * Performs complete WORLD analysis (Harvest + CheapTrick + D4C) on the
+ * Performs complete WORLD analysis (F0 estimation + CheapTrick + D4C) on the
  * input audio signal and stores results in WorldAnalysisData structure.
+ * With `data->precision` set to WORLD_PRECISION_FLOAT32, WORLD runs in
+ * double and the result is narrowed once analysis is complete.
+ *
+ * Once the F0 contour is known, the CheapTrick and D4C frame ranges are split
+ * into options->num_threads contiguous slices, each analyzed on its own
+ * thread with its own FFT plans and buffers (see world_spectral.h). The
+ * safeguard noise of every frame comes from a generator seeded by the frame
+ * index rather than WORLD's shared randn() state, so the result is
+ * bit-identical for any thread count.
  *
  * @param x Input audio signal
  * @param x_length Length of input signal
  * @param fs Sample rate
- * @param frame_period Frame period in milliseconds (default: 5.0)
- * @param f0_floor Lower F0 limit in Hz (default: 71.0)
- * @param f0_ceil Upper F0 limit in Hz (default: 800.0)
+ * @param options Analysis options; NULL selects world_analysis_options_init() defaults
  * @param data Output WorldAnalysisData structure (must be initialized)
  * @return 0 on success, -1 on failure
  */
 int world_analyze(const double* x, int x_length, int fs,
-                  double frame_period, double f0_floor, double f0_ceil,
-                  WorldAnalysisData* data);
+                  const WorldAnalysisOptions* options, WorldAnalysisData* data);
+
+/** Opaque reusable analysis state (see world_analysis_context_create()) */
+typedef struct WorldAnalysisContext WorldAnalysisContext;
+
+/**
+ * @brief Create an analysis context for one sample rate and set of options
+ *
+ * The context resolves the WORLD option structs and CheapTrick fft_size once
+ * and keeps grow-only work buffers (F0 scratch, decimated signal, thread
+ * slices, double staging for float32 output) along with every slice's
+ * CheapTrick/D4C FFT plans and frame buffers (see world_spectral.h).
+ * Together with the buffer reuse in world_analysis_data_allocate(),
+ * analyzing file after file into the same WorldAnalysisData allocates
+ * nothing for the envelope and aperiodicity once the buffers have grown to
+ * the longest file; only WORLD's F0 estimator still allocates per call. A
+ * context is not thread-safe; create one per thread.
+ *
+ * @param out_ctx Receives the new context
+ * @param fs Sample rate every analyzed signal must have
+ * @param options Analysis options; NULL selects world_analysis_options_init() defaults
+ * @return 0 on success, -1 on failure
+ */
+int world_analysis_context_create(WorldAnalysisContext** out_ctx, int fs,
+                                  const WorldAnalysisOptions* options);
+
+/** @brief CheapTrick fft_size of every analysis made with the context */
+int world_analysis_context_fft_size(const WorldAnalysisContext* ctx);
+
+/**
+ * @brief Analyze x with the context's sample rate and options
+ *
+ * Same result as world_analyze() with the options the context was created
+ * with. Existing buffers of data are reused when they fit.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int world_analysis_context_analyze(WorldAnalysisContext* ctx, const double* x, int x_length,
+                                   WorldAnalysisData* data);
+
+/** @brief Destroy a context; NULL is ignored */
+void world_analysis_context_destroy(WorldAnalysisContext* ctx);
 
 /**
  * @brief Perform WORLD synthesis from analysis data
  *
- * Synthesizes audio from F0, spectrogram, and aperiodicity data using
- * the WORLD synthesis function.
+ * Synthesizes audio from F0, spectrogram, and aperiodicity data with the
+ * block-streaming port of WORLD's Synthesis() (world_synthesize_streamed()),
+ * which gives the same samples as Synthesis() called right after
+ * randn_reseed(). The noise generator belongs to the call, so any number of
+ * threads may synthesize at once and every call with the same data returns
+ * the same samples. Float32 rows are widened and coded rows decoded a ring
+ * of frames at a time, so the full double matrices never exist at once.
  *
  * @param data WorldAnalysisData containing synthesis parameters
  * @param y Output audio buffer (must be pre-allocated)
@@ -0,0 +1,110 @@
+#include "worldcache_analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Range reads: worldcache_read_frames returns exactly the frames of a full
+ * load, for plain and chunked compressed caches, and a short range of a
+ * compressed cache reads only the chunks it touches. */
+
+static const char* kCache = "worldcache_chunks_test.worldcache";
+
+static int write_cache(const WorldAnalysisData* data, int compressed) {
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_header_from_analysis(&h, data) != 0) return -1;
+    if (compressed) h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+    FILE* f = fopen(kCache, "wb");
+    if (!f) return -1;
+    int result = worldcache_write_analysis(f, &h, data);
+    return fclose(f) == 0 ? result : -1;
+}
+
+/* Frame i of a against frame j of src */
+static int same_frame(const WorldAnalysisData* a, int i, const WorldAnalysisData* src, int j) {
+    size_t bins = (size_t)(src->fft_size / 2 + 1);
+    if (a->f0[i] != src->f0[j] || a->temporal_positions[i] != src->temporal_positions[j]) return 0;
+    if (src->precision == WORLD_PRECISION_FLOAT32) {
+        return memcmp(a->spectrogram_f32[i], src->spectrogram_f32[j], bins * sizeof(float)) == 0 &&
+               memcmp(a->aperiodicity_f32[i], src->aperiodicity_f32[j], bins * sizeof(float)) == 0;
+    }
+    return memcmp(a->spectrogram[i], src->spectrogram[j], bins * sizeof(double)) == 0 &&
+           memcmp(a->aperiodicity[i], src->aperiodicity[j], bins * sizeof(double)) == 0;
+}
+
+/* Check a set of ranges against src; returns 0 or a failing step */
+static int check_ranges(const WorldAnalysisData* src, const char* label) {
+    int n = src->f0_length;
+    const int ranges[][2] = {
+        { 0, n },                                   /* everything */
+        { WORLDCACHE_CHUNK_FRAMES, WORLDCACHE_CHUNK_FRAMES }, /* one whole chunk */
+        { 50, 70 },                                 /* straddles chunk boundaries */
+        { 7, 3 },                                   /* inside one chunk */
+        { n - 10, 100 },                            /* clipped at the end */
+        { n - 1, 1 },
+    };
+    WorldAnalysisData a;
+    world_analysis_data_init(&a);
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        int first = ranges[r][0];
+        int count = first + ranges[r][1] > n ? n - first : ranges[r][1];
+        WorldCacheLoadInfo info;
+        if (worldcache_read_frames(kCache, first, ranges[r][1], &a, &info) != 0 || a.f0_length != count ||
+            a.precision != src->precision || info.bytes_read == 0 || info.bytes_copied != 0) {
+            fprintf(stderr, "%s: range %d+%d failed\n", label, first, ranges[r][1]);
+            return 1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (!same_frame(&a, i, src, first + i)) {
+                fprintf(stderr, "%s: range %d+%d frame %d differs\n", label, first, count, i);
+                return 2;
+            }
+        }
+    }
+    int bad = worldcache_read_frames(kCache, n, 1, &a, NULL) == 0 ||
+              worldcache_read_frames(kCache, -1, 5, &a, NULL) == 0 ||
+              worldcache_read_frames(kCache, 0, 0, &a, NULL) == 0;
+    world_analysis_data_free(&a);
+    if (bad) { fprintf(stderr, "%s: out-of-range read accepted\n", label); return 3; }
+    return 0;
+}
+
+int main(void) {
+    WorldAnalysisData src;
+    world_analysis_data_init(&src);
+    if (world_generate_dummy_data(&src, 2.0, 44100, 5.0, 200.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        const char* label = pass ? "float32" : "double";
+        if (pass && world_analysis_data_convert(&src, WORLD_PRECISION_FLOAT32) != 0) return 2;
+        if (write_cache(&src, 0) != 0) { fprintf(stderr, "%s: write failed\n", label); return 3; }
+        if (check_ranges(&src, label) != 0) return 4;
+
+        if (write_cache(&src, 1) != 0) {
+            printf("%s: compressed caches unavailable (built without zstd)\n", label);
+            continue;
+        }
+        if (check_ranges(&src, label) != 0) return 5;
+
+        /* a short range reads a fraction of the compressed payload */
+        WorldAnalysisData a;
+        world_analysis_data_init(&a);
+        WorldCacheLoadInfo full, part;
+        if (worldcache_read_frames(kCache, 0, src.f0_length, &a, &full) != 0 ||
+            worldcache_read_frames(kCache, 200, 40, &a, &part) != 0) {
+            fprintf(stderr, "%s: compressed read failed\n", label); return 6;
+        }
+        printf("%s: full read %zu bytes, 40 frames %zu bytes\n", label, full.bytes_read, part.bytes_read);
+        if (part.bytes_read * 4 > full.bytes_read) {
+            fprintf(stderr, "%s: partial read decoded too much\n", label); return 7;
+        }
+        world_analysis_data_free(&a);
+    }
+
+    world_analysis_data_free(&src);
+    remove(kCache);
+    printf("worldcache chunks test passed\n");
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "worldcache_dict.h"
+#include "worldcache_manager.h"
+#include "worldcache_pack.h"
+#include "worldcache_voicebank.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#  include <direct.h>
+#  define MKDIR(path) _mkdir(path)
+#  define RMDIR(path) _rmdir(path)
+#else
+#  include <unistd.h>
+#  define MKDIR(path) mkdir((path), 0755)
+#  define RMDIR(path) rmdir(path)
+#endif
+
+/* Streaming chunk compression round-trips at any level and from scattered
+ * rows; a voicebank dictionary is trained, found again from a fresh
+ * registry, and carried into the pack. */
+
+static const char* kDir = "worldcache_dict_vb";
+static const char* kCache = "worldcache_dict_test.worldcache";
+enum { kSamples = 6 };
+
+static void sample_path(char* out, size_t size, int i) { snprintf(out, size, "%s/s%d.wav", kDir, i); }
+
+static void cleanup(void) {
+    char path[256], sidecar[300];
+    for (int i = 0; i < kSamples; i++) {
+        sample_path(path, sizeof(path), i);
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", path);
+        remove(sidecar);
+        remove(path);
+    }
+    snprintf(path, sizeof(path), "%s/%s", kDir, WORLDCACHE_DICT_FILENAME);
+    remove(path);
+    snprintf(path, sizeof(path), "%s/%s", kDir, WORLDPACK_FILENAME);
+    remove(path);
+    RMDIR(kDir);
+    remove(kCache);
+}
+
+static int same_analysis(const WorldAnalysisData* a, const WorldAnalysisData* b) {
+    if (a->f0_length != b->f0_length || a->fft_size != b->fft_size) return 0;
+    size_t bins = (size_t)(a->fft_size / 2 + 1);
+    for (int i = 0; i < a->f0_length; i++) {
+        if (a->f0[i] != b->f0[i] || memcmp(a->spectrogram[i], b->spectrogram[i], bins * sizeof(double)) != 0 ||
+            memcmp(a->aperiodicity[i], b->aperiodicity[i], bins * sizeof(double)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Registry and path walking; no zstd needed */
+static int check_registry(void) {
+    uint8_t fake[64] = { 0x37, 0xA4, 0x30, 0xEC, 0x2A, 0x00, 0x00, 0x00 };
+    const WorldCacheDict* d = worldcache_dict_register(fake, sizeof(fake));
+    uint8_t no_id[64] = { 0x37, 0xA4, 0x30, 0xEC };
+    if (!d || worldcache_dict_id(d) != 42 || worldcache_dict_find(42) != d ||
+        worldcache_dict_register(fake, sizeof(fake)) != d || worldcache_dict_register(no_id, sizeof(no_id)) ||
+        worldcache_dict_register("raw content", 11) || worldcache_dict_find(7)) {
+        return 1;
+    }
+    worldcache_dict_clear();
+    if (worldcache_dict_find(42)) return 2;
+
+    size_t len = worldcache_path_dir_length("vb/sub/a.wav");
+    if (len != 7 || worldcache_path_parent("vb/sub/a.wav", &len) != 0 || len != 3 ||
+        worldcache_path_parent("vb/sub/a.wav", &len) != 0 || len != 0 ||
+        worldcache_path_parent("vb/sub/a.wav", &len) == 0) {
+        return 3;
+    }
+    len = worldcache_path_dir_length("../a.wav");
+    if (len != 3 || worldcache_path_parent("../a.wav", &len) == 0) return 4;
+    return 0;
+}
+
+/* Copy of src with one allocation per row (WORLD_LAYOUT_ROWS) */
+static int copy_rows(const WorldAnalysisData* src, WorldAnalysisData* dst) {
+    world_analysis_data_init(dst);
+    dst->layout = WORLD_LAYOUT_ROWS;
+    if (world_analysis_data_allocate(dst, src->f0_length, src->fft_size) != 0) return -1;
+    size_t bins = (size_t)(src->fft_size / 2 + 1);
+    for (int i = 0; i < src->f0_length; i++) {
+        dst->f0[i] = src->f0[i];
+        dst->temporal_positions[i] = src->temporal_positions[i];
+        memcpy(dst->spectrogram[i], src->spectrogram[i], bins * sizeof(double));
+        memcpy(dst->aperiodicity[i], src->aperiodicity[i], bins * sizeof(double));
+    }
+    dst->sample_rate = src->sample_rate;
+    dst->frame_period = src->frame_period;
+    dst->f0_estimator = src->f0_estimator;
+    return 0;
+}
+
+/* Chunk compression from scattered rows at several levels */
+static int check_levels(const WorldAnalysisData* src) {
+    for (int level = 1; level <= 19; level += 9) {
+        WorldCacheHeader_t h;
+        worldcache_header_init(&h);
+        if (worldcache_header_from_analysis(&h, src) != 0) return 1;
+        h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+        WorldCacheCompression opts = { level, NULL };
+        FILE* f = fopen(kCache, "wb");
+        if (!f) return 2;
+        int written = worldcache_write_analysis_ex(f, &h, src, &opts);
+        if (fclose(f) != 0 || written != 0) return 3;
+
+        WorldAnalysisData a;
+        world_analysis_data_init(&a);
+        int same = worldcache_read_frames(kCache, 0, src->f0_length, &a, NULL) == 0 && same_analysis(&a, src);
+        world_analysis_data_free(&a);
+        if (!same) { fprintf(stderr, "level %d round trip differs\n", level); return 4; }
+    }
+    return 0;
+}
+
+static int cache_flags(const char* wav_path) {
+    char sidecar[300];
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", wav_path);
+    FILE* f = fopen(sidecar, "rb");
+    if (!f) return -1;
+    WorldCacheHeader_t h;
+    int ok = worldcache_header_read(f, &h) == 0;
+    fclose(f);
+    return ok ? h.flags : -1;
+}
+
+int main(void) {
+    cleanup();
+    int step = check_registry();
+    if (step) { fprintf(stderr, "registry check %d failed\n", step); return 1; }
+
+    MKDIR(kDir);
+    char path[256];
+    for (int i = 0; i < kSamples; i++) {
+        sample_path(path, sizeof(path), i);
+        if (worldx_test_write_tone(path, 22050, 0.35, 180.0 + 37.0 * i, 3) != 0) { perror("setup"); return 2; }
+    }
+
+    WorldAnalysisData src;
+    world_analysis_data_init(&src);
+    sample_path(path, sizeof(path), 0);
+    if (worldcache_analyze(path, &src) != 0) { fprintf(stderr, "analysis failed\n"); return 3; }
+    WorldCacheHeader_t probe;
+    worldcache_header_init(&probe);
+    worldcache_header_from_analysis(&probe, &src);
+    probe.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+    uint8_t* buf = NULL;
+    size_t size = 0;
+    if (worldcache_compress_rows(&probe, worldcache_analysis_row, &src, WORLDCACHE_CHUNK_FRAMES, NULL, 0, &buf,
+                                 &size) != 0) {
+        printf("compressed caches unavailable (built without zstd)\n");
+        WorldCacheDictReport report;
+        if (worldcache_dict_train(kDir, 0, &report) == 0) { fprintf(stderr, "trained without zstd\n"); return 4; }
+        world_analysis_data_free(&src);
+        cleanup();
+        printf("worldcache dict test passed\n");
+        return 0;
+    }
+    free(buf);
+    WorldAnalysisData rows;
+    if (copy_rows(&src, &rows) != 0 || rows.spectrogram_slab) { fprintf(stderr, "row copy failed\n"); return 5; }
+    step = check_levels(&rows);
+    world_analysis_data_free(&rows);
+    if (step) { fprintf(stderr, "level check %d failed\n", step); return 5; }
+
+    /* train: every sample gets a sidecar, then all are recompressed with the dictionary */
+    WorldCacheDictReport report;
+    if (worldcache_dict_train(kDir, 16 * 1024, &report) != 0) { fprintf(stderr, "training failed\n"); return 6; }
+    printf("dictionary %u: %zu bytes from %d samples; sidecars %llu -> %llu bytes\n", (unsigned)report.dict_id,
+           report.dict_size, report.samples, (unsigned long long)report.bytes_before,
+           (unsigned long long)report.bytes_after);
+    if (report.samples != kSamples || report.failed != 0 || report.recompressed != kSamples ||
+        report.dict_size == 0 || report.dict_size > 16 * 1024 || report.dict_id == 0) {
+        fprintf(stderr, "bad training report\n"); return 7;
+    }
+    for (int i = 0; i < kSamples; i++) {
+        sample_path(path, sizeof(path), i);
+        int flags = cache_flags(path);
+        if (flags < 0 || !(flags & WORLDCACHE_FLAG_DICT)) { fprintf(stderr, "sidecar %d lacks the dictionary\n", i); return 8; }
+    }
+
+    /* a fresh registry (as in a new process) finds the dictionary beside the samples */
+    worldcache_dict_clear();
+    WorldAnalysisData a;
+    world_analysis_data_init(&a);
+    WorldCacheLoadInfo info;
+    sample_path(path, sizeof(path), 0);
+    if (worldcache_get_analysis_ex(path, &a, &info) != 0 || !info.cache_hit || !same_analysis(&a, &src) ||
+        !worldcache_dict_find(report.dict_id)) {
+        fprintf(stderr, "dictionary cache hit failed\n"); return 9;
+    }
+    worldcache_dict_clear();
+    char sidecar[300];
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", path);
+    if (worldcache_read_frames(sidecar, 40, 20, &a, NULL) != 0 || a.f0_length != 20 || a.f0[0] != src.f0[40]) {
+        fprintf(stderr, "dictionary range read failed\n"); return 10;
+    }
+
+    /* the pack embeds the dictionary and serves its entries without sidecars */
+    WorldPackReport pr;
+    if (worldpack_build(kDir, 1, &pr) != 0 || pr.entries != kSamples || pr.reused != kSamples ||
+        worldpack_verify(kDir, &pr) != 0 || pr.entries != kSamples) {
+        fprintf(stderr, "pack with dictionary failed\n"); return 11;
+    }
+    for (int i = 0; i < kSamples; i++) {
+        sample_path(path, sizeof(path), i);
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", path);
+        remove(sidecar);
+    }
+    snprintf(path, sizeof(path), "%s/%s", kDir, WORLDCACHE_DICT_FILENAME);
+    remove(path);
+    worldcache_dict_clear();
+    sample_path(path, sizeof(path), 0);
+    if (worldcache_get_analysis_ex(path, &a, &info) != 0 || !info.cache_hit || !same_analysis(&a, &src)) {
+        fprintf(stderr, "pack entry with dictionary failed\n"); return 12;
+    }
+
+    world_analysis_data_free(&a);
+    world_analysis_data_free(&src);
+    worldcache_dict_clear();
+    cleanup();
+    printf("worldcache dict test passed\n");
+    return 0;
+}
@@ -18,5 +18,9 @@ int main(void) {
     printf("offset(sp_size) = %zu\n", offsetof(WorldCacheHeader_t, sp_size));
     printf("offset(ap_size) = %zu\n", offsetof(WorldCacheHeader_t, ap_size));
     printf("offset(voiced_mask_size) = %zu\n", offsetof(WorldCacheHeader_t, voiced_mask_size));
+    printf("offset(section_count) = %zu\n", offsetof(WorldCacheHeader_t, section_count));
+    printf("WorldCacheSection_t size: %zu bytes\n", sizeof(WorldCacheSection_t));
+    printf("first section at %llu (first layout header: %zu bytes)\n",
+           (unsigned long long)worldcache_sections_start(4), sizeof(WorldCacheHeaderV1_t));
     return 0;
 }
@@ -0,0 +1,185 @@
+#include "worldcache_lock.h"
+#include "worldcache_analysis.h"
+#include "worldcache_manager.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <process.h>
+#include <windows.h>
+#else
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* Concurrent cache creation: N processes load the same uncached WAV at
+ * once; exactly one analyzes it, the rest load what it wrote, and no
+ * temporary files are left behind. */
+
+static const char* kWav = "worldcache_lock_test.wav";
+static const char* kGo = "worldcache_lock_test.go";
+
+#define PROCESSES 8
+
+/* child exit codes */
+#define CHILD_ANALYZED 10
+#define CHILD_HIT 11
+#define CHILD_WAITED 12
+
+static void sleep_ms(int ms) {
+#if defined(_WIN32)
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts = { 0, ms * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static int file_exists(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f) fclose(f);
+    return f != NULL;
+}
+
+static void sidecar_path(char* out, size_t size) { snprintf(out, size, "%s.worldcache", kWav); }
+
+/* Wait for the parent's go, then load the WAV through the manager */
+static int run_child(void) {
+    for (int i = 0; i < 10000 && !file_exists(kGo); i++) sleep_ms(1);
+    WorldAnalysisData data;
+    world_analysis_data_init(&data);
+    WorldCacheLoadInfo info;
+    if (worldcache_get_analysis_ex(kWav, &data, &info) != 0 || data.f0_length <= 0) return 1;
+    world_analysis_data_free(&data);
+    if (!info.cache_hit) return CHILD_ANALYZED;
+    return info.waited ? CHILD_WAITED : CHILD_HIT;
+}
+
+/* Start the children; pids receive their process ids */
+static int spawn_children(const char* self, long* pids, intptr_t* handles) {
+    for (int i = 0; i < PROCESSES; i++) {
+#if defined(_WIN32)
+        const char* args[] = { self, "child", NULL };
+        handles[i] = _spawnv(_P_NOWAIT, self, args);
+        if (handles[i] == -1) return -1;
+        pids[i] = (long)GetProcessId((HANDLE)handles[i]);
+#else
+        (void)self;
+        pid_t pid = fork();
+        if (pid < 0) return -1;
+        if (pid == 0) _exit(run_child());
+        pids[i] = (long)pid;
+        handles[i] = (intptr_t)pid;
+#endif
+    }
+    return 0;
+}
+
+static int wait_child(intptr_t handle) {
+#if defined(_WIN32)
+    int status = -1;
+    if (_cwait(&status, handle, 0) == -1) return -1;
+    return status;
+#else
+    int status = 0;
+    if (waitpid((pid_t)handle, &status, 0) < 0 || !WIFEXITED(status)) return -1;
+    return WEXITSTATUS(status);
+#endif
+}
+
+static void cleanup(void) {
+    char sidecar[256];
+    sidecar_path(sidecar, sizeof(sidecar));
+    remove(sidecar);
+    remove(kGo);
+    remove(kWav);
+}
+
+/* Lock and temporary-name primitives within one process */
+static int check_primitives(void) {
+    char a[256], b[256];
+    if (worldcache_temp_path(kWav, a, sizeof(a)) != 0 || worldcache_temp_path(kWav, b, sizeof(b)) != 0 ||
+        strcmp(a, b) == 0 || strncmp(a, kWav, strlen(kWav)) != 0) {
+        fprintf(stderr, "temporary paths not unique: %s %s\n", a, b);
+        return 1;
+    }
+    if (worldcache_temp_path(kWav, a, 8) == 0) return 2;
+
+    WorldCacheLock held, other;
+    if (worldcache_lock_try(kWav, &held) != 0) return 3;
+    if (worldcache_lock_try(kWav, &other) != 1) {
+        fprintf(stderr, "second holder got the lock\n");
+        return 4;
+    }
+    worldcache_lock_release(&held);
+    if (worldcache_lock_try(kWav, &other) != 0) return 5;
+    worldcache_lock_release(&other);
+    if (worldcache_lock_try("worldcache_lock_test_missing.wav", &other) != -1) return 6;
+
+    /* a failed replacement leaves the target alone */
+    char sidecar[256];
+    sidecar_path(sidecar, sizeof(sidecar));
+    if (worldcache_replace_file("worldcache_lock_test_missing.tmp", sidecar) == 0) return 7;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "child") == 0) return run_child();
+
+    cleanup();
+    if (worldx_test_write_tone(kWav, 44100, 2.0, 180.0, 2) != 0) { perror("wav"); return 1; }
+    int result = check_primitives();
+    if (result != 0) { fprintf(stderr, "primitive check failed (%d)\n", result); return 2; }
+
+    long pids[PROCESSES];
+    intptr_t handles[PROCESSES];
+    if (spawn_children(argv[0], pids, handles) != 0) { perror("spawn"); return 3; }
+    sleep_ms(50);
+    FILE* go = fopen(kGo, "wb");
+    if (!go) { perror("go"); return 4; }
+    fclose(go);
+
+    int analyzed = 0, hits = 0, waited = 0, failed = 0;
+    for (int i = 0; i < PROCESSES; i++) {
+        int status = wait_child(handles[i]);
+        if (status == CHILD_ANALYZED) analyzed++;
+        else if (status == CHILD_HIT) hits++;
+        else if (status == CHILD_WAITED) waited++;
+        else failed++;
+    }
+    printf("%d processes: %d analyzed, %d waited for the cache, %d found it ready, %d failed\n", PROCESSES,
+           analyzed, waited, hits, failed);
+    if (failed || analyzed != 1) { fprintf(stderr, "expected exactly one analysis\n"); return 5; }
+
+    /* every writer renamed its temporary file away */
+    char sidecar[256], tmp[300];
+    sidecar_path(sidecar, sizeof(sidecar));
+    for (int i = 0; i < PROCESSES; i++) {
+        for (int serial = 1; serial <= 4; serial++) {
+            snprintf(tmp, sizeof(tmp), "%s.%lu-%d.tmp", sidecar, (unsigned long)pids[i], serial);
+            if (file_exists(tmp)) { fprintf(stderr, "leftover %s\n", tmp); return 6; }
+        }
+    }
+
+    /* the sidecar is complete and current */
+    WorldAnalysisData data;
+    world_analysis_data_init(&data);
+    WorldCacheLoadInfo info;
+    if (worldcache_get_analysis_ex(kWav, &data, &info) != 0 || !info.cache_hit || info.waited) {
+        fprintf(stderr, "sidecar not hit\n");
+        return 7;
+    }
+    double seconds = 0.0;
+    if (worldcache_ensure(kWav, &seconds) != 0 || seconds < 1.9) {
+        fprintf(stderr, "ensure rebuilt a current sidecar\n");
+        return 8;
+    }
+    world_analysis_data_free(&data);
+    cleanup();
+    printf("worldcache lock test passed\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "worldcache_lru.h"
+#include "worldx_thread.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* In-memory LRU: hits share one analysis, eviction respects the budget and
+ * held handles, changed WAVs reload, concurrent misses load once. */
+
+static const char* kWavs[2] = { "worldcache_lru_a.wav", "worldcache_lru_b.wav" };
+
+static void remove_files(void) {
+    char sidecar[256];
+    for (int i = 0; i < 2; i++) {
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWavs[i]);
+        remove(sidecar);
+        remove(kWavs[i]);
+    }
+}
+
+typedef struct {
+    WorldCacheLru* lru;
+    int failures;
+} Worker;
+
+static void worker_run(void* arg) {
+    Worker* w = (Worker*)arg;
+    for (int i = 0; i < 50; i++) {
+        WorldCacheHandle* h = NULL;
+        if (worldcache_lru_acquire(w->lru, kWavs[i & 1], &h) != 0 ||
+            worldcache_handle_data(h)->f0_length <= 0) {
+            w->failures++;
+        }
+        worldcache_lru_release(h);
+    }
+}
+
+int main(void) {
+    remove_files();
+    if (worldx_test_write_tone(kWavs[0], 16000, 0.25, 220.0, 2) != 0 ||
+        worldx_test_write_tone(kWavs[1], 16000, 0.25, 330.0, 2) != 0) {
+        perror("write wav"); return 1;
+    }
+
+    /* hits share the loaded analysis */
+    WorldCacheLru* lru = NULL;
+    if (worldcache_lru_create(64u << 20, &lru) != 0) return 2;
+    WorldCacheHandle *a1 = NULL, *a2 = NULL, *b = NULL;
+    if (worldcache_lru_acquire(lru, kWavs[0], &a1) != 0 || worldcache_lru_acquire(lru, kWavs[0], &a2) != 0 ||
+        worldcache_handle_data(a1) != worldcache_handle_data(a2)) {
+        fprintf(stderr, "second lookup not shared\n"); return 3;
+    }
+    WorldCacheLruStats st;
+    worldcache_lru_stats(lru, &st);
+    if (st.hits != 1 || st.misses != 1 || st.entries != 1 || st.bytes == 0 || st.handles != 2) {
+        fprintf(stderr, "bad counters after hit\n"); return 4;
+    }
+    worldcache_lru_release(a2);
+
+    /* over budget: held entries survive, released ones go */
+    size_t one_entry = st.bytes;
+    worldcache_lru_set_budget(lru, one_entry);
+    if (worldcache_lru_acquire(lru, kWavs[1], &b) != 0) { fprintf(stderr, "load b failed\n"); return 5; }
+    worldcache_lru_stats(lru, &st);
+    if (st.entries != 2 || st.evictions != 0) { fprintf(stderr, "held entry evicted\n"); return 6; }
+    const WorldAnalysisData* da = worldcache_handle_data(a1);
+    worldcache_lru_release(b);
+    worldcache_lru_stats(lru, &st);
+    if (st.entries != 1 || st.evictions != 1 || st.bytes > one_entry) {
+        fprintf(stderr, "released entry not evicted\n"); return 7;
+    }
+    if (da->f0_length <= 0 || !isfinite(da->f0[da->f0_length / 2])) {
+        fprintf(stderr, "held data freed\n"); return 8;
+    }
+
+    /* a changed WAV is reloaded; the old handle keeps its data */
+    if (worldx_test_write_tone(kWavs[0], 16000, 0.3, 250.0, 2) != 0) { perror("rewrite"); return 9; }
+    worldcache_lru_set_budget(lru, 64u << 20);
+    WorldCacheHandle* a3 = NULL;
+    if (worldcache_lru_acquire(lru, kWavs[0], &a3) != 0 || worldcache_handle_data(a3) == da ||
+        worldcache_handle_data(a3)->f0_length <= da->f0_length) {
+        fprintf(stderr, "changed WAV served from memory\n"); return 10;
+    }
+    worldcache_lru_release(a3);
+    worldcache_lru_release(a1);
+    worldcache_lru_destroy(lru);
+
+    /* concurrent lookups: each path loads once */
+    if (worldcache_lru_create(64u << 20, &lru) != 0) return 11;
+    enum { kThreads = 8 };
+    worldx_thread_t threads[kThreads];
+    Worker workers[kThreads];
+    for (int i = 0; i < kThreads; i++) {
+        workers[i].lru = lru;
+        workers[i].failures = 0;
+        if (worldx_thread_create(&threads[i], worker_run, &workers[i]) != 0) return 12;
+    }
+    int failures = 0;
+    for (int i = 0; i < kThreads; i++) {
+        worldx_thread_join(&threads[i]);
+        failures += workers[i].failures;
+    }
+    worldcache_lru_stats(lru, &st);
+    printf("threads: %llu hits, %llu misses\n", (unsigned long long)st.hits, (unsigned long long)st.misses);
+    if (failures || st.misses != 2 || st.hits + st.misses != kThreads * 50 || st.handles != 0) {
+        fprintf(stderr, "concurrent lookups inconsistent\n"); return 13;
+    }
+
+    /* handles outlive the cache */
+    if (worldcache_lru_acquire(lru, kWavs[1], &b) != 0) return 14;
+    worldcache_lru_destroy(lru);
+    if (worldcache_handle_data(b)->f0_length <= 0) { fprintf(stderr, "handle lost on destroy\n"); return 15; }
+    worldcache_lru_release(b);
+
+    remove_files();
+    printf("worldcache lru test passed\n");
+    return 0;
+}
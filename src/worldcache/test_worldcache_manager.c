@@ -1,18 +1,102 @@
 #include "worldcache_manager.h"
+#include "wav_io.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <time.h>
 #if defined(_WIN32)
 #  include <sys/utime.h>
+#  define utimbuf _utimbuf
+#  define utime _utime
 #  define TOUCH_FILE(path) _utime((path), NULL)
 #else
 #  include <utime.h>
 #  define TOUCH_FILE(path) utime((path), NULL)
 #endif
 
+/* Tone of n samples at 44.1 kHz written to path */
+static int write_tone(const char* path, int n, double f0) {
+    double* x = malloc(sizeof(double) * n);
+    if (!x) return -1;
+    for (int i = 0; i < n; i++) x[i] = 0.3 * sin(2.0 * 3.14159265358979323846 * f0 * i / 44100.0);
+    int result = wav_write_pcm16(path, x, n, 44100, 1);
+    free(x);
+    return result;
+}
+
+/* An analysis is only cached under the identity of the WAV it was read
+ * from: a WAV replaced between the read and the write is not stored */
+static int check_changed_source(void) {
+    const char* wav = "worldcache_manager_test.wav";
+    const char* cache = "worldcache_manager_test.wav.worldcache";
+    remove(cache);
+    if (write_tone(wav, 8820, 220.0) != 0) return 1;
+
+    WorldAnalysisData d;
+    world_analysis_data_init(&d);
+    WorldCacheHeader_t source, h;
+    int result = worldcache_analyze_source(wav, &d, &source) == 0 ? 0 : 2;
+    /* rewritten with other content after the read */
+    if (result == 0 && write_tone(wav, 13230, 330.0) != 0) result = 3;
+    struct stat st;
+    if (result == 0 && (worldcache_store_source(wav, &d, &source) == 0 || stat(cache, &st) == 0 ||
+                        worldcache_make_header(&h, wav, &d, &source) == 0)) {
+        result = 4;
+    }
+    /* rewritten with the same content: the hash still matches */
+    if (result == 0 && (write_tone(wav, 8820, 220.0) != 0 || worldcache_analyze_source(wav, &d, &source) != 0 ||
+                        write_tone(wav, 8820, 220.0) != 0 ||
+                        worldcache_store_source(wav, &d, &source) != 0 || stat(cache, &st) != 0)) {
+        result = 5;
+    }
+    world_analysis_data_free(&d);
+    remove(cache);
+    remove(wav);
+    return result;
+}
+
+/* A touched WAV is rehashed once: the hit stores the refreshed identity by
+ * replacing the sidecar, never by writing into the file that was checked */
+static int check_touched_source(void) {
+    const char* wav = "worldcache_manager_touch.wav";
+    const char* cache = "worldcache_manager_touch.wav.worldcache";
+    remove(cache);
+    if (write_tone(wav, 8820, 220.0) != 0) return 1;
+
+    WorldAnalysisData d;
+    world_analysis_data_init(&d);
+    WorldCacheLoadInfo info;
+    struct stat before, after;
+    int result = worldcache_get_analysis_ex(wav, &d, &info) == 0 && stat(cache, &before) == 0 ? 0 : 2;
+    world_analysis_data_free(&d);
+
+    struct utimbuf t;
+    t.actime = time(NULL);
+    t.modtime = time(NULL) - 100;
+    if (result == 0 && utime(wav, &t) != 0) result = 3;
+    if (result == 0 && (worldcache_get_analysis_ex(wav, &d, &info) != 0 || !info.cache_hit)) result = 4;
+    world_analysis_data_free(&d);
+
+    FILE* f = result == 0 ? fopen(cache, "rb") : NULL;
+    WorldCacheHeader_t h;
+    if (result == 0 && (!f || worldcache_header_read(f, &h) != 0 ||
+                        worldcache_source_check(&h, wav) != WORLDCACHE_SOURCE_CURRENT)) {
+        result = 5;
+    }
+    if (f) fclose(f);
+#if !defined(_WIN32)
+    if (result == 0 && (stat(cache, &after) != 0 || after.st_ino == before.st_ino)) result = 6;
+#endif
+    remove(cache);
+    remove(wav);
+    return result;
+}
+
 int main(int argc, char** argv) {
     const char* wav = "third_party/ucra/test_input.wav"; /* use existing test WAV in third_party */
-    WORLD_AnalysisData d;
+    WorldAnalysisData d;
+    world_analysis_data_init(&d);
     int res = worldcache_get_analysis(wav, &d);
     if (res != 0) { fprintf(stderr, "analysis failed\n"); return 1; }
     /* check cache file exists */
@@ -26,7 +110,8 @@ int main(int argc, char** argv) {
     worldcache_free_analysis(&d);
 
     /* WAV 파일을 변경하지 않고 다시 호출하여 캐시 히트 경로가 동작하는지 검증 */
-    WORLD_AnalysisData d_hit;
+    WorldAnalysisData d_hit;
+    world_analysis_data_init(&d_hit);
     int res_hit = worldcache_get_analysis(wav, &d_hit);
     if (res_hit != 0) { fprintf(stderr, "cache-hit analysis failed\n"); return 3; }
     worldcache_free_analysis(&d_hit);
@@ -37,11 +122,17 @@ int main(int argc, char** argv) {
     /* 무효화 헬퍼를 명시적으로 호출 (0: 제거됨, 1: 아직 유효) */
     int inv = worldcache_invalidate_if_changed(wav);
     /* inv 값과 무관하게 다시 분석을 요청하여 복구/재생성을 확인 */
-    WORLD_AnalysisData d2;
+    WorldAnalysisData d2;
+    world_analysis_data_init(&d2);
     int res2 = worldcache_get_analysis(wav, &d2);
     if (res2 != 0) { fprintf(stderr, "analysis after touch failed\n"); return 4; }
     worldcache_free_analysis(&d2);
 
+    int step = check_changed_source();
+    if (step != 0) { fprintf(stderr, "changed source check failed (%d)\n", step); return 5; }
+    step = check_touched_source();
+    if (step != 0) { fprintf(stderr, "touched source check failed (%d)\n", step); return 6; }
+
     printf("worldcache manager test passed\n");
     return 0;
 }
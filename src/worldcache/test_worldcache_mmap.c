@@ -0,0 +1,96 @@
+#include "worldcache_analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Mapped loads: rows point into the mapping, the mapping lives as long as
+ * any analysis using it, and in-place edits never reach the file. */
+
+static const char* kCache = "worldcache_mmap_test.worldcache";
+
+static int write_cache(const WorldAnalysisData* data) {
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_header_from_analysis(&h, data) != 0) return -1;
+    FILE* f = fopen(kCache, "wb");
+    if (!f) return -1;
+    int result = worldcache_write_analysis(f, &h, data);
+    return fclose(f) == 0 ? result : -1;
+}
+
+static int read_cache(WorldAnalysisData* data) {
+    FILE* f = fopen(kCache, "rb");
+    if (!f) return -1;
+    WorldCacheHeader_t h;
+    int result = worldcache_header_read(f, &h) == 0 ? worldcache_read_analysis(f, &h, data, NULL) : -1;
+    fclose(f);
+    return result;
+}
+
+int main(void) {
+    WorldAnalysisData src;
+    world_analysis_data_init(&src);
+    if (world_generate_dummy_data(&src, 0.3, 44100, 5.0, 200.0) != 0 || write_cache(&src) != 0) {
+        fprintf(stderr, "cache setup failed\n"); return 1;
+    }
+    int bins = src.fft_size / 2 + 1;
+    size_t row = sizeof(double) * (size_t)bins;
+
+    WorldCacheMapping* m = NULL;
+    if (worldcache_mapping_open(kCache, &m) != 0) { fprintf(stderr, "map failed\n"); return 2; }
+    const uint8_t* begin = worldcache_mapping_data(m);
+    const uint8_t* end = begin + worldcache_mapping_size(m);
+
+    WorldAnalysisData a, b;
+    world_analysis_data_init(&a);
+    world_analysis_data_init(&b);
+    WorldCacheLoadInfo info;
+    if (worldcache_attach_analysis(m, &a, &info) != 0 || worldcache_attach_analysis(m, &b, NULL) != 0) {
+        fprintf(stderr, "attach failed\n"); return 3;
+    }
+    /* only the analyses keep the mapping alive from here on */
+    worldcache_mapping_release(m);
+
+    const uint8_t* sp0 = (const uint8_t*)a.spectrogram[0];
+    const uint8_t* f0 = (const uint8_t*)a.f0;
+    if (sp0 < begin || sp0 >= end || f0 < begin || f0 >= end || info.bytes_mapped == 0 ||
+        info.bytes_read != 0 || info.bytes_copied != 0) {
+        fprintf(stderr, "rows do not point into the mapping\n"); return 4;
+    }
+    if ((uintptr_t)sp0 % sizeof(double) != 0) { fprintf(stderr, "misaligned rows\n"); return 5; }
+    for (int i = 0; i < src.f0_length; i++) {
+        if (a.f0[i] != src.f0[i] || memcmp(a.spectrogram[i], src.spectrogram[i], row) != 0 ||
+            memcmp(a.aperiodicity[i], src.aperiodicity[i], row) != 0) {
+            fprintf(stderr, "mapped frame %d differs\n", i); return 6;
+        }
+    }
+
+    /* b outlives a's reference */
+    world_analysis_data_free(&a);
+    double y = b.spectrogram[b.f0_length - 1][bins - 1];
+    if (y != src.spectrogram[src.f0_length - 1][bins - 1]) {
+        fprintf(stderr, "mapping released too early\n"); return 7;
+    }
+
+    /* in-place edits are private to the process */
+    b.spectrogram[0][0] = -1.0;
+    b.f0[0] = -1.0;
+    WorldAnalysisData c;
+    world_analysis_data_init(&c);
+    if (read_cache(&c) != 0 || c.spectrogram[0][0] != src.spectrogram[0][0] || c.f0[0] != src.f0[0]) {
+        fprintf(stderr, "in-place edit reached the file\n"); return 8;
+    }
+
+    /* converting borrowed rows yields owned ones; the borrowed f0 stays valid */
+    if (world_analysis_data_convert(&b, WORLD_PRECISION_FLOAT32) != 0 || b.borrowed_matrices ||
+        b.f0[1] != src.f0[1]) {
+        fprintf(stderr, "convert of mapped data failed\n"); return 9;
+    }
+
+    world_analysis_data_free(&b);
+    world_analysis_data_free(&c);
+    world_analysis_data_free(&src);
+    remove(kCache);
+    printf("worldcache mmap test passed\n");
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "worldcache_pack.h"
+#include "worldcache_manager.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#  include <direct.h>
+#  define MKDIR(path) _mkdir(path)
+#  define RMDIR(path) _rmdir(path)
+#else
+#  include <unistd.h>
+#  define MKDIR(path) mkdir((path), 0755)
+#  define RMDIR(path) rmdir(path)
+#endif
+
+/* .worldpack: build, O(1) lookups through the manager, staleness, update */
+
+static const char* kDir = "worldpack_test_vb";
+static const char* kSubDir = "worldpack_test_vb/sub";
+static const char* kWavA = "worldpack_test_vb/a.wav";
+static const char* kWavB = "worldpack_test_vb/sub/b.wav";
+static const char* kPack = "worldpack_test_vb/" WORLDPACK_FILENAME;
+
+static int file_exists(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static void cleanup(void) {
+    char sidecar[256];
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWavA);
+    remove(sidecar);
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWavB);
+    remove(sidecar);
+    remove(kPack);
+    remove(kWavA);
+    remove(kWavB);
+    RMDIR(kSubDir);
+    RMDIR(kDir);
+}
+
+int main(void) {
+    cleanup();
+    MKDIR(kDir);
+    MKDIR(kSubDir);
+    if (worldx_test_write_tone(kWavA, 22050, 0.25, 220.0, 2) != 0 ||
+        worldx_test_write_tone(kWavB, 22050, 0.25, 330.0, 2) != 0) {
+        perror("write wav"); return 1;
+    }
+
+    /* no pack yet: the miss is remembered until a build */
+    WorldPack* pack = NULL;
+    char key[256];
+    if (worldpack_locate(kWavB, &pack, key, sizeof(key)) == 0) { fprintf(stderr, "phantom pack\n"); return 16; }
+
+    WorldPackReport report;
+    if (worldpack_build(kDir, 0, &report) != 0 || report.entries != 2 || report.analyzed != 2) {
+        fprintf(stderr, "build failed\n"); return 2;
+    }
+
+    /* keys are relative, '/' separated; images are 4 KB aligned */
+    if (worldpack_open(kPack, &pack) != 0) { fprintf(stderr, "open failed\n"); return 3; }
+    const WorldPackEntry_t* a = worldpack_find(pack, "a.wav");
+    const WorldPackEntry_t* b = worldpack_find(pack, "sub/b.wav");
+    if (!a || !b || worldpack_find(pack, "b.wav") || a->offset % WORLDPACK_ALIGN != 0 ||
+        b->offset % WORLDPACK_ALIGN != 0) {
+        fprintf(stderr, "bad table of contents\n"); return 4;
+    }
+    worldpack_close(pack);
+
+    if (worldpack_locate(kWavB, &pack, key, sizeof(key)) != 0 || strcmp(key, "sub/b.wav") != 0) {
+        fprintf(stderr, "locate failed\n"); return 5;
+    }
+    /* the located pack stays open for the next lookup in the directory */
+    WorldPack* again = NULL;
+    if (worldpack_locate(kWavB, &again, key, sizeof(key)) != 0 || again != pack) {
+        fprintf(stderr, "located pack not reused\n"); return 17;
+    }
+    worldpack_close(again);
+#if defined(_WIN32)
+    worldpack_close(pack);
+#endif
+
+    /* manager lookups are served from the pack, without sidecars */
+    WorldAnalysisData packed, fresh;
+    world_analysis_data_init(&packed);
+    world_analysis_data_init(&fresh);
+    WorldCacheLoadInfo info;
+    if (worldcache_get_analysis_ex(kWavB, &packed, &info) != 0 || !info.cache_hit ||
+        info.bytes_copied != 0) {
+        fprintf(stderr, "pack lookup missed\n"); return 6;
+    }
+    char sidecar[256];
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", kWavB);
+    if (file_exists(sidecar)) { fprintf(stderr, "pack hit wrote a sidecar\n"); return 7; }
+    if (worldcache_analyze(kWavB, &fresh) != 0 || fresh.f0_length != packed.f0_length ||
+        memcmp(fresh.f0, packed.f0, sizeof(double) * (size_t)fresh.f0_length) != 0) {
+        fprintf(stderr, "packed analysis differs\n"); return 8;
+    }
+    worldcache_free_analysis(&fresh);
+
+    if (worldpack_verify(kDir, &report) != 0 || report.samples != 2) {
+        fprintf(stderr, "fresh pack not current\n"); return 9;
+    }
+
+    /* change a sample (longer, so the update moves the entries after it):
+     * verify flags it, the manager falls back to analysis */
+    if (worldx_test_write_tone(kWavA, 22050, 0.5, 240.0, 2) != 0) { perror("rewrite"); return 10; }
+    if (worldpack_verify(kDir, &report) != 1 || report.stale != 1) {
+        fprintf(stderr, "stale entry not reported\n"); return 11;
+    }
+    if (worldcache_get_analysis_ex(kWavA, &fresh, &info) != 0 || info.cache_hit) {
+        fprintf(stderr, "stale entry served\n"); return 12;
+    }
+    worldcache_free_analysis(&fresh);
+
+    /* update reuses b and the new sidecar of a. POSIX replaces the pack while
+     * `packed` still maps it; Windows cannot replace a mapped file. */
+#if defined(_WIN32)
+    worldcache_free_analysis(&packed);
+#endif
+    if (worldpack_build(kDir, 1, &report) != 0 || report.entries != 2 || report.reused != 2 ||
+        report.analyzed != 0) {
+        fprintf(stderr, "update did not reuse entries\n"); return 13;
+    }
+    if (worldpack_verify(kDir, &report) != 0) { fprintf(stderr, "updated pack not current\n"); return 14; }
+#if !defined(_WIN32)
+    /* the replaced pack is not served from the cache */
+    if (worldpack_locate(kWavB, &again, key, sizeof(key)) != 0 || again == pack ||
+        !worldpack_find(again, "a.wav")) {
+        fprintf(stderr, "replaced pack still located\n"); return 18;
+    }
+    worldpack_close(again);
+    /* entries of the replaced pack still load from its mapping, whatever
+     * the rebuilt file holds at their offsets */
+    WorldAnalysisData old;
+    world_analysis_data_init(&old);
+    if (worldpack_load(pack, worldpack_find(pack, "sub/b.wav"), &old, NULL) != 0 ||
+        old.f0_length != packed.f0_length ||
+        memcmp(old.f0, packed.f0, sizeof(double) * (size_t)old.f0_length) != 0) {
+        fprintf(stderr, "replaced pack entry not loaded from its mapping\n"); return 19;
+    }
+    worldcache_free_analysis(&old);
+    worldpack_close(pack);
+    if (packed.f0_length <= 0 || !isfinite(packed.f0[packed.f0_length / 2])) {
+        fprintf(stderr, "old mapping invalidated\n"); return 15;
+    }
+    worldcache_free_analysis(&packed);
+#endif
+
+    cleanup();
+    printf("worldcache pack test passed\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "worldcache_precache.h"
+#include "worldcache_voicebank.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#  include <direct.h>
+#  define MKDIR(path) _mkdir(path)
+#  define RMDIR(path) _rmdir(path)
+#else
+#  include <unistd.h>
+#  define MKDIR(path) mkdir((path), 0755)
+#  define RMDIR(path) rmdir(path)
+#endif
+
+/* Precache: samples come from oto.ini, caches are written on the pool, and
+ * reruns only analyze what changed */
+
+static const char* kDir = "worldcache_precache_vb";
+static const char* kSubDir = "worldcache_precache_vb/sub";
+static const char* kOto = "worldcache_precache_vb/oto.ini";
+static const char* kSubOto = "worldcache_precache_vb/sub/oto.ini";
+static const char* kWavA = "worldcache_precache_vb/a.wav";
+static const char* kWavB = "worldcache_precache_vb/sub/b.wav";
+static const char* kWavExtra = "worldcache_precache_vb/extra.wav";
+
+static int write_text(const char* path, const char* text) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    fputs(text, f);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static int has_sidecar(const char* wav) {
+    char sidecar[256];
+    struct stat st;
+    snprintf(sidecar, sizeof(sidecar), "%s.worldcache", wav);
+    return stat(sidecar, &st) == 0;
+}
+
+static void cleanup(void) {
+    const char* files[] = { kWavA, kWavB, kWavExtra };
+    char sidecar[256];
+    for (int i = 0; i < 3; i++) {
+        snprintf(sidecar, sizeof(sidecar), "%s.worldcache", files[i]);
+        remove(sidecar);
+        remove(files[i]);
+    }
+    remove(kOto);
+    remove(kSubOto);
+    RMDIR(kSubDir);
+    RMDIR(kDir);
+}
+
+typedef struct {
+    int calls;
+    int last_done;
+    int ordered;
+} Progress;
+
+static void on_progress(const WorldCachePrecacheReport* r, void* user) {
+    Progress* p = (Progress*)user;
+    p->calls++;
+    if (r->done != p->last_done + 1) p->ordered = 0;
+    p->last_done = r->done;
+}
+
+int main(void) {
+    cleanup();
+    MKDIR(kDir);
+    MKDIR(kSubDir);
+    /* BOM, CRLF, repeated sample, a missing one, a Windows separator; extra.wav is not in any oto.ini */
+    if (write_text(kOto, "\xEF\xBB\xBF" "a.wav=a,10,50,-200,30,10\r\n"
+                         "a.wav=- a,10,50,-200,30,10\r\n"
+                         "missing.wav=x,0,0,0,0,0\r\n"
+                         "\r\n") != 0 ||
+        write_text(kSubOto, "b.wav=b,0,60,-150,40,15\n") != 0 ||
+        worldx_test_write_tone(kWavA, 22050, 0.3, 220.0, 2) != 0 ||
+        worldx_test_write_tone(kWavB, 22050, 0.2, 330.0, 2) != 0 ||
+        worldx_test_write_tone(kWavExtra, 22050, 0.2, 440.0, 2) != 0) {
+        perror("setup"); return 1;
+    }
+
+    WorldCachePathList samples;
+    int otos = 0;
+    if (worldcache_voicebank_samples(kDir, &samples, &otos) != 0 || otos != 2 || samples.count != 3 ||
+        strcmp(samples.items[0], "a.wav") != 0 || strcmp(samples.items[1], "missing.wav") != 0 ||
+        strcmp(samples.items[2], "sub/b.wav") != 0) {
+        fprintf(stderr, "oto.ini samples wrong\n"); return 2;
+    }
+    worldcache_path_list_free(&samples);
+
+    /* first run analyzes every sample oto.ini names */
+    WorldCachePrecacheReport r;
+    Progress progress = { 0, 0, 1 };
+    if (worldcache_precache(kDir, 4, on_progress, &progress, &r) != 0) {
+        fprintf(stderr, "precache failed\n"); return 3;
+    }
+    printf("first run: %d analyzed, %d current, %d missing on %d threads, %.2f audio s\n", r.analyzed,
+           r.current, r.missing, r.threads, r.audio_seconds);
+    if (r.samples != 3 || r.oto_files != 2 || r.analyzed != 2 || r.current != 0 || r.missing != 1 ||
+        r.failed != 0 || r.done != 3 || r.threads != 3 || r.audio_seconds < 0.4 || r.elapsed <= 0.0) {
+        fprintf(stderr, "bad first report\n"); return 4;
+    }
+    if (progress.calls != 3 || !progress.ordered) { fprintf(stderr, "bad progress calls\n"); return 5; }
+    if (!has_sidecar(kWavA) || !has_sidecar(kWavB) || has_sidecar(kWavExtra)) {
+        fprintf(stderr, "wrong sidecars written\n"); return 6;
+    }
+
+    /* rerun is incremental */
+    if (worldcache_precache(kDir, 0, NULL, NULL, &r) != 0 || r.analyzed != 0 || r.current != 2 ||
+        r.audio_seconds != 0.0) {
+        fprintf(stderr, "rerun analyzed again\n"); return 7;
+    }
+
+    /* only the changed sample is analyzed */
+    if (worldx_test_write_tone(kWavB, 22050, 0.4, 330.0, 2) != 0) { perror("rewrite"); return 8; }
+    if (worldcache_precache(kDir, 2, NULL, NULL, &r) != 0 || r.analyzed != 1 || r.current != 1) {
+        fprintf(stderr, "changed sample not reanalyzed\n"); return 9;
+    }
+
+    if (worldcache_precache("worldcache_precache_no_such_dir", 2, NULL, NULL, &r) != -1) {
+        fprintf(stderr, "missing directory accepted\n"); return 10;
+    }
+
+    cleanup();
+    printf("worldcache precache test passed\n");
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include "worldcache_analysis.h"
+#include "worldcache_mmap.h"
+#include "worldcache_serialize.h"
+#include "worldx_test_wav.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Section table layout: every section aligned, checksums that catch a
+ * flipped byte, F0 and temporal positions stored in their own sections,
+ * and first-layout ('WCH1') files still read, mapped and refreshed in
+ * their own layout. */
+
+static const char* kCache = "worldcache_sections_test.worldcache";
+
+static int write_cache(const WorldAnalysisData* data, int compressed) {
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_header_from_analysis(&h, data) != 0) return -1;
+    if (compressed) h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+    FILE* f = fopen(kCache, "wb");
+    if (!f) return -1;
+    int result = worldcache_write_analysis(f, &h, data);
+    return fclose(f) == 0 ? result : -1;
+}
+
+static int write_file(const char* path, const void* a, size_t a_size, const void* b, size_t b_size) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = fwrite(a, 1, a_size, f) == a_size && (!b_size || fwrite(b, 1, b_size, f) == b_size);
+    return fclose(f) == 0 && ok ? 0 : -1;
+}
+
+/* Every frame of a against src */
+static int same_analysis(const WorldAnalysisData* a, const WorldAnalysisData* src) {
+    if (a->f0_length != src->f0_length) return 0;
+    size_t bins = (size_t)(src->fft_size / 2 + 1);
+    for (int i = 0; i < src->f0_length; i++) {
+        if (a->f0[i] != src->f0[i] || a->temporal_positions[i] != src->temporal_positions[i] ||
+            memcmp(a->spectrogram[i], src->spectrogram[i], bins * sizeof(double)) != 0 ||
+            memcmp(a->aperiodicity[i], src->aperiodicity[i], bins * sizeof(double)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* The image at kCache has the expected sections, aligned, with checksums
+ * that match and that a flipped byte breaks */
+static int check_image(const WorldAnalysisData* src, int compressed) {
+    size_t size = 0;
+    uint8_t* image = worldx_test_read_file(kCache, &size);
+    WorldCacheHeader_t h;
+    WorldCacheSection_t s[WORLDCACHE_MAX_SECTIONS];
+    uint32_t count = 0;
+    if (!image || worldcache_header_parse(image, size, &h) != 0 || h.magic != WORLDCACHE_MAGIC ||
+        h.format_version != WORLDCACHE_FORMAT_VERSION ||
+        worldcache_image_sections(image, size, &h, s, &count) != 0) {
+        free(image);
+        return 1;
+    }
+    const uint32_t plain[] = { WORLDCACHE_SECTION_SP, WORLDCACHE_SECTION_AP, WORLDCACHE_SECTION_F0,
+                               WORLDCACHE_SECTION_TIME };
+    const uint32_t packed[] = { WORLDCACHE_SECTION_CHUNKS, WORLDCACHE_SECTION_F0, WORLDCACHE_SECTION_TIME };
+    const uint32_t* types = compressed ? packed : plain;
+    uint32_t expected = compressed ? 3 : 4;
+    int result = count == expected ? 0 : 2;
+    for (uint32_t i = 0; result == 0 && i < count; i++) {
+        if (s[i].type != types[i] || s[i].offset % WORLDCACHE_SECTION_ALIGN != 0) result = 3;
+    }
+    const WorldCacheSection_t* f0 = worldcache_sections_find(s, count, WORLDCACHE_SECTION_F0);
+    const WorldCacheSection_t* time = worldcache_sections_find(s, count, WORLDCACHE_SECTION_TIME);
+    size_t frames_bytes = (size_t)src->f0_length * sizeof(double);
+    if (result == 0 && (!f0 || !time || f0->size != frames_bytes || time->size != frames_bytes ||
+                        memcmp(image + f0->offset, src->f0, frames_bytes) != 0 ||
+                        memcmp(image + time->offset, src->temporal_positions, frames_bytes) != 0)) {
+        result = 4;
+    }
+    if (result == 0 && worldcache_image_verify(image, size) != 0) result = 5;
+    /* a flipped byte in the first section is caught */
+    if (result == 0) {
+        image[s[0].offset + s[0].size / 2] ^= 0x10;
+        if (worldcache_image_verify(image, size) == 0) result = 6;
+    }
+    /* a section pointing past the end is rejected */
+    size_t truncated = (size_t)(time->offset + time->size - 1);
+    if (result == 0 && worldcache_image_sections(image, truncated, &h, s, &count) == 0) result = 7;
+    free(image);
+    return result;
+}
+
+/* First-layout header of src's payload, as version 2 files stored it */
+static WorldCacheHeaderV1_t v1_header(const WorldAnalysisData* src, uint16_t flags) {
+    WorldCacheHeaderV1_t v1;
+    memset(&v1, 0, sizeof(v1));
+    v1.magic = WORLDCACHE_MAGIC_V1;
+    v1.format_version = WORLDCACHE_FORMAT_VERSION_V1;
+    v1.flags = (uint16_t)(flags | WORLDCACHE_FLAG_F0_CONTOUR);
+    v1.sample_rate = src->sample_rate;
+    v1.frame_period_ms = src->frame_period;
+    v1.num_frames = (uint32_t)src->f0_length;
+    v1.fft_size = (uint32_t)src->fft_size;
+    v1.sp_size = (uint32_t)(src->f0_length * (src->fft_size / 2 + 1) * sizeof(double));
+    v1.ap_size = v1.sp_size;
+    v1.voiced_mask_size = (uint32_t)(src->f0_length * sizeof(double));
+    v1.wav_size = 1234;
+    return v1;
+}
+
+/* Read kCache back in full and over a range, mapped if possible */
+static int check_loads(const WorldAnalysisData* src, int mappable) {
+    WorldAnalysisData a;
+    world_analysis_data_init(&a);
+    int result = 0;
+    if (worldcache_read_frames(kCache, 0, src->f0_length, &a, NULL) != 0 || !same_analysis(&a, src)) result = 1;
+    if (result == 0 && (worldcache_read_frames(kCache, 40, 30, &a, NULL) != 0 || a.f0_length != 30 ||
+                        a.f0[5] != src->f0[45] || a.temporal_positions[5] != src->temporal_positions[45])) {
+        result = 2;
+    }
+    world_analysis_data_free(&a);
+    WorldCacheMapping* m = NULL;
+    if (result == 0 && mappable && worldcache_mapping_open(kCache, &m) == 0) {
+        WorldCacheLoadInfo info;
+        if (worldcache_attach_analysis(m, &a, &info) != 0 || !same_analysis(&a, src) || info.bytes_mapped == 0) {
+            result = 3;
+        }
+        world_analysis_data_free(&a);
+        worldcache_mapping_release(m);
+    }
+    return result;
+}
+
+static int check_v1(const WorldAnalysisData* src) {
+    /* uncompressed and padded: header, zeros up to the payload, sp, ap, F0 */
+    WorldCacheHeaderV1_t v1 = v1_header(src, WORLDCACHE_FLAG_PADDED);
+    size_t bins = (size_t)(src->fft_size / 2 + 1), frames = (size_t)src->f0_length;
+    size_t payload = v1.sp_size + v1.ap_size + v1.voiced_mask_size;
+    size_t offset = (sizeof(v1) + WORLDCACHE_PAYLOAD_ALIGN - 1) / WORLDCACHE_PAYLOAD_ALIGN *
+                    WORLDCACHE_PAYLOAD_ALIGN;
+    uint8_t* image = (uint8_t*)calloc(1, offset + payload);
+    if (!image) return 1;
+    memcpy(image, &v1, sizeof(v1));
+    uint8_t* p = image + offset;
+    size_t row = bins * sizeof(double);
+    for (size_t i = 0; i < frames; i++, p += row) memcpy(p, src->spectrogram[i], row);
+    for (size_t i = 0; i < frames; i++, p += row) memcpy(p, src->aperiodicity[i], row);
+    memcpy(p, src->f0, frames * sizeof(double));
+    int result = write_file(kCache, image, offset + payload, NULL, 0) == 0 ? 0 : 2;
+    if (result == 0 && check_loads(src, 1) != 0) result = 3;
+
+    /* a refreshed header keeps the first layout and its size */
+    WorldCacheHeader_t h;
+    uint8_t stored[sizeof(WorldCacheHeader_t)];
+    if (result == 0 &&
+        (worldcache_header_parse(image, offset + payload, &h) != 0 || !worldcache_header_is_v1(&h) ||
+         worldcache_header_disk_size(&h) != sizeof(v1) || h.sp_size != v1.sp_size ||
+         worldcache_image_verify(image, offset + payload) != 0)) {
+        result = 4;
+    }
+    if (result == 0) {
+        h.wav_hash = 42;
+        v1.wav_hash = 42;
+        if (worldcache_header_store(&h, stored) != 0 || memcmp(stored, &v1, sizeof(v1)) != 0) result = 5;
+    }
+
+    /* compressed: chunk index right after the header, F0 inside the chunks */
+    if (result == 0) {
+        h.flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+        v1.flags = h.flags;
+        uint8_t* chunks = NULL;
+        size_t chunks_size = 0;
+        p = image + offset;
+        if (worldcache_compress_chunks(&h, p, p + v1.sp_size, p + v1.sp_size + v1.ap_size,
+                                       WORLDCACHE_CHUNK_FRAMES, NULL, &chunks, &chunks_size) != 0) {
+            printf("first-layout compressed caches skipped (built without zstd)\n");
+        } else if (write_file(kCache, &v1, sizeof(v1), chunks, chunks_size) != 0 || check_loads(src, 0) != 0) {
+            result = 6;
+        }
+        free(chunks);
+    }
+    free(image);
+    return result;
+}
+
+/* A float32 analysis is stored as float32: SP and AP sections of
+ * bins * sizeof(float) bytes per frame, read back bit for bit */
+static int check_float32(const WorldAnalysisData* src) {
+    WorldAnalysisData f32, a;
+    world_analysis_data_init(&f32);
+    world_analysis_data_init(&a);
+    f32.precision = WORLD_PRECISION_FLOAT32;
+    size_t bins = (size_t)(src->fft_size / 2 + 1), frames = (size_t)src->f0_length;
+    size_t frame_bytes = bins * sizeof(float);
+    int result = 0;
+    if (world_generate_dummy_data(&f32, 1.0, 44100, 5.0, 200.0) != 0 ||
+        f32.precision != WORLD_PRECISION_FLOAT32 || write_cache(&f32, 0) != 0) {
+        result = 1;
+    }
+
+    size_t size = 0;
+    uint8_t* image = result == 0 ? worldx_test_read_file(kCache, &size) : NULL;
+    WorldCacheHeader_t h;
+    WorldCacheSection_t s[WORLDCACHE_MAX_SECTIONS];
+    uint32_t count = 0;
+    if (result == 0 && (!image || worldcache_header_parse(image, size, &h) != 0 ||
+                        worldcache_image_sections(image, size, &h, s, &count) != 0)) {
+        result = 2;
+    }
+    const WorldCacheSection_t* sp = result == 0 ? worldcache_sections_find(s, count, WORLDCACHE_SECTION_SP) : NULL;
+    const WorldCacheSection_t* ap = result == 0 ? worldcache_sections_find(s, count, WORLDCACHE_SECTION_AP) : NULL;
+    if (result == 0 && (!(h.flags & WORLDCACHE_FLAG_FLOAT32) || !sp || !ap ||
+                        h.sp_size / frames != frame_bytes || h.ap_size / frames != frame_bytes ||
+                        sp->size != frames * frame_bytes || ap->size != frames * frame_bytes ||
+                        memcmp(image + sp->offset, f32.spectrogram_f32[0], frame_bytes) != 0)) {
+        result = 3;
+    }
+    free(image);
+
+    if (result == 0 && (worldcache_read_frames(kCache, 0, f32.f0_length, &a, NULL) != 0 ||
+                        a.precision != WORLD_PRECISION_FLOAT32 || a.f0_length != f32.f0_length)) {
+        result = 4;
+    }
+    for (int i = 0; result == 0 && i < a.f0_length; i++) {
+        if (memcmp(a.spectrogram_f32[i], f32.spectrogram_f32[i], frame_bytes) != 0 ||
+            memcmp(a.aperiodicity_f32[i], f32.aperiodicity_f32[i], frame_bytes) != 0) {
+            result = 5;
+        }
+    }
+    if (result == 0) {
+        printf("sp bytes per frame: double %zu, float32 %zu\n", bins * sizeof(double), frame_bytes);
+    }
+    world_analysis_data_free(&a);
+    world_analysis_data_free(&f32);
+    return result;
+}
+
+int main(void) {
+    WorldAnalysisData src;
+    world_analysis_data_init(&src);
+    if (world_generate_dummy_data(&src, 1.0, 44100, 5.0, 200.0) != 0) {
+        fprintf(stderr, "dummy data failed\n"); return 1;
+    }
+
+    for (int compressed = 0; compressed < 2; compressed++) {
+        const char* label = compressed ? "compressed" : "plain";
+        if (write_cache(&src, compressed) != 0) {
+            if (!compressed) { fprintf(stderr, "write failed\n"); return 2; }
+            printf("compressed caches skipped (built without zstd)\n");
+            continue;
+        }
+        int step = check_loads(&src, !compressed);
+        if (step != 0) { fprintf(stderr, "%s: load check failed (%d)\n", label, step); return 3; }
+        /* the image check corrupts the file's copy in memory only */
+        step = check_image(&src, compressed);
+        if (step != 0) { fprintf(stderr, "%s: image check failed (%d)\n", label, step); return 4; }
+    }
+    int step = check_v1(&src);
+    if (step != 0) { fprintf(stderr, "first-layout check failed (%d)\n", step); return 5; }
+    step = check_float32(&src);
+    if (step != 0) { fprintf(stderr, "float32 payload check failed (%d)\n", step); return 6; }
+
+    world_analysis_data_free(&src);
+    remove(kCache);
+    printf("worldcache sections test passed\n");
+    return 0;
+}
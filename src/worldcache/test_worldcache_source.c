@@ -0,0 +1,97 @@
+#include "worldcache_source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(_WIN32)
+#  include <sys/utime.h>
+#  define utimbuf _utimbuf
+#  define utime _utime
+#else
+#  include <utime.h>
+#endif
+
+/* Tiered source validation: stat-only hits, rehash on identity changes,
+ * stale on content changes. */
+
+static const char* kWav = "worldcache_source_test.bin";
+
+static int write_bytes(const char* path, unsigned char seed, size_t n) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    for (size_t i = 0; i < n; i++) fputc((unsigned char)(seed + i * 31), f);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/* Move the file's mtime back by `delta` seconds without touching the content */
+static int shift_mtime(const char* path, long delta) {
+    struct utimbuf t;
+    t.actime = time(NULL);
+    t.modtime = time(NULL) - delta;
+    return utime(path, &t);
+}
+
+int main(void) {
+    /* chunked hashing agrees with one-shot hashing at every split */
+    unsigned char buf[200];
+    for (int i = 0; i < 200; i++) buf[i] = (unsigned char)(i * 7 + 3);
+    WorldCacheHash s;
+    worldcache_hash_init(&s);
+    worldcache_hash_update(&s, buf, sizeof(buf));
+    uint64_t whole = worldcache_hash_final(&s);
+    for (size_t split = 0; split <= sizeof(buf); split += 13) {
+        worldcache_hash_init(&s);
+        worldcache_hash_update(&s, buf, split);
+        worldcache_hash_update(&s, buf + split, sizeof(buf) - split);
+        if (worldcache_hash_final(&s) != whole) {
+            fprintf(stderr, "hash differs at split %zu\n", split); return 1;
+        }
+    }
+    worldcache_hash_init(&s);
+    worldcache_hash_update(&s, buf, sizeof(buf) - 1);
+    if (worldcache_hash_final(&s) == whole) { fprintf(stderr, "hash ignores length\n"); return 2; }
+
+    /* a file hashes like its bytes */
+    if (write_bytes(kWav, 1, 300000) != 0) { perror("write"); return 3; }
+    WorldCacheHeader_t h;
+    worldcache_header_init(&h);
+    if (worldcache_source_stamp(&h, kWav) != 0 || h.wav_size != 300000) {
+        fprintf(stderr, "stamp failed\n"); return 4;
+    }
+
+    /* unchanged: identity matches, nothing is read */
+    if (worldcache_source_check(&h, kWav) != WORLDCACHE_SOURCE_CURRENT) {
+        fprintf(stderr, "unchanged file not current\n"); return 5;
+    }
+
+    /* touched: same content, new mtime -> rehash once, then fast path again */
+    if (shift_mtime(kWav, 100) != 0) { perror("utime"); return 6; }
+    uint64_t old_mtime = h.wav_mtime;
+    if (worldcache_source_check(&h, kWav) != WORLDCACHE_SOURCE_REHASHED || h.wav_mtime == old_mtime) {
+        fprintf(stderr, "touched file not rehashed\n"); return 7;
+    }
+    if (worldcache_source_check(&h, kWav) != WORLDCACHE_SOURCE_CURRENT) {
+        fprintf(stderr, "refreshed identity not current\n"); return 8;
+    }
+
+    /* same size, different content -> stale */
+    WorldCacheHeader_t before = h;
+    if (write_bytes(kWav, 2, 300000) != 0 || shift_mtime(kWav, 200) != 0) { perror("rewrite"); return 9; }
+    if (worldcache_source_check(&h, kWav) != WORLDCACHE_SOURCE_STALE ||
+        memcmp(&before, &h, sizeof(h)) != 0) {
+        fprintf(stderr, "changed content not stale\n"); return 10;
+    }
+
+    /* different size -> stale; missing -> stale */
+    if (write_bytes(kWav, 2, 1000) != 0) { perror("rewrite"); return 11; }
+    if (worldcache_source_check(&h, kWav) != WORLDCACHE_SOURCE_STALE) {
+        fprintf(stderr, "resized file not stale\n"); return 12;
+    }
+    remove(kWav);
+    if (worldcache_source_check(&h, kWav) != WORLDCACHE_SOURCE_STALE) {
+        fprintf(stderr, "missing file not stale\n"); return 13;
+    }
+
+    printf("worldcache source test passed\n");
+    return 0;
+}
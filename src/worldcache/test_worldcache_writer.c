@@ -0,0 +1,142 @@
+#include "worldcache_writer.h"
+#include "worldcache_manager.h"
+#include "worldx_test_wav.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Cache write-back: misses return before their sidecar exists, flushing
+ * stores it from storage shared with the caller's result (whether or not the
+ * caller freed it first), a full queue falls back to writing inline, and
+ * disabling drains the queue. */
+
+#define SAMPLES 3
+
+static const char* kWavs[SAMPLES] = {
+    "worldcache_writer_test_a.wav", "worldcache_writer_test_b.wav", "worldcache_writer_test_c.wav"
+};
+
+static void sidecar_path(char* out, size_t size, const char* wav) { snprintf(out, size, "%s.worldcache", wav); }
+
+static int sidecar_exists(const char* wav) {
+    char path[256];
+    sidecar_path(path, sizeof(path), wav);
+    FILE* f = fopen(path, "rb");
+    if (f) fclose(f);
+    return f != NULL;
+}
+
+static void remove_sidecars(void) {
+    char path[256];
+    for (int i = 0; i < SAMPLES; i++) {
+        sidecar_path(path, sizeof(path), kWavs[i]);
+        remove(path);
+    }
+}
+
+/* Load wav, expecting a miss or a hit */
+static int load(const char* wav, int expect_hit, WorldAnalysisData* out) {
+    WorldCacheLoadInfo info;
+    if (worldcache_get_analysis_ex(wav, out, &info) != 0) return -1;
+    return info.cache_hit == expect_hit ? 0 : -1;
+}
+
+/* The sidecar holds what the analysis produced */
+static int check_sidecar(const char* wav, const WorldAnalysisData* ref) {
+    WorldAnalysisData d;
+    world_analysis_data_init(&d);
+    if (load(wav, 1, &d) != 0 || d.f0_length != ref->f0_length || d.fft_size != ref->fft_size) return -1;
+    int same = memcmp(d.f0, ref->f0, sizeof(double) * (size_t)d.f0_length) == 0;
+    world_analysis_data_free(&d);
+    return same ? 0 : -1;
+}
+
+int main(void) {
+    remove_sidecars();
+    for (int i = 0; i < SAMPLES; i++) {
+        if (worldx_test_write_tone(kWavs[i], 22050, 0.3, 180.0 + 40.0 * i, 2) != 0) { perror("wav"); return 1; }
+    }
+    WorldAnalysisData ref[SAMPLES];
+    for (int i = 0; i < SAMPLES; i++) {
+        world_analysis_data_init(&ref[i]);
+        if (worldcache_analyze(kWavs[i], &ref[i]) != 0) { fprintf(stderr, "analysis failed\n"); return 2; }
+    }
+
+    /* misses hand their sidecars to the writer; the caller frees its data at once */
+    if (worldcache_set_write_back((size_t)64 << 20) != 0 || !worldcache_write_back()) {
+        fprintf(stderr, "write-back not enabled\n"); return 3;
+    }
+    for (int i = 0; i < SAMPLES; i++) {
+        WorldAnalysisData d;
+        world_analysis_data_init(&d);
+        if (load(kWavs[i], 0, &d) != 0) { fprintf(stderr, "miss %d failed\n", i); return 4; }
+        world_analysis_data_free(&d);
+    }
+    if (worldcache_flush_writes() != 0) { fprintf(stderr, "flush reported failures\n"); return 5; }
+
+    /* the queued write shares the caller's rows instead of copying them, and
+     * the caller's result outlives the job's share */
+    remove_sidecars();
+    WorldAnalysisData kept;
+    world_analysis_data_init(&kept);
+    if (load(kWavs[0], 0, &kept) != 0 || !kept.borrowed_matrices) {
+        fprintf(stderr, "queued write did not share the analysis\n"); return 17;
+    }
+    if (worldcache_flush_writes() != 0 || check_sidecar(kWavs[0], &kept) != 0 ||
+        memcmp(kept.f0, ref[0].f0, sizeof(double) * (size_t)kept.f0_length) != 0) {
+        fprintf(stderr, "shared analysis changed\n"); return 18;
+    }
+    world_analysis_data_free(&kept);
+    for (int i = 1; i < SAMPLES; i++) {
+        if (load(kWavs[i], 0, &kept) != 0) return 19;
+        world_analysis_data_free(&kept);
+    }
+    if (worldcache_flush_writes() != 0) return 20;
+    WorldCacheWriterStats stats;
+    worldcache_writer_stats(&stats);
+    printf("queued %llu, written %llu, inline %llu, pending %zu bytes\n", (unsigned long long)stats.queued,
+           (unsigned long long)stats.written, (unsigned long long)stats.inline_writes, stats.pending_bytes);
+    if (stats.queued != 2 * SAMPLES || stats.written != 2 * SAMPLES || stats.inline_writes != 0 ||
+        stats.pending_bytes) {
+        fprintf(stderr, "unexpected counters\n"); return 6;
+    }
+    for (int i = 0; i < SAMPLES; i++) {
+        if (check_sidecar(kWavs[i], &ref[i]) != 0) { fprintf(stderr, "sidecar %d wrong\n", i); return 7; }
+    }
+
+    /* a queue too small for one analysis writes inline: the sidecar exists on return */
+    remove_sidecars();
+    if (worldcache_set_write_back(1) != 0) return 8;
+    WorldAnalysisData d;
+    world_analysis_data_init(&d);
+    if (load(kWavs[0], 0, &d) != 0 || !sidecar_exists(kWavs[0])) { fprintf(stderr, "inline write missing\n"); return 9; }
+    worldcache_writer_stats(&stats);
+    if (stats.inline_writes != 1 || stats.queued != 2 * SAMPLES || stats.queue_bytes != 1) {
+        fprintf(stderr, "full queue did not write inline\n"); return 10;
+    }
+
+    /* disabling drains what is queued */
+    if (worldcache_set_write_back((size_t)64 << 20) != 0) return 11;
+    for (int i = 1; i < SAMPLES; i++) {
+        if (load(kWavs[i], 0, &d) != 0) return 12;
+    }
+    if (worldcache_set_write_back(0) != 0 || worldcache_write_back()) return 13;
+    for (int i = 0; i < SAMPLES; i++) {
+        if (check_sidecar(kWavs[i], &ref[i]) != 0) { fprintf(stderr, "drained sidecar %d wrong\n", i); return 14; }
+    }
+    worldcache_writer_stats(&stats);
+    if (stats.queue_bytes != 0 || stats.written != 3 * SAMPLES - 1) { fprintf(stderr, "drain incomplete\n"); return 15; }
+
+    /* without write-back misses write synchronously again */
+    remove_sidecars();
+    if (load(kWavs[0], 0, &d) != 0 || !sidecar_exists(kWavs[0]) || worldcache_flush_writes() != 0) return 16;
+
+    world_analysis_data_free(&d);
+    for (int i = 0; i < SAMPLES; i++) world_analysis_data_free(&ref[i]);
+    remove_sidecars();
+    for (int i = 0; i < SAMPLES; i++) remove(kWavs[i]);
+    printf("worldcache writer test passed\n");
+    return 0;
+}
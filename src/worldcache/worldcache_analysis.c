@@ -0,0 +1,754 @@
+#include "worldcache_analysis.h"
+#include "worldcache_dict.h"
+#include "worldcache_quant.h"
+#include "worldcache_source.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(USE_ZSTD)
+#include <zstd.h>
+#endif
+
+/* Blocks of the payload; TIME is the temporal positions */
+enum { BLOCK_SP = 0, BLOCK_AP = 1, BLOCK_F0 = 2, BLOCK_TIME = 3, BLOCKS = 4 };
+
+/* Values per row of a matrix block */
+static size_t block_dims(const WorldAnalysisData* data, int block) {
+    if (world_analysis_data_is_coded(data)) {
+        return (size_t)(block == BLOCK_SP ? data->coded_sp_dims : data->coded_ap_dims);
+    }
+    return (size_t)(data->fft_size / 2 + 1);
+}
+
+/* Row i of a block, in whatever precision data stores it */
+static void* block_row(const WorldAnalysisData* data, int block, int i) {
+    if (block == BLOCK_F0) return data->f0 + i;
+    if (block == BLOCK_TIME) return data->temporal_positions + i;
+    if (world_analysis_data_is_coded(data)) {
+        return block == BLOCK_SP ? data->coded_spectrogram[i] : data->coded_aperiodicity[i];
+    }
+    if (data->precision == WORLD_PRECISION_FLOAT32) {
+        return block == BLOCK_SP ? (void*)data->spectrogram_f32[i] : (void*)data->aperiodicity_f32[i];
+    }
+    return block == BLOCK_SP ? data->spectrogram[i] : data->aperiodicity[i];
+}
+
+/* Whether the rows of a block are one run in memory (everything but WORLD_LAYOUT_ROWS) */
+static int block_contiguous(const WorldAnalysisData* data, int block) {
+    return block == BLOCK_F0 || block == BLOCK_TIME || world_analysis_data_is_coded(data) ||
+           data->precision == WORLD_PRECISION_FLOAT32 || data->spectrogram_slab != NULL;
+}
+
+int worldcache_header_from_analysis(WorldCacheHeader_t* h, const WorldAnalysisData* data) {
+    if (!h || !data || !data->f0 || data->f0_length <= 0 || data->fft_size <= 0) return -1;
+
+    h->sample_rate = (double)data->sample_rate;
+    h->frame_period_ms = data->frame_period;
+    h->num_frames = (uint32_t)data->f0_length;
+    h->fft_size = (uint32_t)data->fft_size;
+    int quantized = (h->flags & WORLDCACHE_FLAG_QUANTIZED) && !world_analysis_data_is_coded(data);
+    h->flags = (uint16_t)(h->flags & ~(WORLDCACHE_FLAG_FLOAT32 | WORLDCACHE_FLAG_CODED | WORLDCACHE_FLAG_QUANTIZED |
+                                       WORLDCACHE_FLAG_PADDED));
+    h->flags |= WORLDCACHE_FLAG_F0_CONTOUR;
+    if (world_analysis_data_is_coded(data)) {
+        h->flags |= WORLDCACHE_FLAG_CODED;
+    } else if (quantized) {
+        h->flags |= WORLDCACHE_FLAG_QUANTIZED;
+    } else if (data->precision == WORLD_PRECISION_FLOAT32) {
+        h->flags |= WORLDCACHE_FLAG_FLOAT32;
+    }
+    worldcache_header_set_f0_estimator(h, (unsigned)data->f0_estimator);
+
+    uint64_t frames = (uint64_t)data->f0_length;
+    uint64_t value_size = worldcache_header_value_size(h);
+    h->sp_size = frames * block_dims(data, BLOCK_SP) * value_size;
+    h->ap_size = frames * block_dims(data, BLOCK_AP) * value_size;
+    if (quantized) {
+        uint32_t bins = (uint32_t)(data->fft_size / 2 + 1);
+        h->sp_size = frames * worldcache_quant_sp_row_bytes(bins);
+        h->ap_size = frames * worldcache_quant_ap_row_bytes(bins);
+    }
+    h->voiced_mask_size = frames * sizeof(double);
+    return 0;
+}
+
+const void* worldcache_analysis_row(const void* data, int block, uint32_t frame) {
+    return block_row((const WorldAnalysisData*)data, block, (int)frame);
+}
+
+/* Stored bytes of a section: a buffer, or the rows of a block of data */
+typedef struct {
+    const uint8_t* bytes;
+    const WorldAnalysisData* data;
+    int block;
+} SectionSource;
+
+/* Feed the bytes of a section of size bytes to fn: a hash or the file */
+static int source_each(const SectionSource* src, uint64_t size, int (*fn)(void* ctx, const void* p, size_t n),
+                       void* ctx) {
+    if (src->bytes || block_contiguous(src->data, src->block)) {
+        const void* p = src->bytes ? (const void*)src->bytes : block_row(src->data, src->block, 0);
+        return fn(ctx, p, (size_t)size);
+    }
+    size_t row_bytes = (size_t)(size / (uint64_t)src->data->f0_length);
+    for (int i = 0; i < src->data->f0_length; i++) {
+        if (fn(ctx, block_row(src->data, src->block, i), row_bytes) != 0) return -1;
+    }
+    return 0;
+}
+
+static int hash_bytes(void* ctx, const void* p, size_t n) {
+    worldcache_hash_update((WorldCacheHash*)ctx, p, n);
+    return 0;
+}
+
+static int write_bytes(void* ctx, const void* p, size_t n) {
+    return fwrite(p, 1, n, (FILE*)ctx) == n ? 0 : -1;
+}
+
+static int write_zeros(FILE* f, uint64_t count) {
+    static const uint8_t zeros[WORLDCACHE_SECTION_ALIGN];
+    while (count > 0) {
+        size_t n = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+        if (fwrite(zeros, 1, n, f) != n) return -1;
+        count -= n;
+    }
+    return 0;
+}
+
+int worldcache_write_analysis(FILE* f, const WorldCacheHeader_t* h, const WorldAnalysisData* data) {
+    return worldcache_write_analysis_ex(f, h, data, NULL);
+}
+
+/* Header of a compressed cache as written with opts */
+static WorldCacheHeader_t chunked_header(const WorldCacheHeader_t* h, const WorldCacheCompression* opts) {
+    WorldCacheHeader_t hc = *h;
+    hc.flags = (uint16_t)((hc.flags | WORLDCACHE_FLAG_CHUNKED) & ~WORLDCACHE_FLAG_DICT);
+    if (opts && opts->dict) hc.flags |= WORLDCACHE_FLAG_DICT;
+    return hc;
+}
+
+/* Add a section of size bytes from src to the image being written */
+static void add_section(WorldCacheSection_t* s, SectionSource* sources, uint32_t* count, uint32_t type,
+                        uint32_t codec, uint64_t size, SectionSource src) {
+    memset(&s[*count], 0, sizeof(s[*count]));
+    s[*count].type = type;
+    s[*count].codec = codec;
+    s[*count].size = size;
+    sources[*count] = src;
+    (*count)++;
+}
+
+/* Header, section table, and each section at its aligned offset */
+static int write_image(FILE* f, WorldCacheHeader_t* h, WorldCacheSection_t* s, const SectionSource* sources,
+                       uint32_t count) {
+    h->section_count = count;
+    worldcache_sections_place(s, count);
+    for (uint32_t i = 0; i < count; i++) {
+        WorldCacheHash hash;
+        worldcache_hash_init(&hash);
+        source_each(&sources[i], s[i].size, hash_bytes, &hash);
+        s[i].checksum = worldcache_hash_final(&hash);
+    }
+    if (fwrite(h, sizeof(*h), 1, f) != 1 || fwrite(s, sizeof(*s), count, f) != count) return -1;
+    uint64_t pos = sizeof(*h) + (uint64_t)count * sizeof(*s);
+    for (uint32_t i = 0; i < count; i++) {
+        if (write_zeros(f, s[i].offset - pos) != 0 || source_each(&sources[i], s[i].size, write_bytes, f) != 0) {
+            return -1;
+        }
+        pos = s[i].offset + s[i].size;
+    }
+    return 0;
+}
+
+/* Rows a cache stores: quantized sp/ap rows from their encoded buffers, the rest from data */
+typedef struct {
+    const WorldAnalysisData* data;
+    const uint8_t* encoded[2];
+    size_t row_bytes[2];
+} StoredRows;
+
+static const void* stored_row(const void* ctx, int block, uint32_t frame) {
+    const StoredRows* r = (const StoredRows*)ctx;
+    if (block <= BLOCK_AP && r->encoded[block]) return r->encoded[block] + frame * r->row_bytes[block];
+    return block_row(r->data, block, (int)frame);
+}
+
+int worldcache_write_analysis_ex(FILE* f, const WorldCacheHeader_t* h, const WorldAnalysisData* data,
+                                 const WorldCacheCompression* opts) {
+    if (!f || !h || !data || !data->f0 || h->num_frames != (uint32_t)data->f0_length ||
+        worldcache_header_is_v1(h)) {
+        return -1;
+    }
+    int quantized = (h->flags & WORLDCACHE_FLAG_QUANTIZED) != 0;
+    uint32_t bins = h->fft_size / 2 + 1;
+    if (quantized && (h->fft_size != (uint32_t)data->fft_size ||
+                      h->sp_size != h->num_frames * (uint64_t)worldcache_quant_sp_row_bytes(bins) ||
+                      h->ap_size != h->num_frames * (uint64_t)worldcache_quant_ap_row_bytes(bins))) {
+        return -1;
+    }
+
+    WorldCacheHeader_t hc = *h;
+    WorldCacheSection_t s[BLOCKS];
+    SectionSource sources[BLOCKS];
+    uint32_t count = 0;
+    uint8_t *sp = NULL, *ap = NULL, *chunks = NULL;
+    size_t chunks_size = 0;
+    double* times = NULL;
+    int result = 0;
+
+    /* Quantized sp/ap rows are encoded up front, then stored like any blocks */
+    if (quantized && worldcache_quant_encode_analysis(data, &sp, &ap) != 0) return -1;
+    SectionSource sp_src = { sp, data, BLOCK_SP }, ap_src = { ap, data, BLOCK_AP };
+    if (worldcache_header_is_compressed(h)) {
+        /* rows are streamed into the compressor where they are */
+        hc = chunked_header(h, opts);
+        StoredRows rows = { data, { sp, ap },
+                            { (size_t)(h->sp_size / h->num_frames), (size_t)(h->ap_size / h->num_frames) } };
+        result = worldcache_compress_rows(h, stored_row, &rows, WORLDCACHE_CHUNK_FRAMES, opts, 0, &chunks,
+                                          &chunks_size);
+        SectionSource chunks_src = { chunks, NULL, 0 };
+        add_section(s, sources, &count, WORLDCACHE_SECTION_CHUNKS, WORLDCACHE_CODEC_ZSTD, chunks_size, chunks_src);
+    } else {
+        uint32_t codec = quantized ? WORLDCACHE_CODEC_QUANTIZED : WORLDCACHE_CODEC_RAW;
+        add_section(s, sources, &count, WORLDCACHE_SECTION_SP, codec, h->sp_size, sp_src);
+        add_section(s, sources, &count, WORLDCACHE_SECTION_AP, codec, h->ap_size, ap_src);
+    }
+    SectionSource f0_src = { NULL, data, BLOCK_F0 };
+    add_section(s, sources, &count, WORLDCACHE_SECTION_F0, WORLDCACHE_CODEC_RAW, h->voiced_mask_size, f0_src);
+
+    /* temporal positions as the analysis has them, or as a load computes them */
+    SectionSource time_src = { NULL, data, BLOCK_TIME };
+    if (!data->temporal_positions) {
+        times = (double*)malloc(sizeof(double) * h->num_frames);
+        if (!times) result = -1;
+        for (uint32_t i = 0; times && i < h->num_frames; i++) times[i] = i * h->frame_period_ms / 1000.0;
+        time_src.bytes = (const uint8_t*)times;
+    }
+    add_section(s, sources, &count, WORLDCACHE_SECTION_TIME, WORLDCACHE_CODEC_RAW,
+                h->num_frames * (uint64_t)sizeof(double), time_src);
+
+    if (result == 0) result = write_image(f, &hc, s, sources, count);
+    free(times);
+    free(chunks);
+    free(sp);
+    free(ap);
+    return result;
+}
+
+/* Where an image is read from: a file positioned in it, or the bytes of an
+ * image already in memory (an entry of a mapped pack) */
+typedef struct {
+    FILE* f;
+    const uint8_t* image;     /* read from here instead of f when not NULL */
+    uint64_t size;
+    uint64_t pos;
+} ImageReader;
+
+static int image_read(ImageReader* r, void* dst, size_t size) {
+    if (!r->image) return fread(dst, 1, size, r->f) == size ? 0 : -1;
+    if (size > r->size - r->pos) return -1;
+    memcpy(dst, r->image + r->pos, size);
+    r->pos += size;
+    return 0;
+}
+
+/* Move forward from the current position; long may be 32-bit */
+static int image_skip(ImageReader* r, uint64_t size) {
+    if (r->image) {
+        if (size > r->size - r->pos) return -1;
+        r->pos += size;
+        return 0;
+    }
+    while (size > 0) {
+        long step = size > (1u << 30) ? (long)(1u << 30) : (long)size;
+        if (fseek(r->f, step, SEEK_CUR) != 0) return -1;
+        size -= (uint64_t)step;
+    }
+    return 0;
+}
+
+/* Sequential payload source: the image itself, or one compressed chunk
+ * decompressing straight into the destination buffers */
+typedef struct {
+    ImageReader* src;
+#if defined(USE_ZSTD)
+    ZSTD_DCtx* zstream;
+    ZSTD_inBuffer in;
+    uint8_t* scratch;         /* sink for decoded rows outside the range */
+#endif
+    int compressed_payload;
+} PayloadReader;
+
+#define PAYLOAD_SCRATCH_SIZE 65536
+
+static int payload_read(PayloadReader* r, void* dst, size_t size) {
+    if (size == 0) return 0;
+#if defined(USE_ZSTD)
+    if (r->compressed_payload) {
+        ZSTD_outBuffer out = { dst, size, 0 };
+        while (out.pos < out.size) {
+            size_t before = out.pos;
+            size_t ret = ZSTD_decompressStream(r->zstream, &out, &r->in);
+            if (ZSTD_isError(ret)) return -1;
+            if (out.pos == before && r->in.pos == r->in.size) return -1; /* truncated */
+        }
+        return 0;
+    }
+#endif
+    return image_read(r->src, dst, size);
+}
+
+static int payload_skip(PayloadReader* r, size_t size) {
+#if defined(USE_ZSTD)
+    if (r->compressed_payload) {
+        while (size > 0) {
+            size_t step = size < PAYLOAD_SCRATCH_SIZE ? size : PAYLOAD_SCRATCH_SIZE;
+            if (payload_read(r, r->scratch, step) != 0) return -1;
+            size -= step;
+        }
+        return 0;
+    }
+#endif
+    return image_skip(r->src, size);
+}
+
+/* Where the rows read go: data's own rows, or for quantized blocks a
+ * staging buffer decoded afterwards. Each block has its own range of
+ * frames: a quantized sp range starts at the key frame before the rest. */
+typedef struct {
+    WorldAnalysisData* data;
+    uint8_t* staged[BLOCKS];
+    size_t first[BLOCKS];
+    size_t count[BLOCKS];
+} RowTarget;
+
+/* Rows [skip, skip + n) of a run of `rows` rows of a block go to the
+ * target's rows from dst on; the rows around them are skipped */
+static int read_span(PayloadReader* r, const RowTarget* t, int block, size_t row_bytes, size_t rows,
+                     size_t skip, size_t n, size_t dst) {
+    if (payload_skip(r, skip * row_bytes) != 0) return -1;
+    if (t->staged[block]) {
+        if (payload_read(r, t->staged[block] + dst * row_bytes, n * row_bytes) != 0) return -1;
+    } else if (block_contiguous(t->data, block)) {
+        if (payload_read(r, block_row(t->data, block, (int)dst), n * row_bytes) != 0) return -1;
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            if (payload_read(r, block_row(t->data, block, (int)(dst + i)), row_bytes) != 0) return -1;
+        }
+    }
+    return payload_skip(r, (rows - skip - n) * row_bytes);
+}
+
+/* Chunked compressed payload (src at the chunk index): only the chunks
+ * overlapping the range are read and decoded. *consumed receives how far
+ * past the index start src was left. */
+static int read_chunks(ImageReader* src, const WorldCacheHeader_t* h, const size_t row_bytes[BLOCKS], const RowTarget* t,
+                       WorldCacheLoadInfo* info, uint64_t* consumed) {
+#if defined(USE_ZSTD)
+    WorldCacheChunkIndex_t index;
+    int blocks = worldcache_header_chunk_blocks(h);
+    if (!(h->flags & WORLDCACHE_FLAG_CHUNKED) || image_read(src, &index, sizeof(index)) != 0 ||
+        index.chunk_frames == 0 ||
+        index.chunk_count != (h->num_frames + index.chunk_frames - 1) / index.chunk_frames) {
+        return -1;
+    }
+    size_t first = t->first[BLOCK_SP], last = t->first[BLOCK_SP] + t->count[BLOCK_SP];
+    for (int b = BLOCK_AP; b < blocks; b++) {
+        if (t->first[b] < first) first = t->first[b];
+        if (t->first[b] + t->count[b] > last) last = t->first[b] + t->count[b];
+    }
+    size_t c0 = first / index.chunk_frames;
+    size_t c1 = (last - 1) / index.chunk_frames;
+    uint64_t* ends = (uint64_t*)malloc(sizeof(uint64_t) * index.chunk_count);
+    if (!ends) return -1;
+    int result = -1;
+    uint64_t begin = 0, end = 0;
+    if (image_read(src, ends, sizeof(uint64_t) * index.chunk_count) == 0) {
+        begin = c0 ? ends[c0 - 1] : 0;
+        end = ends[c1];
+        result = 0;
+        for (size_t c = c0; c <= c1; c++) {
+            if (ends[c] < (c ? ends[c - 1] : 0)) result = -1;
+        }
+    }
+    uint8_t* compressed = NULL;
+    if (result == 0 && (end - begin > SIZE_MAX || image_skip(src, begin) != 0 ||
+                        !(compressed = (uint8_t*)malloc((size_t)(end - begin) + 1)) ||
+                        image_read(src, compressed, (size_t)(end - begin)) != 0)) {
+        result = -1;
+    }
+
+    PayloadReader r;
+    memset(&r, 0, sizeof(r));
+    r.compressed_payload = 1;
+    if (result == 0) {
+        r.zstream = ZSTD_createDCtx();
+        r.scratch = (uint8_t*)malloc(PAYLOAD_SCRATCH_SIZE);
+        if (!r.zstream || !r.scratch) result = -1;
+    }
+    if (result == 0 && (h->flags & WORLDCACHE_FLAG_DICT)) {
+        /* every chunk names the dictionary; the first one is enough */
+        const ZSTD_DDict* ddict = worldcache_dict_ddict(
+            worldcache_dict_find(ZSTD_getDictID_fromFrame(compressed, (size_t)(end - begin))));
+        if (!ddict || ZSTD_isError(ZSTD_DCtx_refDDict(r.zstream, ddict))) result = -1;
+    }
+    for (size_t c = c0; result == 0 && c <= c1; c++) {
+        uint64_t chunk_begin = c ? ends[c - 1] : 0;
+        size_t chunk_first = c * index.chunk_frames;
+        size_t rows = h->num_frames - chunk_first < index.chunk_frames ? h->num_frames - chunk_first
+                                                                       : index.chunk_frames;
+        size_t lo[3], hi[3];
+        int last_block = -1;
+        for (int b = BLOCK_SP; b < blocks; b++) {
+            lo[b] = t->first[b] > chunk_first ? t->first[b] : chunk_first;
+            hi[b] = t->first[b] + t->count[b] < chunk_first + rows ? t->first[b] + t->count[b] : chunk_first + rows;
+            if (hi[b] > lo[b]) last_block = b;
+        }
+        ZSTD_DCtx_reset(r.zstream, ZSTD_reset_session_only);
+        r.in.src = compressed + (chunk_begin - begin);
+        r.in.size = (size_t)(ends[c] - chunk_begin);
+        r.in.pos = 0;
+        for (int b = BLOCK_SP; result == 0 && b <= last_block; b++) {
+            if (hi[b] <= lo[b]) {
+                result = payload_skip(&r, rows * row_bytes[b]);
+                continue;
+            }
+            /* the rest of the chunk after the range is never needed */
+            size_t span = b == last_block ? hi[b] - chunk_first : rows;
+            result = read_span(&r, t, b, row_bytes[b], span, lo[b] - chunk_first, hi[b] - lo[b],
+                               lo[b] - t->first[b]);
+        }
+    }
+    if (r.zstream) ZSTD_freeDCtx(r.zstream);
+    free(r.scratch);
+    free(compressed);
+    free(ends);
+    if (result == 0) {
+        info->bytes_read += sizeof(index) + sizeof(uint64_t) * index.chunk_count + (size_t)(end - begin);
+        *consumed = sizeof(index) + sizeof(uint64_t) * index.chunk_count + end;
+    }
+    return result;
+#else
+    (void)src; (void)h; (void)row_bytes; (void)t; (void)info; (void)consumed;
+    return -1;
+#endif
+}
+
+/* Block a section holds, or -1 for the chunks and sections this build does not know */
+static int section_block(uint32_t type) {
+    if (type < WORLDCACHE_SECTION_SP || type > WORLDCACHE_SECTION_TIME) return -1;
+    return (int)(type - WORLDCACHE_SECTION_SP);
+}
+
+/* Read the sections that hold frames of t, in file order; src is pos bytes
+ * into the image. *have_times tells whether temporal positions were read. */
+static int read_sections(ImageReader* src, const WorldCacheHeader_t* h, const WorldCacheSection_t* s, uint32_t count,
+                         uint64_t pos, const size_t row_bytes[BLOCKS], const RowTarget* t, int* have_times,
+                         WorldCacheLoadInfo* info) {
+    PayloadReader r;
+    memset(&r, 0, sizeof(r));
+    r.src = src;
+    info->bytes_read = 0;
+    *have_times = 0;
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (section_block(s[i].type) >= 0 || s[i].type == WORLDCACHE_SECTION_CHUNKS) last = i;
+    }
+    for (uint32_t i = 0; i <= last; i++) {
+        int b = section_block(s[i].type);
+        if (b < 0 && s[i].type != WORLDCACHE_SECTION_CHUNKS) continue;
+        if (s[i].offset < pos || image_skip(src, s[i].offset - pos) != 0) return -1;
+        if (b < 0) {
+            uint64_t consumed = 0;
+            if (read_chunks(src, h, row_bytes, t, info, &consumed) != 0) return -1;
+            pos = s[i].offset + consumed;
+            continue;
+        }
+        /* nothing is read after the range of the last section */
+        size_t rows = i == last ? t->first[b] + t->count[b] : h->num_frames;
+        if (read_span(&r, t, b, row_bytes[b], rows, t->first[b], t->count[b], 0) != 0) return -1;
+        info->bytes_read += t->count[b] * row_bytes[b];
+        pos = s[i].offset + rows * (uint64_t)row_bytes[b];
+        if (b == BLOCK_TIME) *have_times = 1;
+    }
+    return 0;
+}
+
+/* Check that the payload h describes is one this bridge stores, and get the
+ * row dims of its sp/ap blocks */
+static int payload_dims(const WorldCacheHeader_t* h, uint32_t* sp_dims, uint32_t* ap_dims) {
+    if (!worldcache_header_is_supported(h) ||
+        h->num_frames == 0 || h->fft_size == 0 ||
+        h->num_frames > INT32_MAX || h->fft_size > INT32_MAX ||
+        !(h->flags & WORLDCACHE_FLAG_F0_CONTOUR) ||
+        h->voiced_mask_size != h->num_frames * (uint64_t)sizeof(double)) {
+        return -1;
+    }
+    /* Coded frames are always stored as double */
+    if (worldcache_header_is_coded(h) && (h->flags & WORLDCACHE_FLAG_FLOAT32)) return -1;
+    /* Single-frame compressed payloads (before the chunk index) are rebuilt */
+    if (worldcache_header_is_compressed(h) && !(h->flags & WORLDCACHE_FLAG_CHUNKED)) return -1;
+
+    if (h->flags & WORLDCACHE_FLAG_QUANTIZED) {
+        uint32_t bins = h->fft_size / 2 + 1;
+        if ((h->flags & (WORLDCACHE_FLAG_CODED | WORLDCACHE_FLAG_FLOAT32)) ||
+            h->sp_size != h->num_frames * (uint64_t)worldcache_quant_sp_row_bytes(bins) ||
+            h->ap_size != h->num_frames * (uint64_t)worldcache_quant_ap_row_bytes(bins)) {
+            return -1;
+        }
+        *sp_dims = *ap_dims = bins;
+        return 0;
+    }
+
+    *sp_dims = worldcache_header_frame_dims(h, h->sp_size);
+    *ap_dims = worldcache_header_frame_dims(h, h->ap_size);
+    if (*sp_dims == 0 || *ap_dims == 0) return -1;
+    if (!worldcache_header_is_coded(h)) {
+        uint32_t bins = h->fft_size / 2 + 1;
+        if (*sp_dims != bins || *ap_dims != bins) return -1;
+    }
+    return 0;
+}
+
+/* Check that the sections hold the payload h describes: SP and AP, or the
+ * chunks; F0 unless the chunks carry it; TIME optional */
+static int check_sections(const WorldCacheHeader_t* h, const WorldCacheSection_t* s, uint32_t count) {
+    const WorldCacheSection_t* sp = worldcache_sections_find(s, count, WORLDCACHE_SECTION_SP);
+    const WorldCacheSection_t* ap = worldcache_sections_find(s, count, WORLDCACHE_SECTION_AP);
+    const WorldCacheSection_t* f0 = worldcache_sections_find(s, count, WORLDCACHE_SECTION_F0);
+    const WorldCacheSection_t* time = worldcache_sections_find(s, count, WORLDCACHE_SECTION_TIME);
+    const WorldCacheSection_t* chunks = worldcache_sections_find(s, count, WORLDCACHE_SECTION_CHUNKS);
+    if (worldcache_header_is_compressed(h)) {
+        if (!chunks || chunks->codec != WORLDCACHE_CODEC_ZSTD || sp || ap) return -1;
+        if (worldcache_header_chunk_blocks(h) > BLOCK_F0 ? f0 != NULL : !f0) return -1;
+    } else {
+        uint32_t codec = (h->flags & WORLDCACHE_FLAG_QUANTIZED) ? WORLDCACHE_CODEC_QUANTIZED : WORLDCACHE_CODEC_RAW;
+        if (chunks || !sp || !ap || !f0 || sp->codec != codec || ap->codec != codec || sp->size != h->sp_size ||
+            ap->size != h->ap_size) {
+            return -1;
+        }
+    }
+    if (f0 && (f0->codec != WORLDCACHE_CODEC_RAW || f0->size != h->voiced_mask_size)) return -1;
+    if (time && (time->codec != WORLDCACHE_CODEC_RAW || time->size != h->num_frames * (uint64_t)sizeof(double))) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Fields of a loaded analysis that come from the header alone; data holds
+ * frames [first, first + f0_length), with their temporal positions already
+ * in place if have_times */
+static void finish_load(const WorldCacheHeader_t* h, int first, int have_times, WorldAnalysisData* data) {
+    int frames = data->f0_length;
+    data->sample_rate = (int)h->sample_rate;
+    data->frame_period = h->frame_period_ms;
+    data->f0_estimator = (WorldF0Estimator)worldcache_header_f0_estimator(h);
+    for (int i = 0; !have_times && i < frames; i++) {
+        data->temporal_positions[i] = (first + i) * h->frame_period_ms / 1000.0;
+    }
+    /* The header does not record the source length; this is the length whose
+     * analysis yields the loaded frames */
+    data->x_length = (int)((frames - 1) * h->frame_period_ms / 1000.0 * h->sample_rate) + 1;
+}
+
+/* Decode the staged quantized rows of t into data's float32 rows */
+static int decode_staged(const RowTarget* t, uint32_t bins, const size_t row_bytes[BLOCKS],
+                         WorldAnalysisData* data) {
+    float* recon = (float*)calloc(bins, sizeof(float));
+    if (!recon) return -1;
+    WorldFlagsIsa isa = world_flags_detect_isa();
+    size_t first = t->first[BLOCK_AP];
+    for (size_t i = 0; i < t->count[BLOCK_SP]; i++) {
+        /* frames before the range only carry the prediction forward */
+        size_t frame = t->first[BLOCK_SP] + i;
+        float* sp = frame >= first ? data->spectrogram_f32[frame - first] : NULL;
+        worldcache_quant_decode_sp(t->staged[BLOCK_SP] + i * row_bytes[BLOCK_SP], bins, (uint32_t)frame, recon, sp,
+                                   isa);
+    }
+    for (size_t i = 0; i < t->count[BLOCK_AP]; i++) {
+        worldcache_quant_decode_ap(t->staged[BLOCK_AP] + i * row_bytes[BLOCK_AP], bins, data->aperiodicity_f32[i],
+                                   isa);
+    }
+    free(recon);
+    return 0;
+}
+
+/* Sections of the image whose header h was just read from src */
+static int read_section_table(ImageReader* src, const WorldCacheHeader_t* h, WorldCacheSection_t* s, uint32_t* count,
+                              uint64_t* pos) {
+    WorldCacheSection_t table[WORLDCACHE_MAX_SECTIONS];
+    *pos = worldcache_header_disk_size(h);
+    if (!worldcache_header_is_v1(h)) {
+        if (h->section_count > WORLDCACHE_MAX_SECTIONS ||
+            image_read(src, table, sizeof(*table) * h->section_count) != 0) {
+            return -1;
+        }
+        *pos += h->section_count * sizeof(*table);
+    }
+    return worldcache_header_sections(h, table, UINT64_MAX, s, count);
+}
+
+/* Read frames [first, first + count) of the payload following h */
+static int read_range(ImageReader* src, const WorldCacheHeader_t* h, int first, int count,
+                      WorldAnalysisData* data, WorldCacheLoadInfo* info) {
+    memset(info, 0, sizeof(*info));
+    uint32_t sp_dims, ap_dims, section_count;
+    WorldCacheSection_t sections[WORLDCACHE_MAX_SECTIONS];
+    uint64_t pos;
+    if (!src || !h || !data || payload_dims(h, &sp_dims, &ap_dims) != 0 || first < 0 || count <= 0 ||
+        (uint32_t)first >= h->num_frames || (uint32_t)count > h->num_frames - (uint32_t)first ||
+        read_section_table(src, h, sections, &section_count, &pos) != 0 ||
+        check_sections(h, sections, section_count) != 0) {
+        return -1;
+    }
+
+    int fft_size = (int)h->fft_size;
+    int quantized = (h->flags & WORLDCACHE_FLAG_QUANTIZED) != 0;
+    if (worldcache_header_is_coded(h)) {
+        if (world_analysis_data_allocate_coded(data, count, fft_size, (int)sp_dims,
+                                               (int)ap_dims) != 0) {
+            return -1;
+        }
+    } else {
+        data->precision = (h->flags & WORLDCACHE_FLAG_FLOAT32) || quantized ? WORLD_PRECISION_FLOAT32
+                                                                            : WORLD_PRECISION_DOUBLE;
+        if (world_analysis_data_allocate(data, count, fft_size) != 0) return -1;
+    }
+
+    size_t value_size = worldcache_header_value_size(h);
+    size_t row_bytes[BLOCKS] = { sp_dims * value_size, ap_dims * value_size, sizeof(double), sizeof(double) };
+    RowTarget t = { data, { NULL, NULL, NULL, NULL },
+                    { (size_t)first, (size_t)first, (size_t)first, (size_t)first },
+                    { (size_t)count, (size_t)count, (size_t)count, (size_t)count } };
+    int result = 0, have_times = 0;
+    if (quantized) {
+        /* sp decodes from the key frame at or before first */
+        row_bytes[BLOCK_SP] = worldcache_quant_sp_row_bytes(sp_dims);
+        row_bytes[BLOCK_AP] = worldcache_quant_ap_row_bytes(ap_dims);
+        t.first[BLOCK_SP] = (size_t)first - (size_t)first % WORLDCACHE_QUANT_KEY_FRAMES;
+        t.count[BLOCK_SP] = (size_t)count + ((size_t)first - t.first[BLOCK_SP]);
+        t.staged[BLOCK_SP] = (uint8_t*)malloc(t.count[BLOCK_SP] * row_bytes[BLOCK_SP]);
+        t.staged[BLOCK_AP] = (uint8_t*)malloc(t.count[BLOCK_AP] * row_bytes[BLOCK_AP]);
+        if (!t.staged[BLOCK_SP] || !t.staged[BLOCK_AP]) result = -1;
+    }
+    if (result == 0) {
+        result = read_sections(src, h, sections, section_count, pos, row_bytes, &t, &have_times, info);
+    }
+    if (result == 0 && quantized) result = decode_staged(&t, sp_dims, row_bytes, data);
+    free(t.staged[BLOCK_SP]);
+    free(t.staged[BLOCK_AP]);
+    if (result != 0) {
+        info->bytes_read = 0;
+        return -1;
+    }
+
+    finish_load(h, first, have_times, data);
+    return 0;
+}
+
+int worldcache_read_analysis(FILE* f, const WorldCacheHeader_t* h, WorldAnalysisData* data,
+                             WorldCacheLoadInfo* info) {
+    WorldCacheLoadInfo local;
+    if (!info) info = &local;
+    ImageReader r = { f, NULL, 0, 0 };
+    return read_range(f ? &r : NULL, h, 0, h ? (int)h->num_frames : 0, data, info);
+}
+
+int worldcache_read_frames(const char* cache_path, int first, int count, WorldAnalysisData* data,
+                           WorldCacheLoadInfo* info) {
+    WorldCacheLoadInfo local;
+    if (!info) info = &local;
+    memset(info, 0, sizeof(*info));
+    if (!cache_path || !data) return -1;
+    FILE* f = fopen(cache_path, "rb");
+    if (!f) return -1;
+
+    int result = -1;
+    WorldCacheHeader_t h;
+    if (worldcache_header_read(f, &h) == 0 && first >= 0 && count > 0 && (uint32_t)first < h.num_frames) {
+        /* sidecars sit beside their WAV, so the voicebank's dictionary is found the same way */
+        if (h.flags & WORLDCACHE_FLAG_DICT) worldcache_dict_locate(cache_path);
+        if ((uint32_t)count > h.num_frames - (uint32_t)first) count = (int)(h.num_frames - (uint32_t)first);
+        ImageReader r = { f, NULL, 0, 0 };
+        result = read_range(&r, &h, first, count, data, info);
+    }
+    fclose(f);
+    return result;
+}
+
+static int is_aligned(const void* p, size_t alignment) {
+    return ((uintptr_t)p % alignment) == 0;
+}
+
+int worldcache_attach_analysis(WorldCacheMapping* m, WorldAnalysisData* data,
+                               WorldCacheLoadInfo* info) {
+    return worldcache_attach_analysis_at(m, 0, m ? worldcache_mapping_size(m) : 0, data, info);
+}
+
+int worldcache_attach_analysis_at(WorldCacheMapping* m, size_t offset, size_t size,
+                                  WorldAnalysisData* data, WorldCacheLoadInfo* info) {
+    WorldCacheLoadInfo local;
+    if (!info) info = &local;
+    memset(info, 0, sizeof(*info));
+    if (!m || !data || offset > worldcache_mapping_size(m) || size > worldcache_mapping_size(m) - offset) {
+        return -1;
+    }
+
+    WorldCacheHeader_t h;
+    uint8_t* base = worldcache_mapping_data(m) + offset;
+    WorldCacheSection_t s[WORLDCACHE_MAX_SECTIONS];
+    uint32_t count, sp_dims, ap_dims;
+    if (worldcache_header_parse(base, size, &h) != 0 || worldcache_header_is_compressed(&h) ||
+        (h.flags & WORLDCACHE_FLAG_QUANTIZED) || payload_dims(&h, &sp_dims, &ap_dims) != 0 ||
+        worldcache_image_sections(base, size, &h, s, &count) != 0 || check_sections(&h, s, count) != 0) {
+        return -1;
+    }
+
+    const WorldCacheSection_t* time = worldcache_sections_find(s, count, WORLDCACHE_SECTION_TIME);
+    WorldAnalysisStorage storage;
+    memset(&storage, 0, sizeof(storage));
+    storage.spectrogram = base + worldcache_sections_find(s, count, WORLDCACHE_SECTION_SP)->offset;
+    storage.aperiodicity = base + worldcache_sections_find(s, count, WORLDCACHE_SECTION_AP)->offset;
+    storage.f0 = (double*)(void*)(base + worldcache_sections_find(s, count, WORLDCACHE_SECTION_F0)->offset);
+    storage.precision = (h.flags & WORLDCACHE_FLAG_FLOAT32) ? WORLD_PRECISION_FLOAT32
+                                                            : WORLD_PRECISION_DOUBLE;
+    if (worldcache_header_is_coded(&h)) {
+        storage.coded_sp_dims = (int)sp_dims;
+        storage.coded_ap_dims = (int)ap_dims;
+    }
+    storage.release = worldcache_mapping_release;
+    storage.owner = m;
+
+    /* Unpadded first-layout files leave the blocks misaligned; those are read instead */
+    size_t value_size = worldcache_header_value_size(&h);
+    if (!is_aligned(storage.spectrogram, value_size) || !is_aligned(storage.aperiodicity, value_size) ||
+        !is_aligned(storage.f0, sizeof(double))) {
+        return -1;
+    }
+
+    worldcache_mapping_retain(m);
+    if (world_analysis_data_attach(data, (int)h.num_frames, (int)h.fft_size, &storage) != 0) {
+        worldcache_mapping_release(m);
+        return -1;
+    }
+    if (time) memcpy(data->temporal_positions, base + time->offset, (size_t)time->size);
+    finish_load(&h, 0, time != NULL, data);
+    info->bytes_mapped = (size_t)(h.sp_size + h.ap_size + h.voiced_mask_size);
+    return 0;
+}
+
+int worldcache_read_analysis_at(WorldCacheMapping* m, size_t offset, size_t size, WorldAnalysisData* data,
+                                WorldCacheLoadInfo* info) {
+    WorldCacheLoadInfo local;
+    if (!info) info = &local;
+    memset(info, 0, sizeof(*info));
+    if (!m || !data || offset > worldcache_mapping_size(m) || size > worldcache_mapping_size(m) - offset) {
+        return -1;
+    }
+    WorldCacheHeader_t h;
+    const uint8_t* base = worldcache_mapping_data(m) + offset;
+    if (worldcache_header_parse(base, size, &h) != 0) return -1;
+    ImageReader r = { NULL, base, size, worldcache_header_disk_size(&h) };
+    if (r.pos > r.size) return -1;
+    return read_range(&r, &h, 0, (int)h.num_frames, data, info);
+}
@@ -0,0 +1,95 @@
+#ifndef WORLDCACHE_ANALYSIS_H
+#define WORLDCACHE_ANALYSIS_H
+
+#include <stdio.h>
+#include "worldcache_format.h"
+#include "worldcache_mmap.h"
+#include "worldcache_serialize.h"
+#include "world_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bridge between WorldAnalysisData and .worldcache payloads.
+ *
+ * The SP and AP sections hold the matrices exactly as WorldAnalysisData
+ * keeps them in memory (frame-major double, float32 or coded rows), the F0
+ * section the float64 F0 contour (WORLDCACHE_FLAG_F0_CONTOUR) and the TIME
+ * section the temporal positions. Loading therefore reads every block
+ * straight into the storage synthesis uses, or, from a mapped file, uses the
+ * 64-byte aligned sections where they are; nothing is staged and copied.
+ * First-layout files, which have no TIME section, are read the same way. Quantized blocks (WORLDCACHE_FLAG_QUANTIZED) are the
+ * exception: their rows are read into a staging buffer and decoded into
+ * float32 rows. */
+
+/* What a load did; filled by worldcache_read_analysis and the manager */
+typedef struct {
+    int cache_hit;        /* 1 if the analysis came from the cache */
+    size_t bytes_read;    /* payload bytes read from the cache file */
+    size_t bytes_mapped;  /* payload bytes used in place from a memory mapping */
+    size_t bytes_copied;  /* payload bytes copied between memory buffers after reading */
+    int waited;           /* 1 if another process or thread was building the cache and the load waited for it */
+} WorldCacheLoadInfo;
+
+/* Fill geometry, representation flags and block sizes of h for data.
+ * The source identity (worldcache_source_*) and compression are left to the caller. Set
+ * WORLDCACHE_FLAG_QUANTIZED in h beforehand to store sp/ap quantized (worldcache_quant.h; coded
+ * data is stored as is). Returns 0 on success, -1 if data is empty. */
+int worldcache_header_from_analysis(WorldCacheHeader_t* h, const WorldAnalysisData* data);
+
+/* Write h, its section table and the sections of data (as described by h)
+ * to f. Only the current layout is written. Returns 0 on success. */
+int worldcache_write_analysis(FILE* f, const WorldCacheHeader_t* h, const WorldAnalysisData* data);
+
+/* Same, compressing (if h asks for it) as opts says; opts may be NULL. The
+ * header written gains WORLDCACHE_FLAG_CHUNKED, and WORLDCACHE_FLAG_DICT
+ * when opts names a dictionary. */
+int worldcache_write_analysis_ex(FILE* f, const WorldCacheHeader_t* h, const WorldAnalysisData* data,
+                                 const WorldCacheCompression* opts);
+
+/* WorldCacheRowFn over a WorldAnalysisData (ctx): its rows as a cache with
+ * the header of worldcache_header_from_analysis stores them */
+const void* worldcache_analysis_row(const void* data, int block, uint32_t frame);
+
+/* Read the payload following h (f positioned right after the header) into
+ * data, which must be initialized. data takes the representation stored in
+ * the cache (float32 for quantized ones); its buffers are reused when they fit. info may be NULL.
+ * Returns 0 on success, -1 on malformed or unsupported payloads. */
+int worldcache_read_analysis(FILE* f, const WorldCacheHeader_t* h, WorldAnalysisData* data,
+                             WorldCacheLoadInfo* info);
+
+/* Read frames [first, first + count) of the cache at cache_path into data
+ * (count is clipped to the end of the cache). Uncompressed caches read only
+ * the rows of the range; compressed ones read and decode only the chunks
+ * that overlap it. temporal_positions keep their absolute times. The source
+ * is not validated (see worldcache_check_header). Returns 0 on success, -1
+ * if the file is missing or malformed or first is out of range. */
+int worldcache_read_frames(const char* cache_path, int first, int count, WorldAnalysisData* data,
+                           WorldCacheLoadInfo* info);
+
+/* Point data straight into an uncompressed cache mapping (header at the
+ * start of the mapping). data keeps a reference to m until it is freed or
+ * reallocated. Returns 0 on success, -1 for compressed, quantized, malformed
+ * or misaligned payloads (read those with worldcache_read_analysis). */
+int worldcache_attach_analysis(WorldCacheMapping* m, WorldAnalysisData* data,
+                               WorldCacheLoadInfo* info);
+
+/* Same for a cache image stored at [offset, offset + size) of m, e.g. an
+ * entry of a .worldpack. */
+int worldcache_attach_analysis_at(WorldCacheMapping* m, size_t offset, size_t size,
+                                  WorldAnalysisData* data, WorldCacheLoadInfo* info);
+
+/* Decode the cache image at [offset, offset + size) of m into data's own
+ * storage, like worldcache_read_analysis but from the mapped bytes: the
+ * way to load compressed and quantized entries of a mapped .worldpack
+ * without reopening a file that may have been replaced since. data keeps
+ * no reference to m. Returns 0 on success. */
+int worldcache_read_analysis_at(WorldCacheMapping* m, size_t offset, size_t size, WorldAnalysisData* data,
+                                WorldCacheLoadInfo* info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_ANALYSIS_H */
@@ -0,0 +1,456 @@
+#include "worldcache_dict.h"
+#include "worldcache_analysis.h"
+#include "worldcache_lock.h"
+#include "worldcache_manager.h"
+#include "worldcache_quant.h"
+#include "worldcache_source.h"
+#include "worldcache_voicebank.h"
+#include "worldx_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(USE_ZSTD)
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+/* zstd dictionary magic, followed by the dictionary id (little-endian) */
+#define DICT_MAGIC 0xEC30A437U
+
+/* CDict of one compression level */
+typedef struct LevelDict {
+    int level;
+    struct ZSTD_CDict_s* cdict;
+    struct LevelDict* next;
+} LevelDict;
+
+struct WorldCacheDict {
+    uint32_t id;
+    uint8_t* bytes;
+    size_t size;
+    struct ZSTD_DDict_s* ddict;
+    LevelDict* cdicts;
+    struct WorldCacheDict* next;
+};
+
+/* Where a voicebank's dictionary file was found, and what it held */
+typedef struct Located {
+    char* path;
+    WorldCacheSourceId id;
+    const WorldCacheDict* dict;
+    struct Located* next;
+} Located;
+
+/* Registry: dictionaries are only added until worldcache_dict_clear */
+static worldx_mutex_t g_lock = WORLDX_MUTEX_INITIALIZER;
+static WorldCacheDict* g_dicts;
+static Located* g_located;
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static WorldCacheDict* find_locked(uint32_t id) {
+    for (WorldCacheDict* d = g_dicts; d; d = d->next) {
+        if (d->id == id) return d;
+    }
+    return NULL;
+}
+
+const WorldCacheDict* worldcache_dict_register(const void* bytes, size_t size) {
+    if (!bytes || size < 8 || get_u32((const uint8_t*)bytes) != DICT_MAGIC) return NULL;
+    uint32_t id = get_u32((const uint8_t*)bytes + 4);
+    if (id == 0) return NULL;
+
+    worldx_mutex_lock(&g_lock);
+    WorldCacheDict* d = find_locked(id);
+    if (!d && (d = (WorldCacheDict*)calloc(1, sizeof(*d))) != NULL) {
+        d->bytes = (uint8_t*)malloc(size);
+        if (d->bytes) {
+            memcpy(d->bytes, bytes, size);
+            d->size = size;
+            d->id = id;
+            d->next = g_dicts;
+            g_dicts = d;
+        } else {
+            free(d);
+            d = NULL;
+        }
+    }
+    worldx_mutex_unlock(&g_lock);
+    return d;
+}
+
+/* Whole file at path; caller frees */
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    uint8_t* buf = NULL;
+    long len = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (len > 0 && fseek(f, 0, SEEK_SET) == 0 && (buf = (uint8_t*)malloc((size_t)len)) != NULL &&
+        fread(buf, 1, (size_t)len, f) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *size = buf ? (size_t)len : 0;
+    return buf;
+}
+
+const WorldCacheDict* worldcache_dict_load(const char* path) {
+    size_t size = 0;
+    uint8_t* bytes = path ? read_file(path, &size) : NULL;
+    const WorldCacheDict* d = bytes ? worldcache_dict_register(bytes, size) : NULL;
+    free(bytes);
+    return d;
+}
+
+const WorldCacheDict* worldcache_dict_find(uint32_t id) {
+    worldx_mutex_lock(&g_lock);
+    const WorldCacheDict* d = id ? find_locked(id) : NULL;
+    worldx_mutex_unlock(&g_lock);
+    return d;
+}
+
+/* Registered dictionary of the file at path with identity id, loading it
+ * when the file is new or changed */
+static const WorldCacheDict* locate_file(const char* path, const WorldCacheSourceId* id) {
+    worldx_mutex_lock(&g_lock);
+    Located* l = g_located;
+    while (l && strcmp(l->path, path) != 0) l = l->next;
+    int current = l && l->id.size == id->size && l->id.mtime_ns == id->mtime_ns && l->id.inode == id->inode;
+    const WorldCacheDict* d = current ? l->dict : NULL;
+    worldx_mutex_unlock(&g_lock);
+    if (current) return d;
+
+    d = worldcache_dict_load(path);
+    if (!d) return NULL;
+    worldx_mutex_lock(&g_lock);
+    if (!l) {
+        l = (Located*)calloc(1, sizeof(*l));
+        if (l && (l->path = (char*)malloc(strlen(path) + 1)) != NULL) {
+            strcpy(l->path, path);
+            l->next = g_located;
+            g_located = l;
+        } else {
+            free(l);
+            l = NULL;
+        }
+    }
+    if (l) {
+        l->id = *id;
+        l->dict = d;
+    }
+    worldx_mutex_unlock(&g_lock);
+    return d;
+}
+
+const WorldCacheDict* worldcache_dict_locate(const char* wav_path) {
+    if (!wav_path) return NULL;
+    size_t prefix = worldcache_path_dir_length(wav_path);
+    char path[4096];
+    for (int depth = 0; depth <= WORLDCACHE_DICT_SEARCH_DEPTH; depth++) {
+        WorldCacheSourceId id;
+        int n = snprintf(path, sizeof(path), "%.*s%s", (int)prefix, wav_path, WORLDCACHE_DICT_FILENAME);
+        if (n > 0 && (size_t)n < sizeof(path) && worldcache_source_identify(path, &id) == 0) {
+            return locate_file(path, &id);
+        }
+        if (worldcache_path_parent(wav_path, &prefix) != 0) break;
+    }
+    return NULL;
+}
+
+uint32_t worldcache_dict_id(const WorldCacheDict* dict) { return dict ? dict->id : 0; }
+
+const void* worldcache_dict_bytes(const WorldCacheDict* dict, size_t* size) {
+    if (size) *size = dict ? dict->size : 0;
+    return dict ? dict->bytes : NULL;
+}
+
+void worldcache_dict_clear(void) {
+    worldx_mutex_lock(&g_lock);
+    while (g_dicts) {
+        WorldCacheDict* d = g_dicts;
+        g_dicts = d->next;
+        while (d->cdicts) {
+            LevelDict* c = d->cdicts;
+            d->cdicts = c->next;
+#if defined(USE_ZSTD)
+            ZSTD_freeCDict(c->cdict);
+#endif
+            free(c);
+        }
+#if defined(USE_ZSTD)
+        ZSTD_freeDDict(d->ddict);
+#endif
+        free(d->bytes);
+        free(d);
+    }
+    while (g_located) {
+        Located* l = g_located;
+        g_located = l->next;
+        free(l->path);
+        free(l);
+    }
+    worldx_mutex_unlock(&g_lock);
+}
+
+int worldcache_image_dict_id(const uint8_t* image, size_t size, uint32_t* id) {
+    WorldCacheHeader_t h;
+    WorldCacheChunkIndex_t index;
+    WorldCacheSection_t s[WORLDCACHE_MAX_SECTIONS];
+    uint32_t count;
+    if (!image || !id || worldcache_header_parse(image, size, &h) != 0) return -1;
+    *id = 0;
+    if (!(h.flags & WORLDCACHE_FLAG_DICT)) return 0;
+    if (worldcache_image_sections(image, size, &h, s, &count) != 0) return -1;
+    const WorldCacheSection_t* chunks = worldcache_sections_find(s, count, WORLDCACHE_SECTION_CHUNKS);
+    if (!chunks || chunks->size < sizeof(index)) return -1;
+    memcpy(&index, image + chunks->offset, sizeof(index));
+    uint64_t first = chunks->offset + sizeof(index) + (uint64_t)index.chunk_count * sizeof(uint64_t);
+    if (index.chunk_count == 0 || first >= size) return -1;
+#if defined(USE_ZSTD)
+    *id = ZSTD_getDictID_fromFrame(image + first, size - first);
+#endif
+    return *id ? 0 : -1;
+}
+
+struct ZSTD_CDict_s* worldcache_dict_cdict(const WorldCacheDict* dict, int level) {
+#if defined(USE_ZSTD)
+    if (!dict) return NULL;
+    WorldCacheDict* d = (WorldCacheDict*)dict;
+    worldx_mutex_lock(&g_lock);
+    LevelDict* c = d->cdicts;
+    while (c && c->level != level) c = c->next;
+    if (!c && (c = (LevelDict*)calloc(1, sizeof(*c))) != NULL) {
+        c->level = level;
+        c->cdict = ZSTD_createCDict(d->bytes, d->size, level);
+        if (c->cdict) {
+            c->next = d->cdicts;
+            d->cdicts = c;
+        } else {
+            free(c);
+            c = NULL;
+        }
+    }
+    worldx_mutex_unlock(&g_lock);
+    return c ? c->cdict : NULL;
+#else
+    (void)dict; (void)level;
+    return NULL;
+#endif
+}
+
+struct ZSTD_DDict_s* worldcache_dict_ddict(const WorldCacheDict* dict) {
+#if defined(USE_ZSTD)
+    if (!dict) return NULL;
+    WorldCacheDict* d = (WorldCacheDict*)dict;
+    worldx_mutex_lock(&g_lock);
+    if (!d->ddict) d->ddict = ZSTD_createDDict(d->bytes, d->size);
+    ZSTD_DDict* ddict = d->ddict;
+    worldx_mutex_unlock(&g_lock);
+    return ddict;
+#else
+    (void)dict;
+    return NULL;
+#endif
+}
+
+/* ---- training ---- */
+
+struct WorldCacheDictTrainer {
+    size_t budget;
+    uint8_t* samples;   /* kept samples back to back */
+    size_t* sizes;
+    size_t count, bytes, capacity, sizes_capacity;
+    size_t stride;      /* keep every stride-th offered sample */
+    size_t offered;
+};
+
+WorldCacheDictTrainer* worldcache_dict_trainer_create(size_t budget) {
+    WorldCacheDictTrainer* t = (WorldCacheDictTrainer*)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->budget = budget ? budget : WORLDCACHE_DICT_TRAINING_BUDGET;
+    t->stride = 1;
+    return t;
+}
+
+void worldcache_dict_trainer_destroy(WorldCacheDictTrainer* t) {
+    if (!t) return;
+    free(t->samples);
+    free(t->sizes);
+    free(t);
+}
+
+/* Drop every other kept sample */
+static void decimate(WorldCacheDictTrainer* t) {
+    size_t src = 0, dst = 0, kept = 0;
+    for (size_t i = 0; i < t->count; i++) {
+        if (i % 2 == 0) {
+            memmove(t->samples + dst, t->samples + src, t->sizes[i]);
+            dst += t->sizes[i];
+            t->sizes[kept++] = t->sizes[i];
+        }
+        src += t->sizes[i];
+    }
+    t->count = kept;
+    t->bytes = dst;
+    t->stride *= 2;
+}
+
+static int offer(WorldCacheDictTrainer* t, const void* row, size_t size) {
+    if (t->offered++ % t->stride != 0) return 0;
+    if (t->bytes + size > t->capacity) {
+        size_t capacity = t->capacity ? t->capacity : 65536;
+        while (capacity < t->bytes + size) capacity *= 2;
+        uint8_t* grown = (uint8_t*)realloc(t->samples, capacity);
+        if (!grown) return -1;
+        t->samples = grown;
+        t->capacity = capacity;
+    }
+    if (t->count == t->sizes_capacity) {
+        size_t capacity = t->sizes_capacity ? t->sizes_capacity * 2 : 256;
+        size_t* grown = (size_t*)realloc(t->sizes, capacity * sizeof(size_t));
+        if (!grown) return -1;
+        t->sizes = grown;
+        t->sizes_capacity = capacity;
+    }
+    memcpy(t->samples + t->bytes, row, size);
+    t->bytes += size;
+    t->sizes[t->count++] = size;
+    if (t->bytes > t->budget) decimate(t);
+    return 0;
+}
+
+int worldcache_dict_trainer_add(WorldCacheDictTrainer* t, const WorldCacheHeader_t* h,
+                                const WorldAnalysisData* data) {
+    if (!t || !h || !data || h->num_frames == 0 || h->num_frames != (uint32_t)data->f0_length) return -1;
+    const size_t rows[2] = { (size_t)(h->sp_size / h->num_frames), (size_t)(h->ap_size / h->num_frames) };
+    /* quantized rows only exist once encoded */
+    uint8_t* quantized[2] = { NULL, NULL };
+    if ((h->flags & WORLDCACHE_FLAG_QUANTIZED) &&
+        worldcache_quant_encode_analysis(data, &quantized[0], &quantized[1]) != 0) {
+        return -1;
+    }
+    int result = 0;
+    for (uint32_t i = 0; result == 0 && i < h->num_frames; i++) {
+        for (int b = 0; result == 0 && b < 2; b++) {
+            const void* row = quantized[b] ? quantized[b] + (size_t)i * rows[b] : worldcache_analysis_row(data, b, i);
+            result = offer(t, row, rows[b]);
+        }
+    }
+    free(quantized[0]);
+    free(quantized[1]);
+    return result;
+}
+
+int worldcache_dict_trainer_finish(WorldCacheDictTrainer* t, size_t capacity, void** out_bytes,
+                                   size_t* out_size) {
+#if defined(USE_ZSTD)
+    if (!t || !out_bytes || !out_size || t->count == 0 || t->count > UINT32_MAX) return -1;
+    if (capacity == 0) capacity = WORLDCACHE_DICT_CAPACITY;
+    void* buf = malloc(capacity);
+    if (!buf) return -1;
+    size_t size = ZDICT_trainFromBuffer(buf, capacity, t->samples, t->sizes, (unsigned)t->count);
+    if (ZDICT_isError(size)) {
+        free(buf);
+        return -1;
+    }
+    *out_bytes = buf;
+    *out_size = size;
+    return 0;
+#else
+    (void)t; (void)capacity; (void)out_bytes; (void)out_size;
+    return -1;
+#endif
+}
+
+/* Write bytes to path through a temporary file renamed over it */
+static int replace_file(const char* path, const void* bytes, size_t size) {
+    char tmp_path[4096];
+    if (worldcache_temp_path(path, tmp_path, sizeof(tmp_path)) != 0) return -1;
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) return -1;
+    int result = fwrite(bytes, 1, size, f) == size ? 0 : -1;
+    if (fclose(f) != 0) result = -1;
+    if (result == 0 && worldcache_replace_file(tmp_path, path) != 0) result = -1;
+    if (result != 0) remove(tmp_path);
+    return result;
+}
+
+static uint64_t file_size(const char* path) {
+    WorldCacheSourceId id;
+    return worldcache_source_identify(path, &id) == 0 ? id.size : 0;
+}
+
+int worldcache_dict_train(const char* voicebank_dir, size_t capacity, WorldCacheDictReport* report) {
+    WorldCacheDictReport local;
+    if (!report) report = &local;
+    memset(report, 0, sizeof(*report));
+    if (!voicebank_dir) return -1;
+
+    char dict_path[4096];
+    int n = snprintf(dict_path, sizeof(dict_path), "%s/%s", voicebank_dir, WORLDCACHE_DICT_FILENAME);
+    WorldCachePathList keys;
+    if (n < 0 || (size_t)n >= sizeof(dict_path) || worldcache_voicebank_samples(voicebank_dir, &keys, NULL) != 0) {
+        return -1;
+    }
+
+    /* analyses come through the cache, so current samples are not reanalyzed */
+    WorldCacheDictTrainer* t = worldcache_dict_trainer_create(0);
+    int result = t ? 0 : -1;
+    for (size_t i = 0; result == 0 && i < keys.count; i++) {
+        char wav_path[4096];
+        WorldCacheSourceId id;
+        n = snprintf(wav_path, sizeof(wav_path), "%s/%s", voicebank_dir, keys.items[i]);
+        if (n < 0 || (size_t)n >= sizeof(wav_path) || worldcache_source_identify(wav_path, &id) != 0) continue;
+        WorldAnalysisData data;
+        WorldCacheHeader_t h;
+        world_analysis_data_init(&data);
+        worldcache_header_init(&h);
+        /* train on rows as the sidecars are rewritten below */
+        if (worldcache_quantized()) h.flags |= WORLDCACHE_FLAG_QUANTIZED;
+        if (worldcache_get_analysis(wav_path, &data) != 0 || worldcache_header_from_analysis(&h, &data) != 0) {
+            report->failed++;
+        } else {
+            result = worldcache_dict_trainer_add(t, &h, &data);
+            report->samples++;
+        }
+        world_analysis_data_free(&data);
+    }
+
+    void* bytes = NULL;
+    size_t size = 0;
+    if (result == 0 && (worldcache_dict_trainer_finish(t, capacity, &bytes, &size) != 0 ||
+                        replace_file(dict_path, bytes, size) != 0)) {
+        result = -1;
+    }
+    if (t) report->training_bytes = t->bytes;
+    worldcache_dict_trainer_destroy(t);
+    free(bytes);
+    const WorldCacheDict* dict = result == 0 ? worldcache_dict_load(dict_path) : NULL;
+    if (result == 0 && !dict) result = -1;
+    if (dict) {
+        report->dict_size = size;
+        report->dict_id = worldcache_dict_id(dict);
+    }
+
+    /* sidecars take the new dictionary on their next write */
+    for (size_t i = 0; result == 0 && i < keys.count; i++) {
+        char wav_path[4096], cache_path[4096];
+        snprintf(wav_path, sizeof(wav_path), "%s/%s", voicebank_dir, keys.items[i]);
+        n = snprintf(cache_path, sizeof(cache_path), "%s.worldcache", wav_path);
+        uint64_t before = n > 0 && (size_t)n < sizeof(cache_path) ? file_size(cache_path) : 0;
+        if (before == 0) continue;
+        WorldAnalysisData data;
+        world_analysis_data_init(&data);
+        if (worldcache_get_analysis(wav_path, &data) == 0 && worldcache_store(wav_path, &data) == 0) {
+            report->recompressed++;
+            report->bytes_before += before;
+            report->bytes_after += file_size(cache_path);
+        }
+        world_analysis_data_free(&data);
+    }
+    worldcache_path_list_free(&keys);
+    return result;
+}
@@ -0,0 +1,112 @@
+#ifndef WORLDCACHE_DICT_H
+#define WORLDCACHE_DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "worldcache_format.h"
+#include "worldcache_serialize.h"
+#include "world_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-voicebank zstd dictionaries.
+ *
+ * Samples of one voicebank share a voice, so their spectra share structure
+ * that a dictionary trained across the voicebank's caches gives to every
+ * chunk up front. The dictionary is stored once, as WORLDCACHE_DICT_FILENAME
+ * at the voicebank root (and embedded in its .worldpack); caches compressed
+ * with it carry WORLDCACHE_FLAG_DICT and the dictionary id in each chunk's
+ * zstd frame header.
+ *
+ * Dictionaries are kept in a process-wide registry keyed by id and live
+ * until worldcache_dict_clear; readers look chunks' ids up there. */
+
+#define WORLDCACHE_DICT_FILENAME "voicebank.worlddict"
+#define WORLDCACHE_DICT_SEARCH_DEPTH 3
+
+/* Default dictionary size and training sample budget */
+#define WORLDCACHE_DICT_CAPACITY (112 * 1024)
+#define WORLDCACHE_DICT_TRAINING_BUDGET (16 * 1024 * 1024)
+
+typedef struct WorldCacheDict WorldCacheDict;
+
+/* Register a zstd dictionary (bytes are copied). Returns the registered
+ * dictionary -- an earlier one if its id is already known -- or NULL for
+ * malformed input and raw content without a dictionary id. */
+const WorldCacheDict* worldcache_dict_register(const void* bytes, size_t size);
+
+/* Register the dictionary stored at path */
+const WorldCacheDict* worldcache_dict_load(const char* path);
+
+/* Registered dictionary with this id, or NULL */
+const WorldCacheDict* worldcache_dict_find(uint32_t id);
+
+/* Dictionary of the voicebank holding wav_path: WORLDCACHE_DICT_FILENAME in
+ * the sample's directory or up to WORLDCACHE_DICT_SEARCH_DEPTH parents. The
+ * file is registered on first use and again when it changes. NULL if there
+ * is none. */
+const WorldCacheDict* worldcache_dict_locate(const char* wav_path);
+
+uint32_t worldcache_dict_id(const WorldCacheDict* dict);
+const void* worldcache_dict_bytes(const WorldCacheDict* dict, size_t* size);
+
+/* Drop every registered dictionary; none may be in use */
+void worldcache_dict_clear(void);
+
+/* Dictionary id of the chunks of a cache image (header + payload), 0 when
+ * the image is not compressed with a dictionary. Returns 0 on success, -1
+ * for malformed images. */
+int worldcache_image_dict_id(const uint8_t* image, size_t size, uint32_t* id);
+
+/* zstd objects of a dictionary, created on first use and owned by it
+ * (NULL when built without USE_ZSTD) */
+struct ZSTD_CDict_s* worldcache_dict_cdict(const WorldCacheDict* dict, int level);
+struct ZSTD_DDict_s* worldcache_dict_ddict(const WorldCacheDict* dict);
+
+/* ---- training ---- */
+
+/* Collects training samples: single rows of the sp and ap blocks, as the
+ * cache stores them. Past the budget every other sample is dropped and only
+ * every other new one is kept, so long voicebanks are sampled evenly. */
+typedef struct WorldCacheDictTrainer WorldCacheDictTrainer;
+
+WorldCacheDictTrainer* worldcache_dict_trainer_create(size_t budget);
+void worldcache_dict_trainer_destroy(WorldCacheDictTrainer* t);
+
+/* Add the rows of data, in the representation h describes. Returns 0 on success. */
+int worldcache_dict_trainer_add(WorldCacheDictTrainer* t, const WorldCacheHeader_t* h,
+                                const WorldAnalysisData* data);
+
+/* Train a dictionary of at most capacity bytes from the samples; caller
+ * frees *out_bytes. Returns 0 on success, -1 if training fails (too few
+ * samples) or without USE_ZSTD. */
+int worldcache_dict_trainer_finish(WorldCacheDictTrainer* t, size_t capacity, void** out_bytes,
+                                   size_t* out_size);
+
+/* Outcome of worldcache_dict_train */
+typedef struct {
+    int samples;           /* samples whose analysis was used */
+    int failed;            /* samples that could not be analyzed */
+    int recompressed;      /* sidecars rewritten with the dictionary */
+    size_t training_bytes; /* bytes of training samples kept */
+    size_t dict_size;
+    uint32_t dict_id;
+    uint64_t bytes_before; /* sidecar bytes before recompression */
+    uint64_t bytes_after;  /* and after */
+} WorldCacheDictReport;
+
+/* Train a dictionary of at most capacity (0: WORLDCACHE_DICT_CAPACITY)
+ * bytes across the samples of voicebank_dir (worldcache_voicebank_samples),
+ * analyzing samples without a current cache first. The dictionary is
+ * written to <voicebank_dir>/WORLDCACHE_DICT_FILENAME and the sidecars are
+ * recompressed with it; run `pack update` afterwards to carry it into the
+ * pack. report may be NULL. Returns 0 on success. */
+int worldcache_dict_train(const char* voicebank_dir, size_t capacity, WorldCacheDictReport* report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_DICT_H */
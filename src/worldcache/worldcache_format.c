@@ -1,11 +1,12 @@
 #include "worldcache_format.h"
+#include "worldcache_source.h"
 #include <string.h>
 
 void worldcache_header_init(WorldCacheHeader_t* h) {
     if (!h) return;
     memset(h, 0, sizeof(*h));
     h->magic = WORLDCACHE_MAGIC;
-    h->format_version = 1;
+    h->format_version = WORLDCACHE_FORMAT_VERSION;
     h->flags = 0;
     h->sample_rate = 44100.0;
     h->frame_period_ms = 5.0;
@@ -16,4 +17,186 @@ void worldcache_header_init(WorldCacheHeader_t* h) {
     h->sp_size = 0;
     h->ap_size = 0;
     h->voiced_mask_size = 0;
+    h->wav_size = 0;
+    h->wav_inode = 0;
+    h->section_count = 0;
+}
+
+/* Current header of a first-layout one; magic and version are kept so the
+ * header is stored back in its own layout */
+static void header_from_v1(const WorldCacheHeaderV1_t* v1, WorldCacheHeader_t* h) {
+    memset(h, 0, sizeof(*h));
+    h->magic = v1->magic;
+    h->format_version = v1->format_version;
+    h->flags = v1->flags;
+    h->sample_rate = v1->sample_rate;
+    h->frame_period_ms = v1->frame_period_ms;
+    h->wav_hash = v1->wav_hash;
+    h->wav_mtime = v1->wav_mtime;
+    h->wav_size = v1->wav_size;
+    h->wav_inode = v1->wav_inode;
+    h->num_frames = v1->num_frames;
+    h->fft_size = v1->fft_size;
+    h->sp_size = v1->sp_size;
+    h->ap_size = v1->ap_size;
+    h->voiced_mask_size = v1->voiced_mask_size;
+}
+
+int worldcache_header_parse(const void* image, size_t size, WorldCacheHeader_t* h) {
+    if (!image || !h || size < sizeof(uint32_t)) return -1;
+    uint32_t magic;
+    memcpy(&magic, image, sizeof(magic));
+    if (magic == WORLDCACHE_MAGIC_V1) {
+        WorldCacheHeaderV1_t v1;
+        if (size < sizeof(v1)) return -1;
+        memcpy(&v1, image, sizeof(v1));
+        header_from_v1(&v1, h);
+        return 0;
+    }
+    if (size < sizeof(*h)) return -1;
+    memcpy(h, image, sizeof(*h));
+    return 0;
+}
+
+int worldcache_header_read(FILE* f, WorldCacheHeader_t* h) {
+    if (!f || !h) return -1;
+    uint8_t buf[sizeof(WorldCacheHeader_t)];
+    if (fread(buf, sizeof(WorldCacheHeaderV1_t), 1, f) != 1) return -1;
+    uint32_t magic;
+    memcpy(&magic, buf, sizeof(magic));
+    /* the current header is the longer one */
+    if (magic != WORLDCACHE_MAGIC_V1 &&
+        fread(buf + sizeof(WorldCacheHeaderV1_t), sizeof(buf) - sizeof(WorldCacheHeaderV1_t), 1, f) != 1) {
+        return -1;
+    }
+    return worldcache_header_parse(buf, sizeof(buf), h);
+}
+
+int worldcache_header_store(const WorldCacheHeader_t* h, void* out) {
+    if (!h || !out) return -1;
+    if (!worldcache_header_is_v1(h)) {
+        memcpy(out, h, sizeof(*h));
+        return 0;
+    }
+    if (h->sp_size > UINT32_MAX || h->ap_size > UINT32_MAX || h->voiced_mask_size > UINT32_MAX) return -1;
+    WorldCacheHeaderV1_t v1;
+    v1.magic = h->magic;
+    v1.format_version = h->format_version;
+    v1.flags = h->flags;
+    v1.sample_rate = h->sample_rate;
+    v1.frame_period_ms = h->frame_period_ms;
+    v1.wav_hash = h->wav_hash;
+    v1.wav_mtime = h->wav_mtime;
+    v1.num_frames = h->num_frames;
+    v1.fft_size = h->fft_size;
+    v1.sp_size = (uint32_t)h->sp_size;
+    v1.ap_size = (uint32_t)h->ap_size;
+    v1.voiced_mask_size = (uint32_t)h->voiced_mask_size;
+    v1.wav_size = h->wav_size;
+    v1.wav_inode = h->wav_inode;
+    memcpy(out, &v1, sizeof(v1));
+    return 0;
+}
+
+int worldcache_header_write(FILE* f, const WorldCacheHeader_t* h) {
+    uint8_t buf[sizeof(WorldCacheHeader_t)];
+    if (!f || worldcache_header_store(h, buf) != 0) return -1;
+    size_t size = worldcache_header_disk_size(h);
+    return fwrite(buf, 1, size, f) == size ? 0 : -1;
+}
+
+/* Sections a first-layout header implies: the blocks back to back after the
+ * (padded) header, or the chunks up to the end of the image */
+static uint32_t v1_sections(const WorldCacheHeader_t* h, uint64_t size, WorldCacheSection_t* s) {
+    memset(s, 0, sizeof(*s) * 3);
+    if (worldcache_header_is_compressed(h)) {
+        s[0].type = WORLDCACHE_SECTION_CHUNKS;
+        s[0].codec = WORLDCACHE_CODEC_ZSTD;
+        s[0].offset = sizeof(WorldCacheHeaderV1_t);
+        s[0].size = size - s[0].offset;
+        return 1;
+    }
+    uint32_t codec = (h->flags & WORLDCACHE_FLAG_QUANTIZED) ? WORLDCACHE_CODEC_QUANTIZED : WORLDCACHE_CODEC_RAW;
+    const uint64_t sizes[3] = { h->sp_size, h->ap_size, h->voiced_mask_size };
+    uint64_t offset = worldcache_header_payload_offset(h);
+    for (int i = 0; i < 3; i++) {
+        s[i].type = (uint32_t)(WORLDCACHE_SECTION_SP + i);
+        s[i].codec = i < 2 ? codec : WORLDCACHE_CODEC_RAW;
+        s[i].offset = offset;
+        s[i].size = sizes[i];
+        offset += sizes[i];
+    }
+    return 3;
+}
+
+int worldcache_header_sections(const WorldCacheHeader_t* h, const void* table, uint64_t size,
+                               WorldCacheSection_t* sections, uint32_t* count) {
+    if (!h || !sections || !count || !worldcache_header_is_supported(h)) return -1;
+    if (worldcache_header_is_v1(h)) {
+        if (size < sizeof(WorldCacheHeaderV1_t)) return -1;
+        *count = v1_sections(h, size, sections);
+        return 0;
+    }
+    if (!table || h->section_count == 0 || h->section_count > WORLDCACHE_MAX_SECTIONS) return -1;
+    memcpy(sections, table, sizeof(*sections) * h->section_count);
+    /* in file order, aligned, after the table and inside the image */
+    uint64_t end = worldcache_sections_start(h->section_count);
+    for (uint32_t i = 0; i < h->section_count; i++) {
+        const WorldCacheSection_t* s = &sections[i];
+        if (s->offset % WORLDCACHE_SECTION_ALIGN != 0 || s->offset < end || s->offset > size ||
+            s->size > size - s->offset) {
+            return -1;
+        }
+        end = s->offset + s->size;
+    }
+    *count = h->section_count;
+    return 0;
+}
+
+int worldcache_image_sections(const uint8_t* image, size_t size, const WorldCacheHeader_t* h,
+                              WorldCacheSection_t* sections, uint32_t* count) {
+    if (!image || !h) return -1;
+    const uint8_t* table = NULL;
+    if (!worldcache_header_is_v1(h)) {
+        uint64_t table_end = sizeof(*h) + (uint64_t)h->section_count * sizeof(WorldCacheSection_t);
+        if (size < table_end) return -1;
+        table = image + sizeof(*h);
+    }
+    return worldcache_header_sections(h, table, size, sections, count);
+}
+
+const WorldCacheSection_t* worldcache_sections_find(const WorldCacheSection_t* sections, uint32_t count,
+                                                    uint32_t type) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (sections[i].type == type) return &sections[i];
+    }
+    return NULL;
+}
+
+uint64_t worldcache_sections_place(WorldCacheSection_t* sections, uint32_t count) {
+    uint64_t offset = worldcache_sections_start(count);
+    for (uint32_t i = 0; i < count; i++) {
+        sections[i].offset = offset;
+        offset = (offset + sections[i].size + WORLDCACHE_SECTION_ALIGN - 1) / WORLDCACHE_SECTION_ALIGN *
+                 WORLDCACHE_SECTION_ALIGN;
+    }
+    return count ? sections[count - 1].offset + sections[count - 1].size : offset;
+}
+
+int worldcache_image_verify(const uint8_t* image, size_t size) {
+    WorldCacheHeader_t h;
+    WorldCacheSection_t sections[WORLDCACHE_MAX_SECTIONS];
+    uint32_t count;
+    if (worldcache_header_parse(image, size, &h) != 0 ||
+        worldcache_image_sections(image, size, &h, sections, &count) != 0) {
+        return -1;
+    }
+    if (worldcache_header_is_v1(&h)) return 0;
+    for (uint32_t i = 0; i < count; i++) {
+        WorldCacheHash s;
+        worldcache_hash_init(&s);
+        worldcache_hash_update(&s, image + sections[i].offset, (size_t)sections[i].size);
+        if (worldcache_hash_final(&s) != sections[i].checksum) return -1;
+    }
+    return 0;
 }
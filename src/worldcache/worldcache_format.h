@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,43 +13,246 @@ extern "C" {
  * Fields:
  *  - magic: 4-bytes identifier
  *  - format_version: protocol version
- *  - flags: bitflags (e.g., compression)
+ *  - flags: bitflags (compression, value precision, coded representation,
+ *    F0 estimator)
  *  - sample_rate, frame_period_ms: doubles
- *  - wav_hash: simple 64-bit hash of source WAV (placeholder)
- *  - wav_mtime: file modification time (seconds since epoch)
+ *  - wav_hash: 64-bit content hash of the source WAV (worldcache_hash_file)
+ *  - wav_mtime: source modification time (nanoseconds since epoch)
+ *  - wav_size, wav_inode: rest of the source identity checked before the
+ *    hash (inode is 0 where the platform has none)
  *  - num_frames, fft_size: dims used by sp/ap
- *  - sp_size, ap_size, voiced_mask_size: sizes of subsequent data blocks in bytes
- */
+ *    (with WORLDCACHE_FLAG_CODED the sp block holds mel-cepstral frames and
+ *    the ap block band aperiodicity; their dims follow from the block sizes;
+ *    with WORLDCACHE_FLAG_QUANTIZED both hold quantized rows of
+ *    fft_size/2+1 bins, see worldcache_quant.h)
+ *  - sp_size, ap_size, voiced_mask_size: decoded sizes of the data blocks in
+ *    bytes (with WORLDCACHE_FLAG_F0_CONTOUR the voiced_mask block holds the
+ *    float64 F0 contour, 0 Hz marking unvoiced frames)
+ *  - section_count: entries of the section table that follows the header
+ *
+ * The header is followed by the section table and the sections, see
+ * WorldCacheSection_t. Files of the first layout ('WCH1') are still read:
+ * worldcache_header_read/parse convert their header to this one. */
 
 #pragma pack(push,1)
 typedef struct {
-    uint32_t magic;           /* 'WCH1' */
+    uint32_t magic;           /* 'WCH2' */
     uint16_t format_version;  /* format/protocol version */
     uint16_t flags;           /* bitflags: bit0 = compressed */
     double   sample_rate;     /* e.g., 44100.0 */
     double   frame_period_ms; /* hop size in ms */
-    uint64_t wav_hash;        /* simple content/hash placeholder */
-    uint64_t wav_mtime;       /* source file mtime */
+    uint64_t wav_hash;        /* source content hash */
+    uint64_t wav_mtime;       /* source file mtime, ns */
+    uint64_t wav_size;        /* source file size in bytes */
+    uint64_t wav_inode;       /* source file inode/file id */
     uint32_t num_frames;      /* number of frames */
     uint32_t fft_size;        /* fft size / num bins for sp */
-    uint32_t sp_size;         /* size in bytes of spectral block */
-    uint32_t ap_size;         /* size in bytes of aperiodicity block */
-    uint32_t voiced_mask_size;/* size in bytes of voiced mask block */
+    uint64_t sp_size;         /* size in bytes of spectral block */
+    uint64_t ap_size;         /* size in bytes of aperiodicity block */
+    uint64_t voiced_mask_size;/* size in bytes of the F0 block */
+    uint32_t section_count;   /* entries in the section table */
+    uint32_t reserved;        /* 0 */
 } WorldCacheHeader_t;
 #pragma pack(pop)
 
-/* magic value 'WCH1' little-endian */
-#define WORLDCACHE_MAGIC 0x31484357U
+/* magic value 'WCH2' little-endian */
+#define WORLDCACHE_MAGIC 0x32484357U
+
+/* current format_version; files with another version are rebuilt */
+#define WORLDCACHE_FORMAT_VERSION 3
+
+/* First layout ('WCH1', format_version 2): the payload follows a 76-byte
+ * header without a section table. Uncompressed files hold the sp, ap and F0
+ * blocks back to back from worldcache_header_payload_offset; compressed ones
+ * the chunk index right after the header, with F0 rows inside the chunks. */
+#pragma pack(push,1)
+typedef struct {
+    uint32_t magic;           /* 'WCH1' */
+    uint16_t format_version;  /* 2 */
+    uint16_t flags;
+    double   sample_rate;
+    double   frame_period_ms;
+    uint64_t wav_hash;
+    uint64_t wav_mtime;
+    uint32_t num_frames;
+    uint32_t fft_size;
+    uint32_t sp_size;
+    uint32_t ap_size;
+    uint32_t voiced_mask_size;
+    uint64_t wav_size;
+    uint64_t wav_inode;
+} WorldCacheHeaderV1_t;
+#pragma pack(pop)
+
+#define WORLDCACHE_MAGIC_V1 0x31484357U
+#define WORLDCACHE_FORMAT_VERSION_V1 2
+
+/* Section table entry. Every section starts at a multiple of
+ * WORLDCACHE_SECTION_ALIGN from the start of the cache image (the file, or
+ * the entry of a .worldpack), so mapped sections can be loaded with aligned
+ * SIMD loads. Uncompressed caches have SP, AP, F0 and TIME sections;
+ * compressed ones CHUNKS (sp and ap rows only), F0 and TIME. */
+#pragma pack(push,1)
+typedef struct {
+    uint32_t type;            /* WORLDCACHE_SECTION_* */
+    uint32_t codec;           /* WORLDCACHE_CODEC_* */
+    uint64_t offset;          /* from the start of the image */
+    uint64_t size;            /* stored bytes */
+    uint64_t checksum;        /* worldcache_hash of the stored bytes */
+} WorldCacheSection_t;
+#pragma pack(pop)
+
+#define WORLDCACHE_SECTION_ALIGN 64
+
+/* section types */
+#define WORLDCACHE_SECTION_SP     1 /* spectral envelope rows, frame-major */
+#define WORLDCACHE_SECTION_AP     2 /* aperiodicity rows, frame-major */
+#define WORLDCACHE_SECTION_F0     3 /* float64 F0 contour */
+#define WORLDCACHE_SECTION_TIME   4 /* float64 temporal positions (s) */
+#define WORLDCACHE_SECTION_CHUNKS 5 /* chunk index + zstd chunks of sp/ap rows */
+
+/* section codecs */
+#define WORLDCACHE_CODEC_RAW       0 /* values as the flags describe them */
+#define WORLDCACHE_CODEC_QUANTIZED 1 /* quantized rows (worldcache_quant.h) */
+#define WORLDCACHE_CODEC_ZSTD      2 /* chunked zstd frames (WorldCacheChunkIndex_t) */
+
+/* Most sections a cache has */
+#define WORLDCACHE_MAX_SECTIONS 8
 
 /* flag bits */
 #define WORLDCACHE_FLAG_COMPRESSED 0x1
+#define WORLDCACHE_FLAG_FLOAT32    0x2  /* sp/ap blocks hold float32 values, else float64 */
+#define WORLDCACHE_FLAG_CODED      0x4  /* sp/ap blocks hold WORLD-coded frames, else fft_size/2+1 bins */
+#define WORLDCACHE_FLAG_F0_MASK    0x18 /* bits 3-4: F0 estimator, one of WORLDCACHE_F0_* */
+#define WORLDCACHE_FLAG_F0_SHIFT   3
+#define WORLDCACHE_FLAG_F0_CONTOUR 0x20 /* voiced_mask block holds the float64 F0 contour */
+#define WORLDCACHE_FLAG_PADDED     0x40 /* first layout: payload starts on a WORLDCACHE_PAYLOAD_ALIGN boundary */
+#define WORLDCACHE_FLAG_CHUNKED    0x80 /* compressed payload is split into chunks (required with COMPRESSED) */
+#define WORLDCACHE_FLAG_DICT       0x100 /* chunks were compressed with a trained dictionary (worldcache_dict.h) */
+#define WORLDCACHE_FLAG_QUANTIZED  0x200 /* sp/ap blocks hold quantized rows (worldcache_quant.h), loaded as float32 */
+
+/* Payload alignment of padded first-layout caches: keeps every block
+ * aligned for its values when the file is memory-mapped */
+#define WORLDCACHE_PAYLOAD_ALIGN 64
+
+/* Compressed payloads are split into chunks of chunk_frames frames. Each
+ * chunk is one independent zstd frame holding the chunk's sp rows, then its
+ * ap rows (then, in the first layout, its F0 values), so a range of frames
+ * decodes without touching the other chunks. The CHUNKS section (the
+ * payload after a first-layout header) starts with the chunk index:
+ *   WorldCacheChunkIndex_t, then uint64_t chunk_end[chunk_count]
+ * chunk_end[i] is where chunk i's compressed bytes end, counted from the
+ * start of chunk 0 (right after the index). */
+#pragma pack(push,1)
+typedef struct {
+    uint32_t chunk_frames;    /* frames per chunk (the last one may be shorter) */
+    uint32_t chunk_count;     /* ceil(num_frames / chunk_frames) */
+} WorldCacheChunkIndex_t;
+#pragma pack(pop)
+
+/* Frames per chunk written by default (160 ms at the 5 ms frame period) */
+#define WORLDCACHE_CHUNK_FRAMES 32
+
+/* F0 estimators (same values as WorldF0Estimator) */
+#define WORLDCACHE_F0_HARVEST           0
+#define WORLDCACHE_F0_DIO_STONEMASK     1
+#define WORLDCACHE_F0_HARVEST_DECIMATED 2
 
 /* helpers */
 void worldcache_header_init(WorldCacheHeader_t* h);
 
+/* Whether h was read from a first-layout file */
+static inline int worldcache_header_is_v1(const WorldCacheHeader_t* h) { return h->magic == WORLDCACHE_MAGIC_V1; }
+
+/* Whether h is a layout this build reads (current or first) */
+static inline int worldcache_header_is_supported(const WorldCacheHeader_t* h) {
+    return (h->magic == WORLDCACHE_MAGIC && h->format_version == WORLDCACHE_FORMAT_VERSION) ||
+           (h->magic == WORLDCACHE_MAGIC_V1 && h->format_version == WORLDCACHE_FORMAT_VERSION_V1);
+}
+
+/* Bytes the header of h takes in its file */
+static inline size_t worldcache_header_disk_size(const WorldCacheHeader_t* h) {
+    return worldcache_header_is_v1(h) ? sizeof(WorldCacheHeaderV1_t) : sizeof(WorldCacheHeader_t);
+}
+
+/* Header at the start of size bytes of a cache image, either layout. Returns 0 on success. */
+int worldcache_header_parse(const void* image, size_t size, WorldCacheHeader_t* h);
+
+/* Read the header at the current position of f, either layout; f is left
+ * right after it. Returns 0 on success. */
+int worldcache_header_read(FILE* f, WorldCacheHeader_t* h);
+
+/* Store h in the layout it was read from (e.g. to refresh the source
+ * identity in place); out receives worldcache_header_disk_size(h) bytes.
+ * Returns 0 on success, -1 if a first-layout header no longer fits. */
+int worldcache_header_store(const WorldCacheHeader_t* h, void* out);
+
+/* worldcache_header_store into f at its current position */
+int worldcache_header_write(FILE* f, const WorldCacheHeader_t* h);
+
+/* Sections of the image h heads, in file order, into sections (room for
+ * WORLDCACHE_MAX_SECTIONS). table is the section table that follows a
+ * current-layout header; a first-layout header implies its sections (with
+ * no checksums) and needs none. size is the image size, UINT64_MAX if
+ * unknown. Sections are checked to be aligned, ordered and inside the
+ * image. Returns 0 on success. */
+int worldcache_header_sections(const WorldCacheHeader_t* h, const void* table, uint64_t size,
+                               WorldCacheSection_t* sections, uint32_t* count);
+
+/* worldcache_header_sections of the cache image at [image, image + size) */
+int worldcache_image_sections(const uint8_t* image, size_t size, const WorldCacheHeader_t* h,
+                              WorldCacheSection_t* sections, uint32_t* count);
+
+/* Section of the given type, or NULL */
+const WorldCacheSection_t* worldcache_sections_find(const WorldCacheSection_t* sections, uint32_t count,
+                                                    uint32_t type);
+
+/* Lay out count sections of a new image (sizes set) in order from
+ * worldcache_sections_start(count), each aligned. Returns the image size. */
+uint64_t worldcache_sections_place(WorldCacheSection_t* sections, uint32_t count);
+
+/* Check the checksums of every section of a cache image (first-layout
+ * images have none to check). Loads do not, so that mapped caches are not
+ * read in full. Returns 0 if all match. */
+int worldcache_image_verify(const uint8_t* image, size_t size);
+
+/* Offset of the first section of a current-layout image with count sections */
+static inline uint64_t worldcache_sections_start(uint32_t count) {
+    uint64_t end = sizeof(WorldCacheHeader_t) + (uint64_t)count * sizeof(WorldCacheSection_t);
+    return (end + WORLDCACHE_SECTION_ALIGN - 1) / WORLDCACHE_SECTION_ALIGN * WORLDCACHE_SECTION_ALIGN;
+}
+
 /* helper to test if header indicates compression */
 static inline int worldcache_header_is_compressed(const WorldCacheHeader_t* h) { return (h->flags & WORLDCACHE_FLAG_COMPRESSED) != 0; }
 
+/* size in bytes of one sp/ap value as stored in the payload (not for quantized blocks) */
+static inline size_t worldcache_header_value_size(const WorldCacheHeader_t* h) { return (h->flags & WORLDCACHE_FLAG_FLOAT32) ? sizeof(float) : sizeof(double); }
+
+/* helper to test if header indicates the coded sp/ap representation */
+static inline int worldcache_header_is_coded(const WorldCacheHeader_t* h) { return (h->flags & WORLDCACHE_FLAG_CODED) != 0; }
+
+/* F0 estimator recorded in the header; caches from different estimators must not be mixed */
+static inline unsigned worldcache_header_f0_estimator(const WorldCacheHeader_t* h) { return (h->flags & WORLDCACHE_FLAG_F0_MASK) >> WORLDCACHE_FLAG_F0_SHIFT; }
+static inline void worldcache_header_set_f0_estimator(WorldCacheHeader_t* h, unsigned estimator) {
+    h->flags = (uint16_t)((h->flags & ~WORLDCACHE_FLAG_F0_MASK) | ((estimator << WORLDCACHE_FLAG_F0_SHIFT) & WORLDCACHE_FLAG_F0_MASK));
+}
+
+/* offset of the sp block in an uncompressed first-layout file (the chunk index of a compressed one follows the header) */
+static inline size_t worldcache_header_payload_offset(const WorldCacheHeader_t* h) {
+    const size_t padded = (sizeof(WorldCacheHeaderV1_t) + WORLDCACHE_PAYLOAD_ALIGN - 1) / WORLDCACHE_PAYLOAD_ALIGN * WORLDCACHE_PAYLOAD_ALIGN;
+    return ((h->flags & WORLDCACHE_FLAG_PADDED) && !worldcache_header_is_compressed(h)) ? padded : sizeof(WorldCacheHeaderV1_t);
+}
+
+/* Payload blocks in each compressed chunk: sp, ap and (first layout only) F0 */
+static inline int worldcache_header_chunk_blocks(const WorldCacheHeader_t* h) { return worldcache_header_is_v1(h) ? 3 : 2; }
+
+/* values per frame in an sp/ap block of block_size bytes (0 if inconsistent) */
+static inline uint32_t worldcache_header_frame_dims(const WorldCacheHeader_t* h, uint64_t block_size) {
+    uint64_t frame_bytes = (uint64_t)h->num_frames * worldcache_header_value_size(h);
+    if (frame_bytes == 0 || block_size % frame_bytes != 0 || block_size / frame_bytes > UINT32_MAX) return 0;
+    return (uint32_t)(block_size / frame_bytes);
+}
+
 #ifdef __cplusplus
 }
 #endif
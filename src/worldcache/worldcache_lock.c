@@ -0,0 +1,110 @@
+#include "worldcache_lock.h"
+#include "worldx_thread.h"
+#include <stdio.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+/* Windows locks this byte range, far past any WAV's end */
+#define LOCK_OFFSET_HIGH 0x7FFFFFFFu
+
+static worldx_atomic_t g_temp_serial = 0;
+
+int worldcache_temp_path(const char* path, char* out, size_t size) {
+    if (!path || !out) return -1;
+#if defined(_WIN32)
+    unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    long serial = worldx_atomic_inc(&g_temp_serial);
+    int n = snprintf(out, size, "%s.%lu-%ld.tmp", path, pid, serial);
+    return n < 0 || (size_t)n >= size ? -1 : 0;
+}
+
+int worldcache_replace_file(const char* tmp_path, const char* path) {
+    if (!tmp_path || !path) return -1;
+#if defined(_WIN32)
+    return MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(tmp_path, path) == 0 ? 0 : -1;
+#endif
+}
+
+#if defined(_WIN32)
+static int lock_file(const char* path, WorldCacheLock* lock, DWORD flags) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    OVERLAPPED range;
+    ZeroMemory(&range, sizeof(range));
+    range.OffsetHigh = LOCK_OFFSET_HIGH;
+    if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | flags, 0, 1, 0, &range)) {
+        int busy = GetLastError() == ERROR_LOCK_VIOLATION;
+        CloseHandle(file);
+        return busy ? 1 : -1;
+    }
+    lock->handle = file;
+    return 0;
+}
+
+int worldcache_lock_acquire(const char* path, WorldCacheLock* lock) {
+    if (!path || !lock) return -1;
+    return lock_file(path, lock, 0) == 0 ? 0 : -1;
+}
+
+int worldcache_lock_try(const char* path, WorldCacheLock* lock) {
+    if (!path || !lock) return -1;
+    return lock_file(path, lock, LOCKFILE_FAIL_IMMEDIATELY);
+}
+
+void worldcache_lock_release(WorldCacheLock* lock) {
+    if (!lock || !lock->handle) return;
+    OVERLAPPED range;
+    ZeroMemory(&range, sizeof(range));
+    range.OffsetHigh = LOCK_OFFSET_HIGH;
+    UnlockFileEx((HANDLE)lock->handle, 0, 1, 0, &range);
+    CloseHandle((HANDLE)lock->handle);
+    lock->handle = NULL;
+}
+#else
+static int lock_file(const char* path, WorldCacheLock* lock, int operation) {
+    /* flock locks belong to the open file description, so closing other
+     * descriptors of the same file (reading the WAV) keeps it held */
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int rc;
+    do {
+        rc = flock(fd, operation);
+    } while (rc != 0 && errno == EINTR);
+    if (rc != 0) {
+        int busy = errno == EWOULDBLOCK;
+        close(fd);
+        return busy ? 1 : -1;
+    }
+    lock->fd = fd;
+    return 0;
+}
+
+int worldcache_lock_acquire(const char* path, WorldCacheLock* lock) {
+    if (!path || !lock) return -1;
+    return lock_file(path, lock, LOCK_EX) == 0 ? 0 : -1;
+}
+
+int worldcache_lock_try(const char* path, WorldCacheLock* lock) {
+    if (!path || !lock) return -1;
+    return lock_file(path, lock, LOCK_EX | LOCK_NB);
+}
+
+void worldcache_lock_release(WorldCacheLock* lock) {
+    if (!lock || lock->fd < 0) return;
+    flock(lock->fd, LOCK_UN);
+    close(lock->fd);
+    lock->fd = -1;
+}
+#endif
@@ -0,0 +1,54 @@
+#ifndef WORLDCACHE_LOCK_H
+#define WORLDCACHE_LOCK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cache files shared between processes.
+ *
+ * Resampler hosts run many processes at once, often on the same sample.
+ * Cache files are therefore never written in place: they are written under
+ * a temporary name next to the target and renamed over it, so a reader sees
+ * the old file or the new one, never a torn one (and mappings of the old one
+ * stay valid). Rebuilding a sample's cache is single-flight: the builder
+ * holds an advisory lock on the source WAV, and the others wait on it and
+ * then load what it wrote. */
+
+/* Unique temporary path beside path (per process and call). Returns 0 on
+ * success, -1 if it does not fit in size. */
+int worldcache_temp_path(const char* path, char* out, size_t size);
+
+/* Atomically replace path with tmp_path. Returns 0 on success; tmp_path is
+ * left for the caller to remove on failure. */
+int worldcache_replace_file(const char* tmp_path, const char* path);
+
+/* Exclusive advisory lock on a source file, held by an open handle of it:
+ * flock() on POSIX, a byte range past the end of the file with LockFileEx on
+ * Windows (readers of the file are not blocked). Threads of one process
+ * exclude each other too. The lock goes away with the process. */
+typedef struct {
+#if defined(_WIN32)
+    void* handle;
+#else
+    int fd;
+#endif
+} WorldCacheLock;
+
+/* Block until the lock on path is held. Returns 0 on success, -1 if the
+ * file cannot be opened or locked (callers then go ahead unlocked). */
+int worldcache_lock_acquire(const char* path, WorldCacheLock* lock);
+
+/* Take the lock only if it is free: 0 when held, 1 when another holder has
+ * it, -1 on failure */
+int worldcache_lock_try(const char* path, WorldCacheLock* lock);
+
+void worldcache_lock_release(WorldCacheLock* lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_LOCK_H */
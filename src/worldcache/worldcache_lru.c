@@ -0,0 +1,320 @@
+#include "worldcache_lru.h"
+#include "worldcache_manager.h"
+#include "worldcache_source.h"
+#include "worldx_thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum { ENTRY_LOADING, ENTRY_READY, ENTRY_FAILED } EntryState;
+
+struct WorldCacheHandle {
+    WorldCacheLru* lru;
+    char* path;
+    uint64_t hash;
+    WorldAnalysisData data;
+    WorldCacheSourceId source;  /* WAV identity when loaded */
+    size_t bytes;
+    long refs;                  /* handles out, including waiters on a load */
+    EntryState state;
+    int in_table;
+    struct WorldCacheHandle* chain;       /* hash bucket chain */
+    struct WorldCacheHandle *prev, *next; /* recency list, ready entries only */
+};
+
+struct WorldCacheLru {
+    worldx_mutex_t lock;
+    worldx_cond_t loaded;
+    WorldCacheHandle** buckets;
+    size_t bucket_count;         /* power of two */
+    WorldCacheHandle* head;      /* most recently used */
+    WorldCacheHandle* tail;      /* least recently used */
+    size_t entries, bytes, budget, handles;
+    uint64_t hits, misses, evictions;
+    int destroyed;
+};
+
+static uint64_t path_hash(const char* path) {
+    WorldCacheHash s;
+    worldcache_hash_init(&s);
+    worldcache_hash_update(&s, path, strlen(path));
+    return worldcache_hash_final(&s);
+}
+
+/* Approximate heap (or mapped) footprint of an analysis */
+static size_t analysis_bytes(const WorldAnalysisData* d) {
+    size_t frames = d->f0_length > 0 ? (size_t)d->f0_length : 0;
+    size_t bytes = frames * sizeof(double) * 2; /* f0 + temporal positions */
+    if (world_analysis_data_is_coded(d)) {
+        size_t dims = (size_t)(d->coded_sp_dims + d->coded_ap_dims);
+        bytes += frames * (dims * sizeof(double) + 2 * sizeof(void*));
+    } else {
+        size_t value = d->precision == WORLD_PRECISION_FLOAT32 ? sizeof(float) : sizeof(double);
+        bytes += 2 * frames * ((size_t)(d->fft_size / 2 + 1) * value + sizeof(void*));
+    }
+    return bytes;
+}
+
+static void entry_free(WorldCacheHandle* e) {
+    world_analysis_data_free(&e->data);
+    free(e->path);
+    free(e);
+}
+
+static void list_unlink(WorldCacheLru* lru, WorldCacheHandle* e) {
+    if (e->prev) e->prev->next = e->next; else lru->head = e->next;
+    if (e->next) e->next->prev = e->prev; else lru->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void list_push_front(WorldCacheLru* lru, WorldCacheHandle* e) {
+    e->prev = NULL;
+    e->next = lru->head;
+    if (lru->head) lru->head->prev = e; else lru->tail = e;
+    lru->head = e;
+}
+
+static WorldCacheHandle* table_find(WorldCacheLru* lru, const char* path, uint64_t hash) {
+    for (WorldCacheHandle* e = lru->buckets[hash & (lru->bucket_count - 1)]; e; e = e->chain) {
+        if (e->hash == hash && strcmp(e->path, path) == 0) return e;
+    }
+    return NULL;
+}
+
+/* Double the table when it gets full; failure just keeps longer chains */
+static void table_grow(WorldCacheLru* lru) {
+    if (lru->entries < lru->bucket_count) return;
+    size_t count = lru->bucket_count * 2;
+    WorldCacheHandle** buckets = (WorldCacheHandle**)calloc(count, sizeof(*buckets));
+    if (!buckets) return;
+    for (size_t i = 0; i < lru->bucket_count; i++) {
+        WorldCacheHandle* e = lru->buckets[i];
+        while (e) {
+            WorldCacheHandle* next = e->chain;
+            size_t b = e->hash & (count - 1);
+            e->chain = buckets[b];
+            buckets[b] = e;
+            e = next;
+        }
+    }
+    free(lru->buckets);
+    lru->buckets = buckets;
+    lru->bucket_count = count;
+}
+
+static void table_insert(WorldCacheLru* lru, WorldCacheHandle* e) {
+    table_grow(lru);
+    size_t b = e->hash & (lru->bucket_count - 1);
+    e->chain = lru->buckets[b];
+    lru->buckets[b] = e;
+    e->in_table = 1;
+    lru->entries++;
+}
+
+/* Take e out of the cache; it is freed now or by its last release */
+static void entry_remove(WorldCacheLru* lru, WorldCacheHandle* e) {
+    WorldCacheHandle** link = &lru->buckets[e->hash & (lru->bucket_count - 1)];
+    while (*link != e) link = &(*link)->chain;
+    *link = e->chain;
+    e->chain = NULL;
+    e->in_table = 0;
+    lru->entries--;
+    if (e->state == ENTRY_READY) {
+        list_unlink(lru, e);
+        lru->bytes -= e->bytes;
+    }
+    if (e->refs == 0) entry_free(e);
+}
+
+/* Evict unreferenced entries, oldest first, until within budget */
+static void evict(WorldCacheLru* lru) {
+    WorldCacheHandle* e = lru->tail;
+    while (e && lru->bytes > lru->budget) {
+        WorldCacheHandle* prev = e->prev;
+        if (e->refs == 0) {
+            entry_remove(lru, e);
+            lru->evictions++;
+        }
+        e = prev;
+    }
+}
+
+static void lru_free(WorldCacheLru* lru) {
+    worldx_cond_destroy(&lru->loaded);
+    worldx_mutex_destroy(&lru->lock);
+    free(lru->buckets);
+    free(lru);
+}
+
+int worldcache_lru_create(size_t byte_budget, WorldCacheLru** out_lru) {
+    if (!out_lru) return -1;
+    *out_lru = NULL;
+    WorldCacheLru* lru = (WorldCacheLru*)calloc(1, sizeof(*lru));
+    if (!lru) return -1;
+    lru->bucket_count = 64;
+    lru->buckets = (WorldCacheHandle**)calloc(lru->bucket_count, sizeof(*lru->buckets));
+    lru->budget = byte_budget;
+    if (!lru->buckets) {
+        free(lru);
+        return -1;
+    }
+    if (worldx_mutex_init(&lru->lock) != 0) {
+        free(lru->buckets);
+        free(lru);
+        return -1;
+    }
+    if (worldx_cond_init(&lru->loaded) != 0) {
+        worldx_mutex_destroy(&lru->lock);
+        free(lru->buckets);
+        free(lru);
+        return -1;
+    }
+    *out_lru = lru;
+    return 0;
+}
+
+void worldcache_lru_destroy(WorldCacheLru* lru) {
+    if (!lru) return;
+    worldx_mutex_lock(&lru->lock);
+    lru->destroyed = 1;
+    for (size_t i = 0; i < lru->bucket_count; i++) {
+        while (lru->buckets[i]) entry_remove(lru, lru->buckets[i]);
+    }
+    int last = lru->handles == 0;
+    worldx_mutex_unlock(&lru->lock);
+    if (last) lru_free(lru);
+}
+
+void worldcache_lru_set_budget(WorldCacheLru* lru, size_t byte_budget) {
+    if (!lru) return;
+    worldx_mutex_lock(&lru->lock);
+    lru->budget = byte_budget;
+    evict(lru);
+    worldx_mutex_unlock(&lru->lock);
+}
+
+/* Drop one reference to e with the lock held */
+static void entry_unref(WorldCacheLru* lru, WorldCacheHandle* e) {
+    lru->handles--;
+    if (--e->refs > 0) return;
+    if (!e->in_table) {
+        entry_free(e);
+    } else if (lru->bytes > lru->budget) {
+        evict(lru);
+    }
+}
+
+int worldcache_lru_acquire(WorldCacheLru* lru, const char* wav_path, WorldCacheHandle** out_handle) {
+    if (!lru || !wav_path || !out_handle) return -1;
+    *out_handle = NULL;
+    uint64_t hash = path_hash(wav_path);
+    WorldCacheSourceId id;
+    int identified = worldcache_source_identify(wav_path, &id) == 0;
+
+    worldx_mutex_lock(&lru->lock);
+    if (lru->destroyed) {
+        worldx_mutex_unlock(&lru->lock);
+        return -1;
+    }
+    WorldCacheHandle* e = table_find(lru, wav_path, hash);
+    if (e && e->state == ENTRY_READY &&
+        (!identified || memcmp(&e->source, &id, sizeof(id)) != 0)) {
+        entry_remove(lru, e); /* WAV changed or vanished since loading */
+        e = NULL;
+    }
+    if (!identified) {
+        lru->misses++;
+        worldx_mutex_unlock(&lru->lock);
+        return -1;
+    }
+
+    if (e) {
+        e->refs++;
+        lru->handles++;
+        while (e->state == ENTRY_LOADING) worldx_cond_wait(&lru->loaded, &lru->lock);
+        if (e->state == ENTRY_FAILED) {
+            entry_unref(lru, e);
+            worldx_mutex_unlock(&lru->lock);
+            return -1;
+        }
+        lru->hits++;
+        if (e->in_table) {
+            list_unlink(lru, e);
+            list_push_front(lru, e);
+        }
+        worldx_mutex_unlock(&lru->lock);
+        *out_handle = e;
+        return 0;
+    }
+
+    /* miss: publish a loading entry so concurrent lookups wait for this load */
+    lru->misses++;
+    e = (WorldCacheHandle*)calloc(1, sizeof(*e));
+    size_t len = strlen(wav_path);
+    char* path = (char*)malloc(len + 1);
+    if (!e || !path) {
+        free(e);
+        free(path);
+        worldx_mutex_unlock(&lru->lock);
+        return -1;
+    }
+    memcpy(path, wav_path, len + 1);
+    e->lru = lru;
+    e->path = path;
+    e->hash = hash;
+    e->source = id;
+    e->refs = 1;
+    e->state = ENTRY_LOADING;
+    world_analysis_data_init(&e->data);
+    lru->handles++;
+    table_insert(lru, e);
+    worldx_mutex_unlock(&lru->lock);
+
+    int result = worldcache_get_analysis(wav_path, &e->data);
+
+    worldx_mutex_lock(&lru->lock);
+    if (result == 0) {
+        e->state = ENTRY_READY;
+        e->bytes = analysis_bytes(&e->data);
+        if (e->in_table) {
+            list_push_front(lru, e);
+            lru->bytes += e->bytes;
+            evict(lru);
+        }
+    } else {
+        e->state = ENTRY_FAILED;
+        if (e->in_table) entry_remove(lru, e);
+    }
+    worldx_cond_broadcast(&lru->loaded);
+    if (result != 0) entry_unref(lru, e);
+    worldx_mutex_unlock(&lru->lock);
+    if (result != 0) return -1;
+    *out_handle = e;
+    return 0;
+}
+
+const WorldAnalysisData* worldcache_handle_data(const WorldCacheHandle* handle) {
+    return handle ? &handle->data : NULL;
+}
+
+void worldcache_lru_release(WorldCacheHandle* handle) {
+    if (!handle) return;
+    WorldCacheLru* lru = handle->lru;
+    worldx_mutex_lock(&lru->lock);
+    entry_unref(lru, handle);
+    int last = lru->destroyed && lru->handles == 0;
+    worldx_mutex_unlock(&lru->lock);
+    if (last) lru_free(lru);
+}
+
+void worldcache_lru_stats(WorldCacheLru* lru, WorldCacheLruStats* out_stats) {
+    if (!lru || !out_stats) return;
+    worldx_mutex_lock(&lru->lock);
+    out_stats->hits = lru->hits;
+    out_stats->misses = lru->misses;
+    out_stats->evictions = lru->evictions;
+    out_stats->entries = lru->entries;
+    out_stats->bytes = lru->bytes;
+    out_stats->budget = lru->budget;
+    out_stats->handles = lru->handles;
+    worldx_mutex_unlock(&lru->lock);
+}
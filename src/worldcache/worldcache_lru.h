@@ -0,0 +1,65 @@
+#ifndef WORLDCACHE_LRU_H
+#define WORLDCACHE_LRU_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "world_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* In-process analysis cache for long-lived users (UCRA engine, batch
+ * renders): analyses loaded through worldcache_get_analysis stay in memory,
+ * least recently used first out once their total size exceeds the byte
+ * budget.
+ *
+ * Entries are keyed by WAV path (the manager analyzes with one fixed set of
+ * parameters) and remember the WAV's stat identity; a lookup whose WAV
+ * changed since loading reloads it. Lookups return refcounted handles:
+ * eviction only drops entries nobody holds, so a handle's data stays valid
+ * until it is released. Concurrent misses on one path load it once, the
+ * other callers wait for that load. All functions are thread-safe. */
+
+typedef struct WorldCacheLru WorldCacheLru;
+typedef struct WorldCacheHandle WorldCacheHandle;
+
+typedef struct {
+    uint64_t hits;       /* lookups served from memory */
+    uint64_t misses;     /* lookups that went to the manager (disk or analysis) */
+    uint64_t evictions;  /* entries dropped to stay within the budget */
+    size_t entries;      /* resident entries */
+    size_t bytes;        /* approximate size of the resident entries */
+    size_t budget;       /* byte budget */
+    size_t handles;      /* handles not yet released */
+} WorldCacheLruStats;
+
+/* Create a cache holding up to byte_budget bytes of unreferenced analyses.
+ * Returns 0 on success. */
+int worldcache_lru_create(size_t byte_budget, WorldCacheLru** out_lru);
+
+/* Drop every entry. Handles still held stay valid; the cache itself is
+ * freed with the last of them. */
+void worldcache_lru_destroy(WorldCacheLru* lru);
+
+/* Change the budget, evicting as needed */
+void worldcache_lru_set_budget(WorldCacheLru* lru, size_t byte_budget);
+
+/* Look up the analysis of wav_path, loading it with worldcache_get_analysis
+ * on a miss. Returns 0 and a handle on success. */
+int worldcache_lru_acquire(WorldCacheLru* lru, const char* wav_path, WorldCacheHandle** out_handle);
+
+/* Analysis behind a handle; shared, so read-only */
+const WorldAnalysisData* worldcache_handle_data(const WorldCacheHandle* handle);
+
+/* Give back a handle from worldcache_lru_acquire; NULL is ignored */
+void worldcache_lru_release(WorldCacheHandle* handle);
+
+/* Snapshot of the counters */
+void worldcache_lru_stats(WorldCacheLru* lru, WorldCacheLruStats* out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_LRU_H */
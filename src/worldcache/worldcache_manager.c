@@ -1,145 +1,327 @@
 #include "worldcache_manager.h"
-#include "worldcache_serialize.h"
+#include "worldcache_dict.h"
+#include "worldcache_lock.h"
+#include "worldcache_pack.h"
+#include "worldcache_quant.h"
+#include "worldcache_writer.h"
+#include "wav_io.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
-#include <time.h>
 
-/* Simple 64-bit rolling hash for file content - placeholder for OTO hash */
-static uint64_t simple_file_hash(const char* path) {
-    FILE* f = fopen(path, "rb");
+/* F0 estimator the manager analyzes with; caches made with another are stale */
+#define WORLDCACHE_MANAGER_F0 WORLDCACHE_F0_HARVEST
+
+WorldCacheSourceStatus worldcache_check_header(WorldCacheHeader_t* h, const char* wav_path) {
+    if (!h || !worldcache_header_is_supported(h) ||
+        !(h->flags & WORLDCACHE_FLAG_F0_CONTOUR) ||
+        (worldcache_header_is_compressed(h) && !(h->flags & WORLDCACHE_FLAG_CHUNKED)) ||
+        worldcache_header_f0_estimator(h) != WORLDCACHE_MANAGER_F0) {
+        return WORLDCACHE_SOURCE_STALE;
+    }
+    return worldcache_source_check(h, wav_path);
+}
+
+/* Whether a sidecar header describes the current WAV and the manager's
+ * analysis. The WAV is only hashed when its identity changed at the same
+ * size; a matching hash leaves the refreshed identity in h and sets
+ * *rehashed (when given). The header is not patched in place: another
+ * process may have renamed a new sidecar over the one that was checked,
+ * so get_analysis rewrites a rehashed sidecar whole instead. */
+static int header_is_current(WorldCacheHeader_t* h, const char* wav_path, int* rehashed) {
+    WorldCacheSourceStatus status = worldcache_check_header(h, wav_path);
+    if (rehashed) *rehashed = status == WORLDCACHE_SOURCE_REHASHED;
+    return status != WORLDCACHE_SOURCE_STALE;
+}
+
+/* Serve wav_path from the voicebank pack. Returns 1 when loaded, 0 when
+ * there is no pack or no current entry. */
+static int load_packed(const char* wav_path, WorldAnalysisData* out, WorldCacheLoadInfo* info) {
+    WorldPack* pack = NULL;
+    char key[4096];
+    if (worldpack_locate(wav_path, &pack, key, sizeof(key)) != 0) return 0;
+
+    int result = 0;
+    const WorldPackEntry_t* e = worldpack_find(pack, key);
+    if (e) {
+        WorldCacheHeader_t h;
+        worldpack_entry_header(pack, e, &h);
+        /* a rehashed entry keeps its old identity: other processes map the
+         * pack, so it is only rewritten whole, by `ucra-cli pack update` */
+        if (worldcache_check_header(&h, wav_path) != WORLDCACHE_SOURCE_STALE &&
+            worldpack_load(pack, e, out, info) == 0) {
+            result = 1;
+        }
+    }
+    /* out holds its own reference on a mapped load */
+    worldpack_close(pack);
+    return result;
+}
+
+/* Map the cache and attach out_data to it. Returns 1 when loaded, 0 when
+ * the cache should be read instead (no mapping, compressed or unpadded
+ * payload; *current tells whether its header, left in h, was already
+ * validated), -1 when it is stale. */
+static int load_mapped(const char* cache_path, const char* wav_path, WorldAnalysisData* out,
+                       WorldCacheLoadInfo* info, WorldCacheHeader_t* h, int* current, int* rehashed) {
+    *current = 0;
+    WorldCacheMapping* m = NULL;
+    if (worldcache_mapping_open(cache_path, &m) != 0) return 0;
+
+    int result = -1;
+    if (worldcache_header_parse(worldcache_mapping_data(m), worldcache_mapping_size(m), h) == 0) {
+        if (header_is_current(h, wav_path, rehashed)) {
+            *current = 1;
+            result = worldcache_attach_analysis(m, out, info) == 0 ? 1 : 0;
+        }
+    }
+    /* out holds its own reference on success */
+    worldcache_mapping_release(m);
+    return result;
+}
+
+/* Load the sidecar, mapped when possible. Returns 1 when loaded, 0 when
+ * there is no current, readable sidecar. *rehashed (when given) tells
+ * whether the WAV had to be hashed, h then holding its refreshed identity. */
+static int load_sidecar(const char* cache_path, const char* wav_path, WorldAnalysisData* out,
+                        WorldCacheLoadInfo* info, WorldCacheHeader_t* h, int* rehashed) {
+    int current = 0;
+    int load = load_mapped(cache_path, wav_path, out, info, h, &current, rehashed);
+    if (load != 0) return load > 0;
+    FILE* f = fopen(cache_path, "rb");
     if (!f) return 0;
-    uint64_t h = 1469598103934665603ULL;
-    int c;
-    while ((c = fgetc(f)) != EOF) {
-        h ^= (uint64_t)c;
-        h *= 1099511628211ULL;
+    WorldCacheHeader_t read_h;
+    int readable = worldcache_header_read(f, &read_h) == 0;
+    /* a header the mapping validated is already in h */
+    if (readable && !current) {
+        *h = read_h;
+        readable = header_is_current(h, wav_path, rehashed);
     }
+    if (readable && (h->flags & WORLDCACHE_FLAG_DICT)) worldcache_dict_locate(wav_path);
+    load = readable && worldcache_read_analysis(f, h, out, info) == 0;
     fclose(f);
-    return h;
-}
-
-static uint64_t get_file_mtime(const char* path) {
-    struct stat st;
-    if (stat(path, &st) != 0) return 0;
-    return (uint64_t)st.st_mtime;
-}
-
-/* Placeholder analysis: creates small dummy arrays based on wav_path length */
-static int world_analyze_wav_stub(const char* wav_path, WORLD_AnalysisData* out) {
-    if (!out) return -1;
-    out->sample_rate = 44100.0;
-    out->frame_period_ms = 5.0;
-    out->num_frames = 10;
-    out->fft_size = 512;
-    out->sp = malloc( (size_t)out->num_frames * out->fft_size * sizeof(float) ); /* pretend */
-    out->ap = malloc((size_t)out->num_frames * 2);
-    out->voiced_mask = malloc((size_t)out->num_frames);
-    if (!out->sp || !out->ap || !out->voiced_mask) { worldcache_free_analysis(out); return -1; }
-    memset(out->sp, 1, (size_t)out->num_frames * out->fft_size * sizeof(float));
-    memset(out->ap, 2, (size_t)out->num_frames * 2);
-    memset(out->voiced_mask, 3, (size_t)out->num_frames);
+    return load;
+}
+
+/* Replace the sidecar with data analyzed from wav_path, whose identity
+ * before the read is in source (NULL stamps the WAV as it is now). Returns
+ * 0 on success, -1 also when the WAV changed after source was taken. */
+static int write_sidecar(const char* cache_path, const char* wav_path, const WorldAnalysisData* data,
+                         const WorldCacheHeader_t* source, WorldCacheHeader_t* out_h) {
+    WorldCacheHeader_t h;
+    if (worldcache_make_header(&h, wav_path, data, source) != 0) return -1;
+
+    /* Compressed sidecars use the voicebank's dictionary when it has one */
+    WorldCacheCompression opts = { 0, NULL };
+    if (worldcache_header_is_compressed(&h)) opts.dict = worldcache_dict_locate(wav_path);
+
+    /* Never write in place: earlier hits may still map the old file, and
+     * other processes may be reading it */
+    char tmp_path[4096];
+    if (worldcache_temp_path(cache_path, tmp_path, sizeof(tmp_path)) != 0) return -1;
+    FILE* wf = fopen(tmp_path, "wb");
+    if (!wf) return -1;
+    int written = worldcache_write_analysis_ex(wf, &h, data, &opts);
+    /* the WAV may have changed while the payload was written */
+    if (fclose(wf) != 0 || written != 0 || worldcache_source_check(&h, wav_path) == WORLDCACHE_SOURCE_STALE ||
+        worldcache_replace_file(tmp_path, cache_path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    if (out_h) *out_h = h;
     return 0;
 }
 
-int worldcache_get_analysis(const char* wav_path, WORLD_AnalysisData* out_data) {
+/* Lock wav_path for rebuilding its cache, noting in *waited whether
+ * another holder had to finish first. Returns 0 when held, -1 when locking
+ * is not possible (the caller rebuilds unlocked). */
+static int lock_source(const char* wav_path, WorldCacheLock* lock, int* waited) {
+    int status = worldcache_lock_try(wav_path, lock);
+    *waited = status == 1;
+    if (status == 1) status = worldcache_lock_acquire(wav_path, lock);
+    return status == 0 ? 0 : -1;
+}
+
+int worldcache_analyze(const char* wav_path, WorldAnalysisData* out_data) {
+    return worldcache_analyze_source(wav_path, out_data, NULL);
+}
+
+int worldcache_analyze_source(const char* wav_path, WorldAnalysisData* out_data, WorldCacheHeader_t* source) {
+    double* x = NULL;
+    int x_length = 0, fs = 0;
+    if (!wav_path || !out_data) return -1;
+    /* identity and hash of what is about to be read, not of what is there at write time */
+    if (source && worldcache_source_stamp(source, wav_path) != 0) return -1;
+    if (wav_read_mono(wav_path, &x, &x_length, &fs) != 0) return -1;
+
+    WorldAnalysisOptions options;
+    world_analysis_options_init(&options);
+    options.f0_estimator = (WorldF0Estimator)WORLDCACHE_MANAGER_F0;
+    int result = world_analyze(x, x_length, fs, &options, out_data);
+    free(x);
+    return result;
+}
+
+/* Take the source identity of source into h, if the WAV still matches it */
+static int apply_source(WorldCacheHeader_t* h, const WorldCacheHeader_t* source, const char* wav_path) {
+    h->wav_size = source->wav_size;
+    h->wav_mtime = source->wav_mtime;
+    h->wav_inode = source->wav_inode;
+    h->wav_hash = source->wav_hash;
+    return worldcache_source_check(h, wav_path) == WORLDCACHE_SOURCE_STALE ? -1 : 0;
+}
+
+int worldcache_make_header(WorldCacheHeader_t* h, const char* wav_path, const WorldAnalysisData* data,
+                           const WorldCacheHeader_t* source) {
+    if (!h) return -1;
+    worldcache_header_init(h);
+    /* sp/ap are quantized once the codec passed its check (worldcache_set_quantized) */
+    if (worldcache_quantized()) h->flags |= WORLDCACHE_FLAG_QUANTIZED;
+    if (worldcache_header_from_analysis(h, data) != 0 ||
+        (source ? apply_source(h, source, wav_path) : worldcache_source_stamp(h, wav_path)) != 0) {
+        return -1;
+    }
+#if defined(USE_ZSTD)
+    /* Enable compression when library support is compiled in */
+    h->flags |= WORLDCACHE_FLAG_COMPRESSED | WORLDCACHE_FLAG_CHUNKED;
+#endif
+    return 0;
+}
+
+int worldcache_get_analysis(const char* wav_path, WorldAnalysisData* out_data) {
+    return worldcache_get_analysis_ex(wav_path, out_data, NULL);
+}
+
+int worldcache_get_analysis_ex(const char* wav_path, WorldAnalysisData* out_data,
+                               WorldCacheLoadInfo* info) {
+    WorldCacheLoadInfo local;
+    if (!info) info = &local;
+    memset(info, 0, sizeof(*info));
     if (!wav_path || !out_data) return -1;
     char cache_path[4096];
     snprintf(cache_path, sizeof(cache_path), "%s.worldcache", wav_path);
 
-    /* If cache exists and is valid, load it. If it's stale, remove it. */
-    {
-        FILE* f = fopen(cache_path, "rb");
-        if (f) {
-            WorldCacheHeader_t h;
-            if (fread(&h, sizeof(h), 1, f) == 1) {
-                uint64_t mtime = get_file_mtime(wav_path);
-                uint64_t h_mtime = h.wav_mtime;
-                uint64_t h_hash = h.wav_hash;
-                uint64_t cur_hash = simple_file_hash(wav_path);
-                if (h_mtime == mtime && h_hash == cur_hash) {
-                    /* cache valid - read entire file to buffer and deserialize */
-                    fseek(f, 0, SEEK_END);
-                    long fsz = ftell(f);
-                    fseek(f, 0, SEEK_SET);
-                    if (fsz > (long)sizeof(WorldCacheHeader_t)) {
-                        size_t full_sz = (size_t)fsz;
-                        uint8_t* full = (uint8_t*)malloc(full_sz);
-                        if (full && fread(full, 1, full_sz, f) == full_sz) {
-                            fclose(f);
-                            uint8_t *sp=NULL,*ap=NULL,*vm=NULL;
-                            WorldCacheHeader_t rh; /* read header */
-                            if (worldcache_deserialize(full, full_sz, &rh, &sp, &ap, &vm) == 0) {
-                                out_data->sample_rate = rh.sample_rate;
-                                out_data->frame_period_ms = rh.frame_period_ms;
-                                out_data->num_frames = rh.num_frames;
-                                out_data->fft_size = rh.fft_size;
-                                out_data->sp = sp;
-                                out_data->ap = ap;
-                                out_data->voiced_mask = vm;
-                                free(full);
-                                return 0;
-                            }
-                            free(full);
-                        } else {
-                            if (full) free(full);
-                            fclose(f);
-                        }
-                    } else {
-                        fclose(f);
-                    }
-                } else {
-                    /* stale cache - remove it */
-                    fclose(f);
-                    remove(cache_path);
-                }
-            } else {
-                fclose(f);
-            }
+    /* If cache exists and is valid, use it: the voicebank pack first, then
+     * the sidecar. Uncompressed caches are mapped and used in place, the rest
+     * is read straight into out_data. A stale or unreadable sidecar is
+     * rebuilt and replaced; stale pack entries wait for `ucra-cli pack update`. */
+    if (load_packed(wav_path, out_data, info)) {
+        info->cache_hit = 1;
+        return 0;
+    }
+    WorldCacheHeader_t h;
+    int rehashed = 0;
+    if (load_sidecar(cache_path, wav_path, out_data, info, &h, &rehashed)) {
+        /* the WAV was touched or copied: store its new identity the way any
+         * sidecar is written, so the next lookup only stats it */
+        if (rehashed && worldcache_writer_submit(wav_path, out_data, &h, NULL) != 0) {
+            write_sidecar(cache_path, wav_path, out_data, &h, NULL);
         }
+        info->cache_hit = 1;
+        return 0;
     }
 
-    /* No valid cache - perform analysis */
-    if (world_analyze_wav_stub(wav_path, out_data) != 0) return -1;
+    /* No valid cache: one process analyzes; the others wait for it and load
+     * what it wrote. The sidecar is checked again once the lock is held,
+     * waited or not: its holder may have finished between the miss above
+     * and the lock. */
+    WorldCacheLock lock;
+    int waited = 0;
+    int locked = lock_source(wav_path, &lock, &waited) == 0;
+    if (locked && load_sidecar(cache_path, wav_path, out_data, info, &h, NULL)) {
+        worldcache_lock_release(&lock);
+        info->cache_hit = 1;
+        info->waited = waited;
+        return 0;
+    }
 
-    /* create header and serialize/save */
-    WorldCacheHeader_t h;
-    worldcache_header_init(&h);
-    h.sample_rate = out_data->sample_rate;
-    h.frame_period_ms = out_data->frame_period_ms;
-    h.num_frames = out_data->num_frames;
-    h.fft_size = out_data->fft_size;
-    /* sizes - this is simplified, real code should calculate bytes precisely */
-    h.sp_size = (uint32_t)(out_data->num_frames * out_data->fft_size * sizeof(float));
-    h.ap_size = (uint32_t)(out_data->num_frames * 2);
-    h.voiced_mask_size = (uint32_t)(out_data->num_frames);
-    h.wav_mtime = get_file_mtime(wav_path);
-    h.wav_hash = simple_file_hash(wav_path);
+    WorldCacheHeader_t source;
+    int result = worldcache_analyze_source(wav_path, out_data, &source);
+    /* with write-back the writer thread stores the sidecar and releases the lock */
+    if (result == 0 && worldcache_writer_submit(wav_path, out_data, &source, locked ? &lock : NULL) == 0) {
+        return 0;
+    }
+    if (result == 0) write_sidecar(cache_path, wav_path, out_data, &source, NULL);
+    if (locked) worldcache_lock_release(&lock);
+    return result;
+}
 
-#if defined(USE_ZSTD)
-    /* Enable compression when library support is compiled in */
-    h.flags |= WORLDCACHE_FLAG_COMPRESSED;
-#endif
+void worldcache_free_analysis(WorldAnalysisData* d) {
+    world_analysis_data_free(d);
+}
 
-    uint8_t* buf = NULL; size_t buf_size = 0;
-    if (worldcache_serialize(&h, out_data->sp, out_data->ap, out_data->voiced_mask, &buf, &buf_size) != 0) {
-        return -1;
-    }
-    FILE* wf = fopen(cache_path, "wb");
-    if (!wf) { free(buf); return -1; }
-    fwrite(buf, 1, buf_size, wf);
-    fclose(wf);
-    free(buf);
-    return 0;
+/* Whether the sidecar's header (read into h) is current */
+static int sidecar_is_current(const char* cache_path, const char* wav_path, WorldCacheHeader_t* h) {
+    FILE* f = fopen(cache_path, "rb");
+    if (!f) return 0;
+    int current = worldcache_header_read(f, h) == 0;
+    fclose(f);
+    return current && header_is_current(h, wav_path, NULL);
+}
+
+/* Audio covered by the frames of h */
+static double header_seconds(const WorldCacheHeader_t* h) {
+    return h->num_frames * h->frame_period_ms / 1000.0;
+}
+
+int worldcache_store(const char* wav_path, const WorldAnalysisData* data) {
+    return worldcache_store_source(wav_path, data, NULL);
 }
 
-void worldcache_free_analysis(WORLD_AnalysisData* d) {
-    if (!d) return;
-    if (d->sp) free(d->sp);
-    if (d->ap) free(d->ap);
-    if (d->voiced_mask) free(d->voiced_mask);
-    d->sp = d->ap = d->voiced_mask = NULL;
+int worldcache_store_source(const char* wav_path, const WorldAnalysisData* data,
+                            const WorldCacheHeader_t* source) {
+    if (!wav_path || !data) return -1;
+    char cache_path[4096];
+    int n = snprintf(cache_path, sizeof(cache_path), "%s.worldcache", wav_path);
+    if (n < 0 || (size_t)n >= sizeof(cache_path)) return -1;
+    return write_sidecar(cache_path, wav_path, data, source, NULL);
+}
+
+int worldcache_ensure(const char* wav_path, double* audio_seconds) {
+    if (audio_seconds) *audio_seconds = 0.0;
+    if (!wav_path) return -1;
+    char cache_path[4096];
+    snprintf(cache_path, sizeof(cache_path), "%s.worldcache", wav_path);
+
+    /* a current pack entry or sidecar header is enough; payloads are not read */
+    WorldCacheHeader_t h;
+    WorldPack* pack = NULL;
+    char key[4096];
+    if (worldpack_locate(wav_path, &pack, key, sizeof(key)) == 0) {
+        const WorldPackEntry_t* e = worldpack_find(pack, key);
+        WorldCacheSourceStatus status = WORLDCACHE_SOURCE_STALE;
+        if (e) {
+            worldpack_entry_header(pack, e, &h);
+            status = worldcache_check_header(&h, wav_path);
+        }
+        worldpack_close(pack);
+        if (status != WORLDCACHE_SOURCE_STALE) {
+            if (audio_seconds) *audio_seconds = header_seconds(&h);
+            return 0;
+        }
+    }
+    if (sidecar_is_current(cache_path, wav_path, &h)) {
+        if (audio_seconds) *audio_seconds = header_seconds(&h);
+        return 0;
+    }
+
+    /* single-flight like worldcache_get_analysis: a sidecar another process
+     * finished before the lock was held is current */
+    WorldCacheLock lock;
+    int waited = 0;
+    int locked = lock_source(wav_path, &lock, &waited) == 0;
+    int result = 0;
+    if (!(locked && sidecar_is_current(cache_path, wav_path, &h))) {
+        WorldAnalysisData data;
+        world_analysis_data_init(&data);
+        WorldCacheHeader_t source;
+        result = worldcache_analyze_source(wav_path, &data, &source) == 0 &&
+                 write_sidecar(cache_path, wav_path, &data, &source, &h) == 0 ? 1 : -1;
+        world_analysis_data_free(&data);
+    }
+    if (locked) worldcache_lock_release(&lock);
+    if (result >= 0 && audio_seconds) *audio_seconds = header_seconds(&h);
+    return result;
 }
 
 int worldcache_invalidate_if_changed(const char* wav_path) {
@@ -149,15 +331,13 @@ int worldcache_invalidate_if_changed(const char* wav_path) {
     FILE* f = fopen(cache_path, "rb");
     if (!f) return 0; /* no cache */
     WorldCacheHeader_t h;
-    if (fread(&h, sizeof(h), 1, f) != 1) {
+    if (worldcache_header_read(f, &h) != 0) {
         fclose(f);
         remove(cache_path);
         return 0;
     }
     fclose(f);
-    uint64_t cur_mtime = get_file_mtime(wav_path);
-    uint64_t cur_hash = simple_file_hash(wav_path);
-    if (h.wav_mtime == cur_mtime && h.wav_hash == cur_hash) return 1; /* still valid */
+    if (header_is_current(&h, wav_path, NULL)) return 1; /* still valid */
     /* stale */
     remove(cache_path);
     return 0;
@@ -2,27 +2,71 @@
 #define WORLDCACHE_MANAGER_H
 
 #include "worldcache_format.h"
+#include "worldcache_analysis.h"
+#include "worldcache_source.h"
+#include "world_wrapper.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* Minimal placeholder for WORLD_AnalysisData - real project may define a richer struct. */
-typedef struct {
-    uint32_t num_frames;
-    uint32_t fft_size;
-    double sample_rate;
-    double frame_period_ms;
-    uint8_t* sp; /* raw bytes */
-    uint8_t* ap;
-    uint8_t* voiced_mask;
-} WORLD_AnalysisData;
-
-/* Orchestrate analysis + cache: fills out_data and returns 0 on success. */
-int worldcache_get_analysis(const char* wav_path, WORLD_AnalysisData* out_data);
-
-/* Free a WORLD_AnalysisData allocated by analyze or deserialize */
-void worldcache_free_analysis(WORLD_AnalysisData* d);
+/* Orchestrate analysis + cache: fills out_data (initialized with
+ * world_analysis_data_init) and returns 0 on success. A cache hit reads the
+ * payload straight into out_data, which can be passed to world_synthesize()
+ * as is. The voicebank pack (worldcache_pack.h) is consulted first, then the
+ * <wav>.worldcache sidecar. On a miss the WAV is analyzed with
+ * world_analyze() and the sidecar is (re)written; failing to write it does
+ * not fail the call. With write-back enabled (worldcache_writer.h) the
+ * sidecar is written by a background thread after the call returns, from
+ * storage out_data shares with it; do not write out_data's rows in place. */
+int worldcache_get_analysis(const char* wav_path, WorldAnalysisData* out_data);
+
+/* Same as worldcache_get_analysis, reporting what the load did in info (may be NULL) */
+int worldcache_get_analysis_ex(const char* wav_path, WorldAnalysisData* out_data,
+                               WorldCacheLoadInfo* info);
+
+/* Free analysis data filled by worldcache_get_analysis */
+void worldcache_free_analysis(WorldAnalysisData* d);
+
+/* Analyze wav_path the way a cache miss does; no cache is read or written */
+int worldcache_analyze(const char* wav_path, WorldAnalysisData* out_data);
+
+/* Same, first stamping the source identity and content hash of wav_path
+ * into source (may be NULL), so a cache made from the result can be tied to
+ * the WAV that was actually read */
+int worldcache_analyze_source(const char* wav_path, WorldAnalysisData* out_data, WorldCacheHeader_t* source);
+
+/* Header the manager stores for data analyzed from wav_path (geometry,
+ * source identity, compression, quantization). The identity comes from
+ * source, as stamped by worldcache_analyze_source, or with source NULL from
+ * the WAV as it is now. Returns 0 on success, -1 also when wav_path no
+ * longer matches source: the WAV changed after it was read, and data must
+ * not be cached under its new identity. */
+int worldcache_make_header(WorldCacheHeader_t* h, const char* wav_path, const WorldAnalysisData* data,
+                           const WorldCacheHeader_t* source);
+
+/* Check a cache header (sidecar or pack entry) against wav_path and the
+ * manager's analysis settings. On WORLDCACHE_SOURCE_REHASHED h holds the
+ * refreshed source identity for the caller to persist. */
+WorldCacheSourceStatus worldcache_check_header(WorldCacheHeader_t* h, const char* wav_path);
+
+/* Rewrite the sidecar of wav_path with data analyzed from it, compressed
+ * as the manager does (worldcache_compression_level and the voicebank's
+ * dictionary, see worldcache_dict.h). Returns 0 on success. */
+int worldcache_store(const char* wav_path, const WorldAnalysisData* data);
+
+/* Same for data analyzed by worldcache_analyze_source: refuses (-1) to
+ * write when the WAV changed since source was stamped */
+int worldcache_store_source(const char* wav_path, const WorldAnalysisData* data,
+                            const WorldCacheHeader_t* source);
+
+/* Make sure wav_path has a current cache without loading it: a current
+ * pack entry or sidecar header is left alone, otherwise the WAV is analyzed
+ * and the sidecar rewritten. audio_seconds (may be NULL) receives the
+ * duration the analysis covers. Returns 0 if the cache was already current,
+ * 1 if it was rebuilt, -1 if the WAV cannot be analyzed or the sidecar
+ * cannot be written. */
+int worldcache_ensure(const char* wav_path, double* audio_seconds);
 
 /* Remove or mark cache invalid if WAV changed. Returns 0 if cache removed or not present, 1 if cache still valid, -1 on error. */
 int worldcache_invalidate_if_changed(const char* wav_path);
@@ -0,0 +1,86 @@
+#include "worldcache_mmap.h"
+#include "worldx_thread.h"
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct WorldCacheMapping {
+    uint8_t* base;
+    size_t size;
+    worldx_atomic_t refcount;
+};
+
+int worldcache_mapping_open(const char* path, WorldCacheMapping** out_mapping) {
+    if (!path || !out_mapping) return -1;
+    *out_mapping = NULL;
+
+    WorldCacheMapping* m = (WorldCacheMapping*)calloc(1, sizeof(*m));
+    if (!m) return -1;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) { free(m); return -1; }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        free(m);
+        return -1;
+    }
+    HANDLE section = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!section) { free(m); return -1; }
+    m->base = (uint8_t*)MapViewOfFile(section, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(section); /* the view keeps the section alive */
+    if (!m->base) { free(m); return -1; }
+    m->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { free(m); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        free(m);
+        return -1;
+    }
+    /* MAP_PRIVATE + PROT_WRITE: in-place edits stay private to the process */
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); /* the mapping keeps the file alive */
+    if (base == MAP_FAILED) { free(m); return -1; }
+    m->base = (uint8_t*)base;
+    m->size = (size_t)st.st_size;
+#endif
+
+    m->refcount = 1;
+    *out_mapping = m;
+    return 0;
+}
+
+uint8_t* worldcache_mapping_data(const WorldCacheMapping* m) {
+    return m ? m->base : NULL;
+}
+
+size_t worldcache_mapping_size(const WorldCacheMapping* m) {
+    return m ? m->size : 0;
+}
+
+void worldcache_mapping_retain(WorldCacheMapping* m) {
+    if (m) worldx_atomic_inc(&m->refcount);
+}
+
+void worldcache_mapping_release(void* mapping) {
+    WorldCacheMapping* m = (WorldCacheMapping*)mapping;
+    if (!m || worldx_atomic_dec(&m->refcount) != 0) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(m->base);
+#else
+    munmap(m->base, m->size);
+#endif
+    free(m);
+}
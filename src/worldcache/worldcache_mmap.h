@@ -0,0 +1,36 @@
+#ifndef WORLDCACHE_MMAP_H
+#define WORLDCACHE_MMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Read-only view of a whole .worldcache file, mapped copy-on-write: callers
+ * may modify the mapped bytes in place without touching the file. The
+ * mapping is reference counted and unmapped when the last reference is
+ * released, so analysis data pointing into it can outlive the code that
+ * opened it. */
+typedef struct WorldCacheMapping WorldCacheMapping;
+
+/* Map path; the new mapping holds one reference. Returns 0 on success. */
+int worldcache_mapping_open(const char* path, WorldCacheMapping** out_mapping);
+
+/* Start and size of the mapped file */
+uint8_t* worldcache_mapping_data(const WorldCacheMapping* m);
+size_t worldcache_mapping_size(const WorldCacheMapping* m);
+
+/* Add a reference */
+void worldcache_mapping_retain(WorldCacheMapping* m);
+
+/* Drop a reference, unmapping on the last one; NULL is ignored. Takes void*
+ * so it can serve as WorldAnalysisStorage.release. */
+void worldcache_mapping_release(void* m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_MMAP_H */
@@ -0,0 +1,547 @@
+#include "worldcache_pack.h"
+#include "worldcache_dict.h"
+#include "worldcache_lock.h"
+#include "worldcache_manager.h"
+#include "worldcache_source.h"
+#include "worldcache_voicebank.h"
+#include "worldx_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct WorldPack {
+    WorldCacheMapping* mapping;
+    const uint8_t* base;
+    size_t size;
+    WorldPackHeader_t header;
+    const WorldPackEntry_t* toc;
+    const char* strings;
+    worldx_atomic_t refs;  /* worldpack_close releases one */
+    char path[4096];
+};
+
+/* Pack found for a sample directory, or the fact that there was none.
+ * worldpack_locate keeps the pack open and checks it with one stat per
+ * lookup; a miss is searched again after WORLDPACK_MISS_RECHECK_SEC. */
+typedef struct Located {
+    char* dir;                /* sample directory, as the WAV path spells it */
+    WorldPack* pack;          /* NULL after a miss */
+    size_t pack_prefix;       /* length of the pack directory within dir */
+    WorldCacheSourceId id;    /* identity of the pack file that was mapped */
+    double missed;            /* when the search last failed */
+    struct Located* next;
+} Located;
+
+static worldx_mutex_t g_lock = WORLDX_MUTEX_INITIALIZER;
+static Located* g_located;
+
+static double now_sec(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static int seek64(FILE* f, uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(f, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static uint64_t tell64(FILE* f) {
+#if defined(_WIN32)
+    return (uint64_t)_ftelli64(f);
+#else
+    return (uint64_t)ftello(f);
+#endif
+}
+
+static uint64_t align_up(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+static uint64_t key_hash(const char* key, size_t len) {
+    WorldCacheHash s;
+    worldcache_hash_init(&s);
+    worldcache_hash_update(&s, key, len);
+    return worldcache_hash_final(&s);
+}
+
+int worldpack_open(const char* path, WorldPack** out_pack) {
+    if (!path || !out_pack) return -1;
+    *out_pack = NULL;
+    WorldPack* p = (WorldPack*)calloc(1, sizeof(*p));
+    if (!p) return -1;
+    if (strlen(path) >= sizeof(p->path) || worldcache_mapping_open(path, &p->mapping) != 0) {
+        free(p);
+        return -1;
+    }
+    strcpy(p->path, path);
+    p->refs = 1;
+    p->base = worldcache_mapping_data(p->mapping);
+    p->size = worldcache_mapping_size(p->mapping);
+
+    WorldPackHeader_t* h = &p->header;
+    if (p->size < sizeof(*h)) goto fail;
+    memcpy(h, p->base, sizeof(*h));
+    uint64_t toc_size = (uint64_t)h->bucket_count * sizeof(WorldPackEntry_t);
+    if (h->magic != WORLDPACK_MAGIC || h->version != WORLDPACK_VERSION || h->bucket_count == 0 ||
+        (h->bucket_count & (h->bucket_count - 1)) != 0 || h->entry_count >= h->bucket_count ||
+        h->toc_offset % sizeof(uint64_t) != 0 || h->toc_offset > p->size ||
+        toc_size > p->size - h->toc_offset || h->strings_offset > p->size ||
+        h->strings_size > p->size - h->strings_offset) {
+        goto fail;
+    }
+    p->toc = (const WorldPackEntry_t*)(const void*)(p->base + h->toc_offset);
+    p->strings = (const char*)p->base + h->strings_offset;
+    *out_pack = p;
+
+    /* entries compressed with the embedded dictionary need it registered */
+    const WorldPackEntry_t* d = worldpack_find(p, WORLDPACK_DICT_KEY);
+    if (d) worldcache_dict_register(p->base + d->offset, (size_t)d->size);
+    return 0;
+
+fail:
+    worldpack_close(p);
+    return -1;
+}
+
+void worldpack_close(WorldPack* pack) {
+    if (!pack || worldx_atomic_dec(&pack->refs) > 0) return;
+    worldcache_mapping_release(pack->mapping);
+    free(pack);
+}
+
+uint32_t worldpack_bucket_count(const WorldPack* pack) { return pack->header.bucket_count; }
+
+/* Slot i if it holds a well-formed entry */
+const WorldPackEntry_t* worldpack_bucket(const WorldPack* pack, uint32_t i) {
+    if (i >= pack->header.bucket_count) return NULL;
+    const WorldPackEntry_t* e = &pack->toc[i];
+    if (e->size == 0 || e->offset > pack->size || e->size > pack->size - e->offset ||
+        (uint64_t)e->key_offset + e->key_len >= pack->header.strings_size ||
+        pack->strings[e->key_offset + e->key_len] != '\0') {
+        return NULL;
+    }
+    return e;
+}
+
+const char* worldpack_entry_key(const WorldPack* pack, const WorldPackEntry_t* entry) {
+    return pack->strings + entry->key_offset;
+}
+
+const WorldPackEntry_t* worldpack_find(const WorldPack* pack, const char* key) {
+    if (!pack || !key) return NULL;
+    size_t len = strlen(key);
+    uint64_t hash = key_hash(key, len);
+    uint32_t mask = pack->header.bucket_count - 1;
+    for (uint32_t n = 0, i = (uint32_t)hash & mask; n < pack->header.bucket_count; n++, i = (i + 1) & mask) {
+        if (pack->toc[i].size == 0) return NULL;
+        const WorldPackEntry_t* e = worldpack_bucket(pack, i);
+        if (e && e->key_hash == hash && e->key_len == len &&
+            memcmp(worldpack_entry_key(pack, e), key, len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static int same_id(const WorldCacheSourceId* a, const WorldCacheSourceId* b) {
+    return a->size == b->size && a->mtime_ns == b->mtime_ns && a->inode == b->inode;
+}
+
+static Located* find_located(const char* dir, size_t dir_len) {
+    Located* l = g_located;
+    while (l && (strlen(l->dir) != dir_len || memcmp(l->dir, dir, dir_len) != 0)) l = l->next;
+    return l;
+}
+
+/* Search the directories above a sample for its pack. The pack is only
+ * remembered when its file kept one identity while it was mapped. */
+static WorldPack* search_pack(const char* wav_path, size_t* out_prefix, WorldCacheSourceId* id, int* stable) {
+    size_t prefix = worldcache_path_dir_length(wav_path);
+    char pack_path[4096];
+    for (int depth = 0; depth <= WORLDPACK_SEARCH_DEPTH; depth++) {
+        WorldPack* pack = NULL;
+        WorldCacheSourceId after;
+        int n = snprintf(pack_path, sizeof(pack_path), "%.*s%s", (int)prefix, wav_path, WORLDPACK_FILENAME);
+        if (n > 0 && (size_t)n < sizeof(pack_path) && worldcache_source_identify(pack_path, id) == 0 &&
+            worldpack_open(pack_path, &pack) == 0) {
+            *stable = worldcache_source_identify(pack_path, &after) == 0 && same_id(id, &after);
+            *out_prefix = prefix;
+            return pack;
+        }
+        if (worldcache_path_parent(wav_path, &prefix) != 0) break;
+    }
+    return NULL;
+}
+
+/* Pack covering the directory of wav_path (a reference the caller closes),
+ * from the cache when it is still current */
+static WorldPack* locate_pack(const char* wav_path, size_t* out_prefix) {
+    size_t dir_len = worldcache_path_dir_length(wav_path);
+    double now = now_sec();
+    WorldPack* pack = NULL;
+    WorldCacheSourceId id;
+    worldx_mutex_lock(&g_lock);
+    Located* l = find_located(wav_path, dir_len);
+    if (l && l->pack) {
+        pack = l->pack;
+        worldx_atomic_inc(&pack->refs);
+        id = l->id;
+        *out_prefix = l->pack_prefix;
+    }
+    int recent_miss = l && !l->pack && now - l->missed < WORLDPACK_MISS_RECHECK_SEC;
+    worldx_mutex_unlock(&g_lock);
+    if (recent_miss) return NULL;
+    if (pack) {
+        WorldCacheSourceId current;
+        if (worldcache_source_identify(pack->path, &current) == 0 && same_id(&id, &current)) return pack;
+        worldpack_close(pack);
+    }
+
+    int stable = 0;
+    pack = search_pack(wav_path, out_prefix, &id, &stable);
+    worldx_mutex_lock(&g_lock);
+    if (!(l = find_located(wav_path, dir_len)) && (l = (Located*)calloc(1, sizeof(*l))) != NULL) {
+        if ((l->dir = (char*)malloc(dir_len + 1)) != NULL) {
+            memcpy(l->dir, wav_path, dir_len);
+            l->dir[dir_len] = '\0';
+            l->next = g_located;
+            g_located = l;
+        } else {
+            free(l);
+            l = NULL;
+        }
+    }
+    WorldPack* dropped = NULL;
+    if (l) {
+        dropped = l->pack;
+        l->pack = NULL;
+        l->missed = pack ? -WORLDPACK_MISS_RECHECK_SEC : now;
+        if (pack && stable) {
+            worldx_atomic_inc(&pack->refs);
+            l->pack = pack;
+            l->pack_prefix = *out_prefix;
+            l->id = id;
+        }
+    }
+    worldx_mutex_unlock(&g_lock);
+    worldpack_close(dropped);
+    return pack;
+}
+
+/* Drop the cached references to the pack at pack_path and forget misses,
+ * so a rebuilt pack is found (and, on Windows, can replace the mapped one) */
+static void forget_located(const char* pack_path) {
+    worldx_mutex_lock(&g_lock);
+    for (Located* l = g_located; l; l = l->next) {
+        if (l->pack && strcmp(l->pack->path, pack_path) == 0) {
+            worldpack_close(l->pack);
+            l->pack = NULL;
+        }
+        l->missed = -WORLDPACK_MISS_RECHECK_SEC;
+    }
+    worldx_mutex_unlock(&g_lock);
+}
+
+int worldpack_locate(const char* wav_path, WorldPack** out_pack, char* key, size_t key_size) {
+    if (!wav_path || !out_pack || !key || key_size == 0) return -1;
+    *out_pack = NULL;
+
+    size_t prefix = 0;
+    WorldPack* pack = locate_pack(wav_path, &prefix);
+    if (!pack) return -1;
+    size_t len = strlen(wav_path + prefix);
+    if (len >= key_size) {
+        worldpack_close(pack);
+        return -1;
+    }
+    for (size_t i = 0; i <= len; i++) {
+        char c = wav_path[prefix + i];
+        key[i] = c == '\\' ? '/' : c;
+    }
+    *out_pack = pack;
+    return 0;
+}
+
+void worldpack_entry_header(const WorldPack* pack, const WorldPackEntry_t* entry, WorldCacheHeader_t* h) {
+    if (worldcache_header_parse(pack->base + entry->offset, (size_t)entry->size, h) != 0) memset(h, 0, sizeof(*h));
+}
+
+int worldpack_load(const WorldPack* pack, const WorldPackEntry_t* entry, WorldAnalysisData* data,
+                   WorldCacheLoadInfo* info) {
+    if (!pack || !entry || !data) return -1;
+    if (worldcache_attach_analysis_at(pack->mapping, (size_t)entry->offset, (size_t)entry->size, data,
+                                      info) == 0) {
+        return 0;
+    }
+    /* compressed and quantized entries are decoded from the mapping too: the
+     * file at pack->path may already be a rebuilt pack with other offsets */
+    return worldcache_read_analysis_at(pack->mapping, (size_t)entry->offset, (size_t)entry->size, data, info);
+}
+
+/* ---- build ---- */
+
+static int write_zeros(FILE* f, uint64_t count) {
+    static const uint8_t zeros[512];
+    while (count > 0) {
+        size_t n = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+        if (fwrite(zeros, 1, n, f) != n) return -1;
+        count -= n;
+    }
+    return 0;
+}
+
+/* Whether an image may go into a pack whose dictionary has id dict_id (0: none) */
+static int image_fits(const uint8_t* image, size_t size, uint32_t dict_id) {
+    uint32_t id;
+    return worldcache_image_dict_id(image, size, &id) == 0 && (id == 0 || id == dict_id);
+}
+
+/* Copy image to f with its refreshed header if it is still valid for
+ * wav_path. Returns 1 if copied, 0 if stale, -1 on write errors. */
+static int copy_image(FILE* f, const uint8_t* image, size_t size, const char* wav_path, uint32_t dict_id) {
+    WorldCacheHeader_t h;
+    if (!image_fits(image, size, dict_id) || worldcache_header_parse(image, size, &h) != 0 ||
+        worldcache_check_header(&h, wav_path) == WORLDCACHE_SOURCE_STALE) {
+        return 0;
+    }
+    size_t header = worldcache_header_disk_size(&h), rest = size - header;
+    return worldcache_header_write(f, &h) == 0 && fwrite(image + header, 1, rest, f) == rest ? 1 : -1;
+}
+
+/* Copy a still valid image of key (previous pack entry, else sidecar) to f
+ * with its refreshed header. Returns 1 if copied, 0 if there is none, -1 on
+ * write errors. */
+static int copy_current_image(FILE* f, const WorldPack* old, const char* key, const char* wav_path,
+                              uint32_t dict_id) {
+    const WorldPackEntry_t* e = old ? worldpack_find(old, key) : NULL;
+    if (e) {
+        int copied = copy_image(f, old->base + e->offset, (size_t)e->size, wav_path, dict_id);
+        if (copied != 0) return copied;
+    }
+
+    char sidecar[4096];
+    int n = snprintf(sidecar, sizeof(sidecar), "%s.worldcache", wav_path);
+    if (n < 0 || (size_t)n >= sizeof(sidecar)) return 0;
+    WorldCacheMapping* m = NULL;
+    if (worldcache_mapping_open(sidecar, &m) != 0) return 0;
+    int result = copy_image(f, worldcache_mapping_data(m), worldcache_mapping_size(m), wav_path, dict_id);
+    worldcache_mapping_release(m);
+    return result;
+}
+
+/* Enter an entry at [offset, end) of the file under key */
+static void add_entry(WorldPackHeader_t* ph, WorldPackEntry_t* toc, char* strings, const char* key,
+                      uint64_t offset, uint64_t end) {
+    size_t len = strlen(key);
+    uint64_t hash = key_hash(key, len);
+    uint32_t mask = ph->bucket_count - 1;
+    uint32_t slot = (uint32_t)hash & mask;
+    while (toc[slot].size != 0) slot = (slot + 1) & mask;
+    toc[slot].key_hash = hash;
+    toc[slot].offset = offset;
+    toc[slot].size = end - offset;
+    toc[slot].key_offset = (uint32_t)ph->strings_size;
+    toc[slot].key_len = (uint32_t)len;
+    memcpy(strings + ph->strings_size, key, len + 1);
+    ph->strings_size += len + 1;
+    ph->entry_count++;
+}
+
+int worldpack_build(const char* voicebank_dir, int update, WorldPackReport* report) {
+    WorldPackReport local;
+    if (!report) report = &local;
+    memset(report, 0, sizeof(*report));
+    if (!voicebank_dir) return -1;
+
+    char pack_path[4096], tmp_path[4096];
+    int n = snprintf(pack_path, sizeof(pack_path), "%s/%s", voicebank_dir, WORLDPACK_FILENAME);
+    if (n < 0 || (size_t)n >= sizeof(pack_path)) return -1;
+    if (worldcache_temp_path(pack_path, tmp_path, sizeof(tmp_path)) != 0) return -1;
+
+    WorldCachePathList keys;
+    if (worldcache_voicebank_wavs(voicebank_dir, &keys) != 0) return -1;
+    report->samples = (int)keys.count;
+
+    char dict_path[4096];
+    n = snprintf(dict_path, sizeof(dict_path), "%s/%s", voicebank_dir, WORLDCACHE_DICT_FILENAME);
+    const WorldCacheDict* dict = n > 0 && (size_t)n < sizeof(dict_path) ? worldcache_dict_load(dict_path) : NULL;
+    size_t dict_size = 0;
+    const void* dict_bytes = worldcache_dict_bytes(dict, &dict_size);
+    WorldCacheCompression opts = { 0, dict };
+
+    /* layout: header, slot table, strings, then 4 KB aligned images (the
+     * dictionary first) */
+    size_t entries = keys.count + (dict ? 1 : 0);
+    uint32_t buckets = 1;
+    while (buckets <= entries * 2) buckets <<= 1;
+    uint64_t strings_capacity = dict ? sizeof(WORLDPACK_DICT_KEY) : 0;
+    for (size_t i = 0; i < keys.count; i++) strings_capacity += strlen(keys.items[i]) + 1;
+
+    WorldPackHeader_t ph;
+    memset(&ph, 0, sizeof(ph));
+    ph.magic = WORLDPACK_MAGIC;
+    ph.version = WORLDPACK_VERSION;
+    ph.bucket_count = buckets;
+    ph.toc_offset = align_up(sizeof(ph), 64);
+    ph.strings_offset = ph.toc_offset + (uint64_t)buckets * sizeof(WorldPackEntry_t);
+    uint64_t data_start = align_up(ph.strings_offset + strings_capacity, WORLDPACK_ALIGN);
+
+    WorldPackEntry_t* toc = (WorldPackEntry_t*)calloc(buckets, sizeof(WorldPackEntry_t));
+    char* strings = (char*)malloc(strings_capacity ? (size_t)strings_capacity : 1);
+    WorldPack* old = NULL;
+    if (update) worldpack_open(pack_path, &old);
+    FILE* f = fopen(tmp_path, "wb");
+    int result = toc && strings && f && write_zeros(f, data_start) == 0 ? 0 : -1;
+
+    uint64_t pos = data_start;
+    if (result == 0 && dict) {
+        add_entry(&ph, toc, strings, WORLDPACK_DICT_KEY, pos, pos + dict_size);
+        uint64_t end = pos + dict_size;
+        pos = align_up(end, WORLDPACK_ALIGN);
+        if (fwrite(dict_bytes, 1, dict_size, f) != dict_size || write_zeros(f, pos - end) != 0) result = -1;
+    }
+    for (size_t i = 0; result == 0 && i < keys.count; i++) {
+        const char* key = keys.items[i];
+        char wav_path[4096];
+        n = snprintf(wav_path, sizeof(wav_path), "%s/%s", voicebank_dir, key);
+        if (n < 0 || (size_t)n >= sizeof(wav_path)) {
+            report->failed++;
+            continue;
+        }
+
+        int copied = update ? copy_current_image(f, old, key, wav_path, worldcache_dict_id(dict)) : 0;
+        if (copied < 0) {
+            result = -1;
+            break;
+        }
+        if (copied) {
+            report->reused++;
+        } else {
+            WorldAnalysisData data;
+            world_analysis_data_init(&data);
+            WorldCacheHeader_t h, source;
+            worldcache_header_init(&h);
+            if (worldcache_analyze_source(wav_path, &data, &source) != 0 ||
+                worldcache_make_header(&h, wav_path, &data, &source) != 0) {
+                world_analysis_data_free(&data);
+                report->failed++;
+                continue;
+            }
+            int written = worldcache_write_analysis_ex(f, &h, &data, &opts);
+            world_analysis_data_free(&data);
+            if (written != 0) {
+                result = -1;
+                break;
+            }
+            report->analyzed++;
+        }
+
+        uint64_t end = tell64(f);
+        add_entry(&ph, toc, strings, key, pos, end);
+
+        pos = align_up(end, WORLDPACK_ALIGN);
+        if (write_zeros(f, pos - end) != 0) result = -1;
+    }
+
+    if (result == 0 &&
+        (seek64(f, 0) != 0 || fwrite(&ph, sizeof(ph), 1, f) != 1 ||
+         write_zeros(f, ph.toc_offset - sizeof(ph)) != 0 ||
+         fwrite(toc, sizeof(WorldPackEntry_t), buckets, f) != buckets ||
+         fwrite(strings, 1, (size_t)ph.strings_size, f) != ph.strings_size)) {
+        result = -1;
+    }
+    if (f && fclose(f) != 0) result = -1;
+    worldpack_close(old);
+    free(toc);
+    free(strings);
+    worldcache_path_list_free(&keys);
+
+    if (result == 0) forget_located(pack_path);
+    if (result == 0 && worldcache_replace_file(tmp_path, pack_path) != 0) result = -1;
+    if (result != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    report->entries = (int)(ph.entry_count - (dict ? 1 : 0));
+    report->bytes = pos;
+    return 0;
+}
+
+/* ---- verify ---- */
+
+static int compare_keys(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int worldpack_verify(const char* voicebank_dir, WorldPackReport* report) {
+    WorldPackReport local;
+    if (!report) report = &local;
+    memset(report, 0, sizeof(*report));
+    if (!voicebank_dir) return -1;
+
+    char pack_path[4096];
+    int n = snprintf(pack_path, sizeof(pack_path), "%s/%s", voicebank_dir, WORLDPACK_FILENAME);
+    WorldPack* pack = NULL;
+    if (n < 0 || (size_t)n >= sizeof(pack_path) || worldpack_open(pack_path, &pack) != 0) return -1;
+    WorldCachePathList keys;
+    if (worldcache_voicebank_wavs(voicebank_dir, &keys) != 0) {
+        worldpack_close(pack);
+        return -1;
+    }
+    report->samples = (int)keys.count;
+    report->entries = (int)pack->header.entry_count - (worldpack_find(pack, WORLDPACK_DICT_KEY) ? 1 : 0);
+    report->bytes = pack->size;
+
+    for (size_t i = 0; i < keys.count; i++) {
+        const WorldPackEntry_t* e = worldpack_find(pack, keys.items[i]);
+        if (!e) {
+            report->missing++;
+            continue;
+        }
+        char wav_path[4096];
+        snprintf(wav_path, sizeof(wav_path), "%s/%s", voicebank_dir, keys.items[i]);
+        WorldCacheHeader_t h;
+        worldpack_entry_header(pack, e, &h);
+        if (worldcache_check_header(&h, wav_path) == WORLDCACHE_SOURCE_STALE) {
+            report->stale++;
+            continue;
+        }
+        /* sections are checked against their checksums, which loads skip */
+        WorldAnalysisData data;
+        world_analysis_data_init(&data);
+        if (worldcache_image_verify(pack->base + e->offset, (size_t)e->size) != 0 ||
+            worldpack_load(pack, e, &data, NULL) != 0) {
+            report->failed++;
+        }
+        world_analysis_data_free(&data);
+    }
+
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < pack->header.bucket_count; i++) {
+        if (pack->toc[i].size == 0) continue;
+        used++;
+        const WorldPackEntry_t* e = worldpack_bucket(pack, i);
+        if (!e) {
+            report->failed++;
+            continue;
+        }
+        const char* key = worldpack_entry_key(pack, e);
+        if (strcmp(key, WORLDPACK_DICT_KEY) == 0) continue;
+        if (!bsearch(&key, keys.items, keys.count, sizeof(char*), compare_keys)) report->orphaned++;
+    }
+    if (used != pack->header.entry_count) report->failed++;
+
+    worldcache_path_list_free(&keys);
+    worldpack_close(pack);
+    return report->stale || report->missing || report->orphaned || report->failed ? 1 : 0;
+}
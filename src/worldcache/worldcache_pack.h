@@ -0,0 +1,137 @@
+#ifndef WORLDCACHE_PACK_H
+#define WORLDCACHE_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "worldcache_format.h"
+#include "worldcache_analysis.h"
+#include "worldcache_mmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Voicebank-wide cache pack (.worldpack).
+ *
+ * One file per voicebank instead of a <wav>.worldcache sidecar per sample:
+ *  - WorldPackHeader_t at offset 0
+ *  - table of contents: bucket_count WorldPackEntry_t slots, an open
+ *    addressing hash table (linear probing) keyed by the sample path
+ *    relative to the pack directory, '/' separated
+ *  - string table of NUL-terminated keys
+ *  - entries, each a complete .worldcache image (header + payload) starting
+ *    on a WORLDPACK_ALIGN boundary; the WORLDPACK_DICT_KEY entry instead
+ *    holds the voicebank's zstd dictionary (worldcache_dict.h), which
+ *    worldpack_open registers
+ * The pack is mapped once; a lookup hashes the key and probes the table, and
+ * an uncompressed entry is used in place like a mapped sidecar. */
+
+#pragma pack(push,1)
+typedef struct {
+    uint32_t magic;          /* 'WPK1' */
+    uint16_t version;        /* WORLDPACK_VERSION */
+    uint16_t reserved;
+    uint32_t entry_count;    /* used slots */
+    uint32_t bucket_count;   /* table slots, a power of two > entry_count */
+    uint64_t toc_offset;     /* offset of the slot table */
+    uint64_t strings_offset; /* offset of the key strings */
+    uint64_t strings_size;   /* size of the key strings in bytes */
+} WorldPackHeader_t;
+
+typedef struct {
+    uint64_t key_hash;       /* worldcache_hash of the key bytes */
+    uint64_t offset;         /* offset of the cache image, WORLDPACK_ALIGN aligned */
+    uint64_t size;           /* size of the cache image; 0 marks an empty slot */
+    uint32_t key_offset;     /* offset of the key in the string table */
+    uint32_t key_len;        /* key length without the terminator */
+} WorldPackEntry_t;
+#pragma pack(pop)
+
+/* magic value 'WPK1' little-endian */
+#define WORLDPACK_MAGIC 0x314B5057U
+#define WORLDPACK_VERSION 1
+
+/* Entry alignment (page size, so each image can be used in place) */
+#define WORLDPACK_ALIGN 4096
+
+/* Pack file name at the voicebank root, and how many directories above a
+ * sample the manager looks for it */
+#define WORLDPACK_FILENAME "voicebank.worldpack"
+#define WORLDPACK_SEARCH_DEPTH 3
+
+/* Seconds a directory without a pack is remembered as such before the
+ * search runs again (worldpack_build forgets misses at once) */
+#define WORLDPACK_MISS_RECHECK_SEC 2.0
+
+/* Key of the dictionary entry (hidden files are never samples) */
+#define WORLDPACK_DICT_KEY ".worlddict"
+
+typedef struct WorldPack WorldPack;
+
+/* Map and validate a pack. Returns 0 on success. */
+int worldpack_open(const char* path, WorldPack** out_pack);
+
+/* Release a pack from worldpack_open or worldpack_locate */
+void worldpack_close(WorldPack* pack);
+
+/* Find the pack covering wav_path: WORLDPACK_FILENAME in the sample's
+ * directory or up to WORLDPACK_SEARCH_DEPTH parents. key receives the sample
+ * path relative to the pack. The result is kept per sample directory: the
+ * pack stays mapped (and its dictionary registered) across lookups while
+ * its file is unchanged, and a miss is not searched again for
+ * WORLDPACK_MISS_RECHECK_SEC. Returns 0 if a pack was found; close it after use. */
+int worldpack_locate(const char* wav_path, WorldPack** out_pack, char* key, size_t key_size);
+
+/* Entry for key, or NULL */
+const WorldPackEntry_t* worldpack_find(const WorldPack* pack, const char* key);
+
+/* Slot i of the table (i < worldpack_bucket_count), NULL if empty */
+uint32_t worldpack_bucket_count(const WorldPack* pack);
+const WorldPackEntry_t* worldpack_bucket(const WorldPack* pack, uint32_t i);
+
+/* NUL-terminated key of an entry */
+const char* worldpack_entry_key(const WorldPack* pack, const WorldPackEntry_t* entry);
+
+/* Copy of the cache header at the start of an entry */
+void worldpack_entry_header(const WorldPack* pack, const WorldPackEntry_t* entry, WorldCacheHeader_t* h);
+
+/* Load an entry into data: uncompressed images are attached in place (data
+ * keeps the pack mapped), compressed and quantized ones are decoded from
+ * the mapping. Does not validate the entry against its source. Returns 0 on
+ * success. */
+int worldpack_load(const WorldPack* pack, const WorldPackEntry_t* entry, WorldAnalysisData* data,
+                   WorldCacheLoadInfo* info);
+
+/* Outcome of worldpack_build / worldpack_verify */
+typedef struct {
+    int samples;     /* WAV files found under the voicebank */
+    int entries;     /* entries in the resulting (or verified) pack */
+    int reused;      /* build: images copied from the previous pack or a sidecar */
+    int analyzed;    /* build: samples analyzed afresh */
+    int stale;       /* verify: entries whose source changed */
+    int missing;     /* verify: samples without an entry */
+    int orphaned;    /* verify: entries without a sample */
+    int failed;      /* samples that could not be analyzed / malformed entries */
+    uint64_t bytes;  /* pack file size */
+} WorldPackReport;
+
+/* Build <voicebank_dir>/WORLDPACK_FILENAME from every .wav below the
+ * directory. With update, images of an existing pack (and current sidecars)
+ * are reused when still valid; otherwise every sample is analyzed. A
+ * voicebank dictionary (WORLDCACHE_DICT_FILENAME) is embedded and used for
+ * new entries; images compressed with another dictionary are not reused. The pack
+ * is written beside the old one and renamed over it, so readers that mapped
+ * the old pack keep a consistent view. report may be NULL. Returns 0 on
+ * success (individual samples that fail are counted, not fatal). */
+int worldpack_build(const char* voicebank_dir, int update, WorldPackReport* report);
+
+/* Check the pack of voicebank_dir against its samples and the entries for
+ * well-formed payloads. Returns 0 if everything is current, 1 if not, -1 if
+ * there is no readable pack. */
+int worldpack_verify(const char* voicebank_dir, WorldPackReport* report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_PACK_H */
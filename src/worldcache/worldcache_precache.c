@@ -0,0 +1,136 @@
+#include "worldcache_precache.h"
+#include "worldcache_manager.h"
+#include "worldcache_voicebank.h"
+#include "worldx_pool.h"
+#include "worldx_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+typedef struct {
+    char* key;            /* path below the voicebank */
+    uint64_t size;        /* WAV size, to schedule long samples first */
+    int exists;
+} Sample;
+
+typedef struct {
+    const char* dir;
+    Sample* samples;
+    worldx_mutex_t lock;  /* guards report and progress calls */
+    WorldCachePrecacheReport* report;
+    double start;
+    WorldCachePrecacheProgress progress;
+    void* user;
+} Precache;
+
+static int compare_size_desc(const void* a, const void* b) {
+    const Sample* x = (const Sample*)a;
+    const Sample* y = (const Sample*)b;
+    if (x->size != y->size) return x->size < y->size ? 1 : -1;
+    return strcmp(x->key, y->key);
+}
+
+static void precache_job(void* ctx, size_t job, int worker) {
+    (void)worker;
+    Precache* p = (Precache*)ctx;
+    const Sample* s = &p->samples[job];
+    char wav_path[4096];
+    int n = snprintf(wav_path, sizeof(wav_path), "%s/%s", p->dir, s->key);
+
+    int status = -1;
+    double seconds = 0.0;
+    if (s->exists && n > 0 && (size_t)n < sizeof(wav_path)) status = worldcache_ensure(wav_path, &seconds);
+
+    worldx_mutex_lock(&p->lock);
+    WorldCachePrecacheReport* r = p->report;
+    r->done++;
+    if (!s->exists) {
+        r->missing++;
+    } else if (status == 0) {
+        r->current++;
+    } else if (status == 1) {
+        r->analyzed++;
+        r->audio_seconds += seconds;
+    } else {
+        r->failed++;
+    }
+    r->elapsed = now_sec() - p->start;
+    if (p->progress) p->progress(r, p->user);
+    worldx_mutex_unlock(&p->lock);
+}
+
+int worldcache_precache(const char* voicebank_dir, int threads, WorldCachePrecacheProgress progress,
+                        void* user, WorldCachePrecacheReport* report) {
+    WorldCachePrecacheReport local;
+    if (!report) report = &local;
+    memset(report, 0, sizeof(*report));
+    if (!voicebank_dir) return -1;
+
+    Precache p;
+    memset(&p, 0, sizeof(p));
+    p.dir = voicebank_dir;
+    p.report = report;
+    p.progress = progress;
+    p.user = user;
+    p.start = now_sec();
+
+    WorldCachePathList keys;
+    if (worldcache_voicebank_samples(voicebank_dir, &keys, &report->oto_files) != 0) return -1;
+    report->samples = (int)keys.count;
+    if (threads <= 0) threads = worldx_cpu_count();
+    if ((size_t)threads > keys.count) threads = keys.count > 0 ? (int)keys.count : 1;
+
+    /* Longest samples first, dealt round-robin over the workers' starting
+     * ranges so that each mixes long and short ones; stealing evens out the
+     * rest */
+    Sample* sorted = (Sample*)calloc(keys.count ? keys.count : 1, sizeof(Sample));
+    p.samples = (Sample*)calloc(keys.count ? keys.count : 1, sizeof(Sample));
+    if (!sorted || !p.samples || worldx_mutex_init(&p.lock) != 0) {
+        free(sorted);
+        free(p.samples);
+        worldcache_path_list_free(&keys);
+        return -1;
+    }
+    for (size_t i = 0; i < keys.count; i++) {
+        char wav_path[4096];
+        WorldCacheSourceId id;
+        sorted[i].key = keys.items[i];
+        int n = snprintf(wav_path, sizeof(wav_path), "%s/%s", voicebank_dir, keys.items[i]);
+        sorted[i].exists = n > 0 && (size_t)n < sizeof(wav_path) && worldcache_source_identify(wav_path, &id) == 0;
+        sorted[i].size = sorted[i].exists ? id.size : 0;
+    }
+    qsort(sorted, keys.count, sizeof(Sample), compare_size_desc);
+    size_t next = 0;
+    for (size_t k = 0; next < keys.count; k++) {
+        for (int t = 0; t < threads && next < keys.count; t++) {
+            size_t lo = keys.count * (size_t)t / (size_t)threads;
+            size_t hi = keys.count * (size_t)(t + 1) / (size_t)threads;
+            if (lo + k < hi) p.samples[lo + k] = sorted[next++];
+        }
+    }
+    free(sorted);
+
+    WorldxPoolStats stats;
+    worldx_pool_run(threads, keys.count, precache_job, &p, &stats);
+    report->threads = stats.threads;
+    report->elapsed = now_sec() - p.start;
+
+    worldx_mutex_destroy(&p.lock);
+    free(p.samples);
+    worldcache_path_list_free(&keys);
+    return report->failed ? 1 : 0;
+}
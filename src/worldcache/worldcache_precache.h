@@ -0,0 +1,40 @@
+#ifndef WORLDCACHE_PRECACHE_H
+#define WORLDCACHE_PRECACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Voicebank pre-analysis: fill the caches of every sample a voicebank's
+ * oto.ini files name (see worldcache_voicebank_samples) ahead of the first
+ * render, on a work-stealing pool (worldx_pool.h). Samples whose pack entry
+ * or sidecar is still current are skipped, so reruns only analyze what
+ * changed. */
+
+typedef struct {
+    int samples;          /* samples to cache */
+    int oto_files;        /* oto.ini files read (0: every .wav was taken) */
+    int threads;          /* workers used */
+    int done;             /* samples processed so far */
+    int current;          /* caches that were already current */
+    int analyzed;         /* samples analyzed and written */
+    int missing;          /* oto.ini entries without a WAV */
+    int failed;           /* WAVs that could not be analyzed or cached */
+    double audio_seconds; /* audio covered by the analyzed samples */
+    double elapsed;       /* wall time so far, seconds */
+} WorldCachePrecacheReport;
+
+/* Called after every sample with the totals so far; calls are serialized */
+typedef void (*WorldCachePrecacheProgress)(const WorldCachePrecacheReport* report, void* user);
+
+/* Precache voicebank_dir on `threads` workers (<= 0: one per CPU). progress
+ * and report may be NULL. Returns 0 when every sample ended up cached (or
+ * missing), 1 if some failed, -1 if the directory cannot be read. */
+int worldcache_precache(const char* voicebank_dir, int threads, WorldCachePrecacheProgress progress,
+                        void* user, WorldCachePrecacheReport* report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_PRECACHE_H */
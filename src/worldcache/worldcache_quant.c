@@ -0,0 +1,393 @@
+#include "worldcache_quant.h"
+#include "world_quality.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WORLDCACHE_QUANT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WORLDCACHE_QUANT_TARGET_SSE2
+#define WORLDCACHE_QUANT_TARGET_AVX2
+#else
+#define WORLDCACHE_QUANT_TARGET_SSE2 __attribute__((target("sse2")))
+#define WORLDCACHE_QUANT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#define SP_Q_MAX 32767
+#define AP_Q_MAX 255
+
+/* ap[j] = exp(AP_LOG_BASE + AP_LOG_STEP * q[j]) */
+#define AP_LOG_BASE ((float)(WORLDCACHE_QUANT_AP_DB_MIN * 0.11512925464970229))
+#define AP_LOG_STEP ((float)(-WORLDCACHE_QUANT_AP_DB_MIN / AP_Q_MAX * 0.11512925464970229))
+
+/* Reference analysis the codec is checked on before it is enabled */
+#define CHECK_SECONDS 1.0
+#define CHECK_FS 44100
+#define CHECK_FRAME_PERIOD 5.0
+#define CHECK_F0 220.0
+
+static int g_quantized = 0;
+
+/* ---- encoder ---- */
+
+static double log_sp(double v) {
+    if (!(v > 0.0)) return WORLDCACHE_QUANT_LOG_MIN;
+    double l = log(v);
+    if (l < WORLDCACHE_QUANT_LOG_MIN) return WORLDCACHE_QUANT_LOG_MIN;
+    return l > WORLDCACHE_QUANT_LOG_MAX ? WORLDCACHE_QUANT_LOG_MAX : l;
+}
+
+void worldcache_quant_encode_sp(const double* sp, uint32_t bins, uint32_t frame, float* recon, uint8_t* row) {
+    int key = worldcache_quant_is_key(frame);
+    double lo = HUGE_VAL, hi = -HUGE_VAL;
+    for (uint32_t j = 0; j < bins; j++) {
+        double r = log_sp(sp[j]) - (key ? 0.0 : recon[j]);
+        if (r < lo) lo = r;
+        if (r > hi) hi = r;
+    }
+    WorldCacheQuantFrame_t fr;
+    fr.offset = bins ? (float)(0.5 * (lo + hi)) : 0.0f;
+    double step = bins ? 0.5 * (hi - lo) / SP_Q_MAX : 0.0;
+    fr.step = step > WORLDCACHE_QUANT_SP_STEP_MIN ? (float)step : WORLDCACHE_QUANT_SP_STEP_MIN;
+    memcpy(row, &fr, sizeof(fr));
+
+    /* residuals are taken against the decoder's reconstruction, computed
+     * the way the decoder computes it */
+    uint8_t* q = row + sizeof(fr);
+    for (uint32_t j = 0; j < bins; j++) {
+        float base = key ? 0.0f : recon[j];
+        long v = lrint((log_sp(sp[j]) - base - fr.offset) / fr.step);
+        if (v > SP_Q_MAX) v = SP_Q_MAX;
+        if (v < -SP_Q_MAX) v = -SP_Q_MAX;
+        int16_t s = (int16_t)v;
+        memcpy(q + (size_t)j * sizeof(s), &s, sizeof(s));
+        recon[j] = base + (fr.offset + fr.step * (float)s);
+    }
+}
+
+void worldcache_quant_encode_ap(const double* ap, uint32_t bins, uint8_t* row) {
+    for (uint32_t j = 0; j < bins; j++) {
+        long v = 0;
+        if (ap[j] > 0.0) {
+            double db = 20.0 * log10(ap[j]);
+            v = lrint((db - WORLDCACHE_QUANT_AP_DB_MIN) / -WORLDCACHE_QUANT_AP_DB_MIN * AP_Q_MAX);
+        }
+        row[j] = (uint8_t)(v < 0 ? 0 : v > AP_Q_MAX ? AP_Q_MAX : v);
+    }
+}
+
+/* ---- decoder kernels ----
+ * exp is Cephes' expf (range reduction by ln 2, degree 5 polynomial), the
+ * same operations in every kernel. Inputs are clamped to the log range, so
+ * 2^n always stays a normal float. */
+
+#define EXP_LOG2E 1.44269504088896341f
+#define EXP_C1 0.693359375f
+#define EXP_C2 -2.12194440e-4f
+#define EXP_P0 1.9875691500e-4f
+#define EXP_P1 1.3981999507e-3f
+#define EXP_P2 8.3334519073e-3f
+#define EXP_P3 4.1665795894e-2f
+#define EXP_P4 1.6666665459e-1f
+#define EXP_P5 5.0000001201e-1f
+
+static float exp_scalar(float x) {
+    if (x < WORLDCACHE_QUANT_LOG_MIN) x = WORLDCACHE_QUANT_LOG_MIN;
+    if (x > WORLDCACHE_QUANT_LOG_MAX) x = WORLDCACHE_QUANT_LOG_MAX;
+    int32_t n = (int32_t)lrintf(x * EXP_LOG2E);
+    float fn = (float)n;
+    float r = x - fn * EXP_C1;
+    r = r - fn * EXP_C2;
+    float y = EXP_P0;
+    y = y * r + EXP_P1;
+    y = y * r + EXP_P2;
+    y = y * r + EXP_P3;
+    y = y * r + EXP_P4;
+    y = y * r + EXP_P5;
+    y = y * (r * r) + r + 1.0f;
+    int32_t bits = (n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return y * scale;
+}
+
+static int16_t load_q(const uint8_t* q, uint32_t j) {
+    int16_t v;
+    memcpy(&v, q + (size_t)j * sizeof(v), sizeof(v));
+    return v;
+}
+
+/* bins [j, bins) of an sp row */
+static void sp_tail(const uint8_t* q, uint32_t j, uint32_t bins, int key, const WorldCacheQuantFrame_t* fr,
+                    float* recon, float* sp) {
+    for (; j < bins; j++) {
+        float l = (key ? 0.0f : recon[j]) + (fr->offset + fr->step * (float)load_q(q, j));
+        recon[j] = l;
+        if (sp) sp[j] = exp_scalar(l);
+    }
+}
+
+static void ap_tail(const uint8_t* q, uint32_t j, uint32_t bins, float* ap) {
+    for (; j < bins; j++) ap[j] = exp_scalar(AP_LOG_BASE + AP_LOG_STEP * (float)q[j]);
+}
+
+#if defined(WORLDCACHE_QUANT_X86)
+WORLDCACHE_QUANT_TARGET_SSE2
+static __m128 exp_sse2(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(WORLDCACHE_QUANT_LOG_MIN)), _mm_set1_ps(WORLDCACHE_QUANT_LOG_MAX));
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)));
+    __m128 fn = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(EXP_C1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(fn, _mm_set1_ps(EXP_C2)));
+    __m128 y = _mm_set1_ps(EXP_P0);
+    y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(EXP_P1));
+    y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(EXP_P2));
+    y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(EXP_P3));
+    y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(EXP_P4));
+    y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(EXP_P5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(r, r)), r), _mm_set1_ps(1.0f));
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(bits));
+}
+
+WORLDCACHE_QUANT_TARGET_SSE2
+static void sp_quad_sse2(__m128i q, uint32_t j, int key, __m128 offset, __m128 step, float* recon, float* sp) {
+    __m128 d = _mm_add_ps(offset, _mm_mul_ps(step, _mm_cvtepi32_ps(q)));
+    __m128 l = _mm_add_ps(key ? _mm_setzero_ps() : _mm_loadu_ps(recon + j), d);
+    _mm_storeu_ps(recon + j, l);
+    if (sp) _mm_storeu_ps(sp + j, exp_sse2(l));
+}
+
+WORLDCACHE_QUANT_TARGET_SSE2
+static void decode_sp_sse2(const uint8_t* q, uint32_t bins, int key, const WorldCacheQuantFrame_t* fr,
+                           float* recon, float* sp) {
+    __m128 offset = _mm_set1_ps(fr->offset);
+    __m128 step = _mm_set1_ps(fr->step);
+    uint32_t j = 0;
+    for (; j + 8 <= bins; j += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(q + (size_t)j * 2));
+        sp_quad_sse2(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), j, key, offset, step, recon, sp);
+        sp_quad_sse2(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), j + 4, key, offset, step, recon, sp);
+    }
+    sp_tail(q, j, bins, key, fr, recon, sp);
+}
+
+WORLDCACHE_QUANT_TARGET_SSE2
+static void decode_ap_sse2(const uint8_t* q, uint32_t bins, float* ap) {
+    __m128 base = _mm_set1_ps(AP_LOG_BASE);
+    __m128 step = _mm_set1_ps(AP_LOG_STEP);
+    __m128i zero = _mm_setzero_si128();
+    uint32_t j = 0;
+    for (; j + 16 <= bins; j += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(q + j));
+        __m128i w[2] = { _mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero) };
+        for (int h = 0; h < 2; h++) {
+            __m128i d[2] = { _mm_unpacklo_epi16(w[h], zero), _mm_unpackhi_epi16(w[h], zero) };
+            for (int k = 0; k < 2; k++) {
+                __m128 x = _mm_add_ps(base, _mm_mul_ps(step, _mm_cvtepi32_ps(d[k])));
+                _mm_storeu_ps(ap + j + 8 * h + 4 * k, exp_sse2(x));
+            }
+        }
+    }
+    ap_tail(q, j, bins, ap);
+}
+
+WORLDCACHE_QUANT_TARGET_AVX2
+static __m256 exp_avx2(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(WORLDCACHE_QUANT_LOG_MIN)),
+                      _mm256_set1_ps(WORLDCACHE_QUANT_LOG_MAX));
+    __m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(EXP_LOG2E)));
+    __m256 fn = _mm256_cvtepi32_ps(n);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(fn, _mm256_set1_ps(EXP_C1)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(fn, _mm256_set1_ps(EXP_C2)));
+    __m256 y = _mm256_set1_ps(EXP_P0);
+    y = _mm256_add_ps(_mm256_mul_ps(y, r), _mm256_set1_ps(EXP_P1));
+    y = _mm256_add_ps(_mm256_mul_ps(y, r), _mm256_set1_ps(EXP_P2));
+    y = _mm256_add_ps(_mm256_mul_ps(y, r), _mm256_set1_ps(EXP_P3));
+    y = _mm256_add_ps(_mm256_mul_ps(y, r), _mm256_set1_ps(EXP_P4));
+    y = _mm256_add_ps(_mm256_mul_ps(y, r), _mm256_set1_ps(EXP_P5));
+    y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0f));
+    __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(bits));
+}
+
+WORLDCACHE_QUANT_TARGET_AVX2
+static void decode_sp_avx2(const uint8_t* q, uint32_t bins, int key, const WorldCacheQuantFrame_t* fr,
+                           float* recon, float* sp) {
+    __m256 offset = _mm256_set1_ps(fr->offset);
+    __m256 step = _mm256_set1_ps(fr->step);
+    uint32_t j = 0;
+    for (; j + 8 <= bins; j += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(const void*)(q + (size_t)j * 2)));
+        __m256 d = _mm256_add_ps(offset, _mm256_mul_ps(step, _mm256_cvtepi32_ps(v)));
+        __m256 l = _mm256_add_ps(key ? _mm256_setzero_ps() : _mm256_loadu_ps(recon + j), d);
+        _mm256_storeu_ps(recon + j, l);
+        if (sp) _mm256_storeu_ps(sp + j, exp_avx2(l));
+    }
+    sp_tail(q, j, bins, key, fr, recon, sp);
+}
+
+WORLDCACHE_QUANT_TARGET_AVX2
+static void decode_ap_avx2(const uint8_t* q, uint32_t bins, float* ap) {
+    __m256 base = _mm256_set1_ps(AP_LOG_BASE);
+    __m256 step = _mm256_set1_ps(AP_LOG_STEP);
+    uint32_t j = 0;
+    for (; j + 8 <= bins; j += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(const void*)(q + j)));
+        __m256 x = _mm256_add_ps(base, _mm256_mul_ps(step, _mm256_cvtepi32_ps(v)));
+        _mm256_storeu_ps(ap + j, exp_avx2(x));
+    }
+    ap_tail(q, j, bins, ap);
+}
+#endif
+
+void worldcache_quant_decode_sp(const uint8_t* row, uint32_t bins, uint32_t frame, float* recon, float* sp,
+                                WorldFlagsIsa isa) {
+    WorldCacheQuantFrame_t fr;
+    memcpy(&fr, row, sizeof(fr));
+    const uint8_t* q = row + sizeof(fr);
+    int key = worldcache_quant_is_key(frame);
+#if defined(WORLDCACHE_QUANT_X86)
+    if (isa >= WORLD_FLAGS_ISA_AVX2) {
+        decode_sp_avx2(q, bins, key, &fr, recon, sp);
+        return;
+    }
+    if (isa >= WORLD_FLAGS_ISA_SSE2) {
+        decode_sp_sse2(q, bins, key, &fr, recon, sp);
+        return;
+    }
+#else
+    (void)isa;
+#endif
+    sp_tail(q, 0, bins, key, &fr, recon, sp);
+}
+
+void worldcache_quant_decode_ap(const uint8_t* row, uint32_t bins, float* ap, WorldFlagsIsa isa) {
+#if defined(WORLDCACHE_QUANT_X86)
+    if (isa >= WORLD_FLAGS_ISA_AVX2) {
+        decode_ap_avx2(row, bins, ap);
+        return;
+    }
+    if (isa >= WORLD_FLAGS_ISA_SSE2) {
+        decode_ap_sse2(row, bins, ap);
+        return;
+    }
+#else
+    (void)isa;
+#endif
+    ap_tail(row, 0, bins, ap);
+}
+
+/* ---- whole analyses ---- */
+
+int worldcache_quant_encode_analysis(const WorldAnalysisData* data, uint8_t** sp, uint8_t** ap) {
+    if (!data || !sp || !ap || data->f0_length <= 0 || data->fft_size <= 0) return -1;
+    uint32_t bins = (uint32_t)(data->fft_size / 2 + 1);
+    size_t frames = (size_t)data->f0_length;
+    size_t sp_row = worldcache_quant_sp_row_bytes(bins), ap_row = worldcache_quant_ap_row_bytes(bins);
+    *sp = (uint8_t*)malloc(frames * sp_row);
+    *ap = (uint8_t*)malloc(frames * ap_row);
+    double* sp_frame = (double*)malloc(sizeof(double) * bins * 2);
+    float* recon = (float*)calloc(bins, sizeof(float));
+    int result = *sp && *ap && sp_frame && recon ? 0 : -1;
+    for (size_t i = 0; result == 0 && i < frames; i++) {
+        /* rows in any representation, as double */
+        double* ap_frame = sp_frame + bins;
+        result = world_analysis_data_get_frame(data, (int)i, sp_frame, ap_frame);
+        if (result != 0) break;
+        worldcache_quant_encode_sp(sp_frame, bins, (uint32_t)i, recon, *sp + i * sp_row);
+        worldcache_quant_encode_ap(ap_frame, bins, *ap + i * ap_row);
+    }
+    free(sp_frame);
+    free(recon);
+    if (result != 0) {
+        free(*sp);
+        free(*ap);
+        *sp = *ap = NULL;
+    }
+    return result;
+}
+
+/* Double analysis with data's geometry and F0 */
+static int allocate_like(WorldAnalysisData* out, const WorldAnalysisData* data) {
+    world_analysis_data_init(out);
+    if (world_analysis_data_allocate(out, data->f0_length, data->fft_size) != 0) return -1;
+    out->frame_period = data->frame_period;
+    out->sample_rate = data->sample_rate;
+    out->x_length = data->x_length;
+    out->f0_estimator = data->f0_estimator;
+    memcpy(out->f0, data->f0, sizeof(double) * (size_t)data->f0_length);
+    memcpy(out->temporal_positions, data->temporal_positions, sizeof(double) * (size_t)data->f0_length);
+    return 0;
+}
+
+int worldcache_quant_check(const WorldAnalysisData* data, WorldCacheQuantQuality* quality) {
+    if (!data || !quality || data->f0_length <= 0 || data->fft_size <= 0 || data->x_length <= 0) return -1;
+    memset(quality, 0, sizeof(*quality));
+    uint32_t bins = (uint32_t)(data->fft_size / 2 + 1);
+    size_t sp_row = worldcache_quant_sp_row_bytes(bins), ap_row = worldcache_quant_ap_row_bytes(bins);
+    WorldFlagsIsa isa = world_flags_detect_isa();
+
+    WorldAnalysisData ref, decoded;
+    uint8_t *sp = NULL, *ap = NULL;
+    float* rows = (float*)malloc(sizeof(float) * bins * 3);
+    double* y_ref = (double*)malloc(sizeof(double) * (size_t)data->x_length);
+    double* y = (double*)malloc(sizeof(double) * (size_t)data->x_length);
+    int result = allocate_like(&ref, data) | allocate_like(&decoded, data);
+    if (!rows || !y_ref || !y || worldcache_quant_encode_analysis(data, &sp, &ap) != 0) result = -1;
+    for (int i = 0; result == 0 && i < data->f0_length; i++) {
+        float* recon = rows + 2 * bins;
+        worldcache_quant_decode_sp(sp + (size_t)i * sp_row, bins, (uint32_t)i, recon, rows, isa);
+        worldcache_quant_decode_ap(ap + (size_t)i * ap_row, bins, rows + bins, isa);
+        for (uint32_t j = 0; j < bins; j++) {
+            decoded.spectrogram[i][j] = rows[j];
+            decoded.aperiodicity[i][j] = rows[bins + j];
+        }
+        result = world_analysis_data_get_frame(data, i, ref.spectrogram[i], ref.aperiodicity[i]);
+    }
+    if (result == 0 && (world_synthesize(&ref, y_ref, data->x_length) != 0 ||
+                        world_synthesize(&decoded, y, data->x_length) != 0)) {
+        result = -1;
+    }
+    if (result == 0) {
+        quality->snr_db = world_quality_snr_db(y_ref, y, data->x_length);
+        quality->mcd_db = world_quality_mcd_db((const double* const*)ref.spectrogram,
+                                               (const double* const*)decoded.spectrogram, data->f0_length,
+                                               data->fft_size, data->sample_rate);
+        if (quality->mcd_db < 0.0) result = -1;
+        quality->passed = result == 0 && quality->snr_db >= WORLD_QUALITY_MIN_SNR_DB &&
+                          quality->mcd_db <= WORLD_QUALITY_MAX_MCD_DB;
+    }
+    free(sp);
+    free(ap);
+    free(rows);
+    free(y_ref);
+    free(y);
+    world_analysis_data_free(&ref);
+    world_analysis_data_free(&decoded);
+    return result;
+}
+
+int worldcache_set_quantized(int enable, WorldCacheQuantQuality* quality) {
+    WorldCacheQuantQuality local;
+    if (!quality) quality = &local;
+    memset(quality, 0, sizeof(*quality));
+    if (!enable) {
+        g_quantized = 0;
+        return 0;
+    }
+    WorldAnalysisData ref;
+    world_analysis_data_init(&ref);
+    int result = world_generate_dummy_data(&ref, CHECK_SECONDS, CHECK_FS, CHECK_FRAME_PERIOD, CHECK_F0) == 0 &&
+                 worldcache_quant_check(&ref, quality) == 0 && quality->passed
+                     ? 0
+                     : -1;
+    world_analysis_data_free(&ref);
+    g_quantized = result == 0;
+    return result;
+}
+
+int worldcache_quantized(void) { return g_quantized; }
@@ -0,0 +1,93 @@
+#ifndef WORLDCACHE_QUANT_H
+#define WORLDCACHE_QUANT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "worldcache_format.h"
+#include "world_flags.h"
+#include "world_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lossy quantized sp/ap blocks (WORLDCACHE_FLAG_QUANTIZED).
+ *
+ * sp rows hold the log spectral envelope as int16 steps, delta coded
+ * against the previous frame's reconstruction (closed loop, so errors do
+ * not accumulate); frames at multiples of WORLDCACHE_QUANT_KEY_FRAMES are
+ * coded on their own so a range decodes from the key frame before it. Each
+ * row starts with the frame's offset and step:
+ *   WorldCacheQuantFrame_t, then int16_t q[bins]
+ *   log sp[j] = (key ? 0 : log sp_prev[j]) + offset + step * q[j]
+ * ap rows hold one byte per bin, linear in dB over
+ * [WORLDCACHE_QUANT_AP_DB_MIN, 0]. Both decode to float32 rows. */
+
+#define WORLDCACHE_QUANT_KEY_FRAMES 32
+
+/* Finest sp step (nepers); coarser frames still use the full int16 range */
+#define WORLDCACHE_QUANT_SP_STEP_MIN (1.0f / 1024.0f)
+
+/* Log sp is clamped to what a normal float can hold */
+#define WORLDCACHE_QUANT_LOG_MIN (-87.0f)
+#define WORLDCACHE_QUANT_LOG_MAX 88.0f
+
+/* WORLD's aperiodicity floor is 0.001 */
+#define WORLDCACHE_QUANT_AP_DB_MIN (-60.0)
+
+#pragma pack(push,1)
+typedef struct {
+    float offset;
+    float step;
+} WorldCacheQuantFrame_t;
+#pragma pack(pop)
+
+static inline size_t worldcache_quant_sp_row_bytes(uint32_t bins) {
+    return sizeof(WorldCacheQuantFrame_t) + (size_t)bins * sizeof(int16_t);
+}
+static inline size_t worldcache_quant_ap_row_bytes(uint32_t bins) { return bins; }
+
+static inline int worldcache_quant_is_key(uint32_t frame) { return frame % WORLDCACHE_QUANT_KEY_FRAMES == 0; }
+
+/* Encode one sp row of frame `frame`. recon holds the previous frame's
+ * reconstruction (log domain, bins floats; ignored on key frames) and
+ * receives this frame's. */
+void worldcache_quant_encode_sp(const double* sp, uint32_t bins, uint32_t frame, float* recon, uint8_t* row);
+void worldcache_quant_encode_ap(const double* ap, uint32_t bins, uint8_t* row);
+
+/* Decode one sp row, updating recon as the encoder did; sp may be NULL for
+ * frames only needed as predictors. The kernels run on isa (at most
+ * world_flags_detect_isa()) and agree with the scalar ones to float
+ * rounding. */
+void worldcache_quant_decode_sp(const uint8_t* row, uint32_t bins, uint32_t frame, float* recon, float* sp,
+                                WorldFlagsIsa isa);
+void worldcache_quant_decode_ap(const uint8_t* row, uint32_t bins, float* ap, WorldFlagsIsa isa);
+
+/* Encode every frame of data (double or float32, not coded) into newly
+ * allocated sp and ap blocks, freed by the caller. Returns 0 on success. */
+int worldcache_quant_encode_analysis(const WorldAnalysisData* data, uint8_t** sp, uint8_t** ap);
+
+/* Round trip of data through the codec, measured against the PRD
+ * thresholds of world_quality.h: MCD of the decoded envelope and SNR of
+ * its re-synthesis against data's own */
+typedef struct {
+    double mcd_db;
+    double snr_db;
+    int passed;
+} WorldCacheQuantQuality;
+
+/* Returns 0 when the measurement ran (see quality->passed), -1 on failure */
+int worldcache_quant_check(const WorldAnalysisData* data, WorldCacheQuantQuality* quality);
+
+/* Write new caches quantized (worldcache_make_header). Enabling checks the
+ * codec on a reference analysis first and fails, leaving it off, unless it
+ * passes; quality (may be NULL) receives the measurement. Returns 0 on
+ * success. */
+int worldcache_set_quantized(int enable, WorldCacheQuantQuality* quality);
+int worldcache_quantized(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_QUANT_H */
@@ -1,57 +1,80 @@
 #include "worldcache_serialize.h"
+#include "worldcache_dict.h"
+#include "worldcache_source.h"
 #include <stdlib.h>
 #include <string.h>
 #if defined(USE_ZSTD)
 #include <zstd.h>
 #endif
 
+static int compress_blocks(const WorldCacheHeader_t* h, const uint8_t* sp, const uint8_t* ap,
+                           const uint8_t* voiced_mask, uint32_t chunk_frames,
+                           const WorldCacheCompression* opts, size_t reserve, uint8_t** out_buf,
+                           size_t* out_size);
+
+static uint64_t checksum(const void* data, uint64_t size) {
+    WorldCacheHash s;
+    worldcache_hash_init(&s);
+    worldcache_hash_update(&s, data, (size_t)size);
+    return worldcache_hash_final(&s);
+}
+
 int worldcache_serialize(const WorldCacheHeader_t* h,
                          const uint8_t* sp, const uint8_t* ap, const uint8_t* voiced_mask,
                          uint8_t** out_buf, size_t* out_size) {
-    if (!h || !out_buf || !out_size) return -1;
-    /* If compression requested and compiled with zstd, compress concatenated payload */
+    if (!h || !out_buf || !out_size || worldcache_header_is_v1(h)) return -1;
+    WorldCacheHeader_t hc = *h;
+    WorldCacheSection_t s[3];
+    const uint8_t* src[3] = { sp, ap, voiced_mask };
+    uint8_t* chunks = NULL;
+    memset(s, 0, sizeof(s));
+    uint32_t codec = (h->flags & WORLDCACHE_FLAG_QUANTIZED) ? WORLDCACHE_CODEC_QUANTIZED : WORLDCACHE_CODEC_RAW;
+    s[0].type = WORLDCACHE_SECTION_SP; s[0].codec = codec; s[0].size = h->sp_size;
+    s[1].type = WORLDCACHE_SECTION_AP; s[1].codec = codec; s[1].size = h->ap_size;
+    s[2].type = WORLDCACHE_SECTION_F0; s[2].size = h->voiced_mask_size;
+    uint32_t count = 3;
+    /* If compression requested and compiled with zstd, compress sp and ap in chunks */
 #if defined(USE_ZSTD)
     if (h->flags & WORLDCACHE_FLAG_COMPRESSED) {
-        size_t payload_size = (size_t)h->sp_size + (size_t)h->ap_size + (size_t)h->voiced_mask_size;
-        uint8_t* payload = (uint8_t*)malloc(payload_size);
-        if (!payload) return -1;
-        uint8_t* q = payload;
-        if (h->sp_size) { memcpy(q, sp, h->sp_size); q += h->sp_size; }
-        if (h->ap_size) { memcpy(q, ap, h->ap_size); q += h->ap_size; }
-        if (h->voiced_mask_size) { memcpy(q, voiced_mask, h->voiced_mask_size); q += h->voiced_mask_size; }
-
-        size_t max_csize = ZSTD_compressBound(payload_size);
-        uint8_t* cbuf = (uint8_t*)malloc(max_csize);
-        if (!cbuf) { free(payload); return -1; }
-        size_t csize = ZSTD_compress(cbuf, max_csize, payload, payload_size, 1);
-        free(payload);
-        if (ZSTD_isError(csize)) { free(cbuf); return -1; }
-
-        size_t total = sizeof(WorldCacheHeader_t) + csize + sizeof(uint64_t); /* store uncompressed size */
-        uint8_t* buf = (uint8_t*)malloc(total);
-        if (!buf) { free(cbuf); return -1; }
-        uint8_t* p = buf;
-        memcpy(p, h, sizeof(WorldCacheHeader_t)); p += sizeof(WorldCacheHeader_t);
-        /* write uncompressed payload size as u64 */
-        uint64_t ulen = (uint64_t)payload_size;
-        memcpy(p, &ulen, sizeof(ulen)); p += sizeof(ulen);
-        memcpy(p, cbuf, csize); p += csize;
-        free(cbuf);
-        *out_buf = buf; *out_size = total; return 0;
+        size_t chunks_size = 0;
+        if (compress_blocks(h, sp, ap, voiced_mask, WORLDCACHE_CHUNK_FRAMES, NULL, 0, &chunks, &chunks_size) != 0) {
+            return -1;
+        }
+        hc.flags = (uint16_t)((hc.flags | WORLDCACHE_FLAG_CHUNKED) & ~WORLDCACHE_FLAG_DICT);
+        s[0].type = WORLDCACHE_SECTION_CHUNKS; s[0].codec = WORLDCACHE_CODEC_ZSTD; s[0].size = chunks_size;
+        s[1] = s[2];
+        src[0] = chunks;
+        src[1] = voiced_mask;
+        count = 2;
     }
+#else
+    /* a compressed header over a raw payload would be unreadable */
+    if (h->flags & WORLDCACHE_FLAG_COMPRESSED) return -1;
 #endif
 
-    /* default: no compression */
-    size_t total = sizeof(WorldCacheHeader_t) + (size_t)h->sp_size + (size_t)h->ap_size + (size_t)h->voiced_mask_size;
-    uint8_t* buf = (uint8_t*)malloc(total);
-    if (!buf) return -1;
-    uint8_t* p = buf;
-    memcpy(p, h, sizeof(WorldCacheHeader_t)); p += sizeof(WorldCacheHeader_t);
-    if (h->sp_size) { memcpy(p, sp, h->sp_size); p += h->sp_size; }
-    if (h->ap_size) { memcpy(p, ap, h->ap_size); p += h->ap_size; }
-    if (h->voiced_mask_size) { memcpy(p, voiced_mask, h->voiced_mask_size); p += h->voiced_mask_size; }
+    hc.section_count = count;
+    uint64_t total = worldcache_sections_place(s, count);
+    uint8_t* buf = total <= SIZE_MAX ? (uint8_t*)calloc(1, (size_t)total) : NULL;
+    if (!buf) { free(chunks); return -1; }
+    for (uint32_t i = 0; i < count; i++) {
+        if (s[i].size) memcpy(buf + s[i].offset, src[i], (size_t)s[i].size);
+        s[i].checksum = checksum(buf + s[i].offset, s[i].size);
+    }
+    memcpy(buf, &hc, sizeof(hc));
+    memcpy(buf + sizeof(hc), s, sizeof(*s) * count);
+    free(chunks);
     *out_buf = buf;
-    *out_size = total;
+    *out_size = (size_t)total;
+    return 0;
+}
+
+/* Copy of a section into a new block (NULL for an empty one) */
+static int copy_section(const uint8_t* buf, const WorldCacheSection_t* s, uint64_t size, uint8_t** out) {
+    *out = NULL;
+    if (!s || s->size != size) return -1;
+    if (size == 0) return 0;
+    if (size > SIZE_MAX || !(*out = (uint8_t*)malloc((size_t)size))) return -1;
+    memcpy(*out, buf + s->offset, (size_t)size);
     return 0;
 }
 
@@ -59,66 +82,49 @@ int worldcache_deserialize(const uint8_t* buf, size_t buf_size,
                            WorldCacheHeader_t* out_h,
                            uint8_t** out_sp, uint8_t** out_ap, uint8_t** out_voiced_mask) {
     if (!buf || !out_h || !out_sp || !out_ap || !out_voiced_mask) return -1;
-    if (buf_size < sizeof(WorldCacheHeader_t)) return -1;
-    const uint8_t* p = buf;
-    memcpy(out_h, p, sizeof(WorldCacheHeader_t)); p += sizeof(WorldCacheHeader_t);
-    size_t remaining = buf_size - sizeof(WorldCacheHeader_t);
-    /* If compressed, read ulen and decompress payload then split */
+    *out_sp = *out_ap = *out_voiced_mask = NULL;
+    WorldCacheSection_t s[WORLDCACHE_MAX_SECTIONS];
+    uint32_t count;
+    if (worldcache_header_parse(buf, buf_size, out_h) != 0 ||
+        worldcache_image_sections(buf, buf_size, out_h, s, &count) != 0) {
+        return -1;
+    }
+    const WorldCacheSection_t* f0 = worldcache_sections_find(s, count, WORLDCACHE_SECTION_F0);
+    /* If compressed, decode every chunk straight into the blocks */
 #if defined(USE_ZSTD)
     if (out_h->flags & WORLDCACHE_FLAG_COMPRESSED) {
-        if (remaining < sizeof(uint64_t)) return -1;
-        uint64_t ulen = 0;
-        memcpy(&ulen, p, sizeof(ulen)); p += sizeof(ulen);
-        size_t csize = remaining - sizeof(ulen);
-        const void* cptr = p;
-        size_t payload_size = (size_t)ulen;
-        uint8_t* payload = (uint8_t*)malloc(payload_size);
-        if (!payload) return -1;
-        size_t dres = ZSTD_decompress(payload, payload_size, cptr, csize);
-        if (ZSTD_isError(dres) || dres != payload_size) { free(payload); return -1; }
-        /* now split payload into blocks */
-        const uint8_t* q = payload;
-        if (out_h->sp_size) {
-            *out_sp = (uint8_t*)malloc(out_h->sp_size);
-            if (!*out_sp) { free(payload); return -1; }
-            memcpy(*out_sp, q, out_h->sp_size); q += out_h->sp_size;
-        } else { *out_sp = NULL; }
-        if (out_h->ap_size) {
-            *out_ap = (uint8_t*)malloc(out_h->ap_size);
-            if (!*out_ap) { free(payload); free(*out_sp); return -1; }
-            memcpy(*out_ap, q, out_h->ap_size); q += out_h->ap_size;
-        } else { *out_ap = NULL; }
-        if (out_h->voiced_mask_size) {
-            *out_voiced_mask = (uint8_t*)malloc(out_h->voiced_mask_size);
-            if (!*out_voiced_mask) { free(payload); free(*out_sp); free(*out_ap); return -1; }
-            memcpy(*out_voiced_mask, q, out_h->voiced_mask_size); q += out_h->voiced_mask_size;
-        } else { *out_voiced_mask = NULL; }
-        free(payload);
-        return 0;
+        const WorldCacheSection_t* chunks = worldcache_sections_find(s, count, WORLDCACHE_SECTION_CHUNKS);
+        int result = chunks && out_h->sp_size <= SIZE_MAX && out_h->ap_size <= SIZE_MAX &&
+                     out_h->voiced_mask_size <= SIZE_MAX ? 0 : -1;
+        if (result == 0) {
+            *out_sp = (uint8_t*)malloc(out_h->sp_size ? (size_t)out_h->sp_size : 1);
+            *out_ap = (uint8_t*)malloc(out_h->ap_size ? (size_t)out_h->ap_size : 1);
+            *out_voiced_mask = (uint8_t*)malloc(out_h->voiced_mask_size ? (size_t)out_h->voiced_mask_size : 1);
+            if (!*out_sp || !*out_ap || !*out_voiced_mask ||
+                worldcache_decompress_chunks(out_h, buf + chunks->offset, (size_t)chunks->size, *out_sp, *out_ap,
+                                             *out_voiced_mask) != 0) {
+                result = -1;
+            }
+        }
+        /* F0 has its own section unless the chunks carry it */
+        if (result == 0 && worldcache_header_chunk_blocks(out_h) < 3) {
+            if (!f0 || f0->size != out_h->voiced_mask_size) result = -1;
+            else memcpy(*out_voiced_mask, buf + f0->offset, (size_t)f0->size);
+        }
+        if (result != 0) {
+            worldcache_free_blocks(*out_sp, *out_ap, *out_voiced_mask);
+            *out_sp = *out_ap = *out_voiced_mask = NULL;
+        }
+        return result;
     }
 #endif
 
-    if (remaining < (size_t)out_h->sp_size + (size_t)out_h->ap_size + (size_t)out_h->voiced_mask_size) return -1;
-    if (out_h->sp_size) {
-        *out_sp = (uint8_t*)malloc(out_h->sp_size);
-        if (!*out_sp) return -1;
-        memcpy(*out_sp, p, out_h->sp_size); p += out_h->sp_size;
-    } else {
-        *out_sp = NULL;
-    }
-    if (out_h->ap_size) {
-        *out_ap = (uint8_t*)malloc(out_h->ap_size);
-        if (!*out_ap) { free(*out_sp); return -1; }
-        memcpy(*out_ap, p, out_h->ap_size); p += out_h->ap_size;
-    } else {
-        *out_ap = NULL;
-    }
-    if (out_h->voiced_mask_size) {
-        *out_voiced_mask = (uint8_t*)malloc(out_h->voiced_mask_size);
-        if (!*out_voiced_mask) { free(*out_sp); free(*out_ap); return -1; }
-        memcpy(*out_voiced_mask, p, out_h->voiced_mask_size); p += out_h->voiced_mask_size;
-    } else {
-        *out_voiced_mask = NULL;
+    if (copy_section(buf, worldcache_sections_find(s, count, WORLDCACHE_SECTION_SP), out_h->sp_size, out_sp) != 0 ||
+        copy_section(buf, worldcache_sections_find(s, count, WORLDCACHE_SECTION_AP), out_h->ap_size, out_ap) != 0 ||
+        copy_section(buf, f0, out_h->voiced_mask_size, out_voiced_mask) != 0) {
+        worldcache_free_blocks(*out_sp, *out_ap, *out_voiced_mask);
+        *out_sp = *out_ap = *out_voiced_mask = NULL;
+        return -1;
     }
     return 0;
 }
@@ -128,3 +134,208 @@ void worldcache_free_blocks(uint8_t* sp, uint8_t* ap, uint8_t* voiced_mask) {
     if (ap) free(ap);
     if (voiced_mask) free(voiced_mask);
 }
+
+static int g_compression_level = 1;
+
+void worldcache_set_compression_level(int level) { g_compression_level = level; }
+int worldcache_compression_level(void) { return g_compression_level; }
+
+#if defined(USE_ZSTD)
+/* Bytes per frame of each block in the chunks (0 for F0 where it has its
+ * own section); -1 if a block does not divide into frames */
+static int frame_rows(const WorldCacheHeader_t* h, size_t rows[3]) {
+    if (h->num_frames == 0) return -1;
+    const uint64_t sizes[3] = { h->sp_size, h->ap_size, h->voiced_mask_size };
+    for (int b = 0; b < 3; b++) {
+        rows[b] = b < worldcache_header_chunk_blocks(h) ? (size_t)(sizes[b] / h->num_frames) : 0;
+        if (b < worldcache_header_chunk_blocks(h) && (uint64_t)rows[b] * h->num_frames != sizes[b]) return -1;
+    }
+    return 0;
+}
+
+/* Growable output of the chunk compressor */
+typedef struct {
+    uint8_t* buf;
+    size_t pos, capacity;
+} Output;
+
+/* Feed size bytes at src to the frame being compressed; ZSTD_e_end also
+ * flushes the frame epilogue */
+static int stream_in(ZSTD_CCtx* cctx, Output* o, const void* src, size_t size, ZSTD_EndDirective mode) {
+    ZSTD_inBuffer in = { src, size, 0 };
+    for (;;) {
+        if (o->pos == o->capacity) {
+            uint8_t* grown = (uint8_t*)realloc(o->buf, o->capacity * 2);
+            if (!grown) return -1;
+            o->buf = grown;
+            o->capacity *= 2;
+        }
+        ZSTD_outBuffer out = { o->buf, o->capacity, o->pos };
+        size_t left = ZSTD_compressStream2(cctx, &out, &in, mode);
+        o->pos = out.pos;
+        if (ZSTD_isError(left)) return -1;
+        if (mode == ZSTD_e_end ? left == 0 : in.pos == in.size) return 0;
+    }
+}
+
+/* Set the level, or the dictionary (which carries its own) */
+static int configure(ZSTD_CCtx* cctx, const WorldCacheCompression* opts) {
+    int level = opts && opts->level ? opts->level : g_compression_level;
+    if (opts && opts->dict) {
+        const ZSTD_CDict* cdict = worldcache_dict_cdict(opts->dict, level);
+        return cdict && !ZSTD_isError(ZSTD_CCtx_refCDict(cctx, cdict)) ? 0 : -1;
+    }
+    return ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level)) ? -1 : 0;
+}
+#endif
+
+int worldcache_compress_rows(const WorldCacheHeader_t* h, WorldCacheRowFn row, const void* ctx,
+                             uint32_t chunk_frames, const WorldCacheCompression* opts, size_t reserve,
+                             uint8_t** out_buf, size_t* out_size) {
+#if defined(USE_ZSTD)
+    size_t rows[3];
+    if (!h || !row || !out_buf || !out_size || chunk_frames == 0 || frame_rows(h, rows) != 0) return -1;
+    WorldCacheChunkIndex_t index;
+    index.chunk_frames = chunk_frames;
+    index.chunk_count = (h->num_frames + chunk_frames - 1) / chunk_frames;
+    size_t index_size = sizeof(index) + (size_t)index.chunk_count * sizeof(uint64_t);
+    size_t payload = (size_t)h->num_frames * (rows[0] + rows[1] + rows[2]);
+
+    /* start at a quarter of the payload and grow as needed */
+    Output o;
+    o.pos = reserve + index_size;
+    o.capacity = o.pos + payload / 4 + 4096;
+    o.buf = (uint8_t*)malloc(o.capacity);
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    int result = o.buf && cctx && configure(cctx, opts) == 0 ? 0 : -1;
+    for (uint32_t c = 0; result == 0 && c < index.chunk_count; c++) {
+        uint32_t first = c * chunk_frames;
+        uint32_t n = h->num_frames - first < chunk_frames ? h->num_frames - first : chunk_frames;
+        if (ZSTD_isError(ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only)) ||
+            ZSTD_isError(ZSTD_CCtx_setPledgedSrcSize(cctx, (unsigned long long)n * (rows[0] + rows[1] + rows[2])))) {
+            result = -1;
+            break;
+        }
+        for (int b = 0; result == 0 && b < 3; b++) {
+            if (rows[b] == 0) continue;
+            /* span of adjacent rows not yet fed */
+            const uint8_t* span = NULL;
+            size_t span_size = 0;
+            for (uint32_t i = first; result == 0 && i < first + n; i++) {
+                const uint8_t* p = (const uint8_t*)row(ctx, b, i);
+                if (!p) {
+                    result = -1;
+                } else if (span && p == span + span_size) {
+                    span_size += rows[b];
+                } else {
+                    if (span_size) result = stream_in(cctx, &o, span, span_size, ZSTD_e_continue);
+                    span = p;
+                    span_size = rows[b];
+                }
+            }
+            if (result == 0 && span_size) result = stream_in(cctx, &o, span, span_size, ZSTD_e_continue);
+        }
+        if (result == 0) result = stream_in(cctx, &o, NULL, 0, ZSTD_e_end);
+        uint64_t end = (uint64_t)(o.pos - reserve - index_size);
+        if (result == 0) memcpy(o.buf + reserve + sizeof(index) + (size_t)c * sizeof(end), &end, sizeof(end));
+    }
+    if (cctx) ZSTD_freeCCtx(cctx);
+    if (result != 0) { free(o.buf); return -1; }
+    memcpy(o.buf + reserve, &index, sizeof(index));
+    *out_buf = o.buf;
+    *out_size = o.pos;
+    return 0;
+#else
+    (void)h; (void)row; (void)ctx; (void)chunk_frames; (void)opts; (void)reserve; (void)out_buf; (void)out_size;
+    return -1;
+#endif
+}
+
+/* Rows of contiguous blocks */
+typedef struct {
+    const uint8_t* blocks[3];
+    size_t rows[3];
+} BlockRows;
+
+static const void* block_rows_row(const void* ctx, int block, uint32_t frame) {
+    const BlockRows* r = (const BlockRows*)ctx;
+    return r->blocks[block] + (size_t)frame * r->rows[block];
+}
+
+static int compress_blocks(const WorldCacheHeader_t* h, const uint8_t* sp, const uint8_t* ap,
+                           const uint8_t* voiced_mask, uint32_t chunk_frames,
+                           const WorldCacheCompression* opts, size_t reserve, uint8_t** out_buf,
+                           size_t* out_size) {
+    if (!h || h->num_frames == 0) return -1;
+    BlockRows r = { { sp, ap, voiced_mask },
+                    { (size_t)(h->sp_size / h->num_frames), (size_t)(h->ap_size / h->num_frames),
+                      (size_t)(h->voiced_mask_size / h->num_frames) } };
+    return worldcache_compress_rows(h, block_rows_row, &r, chunk_frames, opts, reserve, out_buf, out_size);
+}
+
+int worldcache_compress_chunks(const WorldCacheHeader_t* h,
+                               const uint8_t* sp, const uint8_t* ap, const uint8_t* voiced_mask,
+                               uint32_t chunk_frames, const WorldCacheCompression* opts,
+                               uint8_t** out_buf, size_t* out_size) {
+    return compress_blocks(h, sp, ap, voiced_mask, chunk_frames, opts, 0, out_buf, out_size);
+}
+
+int worldcache_decompress_chunks(const WorldCacheHeader_t* h, const uint8_t* buf, size_t buf_size,
+                                 uint8_t* sp, uint8_t* ap, uint8_t* voiced_mask) {
+#if defined(USE_ZSTD)
+    size_t rows[3];
+    WorldCacheChunkIndex_t index;
+    if (!h || !buf || frame_rows(h, rows) != 0 || buf_size < sizeof(index)) return -1;
+    memcpy(&index, buf, sizeof(index));
+    if (index.chunk_frames == 0 ||
+        index.chunk_count != (h->num_frames + index.chunk_frames - 1) / index.chunk_frames ||
+        (buf_size - sizeof(index)) / sizeof(uint64_t) < index.chunk_count) {
+        return -1;
+    }
+    size_t index_size = sizeof(index) + (size_t)index.chunk_count * sizeof(uint64_t);
+    uint8_t* blocks[3] = { sp, ap, voiced_mask };
+    size_t frame_bytes = rows[0] + rows[1] + rows[2];
+    const ZSTD_DDict* ddict = NULL;
+    if (h->flags & WORLDCACHE_FLAG_DICT) {
+        if (index.chunk_count == 0 || index_size > buf_size) return -1;
+        ddict = worldcache_dict_ddict(worldcache_dict_find(
+            ZSTD_getDictID_fromFrame(buf + index_size, buf_size - index_size)));
+        if (!ddict) return -1;
+    }
+    uint8_t* raw = (uint8_t*)malloc((size_t)index.chunk_frames * frame_bytes + 1);
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    if (!raw || !dctx) {
+        free(raw);
+        if (dctx) ZSTD_freeDCtx(dctx);
+        return -1;
+    }
+
+    int result = 0;
+    uint64_t begin = 0;
+    for (uint32_t c = 0; result == 0 && c < index.chunk_count; c++) {
+        uint64_t end;
+        memcpy(&end, buf + sizeof(index) + (size_t)c * sizeof(end), sizeof(end));
+        size_t first = (size_t)c * index.chunk_frames;
+        size_t n = h->num_frames - first < index.chunk_frames ? h->num_frames - first : index.chunk_frames;
+        size_t raw_size = n * frame_bytes;
+        if (end < begin || end > buf_size - index_size ||
+            ZSTD_decompress_usingDDict(dctx, raw, raw_size, buf + index_size + begin, (size_t)(end - begin),
+                                       ddict) != raw_size) {
+            result = -1;
+            break;
+        }
+        const uint8_t* q = raw;
+        for (int b = 0; b < 3; b++) {
+            if (rows[b]) memcpy(blocks[b] + first * rows[b], q, n * rows[b]);
+            q += n * rows[b];
+        }
+        begin = end;
+    }
+    ZSTD_freeDCtx(dctx);
+    free(raw);
+    return result;
+#else
+    (void)h; (void)buf; (void)buf_size; (void)sp; (void)ap; (void)voiced_mask;
+    return -1;
+#endif
+}
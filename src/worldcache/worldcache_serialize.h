@@ -9,18 +9,62 @@
 extern "C" {
 #endif
 
-/* Serialize header + data blocks into a contiguous buffer. Caller must free *out_buf. */
+/* Serialize header + data blocks into a contiguous cache image (current
+ * layout: section table, SP/AP/F0 sections, or CHUNKS and F0 when h asks
+ * for compression). Caller must free *out_buf. */
 int worldcache_serialize(const WorldCacheHeader_t* h,
                          const uint8_t* sp, const uint8_t* ap, const uint8_t* voiced_mask,
                          uint8_t** out_buf, size_t* out_size);
 
-/* Deserialize buffer into header and allocate memory for each block. Caller must free blocks with worldcache_free_blocks. */
+/* Deserialize buffer (either layout) into header and allocate memory for each block. Caller must free blocks with worldcache_free_blocks. */
 int worldcache_deserialize(const uint8_t* buf, size_t buf_size,
                            WorldCacheHeader_t* out_h,
                            uint8_t** out_sp, uint8_t** out_ap, uint8_t** out_voiced_mask);
 
 void worldcache_free_blocks(uint8_t* sp, uint8_t* ap, uint8_t* voiced_mask);
 
+struct WorldCacheDict; /* worldcache_dict.h */
+
+/* How chunks are compressed */
+typedef struct {
+    int level;                          /* zstd level; 0: worldcache_compression_level() */
+    const struct WorldCacheDict* dict;  /* trained dictionary, or NULL */
+} WorldCacheCompression;
+
+/* Process-wide level used when a WorldCacheCompression leaves it at 0 (or
+ * none is given); 1 until changed. Set it before caching starts. */
+void worldcache_set_compression_level(int level);
+int worldcache_compression_level(void);
+
+/* Source of payload rows: the row of `frame` in block `block` (0 sp, 1 ap,
+ * 2 voiced_mask, as sized by the header; blocks past
+ * worldcache_header_chunk_blocks are not asked for) */
+typedef const void* (*WorldCacheRowFn)(const void* ctx, int block, uint32_t frame);
+
+/* Compress the payload described by h into chunks of chunk_frames frames:
+ * the chunk index followed by the chunks (the CHUNKS section). Rows are streamed into the compressor as `row` returns
+ * them; consecutive rows that are adjacent in memory go in as one span.
+ * The first `reserve` bytes of *out_buf are left for the caller (e.g. the
+ * header) and *out_size includes them. Caller must free *out_buf; the
+ * caller sets WORLDCACHE_FLAG_DICT when opts names a dictionary. Returns -1
+ * when built without USE_ZSTD. */
+int worldcache_compress_rows(const WorldCacheHeader_t* h, WorldCacheRowFn row, const void* ctx,
+                             uint32_t chunk_frames, const WorldCacheCompression* opts, size_t reserve,
+                             uint8_t** out_buf, size_t* out_size);
+
+/* worldcache_compress_rows over contiguous sp/ap/voiced_mask blocks, no reserve */
+int worldcache_compress_chunks(const WorldCacheHeader_t* h,
+                               const uint8_t* sp, const uint8_t* ap, const uint8_t* voiced_mask,
+                               uint32_t chunk_frames, const WorldCacheCompression* opts,
+                               uint8_t** out_buf, size_t* out_size);
+
+/* Inverse of worldcache_compress_chunks: decode all chunks of buf into the
+ * caller's sp/ap/voiced_mask blocks (sized as h describes; voiced_mask is
+ * only written by first-layout chunks). With
+ * WORLDCACHE_FLAG_DICT the dictionary must be registered (worldcache_dict.h). */
+int worldcache_decompress_chunks(const WorldCacheHeader_t* h, const uint8_t* buf, size_t buf_size,
+                                 uint8_t* sp, uint8_t* ap, uint8_t* voiced_mask);
+
 #ifdef __cplusplus
 }
 #endif
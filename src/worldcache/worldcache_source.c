@@ -0,0 +1,197 @@
+#include "worldcache_source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+/* bulk read size for worldcache_hash_file */
+#define HASH_CHUNK (256 * 1024)
+
+static uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+/* little-endian loads, so hashes agree across hosts */
+static uint64_t load64(const uint8_t* p) {
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+           (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+static uint64_t load32(const uint8_t* p) {
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24;
+}
+
+static uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t hash_merge(uint64_t h, uint64_t lane) {
+    h ^= hash_round(0, lane);
+    return h * PRIME64_1 + PRIME64_4;
+}
+
+static void hash_stripe(uint64_t* lanes, const uint8_t* p) {
+    lanes[0] = hash_round(lanes[0], load64(p));
+    lanes[1] = hash_round(lanes[1], load64(p + 8));
+    lanes[2] = hash_round(lanes[2], load64(p + 16));
+    lanes[3] = hash_round(lanes[3], load64(p + 24));
+}
+
+void worldcache_hash_init(WorldCacheHash* s) {
+    memset(s, 0, sizeof(*s));
+    s->lanes[0] = PRIME64_1 + PRIME64_2;
+    s->lanes[1] = PRIME64_2;
+    s->lanes[2] = 0;
+    s->lanes[3] = 0 - PRIME64_1;
+}
+
+void worldcache_hash_update(WorldCacheHash* s, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    s->total += size;
+
+    if (s->tail_len > 0) {
+        size_t take = sizeof(s->tail) - s->tail_len;
+        if (take > size) take = size;
+        memcpy(s->tail + s->tail_len, p, take);
+        s->tail_len += take;
+        p += take;
+        size -= take;
+        if (s->tail_len < sizeof(s->tail)) return;
+        hash_stripe(s->lanes, s->tail);
+        s->tail_len = 0;
+    }
+    while (size >= 32) {
+        hash_stripe(s->lanes, p);
+        p += 32;
+        size -= 32;
+    }
+    memcpy(s->tail, p, size);
+    s->tail_len = size;
+}
+
+uint64_t worldcache_hash_final(const WorldCacheHash* s) {
+    uint64_t h;
+    if (s->total >= 32) {
+        h = rotl64(s->lanes[0], 1) + rotl64(s->lanes[1], 7) + rotl64(s->lanes[2], 12) +
+            rotl64(s->lanes[3], 18);
+        for (int i = 0; i < 4; i++) h = hash_merge(h, s->lanes[i]);
+    } else {
+        h = PRIME64_5;
+    }
+    h += s->total;
+
+    const uint8_t* p = s->tail;
+    size_t n = s->tail_len;
+    for (; n >= 8; p += 8, n -= 8) {
+        h ^= hash_round(0, load64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (n >= 4) {
+        h ^= load32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        n -= 4;
+    }
+    for (; n > 0; p++, n--) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+int worldcache_hash_file(const char* path, uint64_t* out_hash) {
+    if (!path || !out_hash) return -1;
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    uint8_t* buf = (uint8_t*)malloc(HASH_CHUNK);
+    if (!buf) {
+        fclose(f);
+        return -1;
+    }
+
+    WorldCacheHash s;
+    worldcache_hash_init(&s);
+    size_t n;
+    while ((n = fread(buf, 1, HASH_CHUNK, f)) > 0) {
+        worldcache_hash_update(&s, buf, n);
+    }
+    int result = ferror(f) ? -1 : 0;
+    free(buf);
+    fclose(f);
+    if (result == 0) *out_hash = worldcache_hash_final(&s);
+    return result;
+}
+
+int worldcache_source_identify(const char* path, WorldCacheSourceId* out_id) {
+    if (!path || !out_id) return -1;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    BY_HANDLE_FILE_INFORMATION info;
+    BOOL ok = GetFileInformationByHandle(file, &info);
+    CloseHandle(file);
+    if (!ok) return -1;
+    /* FILETIME counts 100 ns ticks since 1601 */
+    uint64_t ticks = (uint64_t)info.ftLastWriteTime.dwHighDateTime << 32 | info.ftLastWriteTime.dwLowDateTime;
+    out_id->size = (uint64_t)info.nFileSizeHigh << 32 | info.nFileSizeLow;
+    out_id->mtime_ns = (ticks - 116444736000000000ULL) * 100ULL;
+    out_id->inode = (uint64_t)info.nFileIndexHigh << 32 | info.nFileIndexLow;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+#if defined(__APPLE__)
+    long nsec = st.st_mtimespec.tv_nsec;
+#else
+    long nsec = st.st_mtim.tv_nsec;
+#endif
+    out_id->size = (uint64_t)st.st_size;
+    out_id->mtime_ns = (uint64_t)st.st_mtime * 1000000000ULL + (uint64_t)nsec;
+    out_id->inode = (uint64_t)st.st_ino;
+#endif
+    return 0;
+}
+
+int worldcache_source_stamp(WorldCacheHeader_t* h, const char* wav_path) {
+    WorldCacheSourceId id;
+    uint64_t hash;
+    if (!h || worldcache_source_identify(wav_path, &id) != 0 ||
+        worldcache_hash_file(wav_path, &hash) != 0) {
+        return -1;
+    }
+    h->wav_size = id.size;
+    h->wav_mtime = id.mtime_ns;
+    h->wav_inode = id.inode;
+    h->wav_hash = hash;
+    return 0;
+}
+
+WorldCacheSourceStatus worldcache_source_check(WorldCacheHeader_t* h, const char* wav_path) {
+    WorldCacheSourceId id;
+    if (!h || worldcache_source_identify(wav_path, &id) != 0) return WORLDCACHE_SOURCE_STALE;
+
+    if (id.size != h->wav_size) return WORLDCACHE_SOURCE_STALE;
+    if (id.mtime_ns == h->wav_mtime && id.inode == h->wav_inode) return WORLDCACHE_SOURCE_CURRENT;
+
+    uint64_t hash;
+    if (worldcache_hash_file(wav_path, &hash) != 0 || hash != h->wav_hash) return WORLDCACHE_SOURCE_STALE;
+    h->wav_mtime = id.mtime_ns;
+    h->wav_inode = id.inode;
+    return WORLDCACHE_SOURCE_REHASHED;
+}
@@ -0,0 +1,65 @@
+#ifndef WORLDCACHE_SOURCE_H
+#define WORLDCACHE_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "worldcache_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tiered validation of a cache against its source WAV.
+ *
+ * 1. identity: size, mtime (ns) and inode from one stat() -- if all match the
+ *    cache is current and the WAV is not read at all;
+ * 2. a size change means the content changed, no hash needed;
+ * 3. same size but a new mtime or inode (touched, copied or restored file):
+ *    the content hash decides, read in bulk chunks. */
+
+/* Stat-level identity of a source file */
+typedef struct {
+    uint64_t size;
+    uint64_t mtime_ns;
+    uint64_t inode;
+} WorldCacheSourceId;
+
+/* Result of worldcache_source_check */
+typedef enum {
+    WORLDCACHE_SOURCE_STALE = 0,     /* source changed (or is missing) */
+    WORLDCACHE_SOURCE_CURRENT = 1,   /* identity matched; nothing was read */
+    WORLDCACHE_SOURCE_REHASHED = 2   /* identity changed but the content hash matched */
+} WorldCacheSourceStatus;
+
+/* Streaming 64-bit content hash (four independent multiply-rotate lanes over
+ * 32-byte stripes, so it runs at memory speed without special instructions) */
+typedef struct {
+    uint64_t lanes[4];
+    uint64_t total;
+    uint8_t tail[32];
+    size_t tail_len;
+} WorldCacheHash;
+
+void worldcache_hash_init(WorldCacheHash* s);
+void worldcache_hash_update(WorldCacheHash* s, const void* data, size_t size);
+uint64_t worldcache_hash_final(const WorldCacheHash* s);
+
+/* Hash a whole file with bulk reads. Returns 0 on success. */
+int worldcache_hash_file(const char* path, uint64_t* out_hash);
+
+/* Stat path. Returns 0 on success. */
+int worldcache_source_identify(const char* path, WorldCacheSourceId* out_id);
+
+/* Record identity and content hash of wav_path in h. Returns 0 on success. */
+int worldcache_source_stamp(WorldCacheHeader_t* h, const char* wav_path);
+
+/* Validate h against wav_path. On WORLDCACHE_SOURCE_REHASHED h is updated
+ * with the new identity so the caller can persist it and take the fast path
+ * next time. */
+WorldCacheSourceStatus worldcache_source_check(WorldCacheHeader_t* h, const char* wav_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_SOURCE_H */
@@ -0,0 +1,223 @@
+#include "worldcache_voicebank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+int worldcache_path_list_push(WorldCachePathList* list, const char* path) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 64;
+        char** items = (char**)realloc(list->items, capacity * sizeof(char*));
+        if (!items) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    size_t len = strlen(path);
+    char* copy = (char*)malloc(len + 1);
+    if (!copy) return -1;
+    memcpy(copy, path, len + 1);
+    list->items[list->count++] = copy;
+    return 0;
+}
+
+void worldcache_path_list_free(WorldCachePathList* list) {
+    for (size_t i = 0; i < list->count; i++) free(list->items[i]);
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+size_t worldcache_path_dir_length(const char* path) {
+    size_t len = strlen(path);
+    while (len > 0 && path[len - 1] != '/' && path[len - 1] != '\\') len--;
+    return len;
+}
+
+int worldcache_path_parent(const char* path, size_t* dir_length) {
+    if (*dir_length == 0) return -1;
+    size_t end = *dir_length - 1;
+    size_t start = end;
+    while (start > 0 && path[start - 1] != '/' && path[start - 1] != '\\') start--;
+    size_t comp = end - start;
+    if (comp == 0 || (comp == 1 && path[start] == '.') ||
+        (comp == 2 && path[start] == '.' && path[start + 1] == '.') || memchr(path + start, ':', comp) != NULL) {
+        return -1;
+    }
+    *dir_length = start;
+    return 0;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/* Sort and drop duplicates */
+static void sort_unique(WorldCachePathList* list) {
+    qsort(list->items, list->count, sizeof(char*), compare_paths);
+    size_t kept = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (kept > 0 && strcmp(list->items[kept - 1], list->items[i]) == 0) {
+            free(list->items[i]);
+        } else {
+            list->items[kept++] = list->items[i];
+        }
+    }
+    list->count = kept;
+}
+
+static int has_suffix(const char* name, const char* suffix) {
+    size_t len = strlen(name), n = strlen(suffix);
+    if (len < n) return 0;
+    for (size_t i = 0; i < n; i++) {
+        if (tolower((unsigned char)name[len - n + i]) != suffix[i]) return 0;
+    }
+    return 1;
+}
+
+static int is_oto_name(const char* name) {
+    return strlen(name) == 7 && has_suffix(name, "oto.ini");
+}
+
+/* Collect .wav files (and oto.ini files, if otos is given) below root/rel
+ * (rel is "" or ends with '/') */
+static int scan_dir(const char* root, const char* rel, WorldCachePathList* wavs,
+                    WorldCachePathList* otos, int depth) {
+    if (depth > 16) return 0;
+    char dir[4096];
+    int n = snprintf(dir, sizeof(dir), "%s/%s", root, rel);
+    if (n < 0 || (size_t)n >= sizeof(dir)) return -1;
+    char child[4096];
+
+#if defined(_WIN32)
+    char pattern[4096];
+    n = snprintf(pattern, sizeof(pattern), "%s*", dir);
+    if (n < 0 || (size_t)n >= sizeof(pattern)) return -1;
+    WIN32_FIND_DATAA fd;
+    HANDLE find = FindFirstFileA(pattern, &fd);
+    if (find == INVALID_HANDLE_VALUE) return -1;
+    int result = 0;
+    do {
+        const char* name = fd.cFileName;
+        int is_dir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+    DIR* d = opendir(dir);
+    if (!d) return -1;
+    int result = 0;
+    struct dirent* de;
+    while (result == 0 && (de = readdir(d)) != NULL) {
+        const char* name = de->d_name;
+        struct stat st;
+        n = snprintf(child, sizeof(child), "%s%s", dir, name);
+        if (n < 0 || (size_t)n >= sizeof(child) || stat(child, &st) != 0) continue;
+        int is_dir = S_ISDIR(st.st_mode);
+#endif
+        if (name[0] == '.') continue;
+        n = snprintf(child, sizeof(child), "%s%s%s", rel, name, is_dir ? "/" : "");
+        if (n < 0 || (size_t)n >= sizeof(child)) continue;
+        if (is_dir) {
+            result = scan_dir(root, child, wavs, otos, depth + 1) == 0 ? 0 : -1;
+        } else if (has_suffix(name, ".wav")) {
+            result = worldcache_path_list_push(wavs, child);
+        } else if (otos && is_oto_name(name)) {
+            result = worldcache_path_list_push(otos, child);
+        }
+#if defined(_WIN32)
+    } while (result == 0 && FindNextFileA(find, &fd));
+    FindClose(find);
+#else
+    }
+    closedir(d);
+#endif
+    return result;
+}
+
+int worldcache_voicebank_wavs(const char* voicebank_dir, WorldCachePathList* out) {
+    memset(out, 0, sizeof(*out));
+    if (!voicebank_dir || scan_dir(voicebank_dir, "", out, NULL, 0) != 0) {
+        worldcache_path_list_free(out);
+        return -1;
+    }
+    sort_unique(out);
+    return 0;
+}
+
+/* Add the samples of one oto.ini (rel is its path below root) */
+static int read_oto(const char* root, const char* rel, WorldCachePathList* out) {
+    char path[4096];
+    int n = snprintf(path, sizeof(path), "%s/%s", root, rel);
+    if (n < 0 || (size_t)n >= sizeof(path)) return -1;
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+
+    /* samples are named relative to the oto.ini's directory */
+    size_t dir_len = strlen(rel) - strlen("oto.ini");
+    char line[4096], sample[4096];
+    int result = 0, first = 1;
+    while (result == 0 && fgets(line, sizeof(line), f)) {
+        size_t len = strlen(line);
+        int whole = len > 0 && line[len - 1] == '\n';
+        char* p = line;
+        if (first && (unsigned char)p[0] == 0xEF && (unsigned char)p[1] == 0xBB &&
+            (unsigned char)p[2] == 0xBF) {
+            p += 3; /* UTF-8 BOM */
+        }
+        first = 0;
+        char* eq = strchr(p, '=');
+        if (eq) {
+            while (p < eq && isspace((unsigned char)*p)) p++;
+            char* end = eq;
+            while (end > p && isspace((unsigned char)end[-1])) end--;
+            size_t name_len = (size_t)(end - p);
+            if (name_len > 0 && dir_len + name_len < sizeof(sample)) {
+                memcpy(sample, rel, dir_len);
+                memcpy(sample + dir_len, p, name_len);
+                sample[dir_len + name_len] = '\0';
+                for (char* c = sample + dir_len; *c; c++) {
+                    if (*c == '\\') *c = '/';
+                }
+                result = worldcache_path_list_push(out, sample);
+            }
+        }
+        /* skip the rest of an overlong line */
+        while (!whole && fgets(line, sizeof(line), f)) {
+            len = strlen(line);
+            whole = len > 0 && line[len - 1] == '\n';
+        }
+    }
+    fclose(f);
+    return result;
+}
+
+int worldcache_voicebank_samples(const char* voicebank_dir, WorldCachePathList* out, int* oto_count) {
+    WorldCachePathList otos;
+    memset(out, 0, sizeof(*out));
+    memset(&otos, 0, sizeof(otos));
+    if (oto_count) *oto_count = 0;
+    if (!voicebank_dir) return -1;
+
+    int result = scan_dir(voicebank_dir, "", out, &otos, 0);
+    if (result == 0 && otos.count > 0) {
+        /* oto.ini decides what the samples are */
+        worldcache_path_list_free(out);
+        for (size_t i = 0; result == 0 && i < otos.count; i++) {
+            if (read_oto(voicebank_dir, otos.items[i], out) == 0) {
+                if (oto_count) (*oto_count)++;
+            } else {
+                result = -1;
+            }
+        }
+    }
+    worldcache_path_list_free(&otos);
+    if (result != 0) {
+        worldcache_path_list_free(out);
+        return -1;
+    }
+    sort_unique(out);
+    return 0;
+}
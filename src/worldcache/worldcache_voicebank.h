@@ -0,0 +1,46 @@
+#ifndef WORLDCACHE_VOICEBANK_H
+#define WORLDCACHE_VOICEBANK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sample discovery in a voicebank directory tree. Paths are relative to the
+ * voicebank directory, use '/' separators and come back sorted (strcmp) and
+ * unique. Hidden files and directories (leading '.') are skipped. */
+
+typedef struct {
+    char** items;
+    size_t count, capacity;
+} WorldCachePathList;
+
+/* Append a copy of path. Returns 0 on success. */
+int worldcache_path_list_push(WorldCachePathList* list, const char* path);
+void worldcache_path_list_free(WorldCachePathList* list);
+
+/* Every .wav below voicebank_dir. Returns 0 on success, -1 if the directory
+ * cannot be read. */
+int worldcache_voicebank_wavs(const char* voicebank_dir, WorldCachePathList* out);
+
+/* The samples named by the oto.ini files below voicebank_dir (the part
+ * before '=' of each entry, relative to its oto.ini), whether or not the
+ * WAV exists. When the tree has no oto.ini at all, every .wav is listed
+ * instead. *oto_count (may be NULL) receives the number of oto.ini files
+ * read. Returns 0 on success, -1 if the directory cannot be read. */
+int worldcache_voicebank_samples(const char* voicebank_dir, WorldCachePathList* out, int* oto_count);
+
+/* Walking up from a sample to the voicebank root: the length of the
+ * directory part of path (separator included, 0 if there is none), and
+ * worldcache_path_parent shortens such a length by one directory. It
+ * returns -1 where a search should stop: at roots, drives and relative hops
+ * ("." and ".."). */
+size_t worldcache_path_dir_length(const char* path);
+int worldcache_path_parent(const char* path, size_t* dir_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_VOICEBANK_H */
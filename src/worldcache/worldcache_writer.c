@@ -0,0 +1,177 @@
+#include "worldcache_writer.h"
+#include "worldcache_manager.h"
+#include "worldx_thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Job {
+    struct Job* next;
+    WorldAnalysisData data;
+    WorldCacheHeader_t source;
+    WorldCacheLock lock;
+    int locked;
+    size_t bytes;
+    char wav_path[];
+} Job;
+
+/* g_control serializes enabling and disabling; g_lock guards the rest */
+static worldx_mutex_t g_control = WORLDX_MUTEX_INITIALIZER;
+static worldx_mutex_t g_lock = WORLDX_MUTEX_INITIALIZER;
+static worldx_cond_t g_work, g_idle;
+static int g_conds_ready;
+static worldx_thread_t g_thread;
+static int g_running, g_stopping, g_busy;
+static Job *g_head, *g_tail;
+static size_t g_budget, g_pending;
+static uint64_t g_queued, g_written, g_failed, g_inline;
+static uint64_t g_unreported; /* failures not yet returned by a flush */
+
+/* Bytes of analysis a queued write keeps alive */
+static size_t analysis_bytes(const WorldAnalysisData* d) {
+    size_t frames = (size_t)d->f0_length;
+    size_t value = d->precision == WORLD_PRECISION_FLOAT32 ? sizeof(float) : sizeof(double);
+    return frames * 2 * sizeof(double) + 2 * frames * ((size_t)(d->fft_size / 2 + 1) * value + sizeof(void*));
+}
+
+static void writer_main(void* arg) {
+    (void)arg;
+    worldx_mutex_lock(&g_lock);
+    for (;;) {
+        while (!g_head && !g_stopping) worldx_cond_wait(&g_work, &g_lock);
+        Job* job = g_head;
+        if (!job) break; /* stopping with the queue drained */
+        g_head = job->next;
+        if (!g_head) g_tail = NULL;
+        g_busy = 1;
+        worldx_mutex_unlock(&g_lock);
+
+        int stored = worldcache_store_source(job->wav_path, &job->data, &job->source) == 0;
+        if (job->locked) worldcache_lock_release(&job->lock);
+        world_analysis_data_free(&job->data);
+
+        worldx_mutex_lock(&g_lock);
+        g_pending -= job->bytes;
+        g_busy = 0;
+        if (stored) {
+            g_written++;
+        } else {
+            g_failed++;
+            g_unreported++;
+        }
+        free(job);
+        worldx_cond_broadcast(&g_idle);
+    }
+    worldx_mutex_unlock(&g_lock);
+}
+
+int worldcache_set_write_back(size_t queue_bytes) {
+    int result = 0;
+    worldx_mutex_lock(&g_control);
+    worldx_mutex_lock(&g_lock);
+    if (queue_bytes > 0) {
+        if (!g_running) {
+            if (!g_conds_ready) {
+                if (worldx_cond_init(&g_work) != 0 || worldx_cond_init(&g_idle) != 0) result = -1;
+                g_conds_ready = result == 0;
+            }
+            if (result == 0 && worldx_thread_create(&g_thread, writer_main, NULL) != 0) result = -1;
+            g_running = result == 0;
+        }
+        if (result == 0) g_budget = queue_bytes;
+        worldx_mutex_unlock(&g_lock);
+    } else if (g_running) {
+        /* the writer drains the queue before it exits */
+        g_stopping = 1;
+        worldx_cond_broadcast(&g_work);
+        worldx_mutex_unlock(&g_lock);
+        worldx_thread_join(&g_thread);
+        worldx_mutex_lock(&g_lock);
+        g_running = g_stopping = 0;
+        g_budget = 0;
+        worldx_mutex_unlock(&g_lock);
+    } else {
+        worldx_mutex_unlock(&g_lock);
+    }
+    worldx_mutex_unlock(&g_control);
+    return result;
+}
+
+int worldcache_write_back(void) {
+    worldx_mutex_lock(&g_lock);
+    int enabled = g_running && !g_stopping;
+    worldx_mutex_unlock(&g_lock);
+    return enabled;
+}
+
+int worldcache_flush_writes(void) {
+    worldx_mutex_lock(&g_lock);
+    while (g_running && (g_head || g_busy)) worldx_cond_wait(&g_idle, &g_lock);
+    int result = g_unreported ? -1 : 0;
+    g_unreported = 0;
+    worldx_mutex_unlock(&g_lock);
+    return result;
+}
+
+void worldcache_writer_stats(WorldCacheWriterStats* out_stats) {
+    if (!out_stats) return;
+    worldx_mutex_lock(&g_lock);
+    out_stats->queued = g_queued;
+    out_stats->written = g_written;
+    out_stats->failed = g_failed;
+    out_stats->inline_writes = g_inline;
+    out_stats->pending_bytes = g_pending;
+    out_stats->queue_bytes = g_running ? g_budget : 0;
+    worldx_mutex_unlock(&g_lock);
+}
+
+int worldcache_writer_submit(const char* wav_path, WorldAnalysisData* data, const WorldCacheHeader_t* source,
+                             const WorldCacheLock* lock) {
+    if (!wav_path || !data || !source) return -1;
+
+    /* reserve room first so the storage is only shared when the job is queued */
+    size_t bytes = analysis_bytes(data);
+    worldx_mutex_lock(&g_lock);
+    int enabled = g_running && !g_stopping;
+    int fits = enabled && bytes <= g_budget && g_pending <= g_budget - bytes;
+    if (fits) g_pending += bytes;
+    else if (enabled) g_inline++;
+    worldx_mutex_unlock(&g_lock);
+    if (!fits) return -1;
+
+    size_t path_size = strlen(wav_path) + 1;
+    Job* job = (Job*)malloc(sizeof(Job) + path_size);
+    if (job) world_analysis_data_init(&job->data);
+    if (job && world_analysis_data_share(data, &job->data) != 0) {
+        free(job);
+        job = NULL;
+    }
+    if (job) {
+        memcpy(job->wav_path, wav_path, path_size);
+        job->source = *source;
+        job->next = NULL;
+        job->locked = lock != NULL;
+        if (lock) job->lock = *lock;
+        job->bytes = bytes;
+    }
+
+    worldx_mutex_lock(&g_lock);
+    /* the writer only exits once stopping with an empty queue, so a job
+     * queued while not stopping is always written */
+    if (job && g_running && !g_stopping) {
+        if (g_tail) g_tail->next = job;
+        else g_head = job;
+        g_tail = job;
+        g_queued++;
+        worldx_cond_signal(&g_work);
+        worldx_mutex_unlock(&g_lock);
+        return 0;
+    }
+    g_pending -= bytes;
+    g_inline++;
+    worldx_mutex_unlock(&g_lock);
+    if (job) {
+        world_analysis_data_free(&job->data);
+        free(job);
+    }
+    return -1;
+}
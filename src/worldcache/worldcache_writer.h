@@ -0,0 +1,68 @@
+#ifndef WORLDCACHE_WRITER_H
+#define WORLDCACHE_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "worldcache_format.h"
+#include "worldcache_lock.h"
+#include "world_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cache write-back off the render path.
+ *
+ * Without it, a cache miss in worldcache_get_analysis serializes,
+ * compresses and writes the sidecar before returning. With write-back
+ * enabled the miss returns as soon as the analysis is done: the analysis is
+ * queued, sharing its storage with the caller's result instead of being
+ * copied, and a background writer thread stores the sidecar. Processes
+ * waiting for the sample (worldcache_lock.h) keep waiting until the sidecar
+ * is written, since the writer takes over the miss's lock.
+ *
+ * The queue is bounded by the bytes of the analyses it holds; a miss that
+ * does not fit writes its sidecar itself, as without write-back. Queued
+ * writes are lost if the process exits without worldcache_flush_writes()
+ * or disabling write-back (the next load just misses again). */
+
+typedef struct {
+    uint64_t queued;         /* writes handed to the writer thread */
+    uint64_t written;        /* queued writes stored */
+    uint64_t failed;         /* queued writes that could not be stored */
+    uint64_t inline_writes;  /* misses written by the caller: queue full or analysis not shareable */
+    size_t pending_bytes;    /* analysis bytes waiting in the queue or being written */
+    size_t queue_bytes;      /* queue bound; 0 when write-back is off */
+} WorldCacheWriterStats;
+
+/* Enable write-back with a queue of up to queue_bytes of analyses (the
+ * bound can be changed while enabled), or disable it with 0, which drains
+ * the queue and stops the writer thread. Returns 0 on success. */
+int worldcache_set_write_back(size_t queue_bytes);
+
+/* Whether write-back is enabled */
+int worldcache_write_back(void);
+
+/* Block until every write queued so far is stored. Returns 0 if they all
+ * succeeded (failures are counted once), -1 otherwise. */
+int worldcache_flush_writes(void);
+
+/* Snapshot of the counters */
+void worldcache_writer_stats(WorldCacheWriterStats* out_stats);
+
+/* Queue the sidecar of wav_path for data, analyzed by
+ * worldcache_analyze_source into source; the write is dropped if the WAV
+ * changed since. The job shares data's storage (world_analysis_data_share)
+ * until it is written, so data's rows must not be written in place; data
+ * itself stays the caller's to free. lock, if not NULL, is the caller's lock on wav_path; on
+ * success the writer owns it and releases it once the sidecar is written.
+ * Returns 0 when queued, -1 when the caller has to write (and release)
+ * itself. */
+int worldcache_writer_submit(const char* wav_path, WorldAnalysisData* data, const WorldCacheHeader_t* source,
+                             const WorldCacheLock* lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDCACHE_WRITER_H */
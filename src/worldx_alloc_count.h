@@ -0,0 +1,137 @@
+/**
+ * @file worldx_alloc_count.h
+ * @brief Interposed heap allocation counter for tests and benchmarks
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * Include from exactly one translation unit of an executable. On glibc it
+ * replaces malloc, calloc, realloc, posix_memalign, aligned_alloc and
+ * memalign with versions that count the call and forward to the C library,
+ * so allocations made inside WORLD (C++ new ends in malloc) and any other
+ * linked library are counted as well. The same wrappers and free() keep the
+ * bytes live on the heap (malloc_usable_size() of every block, so allocator
+ * rounding included) and their high-water mark. Elsewhere, and under
+ * AddressSanitizer or ThreadSanitizer (which own the allocator),
+ * WORLDX_ALLOC_COUNT_AVAILABLE is 0 and every counter reads 0.
+ */
+#ifndef WORLDX_UCRA_WORLDX_ALLOC_COUNT_H
+#define WORLDX_UCRA_WORLDX_ALLOC_COUNT_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "worldx_thread.h"
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define WORLDX_ALLOC_COUNT_AVAILABLE 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define WORLDX_ALLOC_COUNT_AVAILABLE 0
+#endif
+#endif
+#if !defined(WORLDX_ALLOC_COUNT_AVAILABLE)
+#if defined(__GLIBC__)
+#define WORLDX_ALLOC_COUNT_AVAILABLE 1
+#else
+#define WORLDX_ALLOC_COUNT_AVAILABLE 0
+#endif
+#endif
+
+static worldx_atomic_t worldx_alloc_calls = 0;
+static worldx_atomic_t worldx_alloc_live = 0;
+static worldx_atomic_t worldx_alloc_peak = 0;
+
+/** @brief Heap allocations made by the process so far (0 when not available) */
+static inline long worldx_alloc_count(void) {
+    return worldx_atomic_load(&worldx_alloc_calls);
+}
+
+/**
+ * @brief Bytes allocated through the wrappers and not yet freed
+ *
+ * Blocks the C library allocated for itself and handed over (strdup(),
+ * getline()) are only subtracted when freed, so compare readings taken
+ * around the code being measured rather than absolute values.
+ */
+static inline long worldx_alloc_live_bytes(void) {
+    return worldx_atomic_load(&worldx_alloc_live);
+}
+
+/** @brief Highest worldx_alloc_live_bytes() since the last reset */
+static inline long worldx_alloc_peak_bytes(void) {
+    return worldx_atomic_load(&worldx_alloc_peak);
+}
+
+#if WORLDX_ALLOC_COUNT_AVAILABLE
+#include <errno.h>
+#include <malloc.h>
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+/** @brief Restart the high-water mark from the bytes live now */
+static inline void worldx_alloc_peak_reset(void) {
+    __atomic_store_n(&worldx_alloc_peak, worldx_alloc_live_bytes(), __ATOMIC_RELEASE);
+}
+
+static inline void worldx_alloc_track(long delta) {
+    long live = __atomic_add_fetch(&worldx_alloc_live, delta, __ATOMIC_ACQ_REL);
+    long peak = __atomic_load_n(&worldx_alloc_peak, __ATOMIC_ACQUIRE);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&worldx_alloc_peak, &peak, live, 0, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE)) {
+    }
+}
+
+static inline void* worldx_alloc_tracked(void* ptr) {
+    if (ptr) worldx_alloc_track((long)malloc_usable_size(ptr));
+    return ptr;
+}
+
+void* malloc(size_t size) {
+    worldx_atomic_inc(&worldx_alloc_calls);
+    return worldx_alloc_tracked(__libc_malloc(size));
+}
+
+void* calloc(size_t count, size_t size) {
+    worldx_atomic_inc(&worldx_alloc_calls);
+    return worldx_alloc_tracked(__libc_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size) {
+    worldx_atomic_inc(&worldx_alloc_calls);
+    long old_bytes = ptr ? (long)malloc_usable_size(ptr) : 0;
+    void* result = __libc_realloc(ptr, size);
+    // On failure the old block stays; realloc(ptr, 0) frees it
+    if (result || (ptr && size == 0)) worldx_alloc_track(-old_bytes);
+    return worldx_alloc_tracked(result);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    worldx_atomic_inc(&worldx_alloc_calls);
+    return worldx_alloc_tracked(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) return EINVAL;
+    void* ptr = memalign(alignment, size);
+    if (!ptr && size > 0) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void free(void* ptr) {
+    if (ptr) worldx_alloc_track(-(long)malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+#else
+static inline void worldx_alloc_peak_reset(void) {}
+#endif
+
+#endif /* WORLDX_UCRA_WORLDX_ALLOC_COUNT_H */
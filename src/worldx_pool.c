@@ -0,0 +1,149 @@
+/**
+ * @file worldx_pool.c
+ * @brief Work-stealing pool for batches of independent jobs
+ * @author worldx-ucra development team
+ * @date 2025
+ */
+
+#include "worldx_pool.h"
+#include "worldx_thread.h"
+#include <stdlib.h>
+
+typedef struct WorldxPool WorldxPool;
+
+/** One worker and the range of jobs it still owns */
+typedef struct {
+    worldx_mutex_t lock;   /* guards lo/hi */
+    size_t lo, hi;         /* jobs [lo, hi) not yet taken */
+    worldx_thread_t thread;
+    WorldxPool* pool;
+    int index;
+    int started;
+} WorldxWorker;
+
+struct WorldxPool {
+    WorldxWorker* workers;
+    int count;
+    worldx_pool_fn fn;
+    void* ctx;
+    worldx_atomic_t steals;
+};
+
+/* Next job from the front of w's own range */
+static int take_own(WorldxWorker* w, size_t* job) {
+    worldx_mutex_lock(&w->lock);
+    int ok = w->lo < w->hi;
+    if (ok) *job = w->lo++;
+    worldx_mutex_unlock(&w->lock);
+    return ok;
+}
+
+/* Move the back half of the fullest other range into w's (empty) range.
+ * Returns 0 once every range is empty: jobs are never added, so there is
+ * nothing left to wait for. */
+static int steal(WorldxWorker* w) {
+    WorldxPool* pool = w->pool;
+    for (;;) {
+        int victim = -1;
+        size_t most = 0;
+        for (int i = 1; i < pool->count; i++) {
+            WorldxWorker* v = &pool->workers[(w->index + i) % pool->count];
+            worldx_mutex_lock(&v->lock);
+            size_t left = v->hi - v->lo;
+            worldx_mutex_unlock(&v->lock);
+            if (left > most) {
+                most = left;
+                victim = v->index;
+            }
+        }
+        if (victim < 0) return 0;
+
+        WorldxWorker* v = &pool->workers[victim];
+        size_t lo = 0, hi = 0;
+        worldx_mutex_lock(&v->lock);
+        if (v->hi > v->lo) {
+            lo = v->lo + (v->hi - v->lo) / 2;
+            hi = v->hi;
+            v->hi = lo;
+        }
+        worldx_mutex_unlock(&v->lock);
+        /* lost the race to the owner or another thief: look again */
+        if (hi == lo) continue;
+
+        worldx_mutex_lock(&w->lock);
+        w->lo = lo;
+        w->hi = hi;
+        worldx_mutex_unlock(&w->lock);
+        worldx_atomic_inc(&pool->steals);
+        return 1;
+    }
+}
+
+static void worker_main(void* arg) {
+    WorldxWorker* w = (WorldxWorker*)arg;
+    size_t job;
+    do {
+        while (take_own(w, &job)) w->pool->fn(w->pool->ctx, job, w->index);
+    } while (steal(w));
+}
+
+int worldx_pool_run(int num_threads, size_t num_jobs, worldx_pool_fn fn, void* ctx,
+                    WorldxPoolStats* stats) {
+    if (stats) {
+        stats->threads = 0;
+        stats->steals = 0;
+    }
+    if (!fn) return -1;
+    if (num_jobs == 0) return 0;
+    if (num_threads <= 0) num_threads = worldx_cpu_count();
+    if ((size_t)num_threads > num_jobs) num_threads = (int)num_jobs;
+
+    WorldxPool pool;
+    pool.workers = (WorldxWorker*)calloc((size_t)num_threads, sizeof(WorldxWorker));
+    pool.count = 0;
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.steals = 0;
+    for (int t = 0; pool.workers && t < num_threads; t++) {
+        if (worldx_mutex_init(&pool.workers[t].lock) != 0) break;
+        pool.count++;
+    }
+    if (pool.count < num_threads) {
+        /* out of resources: run the batch on the caller */
+        for (int t = 0; t < pool.count; t++) worldx_mutex_destroy(&pool.workers[t].lock);
+        free(pool.workers);
+        for (size_t i = 0; i < num_jobs; i++) fn(ctx, i, 0);
+        if (stats) stats->threads = 1;
+        return 0;
+    }
+
+    /* even contiguous shares */
+    int count = pool.count;
+    for (int t = 0; t < count; t++) {
+        WorldxWorker* w = &pool.workers[t];
+        w->pool = &pool;
+        w->index = t;
+        w->lo = num_jobs * (size_t)t / (size_t)count;
+        w->hi = num_jobs * (size_t)(t + 1) / (size_t)count;
+    }
+
+    /* workers that fail to start keep their range; the others steal it */
+    int running = 1;
+    for (int t = 1; t < count; t++) {
+        WorldxWorker* w = &pool.workers[t];
+        w->started = worldx_thread_create(&w->thread, worker_main, w) == 0;
+        running += w->started;
+    }
+    worker_main(&pool.workers[0]);
+    for (int t = 1; t < count; t++) {
+        if (pool.workers[t].started) worldx_thread_join(&pool.workers[t].thread);
+    }
+    for (int t = 0; t < count; t++) worldx_mutex_destroy(&pool.workers[t].lock);
+
+    if (stats) {
+        stats->threads = running;
+        stats->steals = (size_t)pool.steals;
+    }
+    free(pool.workers);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file worldx_pool.h
+ * @brief Work-stealing pool for batches of independent jobs
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * The jobs of a batch are numbered 0..num_jobs-1 and split into one
+ * contiguous range per worker (worker t starts with jobs
+ * [num_jobs * t / threads, num_jobs * (t + 1) / threads)). Each worker takes jobs from the front of its
+ * own range; a worker that runs dry steals the back half of the largest
+ * remaining range, so uneven job costs (long and short samples) still keep
+ * every thread busy until the batch is done.
+ */
+#ifndef WORLDX_UCRA_WORLDX_POOL_H
+#define WORLDX_UCRA_WORLDX_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Job callback
+ * @param ctx The ctx passed to worldx_pool_run()
+ * @param job Job index, in [0, num_jobs)
+ * @param worker Index of the worker running it, in [0, threads)
+ */
+typedef void (*worldx_pool_fn)(void* ctx, size_t job, int worker);
+
+/** Per-run counters, for diagnostics */
+typedef struct {
+    int threads;      /**< Workers that ran (the caller is worker 0) */
+    size_t steals;    /**< Ranges taken from another worker */
+} WorldxPoolStats;
+
+/**
+ * @brief Run fn for every job on num_threads workers and wait for all of them
+ *
+ * The calling thread is one of the workers. Jobs run exactly once, in no
+ * particular order across workers.
+ *
+ * @param num_threads Worker count; <= 0 uses worldx_cpu_count(). Never more than num_jobs.
+ * @param num_jobs Number of jobs
+ * @param fn Job callback
+ * @param ctx Passed to fn
+ * @param stats Filled with the run's counters; may be NULL
+ * @return 0 on success, -1 on invalid arguments. Workers that cannot be
+ *         started leave their share to the others.
+ */
+int worldx_pool_run(int num_threads, size_t num_jobs, worldx_pool_fn fn, void* ctx,
+                    WorldxPoolStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLDX_POOL_H */
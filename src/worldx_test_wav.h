@@ -0,0 +1,71 @@
+/**
+ * @file worldx_test_wav.h
+ * @brief WAV and file fixtures shared by the tests
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * Header-only helpers for test executables: tones are written through
+ * wav_write_pcm16(), so fixtures go through the same writer as rendered
+ * notes.
+ */
+#ifndef WORLDX_UCRA_WORLDX_TEST_WAV_H
+#define WORLDX_UCRA_WORLDX_TEST_WAV_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wav_io.h"
+
+/**
+ * @brief Write `seconds` of a harmonic tone as 16-bit mono
+ *
+ * Partials 1..harmonics of f0 at 0.4, 0.2, 0.1, ... of full scale.
+ *
+ * @return 0 on success, -1 on failure
+ */
+static inline int worldx_test_write_tone(const char* path, int fs, double seconds, double f0, int harmonics) {
+    int n = (int)(fs * seconds);
+    double* x = (double*)malloc(sizeof(double) * (size_t)(n > 0 ? n : 1));
+    if (!x) return -1;
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / fs, v = 0.0, a = 0.4;
+        for (int k = 1; k <= harmonics; k++, a *= 0.5) v += a * sin(2.0 * M_PI * k * f0 * t);
+        x[i] = v;
+    }
+    int result = wav_write_pcm16(path, x, n, fs, 1);
+    free(x);
+    return result;
+}
+
+/** @brief Whole file at path, NULL if missing or empty; release with free() */
+static inline uint8_t* worldx_test_read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    *size = 0;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = n > 0 ? (uint8_t*)malloc((size_t)n) : NULL;
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    if (buf) *size = (size_t)n;
+    return buf;
+}
+
+/** @brief Whether the files at a and b exist and hold the same bytes */
+static inline int worldx_test_same_file(const char* a, const char* b) {
+    size_t a_size = 0, b_size = 0;
+    uint8_t* x = worldx_test_read_file(a, &a_size);
+    uint8_t* y = worldx_test_read_file(b, &b_size);
+    int same = x && y && a_size == b_size && memcmp(x, y, a_size) == 0;
+    free(x);
+    free(y);
+    return same;
+}
+
+#endif /* WORLDX_UCRA_WORLDX_TEST_WAV_H */
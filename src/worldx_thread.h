@@ -0,0 +1,240 @@
+/**
+ * @file worldx_thread.h
+ * @brief Minimal portable threading primitives
+ * @author worldx-ucra development team
+ * @date 2025
+ *
+ * Thin header-only layer over Win32 threads and POSIX threads, covering only
+ * what the engine needs (threads, atomic counters, mutexes and condition
+ * variables). The worldx_thread_t
+ * object must stay alive until worldx_thread_join() returns.
+ */
+#ifndef WORLDX_UCRA_WORLDX_THREAD_H
+#define WORLDX_UCRA_WORLDX_THREAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/** Thread entry point */
+typedef void (*worldx_thread_fn)(void* arg);
+
+/** Thread handle */
+typedef struct {
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    worldx_thread_fn fn;
+    void* arg;
+} worldx_thread_t;
+
+#if defined(_WIN32)
+static unsigned __stdcall worldx_thread_trampoline(void* self) {
+    worldx_thread_t* t = (worldx_thread_t*)self;
+    t->fn(t->arg);
+    return 0;
+}
+#else
+static void* worldx_thread_trampoline(void* self) {
+    worldx_thread_t* t = (worldx_thread_t*)self;
+    t->fn(t->arg);
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Start a thread running fn(arg)
+ * @return 0 on success, -1 on failure
+ */
+static inline int worldx_thread_create(worldx_thread_t* t, worldx_thread_fn fn, void* arg) {
+    t->fn = fn;
+    t->arg = arg;
+#if defined(_WIN32)
+    t->handle = (HANDLE)_beginthreadex(NULL, 0, worldx_thread_trampoline, t, 0, NULL);
+    return t->handle ? 0 : -1;
+#else
+    return pthread_create(&t->handle, NULL, worldx_thread_trampoline, t) == 0 ? 0 : -1;
+#endif
+}
+
+/** @brief Wait for a thread started with worldx_thread_create() */
+static inline void worldx_thread_join(worldx_thread_t* t) {
+#if defined(_WIN32)
+    WaitForSingleObject(t->handle, INFINITE);
+    CloseHandle(t->handle);
+#else
+    pthread_join(t->handle, NULL);
+#endif
+}
+
+/** @brief Number of online logical CPUs (at least 1) */
+static inline int worldx_cpu_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/** Reference count or other counter shared between threads */
+typedef volatile long worldx_atomic_t;
+
+/** @brief Atomically increment *v and return the new value */
+static inline long worldx_atomic_inc(worldx_atomic_t* v) {
+#if defined(_WIN32)
+    return InterlockedIncrement(v);
+#else
+    return __atomic_add_fetch(v, 1, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/** @brief Atomically decrement *v and return the new value */
+static inline long worldx_atomic_dec(worldx_atomic_t* v) {
+#if defined(_WIN32)
+    return InterlockedDecrement(v);
+#else
+    return __atomic_sub_fetch(v, 1, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/** @brief Atomically read *v */
+static inline long worldx_atomic_load(worldx_atomic_t* v) {
+#if defined(_WIN32)
+    return InterlockedCompareExchange(v, 0, 0);
+#else
+    return __atomic_load_n(v, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/** Mutual exclusion lock (not recursive) */
+typedef struct {
+#if defined(_WIN32)
+    SRWLOCK lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} worldx_mutex_t;
+
+/** Static initializer for a worldx_mutex_t that is never destroyed */
+#if defined(_WIN32)
+#define WORLDX_MUTEX_INITIALIZER { SRWLOCK_INIT }
+#else
+#define WORLDX_MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER }
+#endif
+
+/**
+ * @brief Initialize a mutex
+ * @return 0 on success, -1 on failure
+ */
+static inline int worldx_mutex_init(worldx_mutex_t* m) {
+#if defined(_WIN32)
+    InitializeSRWLock(&m->lock);
+    return 0;
+#else
+    return pthread_mutex_init(&m->lock, NULL) == 0 ? 0 : -1;
+#endif
+}
+
+/** @brief Destroy an unlocked mutex */
+static inline void worldx_mutex_destroy(worldx_mutex_t* m) {
+#if defined(_WIN32)
+    (void)m;
+#else
+    pthread_mutex_destroy(&m->lock);
+#endif
+}
+
+/** @brief Acquire a mutex */
+static inline void worldx_mutex_lock(worldx_mutex_t* m) {
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(&m->lock);
+#else
+    pthread_mutex_lock(&m->lock);
+#endif
+}
+
+/** @brief Release a mutex held by the calling thread */
+static inline void worldx_mutex_unlock(worldx_mutex_t* m) {
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(&m->lock);
+#else
+    pthread_mutex_unlock(&m->lock);
+#endif
+}
+
+/** Condition variable, used with a worldx_mutex_t */
+typedef struct {
+#if defined(_WIN32)
+    CONDITION_VARIABLE cond;
+#else
+    pthread_cond_t cond;
+#endif
+} worldx_cond_t;
+
+/**
+ * @brief Initialize a condition variable
+ * @return 0 on success, -1 on failure
+ */
+static inline int worldx_cond_init(worldx_cond_t* c) {
+#if defined(_WIN32)
+    InitializeConditionVariable(&c->cond);
+    return 0;
+#else
+    return pthread_cond_init(&c->cond, NULL) == 0 ? 0 : -1;
+#endif
+}
+
+/** @brief Destroy a condition variable nobody waits on */
+static inline void worldx_cond_destroy(worldx_cond_t* c) {
+#if defined(_WIN32)
+    (void)c;
+#else
+    pthread_cond_destroy(&c->cond);
+#endif
+}
+
+/** @brief Atomically release m and wait for a signal; m is held again on return (wakeups may be spurious) */
+static inline void worldx_cond_wait(worldx_cond_t* c, worldx_mutex_t* m) {
+#if defined(_WIN32)
+    SleepConditionVariableSRW(&c->cond, &m->lock, INFINITE, 0);
+#else
+    pthread_cond_wait(&c->cond, &m->lock);
+#endif
+}
+
+/** @brief Wake one waiter */
+static inline void worldx_cond_signal(worldx_cond_t* c) {
+#if defined(_WIN32)
+    WakeConditionVariable(&c->cond);
+#else
+    pthread_cond_signal(&c->cond);
+#endif
+}
+
+/** @brief Wake all waiters */
+static inline void worldx_cond_broadcast(worldx_cond_t* c) {
+#if defined(_WIN32)
+    WakeAllConditionVariable(&c->cond);
+#else
+    pthread_cond_broadcast(&c->cond);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORLDX_UCRA_WORLDX_THREAD_H */